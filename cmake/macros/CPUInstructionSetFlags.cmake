@@ -73,15 +73,20 @@ ENDIF()
 IF(CPU_i386 OR CPU_amd64)
 	# MSVC does not require anything past /arch:SSE2 for SSSE3.
 	# ClangCL does require -mssse3, even on 64-bit.
+	# AVX2 requires /arch:AVX2 on MSVC. (MSVC 2013 Update 2 or later)
+	# PCLMULQDQ doesn't require anything on MSVC.
 	IF(MSVC)
 		IF(CPU_i386)
 			SET(SSE2_FLAG "/arch:SSE2")
 			SET(SSSE3_FLAG "/arch:SSE2")
 			SET(SSE41_FLAG "/arch:SSE2")
 		ENDIF(CPU_i386)
+		SET(AVX2_FLAG "/arch:AVX2")
 		IF(CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
 			SET(SSSE3_FLAG "-mssse3")
 			SET(SSE41_FLAG "-msse4.1")
+			SET(AVX2_FLAG "-mavx2")
+			SET(PCLMUL_FLAG "-msse4.1 -mpclmul")
 		ENDIF(CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
 	ELSE()
 		IF(CPU_i386)
@@ -90,5 +95,7 @@ IF(CPU_i386 OR CPU_amd64)
 		ENDIF(CPU_i386)
 		SET(SSSE3_FLAG "-mssse3")
 		SET(SSE41_FLAG "-msse4.1")
+		SET(AVX2_FLAG "-mavx2")
+		SET(PCLMUL_FLAG "-msse4.1 -mpclmul")
 	ENDIF()
 ENDIF(CPU_i386 OR CPU_amd64)
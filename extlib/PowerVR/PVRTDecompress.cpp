@@ -19,6 +19,8 @@
 // rom-properties: Use librpcpu's byteorder macros.
 // NOTE: Not able to detect built-in byteswapping intrinsics here.
 #include "../../src/librpcpu/byteorder.h"
+// rom-properties: Thread pool for parallel decoding.
+#include "../../src/librpthreads/ThreadPool.hpp"
 #define __swab32(x) \
 	((uint32_t)((((uint32_t)x) << 24) | (((uint32_t)x) >> 24) | \
 		((((uint32_t)x) & 0x0000FF00UL) << 8) | \
@@ -556,13 +558,17 @@ static uint32_t pvrtcDecompress(uint8_t* pCompressedData, Pixel32* pDecompressed
 	int i32NumXWords = static_cast<int>(width / wordWidth);
 	int i32NumYWords = static_cast<int>(height / wordHeight);
 
-	// Structs used for decompression
-	PVRTCWordIndices indices;
-	std::vector<Pixel32> pPixels(wordWidth * wordHeight * sizeof(Pixel32));
-
 	// For each row of words
-	for (int32_t wordY = -1; wordY < i32NumYWords - 1; wordY++)
+	// rom-properties: Decode rows of words in parallel using the thread pool.
+	// Each row of words writes to a distinct set of output pixels.
+	// Small images are decoded on the calling thread.
+	LibRpThreads::parallel_for(-1, i32NumYWords - 1, [&](int32_t wordY)
 	{
+		// Structs used for decompression
+		// rom-properties: Allocated per row of words for multi-threading.
+		PVRTCWordIndices indices;
+		Pixel32 pPixels[8 * 4];
+
 		// for each column of words
 		for (int32_t wordX = -1; wordX < i32NumXWords - 1; wordX++)
 		{
@@ -595,11 +601,11 @@ static uint32_t pvrtcDecompress(uint8_t* pCompressedData, Pixel32* pDecompressed
 			S.modulationData = static_cast<uint32_t>(le32_to_cpu(pWordMembers[WordOffsets[3]]));
 
 			// assemble 4 words into struct to get decompressed pixels from
-			pvrtcGetDecompressedPixels<PVRTCII>(P, Q, R, S, pPixels.data(), bpp);
-			mapDecompressedData(pOutData, width, pPixels.data(), indices, bpp);
+			pvrtcGetDecompressedPixels<PVRTCII>(P, Q, R, S, pPixels, bpp);
+			mapDecompressedData(pOutData, width, pPixels, indices, bpp);
 
 		} // for each word
-	} // for each row of words
+	}, width * height >= 128 * 128); // for each row of words
 
 	// Return the data size
 	return width * height / static_cast<uint32_t>((wordWidth / 2));
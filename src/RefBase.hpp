@@ -80,6 +80,18 @@ class RP_LIBROMDATA_PUBLIC RefBase
 			}
 		}
 
+		/**
+		 * Get the current reference count.
+		 * NOTE: Other threads that hold a reference may change
+		 * this at any time, so this is only reliable if the
+		 * caller knows it holds the only other references.
+		 * @return Reference count
+		 */
+		inline int refCount(void) const
+		{
+			return m_ref_cnt;
+		}
+
 	private:
 		volatile int m_ref_cnt;
 };
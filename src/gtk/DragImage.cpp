@@ -202,7 +202,7 @@ rp_drag_image_update_pixmaps(RpDragImage *image)
 				anim->iconFrames[i] = nullptr;
 			}
 
-			const rp_image *const frame = iconAnimData->frames[i];
+			const rp_image *const frame = iconAnimData->frame(i);
 			if (frame && frame->isValid()) {
 				// NOTE: Allowing NULL frames here...
 				anim->iconFrames[i] = rp_image_to_PIMGTYPE(frame);
@@ -24,11 +24,14 @@
 // Other rom-properties libraries
 using namespace LibRpBase;
 using namespace LibRpText;
+using LibRpFile::IRpFile;
 using LibRpTexture::rp_image;
 
 // libromdata
 #include "libromdata/RomDataFactory.hpp"
+#include "libromdata/RomDataLoader.hpp"
 using LibRomData::RomDataFactory;
+using LibRomData::RomDataLoader;
 
 // libdl
 #ifdef HAVE_DLVSYM
@@ -78,8 +81,11 @@ static void	rp_rom_data_view_desc_format_type_changed(RpRomDataView *page,
 						 RpDescFormatType desc_format_type);
 
 static void	rp_rom_data_view_init_header_row(RpRomDataView	*page);
-static gboolean	rp_rom_data_view_update_display	(RpRomDataView	*page);
+static void	rp_rom_data_view_init_header_images(RpRomDataView *page);
+static void	rp_rom_data_view_init_fields	(RpRomDataView	*page);
 static gboolean	rp_rom_data_view_load_rom_data	(RpRomDataView	*page);
+static gboolean	rp_rom_data_view_start_loader	(RpRomDataView	*page);
+static void	rp_rom_data_view_cancel_loader	(RpRomDataView	*page);
 static void	rp_rom_data_view_delete_tabs	(RpRomDataView	*page);
 
 /** Signal handlers **/
@@ -364,7 +370,7 @@ rp_rom_data_view_init(RpRomDataView *page)
 	g_signal_connect(page, "unmap",
 		G_CALLBACK(rp_rom_data_view_unmap_signal_handler), nullptr);
 
-	// Table layout is created in rp_rom_data_view_update_display().
+	// Table layout is created in rp_rom_data_view_init_fields().
 }
 
 static void
@@ -375,6 +381,9 @@ rp_rom_data_view_dispose(GObject *object)
 	// Unregister changed_idle.
 	g_clear_handle_id(&page->changed_idle, g_source_remove);
 
+	// Cancel the asynchronous loader.
+	rp_rom_data_view_cancel_loader(page);
+
 	// Delete the icon frames and tabs.
 	rp_rom_data_view_delete_tabs(page);
 
@@ -431,8 +440,8 @@ rp_rom_data_view_new_with_romData(const gchar *uri, RomData *romData, RpDescForm
 	if (G_LIKELY(romData != nullptr)) {
 		// NOTE: Don't call rp_rom_data_view_load_rom_data() because that will
 		// close and reopen romData, which wastes CPU cycles.
-		// Call rp_rom_data_view_update_display() instead.
-		page->changed_idle = g_idle_add(G_SOURCE_FUNC(rp_rom_data_view_update_display), page);
+		// Call rp_rom_data_view_start_loader() instead.
+		page->changed_idle = g_idle_add(G_SOURCE_FUNC(rp_rom_data_view_start_loader), page);
 		page->hasCheckedAchievements = false;
 	} else if (G_LIKELY(uri != nullptr)) {
 		// URI is specified, but not RomData.
@@ -529,6 +538,9 @@ rp_rom_data_view_set_uri(RpRomDataView	*page,
 	if (G_UNLIKELY(!g_strcmp0(page->uri, uri)))
 		return;
 
+	/* Stop loading the previous file (if any) */
+	rp_rom_data_view_cancel_loader(page);
+
 	/* Disconnect from the previous file (if any) */
 	if (G_LIKELY(page->uri != nullptr)) {
 		g_free(page->uri);
@@ -646,6 +658,28 @@ rp_rom_data_view_init_header_row(RpRomDataView *page)
 		C_("RomDataView", "%1$s\n%2$s"), systemName, fileType);
 	gtk_label_set_text(GTK_LABEL(page->lblSysInfo), sysInfo.c_str());
 
+	// Images are loaded by rp_rom_data_view_init_header_images().
+	gtk_widget_set_visible(page->imgBanner, false);
+	gtk_widget_set_visible(page->imgIcon, false);
+
+	// Show the header row. (outer box)
+	gtk_widget_set_visible(page->hboxHeaderRow_outer, true);
+}
+
+static void
+rp_rom_data_view_init_header_images(RpRomDataView *page)
+{
+	// Initialize the header row images.
+	// NOTE: The images must have been loaded by RomDataLoader,
+	// since this function is called on the UI thread.
+	assert(page != nullptr);
+
+	const RomData *const romData = page->romData;
+	if (!romData) {
+		// No ROM data.
+		return;
+	}
+
 	// Supported image types.
 	const uint32_t imgbf = romData->supportedImageTypes();
 
@@ -677,9 +711,6 @@ rp_rom_data_view_init_header_row(RpRomDataView *page)
 			}
 		}
 	}
-
-	// Show the header row. (outer box)
-	gtk_widget_set_visible(page->hboxHeaderRow_outer, true);
 }
 
 /**
@@ -1628,30 +1659,22 @@ rp_rom_data_view_create_options_button(RpRomDataView *page)
 }
 
 /**
- * Update the display widgets.
+ * Initialize the field widgets.
+ * NOTE: The fields must have been loaded by RomDataLoader,
+ * since this function is called on the UI thread.
  * @param page RomDataView
- * @return G_SOURCE_REMOVE
  */
-static gboolean
-rp_rom_data_view_update_display(RpRomDataView *page)
+static void
+rp_rom_data_view_init_fields(RpRomDataView *page)
 {
-	g_return_val_if_fail(RP_IS_ROM_DATA_VIEW(page), G_SOURCE_REMOVE);
+	g_return_if_fail(RP_IS_ROM_DATA_VIEW(page));
 
 	// Delete the icon frames and tabs.
 	rp_rom_data_view_delete_tabs(page);
 
-	// Create the "Options" button.
-	if (!page->btnOptions) {
-		rp_rom_data_view_create_options_button(page);
-	}
-
-	// Initialize the header row.
-	rp_rom_data_view_init_header_row(page);
-
 	if (!page->romData) {
 		// No ROM data...
-		page->changed_idle = 0;
-		return G_SOURCE_REMOVE;
+		return;
 	}
 
 	// Get the fields.
@@ -1660,8 +1683,7 @@ rp_rom_data_view_update_display(RpRomDataView *page)
 	if (!pFields) {
 		// No fields.
 		// TODO: Show an error?
-		page->changed_idle = 0;
-		return G_SOURCE_REMOVE;
+		return;
 	}
 	int fieldCount = pFields->count();
 
@@ -1980,13 +2002,175 @@ rp_rom_data_view_update_display(RpRomDataView *page)
 		page->cxx->def_lc = pFields->defaultLanguageCode();
 		rp_rom_data_view_update_multi(page, 0);
 	}
+}
+
+/**
+ * RomDataLoader event, marshalled to the UI thread.
+ */
+struct RomDataViewLoaderEvent {
+	RpRomDataView *page;		// ref()'d
+	RomDataLoader *loader;		// ref()'d
+	RomDataLoader::Event event;
+};
+
+/**
+ * Free a RomDataViewLoaderEvent.
+ * @param ev RomDataViewLoaderEvent
+ */
+static void
+rp_rom_data_view_loader_event_free(RomDataViewLoaderEvent *ev)
+{
+	g_object_unref(ev->page);
+	ev->loader->unref();
+	delete ev;
+}
+
+/**
+ * Handle a RomDataLoader event on the UI thread.
+ * Call this function using g_idle_add_full().
+ * @param ev RomDataViewLoaderEvent
+ * @return G_SOURCE_REMOVE
+ */
+static gboolean
+rp_rom_data_view_loader_event_idle(RomDataViewLoaderEvent *ev)
+{
+	RpRomDataView *const page = ev->page;
+	if (ev->loader != page->loader) {
+		// Stale event from a cancelled loader.
+		return G_SOURCE_REMOVE;
+	}
+
+	switch (ev->event) {
+		case RomDataLoader::Event::Created:
+			// RomData object was created.
+			// Only the header information is available at this point.
+			assert(page->romData == nullptr);
+			page->romData = ev->loader->romData()->ref();
+			page->hasCheckedAchievements = false;
+			rp_rom_data_view_init_header_row(page);
+			g_object_notify_by_pspec(G_OBJECT(page), props[PROP_SHOWING_DATA]);
+			break;
+
+		case RomDataLoader::Event::FieldsLoaded:
+			rp_rom_data_view_init_fields(page);
+			break;
+
+		case RomDataLoader::Event::ImagesLoaded:
+			rp_rom_data_view_init_header_images(page);
+			if (gtk_widget_get_mapped(GTK_WIDGET(page))) {
+				rp_drag_image_start_anim_timer(RP_DRAG_IMAGE(page->imgIcon));
+			}
+			break;
+
+		case RomDataLoader::Event::Finished:
+			// Loading is complete. The worker thread is no longer
+			// using the RomData object, so it's safe to access
+			// everything from the UI thread now.
+			UNREF_AND_NULL_NOCHK(page->loader);
+
+			// Create the "Options" button.
+			if (!page->btnOptions) {
+				rp_rom_data_view_create_options_button(page);
+			}
+
+			// Check for "viewed" achievements if we're already visible.
+			// NOTE: The underlying file handle was already closed
+			// by RomDataLoader, since we don't need it anymore.
+			if (!page->hasCheckedAchievements && gtk_widget_get_mapped(GTK_WIDGET(page))) {
+				page->romData->checkViewedAchievements();
+				page->hasCheckedAchievements = true;
+			}
+			break;
+
+		case RomDataLoader::Event::Failed:
+			// ROM is not supported.
+			// The header row was hidden by rp_rom_data_view_load_rom_data().
+			UNREF_AND_NULL_NOCHK(page->loader);
+			break;
+
+		default:
+			assert(!"Unhandled RomDataLoader event.");
+			break;
+	}
+
+	return G_SOURCE_REMOVE;
+}
 
+/**
+ * RomDataLoader callback.
+ * NOTE: This is called on the loader's worker thread.
+ * @param loader RomDataLoader
+ * @param event Event
+ * @param user_data RomDataView
+ */
+static void
+rp_rom_data_view_loader_callback(RomDataLoader *loader, RomDataLoader::Event event, void *user_data)
+{
+	// Marshal the event to the UI thread.
+	// NOTE: RomDataLoader::cancel() blocks until this callback returns,
+	// and no further callbacks are made after that, so the page is
+	// guaranteed to still be alive here.
+	RomDataViewLoaderEvent *const ev = new RomDataViewLoaderEvent;
+	ev->page = RP_ROM_DATA_VIEW(g_object_ref(user_data));
+	ev->loader = loader->ref();
+	ev->event = event;
+	g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+		G_SOURCE_FUNC(rp_rom_data_view_loader_event_idle), ev,
+		(GDestroyNotify)rp_rom_data_view_loader_event_free);
+}
+
+/**
+ * Cancel the asynchronous loader, if it's running.
+ * @param page RomDataView
+ */
+static void
+rp_rom_data_view_cancel_loader(RpRomDataView *page)
+{
+	if (page->loader) {
+		// NOTE: This doesn't wait for the worker thread.
+		// The worker thread keeps its own references to the
+		// loader and the RomData object until it finishes.
+		// Any pending events will be ignored, since
+		// page->loader will no longer match.
+		page->loader->cancel();
+		UNREF_AND_NULL_NOCHK(page->loader);
+	}
+}
+
+/**
+ * Load fields and images for the existing RomData object.
+ * Call this function using g_idle_add().
+ * @param page RomDataView
+ * @return G_SOURCE_REMOVE
+ */
+static gboolean
+rp_rom_data_view_start_loader(RpRomDataView *page)
+{
+	g_return_val_if_fail(RP_IS_ROM_DATA_VIEW(page), G_SOURCE_REMOVE);
 	page->changed_idle = 0;
+
+	rp_rom_data_view_cancel_loader(page);
+	rp_rom_data_view_delete_tabs(page);
+
+	// Initialize the header row.
+	// This doesn't do any I/O, so it's done immediately.
+	rp_rom_data_view_init_header_row(page);
+	if (!page->romData) {
+		// No ROM data...
+		return G_SOURCE_REMOVE;
+	}
+
+	page->loader = new RomDataLoader(page->romData, rp_rom_data_view_loader_callback, page);
+	if (page->loader->start() != 0) {
+		// Unable to start the worker thread.
+		UNREF_AND_NULL_NOCHK(page->loader);
+	}
 	return G_SOURCE_REMOVE;
 }
 
 /**
  * Reload the RomData object from the current URI.
+ * The RomData object is created on a worker thread by RomDataLoader.
  * Call this function using g_idle_add().
  * @param page RomDataView
  * @return G_SOURCE_REMOVE
@@ -1996,10 +2180,15 @@ rp_rom_data_view_load_rom_data(RpRomDataView *page)
 {
 	g_return_val_if_fail(RP_IS_ROM_DATA_VIEW(page), G_SOURCE_REMOVE);
 
+	// Clear the timeout.
+	page->changed_idle = 0;
+
+	// Cancel the previous loader, if any.
+	rp_rom_data_view_cancel_loader(page);
+
 	if (G_UNLIKELY(page->uri == nullptr)) {
 		// No URI or RomData.
 		// TODO: Remove widgets?
-		page->changed_idle = 0;
 		return G_SOURCE_REMOVE;
 	}
 
@@ -2010,34 +2199,28 @@ rp_rom_data_view_load_rom_data(RpRomDataView *page)
 		page->hasCheckedAchievements = false;
 		g_object_notify_by_pspec(G_OBJECT(page), props[PROP_SHOWING_DATA]);
 	}
-
-	// Load the specified URI.
-	RomData *const romData = rp_gtk_open_uri(page->uri);
-	if (romData) {
-		// FIXME: If called from rp_rom_data_view_set_property(), this might
-		// result in *two* notifications.
-		page->romData = romData;
-		page->hasCheckedAchievements = false;
-		g_object_notify_by_pspec(G_OBJECT(page), props[PROP_SHOWING_DATA]);
+	rp_rom_data_view_delete_tabs(page);
+	if (page->hboxHeaderRow_outer) {
+		gtk_widget_set_visible(page->hboxHeaderRow_outer, false);
 	}
 
-	if (page->romData) {
-		// Update the display widgets.
-		// TODO: If already mapped, check achievements again.
-		// NOTE: This will clear page->changed_idle.
-		rp_rom_data_view_update_display(page);
-
-		// Make sure the underlying file handle is closed,
-		// since we don't need it once the RomData has been
-		// loaded by RomDataView.
-		page->romData->close();
+	// Open the specified URI.
+	IRpFile *const file = rp_gtk_open_uri_file(page->uri);
+	if (!file) {
+		// Unable to open the file.
+		return G_SOURCE_REMOVE;
 	}
 
+	// Create the RomData object on a worker thread.
+	// The display is updated progressively as events arrive.
 	// Animation timer will be started when the page
 	// receives the "map" signal.
-
-	// Clear the timeout.
-	page->changed_idle = 0;
+	page->loader = new RomDataLoader(file, rp_rom_data_view_loader_callback, page);
+	file->unref();	// file is ref()'d by RomDataLoader.
+	if (page->loader->start() != 0) {
+		// Unable to start the worker thread.
+		UNREF_AND_NULL_NOCHK(page->loader);
+	}
 	return G_SOURCE_REMOVE;
 }
 
@@ -2155,7 +2338,9 @@ rp_rom_data_view_map_signal_handler(RpRomDataView	*page,
 	}
 
 	// Check for "viewed" achievements.
-	if (!page->hasCheckedAchievements) {
+	// NOTE: If the RomData object is still being loaded, this
+	// will be done when loading is finished.
+	if (!page->hasCheckedAchievements && page->romData && !page->loader) {
 		page->romData->checkViewedAchievements();
 		page->hasCheckedAchievements = true;
 	}
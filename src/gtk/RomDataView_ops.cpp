@@ -457,6 +457,10 @@ btnOptions_triggered_signal_handler(RpOptionsMenuButton *menuButton,
 				    RpRomDataView *page)
 {
 	RP_UNUSED(menuButton);
+	if (!page->romData || page->loader) {
+		// RomData is still being loaded on a worker thread.
+		return;
+	}
 	GtkWindow *const parent = gtk_widget_get_toplevel_window(GTK_WIDGET(page));
 
 	if (id < 0) {
@@ -18,6 +18,10 @@ namespace LibRpBase {
 	class RomData;
 	class RomFields;
 }
+// libromdata
+namespace LibRomData {
+	class RomDataLoader;
+}
 
 // C++ includes
 #include <vector>
@@ -85,6 +89,7 @@ struct _RpRomDataView {
 
 	_RpRomDataViewCxx	*cxx;		// C++ objects
 	LibRpBase::RomData	*romData;	// ROM data
+	LibRomData::RomDataLoader *loader;	// Asynchronous loader (non-null while loading)
 	gchar			*uri;		// URI (GVfs)
 
 	// Header row.
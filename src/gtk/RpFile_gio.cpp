@@ -135,6 +135,8 @@ void RpFileGio::init(void)
 
 	// File is open.
 	// TODO: Transparent gzip decompression?
+	// NOTE: RpFileGio is only used for non-local files.
+	m_isRemote = true;
 }
 
 RpFileGio::~RpFileGio()
@@ -2,18 +2,26 @@
  * ROM Properties Page shell extension. (GTK+ common)                      *
  * CairoImageConv.cpp: Helper functions to convert from rp_image to Cairo. *
  *                                                                         *
- * Copyright (c) 2017-2022 by David Korth.                                 *
+ * Copyright (c) 2017-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
-#include "stdafx.h"
+// NOTE: Not using stdafx.h here, since this file is also
+// used by ThumbnailBenchmark, which doesn't use GTK+.
 #include "CairoImageConv.hpp"
 
+// C includes (C++ namespace)
+#include <cassert>
+#include <cstring>
+#include <stdint.h>
+
 // C++ STL classes.
+#include <array>
 using std::array;
 
 // librptexture
 #include "librptexture/ImageSizeCalc.hpp"
+#include "librptexture/img/rp_image.hpp"
 using namespace LibRpTexture;
 
 /**
@@ -48,30 +56,26 @@ cairo_surface_t *CairoImageConv::rp_image_to_cairo_surface_t(const rp_image *img
 
 	switch (img->format()) {
 		case rp_image::Format::ARGB32: {
-			const rp_image *img_prex;
+			int dest_stride = cairo_image_surface_get_stride(surface);
 			if (premultiply) {
-				// Premultiply the image first.
-				// TODO: Combined dup()/premultiply() function?
-				img_prex = img->dup();
-				const_cast<rp_image*>(img_prex)->premultiply();
-			} else {
-				// No premultiplication.
-				img_prex = img;
+				// Premultiply the image while copying it.
+				img->premultiply_to(px_dest, dest_stride);
+				cairo_surface_mark_dirty(surface);
+				break;
 			}
 
+			// No premultiplication.
 			// Copy the image data.
-			int dest_stride = cairo_image_surface_get_stride(surface);
-			int src_stride = img_prex->stride();
-
+			int src_stride = img->stride();
 			if (dest_stride == src_stride) {
 				// Stride is identical. Copy the whole image all at once.
 				// NOTE: Partial copy for the last line.
 				size_t sz = ImageSizeCalc::T_calcImageSize(dest_stride, (height - 1));
 				sz += width * sizeof(uint32_t);
-				memcpy(px_dest, img_prex->bits(), sz);
+				memcpy(px_dest, img->bits(), sz);
 			} else {
 				// Stride is not identical. Copy each scanline.
-				const uint32_t *img_buf = static_cast<const uint32_t*>(img_prex->bits());
+				const uint32_t *img_buf = static_cast<const uint32_t*>(img->bits());
 				const int row_bytes = img->row_bytes();
 				// We're adding strides to pointers, so the strides
 				// must be in uint32_t units here.
@@ -86,9 +90,6 @@ cairo_surface_t *CairoImageConv::rp_image_to_cairo_surface_t(const rp_image *img
 
 			// Mark the surface as dirty.
 			cairo_surface_mark_dirty(surface);
-			if (premultiply) {
-				img_prex->unref();
-			}
 			break;
 		}
 
@@ -135,8 +136,6 @@ cairo_surface_t *CairoImageConv::rp_image_to_cairo_surface_t(const rp_image *img
 				for (; x > 0; x--, px_dest++, img_buf++) {
 					// Last pixels.
 					*px_dest = pal_toUse[*img_buf];
-					px_dest++;
-					img_buf++;
 				}
 
 				// Next line.
@@ -159,3 +158,53 @@ cairo_surface_t *CairoImageConv::rp_image_to_cairo_surface_t(const rp_image *img
 
 	return surface;
 }
+
+/**
+ * Rescale a cairo_surface_t.
+ * @param surface	[in] cairo_surface_t
+ * @param width		[in] New width
+ * @param height	[in] New height
+ * @param bilinear	[in] If true, use bilinear interpolation.
+ * @return Rescaled image. (If unable to rescale, returns a new reference to surface.)
+ */
+cairo_surface_t *CairoImageConv::scale(cairo_surface_t *surface, int width, int height, bool bilinear)
+{
+	// TODO: Maintain aspect ratio, and use nearest-neighbor
+	// when scaling up from small sizes.
+	const int srcWidth = cairo_image_surface_get_width(surface);
+	const int srcHeight = cairo_image_surface_get_height(surface);
+	assert(srcWidth > 0 && srcHeight > 0);
+	if (unlikely(srcWidth <= 0 || srcHeight <= 0)) {
+		return cairo_surface_reference(surface);
+	}
+
+	cairo_surface_t *const dest = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+	assert(dest != nullptr);
+	assert(cairo_surface_status(dest) == CAIRO_STATUS_SUCCESS);
+	if (unlikely(!dest)) {
+		return cairo_surface_reference(surface);
+	} else if (cairo_surface_status(dest) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(dest);
+		return cairo_surface_reference(surface);
+	}
+
+	cairo_t *const cr = cairo_create(dest);
+	assert(cr != nullptr);
+	assert(cairo_status(cr) == CAIRO_STATUS_SUCCESS);
+	if (unlikely(!cr)) {
+		cairo_surface_destroy(dest);
+		return cairo_surface_reference(surface);
+	} else if (cairo_status(cr) != CAIRO_STATUS_SUCCESS) {
+		cairo_destroy(cr);
+		cairo_surface_destroy(dest);
+		return cairo_surface_reference(surface);
+	}
+
+	cairo_pattern_set_filter(cairo_get_source(cr),
+		(bilinear ? CAIRO_FILTER_BILINEAR : CAIRO_FILTER_NEAREST));
+	cairo_scale(cr, (double)width / (double)srcWidth, (double)height / (double)srcHeight);
+	cairo_set_source_surface(cr, surface, 0, 0);
+	cairo_paint(cr);
+	cairo_destroy(cr);
+	return dest;
+}
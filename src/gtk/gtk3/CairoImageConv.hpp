@@ -10,6 +10,10 @@
 
 // NOTE: Cairo doesn't natively support 8bpp. Because of this,
 // we can't simply make a cairo_surface_t rp_image backend.
+// In addition, CAIRO_FORMAT_ARGB32 is premultiplied, whereas rp_image
+// uses straight alpha, so an ARGB32 backend would still need a separate
+// premultiply pass. rp_image::premultiply_to() premultiplies while
+// copying into the surface instead.
 
 #include "common.h"
 #include "librpcpu/cpu_dispatch.h"
@@ -35,4 +39,14 @@ class CairoImageConv
 		 * @return cairo_surface_t, or nullptr on error.
 		 */
 		static cairo_surface_t *rp_image_to_cairo_surface_t(const LibRpTexture::rp_image *img, bool premultiply = true);
+
+		/**
+		 * Rescale a cairo_surface_t.
+		 * @param surface	[in] cairo_surface_t
+		 * @param width		[in] New width
+		 * @param height	[in] New height
+		 * @param bilinear	[in] If true, use bilinear interpolation.
+		 * @return Rescaled image. (If unable to rescale, returns a new reference to surface.)
+		 */
+		static cairo_surface_t *scale(cairo_surface_t *surface, int width, int height, bool bilinear);
 };
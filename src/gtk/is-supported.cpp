@@ -10,24 +10,24 @@
 #include "is-supported.hpp"
 
 // librpfile, librpbase, libromdata
+#include "librpfile/CancellableFile.hpp"
 #include "libromdata/RomDataFactory.hpp"
+using LibRpFile::CancellableFile;
 using LibRpFile::IRpFile;
 using LibRpFile::RpFile;
 using LibRpBase::RomData;
 using LibRomData::RomDataFactory;
 
 /**
- * Attempt to open a RomData object from the specified GVfs URI.
- * If it is, the RomData object will be opened.
+ * Open an IRpFile for the specified GVfs URI.
+ * Local files are opened using RpFile; others use RpFileGio.
  * @param uri URI from e.g. nautilus_file_info_get_uri() [UTF-8]
- * @return RomData object if supported; nullptr if not.
+ * @return IRpFile if opened successfully; nullptr if not.
  */
-LibRpBase::RomData *rp_gtk_open_uri(const gchar *uri)
+IRpFile *rp_gtk_open_uri_file(const gchar *uri)
 {
 	g_return_val_if_fail(uri != nullptr && uri[0] != '\0', nullptr);
 
-	// TODO: Check file extensions and/or MIME types?
-
 	// Check if the URI maps to a local file.
 	IRpFile *file = nullptr;
 	gchar *const filename = g_filename_from_uri(uri, nullptr, nullptr);
@@ -40,13 +40,46 @@ LibRpBase::RomData *rp_gtk_open_uri(const gchar *uri)
 		file = new RpFileGio(uri);
 	}
 
-	// Open the ROM file.
-	RomData *romData = nullptr;
-	if (file->isOpen()) {
-		// Attempt to open the ROM file.
-		romData = RomDataFactory::create(file);
+	if (!file->isOpen()) {
+		file->unref();
+		return nullptr;
+	}
+	return file;
+}
+
+/**
+ * Attempt to open a RomData object from the specified GVfs URI.
+ * If it is, the RomData object will be opened.
+ *
+ * The file is opened through a CancellableFile, so RomDataView's
+ * loader can abort pending reads if the property page is closed
+ * while it's still loading. The RomData object isn't cached,
+ * since it can't read from its file once it's been cancelled.
+ *
+ * @param uri URI from e.g. nautilus_file_info_get_uri() [UTF-8]
+ * @return RomData object if supported; nullptr if not.
+ */
+LibRpBase::RomData *rp_gtk_open_uri(const gchar *uri)
+{
+	g_return_val_if_fail(uri != nullptr && uri[0] != '\0', nullptr);
+
+	// TODO: Check file extensions and/or MIME types?
+
+	IRpFile *const file = rp_gtk_open_uri_file(uri);
+	if (!file) {
+		return nullptr;
+	}
+
+	// Attempt to open the ROM file.
+	// NOTE: Devices are opened directly, since RomData subclasses
+	// may need to access the underlying RpFile.
+	IRpFile *createFile = file;
+	if (!file->isDevice()) {
+		createFile = new CancellableFile(file);
+		file->unref();
 	}
-	file->unref();
+	RomData *const romData = RomDataFactory::create(createFile);
+	createFile->unref();
 
 	return romData;
 }
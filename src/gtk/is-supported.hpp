@@ -14,10 +14,27 @@
 namespace LibRomData {
 	class RomData;
 };
+namespace LibRpFile {
+	class IRpFile;
+};
+
+/**
+ * Open an IRpFile for the specified GVfs URI.
+ * Local files are opened using RpFile; others use RpFileGio.
+ * @param uri URI from e.g. nautilus_file_info_get_uri() [UTF-8]
+ * @return IRpFile if opened successfully; nullptr if not.
+ */
+LibRpFile::IRpFile *rp_gtk_open_uri_file(const gchar *uri);
 
 /**
  * Attempt to open a RomData object from the specified GVfs URI.
  * If it is, the RomData object will be opened.
+ *
+ * The file is opened through a CancellableFile, so RomDataView's
+ * loader can abort pending reads if the property page is closed
+ * while it's still loading. The RomData object isn't cached,
+ * since it can't read from its file once it's been cancelled.
+ *
  * @param uri URI from e.g. nautilus_file_info_get_uri() [UTF-8]
  * @return RomData object if supported; nullptr if not.
  */
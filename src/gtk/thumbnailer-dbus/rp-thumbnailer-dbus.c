@@ -18,9 +18,12 @@
 #include "SpecializedThumbnailer1.h"
 
 // C includes.
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // from tumbler-utils.h
 #define g_dbus_async_return_val_if_fail(expr, invocation, val) \
@@ -93,12 +96,16 @@ struct _RpThumbnailerClass {
 
 #define SHUTDOWN_TIMEOUT_SECONDS 30U
 
+// Number of queued requests to prefetch while processing a request.
+#define PREFETCH_QUEUE_DEPTH 4U
+
 // Thumbnail request information.
 struct request_info {
 	gchar *uri;
 	guint32 handle;
-	bool large;	// False for 'normal' (128x128); true for 'large' (256x256)
-	bool urgent;	// 'urgent' value
+	bool large;		// False for 'normal' (128x128); true for 'large' (256x256)
+	bool urgent;		// 'urgent' value
+	bool prefetched;	// Has this file been prefetched?
 };
 
 struct _RpThumbnailer {
@@ -120,6 +127,13 @@ struct _RpThumbnailer {
 	// Request queue.
 	GQueue request_queue;	// element is struct request_info*
 
+#ifdef POSIX_FADV_WILLNEED
+	// Prefetch thread pool. (element is gchar* filename)
+	// open() and fstat() may block on slow filesystems,
+	// so prefetching is done off of the main loop.
+	GThreadPool *prefetch_pool;
+#endif /* POSIX_FADV_WILLNEED */
+
 	/** Properties. **/
 
 	// D-Bus connection.
@@ -275,6 +289,16 @@ rp_thumbnailer_dispose(GObject *object)
 	g_clear_handle_id(&thumbnailer->timeout_id, g_source_remove);
 	g_clear_handle_id(&thumbnailer->idle_process, g_source_remove);
 
+#ifdef POSIX_FADV_WILLNEED
+	// Shut down the prefetch thread pool.
+	// NOTE: Pending prefetches are still run so their filenames
+	// are freed. There's at most PREFETCH_QUEUE_DEPTH of them.
+	if (thumbnailer->prefetch_pool) {
+		g_thread_pool_free(thumbnailer->prefetch_pool, FALSE, TRUE);
+		thumbnailer->prefetch_pool = NULL;
+	}
+#endif /* POSIX_FADV_WILLNEED */
+
 	/** Properties **/
 	g_clear_object(&thumbnailer->connection);
 
@@ -433,6 +457,7 @@ rp_thumbnailer_queue(SpecializedThumbnailer1 *skeleton,
 	req->handle = handle;
 	req->large = flavor && (g_ascii_strcasecmp(flavor, "large") == 0);
 	req->urgent = urgent;
+	req->prefetched = false;
 	// TODO Put 'urgent' requests at the front of the queue?
 	g_queue_push_tail(&thumbnailer->request_queue, req);
 
@@ -489,6 +514,108 @@ rp_thumbnailer_timeout(RpThumbnailer *thumbnailer)
 	return false;
 }
 
+#ifdef POSIX_FADV_WILLNEED
+/**
+ * File ranges that are read by RomDataFactory::create().
+ * These are prefetched for queued files.
+ * The end of the file is prefetched separately.
+ */
+static const struct {
+	off_t addr;
+	off_t len;
+} prefetch_ranges[] = {
+	// Header buffer (4096+256 bytes) and headers within the first 64 KiB,
+	// e.g. ISO-9660 PVD (0x8000), Sega 8-bit (0x7FE0), SNES (0x7FB0, 0xFFB0)
+	{0, 64*1024},
+	// game.com and ISO-9660 (0x40000)
+	{0x40000, 4096},
+	// SNES ExHiROM (0x40FFB0)
+	{0x40F000, 4096},
+};
+
+/**
+ * Prefetch the parts of a local file that RomDataFactory will read.
+ * This uses posix_fadvise(), so the data is read asynchronously.
+ *
+ * NOTE: This is run on the prefetch thread pool, since open()
+ * and fstat() may block, e.g. on network filesystems.
+ *
+ * @param filename Local filename (g_malloc()'d; will be freed)
+ * @param user_data Unused
+ */
+static void
+rp_thumbnailer_prefetch_file(gpointer filename, gpointer user_data)
+{
+	RP_UNUSED(user_data);
+
+	const int fd = open((const char*)filename, O_RDONLY | O_CLOEXEC);
+	g_free(filename);
+	if (fd < 0) {
+		// Unable to open the file.
+		return;
+	}
+
+	struct stat sb;
+	if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size <= 0) {
+		// Not a regular file, or the file is empty.
+		close(fd);
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(prefetch_ranges); i++) {
+		if (prefetch_ranges[i].addr >= sb.st_size)
+			break;
+		posix_fadvise(fd, prefetch_ranges[i].addr, prefetch_ranges[i].len, POSIX_FADV_WILLNEED);
+	}
+
+	// RomData subclasses that use a footer read from the last 4 KiB.
+	if (sb.st_size > prefetch_ranges[0].len) {
+		const off_t footer_addr = (sb.st_size > 4096 ? sb.st_size - 4096 : 0);
+		posix_fadvise(fd, footer_addr, sb.st_size - footer_addr, POSIX_FADV_WILLNEED);
+	}
+
+	close(fd);
+}
+
+/**
+ * Prefetch the next few local files in the request queue,
+ * so their I/O overlaps with processing the current request.
+ * The files are opened on the prefetch thread pool.
+ * @param thumbnailer RpThumbnailer object.
+ */
+static void
+rp_thumbnailer_prefetch_queue(RpThumbnailer *thumbnailer)
+{
+	if (!thumbnailer->prefetch_pool) {
+		// Create the prefetch thread pool.
+		// One thread is enough, since posix_fadvise() doesn't wait for the I/O.
+		thumbnailer->prefetch_pool = g_thread_pool_new(
+			rp_thumbnailer_prefetch_file, NULL, 1, FALSE, NULL);
+		if (!thumbnailer->prefetch_pool) {
+			// Unable to create the thread pool.
+			return;
+		}
+	}
+
+	unsigned int count = 0;
+	for (GList *p = thumbnailer->request_queue.head;
+	     p != NULL && count < PREFETCH_QUEUE_DEPTH; p = p->next, count++)
+	{
+		struct request_info *const req = (struct request_info*)p->data;
+		if (!req || req->prefetched)
+			continue;
+		req->prefetched = true;
+
+		// Only local files can be prefetched.
+		// NOTE: The thread pool takes ownership of filename.
+		gchar *const filename = g_filename_from_uri(req->uri, NULL, NULL);
+		if (filename) {
+			g_thread_pool_push(thumbnailer->prefetch_pool, filename, NULL);
+		}
+	}
+}
+#endif /* POSIX_FADV_WILLNEED */
+
 /**
  * Process a thumbnail.
  * @param thumbnailer RpThumbnailer object.
@@ -512,6 +639,11 @@ rp_thumbnailer_process(RpThumbnailer *thumbnailer)
 		goto cleanup;
 	}
 
+#ifdef POSIX_FADV_WILLNEED
+	// Prefetch the next few queued files while this one is processed.
+	rp_thumbnailer_prefetch_queue(thumbnailer);
+#endif /* POSIX_FADV_WILLNEED */
+
 	// NOTE: cache_dir and pfn_rp_create_thumbnail2 should NOT be NULL
 	// at this point, but we're checking it anyway.
 	if (!thumbnailer->cache_dir || thumbnailer->cache_dir[0] == 0) {
@@ -173,7 +173,7 @@ bool DragImageLabel::updatePixmaps(void)
 
 		// Convert the icons to QPixmaps.
 		for (int i = iconAnimData->count-1; i >= 0; i--) {
-			const rp_image *const frame = iconAnimData->frames[i];
+			const rp_image *const frame = iconAnimData->frame(i);
 			if (frame && frame->isValid()) {
 				// NOTE: Allowing NULL frames here...
 				m_anim->iconFrames[i] = imgToPixmap(rpToQImage(frame));
@@ -88,7 +88,7 @@ void ExtractorPlugin::extract(ExtractionResult *result)
 
 	// Get the appropriate RomData class for this ROM.
 	// file is dup()'d by RomData.
-	RomData *const romData = RomDataFactory::create(file, RomDataFactory::RDA_HAS_METADATA);
+	RomData *const romData = RomDataFactory::createCached(file, RomDataFactory::RDA_HAS_METADATA);
 	file->unref();	// file is ref()'d by RomData.
 	if (!romData) {
 		// ROM is not supported.
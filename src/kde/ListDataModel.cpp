@@ -606,7 +606,10 @@ void ListDataModel::setField(const RomFields::Field *pField)
 		// Also, we can assume all rows are present, since
 		// icons and checkboxes are mutually exclusive.
 		d->icons.reserve(rowCount);
-		for (const rp_image *icon : *(pField->data.list_data.mxd.icons)) {
+		const RomFields::ListDataIcons_t *const icons = pField->data.list_data.mxd.icons;
+		const size_t icon_count = icons->size();
+		for (size_t i = 0; i < icon_count; i++) {
+			const rp_image *const icon = icons->at(i);
 			d->icons_rp.emplace_back(icon ? icon->ref() : nullptr);
 		}
 		// Update the icons pixmap vector.
@@ -67,7 +67,7 @@ QStringList OverlayIconPlugin::getOverlays(const QUrl &item)
 	}
 
 	// Get the appropriate RomData class for this ROM.
-	RomData *const romData = RomDataFactory::create(file, RomDataFactory::RDA_HAS_DPOVERLAY);
+	RomData *const romData = RomDataFactory::createCached(file, RomDataFactory::RDA_HAS_DPOVERLAY);
 	file->unref();	// file is ref()'d by RomData.
 	if (!romData) {
 		// No RomData.
@@ -21,6 +21,9 @@ using namespace LibRpFile;
 using namespace LibRpText;
 using LibRpTexture::rp_image;
 
+// libromdata
+using LibRomData::RomDataLoader;
+
 // libi18n
 #include "libi18n/i18n.h"
 
@@ -43,6 +46,8 @@ using std::vector;
 RomDataViewPrivate::RomDataViewPrivate(RomDataView *q, RomData *romData)
 	: q_ptr(q)
 	, romData(nullptr)
+	, loader(nullptr)
+	, loaderGen(0)
 	, btnOptions(nullptr)
 #ifdef HAVE_KMESSAGEWIDGET
 	, messageWidget(nullptr)
@@ -58,6 +63,7 @@ RomDataViewPrivate::RomDataViewPrivate(RomDataView *q, RomData *romData)
 
 RomDataViewPrivate::~RomDataViewPrivate()
 {
+	cancelLoader();
 	ui.lblIcon->clearRp();
 	ui.lblBanner->clearRp();
 	UNREF(romData);
@@ -128,7 +134,11 @@ void RomDataViewPrivate::createOptionsButton(void)
 			 q, SLOT(btnOptions_triggered(int)));
 
 	// Initialize the menu options.
-	btnOptions->reinitMenu(romData);
+	// NOTE: If the RomData object is still being loaded,
+	// this will be done when loading is finished.
+	if (romData && !loader) {
+		btnOptions->reinitMenu(romData);
+	}
 }
 
 /**
@@ -165,6 +175,22 @@ void RomDataViewPrivate::initHeaderRow(void)
 	ui.lblSysInfo->setText(sysInfo);
 	ui.lblSysInfo->show();
 
+	// Images are loaded by initHeaderImages().
+	ui.lblBanner->hide();
+	ui.lblIcon->hide();
+}
+
+/**
+ * Initialize the header row images.
+ * The images must have already been loaded by RomDataLoader.
+ */
+void RomDataViewPrivate::initHeaderImages(void)
+{
+	if (!romData) {
+		// No ROM data.
+		return;
+	}
+
 	// Supported image types.
 	const uint32_t imgbf = romData->supportedImageTypes();
 
@@ -905,6 +931,9 @@ void RomDataViewPrivate::updateMulti(uint32_t user_lc)
  */
 void RomDataViewPrivate::initDisplayWidgets(void)
 {
+	// Cancel the previous loader, if any.
+	cancelLoader();
+
 	// Clear the tabs.
 	for (RomDataViewPrivate::tab &tab : tabs) {
 		// Delete the credits label if it's present.
@@ -938,6 +967,16 @@ void RomDataViewPrivate::initDisplayWidgets(void)
 		return;
 	}
 
+	// Load the fields and images asynchronously.
+	startLoader();
+}
+
+/**
+ * Initialize the field widgets.
+ * The fields must have already been loaded by RomDataLoader.
+ */
+void RomDataViewPrivate::initFields(void)
+{
 	// Get the fields.
 	const RomFields *const pFields = romData->fields();
 	assert(pFields != nullptr);
@@ -1105,11 +1144,67 @@ void RomDataViewPrivate::initDisplayWidgets(void)
 	for (const tab &tab : tabs) {
 		tab.form->addItem(new QSpacerItem(0, 0));
 	}
+}
+
+/** Asynchronous loading **/
+
+/**
+ * RomDataLoader callback.
+ * NOTE: This is called on the loader's worker thread.
+ * @param loader RomDataLoader
+ * @param event Event
+ * @param user_data RomDataViewPrivate
+ */
+void RomDataViewPrivate::loaderCallback(RomDataLoader *loader, RomDataLoader::Event event, void *user_data)
+{
+	Q_UNUSED(loader)
+
+	// Queue the event for the UI thread.
+	// NOTE: RomDataLoader::cancel() blocks until this callback returns,
+	// and loaderGen is only changed after cancel(), so it's safe to
+	// read it here.
+	RomDataViewPrivate *const d = static_cast<RomDataViewPrivate*>(user_data);
+	QMetaObject::invokeMethod(d->q_ptr, "loaderEvent_slot", Qt::QueuedConnection,
+		Q_ARG(uint, d->loaderGen), Q_ARG(int, static_cast<int>(event)));
+}
+
+/**
+ * Start loading fields and images for romData.
+ */
+void RomDataViewPrivate::startLoader(void)
+{
+	cancelLoader();
+	if (!romData)
+		return;
 
-	// Close the file.
-	// Keeping the file open may prevent the user from
-	// changing the file.
-	romData->close();
+	loader = new RomDataLoader(romData, loaderCallback, this);
+	if (loader->start() != 0) {
+		// Unable to start the worker thread.
+		// Load everything synchronously instead.
+		UNREF_AND_NULL_NOCHK(loader);
+		initFields();
+		initHeaderImages();
+		if (btnOptions) {
+			btnOptions->reinitMenu(romData);
+		}
+		// No loader is using romData, so close the file here.
+		romData->close();
+	}
+}
+
+/**
+ * Cancel the asynchronous loader, if it's running.
+ */
+void RomDataViewPrivate::cancelLoader(void)
+{
+	if (loader) {
+		// NOTE: This doesn't wait for the worker thread.
+		// The worker thread keeps its own references to the
+		// loader and the RomData object until it finishes.
+		loader->cancel();
+		UNREF_AND_NULL_NOCHK(loader);
+		loaderGen++;
+	}
 }
 
 /** RomDataView **/
@@ -1163,7 +1258,9 @@ void RomDataView::showEvent(QShowEvent *event)
 	}
 
 	// Check for "viewed" achievements.
-	if (!d->hasCheckedAchievements) {
+	// NOTE: If the RomData object is still being loaded,
+	// this will be done when loading is finished.
+	if (!d->hasCheckedAchievements && d->romData && !d->loader) {
 		d->romData->checkViewedAchievements();
 		d->hasCheckedAchievements = true;
 	}
@@ -1279,6 +1376,62 @@ void RomDataView::cboLanguage_lcChanged_slot(uint32_t lc)
 	d->updateMulti(lc);
 }
 
+/**
+ * A RomDataLoader event was received.
+ * Queued from RomDataViewPrivate::loaderCallback().
+ * @param gen Loader generation
+ * @param event RomDataLoader::Event
+ */
+void RomDataView::loaderEvent_slot(uint gen, int event)
+{
+	Q_D(RomDataView);
+	if (!d->loader || gen != d->loaderGen) {
+		// Stale event from a cancelled loader.
+		return;
+	}
+
+	switch (static_cast<RomDataLoader::Event>(event)) {
+		case RomDataLoader::Event::FieldsLoaded:
+			d->initFields();
+			break;
+
+		case RomDataLoader::Event::ImagesLoaded:
+			d->initHeaderImages();
+			if (isVisible()) {
+				d->ui.lblIcon->startAnimTimer();
+			}
+			break;
+
+		case RomDataLoader::Event::Finished:
+			// Loading is complete. The worker thread is no longer
+			// using the RomData object, so it's safe to access
+			// everything from the UI thread now.
+			UNREF_AND_NULL_NOCHK(d->loader);
+
+			// Initialize the menu options.
+			if (d->btnOptions) {
+				d->btnOptions->reinitMenu(d->romData);
+			}
+
+			// Check for "viewed" achievements if we're already visible.
+			// NOTE: The file was already closed by RomDataLoader.
+			if (!d->hasCheckedAchievements && isVisible()) {
+				d->romData->checkViewedAchievements();
+				d->hasCheckedAchievements = true;
+			}
+			break;
+
+		case RomDataLoader::Event::Failed:
+			UNREF_AND_NULL_NOCHK(d->loader);
+			break;
+
+		default:
+			// Created is not used, since the RomData object
+			// is created before RomDataView.
+			break;
+	}
+}
+
 /** Properties. **/
 
 /**
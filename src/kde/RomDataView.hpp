@@ -71,6 +71,14 @@ class RomDataView : public QWidget
 		 */
 		void cboLanguage_lcChanged_slot(uint32_t lc);
 
+		/**
+		 * A RomDataLoader event was received.
+		 * Queued from RomDataViewPrivate::loaderCallback().
+		 * @param gen Loader generation
+		 * @param event RomDataLoader::Event
+		 */
+		void loaderEvent_slot(uint gen, int event);
+
 	public:
 		/** Properties. **/
 
@@ -290,6 +290,10 @@ void RomDataView::btnOptions_triggered(int id)
 	// IDs below 0 are for built-in actions.
 	// IDs >= 0 are for RomData-specific actions.
 	Q_D(RomDataView);
+	if (!d->romData || d->loader) {
+		// RomData is still being loaded on a worker thread.
+		return;
+	}
 
 	if (id < 0) {
 		// Standard operation.
@@ -36,6 +36,9 @@ namespace LibRpBase {
 	class RomFields;
 }
 
+// libromdata
+#include "libromdata/RomDataLoader.hpp"
+
 // C++ includes
 #include <vector>
 
@@ -65,6 +68,12 @@ class RomDataViewPrivate
 		// RomData object.
 		LibRpBase::RomData *romData;
 
+		// Asynchronous loader. (non-null while loading)
+		LibRomData::RomDataLoader *loader;
+		// Loader generation. Incremented when a loader is cancelled
+		// so that queued events from the old loader are ignored.
+		unsigned int loaderGen;
+
 		// Tab contents.
 		struct tab {
 			QVBoxLayout *vbox;
@@ -116,6 +125,12 @@ class RomDataViewPrivate
 		 */
 		void initHeaderRow(void);
 
+		/**
+		 * Initialize the header row images.
+		 * The images must have already been loaded by RomDataLoader.
+		 */
+		void initHeaderImages(void);
+
 		/**
 		 * Clear a QLayout.
 		 * @param layout QLayout.
@@ -221,13 +236,45 @@ class RomDataViewPrivate
 		 */
 		int updateField(int fieldIdx);
 
+		/**
+		 * Initialize the field widgets.
+		 * The fields must have already been loaded by RomDataLoader.
+		 */
+		void initFields(void);
+
 		/**
 		 * Initialize the display widgets.
 		 * If the widgets already exist, they will
 		 * be deleted and recreated.
+		 *
+		 * The header row is initialized immediately. Fields and
+		 * images are loaded asynchronously by RomDataLoader.
 		 */
 		void initDisplayWidgets(void);
 
+	public:
+		/** Asynchronous loading **/
+
+		/**
+		 * RomDataLoader callback.
+		 * NOTE: This is called on the loader's worker thread.
+		 * @param loader RomDataLoader
+		 * @param event Event
+		 * @param user_data RomDataViewPrivate
+		 */
+		static void loaderCallback(LibRomData::RomDataLoader *loader,
+			LibRomData::RomDataLoader::Event event, void *user_data);
+
+		/**
+		 * Start loading fields and images for romData.
+		 */
+		void startLoader(void);
+
+		/**
+		 * Cancel the asynchronous loader, if it's running.
+		 */
+		void cancelLoader(void);
+
 	public:
 		/**
 		 * ROM operation: Standard Operations
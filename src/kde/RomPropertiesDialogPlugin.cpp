@@ -20,7 +20,9 @@
 #include "RomDataView.hpp"
 
 // librpbase, librpfile
+#include "librpfile/CancellableFile.hpp"
 using LibRpBase::RomData;
+using LibRpFile::CancellableFile;
 using LibRpFile::IRpFile;
 
 // libromdata
@@ -47,22 +49,30 @@ RomDataView *RomPropertiesDialogPlugin::createRomDataView(const KFileItem &fileI
 	}
 
 	// Get the appropriate RomData class for this ROM.
-	RomData *const romData = RomDataFactory::create(file);
-	file->unref();	// file is ref()'d by RomData.
+	// The file is opened through a CancellableFile, so RomDataView's
+	// loader can abort pending reads if the dialog is closed while
+	// it's still loading. The RomData object isn't cached, since it
+	// can't read from its file once it's been cancelled.
+	// NOTE: Devices are opened directly, since RomData subclasses
+	// may need to access the underlying RpFile.
+	IRpFile *createFile = file;
+	if (!file->isDevice()) {
+		createFile = new CancellableFile(file);
+		file->unref();	// file is ref()'d by CancellableFile.
+	}
+	RomData *const romData = RomDataFactory::create(createFile);
+	createFile->unref();	// createFile is ref()'d by RomData.
 	if (!romData) {
 		// ROM is not supported.
 		return nullptr;
 	}
 
 	// ROM is supported. Show the properties.
+	// NOTE: RomDataView loads the fields and images asynchronously,
+	// and it will close the underlying file handle once it's done.
 	RomDataView *const romDataView = new RomDataView(romData, props);
 	romDataView->setObjectName(QLatin1String("romDataView"));
 
-	// Make sure the underlying file handle is closed,
-	// since we don't need it once the RomData has been
-	// loaded by RomDataView.
-	romData->close();
-
 	// RomDataView takes a reference to the RomData object.
 	// We don't need to hold on to it.
 	romData->unref();
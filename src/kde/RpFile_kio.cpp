@@ -144,7 +144,9 @@ void RpFileKio::init(void)
 	RP_D(RpFileKio);
 
 	// Open the file.
+	// NOTE: RpFileKio is only used for non-local files.
 	m_lastError = 0;
+	m_isRemote = true;
 	d->fileJob = KIO::open(d->uri, QIODevice::ReadOnly);
 	d->fileJob->setUiDelegate(nullptr);
 	/** Signals **/
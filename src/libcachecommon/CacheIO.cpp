@@ -0,0 +1,213 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * CacheIO.cpp: Internal file I/O functions for the cache index files.     *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "config.libcachecommon.h"
+#include "CacheIO.hpp"
+#include "CacheKeys.hpp"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+
+// C++ includes.
+#include <string>
+using std::string;
+#ifdef _WIN32
+using std::wstring;
+#endif /* _WIN32 */
+
+// OS-specific includes.
+#ifdef _WIN32
+#  include "libwin32common/RpWin32_sdk.h"
+#  include <io.h>
+#else /* !_WIN32 */
+#  include <unistd.h>
+#endif /* _WIN32 */
+
+namespace LibCacheCommon {
+
+/**
+ * Filter and hash a cache key.
+ *
+ * The hash is a 64-bit FNV-1a hash of the filtered cache key.
+ * This is used by both the negative cache index and the cache index.
+ *
+ * @param pCacheKey	[in] Cache key. (Must be UTF-8, NULL-terminated.)
+ * @param key		[out] Filtered cache key.
+ * @param pHash		[out] Hash.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int filterAndHashCacheKey(const char *pCacheKey, string &key, uint64_t *pHash)
+{
+	assert(pCacheKey != nullptr);
+	assert(pCacheKey[0] != '\0');
+	if (!pCacheKey || pCacheKey[0] == '\0') {
+		return -EINVAL;
+	}
+
+	// Filter the cache key first so "ds/cover/US/ABCE.png" and
+	// "ds\\cover\\US\\ABCE.png" result in the same hash on Windows.
+	key = pCacheKey;
+	int ret = filterCacheKey(key);
+	if (ret != 0) {
+		return ret;
+	}
+
+	// 64-bit FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (const uint8_t chr : key) {
+		hash ^= chr;
+		hash *= 0x100000001B3ULL;
+	}
+	*pHash = hash;
+	return 0;
+}
+
+#ifdef _WIN32
+/**
+ * Internal U82W() function.
+ * @param mbs UTF-8 string.
+ * @return UTF-16 C++ string.
+ */
+wstring U82W(const string &mbs)
+{
+	wstring s_wcs;
+
+	const int cchWcs = MultiByteToWideChar(CP_UTF8, 0, mbs.c_str(), static_cast<int>(mbs.size()), nullptr, 0);
+	if (cchWcs <= 0) {
+		return s_wcs;
+	}
+
+	s_wcs.resize(cchWcs);
+	MultiByteToWideChar(CP_UTF8, 0, mbs.c_str(), static_cast<int>(mbs.size()), &s_wcs[0], cchWcs);
+	return s_wcs;
+}
+
+/**
+ * Internal W2U8() function.
+ * @param wcs UTF-16 string.
+ * @return UTF-8 C++ string.
+ */
+string W2U8(const wchar_t *wcs)
+{
+	string s_mbs;
+
+	const int cbMbs = WideCharToMultiByte(CP_UTF8, 0, wcs, -1, nullptr, 0, nullptr, nullptr);
+	if (cbMbs <= 1) {
+		return s_mbs;
+	}
+
+	s_mbs.resize(cbMbs - 1);
+	WideCharToMultiByte(CP_UTF8, 0, wcs, -1, &s_mbs[0], cbMbs, nullptr, nullptr);
+	return s_mbs;
+}
+#endif /* _WIN32 */
+
+/**
+ * Open a file for reading.
+ * @param filename Filename. (UTF-8)
+ * @return FILE*, or nullptr on error.
+ */
+FILE *fopen_read(const string &filename)
+{
+#ifdef _WIN32
+	return _wfopen(U82W(filename).c_str(), L"rb");
+#else /* !_WIN32 */
+	return fopen(filename.c_str(), "rbe");
+#endif /* _WIN32 */
+}
+
+/**
+ * Write a file atomically.
+ *
+ * The data is written to a temporary file and flushed to disk,
+ * then the temporary file is renamed over the existing file.
+ * This ensures readers either see the old file or the new file,
+ * never a partial file.
+ *
+ * @param filename	[in] Filename. (UTF-8)
+ * @param chunks	[in] Data chunks to write, in order.
+ * @param count		[in] Number of data chunks.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int writeFileAtomic(const string &filename, const FileChunk *chunks, size_t count)
+{
+	int ret;
+#ifdef _WIN32
+	const wstring wfilename = U82W(filename);
+	wchar_t tmpSuffix[24];
+	_snwprintf(tmpSuffix, _countof(tmpSuffix), L".%08lX.tmp", GetCurrentProcessId());
+	tmpSuffix[_countof(tmpSuffix)-1] = L'\0';
+	const wstring tmpFilename = wfilename + tmpSuffix;
+	FILE *f = _wfopen(tmpFilename.c_str(), L"wb");
+	if (!f) {
+		return -errno;
+	}
+#else /* !_WIN32 */
+	string tmpFilename = filename;
+	tmpFilename += ".XXXXXX";
+	int fd = mkstemp(&tmpFilename[0]);
+	if (fd < 0) {
+		return -errno;
+	}
+	FILE *f = fdopen(fd, "wb");
+	if (!f) {
+		ret = -errno;
+		close(fd);
+		unlink(tmpFilename.c_str());
+		return ret;
+	}
+#endif /* _WIN32 */
+
+	bool ok = true;
+	for (size_t i = 0; ok && i < count; i++) {
+		if (chunks[i].size > 0) {
+			ok = (fwrite(chunks[i].data, 1, chunks[i].size, f) == chunks[i].size);
+		}
+	}
+
+	// Make sure the data is on disk before renaming the file.
+	// Otherwise, a crash could leave an empty file in place
+	// of the existing file.
+	if (ok) {
+		ok = (fflush(f) == 0);
+	}
+	if (ok) {
+#ifdef _WIN32
+		ok = (_commit(_fileno(f)) == 0);
+#else /* !_WIN32 */
+		ok = (fsync(fileno(f)) == 0);
+#endif /* _WIN32 */
+	}
+	if (fclose(f) != 0) {
+		ok = false;
+	}
+
+#ifdef _WIN32
+	if (ok) {
+		ok = !!MoveFileExW(tmpFilename.c_str(), wfilename.c_str(), MOVEFILE_REPLACE_EXISTING);
+	}
+	if (!ok) {
+		DeleteFileW(tmpFilename.c_str());
+		return -EIO;
+	}
+#else /* !_WIN32 */
+	if (ok) {
+		ok = (rename(tmpFilename.c_str(), filename.c_str()) == 0);
+	}
+	if (!ok) {
+		ret = (errno != 0 ? -errno : -EIO);
+		unlink(tmpFilename.c_str());
+		return ret;
+	}
+#endif /* _WIN32 */
+
+	return 0;
+}
+
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * CacheIO.hpp: Internal file I/O functions for the cache index files.     *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+// NOTE: This header is only used internally by libcachecommon.
+
+// C includes.
+#include <stddef.h>
+#include <stdint.h>
+
+// C includes. (C++ namespace)
+#include <cstdio>
+
+// C++ includes.
+#include <string>
+
+namespace LibCacheCommon {
+
+/**
+ * Filter and hash a cache key.
+ *
+ * The hash is a 64-bit FNV-1a hash of the filtered cache key.
+ * This is used by both the negative cache index and the cache index.
+ *
+ * @param pCacheKey	[in] Cache key. (Must be UTF-8, NULL-terminated.)
+ * @param key		[out] Filtered cache key.
+ * @param pHash		[out] Hash.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int filterAndHashCacheKey(const char *pCacheKey, std::string &key, uint64_t *pHash);
+
+#ifdef _WIN32
+/**
+ * Internal U82W() function.
+ * @param mbs UTF-8 string.
+ * @return UTF-16 C++ string.
+ */
+std::wstring U82W(const std::string &mbs);
+
+/**
+ * Internal W2U8() function.
+ * @param wcs UTF-16 string.
+ * @return UTF-8 C++ string.
+ */
+std::string W2U8(const wchar_t *wcs);
+#endif /* _WIN32 */
+
+/**
+ * Open a file for reading.
+ * @param filename Filename. (UTF-8)
+ * @return FILE*, or nullptr on error.
+ */
+FILE *fopen_read(const std::string &filename);
+
+/**
+ * Data chunk for writeFileAtomic().
+ */
+struct FileChunk {
+	const void *data;
+	size_t size;
+};
+
+/**
+ * Write a file atomically.
+ *
+ * The data is written to a temporary file and flushed to disk,
+ * then the temporary file is renamed over the existing file.
+ * This ensures readers either see the old file or the new file,
+ * never a partial file.
+ *
+ * @param filename	[in] Filename. (UTF-8)
+ * @param chunks	[in] Data chunks to write, in order.
+ * @param count		[in] Number of data chunks.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int writeFileAtomic(const std::string &filename, const FileChunk *chunks, size_t count);
+
+}
@@ -0,0 +1,757 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * CacheIndex.cpp: Cache index with size-quota LRU eviction.               *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "config.libcachecommon.h"
+#include "common.h"
+#include "CacheIndex.hpp"
+#include "CacheDir.hpp"
+#include "CacheIO.hpp"
+#include "CacheLock.hpp"
+#include "NegativeCache.hpp"
+
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+// C++ includes.
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using std::string;
+using std::unordered_map;
+using std::vector;
+#ifdef _WIN32
+using std::wstring;
+#endif /* _WIN32 */
+
+// OS-specific includes.
+#ifdef _WIN32
+#  include "libwin32common/RpWin32_sdk.h"
+#  include "libwin32common/w32time.h"
+#  define DIR_SEP_CHR '\\'
+#else /* !_WIN32 */
+#  include <dirent.h>
+#  include <fcntl.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define DIR_SEP_CHR '/'
+#endif /* _WIN32 */
+
+namespace LibCacheCommon {
+
+/**
+ * Cache index file format:
+ * - Header
+ * - Entries, sorted by hash.
+ * - String table containing the filtered cache keys.
+ *   (Not NULL-terminated.)
+ *
+ * Access journal file format:
+ * - Access records, in the order they were written.
+ *
+ * All values are in host-endian format, since the cache
+ * directory is not shared between different systems.
+ */
+#define CACHEIDX_FILENAME "cache-index.idx"
+#define CACHEIDX_JOURNAL_FILENAME "cache-access.log"
+#define CACHEIDX_LOCK_FILENAME "cache-index.lock"
+#define CACHEIDX_MAGIC "RPCACIDX"
+#define CACHEIDX_VERSION 1
+struct CacheIdxHeader {
+	char magic[8];		// [0x000] "RPCACIDX"
+	uint32_t version;	// [0x008] Format version (host-endian)
+	uint32_t count;		// [0x00C] Number of entries
+	int64_t last_scan;	// [0x010] Time the cache directory was last scanned
+	uint32_t strtbl_size;	// [0x018] Size of the string table
+	uint32_t reserved;	// [0x01C]
+};
+static_assert(sizeof(CacheIdxHeader) == 32, "CacheIdxHeader is not 32 bytes.");
+
+struct CacheIdxEntry {
+	uint64_t hash;		// [0x000] FNV-1a hash of the filtered cache key
+	uint64_t size;		// [0x008] File size
+	int64_t atime;		// [0x010] Last access time
+	uint32_t key_offset;	// [0x018] Offset of the cache key in the string table
+	uint32_t key_length;	// [0x01C] Length of the cache key
+};
+static_assert(sizeof(CacheIdxEntry) == 32, "CacheIdxEntry is not 32 bytes.");
+
+struct CacheAccessRecord {
+	uint64_t hash;		// [0x000] FNV-1a hash of the filtered cache key
+	int64_t atime;		// [0x008] Access time
+};
+static_assert(sizeof(CacheAccessRecord) == 16, "CacheAccessRecord is not 16 bytes.");
+
+// Maximum index file size. (Larger files are considered invalid.)
+static const uint64_t CACHEIDX_MAX_SIZE = 64U*1024U*1024U;
+// Maximum access journal size. Once the journal reaches this size,
+// accesses won't be recorded until rp-download merges it.
+static const uint64_t CACHEIDX_JOURNAL_MAX_SIZE = 1024U*1024U;
+// Minimum interval between recording accesses to the same cache key, in seconds.
+static const time_t CACHEIDX_ACCESS_INTERVAL = 60*60;
+// Interval between cache directory rescans, in seconds.
+static const time_t CACHEIDX_RESCAN_INTERVAL = 7*86400;
+// Maximum subdirectory depth when scanning the cache directory.
+static const unsigned int CACHEIDX_SCAN_MAX_DEPTH = 8;
+
+/**
+ * In-memory cache index entry.
+ */
+struct CacheEntry {
+	uint64_t hash;
+	uint64_t size;
+	int64_t atime;
+	string key;	// Filtered cache key
+};
+
+static inline bool operator<(const CacheEntry &entry, uint64_t hash)
+{
+	return entry.hash < hash;
+}
+
+/** Access journal deduplication **/
+static Mutex access_mutex;
+static unordered_map<uint64_t, time_t> access_map;
+
+/**
+ * Get the cache directory with a trailing separator.
+ * @return Cache directory, or empty string on error.
+ */
+static string getCacheDirWithSep(void)
+{
+	string cacheDir = getCacheDirectory();
+	if (!cacheDir.empty() && cacheDir.at(cacheDir.size()-1) != DIR_SEP_CHR) {
+		cacheDir += DIR_SEP_CHR;
+	}
+	return cacheDir;
+}
+
+/**
+ * Delete a file.
+ * @param filename Filename. (UTF-8)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int delete_file(const string &filename)
+{
+#ifdef _WIN32
+	if (!DeleteFileW(U82W(filename).c_str())) {
+		const DWORD dwError = GetLastError();
+		return (dwError == ERROR_FILE_NOT_FOUND || dwError == ERROR_PATH_NOT_FOUND)
+			? -ENOENT : -EIO;
+	}
+#else /* !_WIN32 */
+	if (unlink(filename.c_str()) != 0) {
+		return (errno != 0 ? -errno : -EIO);
+	}
+#endif /* _WIN32 */
+	return 0;
+}
+
+/**
+ * Load the cache index.
+ * @param filename	[in] Index filename.
+ * @param entries	[out] Entries, sorted by hash.
+ * @param pLastScan	[out] Time the cache directory was last scanned.
+ * @return True if the index was loaded; false if it's missing or invalid.
+ */
+static bool loadIndex(const string &filename, vector<CacheEntry> &entries, time_t *pLastScan)
+{
+	entries.clear();
+	*pLastScan = 0;
+
+	FILE *f = fopen_read(filename);
+	if (!f) {
+		return false;
+	}
+
+	bool ok = false;
+	CacheIdxHeader header;
+	if (fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+	    !memcmp(header.magic, CACHEIDX_MAGIC, sizeof(header.magic)) &&
+	    header.version == CACHEIDX_VERSION)
+	{
+		fseek(f, 0, SEEK_END);
+		const uint64_t fileSize = static_cast<uint64_t>(ftell(f));
+		fseek(f, sizeof(header), SEEK_SET);
+		const uint64_t expectedSize = sizeof(header) +
+			(static_cast<uint64_t>(header.count) * sizeof(CacheIdxEntry)) +
+			header.strtbl_size;
+
+		vector<CacheIdxEntry> idxEntries;
+		string strtbl;
+		if (fileSize == expectedSize && fileSize <= CACHEIDX_MAX_SIZE) {
+			idxEntries.resize(header.count);
+			strtbl.resize(header.strtbl_size);
+			ok = (header.count == 0 ||
+			      fread(idxEntries.data(), sizeof(CacheIdxEntry), header.count, f) == header.count);
+			if (ok && header.strtbl_size > 0) {
+				ok = (fread(&strtbl[0], 1, header.strtbl_size, f) == header.strtbl_size);
+			}
+		}
+
+		if (ok) {
+			entries.reserve(idxEntries.size());
+			for (const CacheIdxEntry &idxEntry : idxEntries) {
+				if (idxEntry.key_length == 0 ||
+				    static_cast<uint64_t>(idxEntry.key_offset) + idxEntry.key_length > strtbl.size())
+				{
+					// Invalid string table reference.
+					ok = false;
+					break;
+				}
+				// The cache key is used to delete the file when evicting it,
+				// so make sure it's still a valid cache key. Otherwise, a
+				// modified index could be used to delete files outside of
+				// the cache directory, e.g. by using "../".
+				const string key(&strtbl[idxEntry.key_offset], idxEntry.key_length);
+				CacheEntry entry;
+				if (filterAndHashCacheKey(key.c_str(), entry.key, &entry.hash) != 0 ||
+				    entry.key != key || entry.hash != idxEntry.hash)
+				{
+					// Invalid cache key. Skip this entry.
+					continue;
+				}
+				entry.size = idxEntry.size;
+				entry.atime = idxEntry.atime;
+				entries.emplace_back(std::move(entry));
+			}
+		}
+
+		if (ok) {
+			// Entries should already be sorted, but make sure.
+			std::sort(entries.begin(), entries.end(),
+				[](const CacheEntry &a, const CacheEntry &b) noexcept -> bool {
+					return a.hash < b.hash;
+				});
+			*pLastScan = static_cast<time_t>(header.last_scan);
+		} else {
+			entries.clear();
+		}
+	}
+
+	fclose(f);
+	return ok;
+}
+
+/**
+ * Save the cache index.
+ *
+ * The new index is written to a temporary file, then renamed
+ * over the existing index. This ensures readers either see
+ * the old index or the new index, never a partial index.
+ *
+ * @param filename	[in] Index filename.
+ * @param entries	[in] Entries, sorted by hash.
+ * @param lastScan	[in] Time the cache directory was last scanned.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int saveIndex(const string &filename, const vector<CacheEntry> &entries, time_t lastScan)
+{
+	// Build the entry table and string table.
+	vector<CacheIdxEntry> idxEntries;
+	idxEntries.reserve(entries.size());
+	string strtbl;
+	for (const CacheEntry &entry : entries) {
+		CacheIdxEntry idxEntry;
+		idxEntry.hash = entry.hash;
+		idxEntry.size = entry.size;
+		idxEntry.atime = entry.atime;
+		idxEntry.key_offset = static_cast<uint32_t>(strtbl.size());
+		idxEntry.key_length = static_cast<uint32_t>(entry.key.size());
+		idxEntries.push_back(idxEntry);
+		strtbl += entry.key;
+	}
+
+	CacheIdxHeader header;
+	memcpy(header.magic, CACHEIDX_MAGIC, sizeof(header.magic));
+	header.version = CACHEIDX_VERSION;
+	header.count = static_cast<uint32_t>(idxEntries.size());
+	header.last_scan = static_cast<int64_t>(lastScan);
+	header.strtbl_size = static_cast<uint32_t>(strtbl.size());
+	header.reserved = 0;
+
+	const FileChunk chunks[] = {
+		{&header, sizeof(header)},
+		{idxEntries.data(), idxEntries.size() * sizeof(CacheIdxEntry)},
+		{strtbl.data(), strtbl.size()},
+	};
+	return writeFileAtomic(filename, chunks, ARRAY_SIZE(chunks));
+}
+
+/**
+ * Add a file found while scanning the cache directory.
+ * @param entries	[in/out] Entries. (unsorted)
+ * @param expired	[in/out] Expired zero-byte files to delete.
+ * @param relName	[in] Filename, relative to the cache directory.
+ * @param size		[in] File size.
+ * @param atime		[in] Last access time.
+ */
+static void addScannedFile(vector<CacheEntry> &entries, vector<string> &expired,
+	const string &relName, uint64_t size, int64_t atime)
+{
+	CacheEntry entry;
+	if (filterAndHashCacheKey(relName.c_str(), entry.key, &entry.hash) != 0 ||
+	    entry.key != relName)
+	{
+		// Not a valid cache key.
+		return;
+	}
+
+	if (size == 0) {
+		// Zero-byte files are negative cache entries from older versions.
+		// They aren't counted towards the quota, but they're deleted once
+		// the default negative cache expiry has elapsed. (If a longer expiry
+		// is configured, the file will be redownloaded once, and the new
+		// negative cache entry will be added to the negative cache index.)
+		if (static_cast<int64_t>(time(nullptr)) - atime >= static_cast<int64_t>(NEGATIVE_CACHE_EXPIRY_DEFAULT) * 86400) {
+			expired.push_back(relName);
+		}
+		return;
+	}
+
+	entry.size = size;
+	entry.atime = atime;
+	entries.emplace_back(std::move(entry));
+}
+
+/**
+ * Scan a directory in the cache directory.
+ *
+ * NOTE: Files in the cache directory itself are skipped,
+ * since cache keys always have at least one subdirectory.
+ * (This also skips the index files.)
+ *
+ * @param cacheDir	[in] Cache directory, with a trailing separator.
+ * @param relDir	[in] Directory to scan, relative to the cache directory, with a trailing separator. (Empty for the cache directory.)
+ * @param entries	[in/out] Entries. (unsorted)
+ * @param expired	[in/out] Expired zero-byte files to delete.
+ * @param depth		[in] Current depth.
+ */
+static void scanDirectory(const string &cacheDir, const string &relDir,
+	vector<CacheEntry> &entries, vector<string> &expired, unsigned int depth)
+{
+#ifdef _WIN32
+	wstring wpath = U82W(cacheDir + relDir);
+	wpath += L'*';
+
+	WIN32_FIND_DATAW ffd;
+	HANDLE hFind = FindFirstFileW(wpath.c_str(), &ffd);
+	if (!hFind || hFind == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		const wchar_t *const name = ffd.cFileName;
+		if (name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'))) {
+			// "." or ".."
+			continue;
+		}
+
+		string relName = relDir;
+		relName += W2U8(name);
+		if (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			if (!(ffd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) &&
+			    depth < CACHEIDX_SCAN_MAX_DEPTH)
+			{
+				relName += DIR_SEP_CHR;
+				scanDirectory(cacheDir, relName, entries, expired, depth + 1);
+			}
+		} else if (!relDir.empty()) {
+			const uint64_t size = (static_cast<uint64_t>(ffd.nFileSizeHigh) << 32) | ffd.nFileSizeLow;
+			const int64_t atime = std::max(FileTimeToUnixTime(&ffd.ftLastAccessTime),
+			                               FileTimeToUnixTime(&ffd.ftLastWriteTime));
+			addScannedFile(entries, expired, relName, size, atime);
+		}
+	} while (FindNextFileW(hFind, &ffd));
+	FindClose(hFind);
+#else /* !_WIN32 */
+	const string path = cacheDir + relDir;
+	DIR *const pdir = opendir(path.c_str());
+	if (!pdir) {
+		return;
+	}
+
+	const int dfd = dirfd(pdir);
+	const struct dirent *dirent;
+	while ((dirent = readdir(pdir)) != nullptr) {
+		const char *const name = dirent->d_name;
+		if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+			// "." or ".."
+			continue;
+		}
+
+		struct stat sb;
+		if (fstatat(dfd, name, &sb, AT_SYMLINK_NOFOLLOW) != 0) {
+			continue;
+		}
+
+		string relName = relDir;
+		relName += name;
+		if (S_ISDIR(sb.st_mode)) {
+			if (depth < CACHEIDX_SCAN_MAX_DEPTH) {
+				relName += DIR_SEP_CHR;
+				scanDirectory(cacheDir, relName, entries, expired, depth + 1);
+			}
+		} else if (S_ISREG(sb.st_mode) && !relDir.empty()) {
+			const int64_t atime = std::max(static_cast<int64_t>(sb.st_atime),
+			                               static_cast<int64_t>(sb.st_mtime));
+			addScannedFile(entries, expired, relName, static_cast<uint64_t>(sb.st_size), atime);
+		}
+	}
+	closedir(pdir);
+#endif /* _WIN32 */
+}
+
+/**
+ * Rescan the cache directory and merge the results into the index.
+ * Entries for files that no longer exist are removed.
+ * Expired zero-byte files from older versions are deleted.
+ * @param cacheDir	[in] Cache directory, with a trailing separator.
+ * @param entries	[in/out] Entries, sorted by hash.
+ */
+static void rescanCacheDir(const string &cacheDir, vector<CacheEntry> &entries)
+{
+	vector<CacheEntry> scanned;
+	vector<string> expired;
+	scanned.reserve(entries.size());
+	scanDirectory(cacheDir, string(), scanned, expired, 0);
+	for (const string &relName : expired) {
+		delete_file(cacheDir + relName);
+	}
+	std::sort(scanned.begin(), scanned.end(),
+		[](const CacheEntry &a, const CacheEntry &b) noexcept -> bool {
+			return a.hash < b.hash;
+		});
+
+	// Keep the access times from the existing index if they're newer.
+	for (CacheEntry &entry : scanned) {
+		auto iter = std::lower_bound(entries.cbegin(), entries.cend(), entry.hash);
+		if (iter != entries.cend() && iter->hash == entry.hash && iter->atime > entry.atime) {
+			entry.atime = iter->atime;
+		}
+	}
+
+	entries = std::move(scanned);
+}
+
+/**
+ * Merge the access journal into the index, then delete the journal.
+ * @param filename	[in] Access journal filename.
+ * @param entries	[in/out] Entries, sorted by hash.
+ * @return True if any entries were changed; false if not.
+ */
+static bool mergeJournal(const string &filename, vector<CacheEntry> &entries)
+{
+	FILE *f = fopen_read(filename);
+	if (!f) {
+		return false;
+	}
+
+	bool changed = false;
+	CacheAccessRecord records[256];
+	size_t count;
+	while ((count = fread(records, sizeof(CacheAccessRecord), sizeof(records)/sizeof(records[0]), f)) > 0) {
+		for (size_t i = 0; i < count; i++) {
+			const CacheAccessRecord &record = records[i];
+			auto iter = std::lower_bound(entries.begin(), entries.end(), record.hash);
+			if (iter != entries.end() && iter->hash == record.hash && iter->atime < record.atime) {
+				iter->atime = record.atime;
+				changed = true;
+			}
+		}
+	}
+	fclose(f);
+
+	// NOTE: Accesses recorded between reading the journal and deleting
+	// it will be lost. That's fine, since the journal is only advisory.
+	delete_file(filename);
+	return changed;
+}
+
+/**
+ * Record an access to a cached file in the access journal.
+ *
+ * Each cache key is only recorded once per hour per process,
+ * so repeated lookups don't write to the journal every time.
+ * Errors are ignored, since the journal is only advisory.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ */
+void cacheIndexRecordAccess(const char *pCacheKey)
+{
+	string key;
+	uint64_t hash;
+	if (filterAndHashCacheKey(pCacheKey, key, &hash) != 0) {
+		return;
+	}
+
+	const time_t now = time(nullptr);
+	{
+		MutexLocker locker(access_mutex);
+		time_t &last = access_map[hash];
+		if (last != 0 && now >= last && (now - last) < CACHEIDX_ACCESS_INTERVAL) {
+			// Recorded recently.
+			return;
+		}
+		last = now;
+	}
+
+	string filename = getCacheDirWithSep();
+	if (filename.empty()) {
+		return;
+	}
+	filename += CACHEIDX_JOURNAL_FILENAME;
+
+	CacheAccessRecord record;
+	record.hash = hash;
+	record.atime = static_cast<int64_t>(now);
+
+	// NOTE: Appending the record in a single write, so records
+	// from multiple processes won't be interleaved.
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(U82W(filename).c_str(), FILE_APPEND_DATA,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (!hFile || hFile == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	LARGE_INTEGER liFileSize;
+	if (GetFileSizeEx(hFile, &liFileSize) &&
+	    static_cast<uint64_t>(liFileSize.QuadPart) < CACHEIDX_JOURNAL_MAX_SIZE)
+	{
+		DWORD dwWritten;
+		WriteFile(hFile, &record, sizeof(record), &dwWritten, nullptr);
+	}
+	CloseHandle(hFile);
+#else /* !_WIN32 */
+	int fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return;
+	}
+	struct stat sb;
+	if (fstat(fd, &sb) == 0 && static_cast<uint64_t>(sb.st_size) < CACHEIDX_JOURNAL_MAX_SIZE) {
+		ssize_t size = write(fd, &record, sizeof(record));
+		((void)size);
+	}
+	close(fd);
+#endif /* _WIN32 */
+}
+
+#ifdef _WIN32
+/**
+ * Record an access to a cached file in the access journal.
+ *
+ * Each cache key is only recorded once per hour per process,
+ * so repeated lookups don't write to the journal every time.
+ * Errors are ignored, since the journal is only advisory.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ */
+void cacheIndexRecordAccess(const wchar_t *pCacheKey)
+{
+	cacheIndexRecordAccess(W2U8(pCacheKey).c_str());
+}
+#endif /* _WIN32 */
+
+/**
+ * Add, update, or remove a cache key in the cache index,
+ * then evict least-recently-used files if the cache is
+ * larger than the specified quota.
+ *
+ * The access journal is merged into the index at the same time.
+ * When evicting, files are removed until the cache is at 90%
+ * of the quota, so every download doesn't trigger an eviction.
+ * The specified cache key is never evicted.
+ *
+ * The update is done while holding an exclusive lock on
+ * cache-index.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey	[in] Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().) (May be nullptr to only evict.)
+ * @param size		[in] File size, or -1 to remove the cache key.
+ * @param quota		[in] Cache quota, in bytes. (0 for unlimited)
+ * @param pFreed	[out,opt] Number of bytes freed by eviction.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cacheIndexUpdate(const char *pCacheKey, int64_t size, uint64_t quota, uint64_t *pFreed)
+{
+	if (pFreed) {
+		*pFreed = 0;
+	}
+
+	string key;
+	uint64_t hash = 0;
+	if (pCacheKey) {
+		int ret = filterAndHashCacheKey(pCacheKey, key, &hash);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	const string cacheDir = getCacheDirWithSep();
+	if (cacheDir.empty()) {
+		return -ENOENT;
+	}
+	const string indexFilename = cacheDir + CACHEIDX_FILENAME;
+
+	// Hold the lock until the new index is saved.
+	CacheLock lock(CACHEIDX_LOCK_FILENAME);
+	if (!lock.isLocked()) {
+		return lock.lastError();
+	}
+	const time_t now = time(nullptr);
+
+	// Load the current index.
+	vector<CacheEntry> entries;
+	time_t lastScan;
+	bool changed = false;
+	if (!loadIndex(indexFilename, entries, &lastScan) ||
+	    now < lastScan || (now - lastScan) >= CACHEIDX_RESCAN_INTERVAL)
+	{
+		// Index is missing or hasn't been checked in a while.
+		// Rescan the cache directory.
+		rescanCacheDir(cacheDir, entries);
+		lastScan = now;
+		changed = true;
+	}
+
+	// Merge the access journal.
+	if (mergeJournal(cacheDir + CACHEIDX_JOURNAL_FILENAME, entries)) {
+		changed = true;
+	}
+
+	// Add, update, or remove the entry.
+	if (pCacheKey) {
+		auto iter = std::lower_bound(entries.begin(), entries.end(), hash);
+		const bool found = (iter != entries.end() && iter->hash == hash);
+		if (size >= 0) {
+			if (found) {
+				iter->size = static_cast<uint64_t>(size);
+				iter->atime = static_cast<int64_t>(now);
+			} else {
+				CacheEntry entry;
+				entry.hash = hash;
+				entry.size = static_cast<uint64_t>(size);
+				entry.atime = static_cast<int64_t>(now);
+				entry.key = std::move(key);
+				entries.insert(iter, std::move(entry));
+			}
+			changed = true;
+		} else if (found) {
+			entries.erase(iter);
+			changed = true;
+		}
+	}
+
+	// Evict least-recently-used files if the cache is over quota.
+	if (quota > 0) {
+		uint64_t total = 0;
+		for (const CacheEntry &entry : entries) {
+			total += entry.size;
+		}
+
+		if (total > quota) {
+			const uint64_t target = quota - (quota / 10);
+
+			// Sort the entries by access time.
+			vector<size_t> lru(entries.size());
+			for (size_t i = 0; i < lru.size(); i++) {
+				lru[i] = i;
+			}
+			std::sort(lru.begin(), lru.end(),
+				[&entries](size_t a, size_t b) noexcept -> bool {
+					return entries[a].atime < entries[b].atime;
+				});
+
+			vector<bool> evicted(entries.size());
+			uint64_t freed = 0;
+			for (const size_t idx : lru) {
+				if (total <= target)
+					break;
+				const CacheEntry &entry = entries[idx];
+				if (pCacheKey && size >= 0 && entry.hash == hash) {
+					// Don't evict the file that was just added.
+					continue;
+				}
+
+				const int ret = delete_file(cacheDir + entry.key);
+				if (ret != 0 && ret != -ENOENT) {
+					// Unable to delete the file. Keep it in the index.
+					continue;
+				}
+				if (ret == 0) {
+					freed += entry.size;
+				}
+				total -= entry.size;
+				evicted[idx] = true;
+			}
+
+			// Remove the evicted entries.
+			size_t dest = 0;
+			for (size_t i = 0; i < entries.size(); i++) {
+				if (evicted[i])
+					continue;
+				if (dest != i) {
+					entries[dest] = std::move(entries[i]);
+				}
+				dest++;
+			}
+			entries.resize(dest);
+			if (pFreed) {
+				*pFreed = freed;
+			}
+			changed = true;
+		}
+	}
+
+	if (!changed) {
+		// Nothing to do.
+		return 0;
+	}
+	return saveIndex(indexFilename, entries, lastScan);
+}
+
+#ifdef _WIN32
+/**
+ * Add, update, or remove a cache key in the cache index,
+ * then evict least-recently-used files if the cache is
+ * larger than the specified quota.
+ *
+ * The access journal is merged into the index at the same time.
+ * When evicting, files are removed until the cache is at 90%
+ * of the quota, so every download doesn't trigger an eviction.
+ * The specified cache key is never evicted.
+ *
+ * The update is done while holding an exclusive lock on
+ * cache-index.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey	[in] Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().) (May be nullptr to only evict.)
+ * @param size		[in] File size, or -1 to remove the cache key.
+ * @param quota		[in] Cache quota, in bytes. (0 for unlimited)
+ * @param pFreed	[out,opt] Number of bytes freed by eviction.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cacheIndexUpdate(const wchar_t *pCacheKey, int64_t size, uint64_t quota, uint64_t *pFreed)
+{
+	if (!pCacheKey) {
+		return cacheIndexUpdate(static_cast<const char*>(nullptr), size, quota, pFreed);
+	}
+	return cacheIndexUpdate(W2U8(pCacheKey).c_str(), size, quota, pFreed);
+}
+#endif /* _WIN32 */
+
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * CacheIndex.hpp: Cache index with size-quota LRU eviction.               *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+// C includes. (C++ namespace)
+#include <stdint.h>
+
+namespace LibCacheCommon {
+
+/**
+ * The cache index tracks the size and last access time of each
+ * file in the cache directory, so the least-recently-used files
+ * can be removed once the cache exceeds a size quota.
+ *
+ * The index (cache-index.idx) is only updated by rp-download,
+ * using the same write-to-temporary-file-and-rename method as
+ * the negative cache index. Updates hold an advisory lock on
+ * cache-index.lock, since multiple rp-download processes may
+ * be running at the same time.
+ *
+ * Cache hits in the shell extension are appended to a small
+ * access journal (cache-access.log) instead of rewriting the
+ * index, since the shell extension may be running in a sandbox
+ * that doesn't allow renaming files. rp-download merges the
+ * journal into the index the next time it updates the index.
+ *
+ * If the index is missing, or it hasn't been checked against the
+ * cache directory in a while, the cache directory is rescanned,
+ * so files downloaded by older versions are also accounted for.
+ */
+
+/**
+ * Default cache quota, in MiB. (0 for unlimited)
+ */
+static const unsigned int CACHE_QUOTA_DEFAULT = 1024;
+
+/**
+ * Record an access to a cached file in the access journal.
+ *
+ * Each cache key is only recorded once per hour per process,
+ * so repeated lookups don't write to the journal every time.
+ * Errors are ignored, since the journal is only advisory.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ */
+void cacheIndexRecordAccess(const char *pCacheKey);
+
+#ifdef _WIN32
+/**
+ * Record an access to a cached file in the access journal.
+ *
+ * Each cache key is only recorded once per hour per process,
+ * so repeated lookups don't write to the journal every time.
+ * Errors are ignored, since the journal is only advisory.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ */
+void cacheIndexRecordAccess(const wchar_t *pCacheKey);
+#endif /* _WIN32 */
+
+/**
+ * Add, update, or remove a cache key in the cache index,
+ * then evict least-recently-used files if the cache is
+ * larger than the specified quota.
+ *
+ * The access journal is merged into the index at the same time.
+ * When evicting, files are removed until the cache is at 90%
+ * of the quota, so every download doesn't trigger an eviction.
+ * The specified cache key is never evicted.
+ *
+ * The update is done while holding an exclusive lock on
+ * cache-index.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey	[in] Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().) (May be nullptr to only evict.)
+ * @param size		[in] File size, or -1 to remove the cache key.
+ * @param quota		[in] Cache quota, in bytes. (0 for unlimited)
+ * @param pFreed	[out,opt] Number of bytes freed by eviction.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cacheIndexUpdate(const char *pCacheKey, int64_t size, uint64_t quota, uint64_t *pFreed = nullptr);
+
+#ifdef _WIN32
+/**
+ * Add, update, or remove a cache key in the cache index,
+ * then evict least-recently-used files if the cache is
+ * larger than the specified quota.
+ *
+ * The access journal is merged into the index at the same time.
+ * When evicting, files are removed until the cache is at 90%
+ * of the quota, so every download doesn't trigger an eviction.
+ * The specified cache key is never evicted.
+ *
+ * The update is done while holding an exclusive lock on
+ * cache-index.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey	[in] Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().) (May be nullptr to only evict.)
+ * @param size		[in] File size, or -1 to remove the cache key.
+ * @param quota		[in] Cache quota, in bytes. (0 for unlimited)
+ * @param pFreed	[out,opt] Number of bytes freed by eviction.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int cacheIndexUpdate(const wchar_t *pCacheKey, int64_t size, uint64_t quota, uint64_t *pFreed = nullptr);
+#endif /* _WIN32 */
+
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * CacheLock.cpp: Advisory lock for cache index updates.                   *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "config.libcachecommon.h"
+#include "CacheLock.hpp"
+#include "CacheDir.hpp"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+
+// C++ includes.
+#include <string>
+using std::string;
+#ifdef _WIN32
+using std::wstring;
+#endif /* _WIN32 */
+
+// OS-specific includes.
+#ifdef _WIN32
+#  define DIR_SEP_CHR '\\'
+#else /* !_WIN32 */
+#  include <fcntl.h>
+#  include <sys/file.h>
+#  include <unistd.h>
+#  define DIR_SEP_CHR '/'
+#endif /* _WIN32 */
+
+namespace LibCacheCommon {
+
+/**
+ * Take an exclusive lock on a lock file in the cache directory.
+ * This will block until the lock is available.
+ * @param lockName Lock filename, relative to the cache directory.
+ */
+CacheLock::CacheLock(const char *lockName)
+#ifdef _WIN32
+	: m_hFile(INVALID_HANDLE_VALUE)
+#else /* !_WIN32 */
+	: m_fd(-1)
+#endif /* _WIN32 */
+	, m_lastError(-ENOENT)
+{
+	string filename = getCacheDirectory();
+	if (filename.empty()) {
+		return;
+	}
+	if (filename.at(filename.size()-1) != DIR_SEP_CHR) {
+		filename += DIR_SEP_CHR;
+	}
+	filename += lockName;
+
+#ifdef _WIN32
+	wstring wfilename;
+	const int cchWcs = MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), static_cast<int>(filename.size()), nullptr, 0);
+	if (cchWcs <= 0) {
+		m_lastError = -EINVAL;
+		return;
+	}
+	wfilename.resize(cchWcs);
+	MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), static_cast<int>(filename.size()), &wfilename[0], cchWcs);
+
+	m_hFile = CreateFileW(wfilename.c_str(), GENERIC_READ | GENERIC_WRITE,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (!m_hFile || m_hFile == INVALID_HANDLE_VALUE) {
+		m_hFile = INVALID_HANDLE_VALUE;
+		m_lastError = -EACCES;
+		return;
+	}
+
+	OVERLAPPED ov = {};
+	if (!LockFileEx(m_hFile, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov)) {
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+		m_lastError = -EIO;
+		return;
+	}
+#else /* !_WIN32 */
+	m_fd = open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (m_fd < 0) {
+		m_lastError = (errno != 0 ? -errno : -EIO);
+		return;
+	}
+
+	int ret;
+	do {
+		ret = flock(m_fd, LOCK_EX);
+	} while (ret != 0 && errno == EINTR);
+	if (ret != 0) {
+		m_lastError = (errno != 0 ? -errno : -EIO);
+		close(m_fd);
+		m_fd = -1;
+		return;
+	}
+#endif /* _WIN32 */
+
+	m_lastError = 0;
+}
+
+CacheLock::~CacheLock()
+{
+	// NOTE: The lock file is not deleted, since another
+	// process may have already opened it and be waiting
+	// for the lock.
+#ifdef _WIN32
+	if (m_hFile != INVALID_HANDLE_VALUE) {
+		OVERLAPPED ov = {};
+		UnlockFileEx(m_hFile, 0, 1, 0, &ov);
+		CloseHandle(m_hFile);
+	}
+#else /* !_WIN32 */
+	if (m_fd >= 0) {
+		// Closing the file releases the lock.
+		close(m_fd);
+	}
+#endif /* _WIN32 */
+}
+
+}
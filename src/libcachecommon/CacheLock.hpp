@@ -0,0 +1,73 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * CacheLock.hpp: Advisory lock for cache index updates.                   *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#ifdef _WIN32
+#  include "libwin32common/RpWin32_sdk.h"
+#endif /* _WIN32 */
+
+namespace LibCacheCommon {
+
+/**
+ * Exclusive advisory lock on a lock file in the cache directory.
+ *
+ * The cache index files are updated using read-modify-rename.
+ * Multiple rp-download processes may be running at the same time,
+ * so each update must hold the lock for the index it's updating,
+ * or one process's changes may overwrite another's.
+ *
+ * Readers don't need to take the lock, since the index files
+ * are always replaced atomically.
+ *
+ * The lock is released when the CacheLock object is destroyed.
+ */
+class CacheLock
+{
+	public:
+		/**
+		 * Take an exclusive lock on a lock file in the cache directory.
+		 * This will block until the lock is available.
+		 * @param lockName Lock filename, relative to the cache directory.
+		 */
+		explicit CacheLock(const char *lockName);
+		~CacheLock();
+
+	private:
+		CacheLock(const CacheLock &) = delete;
+		CacheLock &operator=(const CacheLock &) = delete;
+
+	public:
+		/**
+		 * Was the lock acquired?
+		 * @return True if the lock is held; false if not.
+		 */
+		inline bool isLocked(void) const
+		{
+			return (m_lastError == 0);
+		}
+
+		/**
+		 * Get the last error.
+		 * @return 0 if the lock is held; negative POSIX error code on error.
+		 */
+		inline int lastError(void) const
+		{
+			return m_lastError;
+		}
+
+	private:
+#ifdef _WIN32
+		HANDLE m_hFile;
+#else /* !_WIN32 */
+		int m_fd;
+#endif /* _WIN32 */
+		int m_lastError;
+};
+
+}
@@ -0,0 +1,656 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * NegativeCache.cpp: Negative cache index.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "config.libcachecommon.h"
+#include "common.h"
+#include "NegativeCache.hpp"
+#include "CacheDir.hpp"
+#include "CacheIO.hpp"
+#include "CacheLock.hpp"
+
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+// C++ includes.
+#include <algorithm>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+#ifdef _WIN32
+using std::wstring;
+#endif /* _WIN32 */
+
+// OS-specific includes.
+#ifdef _WIN32
+#  include "libwin32common/RpWin32_sdk.h"
+#  include <io.h>
+#  define DIR_SEP_CHR '\\'
+#else /* !_WIN32 */
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define DIR_SEP_CHR '/'
+#endif /* _WIN32 */
+
+namespace LibCacheCommon {
+
+/**
+ * Negative cache index file format:
+ * - Header
+ * - Entries, sorted by hash.
+ *
+ * Negative cache journal file format:
+ * - Entries, in the order they were written.
+ *   A timestamp of -1 indicates the cache key was removed.
+ *
+ * All values are in host-endian format, since the cache
+ * directory is not shared between different systems.
+ */
+#define NEGCACHE_FILENAME "negative-cache.idx"
+#define NEGCACHE_JOURNAL_FILENAME "negative-cache.log"
+#define NEGCACHE_LOCK_FILENAME "negative-cache.lock"
+#define NEGCACHE_MAGIC "RPNEGIDX"
+#define NEGCACHE_VERSION 1
+struct NegCacheHeader {
+	char magic[8];		// [0x000] "RPNEGIDX"
+	uint32_t version;	// [0x008] Format version (host-endian)
+	uint32_t count;		// [0x00C] Number of entries
+};
+static_assert(sizeof(NegCacheHeader) == 16, "NegCacheHeader is not 16 bytes.");
+
+struct NegCacheEntry {
+	uint64_t hash;		// [0x000] FNV-1a hash of the filtered cache key
+	int64_t timestamp;	// [0x008] Time the download was attempted
+};
+static_assert(sizeof(NegCacheEntry) == 16, "NegCacheEntry is not 16 bytes.");
+
+static inline bool operator<(const NegCacheEntry &entry, uint64_t hash)
+{
+	return entry.hash < hash;
+}
+
+// Minimum interval between checks for a new index file, in seconds.
+static const time_t NEGCACHE_RECHECK_INTERVAL = 1;
+// Once the journal reaches this size, it's merged into the index.
+static const size_t NEGCACHE_JOURNAL_MAX_SIZE = 256 * sizeof(NegCacheEntry);
+
+/** Loaded negative cache index **/
+static Mutex negcache_mutex;
+static const NegCacheEntry *negcache_entries = nullptr;
+static uint32_t negcache_count = 0;
+static time_t negcache_last_check = 0;
+#ifdef _WIN32
+// NOTE: Not using a file mapping on Windows, since that would
+// prevent rp-download from replacing the index file.
+static vector<NegCacheEntry> negcache_buf;
+static FILETIME negcache_mtime;
+#else /* !_WIN32 */
+static void *negcache_map = nullptr;
+static size_t negcache_map_size = 0;
+static dev_t negcache_dev;
+static ino_t negcache_ino;
+static time_t negcache_mtime;
+#endif /* _WIN32 */
+
+/** Loaded negative cache journal **/
+static vector<NegCacheEntry> negcache_journal;
+#ifdef _WIN32
+static FILETIME negcache_journal_mtime;
+#else /* !_WIN32 */
+static ino_t negcache_journal_ino;
+static time_t negcache_journal_mtime;
+#endif /* _WIN32 */
+static uint64_t negcache_journal_size;
+
+/**
+ * Get the full path of a negative cache file.
+ * @param name Filename, e.g. NEGCACHE_FILENAME.
+ * @return Full path, or empty string on error.
+ */
+static string getNegCacheFilename(const char *name)
+{
+	string filename = getCacheDirectory();
+	if (filename.empty()) {
+		return filename;
+	}
+	if (filename.at(filename.size()-1) != DIR_SEP_CHR) {
+		filename += DIR_SEP_CHR;
+	}
+	filename += name;
+	return filename;
+}
+
+/**
+ * Hash a cache key.
+ * @param pCacheKey Cache key. (Must be UTF-8, NULL-terminated.)
+ * @param pHash [out] Hash.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int hashCacheKey(const char *pCacheKey, uint64_t *pHash)
+{
+	string filteredCacheKey;
+	return filterAndHashCacheKey(pCacheKey, filteredCacheKey, pHash);
+}
+
+/**
+ * Unload the negative cache index.
+ * Caller must hold negcache_mutex.
+ */
+static void unloadIndex(void)
+{
+#ifdef _WIN32
+	negcache_buf.clear();
+	memset(&negcache_mtime, 0, sizeof(negcache_mtime));
+#else /* !_WIN32 */
+	if (negcache_map) {
+		munmap(negcache_map, negcache_map_size);
+		negcache_map = nullptr;
+		negcache_map_size = 0;
+	}
+#endif /* _WIN32 */
+	negcache_entries = nullptr;
+	negcache_count = 0;
+}
+
+/**
+ * Validate a negative cache index header.
+ * @param pHeader Header.
+ * @param fileSize Size of the index file.
+ * @return True if valid; false if not.
+ */
+static bool isHeaderValid(const NegCacheHeader *pHeader, uint64_t fileSize)
+{
+	return (!memcmp(pHeader->magic, NEGCACHE_MAGIC, sizeof(pHeader->magic)) &&
+		pHeader->version == NEGCACHE_VERSION &&
+		fileSize == sizeof(NegCacheHeader) + (static_cast<uint64_t>(pHeader->count) * sizeof(NegCacheEntry)));
+}
+
+/**
+ * Read negative cache entries from a file.
+ * Any partial entry at the end of the file is ignored.
+ * @param f		[in] File, positioned at the first entry.
+ * @param entries	[out] Entries.
+ * @param maxCount	[in] Maximum number of entries to read.
+ */
+static void readEntries(FILE *f, vector<NegCacheEntry> &entries, size_t maxCount)
+{
+	entries.resize(maxCount);
+	const size_t count = fread(entries.data(), sizeof(NegCacheEntry), maxCount, f);
+	entries.resize(count);
+}
+
+/**
+ * (Re)load the negative cache journal if it has changed on disk.
+ * Caller must hold negcache_mutex.
+ */
+static void reloadJournal(void)
+{
+	const string filename = getNegCacheFilename(NEGCACHE_JOURNAL_FILENAME);
+	if (filename.empty()) {
+		negcache_journal.clear();
+		return;
+	}
+
+	// NOTE: The journal is appended to, so the file size
+	// needs to be checked in addition to the mtime.
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attrs;
+	if (!GetFileAttributesExW(U82W(filename).c_str(), GetFileExInfoStandard, &attrs)) {
+		// No journal.
+		negcache_journal.clear();
+		negcache_journal_size = 0;
+		return;
+	}
+	const uint64_t fileSize = (static_cast<uint64_t>(attrs.nFileSizeHigh) << 32) | attrs.nFileSizeLow;
+	if (fileSize == negcache_journal_size &&
+	    !memcmp(&attrs.ftLastWriteTime, &negcache_journal_mtime, sizeof(negcache_journal_mtime)))
+	{
+		// Journal has not changed.
+		return;
+	}
+	negcache_journal_mtime = attrs.ftLastWriteTime;
+#else /* !_WIN32 */
+	struct stat sb;
+	if (stat(filename.c_str(), &sb) != 0) {
+		// No journal.
+		negcache_journal.clear();
+		negcache_journal_size = 0;
+		return;
+	}
+	const uint64_t fileSize = static_cast<uint64_t>(sb.st_size);
+	if (fileSize == negcache_journal_size && sb.st_ino == negcache_journal_ino &&
+	    sb.st_mtime == negcache_journal_mtime)
+	{
+		// Journal has not changed.
+		return;
+	}
+	negcache_journal_ino = sb.st_ino;
+	negcache_journal_mtime = sb.st_mtime;
+#endif /* _WIN32 */
+	negcache_journal_size = fileSize;
+	negcache_journal.clear();
+
+	// NOTE: The journal is merged once it reaches NEGCACHE_JOURNAL_MAX_SIZE,
+	// but another process might be appending to it, so allow some slack.
+	if (fileSize > NEGCACHE_JOURNAL_MAX_SIZE * 2) {
+		return;
+	}
+
+	FILE *f = fopen_read(filename);
+	if (f) {
+		readEntries(f, negcache_journal, static_cast<size_t>(fileSize / sizeof(NegCacheEntry)));
+		fclose(f);
+	}
+}
+
+/**
+ * (Re)load the negative cache index if it has changed on disk.
+ * Caller must hold negcache_mutex.
+ */
+static void reloadIndex(void)
+{
+	const string filename = getNegCacheFilename(NEGCACHE_FILENAME);
+	if (filename.empty()) {
+		unloadIndex();
+		return;
+	}
+
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attrs;
+	const wstring wfilename = U82W(filename);
+	if (!GetFileAttributesExW(wfilename.c_str(), GetFileExInfoStandard, &attrs)) {
+		// No index file.
+		unloadIndex();
+		return;
+	}
+	if (!negcache_buf.empty() &&
+	    !memcmp(&attrs.ftLastWriteTime, &negcache_mtime, sizeof(negcache_mtime)))
+	{
+		// Index file has not changed.
+		return;
+	}
+	unloadIndex();
+
+	FILE *f = _wfopen(wfilename.c_str(), L"rb");
+	if (!f) {
+		return;
+	}
+	const uint64_t fileSize = (static_cast<uint64_t>(attrs.nFileSizeHigh) << 32) | attrs.nFileSizeLow;
+	NegCacheHeader header;
+	if (fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+	    isHeaderValid(&header, fileSize) && header.count > 0)
+	{
+		negcache_buf.resize(header.count);
+		if (fread(negcache_buf.data(), sizeof(NegCacheEntry), header.count, f) == header.count) {
+			negcache_entries = negcache_buf.data();
+			negcache_count = header.count;
+			negcache_mtime = attrs.ftLastWriteTime;
+		} else {
+			negcache_buf.clear();
+		}
+	}
+	fclose(f);
+#else /* !_WIN32 */
+	struct stat sb;
+	if (stat(filename.c_str(), &sb) != 0) {
+		// No index file.
+		unloadIndex();
+		return;
+	}
+	if (negcache_map && sb.st_dev == negcache_dev && sb.st_ino == negcache_ino &&
+	    sb.st_mtime == negcache_mtime && static_cast<size_t>(sb.st_size) == negcache_map_size)
+	{
+		// Index file has not changed.
+		// NOTE: rp-download replaces the index file instead of
+		// modifying it, so the inode number will change.
+		return;
+	}
+	unloadIndex();
+
+	if (sb.st_size <= static_cast<off_t>(sizeof(NegCacheHeader))) {
+		// Empty index.
+		return;
+	}
+
+	int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	void *const map = mmap(nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return;
+	}
+
+	const NegCacheHeader *const pHeader = static_cast<const NegCacheHeader*>(map);
+	if (!isHeaderValid(pHeader, sb.st_size)) {
+		munmap(map, sb.st_size);
+		return;
+	}
+
+	negcache_map = map;
+	negcache_map_size = sb.st_size;
+	negcache_dev = sb.st_dev;
+	negcache_ino = sb.st_ino;
+	negcache_mtime = sb.st_mtime;
+	negcache_entries = reinterpret_cast<const NegCacheEntry*>(pHeader + 1);
+	negcache_count = pHeader->count;
+#endif /* _WIN32 */
+}
+
+/**
+ * (Re)load the negative cache index and journal if they have changed on disk.
+ * Caller must hold negcache_mutex.
+ */
+static void reloadIndexIfChanged(void)
+{
+	const time_t now = time(nullptr);
+	if (negcache_last_check != 0 && (now - negcache_last_check) < NEGCACHE_RECHECK_INTERVAL) {
+		// Checked recently.
+		return;
+	}
+	negcache_last_check = now;
+
+	reloadIndex();
+	reloadJournal();
+}
+
+/**
+ * Look up a cache key in the negative cache index.
+ *
+ * The index and journal are kept in memory and are only reloaded
+ * if they were changed on disk. (Checked at most once per second.)
+ *
+ * @param pCacheKey Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @return Time the cache key was added to the index, or -1 if not found.
+ */
+time_t negativeCacheLookup(const char *pCacheKey)
+{
+	uint64_t hash;
+	if (hashCacheKey(pCacheKey, &hash) != 0) {
+		return -1;
+	}
+
+	MutexLocker locker(negcache_mutex);
+	reloadIndexIfChanged();
+
+	// Check the journal first. The most recent entry takes precedence.
+	for (auto iter = negcache_journal.crbegin(); iter != negcache_journal.crend(); ++iter) {
+		if (iter->hash == hash) {
+			return (iter->timestamp >= 0 ? static_cast<time_t>(iter->timestamp) : -1);
+		}
+	}
+
+	if (negcache_count == 0) {
+		return -1;
+	}
+
+	const NegCacheEntry *const pEnd = negcache_entries + negcache_count;
+	const NegCacheEntry *const pEntry = std::lower_bound(negcache_entries, pEnd, hash);
+	if (pEntry == pEnd || pEntry->hash != hash) {
+		return -1;
+	}
+	return static_cast<time_t>(pEntry->timestamp);
+}
+
+#ifdef _WIN32
+/**
+ * Look up a cache key in the negative cache index.
+ *
+ * The index and journal are kept in memory and are only reloaded
+ * if they were changed on disk. (Checked at most once per second.)
+ *
+ * @param pCacheKey Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @return Time the cache key was added to the index, or -1 if not found.
+ */
+time_t negativeCacheLookup(const wchar_t *pCacheKey)
+{
+	return negativeCacheLookup(W2U8(pCacheKey).c_str());
+}
+#endif /* _WIN32 */
+
+/**
+ * Force the negative cache index to be reloaded on the next lookup.
+ * This should be called after rp-download has been run.
+ */
+void negativeCacheInvalidate(void)
+{
+	MutexLocker locker(negcache_mutex);
+	negcache_last_check = 0;
+	// Always reread the journal, since it might have been
+	// recreated with the same size and mtime.
+	negcache_journal_size = ~0ULL;
+}
+
+/**
+ * Merge the negative cache journal into the index, then delete the journal.
+ * Caller must hold the negative cache lock.
+ * @param expiry Expiry time, in seconds. Older entries will be pruned. (0 to keep all entries)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int mergeJournal(time_t expiry)
+{
+	const string filename = getNegCacheFilename(NEGCACHE_FILENAME);
+	const string journalFilename = getNegCacheFilename(NEGCACHE_JOURNAL_FILENAME);
+	if (filename.empty() || journalFilename.empty()) {
+		return -ENOENT;
+	}
+
+	// Load the current index.
+	// NOTE: Reading it directly instead of using the mapping,
+	// since it might have been replaced by another process.
+	vector<NegCacheEntry> entries;
+	FILE *f = fopen_read(filename);
+	if (f) {
+		NegCacheHeader header;
+		if (fread(&header, 1, sizeof(header), f) == sizeof(header)) {
+			fseek(f, 0, SEEK_END);
+			const uint64_t fileSize = static_cast<uint64_t>(ftell(f));
+			fseek(f, sizeof(header), SEEK_SET);
+			if (isHeaderValid(&header, fileSize) && header.count > 0) {
+				readEntries(f, entries, header.count);
+				if (entries.size() != header.count) {
+					// Short read. Start with an empty index.
+					entries.clear();
+				}
+			}
+		}
+		fclose(f);
+	}
+
+	// Apply the journal, in order.
+	vector<NegCacheEntry> journal;
+	f = fopen_read(journalFilename);
+	if (f) {
+		fseek(f, 0, SEEK_END);
+		const size_t count = static_cast<size_t>(ftell(f)) / sizeof(NegCacheEntry);
+		fseek(f, 0, SEEK_SET);
+		readEntries(f, journal, count);
+		fclose(f);
+	}
+	for (const NegCacheEntry &record : journal) {
+		auto iter = std::lower_bound(entries.begin(), entries.end(), record.hash);
+		const bool found = (iter != entries.end() && iter->hash == record.hash);
+		if (record.timestamp >= 0) {
+			if (found) {
+				iter->timestamp = record.timestamp;
+			} else {
+				entries.insert(iter, record);
+			}
+		} else if (found) {
+			entries.erase(iter);
+		}
+	}
+
+	// Prune expired entries.
+	if (expiry > 0) {
+		const time_t now = time(nullptr);
+		entries.erase(std::remove_if(entries.begin(), entries.end(),
+			[now, expiry](const NegCacheEntry &entry) noexcept -> bool {
+				return (now - static_cast<time_t>(entry.timestamp)) >= expiry;
+			}), entries.end());
+	}
+
+	// Write the new index to a temporary file, then rename it
+	// over the existing index. This ensures readers either see
+	// the old index or the new index, never a partial index.
+	NegCacheHeader header;
+	memcpy(header.magic, NEGCACHE_MAGIC, sizeof(header.magic));
+	header.version = NEGCACHE_VERSION;
+	header.count = static_cast<uint32_t>(entries.size());
+
+	const FileChunk chunks[] = {
+		{&header, sizeof(header)},
+		{entries.data(), entries.size() * sizeof(NegCacheEntry)},
+	};
+	int ret = writeFileAtomic(filename, chunks, ARRAY_SIZE(chunks));
+	if (ret != 0) {
+		return ret;
+	}
+
+	// NOTE: If a reader sees the new index and the old journal,
+	// it gets the same results, since the journal was merged.
+#ifdef _WIN32
+	DeleteFileW(U82W(journalFilename).c_str());
+#else /* !_WIN32 */
+	unlink(journalFilename.c_str());
+#endif /* _WIN32 */
+
+	return 0;
+}
+
+/**
+ * Add, update, or remove a cache key in the negative cache index.
+ *
+ * The change is appended to the negative cache journal instead
+ * of rewriting the index. Once the journal is large enough, it's
+ * merged into the index, and expired entries are pruned from the
+ * index at the same time. If nothing changes, nothing is written.
+ *
+ * The update is done while holding an exclusive lock on
+ * negative-cache.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @param timestamp Timestamp to store, or -1 to remove the cache key.
+ * @param expiry Expiry time, in seconds. Older entries will be pruned. (0 to keep all entries)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int negativeCacheUpdate(const char *pCacheKey, time_t timestamp, time_t expiry)
+{
+	NegCacheEntry record;
+	int ret = hashCacheKey(pCacheKey, &record.hash);
+	if (ret != 0) {
+		return ret;
+	}
+	record.timestamp = (timestamp >= 0 ? static_cast<int64_t>(timestamp) : -1);
+
+	const string journalFilename = getNegCacheFilename(NEGCACHE_JOURNAL_FILENAME);
+	if (journalFilename.empty()) {
+		return -ENOENT;
+	}
+
+	// Hold the lock until the journal is updated.
+	CacheLock lock(NEGCACHE_LOCK_FILENAME);
+	if (!lock.isLocked()) {
+		return lock.lastError();
+	}
+
+	// Check the current entry, since it usually doesn't need to be changed.
+	// (e.g. removing the entry after successfully downloading a file)
+	negativeCacheInvalidate();
+	const time_t curTimestamp = negativeCacheLookup(pCacheKey);
+	if (curTimestamp == static_cast<time_t>(record.timestamp)) {
+		// Nothing to do.
+		return 0;
+	}
+
+	// Append the record to the journal.
+	// NOTE: Writing the record in a single write, so a reader
+	// will never see a partial record in the middle of the file.
+	uint64_t journalSize = 0;
+#ifdef _WIN32
+	HANDLE hFile = CreateFileW(U82W(journalFilename).c_str(), FILE_APPEND_DATA,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (!hFile || hFile == INVALID_HANDLE_VALUE) {
+		return -EACCES;
+	}
+	DWORD dwWritten = 0;
+	BOOL bRet = WriteFile(hFile, &record, sizeof(record), &dwWritten, nullptr);
+	LARGE_INTEGER liFileSize;
+	if (GetFileSizeEx(hFile, &liFileSize)) {
+		journalSize = static_cast<uint64_t>(liFileSize.QuadPart);
+	}
+	CloseHandle(hFile);
+	if (!bRet || dwWritten != sizeof(record)) {
+		return -EIO;
+	}
+#else /* !_WIN32 */
+	int fd = open(journalFilename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return -errno;
+	}
+	const ssize_t size = write(fd, &record, sizeof(record));
+	ret = (size == static_cast<ssize_t>(sizeof(record)) ? 0 : (errno != 0 ? -errno : -EIO));
+	struct stat sb;
+	if (fstat(fd, &sb) == 0) {
+		journalSize = static_cast<uint64_t>(sb.st_size);
+	}
+	close(fd);
+	if (ret != 0) {
+		return ret;
+	}
+#endif /* _WIN32 */
+
+	if (journalSize >= NEGCACHE_JOURNAL_MAX_SIZE) {
+		// Merge the journal into the index.
+		ret = mergeJournal(expiry);
+	}
+
+	// Make sure this process sees the new entry.
+	negativeCacheInvalidate();
+	return ret;
+}
+
+#ifdef _WIN32
+/**
+ * Add, update, or remove a cache key in the negative cache index.
+ *
+ * The change is appended to the negative cache journal instead
+ * of rewriting the index. Once the journal is large enough, it's
+ * merged into the index, and expired entries are pruned from the
+ * index at the same time. If nothing changes, nothing is written.
+ *
+ * The update is done while holding an exclusive lock on
+ * negative-cache.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @param timestamp Timestamp to store, or -1 to remove the cache key.
+ * @param expiry Expiry time, in seconds. Older entries will be pruned. (0 to keep all entries)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int negativeCacheUpdate(const wchar_t *pCacheKey, time_t timestamp, time_t expiry)
+{
+	return negativeCacheUpdate(W2U8(pCacheKey).c_str(), timestamp, expiry);
+}
+#endif /* _WIN32 */
+
+}
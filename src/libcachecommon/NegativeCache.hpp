@@ -0,0 +1,110 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon)                   *
+ * NegativeCache.hpp: Negative cache index.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+// C includes. (C++ namespace)
+#include <ctime>
+
+namespace LibCacheCommon {
+
+/**
+ * The negative cache index stores cache keys that were not found
+ * on the server, along with the time the download was attempted.
+ *
+ * This replaces the zero-byte files that were previously stored
+ * in the cache directory. The index is a single file containing
+ * a sorted table of hashed cache keys, so checking it does not
+ * require a filesystem lookup for each cache key.
+ *
+ * The index is only updated by rp-download. New entries and
+ * removals are appended to a small journal (negative-cache.log),
+ * which is checked before the index. Once the journal is large
+ * enough, it's merged into the index. Merges are atomic: a new
+ * index is written to a temporary file and then renamed over the
+ * existing index. Updates hold an advisory lock on
+ * negative-cache.lock, since multiple rp-download processes may
+ * be running at the same time.
+ */
+
+/**
+ * Default negative cache expiry, in days.
+ */
+static const unsigned int NEGATIVE_CACHE_EXPIRY_DEFAULT = 7;
+
+/**
+ * Look up a cache key in the negative cache index.
+ *
+ * The index and journal are kept in memory and are only reloaded
+ * if they were changed on disk. (Checked at most once per second.)
+ *
+ * @param pCacheKey Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @return Time the cache key was added to the index, or -1 if not found.
+ */
+time_t negativeCacheLookup(const char *pCacheKey);
+
+#ifdef _WIN32
+/**
+ * Look up a cache key in the negative cache index.
+ *
+ * The index and journal are kept in memory and are only reloaded
+ * if they were changed on disk. (Checked at most once per second.)
+ *
+ * @param pCacheKey Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @return Time the cache key was added to the index, or -1 if not found.
+ */
+time_t negativeCacheLookup(const wchar_t *pCacheKey);
+#endif /* _WIN32 */
+
+/**
+ * Force the negative cache index to be reloaded on the next lookup.
+ * This should be called after rp-download has been run.
+ */
+void negativeCacheInvalidate(void);
+
+/**
+ * Add, update, or remove a cache key in the negative cache index.
+ *
+ * The change is appended to the negative cache journal instead
+ * of rewriting the index. Once the journal is large enough, it's
+ * merged into the index, and expired entries are pruned from the
+ * index at the same time. If nothing changes, nothing is written.
+ *
+ * The update is done while holding an exclusive lock on
+ * negative-cache.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-8, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @param timestamp Timestamp to store, or -1 to remove the cache key.
+ * @param expiry Expiry time, in seconds. Older entries will be pruned. (0 to keep all entries)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int negativeCacheUpdate(const char *pCacheKey, time_t timestamp, time_t expiry);
+
+#ifdef _WIN32
+/**
+ * Add, update, or remove a cache key in the negative cache index.
+ *
+ * The change is appended to the negative cache journal instead
+ * of rewriting the index. Once the journal is large enough, it's
+ * merged into the index, and expired entries are pruned from the
+ * index at the same time. If nothing changes, nothing is written.
+ *
+ * The update is done while holding an exclusive lock on
+ * negative-cache.lock, so concurrent updates from multiple
+ * rp-download processes don't lose each other's changes.
+ *
+ * @param pCacheKey Cache key. (Must be UTF-16, NULL-terminated.) (Will be filtered using filterCacheKey().)
+ * @param timestamp Timestamp to store, or -1 to remove the cache key.
+ * @param expiry Expiry time, in seconds. Older entries will be pruned. (0 to keep all entries)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int negativeCacheUpdate(const wchar_t *pCacheKey, time_t timestamp, time_t expiry);
+#endif /* _WIN32 */
+
+}
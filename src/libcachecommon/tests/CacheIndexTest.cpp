@@ -0,0 +1,487 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon/tests)             *
+ * CacheIndexTest.cpp: LibCacheCommon::cacheIndexUpdate() test.            *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// libcachecommon
+#include "../CacheDir.hpp"
+#include "../CacheIndex.hpp"
+
+// librpsecure
+#include "librpsecure/os-secure.h"
+
+// C includes
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+// C++ includes
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+using std::string;
+using std::vector;
+
+/**
+ * Additional security options for creating and deleting cache files.
+ * (See gtest_init.cpp.)
+ */
+#if defined(HAVE_SECCOMP)
+extern "C" const int gtest_extra_syscall_wl[] = {
+	SCMP_SYS(flock),
+	SCMP_SYS(getdents), SCMP_SYS(getdents64),
+	SCMP_SYS(getrandom),	// mkstemp()
+	SCMP_SYS(mkdir), SCMP_SYS(rmdir),
+	SCMP_SYS(rename), SCMP_SYS(renameat),
+#if defined(__SNR_renameat2) || defined(__NR_renameat2)
+	SCMP_SYS(renameat2),
+#endif /* __SNR_renameat2 || __NR_renameat2 */
+	SCMP_SYS(unlink),
+	SCMP_SYS(utimensat),
+	-1	// End of whitelist
+};
+#elif defined(HAVE_PLEDGE)
+extern "C" const char gtest_extra_promises[] = "wpath cpath flock fattr";
+#endif
+
+namespace LibCacheCommon { namespace Tests {
+
+/**
+ * Cache index file format.
+ * NOTE: Must match CacheIndex.cpp.
+ */
+#define CACHEIDX_FILENAME "cache-index.idx"
+#define CACHEIDX_MAGIC "RPCACIDX"
+#define CACHEIDX_VERSION 1
+struct CacheIdxHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+	int64_t last_scan;
+	uint32_t strtbl_size;
+	uint32_t reserved;
+};
+static_assert(sizeof(CacheIdxHeader) == 32, "CacheIdxHeader is not 32 bytes.");
+
+struct CacheIdxEntry {
+	uint64_t hash;
+	uint64_t size;
+	int64_t atime;
+	uint32_t key_offset;
+	uint32_t key_length;
+};
+static_assert(sizeof(CacheIdxEntry) == 32, "CacheIdxEntry is not 32 bytes.");
+
+class CacheIndexTest : public ::testing::Test
+{
+	protected:
+		void SetUp(void) override
+		{
+			cacheDir = getCacheDirectory();
+			ASSERT_FALSE(cacheDir.empty());
+			cacheDir += '/';
+
+			// Start with an empty cache directory.
+			removeTree(cacheDir);
+			ASSERT_EQ(0, mkdir(cacheDir.c_str(), 0777));
+		}
+
+		void TearDown(void) override
+		{
+			removeTree(cacheDir);
+		}
+
+	public:
+		/**
+		 * Recursively delete a directory.
+		 * @param path Directory, with a trailing slash.
+		 */
+		static void removeTree(const string &path)
+		{
+			DIR *const pdir = opendir(path.c_str());
+			if (!pdir) {
+				return;
+			}
+
+			const struct dirent *dirent;
+			while ((dirent = readdir(pdir)) != nullptr) {
+				const char *const name = dirent->d_name;
+				if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+					continue;
+				}
+
+				const string subpath = path + name;
+				struct stat sb;
+				if (lstat(subpath.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode)) {
+					removeTree(subpath + '/');
+				} else {
+					unlink(subpath.c_str());
+				}
+			}
+			closedir(pdir);
+			rmdir(path.c_str());
+		}
+
+		/**
+		 * Create a file.
+		 * @param filename Filename
+		 * @param size File size
+		 * @param mtime Access and modification time
+		 */
+		static void createFile(const string &filename, size_t size, time_t mtime)
+		{
+			// Create the parent directories.
+			for (size_t slash = filename.find('/', 1); slash != string::npos;
+			     slash = filename.find('/', slash + 1))
+			{
+				mkdir(filename.substr(0, slash).c_str(), 0777);
+			}
+
+			FILE *f = fopen(filename.c_str(), "wb");
+			ASSERT_NE(nullptr, f) << "Error creating " << filename << ": " << strerror(errno);
+			if (size > 0) {
+				const vector<uint8_t> buf(size, 0x55);
+				EXPECT_EQ(size, fwrite(buf.data(), 1, size, f));
+			}
+			fclose(f);
+
+			struct timeval tv[2];
+			tv[0].tv_sec = mtime;
+			tv[0].tv_usec = 0;
+			tv[1] = tv[0];
+			EXPECT_EQ(0, utimes(filename.c_str(), tv));
+		}
+
+		/**
+		 * Create a file in the cache directory.
+		 * @param key Cache key
+		 * @param size File size
+		 * @param mtime Access and modification time
+		 */
+		void createCacheFile(const char *key, size_t size, time_t mtime)
+		{
+			createFile(cacheDir + key, size, mtime);
+		}
+
+		/**
+		 * Does a file exist?
+		 * @param filename Filename
+		 * @return True if it exists; false if not.
+		 */
+		static bool fileExists(const string &filename)
+		{
+			return (access(filename.c_str(), F_OK) == 0);
+		}
+
+		/**
+		 * Does a file exist in the cache directory?
+		 * @param key Cache key
+		 * @return True if it exists; false if not.
+		 */
+		bool cacheFileExists(const char *key) const
+		{
+			return fileExists(cacheDir + key);
+		}
+
+		/**
+		 * 64-bit FNV-1a hash.
+		 * NOTE: Must match CacheIndex.cpp.
+		 * @param key Cache key
+		 * @return Hash
+		 */
+		static uint64_t fnv1a(const string &key)
+		{
+			uint64_t hash = 0xCBF29CE484222325ULL;
+			for (const uint8_t chr : key) {
+				hash ^= chr;
+				hash *= 0x100000001B3ULL;
+			}
+			return hash;
+		}
+
+		/**
+		 * Read the cache keys from the cache index.
+		 * @return Cache keys, sorted alphabetically.
+		 */
+		vector<string> readIndexKeys(void) const
+		{
+			vector<string> keys;
+			const string filename = cacheDir + CACHEIDX_FILENAME;
+			FILE *f = fopen(filename.c_str(), "rb");
+			EXPECT_NE(nullptr, f);
+			if (!f) {
+				return keys;
+			}
+
+			CacheIdxHeader header;
+			EXPECT_EQ(sizeof(header), fread(&header, 1, sizeof(header), f));
+			EXPECT_EQ(0, memcmp(header.magic, CACHEIDX_MAGIC, sizeof(header.magic)));
+			EXPECT_EQ(static_cast<uint32_t>(CACHEIDX_VERSION), header.version);
+
+			vector<CacheIdxEntry> entries(header.count);
+			string strtbl(header.strtbl_size, '\0');
+			EXPECT_EQ(entries.size(), fread(entries.data(), sizeof(CacheIdxEntry), entries.size(), f));
+			EXPECT_EQ(strtbl.size(), fread(&strtbl[0], 1, strtbl.size(), f));
+			fclose(f);
+
+			for (const CacheIdxEntry &entry : entries) {
+				keys.emplace_back(strtbl, entry.key_offset, entry.key_length);
+			}
+			std::sort(keys.begin(), keys.end());
+			return keys;
+		}
+
+		/**
+		 * Write a cache index.
+		 * @param keys Cache keys
+		 * @param size Size of each file
+		 * @param atime Access time of each file
+		 */
+		void writeIndex(const vector<string> &keys, uint64_t size, time_t atime)
+		{
+			vector<CacheIdxEntry> entries;
+			string strtbl;
+			for (const string &key : keys) {
+				CacheIdxEntry entry;
+				entry.hash = fnv1a(key);
+				entry.size = size;
+				entry.atime = atime;
+				entry.key_offset = static_cast<uint32_t>(strtbl.size());
+				entry.key_length = static_cast<uint32_t>(key.size());
+				entries.push_back(entry);
+				strtbl += key;
+			}
+			std::sort(entries.begin(), entries.end(),
+				[](const CacheIdxEntry &a, const CacheIdxEntry &b) noexcept -> bool {
+					return a.hash < b.hash;
+				});
+
+			CacheIdxHeader header;
+			memcpy(header.magic, CACHEIDX_MAGIC, sizeof(header.magic));
+			header.version = CACHEIDX_VERSION;
+			header.count = static_cast<uint32_t>(entries.size());
+			header.last_scan = time(nullptr);	// don't rescan
+			header.strtbl_size = static_cast<uint32_t>(strtbl.size());
+			header.reserved = 0;
+
+			const string filename = cacheDir + CACHEIDX_FILENAME;
+			FILE *f = fopen(filename.c_str(), "wb");
+			ASSERT_NE(nullptr, f);
+			fwrite(&header, 1, sizeof(header), f);
+			fwrite(entries.data(), sizeof(CacheIdxEntry), entries.size(), f);
+			fwrite(strtbl.data(), 1, strtbl.size(), f);
+			fclose(f);
+		}
+
+	public:
+		string cacheDir;	// Cache directory, with a trailing slash
+};
+
+/**
+ * Least-recently-used files are evicted when the cache is over quota.
+ */
+TEST_F(CacheIndexTest, lruEviction)
+{
+	const time_t now = time(nullptr);
+	createCacheFile("lru/1.png", 1000, now - 5000);
+	createCacheFile("lru/2.png", 1000, now - 4000);
+	createCacheFile("lru/3.png", 1000, now - 3000);
+	createCacheFile("lru/4.png", 1000, now - 2000);
+	createCacheFile("lru/5.png", 1000, now - 1000);
+	createCacheFile("lru/new.png", 1000, now);
+
+	// No index, so the cache directory is scanned.
+	// 6,000 bytes is over quota; evict down to 90% (4,500 bytes).
+	uint64_t freed = 0;
+	EXPECT_EQ(0, cacheIndexUpdate("lru/new.png", 1000, 5000, &freed));
+	EXPECT_EQ(2000U, freed);
+
+	EXPECT_FALSE(cacheFileExists("lru/1.png"));
+	EXPECT_FALSE(cacheFileExists("lru/2.png"));
+	EXPECT_TRUE(cacheFileExists("lru/3.png"));
+	EXPECT_TRUE(cacheFileExists("lru/4.png"));
+	EXPECT_TRUE(cacheFileExists("lru/5.png"));
+	EXPECT_TRUE(cacheFileExists("lru/new.png"));
+
+	const vector<string> expected = {"lru/3.png", "lru/4.png", "lru/5.png", "lru/new.png"};
+	EXPECT_EQ(expected, readIndexKeys());
+}
+
+/**
+ * The file that was just added is never evicted.
+ */
+TEST_F(CacheIndexTest, newFileNotEvicted)
+{
+	const time_t now = time(nullptr);
+	createCacheFile("big/old.png", 1000, now - 1000);
+	createCacheFile("big/new.png", 8000, now - 2000);
+
+	uint64_t freed = 0;
+	EXPECT_EQ(0, cacheIndexUpdate("big/new.png", 8000, 5000, &freed));
+	EXPECT_EQ(1000U, freed);
+	EXPECT_FALSE(cacheFileExists("big/old.png"));
+	EXPECT_TRUE(cacheFileExists("big/new.png"));
+}
+
+/**
+ * Entries are saved to the index, and the index is used
+ * instead of rescanning the cache directory.
+ */
+TEST_F(CacheIndexTest, loadSaveRoundTrip)
+{
+	const time_t now = time(nullptr);
+	createCacheFile("rt/1.png", 1000, now - 3000);
+	createCacheFile("rt/2.png", 1000, now - 2000);
+	createCacheFile("rt/3.png", 1000, now - 1000);
+	EXPECT_EQ(0, cacheIndexUpdate("rt/3.png", 1000, 0));
+
+	vector<string> expected = {"rt/1.png", "rt/2.png", "rt/3.png"};
+	EXPECT_EQ(expected, readIndexKeys());
+
+	// Files that aren't in the index aren't evicted,
+	// since the cache directory isn't rescanned.
+	createCacheFile("rt/0.png", 1000, now - 10000);
+
+	// Remove a cache key.
+	EXPECT_EQ(0, cacheIndexUpdate("rt/2.png", -1, 0));
+	expected = {"rt/1.png", "rt/3.png"};
+	EXPECT_EQ(expected, readIndexKeys());
+
+	// Add a cache key, over quota.
+	// rt/1.png is the least-recently-used file in the index.
+	createCacheFile("rt/4.png", 1000, now);
+	uint64_t freed = 0;
+	EXPECT_EQ(0, cacheIndexUpdate("rt/4.png", 1000, 2500, &freed));
+	EXPECT_EQ(1000U, freed);
+
+	expected = {"rt/3.png", "rt/4.png"};
+	EXPECT_EQ(expected, readIndexKeys());
+	EXPECT_TRUE(cacheFileExists("rt/0.png"));
+	EXPECT_FALSE(cacheFileExists("rt/1.png"));
+	EXPECT_TRUE(cacheFileExists("rt/2.png"));	// removed from the index only
+}
+
+/**
+ * Invalid cache keys in the index are ignored,
+ * so they can't be used to delete files outside
+ * of the cache directory.
+ */
+TEST_F(CacheIndexTest, rejectBadKeys)
+{
+	const time_t now = time(nullptr);
+
+	// NOTE: The cache directory's parent directory is the
+	// temporary directory created by gtest_main().
+	const string outside = cacheDir + "../outside.png";
+	createFile(outside, 1000, now - 10000);
+	createCacheFile("good/1.png", 1000, now - 5000);
+
+	writeIndex({"../outside.png", "good/../../outside.png", "good/1.png"}, 1000, now - 10000);
+
+	uint64_t freed = 0;
+	EXPECT_EQ(0, cacheIndexUpdate("good/2.png", 1000, 1500, &freed));
+	EXPECT_EQ(1000U, freed);
+
+	EXPECT_TRUE(fileExists(outside));
+	EXPECT_FALSE(cacheFileExists("good/1.png"));
+
+	const vector<string> expected = {"good/2.png"};
+	EXPECT_EQ(expected, readIndexKeys());
+
+	unlink(outside.c_str());
+}
+
+/**
+ * Expired zero-byte files from older versions are deleted
+ * when rescanning the cache directory.
+ */
+TEST_F(CacheIndexTest, legacyNegativeCacheFiles)
+{
+	const time_t now = time(nullptr);
+	createCacheFile("neg/expired.png", 0, now - (30 * 86400));
+	createCacheFile("neg/recent.png", 0, now - 60);
+	createCacheFile("neg/real.png", 1000, now - 60);
+
+	EXPECT_EQ(0, cacheIndexUpdate(nullptr, -1, 0));
+	EXPECT_FALSE(cacheFileExists("neg/expired.png"));
+	EXPECT_TRUE(cacheFileExists("neg/recent.png"));
+	EXPECT_TRUE(cacheFileExists("neg/real.png"));
+
+	// Zero-byte files aren't added to the index.
+	const vector<string> expected = {"neg/real.png"};
+	EXPECT_EQ(expected, readIndexKeys());
+}
+
+/**
+ * Concurrent updates don't lose each other's entries.
+ */
+TEST_F(CacheIndexTest, concurrentUpdates)
+{
+	static const unsigned int THREAD_COUNT = 8;
+	static const unsigned int KEYS_PER_THREAD = 16;
+
+	// Make sure the index exists first.
+	EXPECT_EQ(0, cacheIndexUpdate(nullptr, -1, 0));
+
+	vector<std::thread> threads;
+	for (unsigned int t = 0; t < THREAD_COUNT; t++) {
+		threads.emplace_back([t]() {
+			for (unsigned int i = 0; i < KEYS_PER_THREAD; i++) {
+				char key[32];
+				snprintf(key, sizeof(key), "conc/%u/%u.png", t, i);
+				EXPECT_EQ(0, cacheIndexUpdate(key, 1000, 0));
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	EXPECT_EQ(THREAD_COUNT * KEYS_PER_THREAD, readIndexKeys().size());
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fprintf(stderr, "LibCacheCommon test suite: LibCacheCommon::cacheIndexUpdate() tests.\n\n");
+	fflush(nullptr);
+
+	// Use a temporary cache directory.
+	// NOTE: This must be set before getCacheDirectory() is called.
+	const char *tmpdir = getenv("TMPDIR");
+	string tmpl = (tmpdir && tmpdir[0] == '/') ? tmpdir : "/tmp";
+	tmpl += "/rp-CacheIndexTest.XXXXXX";
+	if (!mkdtemp(&tmpl[0])) {
+		fprintf(stderr, "*** ERROR: Unable to create a temporary directory: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	setenv("XDG_CACHE_HOME", tmpl.c_str(), 1);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	const int ret = RUN_ALL_TESTS();
+
+	rmdir(tmpl.c_str());
+	return ret;
+}
@@ -0,0 +1,234 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libcachecommon/tests)             *
+ * NegativeCacheTest.cpp: LibCacheCommon negative cache index test.        *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// libcachecommon
+#include "../CacheDir.hpp"
+#include "../NegativeCache.hpp"
+
+// librpsecure
+#include "librpsecure/os-secure.h"
+
+// C includes
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+// C++ includes
+#include <string>
+#include <thread>
+#include <vector>
+using std::string;
+using std::vector;
+
+/**
+ * Additional security options for creating and deleting cache files.
+ * (See gtest_init.cpp.)
+ */
+#if defined(HAVE_SECCOMP)
+extern "C" const int gtest_extra_syscall_wl[] = {
+	SCMP_SYS(flock),
+	SCMP_SYS(getrandom),	// mkstemp()
+	SCMP_SYS(mkdir), SCMP_SYS(rmdir),
+	SCMP_SYS(rename), SCMP_SYS(renameat),
+#if defined(__SNR_renameat2) || defined(__NR_renameat2)
+	SCMP_SYS(renameat2),
+#endif /* __SNR_renameat2 || __NR_renameat2 */
+	SCMP_SYS(unlink),
+	-1	// End of whitelist
+};
+#elif defined(HAVE_PLEDGE)
+extern "C" const char gtest_extra_promises[] = "wpath cpath flock";
+#endif
+
+namespace LibCacheCommon { namespace Tests {
+
+class NegativeCacheTest : public ::testing::Test
+{
+	protected:
+		void SetUp(void) override
+		{
+			cacheDir = getCacheDirectory();
+			ASSERT_FALSE(cacheDir.empty());
+			cacheDir += '/';
+
+			// Start with an empty cache directory.
+			removeFiles();
+			mkdir(cacheDir.c_str(), 0777);
+			negativeCacheInvalidate();
+		}
+
+		void TearDown(void) override
+		{
+			removeFiles();
+			rmdir(cacheDir.c_str());
+		}
+
+	public:
+		/**
+		 * Remove the negative cache files.
+		 */
+		void removeFiles(void)
+		{
+			unlink((cacheDir + "negative-cache.idx").c_str());
+			unlink((cacheDir + "negative-cache.log").c_str());
+			unlink((cacheDir + "negative-cache.lock").c_str());
+		}
+
+		/**
+		 * Get the size of a file in the cache directory.
+		 * @param name Filename
+		 * @return File size, or -1 if it doesn't exist.
+		 */
+		off_t fileSize(const char *name) const
+		{
+			struct stat sb;
+			if (stat((cacheDir + name).c_str(), &sb) != 0) {
+				return -1;
+			}
+			return sb.st_size;
+		}
+
+	public:
+		string cacheDir;	// Cache directory, with a trailing slash
+};
+
+/**
+ * Add, look up, and remove a cache key.
+ */
+TEST_F(NegativeCacheTest, addLookupRemove)
+{
+	const time_t now = time(nullptr);
+	EXPECT_EQ(-1, negativeCacheLookup("neg/1.png"));
+
+	EXPECT_EQ(0, negativeCacheUpdate("neg/1.png", now, 0));
+	EXPECT_EQ(now, negativeCacheLookup("neg/1.png"));
+	EXPECT_EQ(-1, negativeCacheLookup("neg/2.png"));
+
+	// Updates are appended to the journal; the index isn't rewritten.
+	EXPECT_EQ(-1, fileSize("negative-cache.idx"));
+	EXPECT_EQ(16, fileSize("negative-cache.log"));
+
+	// Same timestamp: Nothing is written.
+	EXPECT_EQ(0, negativeCacheUpdate("neg/1.png", now, 0));
+	EXPECT_EQ(16, fileSize("negative-cache.log"));
+
+	// Removing a cache key that isn't present: Nothing is written.
+	EXPECT_EQ(0, negativeCacheUpdate("neg/2.png", -1, 0));
+	EXPECT_EQ(16, fileSize("negative-cache.log"));
+
+	EXPECT_EQ(0, negativeCacheUpdate("neg/1.png", -1, 0));
+	EXPECT_EQ(-1, negativeCacheLookup("neg/1.png"));
+	EXPECT_EQ(32, fileSize("negative-cache.log"));
+}
+
+/**
+ * The journal is merged into the index once it's large enough.
+ * Expired entries are pruned when merging.
+ */
+TEST_F(NegativeCacheTest, mergeJournal)
+{
+	static const unsigned int KEY_COUNT = 300;
+	static const time_t expiry = 86400;
+	const time_t now = time(nullptr);
+
+	// This entry will be expired when the journal is merged.
+	EXPECT_EQ(0, negativeCacheUpdate("neg/expired.png", now - (2 * expiry), expiry));
+
+	char key[32];
+	for (unsigned int i = 0; i < KEY_COUNT; i++) {
+		snprintf(key, sizeof(key), "neg/%u.png", i);
+		EXPECT_EQ(0, negativeCacheUpdate(key, now - i, expiry));
+	}
+
+	// The index should exist now, and the journal should be small.
+	EXPECT_GT(fileSize("negative-cache.idx"), 0);
+	EXPECT_LT(fileSize("negative-cache.log"), static_cast<off_t>(KEY_COUNT * 16));
+
+	for (unsigned int i = 0; i < KEY_COUNT; i++) {
+		snprintf(key, sizeof(key), "neg/%u.png", i);
+		EXPECT_EQ(now - static_cast<time_t>(i), negativeCacheLookup(key)) << key;
+	}
+	EXPECT_EQ(-1, negativeCacheLookup("neg/expired.png"));
+
+	// Removals in the journal override the index.
+	EXPECT_EQ(0, negativeCacheUpdate("neg/0.png", -1, expiry));
+	EXPECT_EQ(-1, negativeCacheLookup("neg/0.png"));
+	EXPECT_EQ(now - 1, negativeCacheLookup("neg/1.png"));
+}
+
+/**
+ * Concurrent updates don't lose each other's entries.
+ */
+TEST_F(NegativeCacheTest, concurrentUpdates)
+{
+	static const unsigned int THREAD_COUNT = 8;
+	static const unsigned int KEYS_PER_THREAD = 64;
+	const time_t now = time(nullptr);
+
+	vector<std::thread> threads;
+	for (unsigned int t = 0; t < THREAD_COUNT; t++) {
+		threads.emplace_back([t, now]() {
+			char key[32];
+			for (unsigned int i = 0; i < KEYS_PER_THREAD; i++) {
+				snprintf(key, sizeof(key), "conc/%u/%u.png", t, i);
+				EXPECT_EQ(0, negativeCacheUpdate(key, now, 0));
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	negativeCacheInvalidate();
+	char key[32];
+	for (unsigned int t = 0; t < THREAD_COUNT; t++) {
+		for (unsigned int i = 0; i < KEYS_PER_THREAD; i++) {
+			snprintf(key, sizeof(key), "conc/%u/%u.png", t, i);
+			EXPECT_EQ(now, negativeCacheLookup(key)) << key;
+		}
+	}
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fprintf(stderr, "LibCacheCommon test suite: Negative cache index tests.\n\n");
+	fflush(nullptr);
+
+	// Use a temporary cache directory.
+	// NOTE: This must be set before getCacheDirectory() is called.
+	const char *tmpdir = getenv("TMPDIR");
+	string tmpl = (tmpdir && tmpdir[0] == '/') ? tmpdir : "/tmp";
+	tmpl += "/rp-NegativeCacheTest.XXXXXX";
+	if (!mkdtemp(&tmpl[0])) {
+		fprintf(stderr, "*** ERROR: Unable to create a temporary directory: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	setenv("XDG_CACHE_HOME", tmpl.c_str(), 1);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	const int ret = RUN_ALL_TESTS();
+
+	rmdir(tmpl.c_str());
+	return ret;
+}
@@ -436,7 +436,7 @@ const rp_image *DreamcastSavePrivate::loadIcon(void)
 {
 	if (iconAnimData) {
 		// Icon has already been loaded.
-		return iconAnimData->frames[0];
+		return iconAnimData->frame(0);
 	} else if (!this->file || !this->isValid) {
 		// Can't load the icon.
 		return nullptr;
@@ -538,7 +538,7 @@ const rp_image *DreamcastSavePrivate::loadIcon(void)
 	iconAnimData->seq_count = iconAnimData->count;
 
 	// Return the first frame.
-	return iconAnimData->frames[0];
+	return iconAnimData->frame(0);
 }
 
 /**
@@ -553,7 +553,7 @@ const rp_image *DreamcastSavePrivate::loadIcon_ICONDATA_VMS(void)
 {
 	if (iconAnimData) {
 		// Icon has already been loaded.
-		return iconAnimData->frames[0];
+		return iconAnimData->frame(0);
 	} else if (!this->file || !this->isValid) {
 		// Can't load the icon.
 		return nullptr;
@@ -1541,7 +1541,7 @@ int DreamcastSave::loadInternalImage(ImageType imageType, const rp_image **pImag
 				// Return the first icon frame.
 				// NOTE: DC save icon animations are always
 				// sequential, so we can use a shortcut here.
-				*pImage = d->iconAnimData->frames[0];
+				*pImage = d->iconAnimData->frame(0);
 				return 0;
 			}
 			break;
@@ -2296,6 +2296,59 @@ int GameCube::extURLs(ImageType imageType, vector<ExtURL> *pExtURLs, int size) c
 	return 0;
 }
 
+/**
+ * Open the logical ROM image for reading.
+ * For compressed and container formats, this is the decompressed disc image.
+ * @return IDiscReader for the logical ROM image, or nullptr on error. (Caller must unref() it.)
+ */
+IDiscReader *GameCube::openLogicalImage(void)
+{
+	RP_D(GameCube);
+	if (!d->discReader || !d->discReader->isOpen()) {
+		return nullptr;
+	}
+	return d->discReader->ref();
+}
+
+/**
+ * Open the partition that contains the main file system.
+ * For GameCube, this is the disc itself. For Wii, this is the
+ * game partition, which requires the encryption keys.
+ * @return IPartition with a file system table, or nullptr if not supported. (Caller must unref() it.)
+ */
+IPartition *GameCube::openFstPartition(void)
+{
+	RP_D(GameCube);
+	if (!d->isValid || !d->discReader || !d->discReader->isOpen()) {
+		return nullptr;
+	}
+
+	switch (d->discType & GameCubePrivate::DISC_SYSTEM_MASK) {
+		case GameCubePrivate::DISC_SYSTEM_GCN: {
+			GcnPartition *const gcnPartition = new GcnPartition(d->discReader, 0);
+			if (!gcnPartition->isOpen()) {
+				// Could not open the partition.
+				gcnPartition->unref();
+				return nullptr;
+			}
+			return gcnPartition;
+		}
+
+		case GameCubePrivate::DISC_SYSTEM_WII:
+			if (d->loadWiiPartitionTables() != 0 || !d->gamePartition) {
+				// No game partition.
+				return nullptr;
+			}
+			return d->gamePartition->RefBase::ref<IPartition>();
+
+		default:
+			// TODO: Triforce?
+			break;
+	}
+
+	return nullptr;
+}
+
 /**
  * Check for "viewed" achievements.
  *
@@ -20,6 +20,8 @@ ROMDATA_DECL_IMGPF()
 ROMDATA_DECL_IMGINT()
 ROMDATA_DECL_IMGEXT()
 ROMDATA_DECL_VIEWED_ACHIEVEMENTS()
+ROMDATA_DECL_LOGICAL_IMAGE()
+ROMDATA_DECL_FST_PARTITION()
 ROMDATA_DECL_END()
 
 }
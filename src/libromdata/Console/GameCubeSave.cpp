@@ -20,8 +20,10 @@ using namespace LibRpTexture;
 using LibRpFile::IRpFile;
 
 // C++ STL classes.
+#include <array>
 #include <string>
 #include <vector>
+using std::array;
 using std::string;
 using std::vector;
 
@@ -289,11 +291,129 @@ bool GameCubeSavePrivate::isCardDirEntry(const uint8_t *buffer, uint32_t data_si
 	return true;
 }
 
+/**
+ * GameCube save file icon data.
+ * Frames are decoded on first access.
+ */
+class GameCubeSaveIconAnimData : public IconAnimData
+{
+	public:
+		explicit GameCubeSaveIconAnimData(UNIQUE_PTR_ALIGNED(uint8_t) &&icondata)
+			: icondata(std::move(icondata))
+			, pal_CI8_shared(nullptr)
+		{
+			fmt.fill(CARD_ICON_NONE);
+			offset.fill(0);
+			alias.fill(-1);
+		}
+
+		/**
+		 * Get the size of a frame's icon data.
+		 * @param idx Frame index
+		 * @return Size of the icon data, including the palette for CI8 with a unique palette.
+		 */
+		unsigned int frameSize(int idx) const
+		{
+			switch (fmt[idx]) {
+				case CARD_ICON_RGB:
+					return CARD_ICON_W * CARD_ICON_H * 2;
+				case CARD_ICON_CI_UNIQUE:
+					return (CARD_ICON_W * CARD_ICON_H * 1) + (256*2);
+				case CARD_ICON_CI_SHARED:
+					return CARD_ICON_W * CARD_ICON_H * 1;
+				default:
+					break;
+			}
+			return 0;
+		}
+
+		/**
+		 * Check for frames that have identical icon data to an
+		 * earlier frame. These frames will share the same rp_image.
+		 */
+		void findAliases(void)
+		{
+			for (int i = 1; i < count; i++) {
+				const unsigned int size = frameSize(i);
+				if (size == 0)
+					continue;
+				for (int j = 0; j < i; j++) {
+					if (fmt[j] == fmt[i] && alias[j] < 0 &&
+					    !memcmp(icondata.get() + offset[j], icondata.get() + offset[i], size))
+					{
+						alias[i] = static_cast<int8_t>(j);
+						break;
+					}
+				}
+			}
+		}
+
+	public:
+		// Icon data, as loaded from the save file.
+		UNIQUE_PTR_ALIGNED(uint8_t) icondata;
+		const uint16_t *pal_CI8_shared;
+
+		// Icon format and offset into icondata for each frame.
+		array<uint8_t, MAX_FRAMES> fmt;
+		array<unsigned int, MAX_FRAMES> offset;
+
+		// Earlier frame with identical icon data, or -1 if none.
+		array<int8_t, MAX_FRAMES> alias;
+
+	protected:
+		/**
+		 * Decode a frame.
+		 * @param idx Frame index
+		 * @return Decoded frame (ref()'d), or nullptr on error.
+		 */
+		rp_image *decodeFrame(int idx) const final
+		{
+			static const size_t iconsize_RGB = CARD_ICON_W * CARD_ICON_H * 2;
+			static const size_t iconsize_CI8 = CARD_ICON_W * CARD_ICON_H * 1;
+			const uint8_t *const pIcon = icondata.get() + offset[idx];
+
+			if (alias[idx] >= 0) {
+				// Share the earlier frame.
+				// NOTE: frameMutex is already locked.
+				const rp_image *const img = frame_locked(alias[idx]);
+				return (img ? const_cast<rp_image*>(img)->ref() : nullptr);
+			}
+
+			switch (fmt[idx]) {
+				case CARD_ICON_RGB:
+					// RGB5A3
+					return ImageDecoder::fromGcn16(
+						ImageDecoder::PixelFormat::RGB5A3, CARD_ICON_W, CARD_ICON_H,
+						reinterpret_cast<const uint16_t*>(pIcon), iconsize_RGB);
+
+				case CARD_ICON_CI_UNIQUE:
+					// CI8 with a unique palette.
+					// Palette is located immediately after the icon.
+					return ImageDecoder::fromGcnCI8(
+						CARD_ICON_W, CARD_ICON_H,
+						pIcon, iconsize_CI8,
+						reinterpret_cast<const uint16_t*>(pIcon + iconsize_CI8), 256*2);
+
+				case CARD_ICON_CI_SHARED:
+					// CI8 with a shared palette.
+					return ImageDecoder::fromGcnCI8(
+						CARD_ICON_W, CARD_ICON_H,
+						pIcon, iconsize_CI8,
+						pal_CI8_shared, 256*2);
+
+				default:
+					// No icon.
+					break;
+			}
+			return nullptr;
+		}
+};
+
 /**
  * Load the save file's icons.
  *
- * This will load all of the animated icon frames,
- * though only the first frame will be returned.
+ * Only the first frame will be decoded. The other frames
+ * will be decoded by IconAnimData::frame() on first access.
  *
  * @return Icon, or nullptr on error.
  */
@@ -301,7 +421,7 @@ const rp_image *GameCubeSavePrivate::loadIcon(void)
 {
 	if (iconAnimData) {
 		// Icon has already been loaded.
-		return iconAnimData->frames[0];
+		return iconAnimData->frame(0);
 	} else if (!this->file || !this->isValid) {
 		// Can't load the icon.
 		return nullptr;
@@ -368,7 +488,6 @@ const rp_image *GameCubeSavePrivate::loadIcon(void)
 	}
 
 	// Load the icon data.
-	// TODO: Only read the first frame unless specifically requested?
 	auto icondata = aligned_uptr<uint8_t>(16, iconsizetotal);
 	size_t size = file->seekAndRead(dataOffset + iconaddr, icondata.get(), iconsizetotal);
 	if (size != iconsizetotal) {
@@ -376,16 +495,14 @@ const rp_image *GameCubeSavePrivate::loadIcon(void)
 		return nullptr;
 	}
 
-	const uint16_t *pal_CI8_shared = nullptr;
+	GameCubeSaveIconAnimData *const gcnIconAnimData = new GameCubeSaveIconAnimData(std::move(icondata));
+	this->iconAnimData = gcnIconAnimData;
 	if (is_CI8_shared) {
 		// Shared CI8 palette is at the end of the data.
-		pal_CI8_shared = reinterpret_cast<const uint16_t*>(
-			icondata.get() + (iconsizetotal - (256*2)));
+		gcnIconAnimData->pal_CI8_shared = reinterpret_cast<const uint16_t*>(
+			gcnIconAnimData->icondata.get() + (iconsizetotal - (256*2)));
 	}
 
-	this->iconAnimData = new IconAnimData();
-	iconAnimData->count = 0;
-
 	unsigned int iconaddr_cur = 0;
 	iconfmt = direntry.iconfmt;
 	iconspeed = direntry.iconspeed;
@@ -403,49 +520,39 @@ const rp_image *GameCubeSavePrivate::loadIcon(void)
 		iconAnimData->delays[i].denom = 8;
 		iconAnimData->delays[i].ms = delay * 125;
 
-		switch (iconfmt & CARD_ICON_MASK) {
-			case CARD_ICON_RGB: {
+		// NOTE: Frames will be decoded on first access.
+		const uint8_t fmt = (iconfmt & CARD_ICON_MASK);
+		gcnIconAnimData->fmt[i] = fmt;
+		gcnIconAnimData->offset[i] = iconaddr_cur;
+		switch (fmt) {
+			case CARD_ICON_RGB:
 				// RGB5A3
-				static const size_t iconsize = CARD_ICON_W * CARD_ICON_H * 2;
-				iconAnimData->frames[i] = ImageDecoder::fromGcn16(
-					ImageDecoder::PixelFormat::RGB5A3, CARD_ICON_W, CARD_ICON_H,
-					reinterpret_cast<const uint16_t*>(icondata.get() + iconaddr_cur),
-					iconsize);
-				iconaddr_cur += iconsize;
+				iconaddr_cur += (CARD_ICON_W * CARD_ICON_H * 2);
+				gcnIconAnimData->frame_pending[i] = true;
 				break;
-			}
 
-			case CARD_ICON_CI_UNIQUE: {
+			case CARD_ICON_CI_UNIQUE:
 				// CI8 with a unique palette.
 				// Palette is located immediately after the icon.
-				static const size_t iconsize = CARD_ICON_W * CARD_ICON_H * 1;
-				iconAnimData->frames[i] = ImageDecoder::fromGcnCI8(
-					CARD_ICON_W, CARD_ICON_H,
-					icondata.get() + iconaddr_cur, iconsize,
-					reinterpret_cast<const uint16_t*>(icondata.get() + iconaddr_cur + iconsize), 256*2);
-				iconaddr_cur += iconsize + (256*2);
+				iconaddr_cur += (CARD_ICON_W * CARD_ICON_H * 1) + (256*2);
+				gcnIconAnimData->frame_pending[i] = true;
 				break;
-			}
 
-			case CARD_ICON_CI_SHARED: {
-				static const size_t iconsize = CARD_ICON_W * CARD_ICON_H * 1;
-				iconAnimData->frames[i] = ImageDecoder::fromGcnCI8(
-					CARD_ICON_W, CARD_ICON_H,
-					icondata.get() + iconaddr_cur, iconsize,
-					pal_CI8_shared, 256*2);
-				iconaddr_cur += iconsize;
+			case CARD_ICON_CI_SHARED:
+				// CI8 with a shared palette.
+				iconaddr_cur += (CARD_ICON_W * CARD_ICON_H * 1);
+				gcnIconAnimData->frame_pending[i] = true;
 				break;
-			}
 
 			default:
 				// No icon.
-				// Add a nullptr as a placeholder.
-				iconAnimData->frames[i] = 0;
+				// frames[i] is left as nullptr as a placeholder.
 				break;
 		}
 
 		iconAnimData->count++;
 	}
+	gcnIconAnimData->findAliases();
 
 	// NOTE: We're not deleting iconAnimData even if we only have
 	// a single icon because iconAnimData() will call loadIcon()
@@ -469,7 +576,7 @@ const rp_image *GameCubeSavePrivate::loadIcon(void)
 	iconAnimData->seq_count = idx;
 
 	// Return the first frame.
-	return iconAnimData->frames[0];
+	return iconAnimData->frame(0);
 }
 
 /**
@@ -1038,7 +1145,7 @@ int GameCubeSave::loadInternalImage(ImageType imageType, const rp_image **pImage
 				// Return the first icon frame.
 				// NOTE: GCN save icon animations are always
 				// sequential, so we can use a shortcut here.
-				*pImage = d->iconAnimData->frames[0];
+				*pImage = d->iconAnimData->frame(0);
 				return 0;
 			}
 			break;
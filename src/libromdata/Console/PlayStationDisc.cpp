@@ -1028,4 +1028,18 @@ int PlayStationDisc::extURLs(ImageType imageType, vector<ExtURL> *pExtURLs, int
 	return 0;
 }
 
+/**
+ * Open the partition that contains the main file system.
+ * For PlayStation discs, this is the ISO-9660 partition.
+ * @return IPartition with a file system table, or nullptr if not supported. (Caller must unref() it.)
+ */
+IPartition *PlayStationDisc::openFstPartition(void)
+{
+	RP_D(PlayStationDisc);
+	if (!d->isValid || !d->isoPartition || !d->isoPartition->isOpen()) {
+		return nullptr;
+	}
+	return d->isoPartition->RefBase::ref<IPartition>();
+}
+
 }
@@ -28,6 +28,7 @@ ROMDATA_DECL_CLOSE()
 ROMDATA_DECL_METADATA()
 ROMDATA_DECL_IMGSUPPORT()
 ROMDATA_DECL_IMGEXT()
+ROMDATA_DECL_FST_PARTITION()
 ROMDATA_DECL_END()
 
 }
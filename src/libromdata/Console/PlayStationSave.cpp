@@ -132,7 +132,7 @@ const rp_image *PlayStationSavePrivate::loadIcon(void)
 {
 	if (iconAnimData) {
 		// Icon has already been loaded.
-		return iconAnimData->frames[0];
+		return iconAnimData->frame(0);
 	}
 
 	if ((int)saveType < 0) {
@@ -193,7 +193,7 @@ const rp_image *PlayStationSavePrivate::loadIcon(void)
 
 
 	// Return the first frame.
-	return iconAnimData->frames[0];
+	return iconAnimData->frame(0);
 }
 
 /** PlayStationSave **/
@@ -567,7 +567,7 @@ int PlayStationSave::loadInternalImage(ImageType imageType, const rp_image **pIm
 		// Image has already been loaded.
 		// NOTE: PS1 icon animations are always sequential,
 		// so we can use a shortcut here.
-		*pImage = d->iconAnimData->frames[0];
+		*pImage = d->iconAnimData->frame(0);
 		return 0;
 	} else if (!d->file) {
 		// File isn't open.
@@ -619,4 +619,18 @@ int WiiU::extURLs(ImageType imageType, vector<ExtURL> *pExtURLs, int size) const
 	return 0;
 }
 
+/**
+ * Open the logical ROM image for reading.
+ * For WUX images, this is the decompressed WUD image.
+ * @return IDiscReader for the logical ROM image, or nullptr on error. (Caller must unref() it.)
+ */
+IDiscReader *WiiU::openLogicalImage(void)
+{
+	RP_D(WiiU);
+	if (!d->discReader || !d->discReader->isOpen()) {
+		return nullptr;
+	}
+	return d->discReader->ref();
+}
+
 }
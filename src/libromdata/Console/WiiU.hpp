@@ -15,6 +15,7 @@ namespace LibRomData {
 ROMDATA_DECL_BEGIN(WiiU)
 ROMDATA_DECL_IMGSUPPORT()
 ROMDATA_DECL_IMGEXT()
+ROMDATA_DECL_LOGICAL_IMAGE()
 ROMDATA_DECL_END()
 
 }
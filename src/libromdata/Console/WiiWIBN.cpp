@@ -121,7 +121,7 @@ const rp_image *WiiWIBNPrivate::loadIcon(void)
 {
 	if (iconAnimData) {
 		// Icon has already been loaded.
-		return iconAnimData->frames[0];
+		return iconAnimData->frame(0);
 	} else if (!this->file || !this->isValid) {
 		// Can't load the icon.
 		return nullptr;
@@ -212,7 +212,7 @@ const rp_image *WiiWIBNPrivate::loadIcon(void)
 	iconAnimData->seq_count = idx;
 
 	// Return the first frame.
-	return iconAnimData->frames[0];
+	return iconAnimData->frame(0);
 }
 
 /**
@@ -511,7 +511,7 @@ int WiiWIBN::loadInternalImage(ImageType imageType, const rp_image **pImage)
 				// Return the first icon frame.
 				// NOTE: Wii save icon animations are always
 				// sequential, so we can use a shortcut here.
-				*pImage = d->iconAnimData->frames[0];
+				*pImage = d->iconAnimData->frame(0);
 				return 0;
 			}
 			break;
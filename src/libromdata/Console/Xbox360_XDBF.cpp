@@ -15,10 +15,13 @@
 // Other rom-properties libraries
 #include "librpbase/img/RpPng.hpp"
 #include "librpfile/MemFile.hpp"
+#include "librpthreads/Mutex.hpp"
 using namespace LibRpBase;
 using namespace LibRpText;
 using LibRpFile::IRpFile;
 using LibRpFile::MemFile;
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
 using LibRpTexture::rp_image;
 
 // C++ STL classes.
@@ -71,6 +74,10 @@ class Xbox360_XDBF_Private final : public RomDataPrivate
 		// - Value: rp_image*
 		unordered_map<uint64_t, rp_image*> map_images;
 
+		// Mutex for map_images and image reads.
+		// List data icons may be decoded in parallel.
+		Mutex imgMutex;
+
 	public:
 		// XDBF header.
 		XDBF_Header xdbfHeader;
@@ -160,6 +167,15 @@ class Xbox360_XDBF_Private final : public RomDataPrivate
 		 */
 		rp_image *loadImage(uint64_t image_id);
 
+		/**
+		 * Load an image resource for a list data icon.
+		 * Used as a RomFields::ListDataIcons loader function.
+		 * @param userdata Xbox360_XDBF_Private
+		 * @param image_id Image ID.
+		 * @return Decoded image, or nullptr on error.
+		 */
+		static const rp_image *loadImage_icon_cb(void *userdata, uint64_t image_id);
+
 		/**
 		 * Load the main title icon.
 		 * @return Icon, or nullptr on error.
@@ -727,51 +743,60 @@ inline uint32_t Xbox360_XDBF_Private::getDefaultLC(void) const
  */
 rp_image *Xbox360_XDBF_Private::loadImage(uint64_t image_id)
 {
-	// Is the image already loaded?
-	auto iter = map_images.find(image_id);
-	if (iter != map_images.end()) {
-		// We already loaded the image.
-		return iter->second;
-	}
+	// NOTE: The file is read while holding imgMutex, but the
+	// PNG is decoded without it so icons can be decoded in
+	// parallel by RomFields::ListDataIcons::loadAll().
+	unique_ptr<uint8_t[]> png_buf;
+	uint32_t length;
+	{
+		MutexLocker locker(imgMutex);
 
-	if (entryTable.empty()) {
-		// Entry table isn't loaded...
-		return nullptr;
-	}
+		// Is the image already loaded?
+		auto iter = map_images.find(image_id);
+		if (iter != map_images.end()) {
+			// We already loaded the image.
+			return iter->second;
+		}
 
-	// Can we load the image?
-	if (!file || !isValid) {
-		// Can't load the image.
-		return nullptr;
-	}
+		if (entryTable.empty()) {
+			// Entry table isn't loaded...
+			return nullptr;
+		}
 
-	// Icons are stored in PNG format.
+		// Can we load the image?
+		if (!file || !isValid) {
+			// Can't load the image.
+			return nullptr;
+		}
 
-	// Get the icon resource.
-	const XDBF_Entry *const entry = findResource(XDBF_SPA_NAMESPACE_IMAGE, image_id);
-	if (!entry) {
-		// Not found...
-		return nullptr;
-	}
+		// Icons are stored in PNG format.
 
-	// Load the image.
-	const uint32_t addr = be32_to_cpu(entry->offset) + this->data_offset;
-	const uint32_t length = be32_to_cpu(entry->length);
-	// Sanity check:
-	// - Size must be at least 16 bytes. [TODO: Smallest PNG?]
-	// - Size must be a maximum of 1 MB.
-	assert(length >= 16);
-	assert(length <= 1024*1024);
-	if (length < 16 || length > 1024*1024) {
-		// Size is out of range.
-		return nullptr;
-	}
+		// Get the icon resource.
+		const XDBF_Entry *const entry = findResource(XDBF_SPA_NAMESPACE_IMAGE, image_id);
+		if (!entry) {
+			// Not found...
+			return nullptr;
+		}
 
-	unique_ptr<uint8_t[]> png_buf(new uint8_t[length]);
-	size_t size = file->seekAndRead(addr, png_buf.get(), length);
-	if (size != length) {
-		// Seek and/or read error.
-		return nullptr;
+		// Load the image.
+		const uint32_t addr = be32_to_cpu(entry->offset) + this->data_offset;
+		length = be32_to_cpu(entry->length);
+		// Sanity check:
+		// - Size must be at least 16 bytes. [TODO: Smallest PNG?]
+		// - Size must be a maximum of 1 MB.
+		assert(length >= 16);
+		assert(length <= 1024*1024);
+		if (length < 16 || length > 1024*1024) {
+			// Size is out of range.
+			return nullptr;
+		}
+
+		png_buf.reset(new uint8_t[length]);
+		size_t size = file->seekAndRead(addr, png_buf.get(), length);
+		if (size != length) {
+			// Seek and/or read error.
+			return nullptr;
+		}
 	}
 
 	// Create a MemFile and decode the image.
@@ -782,12 +807,31 @@ rp_image *Xbox360_XDBF_Private::loadImage(uint64_t image_id)
 
 	if (img) {
 		// Save the image for later use.
-		map_images.emplace(image_id, img);
+		// If another thread loaded the same image in the meantime,
+		// use that one instead.
+		MutexLocker locker(imgMutex);
+		auto ret = map_images.emplace(image_id, img);
+		if (!ret.second) {
+			img->unref();
+			img = ret.first->second;
+		}
 	}
 
 	return img;
 }
 
+/**
+ * Load an image resource for a list data icon.
+ * Used as a RomFields::ListDataIcons loader function.
+ * @param userdata Xbox360_XDBF_Private
+ * @param image_id Image ID.
+ * @return Decoded image, or nullptr on error.
+ */
+const rp_image *Xbox360_XDBF_Private::loadImage_icon_cb(void *userdata, uint64_t image_id)
+{
+	return static_cast<Xbox360_XDBF_Private*>(userdata)->loadImage(image_id);
+}
+
 /**
  * Load the main title icon.
  * @return Icon, or nullptr on error.
@@ -1028,13 +1072,14 @@ int Xbox360_XDBF_Private::addFields_achievements_SPA(void)
 			? new RomFields::ListData_t(xach_count)
 			: nullptr;
 	}
-	auto vv_icons = new RomFields::ListDataIcons_t(xach_count);
-	auto icon_iter = vv_icons->begin();
-	for (unsigned int i = 0; p < p_end && i < xach_count; p++, i++, ++icon_iter) {
+	auto vv_icons = new RomFields::ListDataIcons_t(loadImage_icon_cb, this);
+	vv_icons->reserve(xach_count);
+	for (unsigned int i = 0; p < p_end && i < xach_count; p++, i++) {
 		// NOTE: Not deduplicating strings here.
 
 		// Icon
-		*icon_iter = loadImage(be32_to_cpu(p->image_id));
+		// NOTE: Icons are decoded on first access.
+		vv_icons->push_back_lazy(be32_to_cpu(p->image_id));
 
 		// Achievement IDs.
 		const uint16_t name_id = be16_to_cpu(p->name_id);
@@ -1240,13 +1285,14 @@ int Xbox360_XDBF_Private::addFields_avatarAwards_SPA(void)
 			? new RomFields::ListData_t(xgaa_count)
 			: nullptr;
 	}
-	auto vv_icons = new RomFields::ListDataIcons_t(xgaa_count);
-	auto icon_iter = vv_icons->begin();
-	for (unsigned int i = 0; p < p_end && i < xgaa_count; p++, i++, ++icon_iter) {
+	auto vv_icons = new RomFields::ListDataIcons_t(loadImage_icon_cb, this);
+	vv_icons->reserve(xgaa_count);
+	for (unsigned int i = 0; p < p_end && i < xgaa_count; p++, i++) {
 		// NOTE: Not deduplicating strings here.
 
 		// Icon
-		*icon_iter = loadImage(be32_to_cpu(p->image_id));
+		// NOTE: Icons are decoded on first access.
+		vv_icons->push_back_lazy(be32_to_cpu(p->image_id));
 
 		// Avatar award IDs.
 		const uint16_t name_id = be16_to_cpu(p->name_id);
@@ -1414,7 +1460,7 @@ int Xbox360_XDBF_Private::addFields_achievements_GPD(void)
 		"Xbox360_XDBF|Achievements", xach_col_names, ARRAY_SIZE(xach_col_names));
 
 	RomFields::ListData_t *vv_xach = new RomFields::ListData_t();
-	auto vv_icons = new RomFields::ListDataIcons_t();
+	auto vv_icons = new RomFields::ListDataIcons_t(loadImage_icon_cb, this);
 	vv_xach->reserve(16);
 	vv_icons->reserve(16);
 
@@ -1462,7 +1508,7 @@ int Xbox360_XDBF_Private::addFields_achievements_GPD(void)
 		// Icon.
 		// TODO: Grayscale version if locked?
 		// NOTE: Most GPDs don't have achievement icons...
-		vv_icons->push_back(loadImage(be32_to_cpu(pGPD->image_id)));
+		vv_icons->push_back_lazy(be32_to_cpu(pGPD->image_id));
 
 		// TODO: Localized numeric formatting?
 		char s_achievement_id[16];
@@ -164,11 +164,14 @@ class Xbox360_XEX_Private final : public RomDataPrivate
 		 * (low byte is between 0x02 and 0xFE), or have a size stored
 		 * at the beginning of the data (low byte == 0xFF).
 		 *
+		 * The data is allocated from the scratch arena, so callers
+		 * should use a ScratchArena::Scope to release it.
+		 *
 		 * @param header_id	[in] Optional header ID.
-		 * @param pVec		[out] ao::uvector<uint8_t>&
+		 * @param ppData	[out] Pointer to data (allocated from the scratch arena)
 		 * @return Number of bytes read on success; 0 on error.
 		 */
-		size_t getOptHdrData(uint32_t header_id, ao::uvector<uint8_t> &pVec);
+		size_t getOptHdrData(uint32_t header_id, const uint8_t **ppData);
 
 		/**
 		 * Get the resource information.
@@ -400,11 +403,14 @@ size_t Xbox360_XEX_Private::getOptHdrData(uint32_t header_id, uint32_t *pOut32)
  * (low byte is between 0x02 and 0xFE), or have a size stored
  * at the beginning of the data (low byte == 0xFF).
  *
+ * The data is allocated from the scratch arena, so callers
+ * should use a ScratchArena::Scope to release it.
+ *
  * @param header_id	[in] Optional header ID.
- * @param pVec		[out] ao::uvector<uint8_t>&
+ * @param ppData	[out] Pointer to data (allocated from the scratch arena)
  * @return Number of bytes read on success; 0 on error.
  */
-size_t Xbox360_XEX_Private::getOptHdrData(uint32_t header_id, ao::uvector<uint8_t> &pVec)
+size_t Xbox360_XEX_Private::getOptHdrData(uint32_t header_id, const uint8_t **ppData)
 {
 	assert((header_id & 0xFF) > 0x01);
 	if ((header_id & 0xFF) <= 0x01) {
@@ -442,12 +448,18 @@ size_t Xbox360_XEX_Private::getOptHdrData(uint32_t header_id, ao::uvector<uint8_
 
 	// Read the data.
 	// NOTE: This includes the size value for 0xFF structs.
-	pVec.resize(size);
-	size_t sz_read = file->seekAndRead(offset, pVec.data(), size);
+	// NOTE: Callers access the data as structs containing 32-bit
+	// fields, so it must be aligned for those fields.
+	uint8_t *const pData = static_cast<uint8_t*>(scratch.alloc(size, alignof(uint32_t)));
+	if (!pData) {
+		return 0;
+	}
+	size_t sz_read = file->seekAndRead(offset, pData, size);
 	if (sz_read != size) {
 		// Seek and/or read error.
 		return 0;
 	}
+	*ppData = pData;
 	return size;
 }
 
@@ -464,14 +476,16 @@ const XEX2_Resource_Info *Xbox360_XEX_Private::getXdbfResInfo(const char *resour
 	}
 
 	// General data buffer for loading optional headers.
-	ao::uvector<uint8_t> u8_data;
+	// NOTE: Allocated from the scratch arena.
+	ScratchArena::Scope scratchScope(scratch);
+	const uint8_t *u8_data = nullptr;
 
 	// Title ID is part of the execution ID, so load it if it
 	// hasn't been loaded already.
 	// Note that this is loaded even if we don't need the title ID,
 	// since other functions may need the execution ID.
 	if (!isExecutionIDLoaded) {
-		size_t size = getOptHdrData(XEX2_OPTHDR_EXECUTION_ID, u8_data);
+		size_t size = getOptHdrData(XEX2_OPTHDR_EXECUTION_ID, &u8_data);
 		if (size != sizeof(XEX2_Execution_ID)) {
 			// Unable to read the execution ID...
 			// Can't get the title ID.
@@ -479,7 +493,7 @@ const XEX2_Resource_Info *Xbox360_XEX_Private::getXdbfResInfo(const char *resour
 		}
 
 		const XEX2_Execution_ID *const pLdExecutionId =
-			reinterpret_cast<const XEX2_Execution_ID*>(u8_data.data());
+			reinterpret_cast<const XEX2_Execution_ID*>(u8_data);
 		executionID.media_id		= be32_to_cpu(pLdExecutionId->media_id);
 		executionID.version.u32		= be32_to_cpu(pLdExecutionId->version.u32);
 		executionID.base_version.u32	= be32_to_cpu(pLdExecutionId->base_version.u32);
@@ -504,7 +518,7 @@ const XEX2_Resource_Info *Xbox360_XEX_Private::getXdbfResInfo(const char *resour
 	}
 
 	// Get the resource information.
-	size_t size = getOptHdrData(XEX2_OPTHDR_RESOURCE_INFO, u8_data);
+	size_t size = getOptHdrData(XEX2_OPTHDR_RESOURCE_INFO, &u8_data);
 	if (size < sizeof(uint32_t) + sizeof(XEX2_Resource_Info)) {
 		// No resource information.
 		return nullptr;
@@ -522,7 +536,7 @@ const XEX2_Resource_Info *Xbox360_XEX_Private::getXdbfResInfo(const char *resour
 	res.vaddr = 0;
 	res.size = 0;
 	const XEX2_Resource_Info *p =
-		reinterpret_cast<const XEX2_Resource_Info*>(u8_data.data() + sizeof(uint32_t));
+		reinterpret_cast<const XEX2_Resource_Info*>(u8_data + sizeof(uint32_t));
 	for (unsigned int i = 0; i < res_count; i++, p++) {
 		// Using a string comparison, since the resource ID might not
 		// be the full 8 characters.
@@ -578,8 +592,9 @@ CBCReader *Xbox360_XEX_Private::initPeReader(void)
 	}
 
 	// Get the file format info.
-	ao::uvector<uint8_t> u8_ffi;
-	size_t size = getOptHdrData(XEX2_OPTHDR_FILE_FORMAT_INFO, u8_ffi);
+	ScratchArena::Scope scratchScope(scratch);
+	const uint8_t *u8_ffi = nullptr;
+	size_t size = getOptHdrData(XEX2_OPTHDR_FILE_FORMAT_INFO, &u8_ffi);
 	if (size < sizeof(fileFormatInfo)) {
 		// Seek and/or read error.
 		return nullptr;
@@ -587,7 +602,7 @@ CBCReader *Xbox360_XEX_Private::initPeReader(void)
 
 	// Copy the file format information.
 	const XEX2_File_Format_Info *const pLdFileFormatInfo =
-		reinterpret_cast<const XEX2_File_Format_Info*>(u8_ffi.data());
+		reinterpret_cast<const XEX2_File_Format_Info*>(u8_ffi);
 	fileFormatInfo.size             = be32_to_cpu(pLdFileFormatInfo->size);
 	fileFormatInfo.encryption_type  = be16_to_cpu(pLdFileFormatInfo->encryption_type);
 	fileFormatInfo.compression_type = be16_to_cpu(pLdFileFormatInfo->compression_type);
@@ -730,7 +745,7 @@ CBCReader *Xbox360_XEX_Private::initPeReader(void)
 			uint32_t vaddr = 0, physaddr = 0;
 			basicZDataSegments.resize(seg_len);
 			const XEX2_Compression_Basic_Info *p =
-				reinterpret_cast<const XEX2_Compression_Basic_Info*>(u8_ffi.data() + sizeof(XEX2_File_Format_Info));
+				reinterpret_cast<const XEX2_Compression_Basic_Info*>(u8_ffi + sizeof(XEX2_File_Format_Info));
 			for (unsigned int i = 0; i < seg_count; i++, p++) {
 				const uint32_t data_size = be32_to_cpu(p->data_size);
 				basicZDataSegments[i].vaddr = vaddr;
@@ -773,7 +788,7 @@ CBCReader *Xbox360_XEX_Private::initPeReader(void)
 			// NOTE: Technically part of XEX2_Compression_Normal_Header,
 			// but we're not using that in order to be
 			// able to swap lzx_blocks.
-			const uint8_t *p = u8_ffi.data() + sizeof(fileFormatInfo);
+			const uint8_t *p = u8_ffi + sizeof(fileFormatInfo);
 			const uint32_t *const pWindowSize =
 				reinterpret_cast<const uint32_t*>(p);
 			const uint32_t window_size = be32_to_cpu(*pWindowSize);
@@ -1161,19 +1176,20 @@ Xbox360_Version_t Xbox360_XEX_Private::getMinKernelVersion(void)
 
 	// Minimum kernel version is determined by checking the
 	// import libraries and taking the maximum version.
-	ao::uvector<uint8_t> u8_implib;
-	size_t size = getOptHdrData(XEX2_OPTHDR_IMPORT_LIBRARIES, u8_implib);
+	ScratchArena::Scope scratchScope(scratch);
+	const uint8_t *u8_implib = nullptr;
+	size_t size = getOptHdrData(XEX2_OPTHDR_IMPORT_LIBRARIES, &u8_implib);
 	if (size < sizeof(XEX2_Import_Libraries_Header) + (sizeof(XEX2_Import_Library_Entry) * 2)) {
 		// Too small...
 		return rver;
 	}
 
 	const XEX2_Import_Libraries_Header *const pLibHdr =
-		reinterpret_cast<const XEX2_Import_Libraries_Header*>(u8_implib.data());
+		reinterpret_cast<const XEX2_Import_Libraries_Header*>(u8_implib);
 
 	// Pointers
-	const uint8_t *p = u8_implib.data();
-	const uint8_t *const p_end = p + u8_implib.size();
+	const uint8_t *p = u8_implib;
+	const uint8_t *const p_end = p + size;
 
 	// Skip the string table.
 	p += sizeof(*pLibHdr) + be32_to_cpu(pLibHdr->str_tbl_size);
@@ -1668,8 +1684,10 @@ int Xbox360_XEX::loadFieldData(void)
 	}
 
 	// Original executable name
-	ao::uvector<uint8_t> u8_data;
-	size_t size = d->getOptHdrData(XEX2_OPTHDR_ORIGINAL_PE_NAME, u8_data);
+	// NOTE: Optional header data is allocated from the scratch arena.
+	ScratchArena::Scope scratchScope(d->scratch);
+	const uint8_t *u8_data = nullptr;
+	size_t size = d->getOptHdrData(XEX2_OPTHDR_ORIGINAL_PE_NAME, &u8_data);
 	if (size > sizeof(uint32_t)) {
 		// Sanity check: Must be less than 260 bytes. (PATH_MAX)
 		assert(size <= 260+sizeof(uint32_t));
@@ -1680,7 +1698,7 @@ int Xbox360_XEX::loadFieldData(void)
 			int len = static_cast<int>(size - sizeof(uint32_t));
 			d->fields.addField_string(C_("Xbox360_XEX", "PE Filename"),
 				cp1252_to_utf8(reinterpret_cast<const char*>(
-					u8_data.data() + sizeof(uint32_t)), len),
+					u8_data + sizeof(uint32_t)), len),
 				RomFields::STRF_TRIM_END);
 		}
 	}
@@ -1848,10 +1866,10 @@ int Xbox360_XEX::loadFieldData(void)
 		RomFields::STRF_MONOSPACE);
 
 	// Disc Profile ID
-	size = d->getOptHdrData(XEX2_OPTHDR_DISC_PROFILE_ID, u8_data);
+	size = d->getOptHdrData(XEX2_OPTHDR_DISC_PROFILE_ID, &u8_data);
 	if (size == 16) {
 		d->fields.addField_string(C_("Xbox360_XEX", "Disc Profile ID"),
-			d->formatMediaID(u8_data.data()),
+			d->formatMediaID(u8_data),
 			RomFields::STRF_MONOSPACE);
 	}
 
@@ -1957,10 +1975,10 @@ int Xbox360_XEX::loadFieldData(void)
 	// Nintendo's systems. For Xbox 360, we'll need to convert the format.
 	// NOTE: The actual game ratings field is 64 bytes, but only the first
 	// 14 bytes are actually used.
-	size = d->getOptHdrData(XEX2_OPTHDR_GAME_RATINGS, u8_data);
+	size = d->getOptHdrData(XEX2_OPTHDR_GAME_RATINGS, &u8_data);
 	if (size >= sizeof(XEX2_Game_Ratings)) {
 		const XEX2_Game_Ratings *const pLdGameRatings =
-			reinterpret_cast<const XEX2_Game_Ratings*>(u8_data.data());
+			reinterpret_cast<const XEX2_Game_Ratings*>(u8_data);
 
 		// Convert the game ratings.
 		RomFields::age_ratings_t age_ratings;
@@ -909,4 +909,18 @@ int XboxDisc::checkViewedAchievements(void) const
 	return exe->checkViewedAchievements();
 }
 
+/**
+ * Open the partition that contains the main file system.
+ * For Xbox and Xbox 360 discs, this is the XDVDFS partition.
+ * @return IPartition with a file system table, or nullptr if not supported. (Caller must unref() it.)
+ */
+IPartition *XboxDisc::openFstPartition(void)
+{
+	RP_D(XboxDisc);
+	if (!d->isValid || !d->xdvdfsPartition || !d->xdvdfsPartition->isOpen()) {
+		return nullptr;
+	}
+	return d->xdvdfsPartition->RefBase::ref<IPartition>();
+}
+
 }
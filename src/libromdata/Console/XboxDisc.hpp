@@ -20,6 +20,7 @@ ROMDATA_DECL_IMGSUPPORT()
 ROMDATA_DECL_IMGPF()
 ROMDATA_DECL_IMGINT()
 ROMDATA_DECL_VIEWED_ACHIEVEMENTS()
+ROMDATA_DECL_FST_PARTITION()
 
 	public:
 		/**
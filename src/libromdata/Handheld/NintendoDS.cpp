@@ -145,6 +145,92 @@ int NintendoDSPrivate::loadIconTitleData(void)
 	return 0;
 }
 
+/**
+ * DSi animated icon data.
+ * Frames are decoded on first access.
+ */
+class NintendoDSIconAnimData : public IconAnimData
+{
+	public:
+		explicit NintendoDSIconAnimData(const NDS_IconTitleData *nds_icon_title)
+		{
+			memcpy(dsi_icon_data, nds_icon_title->dsi_icon_data, sizeof(dsi_icon_data));
+			memcpy(dsi_icon_pal, nds_icon_title->dsi_icon_pal, sizeof(dsi_icon_pal));
+			tokens.fill(0);
+		}
+
+	public:
+		// DSi icon bitmaps and palettes.
+		uint8_t dsi_icon_data[8][0x200];
+		uint16_t dsi_icon_pal[8][0x10];
+
+		// High byte of the sequence token for each frame.
+		// - 7:   V flip
+		// - 6:   H flip
+		// - 5-3: Palette index.
+		// - 2-0: Bitmap index.
+		array<uint8_t, MAX_FRAMES> tokens;
+
+		/**
+		 * Find an existing frame with identical bitmap, palette, and flip bits.
+		 * Some DSi icons use multiple bitmap and/or palette slots
+		 * with the same data, so these can share a single frame.
+		 * @param high_token High byte of the sequence token
+		 * @param count Number of frames added so far
+		 * @return Frame index, or -1 if not found.
+		 */
+		int findFrame(uint8_t high_token, int count) const
+		{
+			const uint8_t bmp = (high_token & 7);
+			const uint8_t pal = (high_token >> 3) & 7;
+			for (int i = 0; i < count; i++) {
+				const uint8_t cmp_token = tokens[i];
+				if ((cmp_token & (3U << 6)) != (high_token & (3U << 6)))
+					continue;
+				const uint8_t cmp_bmp = (cmp_token & 7);
+				const uint8_t cmp_pal = (cmp_token >> 3) & 7;
+				if ((cmp_bmp == bmp || !memcmp(dsi_icon_data[cmp_bmp], dsi_icon_data[bmp], sizeof(dsi_icon_data[bmp]))) &&
+				    (cmp_pal == pal || !memcmp(dsi_icon_pal[cmp_pal], dsi_icon_pal[pal], sizeof(dsi_icon_pal[pal]))))
+				{
+					return i;
+				}
+			}
+			return -1;
+		}
+
+	protected:
+		/**
+		 * Decode a frame.
+		 * @param idx Frame index
+		 * @return Decoded frame (ref()'d), or nullptr on error.
+		 */
+		rp_image *decodeFrame(int idx) const final
+		{
+			const uint8_t high_token = tokens[idx];
+			const uint8_t bmp = (high_token & 7);
+			const uint8_t pal = (high_token >> 3) & 7;
+			rp_image *img = ImageDecoder::fromNDS_CI4(32, 32,
+				dsi_icon_data[bmp], sizeof(dsi_icon_data[bmp]),
+				dsi_icon_pal[pal], sizeof(dsi_icon_pal[pal]));
+			if (img && (high_token & (3U << 6))) {
+				// At least one flip bit is set.
+				rp_image::FlipOp flipOp = rp_image::FLIP_NONE;
+				if (high_token & (1U << 6)) {
+					// H-flip
+					flipOp = rp_image::FLIP_H;
+				}
+				if (high_token & (1U << 7)) {
+					// V-flip
+					flipOp = static_cast<rp_image::FlipOp>(flipOp | rp_image::FLIP_V);
+				}
+				rp_image *const flipimg = img->flip(flipOp);
+				img->unref();
+				img = flipimg;
+			}
+			return img;
+		}
+};
+
 /**
  * Load the ROM image's icon.
  * @return Icon, or nullptr on error.
@@ -166,11 +252,6 @@ const rp_image *NintendoDSPrivate::loadIcon(void)
 		return nullptr;
 	}
 
-	// Load the icon data.
-	// TODO: Only read the first frame unless specifically requested?
-	this->iconAnimData = new IconAnimData();
-	iconAnimData->count = 0;
-
 	// Check if a DSi animated icon is present.
 	// TODO: Some configuration option to return the standard
 	// NDS icon for the standard icon instead of the first frame
@@ -180,6 +261,7 @@ const rp_image *NintendoDSPrivate::loadIcon(void)
 	{
 		// Either this isn't a DSi icon/title struct (pre-v0103),
 		// or the animated icon sequence is invalid.
+		this->iconAnimData = new IconAnimData();
 
 		// Convert the NDS icon to rp_image.
 		iconAnimData->frames[0] = ImageDecoder::fromNDS_CI4(32, 32,
@@ -188,6 +270,10 @@ const rp_image *NintendoDSPrivate::loadIcon(void)
 		iconAnimData->count = 1;
 	} else {
 		// Animated icon is present.
+		// Frames will be decoded on first access, so static
+		// thumbnails only need to decode the first frame.
+		NintendoDSIconAnimData *const dsiIconAnimData = new NintendoDSIconAnimData(&nds_icon_title);
+		this->iconAnimData = dsiIconAnimData;
 
 		// Maximum number of combinations based on bitmap index,
 		// palette index, and flip bits is 256. We don't want to
@@ -226,30 +312,17 @@ const rp_image *NintendoDSPrivate::loadIcon(void)
 			// of 64 bitmaps.
 			uint8_t high_token = (seq >> 8);
 			if (arr_bmpUsed[high_token] == 0xFF) {
-				// Not used yet. Create the bitmap.
-				const uint8_t bmp = (high_token & 7);
-				const uint8_t pal = (high_token >> 3) & 7;
-				rp_image *img = ImageDecoder::fromNDS_CI4(32, 32,
-					nds_icon_title.dsi_icon_data[bmp],
-					sizeof(nds_icon_title.dsi_icon_data[bmp]),
-					nds_icon_title.dsi_icon_pal[pal],
-					sizeof(nds_icon_title.dsi_icon_pal[pal]));
-				if (high_token & (3U << 6)) {
-					// At least one flip bit is set.
-					rp_image::FlipOp flipOp = rp_image::FLIP_NONE;
-					if (high_token & (1U << 6)) {
-						// H-flip
-						flipOp = rp_image::FLIP_H;
-					}
-					if (high_token & (1U << 7)) {
-						// V-flip
-						flipOp = static_cast<rp_image::FlipOp>(flipOp | rp_image::FLIP_V);
-					}
-					rp_image *const flipimg = img->flip(flipOp);
-					img->unref();
-					img = flipimg;
+				// Not used yet. Check if an existing frame has
+				// identical bitmap and palette data.
+				const int match = dsiIconAnimData->findFrame(high_token, bmp_idx);
+				if (match >= 0) {
+					arr_bmpUsed[high_token] = static_cast<uint8_t>(match);
 				}
-				iconAnimData->frames[bmp_idx] = img;
+			}
+			if (arr_bmpUsed[high_token] == 0xFF) {
+				// Not used yet. Add the bitmap.
+				dsiIconAnimData->tokens[bmp_idx] = high_token;
+				dsiIconAnimData->frame_pending[bmp_idx] = true;
 				arr_bmpUsed[high_token] = bmp_idx;
 				bmp_idx++;
 			}
@@ -267,7 +340,7 @@ const rp_image *NintendoDSPrivate::loadIcon(void)
 	// if iconAnimData is nullptr.
 
 	// Return a pointer to the first frame.
-	icon_first_frame = iconAnimData->frames[iconAnimData->seq_index[0]];
+	icon_first_frame = iconAnimData->frame(iconAnimData->seq_index[0]);
 	return icon_first_frame;
 }
 
@@ -676,4 +676,32 @@ int PSP::loadMetaData(void)
 	return static_cast<int>(d->metaData->count());
 }
 
+/**
+ * Open the logical ROM image for reading.
+ * For CISO/ZISO/JISO/DAX images, this is the decompressed ISO image.
+ * @return IDiscReader for the logical ROM image, or nullptr on error. (Caller must unref() it.)
+ */
+IDiscReader *PSP::openLogicalImage(void)
+{
+	RP_D(PSP);
+	if (!d->discReader || !d->discReader->isOpen()) {
+		return nullptr;
+	}
+	return d->discReader->ref();
+}
+
+/**
+ * Open the partition that contains the main file system.
+ * For PSP UMDs, this is the ISO-9660 partition.
+ * @return IPartition with a file system table, or nullptr if not supported. (Caller must unref() it.)
+ */
+IPartition *PSP::openFstPartition(void)
+{
+	RP_D(PSP);
+	if (!d->isValid || !d->isoPartition || !d->isoPartition->isOpen()) {
+		return nullptr;
+	}
+	return d->isoPartition->RefBase::ref<IPartition>();
+}
+
 }
@@ -28,6 +28,8 @@ ROMDATA_DECL_CLOSE()
 ROMDATA_DECL_METADATA()
 ROMDATA_DECL_IMGSUPPORT()
 ROMDATA_DECL_IMGINT()
+ROMDATA_DECL_LOGICAL_IMAGE()
+ROMDATA_DECL_FST_PARTITION()
 ROMDATA_DECL_END()
 
 }
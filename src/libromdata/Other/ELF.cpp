@@ -196,7 +196,7 @@ class ELFPrivate final : public RomDataPrivate
 		 * @param out The output vector. Its size determines how much data is read.
 		 * @return 0 on success; non-zero on error.
 		 */
-		int readDataAtVA(uint64_t vaddr, ao::uvector<uint8_t> &out);
+		int readDataAtVA(uint64_t vaddr, uint8_t *out, size_t size);
 
 		/**
 		 * Add PT_DYNAMIC fields.
@@ -742,13 +742,14 @@ int ELFPrivate::checkSectionHeaders(void)
 /**
  * Read data at a given VA. The data must be in a single PT_LOAD segment.
  * @param vaddr The virtual address
- * @param out The output vector. Its size determines how much data is read.
+ * @param out The output buffer.
+ * @param size Amount of data to read.
  * @return 0 on success; non-zero on error.
  */
-int ELFPrivate::readDataAtVA(uint64_t vaddr, ao::uvector<uint8_t> &out)
+int ELFPrivate::readDataAtVA(uint64_t vaddr, uint8_t *out, size_t size)
 {
 	// Find the segment
-	const uint64_t vend = vaddr + out.size();
+	const uint64_t vend = vaddr + size;
 	auto it = std::upper_bound(pt_load.begin(), pt_load.end(), vaddr,
 		[](uint64_t lhs, const Elf64_Phdr &rhs) noexcept -> bool {
 			return lhs < (uint64_t)rhs.p_vaddr;
@@ -763,9 +764,9 @@ int ELFPrivate::readDataAtVA(uint64_t vaddr, ao::uvector<uint8_t> &out)
 	if (sstart <= vaddr && vaddr <= send && sstart <= vend && vend <= send) {
 		// Read data
 		vaddr += it->p_offset - it->p_vaddr;
-		size_t size = file->seekAndRead(vaddr, out.data(), out.size());
-		assert(size == out.size());
-		if (size != out.size()) {
+		const size_t nread = file->seekAndRead(vaddr, out, size);
+		assert(nread == size);
+		if (nread != size) {
 			return -EIO;
 		}
 		return 0;
@@ -793,14 +794,23 @@ int ELFPrivate::addPtDynamicFields(void)
 		return -2;
 	}
 
+	// Temporary buffers are released when this function returns.
+	ScratchArena::Scope scratchScope(scratch);
+
 	// Read the header.
-	ao::uvector<uint8_t> pt_dyn_buf;
-	pt_dyn_buf.resize(static_cast<unsigned int>(pt_dynamic.p_filesz));
-	size_t size = file->seekAndRead(pt_dynamic.p_offset, pt_dyn_buf.data(), pt_dyn_buf.size());
-	if (size != pt_dyn_buf.size()) {
+	// NOTE: The buffer is accessed as an array of Elf64_Dyn or Elf32_Dyn,
+	// so it must be aligned for those structs.
+	const size_t pt_dyn_size = static_cast<size_t>(pt_dynamic.p_filesz);
+	uint8_t *const pt_dyn_data = static_cast<uint8_t*>(scratch.alloc(pt_dyn_size, alignof(Elf64_Dyn)));
+	if (!pt_dyn_data) {
+		return -ENOMEM;
+	}
+	size_t size = file->seekAndRead(pt_dynamic.p_offset, pt_dyn_data, pt_dyn_size);
+	if (size != pt_dyn_size) {
 		// Read error.
 		return -3;
 	}
+	const span<const uint8_t> pt_dyn_buf(pt_dyn_data, pt_dyn_size);
 
 	// Process headers.
 	// NOTE: Separate loops for 32-bit vs. 64-bit.
@@ -847,17 +857,17 @@ int ELFPrivate::addPtDynamicFields(void)
 				break;
 	}
 
-	ao::uvector<uint8_t> strtab_buf;
 	span<const char> strtab;
 	assert(val_dtag[DT_STRSZ] < 1*1024*1024);
-	if (has_dtag[DT_STRTAB] && has_dtag[DT_STRSZ] && val_dtag[DT_STRSZ] < 1*1024*1024) {
-		strtab_buf.resize(val_dtag[DT_STRSZ]);
-		if (readDataAtVA(val_dtag[DT_STRTAB], strtab_buf) == 0) {
+	if (has_dtag[DT_STRTAB] && has_dtag[DT_STRSZ] && val_dtag[DT_STRSZ] > 0 && val_dtag[DT_STRSZ] < 1*1024*1024) {
+		const size_t strtab_size = static_cast<size_t>(val_dtag[DT_STRSZ]);
+		char *const strtab_buf = scratch.alloc_array<char>(strtab_size);
+		if (strtab_buf && readDataAtVA(val_dtag[DT_STRTAB], reinterpret_cast<uint8_t*>(strtab_buf), strtab_size) == 0) {
 			// The first the last byte of the string table MUST be zero.
 			// This is pretty nice, because it simplifies the checks later on.
-			assert(!strtab_buf.empty() && strtab_buf[0] == 0 && strtab_buf[strtab_buf.size()-1] == 0);
-			if (!strtab_buf.empty() && strtab_buf[0] == 0 && strtab_buf[strtab_buf.size()-1] == 0) {
-				strtab = reinterpret_span<const char>(strtab_buf);
+			assert(strtab_buf[0] == 0 && strtab_buf[strtab_size-1] == 0);
+			if (strtab_buf[0] == 0 && strtab_buf[strtab_size-1] == 0) {
+				strtab = span<const char>(strtab_buf, strtab_size);
 			}
 		}
 	}
@@ -949,6 +959,8 @@ int ELFPrivate::addPtDynamicFields(void)
 
 /**
  * Read an ELF symbol.
+ * NOTE: sh_entsize might not be a multiple of the symbol's
+ * alignment, so the symbol is copied instead of cast.
  * @param sbuf	[in] Pointer to symbol.
  * @return Symbol information.
  */
@@ -956,23 +968,25 @@ Elf64_Sym ELFPrivate::readSymbol(const uint8_t *sbuf)
 {
 	Elf64_Sym out;
 	if (Elf_Header.primary.e_class == ELFCLASS64) {
-		const Elf64_Sym *const sym = reinterpret_cast<const Elf64_Sym *>(sbuf);
+		Elf64_Sym sym;
+		memcpy(&sym, sbuf, sizeof(sym));
 		if (Elf_Header.primary.e_data == ELFDATAHOST)
-			return *sym;
-		out.st_name = elf32_to_cpu(sym->st_name);
-		out.st_info = sym->st_info;
-		out.st_other = sym->st_other;
-		out.st_shndx = elf16_to_cpu(sym->st_shndx);
-		out.st_value = elf64_to_cpu(sym->st_value);
-		out.st_size = elf64_to_cpu(sym->st_size);
+			return sym;
+		out.st_name = elf32_to_cpu(sym.st_name);
+		out.st_info = sym.st_info;
+		out.st_other = sym.st_other;
+		out.st_shndx = elf16_to_cpu(sym.st_shndx);
+		out.st_value = elf64_to_cpu(sym.st_value);
+		out.st_size = elf64_to_cpu(sym.st_size);
 	} else {
-		const Elf32_Sym *const sym = reinterpret_cast<const Elf32_Sym *>(sbuf);
-		out.st_name = elf32_to_cpu(sym->st_name);
-		out.st_info = sym->st_info;
-		out.st_other = sym->st_other;
-		out.st_shndx = elf16_to_cpu(sym->st_shndx);
-		out.st_value = elf32_to_cpu(sym->st_value);
-		out.st_size = elf32_to_cpu(sym->st_size);
+		Elf32_Sym sym;
+		memcpy(&sym, sbuf, sizeof(sym));
+		out.st_name = elf32_to_cpu(sym.st_name);
+		out.st_info = sym.st_info;
+		out.st_other = sym.st_other;
+		out.st_shndx = elf16_to_cpu(sym.st_shndx);
+		out.st_value = elf32_to_cpu(sym.st_value);
+		out.st_size = elf32_to_cpu(sym.st_size);
 	}
 	return out;
 }
@@ -1004,18 +1018,23 @@ int ELFPrivate::addSymbolFields(span<const char> dynsym_strtab)
 	 */
 
 	auto parse_symtab = [this](vector<Elf64_Sym> &out, const symtab_info_t &info) -> void {
-		ao::uvector<uint8_t> buf;
 		if (info.size == 0 || info.size > 1*1024*1024)
 			return;
 		if (info.entsize < (Elf_Header.primary.e_class == ELFCLASS64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym)))
 			return;
-		buf.resize(info.size/info.entsize*info.entsize);
-		size_t nread = file->seekAndRead(info.offset, buf.data(), buf.size());
-		assert(nread == buf.size());
-		if (nread != buf.size())
+
+		// The symbol table is only needed until it's parsed.
+		ScratchArena::Scope scratchScope(scratch);
+		const size_t buf_size = static_cast<size_t>(info.size/info.entsize*info.entsize);
+		uint8_t *const buf = static_cast<uint8_t*>(scratch.alloc(buf_size, alignof(Elf64_Sym)));
+		if (!buf)
 			return;
-		out.reserve(buf.size()/info.entsize);
-		for (uint8_t *p = buf.data(); p < buf.data() + buf.size(); p += info.entsize)
+		size_t nread = file->seekAndRead(info.offset, buf, buf_size);
+		assert(nread == buf_size);
+		if (nread != buf_size)
+			return;
+		out.reserve(buf_size/info.entsize);
+		for (const uint8_t *p = buf; p < buf + buf_size; p += info.entsize)
 			out.push_back(readSymbol(p));
 	};
 
@@ -1108,16 +1127,19 @@ int ELFPrivate::addSymbolFields(span<const char> dynsym_strtab)
 		fields.addField_listData(name, &params);
 	};
 
-	auto read_strtab = [this](ao::uvector<uint8_t> &buf, const symtab_info_t &info) -> span<const char> {
+	auto read_strtab = [this](const symtab_info_t &info) -> span<const char> {
 		if (info.strtab_size == 0 || info.strtab_size > 1*1024*1024)
 			return span<const char>();
-		buf.resize(info.strtab_size);
-		size_t nread = file->seekAndRead(info.strtab_offset, buf.data(), buf.size());
-		assert(nread == buf.size());
-		if (nread == buf.size()) {
-			assert(buf[0] == 0 && buf[buf.size()-1] == 0);
-			if (buf[0] == 0 && buf[buf.size()-1] == 0) {
-				return reinterpret_span<const char>(buf);
+		const size_t buf_size = static_cast<size_t>(info.strtab_size);
+		char *const buf = scratch.alloc_array<char>(buf_size);
+		if (!buf)
+			return span<const char>();
+		size_t nread = file->seekAndRead(info.strtab_offset, buf, buf_size);
+		assert(nread == buf_size);
+		if (nread == buf_size) {
+			assert(buf[0] == 0 && buf[buf_size-1] == 0);
+			if (buf[0] == 0 && buf[buf_size-1] == 0) {
+				return span<const char>(buf, buf_size);
 			}
 		}
 
@@ -1125,10 +1147,11 @@ int ELFPrivate::addSymbolFields(span<const char> dynsym_strtab)
 		return span<const char>();
 	};
 
-	ao::uvector<uint8_t> symtab_buf, dynsym_buf;
-	add_symbol_tab("SHT_SYMTAB", sht_symtab, read_strtab(symtab_buf, sht_symtab));
+	// String tables are released when this function returns.
+	ScratchArena::Scope scratchScope(scratch);
+	add_symbol_tab("SHT_SYMTAB", sht_symtab, read_strtab(sht_symtab));
 	if (dynsym_strtab.size() == 0) {
-		dynsym_strtab = read_strtab(dynsym_buf, sht_dynsym);
+		dynsym_strtab = read_strtab(sht_dynsym);
 	}
 	add_symbol_tab("SHT_DYNSYM", sht_dynsym, dynsym_strtab);
 
@@ -200,11 +200,11 @@ int EXEPrivate::loadPEResourceTypes(void)
  * @param type One of IMAGE_DATA_DIRECTORY_{EXPORT,IMPORT}_TABLE
  * @param minSize Minimum direcrory size
  * @param maxSize Maximum directory size
- * @param dirTbl Vector into which the directory will be read.
+ * @param dirTbl Directory data. (allocated from the scratch arena)
  * @return 0 on success; negative POSIX error code on error.
  */
 int EXEPrivate::readPEImpExpDir(IMAGE_DATA_DIRECTORY &dataDir, int type,
-	size_t minSize, size_t maxSize, ao::uvector<uint8_t> &dirTbl)
+	size_t minSize, size_t maxSize, vhvc::span<const uint8_t> &dirTbl)
 {
 	if (!file || !file->isOpen()) {
 		// File isn't open.
@@ -258,12 +258,19 @@ int EXEPrivate::readPEImpExpDir(IMAGE_DATA_DIRECTORY &dataDir, int type,
 	}
 
 	// Load the import/export directory table.
-	dirTbl.resize(dataDir.Size);
-	size_t size = file->seekAndRead(tbl_paddr, dirTbl.data(), dirTbl.size());
-	if (size != dirTbl.size()) {
+	// NOTE: The table is accessed as IMAGE_IMPORT_DIRECTORY or
+	// IMAGE_EXPORT_DIRECTORY, so it must be aligned for those structs.
+	uint8_t *const pDirTbl = static_cast<uint8_t*>(scratch.alloc(dataDir.Size,
+		std::max(alignof(IMAGE_IMPORT_DIRECTORY), alignof(IMAGE_EXPORT_DIRECTORY))));
+	if (!pDirTbl) {
+		return -ENOMEM;
+	}
+	size_t size = file->seekAndRead(tbl_paddr, pDirTbl, dataDir.Size);
+	if (size != dataDir.Size) {
 		// Seek and/or read error.
 		return -EIO;
 	}
+	dirTbl = vhvc::span<const uint8_t>(pDirTbl, size);
 	return 0;
 }
 
@@ -280,12 +287,12 @@ int EXEPrivate::readPEImpExpDir(IMAGE_DATA_DIRECTORY &dataDir, int type,
  * @param minExtra Last string must be at least this long.
  * @param minMax The minimum size of the block must be smaller than this.
  * @param maxExtra How many extra bytes can be read.
- * @param outPtr Resulting array.
+ * @param outPtr Resulting array. (allocated from the scratch arena)
  * @param outSize How much data was read.
  * @return 0 on success; negative POSIX error code on error.
  */
 int EXEPrivate::readPENullBlock(uint32_t low, uint32_t high, uint32_t minExtra,
-	uint32_t minMax, uint32_t maxExtra, std::unique_ptr<char[]> &outPtr,
+	uint32_t minMax, uint32_t maxExtra, char *&outPtr,
 	size_t &outSize)
 {
 	const uint32_t sizeMin = high - low + minExtra;
@@ -299,8 +306,11 @@ int EXEPrivate::readPENullBlock(uint32_t low, uint32_t high, uint32_t minExtra,
 	}
 
 	const uint32_t sizeMax = sizeMin + maxExtra;
-	outPtr.reset(new char[sizeMax]);
-	outSize = file->seekAndRead(paddr, reinterpret_cast<uint8_t*>(outPtr.get()), sizeMax);
+	outPtr = scratch.alloc_array<char>(sizeMax);
+	if (!outPtr) {
+		return -ENOMEM;
+	}
+	outSize = file->seekAndRead(paddr, outPtr, sizeMax);
 	if (outSize < sizeMin || outSize > sizeMax) {
 		// Seek and/or read error.
 		return -EIO;
@@ -329,8 +339,11 @@ int EXEPrivate::readPEImportDir(void)
 	// table size might not be an exact multiple of
 	// IMAGE_IMPORT_DIRECTORY in the former case.
 
+	// Temporary buffers are released when this function returns.
+	ScratchArena::Scope scratchScope(scratch);
+
 	IMAGE_DATA_DIRECTORY dataDir;
-	ao::uvector<uint8_t> impDirTbl;
+	vhvc::span<const uint8_t> impDirTbl;
 	int res = readPEImpExpDir(dataDir, IMAGE_DATA_DIRECTORY_IMPORT_TABLE,
 		sizeof(IMAGE_IMPORT_DIRECTORY), 4*1024*1024, impDirTbl);
 	if (res)
@@ -361,7 +374,7 @@ int EXEPrivate::readPEImportDir(void)
 		return -ENOENT;
 	}
 
-	unique_ptr<char[]> dll_name_data;
+	char *dll_name_data = nullptr;
 	size_t dll_size_read;
 	// NOTE: Since the DLL names are NULL-terminated, we'll have to guess
 	// with the last one. It's unlikely that it'll be at EOF, but we'll
@@ -786,8 +799,11 @@ void EXEPrivate::addFields_PE(void)
  */
 int EXEPrivate::addFields_PE_Export(void)
 {
+	// Temporary buffers are released when this function returns.
+	ScratchArena::Scope scratchScope(scratch);
+
 	IMAGE_DATA_DIRECTORY dataDir;
-	ao::uvector<uint8_t> expDirTbl;
+	vhvc::span<const uint8_t> expDirTbl;
 
 	int res = readPEImpExpDir(dataDir, IMAGE_DATA_DIRECTORY_EXPORT_TABLE,
 		sizeof(IMAGE_EXPORT_DIRECTORY), 4*1024*1024, expDirTbl);
@@ -803,7 +819,7 @@ int EXEPrivate::addFields_PE_Export(void)
 	// the export directory.
 	const uint32_t rvaMin = dataDir.VirtualAddress;
 	const uint32_t rvaMax = dataDir.VirtualAddress + dataDir.Size;
-	auto checkBounds = [&](uint32_t rva, uint32_t size) -> void * {
+	auto checkBounds = [&](uint32_t rva, uint32_t size) -> const void * {
 		if (rva < rvaMin || rva > rvaMax)
 			return nullptr;
 		if (rva+size < rvaMin || rva+size > rvaMax)
@@ -898,11 +914,14 @@ int EXEPrivate::addFields_PE_Export(void)
 	 * in ordinal order, followed by named symbols in lexicographic order.
 	 * ...unless your names aren't sorted, in which case your DLL is broken.
 	 * NOTE: ExportEntry is 80 bytes on 64-bit, so we'll use a sort index map. */
-	std::unique_ptr<unsigned int[]> sortIndexMap(new unsigned int[ents.size()]);
-	const auto sortIndexMap_end = sortIndexMap.get() + ents.size();
-	std::iota(sortIndexMap.get(), sortIndexMap_end, 0);
+	unsigned int *const sortIndexMap = scratch.alloc_array<unsigned int>(ents.size());
+	if (!sortIndexMap) {
+		return -ENOMEM;
+	}
+	const auto sortIndexMap_end = sortIndexMap + ents.size();
+	std::iota(sortIndexMap, sortIndexMap_end, 0);
 
-	std::sort(sortIndexMap.get(), sortIndexMap_end,
+	std::sort(sortIndexMap, sortIndexMap_end,
 		[&ents](unsigned int idx_lhs, unsigned int idx_rhs) -> bool {
 			const ExportEntry &lhs = ents[idx_lhs];
 			const ExportEntry &rhs = ents[idx_rhs];
@@ -980,7 +999,10 @@ int EXEPrivate::addFields_PE_Import(void)
 	if (res)
 		return res;
 
-	unique_ptr<char[]> dll_ilt_data;
+	// Temporary buffers are released when this function returns.
+	ScratchArena::Scope scratchScope(scratch);
+
+	char *dll_ilt_data = nullptr;
 	uint32_t dll_ilt_base;
 	size_t dll_ilt_read;
 	// Read Import Lookup Table
@@ -1024,7 +1046,7 @@ int EXEPrivate::addFields_PE_Import(void)
 	}
 
 	// Iterator for import entries
-	const uint32_t *ilt_buf = reinterpret_cast<const uint32_t*>(dll_ilt_data.get());
+	const uint32_t *ilt_buf = reinterpret_cast<const uint32_t*>(dll_ilt_data);
 	const uint32_t *ilt_end;
 	if (is64)
 		ilt_end = ilt_buf + dll_ilt_read/8*2;
@@ -1073,7 +1095,7 @@ int EXEPrivate::addFields_PE_Import(void)
 	};
 
 	// Read Name/Hint Table
-	unique_ptr<char[]> dll_hint_data;
+	char *dll_hint_data = nullptr;
 	uint32_t dll_hint_base;
 	size_t dll_hint_read;
 	int import_count = 0;
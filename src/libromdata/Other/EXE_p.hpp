@@ -217,11 +217,11 @@ class EXEPrivate final : public LibRpBase::RomDataPrivate
 		 * @param type One of IMAGE_DATA_DIRECTORY_{EXPORT,IMPORT}_TABLE
 		 * @param minSize Minimum direcrory size
 		 * @param maxSize Maximum directory size
-		 * @param dirTbl Vector into which the directory will be read.
+		 * @param dirTbl Directory data. (allocated from the scratch arena)
 		 * @return 0 on success; negative POSIX error code on error.
 		 */
 		int readPEImpExpDir(IMAGE_DATA_DIRECTORY &dataDir, int type,
-			size_t minSize, size_t maxSize, ao::uvector<uint8_t> &dirTbl);
+			size_t minSize, size_t maxSize, vhvc::span<const uint8_t> &dirTbl);
 
 		/**
 		 * Read a block of null-terminated strings, where the length of the
@@ -236,12 +236,12 @@ class EXEPrivate final : public LibRpBase::RomDataPrivate
 		 * @param minExtra Last string must be at least this long.
 		 * @param minMax The minimum size of the block must be smaller than this.
 		 * @param maxExtra How many extra bytes can be read.
-		 * @param outPtr Resulting array.
+		 * @param outPtr Resulting array. (allocated from the scratch arena)
 		 * @param outSize How much data was read.
 		 * @return 0 on success; negative POSIX error code on error.
 		 */
 		int readPENullBlock(uint32_t low, uint32_t high, uint32_t minExtra,
-			uint32_t minMax, uint32_t maxExtra, std::unique_ptr<char[]> &outPtr,
+			uint32_t minMax, uint32_t maxExtra, char *&outPtr,
 			size_t &outSize);
 
 		// PE Import Directory
@@ -0,0 +1,322 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * RomDataCache.cpp: In-process RomData instance cache.                    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "RomDataCache.hpp"
+
+// librpbase
+#include "librpbase/RomData.hpp"
+using LibRpBase::RomData;
+
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+#include "librpthreads/Thread.hpp"
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
+using LibRpThreads::Thread;
+
+// C++ STL classes
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+using std::string;
+using std::vector;
+
+namespace LibRomData {
+
+namespace {
+
+// Maximum number of cached RomData objects.
+static const size_t ROMDATACACHE_MAX_ENTRIES = 8;
+// Entries that haven't been used in this many seconds are removed.
+static const time_t ROMDATACACHE_MAX_AGE = 30;
+
+struct CacheEntry {
+	string filename;
+	off64_t size;
+	time_t mtime;
+	unsigned int attrs;		// RomDataAttr bitfield used to create the RomData object
+	unsigned int classAttrs;	// RomDataAttr bitfield for the RomData subclass
+	time_t lastUsed;
+	RomData *romData;		// ref()'d by the cache
+};
+
+// Cached entries, ordered from least-recently-used to most-recently-used.
+static Mutex cache_mutex;
+static vector<CacheEntry> cache_entries;
+
+// Reaper thread. This removes entries once they expire, even if
+// the cache isn't used again, so files aren't held open while the
+// process is idle. It's only running while the cache has entries.
+// reaper_running is protected by cache_mutex.
+static Thread reaper_thread;
+static bool reaper_running = false;
+
+// Reaper thread shutdown. (reaper_stop is protected by reaper_mutex)
+// NOTE: std::condition_variable is used here because it supports
+// timed waits, which the librpthreads classes don't.
+static std::mutex reaper_mutex;
+static std::condition_variable reaper_cond;
+static bool reaper_stop = false;
+
+/**
+ * Stop the reaper thread when the library is unloaded.
+ * NOTE: This must be declared after reaper_thread so it's
+ * destroyed first. Otherwise, ~Thread() would wait forever.
+ */
+static class ReaperShutdown {
+	public:
+		~ReaperShutdown()
+		{
+			{
+				std::lock_guard<std::mutex> lock(reaper_mutex);
+				reaper_stop = true;
+			}
+			reaper_cond.notify_all();
+			if (reaper_thread.isJoinable()) {
+				reaper_thread.join();
+			}
+		}
+} reaper_shutdown;
+
+/**
+ * Remove entries that are expired or closed.
+ * Caller must hold cache_mutex.
+ * @param now		[in] Current time
+ * @param removed	[out] RomData objects to unref() after releasing the mutex
+ */
+static void removeStaleEntries(time_t now, vector<RomData*> &removed)
+{
+	auto iter = cache_entries.begin();
+	while (iter != cache_entries.end()) {
+		// NOTE: Only checking isOpen() if nothing else is using
+		// the RomData object, since another thread might be
+		// closing it right now.
+		const time_t age = now - iter->lastUsed;
+		if (age < 0 || age >= ROMDATACACHE_MAX_AGE ||
+		    (iter->romData->refCount() == 1 && !iter->romData->isOpen()))
+		{
+			removed.push_back(iter->romData);
+			iter = cache_entries.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+/**
+ * unref() RomData objects that were removed from the cache.
+ * NOTE: This must be called without holding cache_mutex,
+ * since deleting a RomData object may take a while.
+ * @param removed RomData objects
+ */
+static inline void unrefRemoved(const vector<RomData*> &removed)
+{
+	for (RomData *const romData : removed) {
+		romData->unref();
+	}
+}
+
+/**
+ * Reaper thread function.
+ * Removes entries as they expire, and exits once the cache is empty.
+ * @param param Unused
+ */
+static void reaperThreadFunc(void *param)
+{
+	RP_UNUSED(param);
+
+	for (;;) {
+		vector<RomData*> removed;
+		time_t wait_secs = 0;
+
+		{
+			MutexLocker locker(cache_mutex);
+			const time_t now = time(nullptr);
+			removeStaleEntries(now, removed);
+			if (cache_entries.empty()) {
+				// Nothing left to expire.
+				reaper_running = false;
+			} else {
+				// Wait until the least-recently-used entry expires.
+				wait_secs = ROMDATACACHE_MAX_AGE - (now - cache_entries.front().lastUsed);
+				if (wait_secs < 1) {
+					wait_secs = 1;
+				}
+			}
+		}
+
+		unrefRemoved(removed);
+		if (wait_secs == 0) {
+			// Cache is empty.
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(reaper_mutex);
+		if (reaper_cond.wait_for(lock, std::chrono::seconds(wait_secs), []{ return reaper_stop; })) {
+			// Library is being unloaded.
+			return;
+		}
+	}
+}
+
+/**
+ * Start the reaper thread if it isn't running.
+ * Caller must hold cache_mutex.
+ */
+static void startReaper(void)
+{
+	if (reaper_running)
+		return;
+
+	// If the previous reaper thread exited, it no longer
+	// needs cache_mutex, so it's safe to join it here.
+	if (reaper_thread.isJoinable()) {
+		reaper_thread.join();
+	}
+	reaper_running = (reaper_thread.start(reaperThreadFunc, nullptr) == 0);
+}
+
+}
+
+/**
+ * Look up a RomData object.
+ *
+ * A cached object is returned if it was created with a subset
+ * of the requested attributes (so detection checked at least
+ * the same RomData subclasses), and its subclass has all of
+ * the requested attributes.
+ *
+ * @param filename	[in] Filename
+ * @param size		[in] File size
+ * @param mtime		[in] File modification time
+ * @param attrs		[in] RomDataAttr bitfield
+ * @return RomData object (ref()'d), or nullptr if not found.
+ */
+RomData *RomDataCache::lookup(const char *filename, off64_t size, time_t mtime, unsigned int attrs)
+{
+	assert(filename != nullptr);
+	RomData *romData = nullptr;
+	vector<RomData*> removed;
+
+	{
+		MutexLocker locker(cache_mutex);
+		const time_t now = time(nullptr);
+		removeStaleEntries(now, removed);
+
+		for (auto iter = cache_entries.begin(); iter != cache_entries.end(); ++iter) {
+			if (iter->size != size || iter->mtime != mtime ||
+			    (iter->attrs & ~attrs) != 0 || (iter->classAttrs & attrs) != attrs ||
+			    iter->filename != filename)
+			{
+				continue;
+			}
+
+			// NOTE: RomData objects can't be used by multiple threads
+			// at once, so only return this entry if the cache holds
+			// the only reference. In that case, no other code has a
+			// pointer to the object, so the only way to get a new
+			// reference is through the cache, and cache_mutex is held.
+			// (This assumes nothing keeps a RomData pointer without
+			// holding a reference.) If another thread drops its
+			// reference right after this check, the entry is simply
+			// skipped this time.
+			if (iter->romData->refCount() != 1) {
+				continue;
+			}
+
+			romData = iter->romData->ref();
+
+			// Move the entry to the most-recently-used position.
+			CacheEntry entry = std::move(*iter);
+			entry.lastUsed = now;
+			cache_entries.erase(iter);
+			cache_entries.emplace_back(std::move(entry));
+			break;
+		}
+	}
+
+	unrefRemoved(removed);
+	return romData;
+}
+
+/**
+ * Add a RomData object to the cache.
+ * If the cache is full, the least-recently-used entry is removed.
+ * @param filename	[in] Filename
+ * @param size		[in] File size
+ * @param mtime		[in] File modification time
+ * @param attrs		[in] RomDataAttr bitfield used to create the RomData object
+ * @param classAttrs	[in] RomDataAttr bitfield for the RomData subclass
+ * @param romData	[in] RomData object (will be ref()'d)
+ */
+void RomDataCache::insert(const char *filename, off64_t size, time_t mtime,
+	unsigned int attrs, unsigned int classAttrs, RomData *romData)
+{
+	assert(filename != nullptr);
+	assert(romData != nullptr);
+	vector<RomData*> removed;
+
+	{
+		MutexLocker locker(cache_mutex);
+		const time_t now = time(nullptr);
+		removeStaleEntries(now, removed);
+
+		// Remove an existing entry for this file and attributes.
+		for (auto iter = cache_entries.begin(); iter != cache_entries.end(); ++iter) {
+			if (iter->attrs == attrs && iter->filename == filename) {
+				removed.push_back(iter->romData);
+				cache_entries.erase(iter);
+				break;
+			}
+		}
+
+		// Remove the least-recently-used entry if the cache is full.
+		if (cache_entries.size() >= ROMDATACACHE_MAX_ENTRIES) {
+			removed.push_back(cache_entries.front().romData);
+			cache_entries.erase(cache_entries.begin());
+		}
+
+		CacheEntry entry;
+		entry.filename = filename;
+		entry.size = size;
+		entry.mtime = mtime;
+		entry.attrs = attrs;
+		entry.classAttrs = classAttrs;
+		entry.lastUsed = now;
+		entry.romData = romData->ref();
+		cache_entries.emplace_back(std::move(entry));
+
+		// Make sure the entry is removed once it expires.
+		startReaper();
+	}
+
+	unrefRemoved(removed);
+}
+
+/**
+ * Remove all entries from the cache.
+ * This closes any files that are only held open by the cache.
+ */
+void RomDataCache::clear(void)
+{
+	vector<RomData*> removed;
+
+	{
+		MutexLocker locker(cache_mutex);
+		removed.reserve(cache_entries.size());
+		for (const CacheEntry &entry : cache_entries) {
+			removed.push_back(entry.romData);
+		}
+		cache_entries.clear();
+	}
+
+	unrefRemoved(removed);
+}
+
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * RomDataCache.hpp: In-process RomData instance cache.                    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "common.h"
+#include "dll-macros.h"
+
+// C includes.
+#include <sys/types.h>	// for off64_t
+
+// C includes. (C++ namespace)
+#include <ctime>
+
+namespace LibRpBase {
+	class RomData;
+}
+
+namespace LibRomData {
+
+/**
+ * Cache of recently-created RomData objects.
+ *
+ * File browsers call into several plugin entry points for the
+ * same file (overlay icons, property pages, context menus), and
+ * each one would otherwise detect and parse the file again.
+ *
+ * Entries are keyed by filename, file size, and mtime, so a
+ * modified file is never matched. An entry is only returned if
+ * nothing else is currently using it, since RomData objects are
+ * not safe to use from multiple threads at once. Entries that
+ * were closed, e.g. by a property page after it finished loading,
+ * are dropped.
+ *
+ * The cache keeps the file open, so it's limited to a small
+ * number of entries that were used within the last few seconds.
+ * (RomData doesn't report its memory usage, so the number of
+ * entries is used as the memory bound.) A background thread
+ * removes entries once they expire, so files aren't held open
+ * while the process is idle. The thread exits when the cache
+ * is empty.
+ *
+ * This is used by RomDataFactory::createCached().
+ */
+class RomDataCache
+{
+	private:
+		RomDataCache();
+		~RomDataCache();
+	private:
+		RP_DISABLE_COPY(RomDataCache)
+
+	public:
+		/**
+		 * Look up a RomData object.
+		 *
+		 * A cached object is returned if it was created with a subset
+		 * of the requested attributes (so detection checked at least
+		 * the same RomData subclasses), and its subclass has all of
+		 * the requested attributes.
+		 *
+		 * @param filename	[in] Filename
+		 * @param size		[in] File size
+		 * @param mtime		[in] File modification time
+		 * @param attrs		[in] RomDataAttr bitfield
+		 * @return RomData object (ref()'d), or nullptr if not found.
+		 */
+		static LibRpBase::RomData *lookup(const char *filename, off64_t size, time_t mtime, unsigned int attrs);
+
+		/**
+		 * Add a RomData object to the cache.
+		 * If the cache is full, the least-recently-used entry is removed.
+		 * @param filename	[in] Filename
+		 * @param size		[in] File size
+		 * @param mtime		[in] File modification time
+		 * @param attrs		[in] RomDataAttr bitfield used to create the RomData object
+		 * @param classAttrs	[in] RomDataAttr bitfield for the RomData subclass
+		 * @param romData	[in] RomData object (will be ref()'d)
+		 */
+		static void insert(const char *filename, off64_t size, time_t mtime,
+			unsigned int attrs, unsigned int classAttrs, LibRpBase::RomData *romData);
+
+		/**
+		 * Remove all entries from the cache.
+		 * This closes any files that are only held open by the cache.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		static void clear(void);
+};
+
+}
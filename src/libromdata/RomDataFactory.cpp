@@ -11,10 +11,19 @@
 #include "libromdata/config.libromdata.h"
 
 #include "RomDataFactory.hpp"
+#include "RomDataCache.hpp"
 #include "RomData_p.hpp"	// for RomDataInfo
 
 // librpbase, librpfile
 #include "librpfile/RelatedFile.hpp"
+#include "librpfile/IoTrace.hpp"
+#include "librpfile/TracingFile.hpp"
+#include "librpfile/HeaderCacheFile.hpp"
+#include "librpfile/BlockCacheFile.hpp"
+namespace IoTrace = LibRpFile::IoTrace;
+using LibRpFile::TracingFile;
+using LibRpFile::HeaderCacheFile;
+using LibRpFile::BlockCacheFile;
 using namespace LibRpBase;
 using namespace LibRpFile;
 
@@ -141,6 +150,9 @@ class RomDataFactoryPrivate
 		template<typename klass>
 		static LibRpBase::RomData *RomData_ctor(IRpFile *file)
 		{
+			// Attribute reads in the constructor to this class
+			// if I/O tracing is enabled.
+			IoTrace::ScopedTag tag(klass::romDataInfo()->className);
 			return new klass(file);
 		}
 
@@ -188,9 +200,14 @@ class RomDataFactoryPrivate
 		// not cache them.
 		static vector<RomDataFactory::ExtInfo> vec_exts;
 		static vector<const char*> vec_mimeTypes;
+		// RomData subclass attributes, indexed by class name.
+		// Used by RomDataCache to determine if a cached RomData
+		// object can be used for a request with different attributes.
+		static unordered_map<string, unsigned int> map_classAttrs;
 		// pthread_once() control variables
 		static pthread_once_t once_exts;
 		static pthread_once_t once_mimeTypes;
+		static pthread_once_t once_classAttrs;
 
 		/**
 		 * Initialize the vector of supported file extensions.
@@ -211,6 +228,21 @@ class RomDataFactoryPrivate
 		 */
 		static void init_supportedMimeTypes(void);
 
+		/**
+		 * Initialize the map of RomData subclass attributes.
+		 *
+		 * Internal function; must be called using pthread_once().
+		 */
+		static void init_classAttrs(void);
+
+		/**
+		 * Get the attributes for a RomData subclass.
+		 * @param romData RomData object
+		 * @param attrs Attributes that were used to create the RomData object
+		 * @return RomDataAttr bitfield
+		 */
+		static unsigned int getClassAttrs(const RomData *romData, unsigned int attrs);
+
 		/**
 		 * Check an ISO-9660 disc image for a game-specific file system.
 		 *
@@ -221,14 +253,25 @@ class RomDataFactoryPrivate
 		 * @return Game-specific RomData subclass, or nullptr if none are supported.
 		 */
 		static RomData *checkISO(IRpFile *file);
+
+		/**
+		 * Create a RomData subclass for the specified ROM file.
+		 * Internal implementation of RomDataFactory::create().
+		 * @param file ROM file.
+		 * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
+		 * @return RomData subclass, or nullptr if the ROM isn't supported.
+		 */
+		static RomData *create(IRpFile *file, unsigned int attrs);
 };
 
 /** RomDataFactoryPrivate **/
 
 vector<RomDataFactory::ExtInfo> RomDataFactoryPrivate::vec_exts;
 vector<const char*> RomDataFactoryPrivate::vec_mimeTypes;
+unordered_map<string, unsigned int> RomDataFactoryPrivate::map_classAttrs;
 pthread_once_t RomDataFactoryPrivate::once_exts = PTHREAD_ONCE_INIT;
 pthread_once_t RomDataFactoryPrivate::once_mimeTypes = PTHREAD_ONCE_INIT;
+pthread_once_t RomDataFactoryPrivate::once_classAttrs = PTHREAD_ONCE_INIT;
 
 #define ATTR_NONE		RomDataFactory::RDA_NONE
 #define ATTR_HAS_THUMBNAIL	RomDataFactory::RDA_HAS_THUMBNAIL
@@ -437,7 +480,11 @@ RomData *RomDataFactoryPrivate::openDreamcastVMSandVMI(IRpFile *file)
 
 	// Attempt to create a DreamcastSave using both the
 	// VMS and VMI files.
-	DreamcastSave *const dcSave = new DreamcastSave(vms_file, vmi_file);
+	DreamcastSave *dcSave;
+	{
+		IoTrace::ScopedTag tag(DreamcastSave::romDataInfo()->className);
+		dcSave = new DreamcastSave(vms_file, vmi_file);
+	}
 	(*other_file)->unref();	// Not needed anymore.
 	if (!dcSave->isValid()) {
 		// Not valid.
@@ -543,7 +590,7 @@ RomData *RomDataFactoryPrivate::checkISO(IRpFile *file)
 			    !memcmp(xdvdfsHeader.magic_footer, XDVDFS_MAGIC, sizeof(xdvdfsHeader.magic_footer)))
 			{
 				// It's a match! Try opening as XboxDisc.
-				RomData *const romData = new XboxDisc(file);
+				RomData *const romData = RomData_ctor<XboxDisc>(file);
 				if (romData->isValid()) {
 					// Found the correct RomData subclass.
 					return romData;
@@ -555,11 +602,9 @@ RomData *RomDataFactoryPrivate::checkISO(IRpFile *file)
 
 	// Not a game-specific file system.
 	// Use the generic ISO-9660 parser.
-	return new ISO(file);
+	return RomData_ctor<ISO>(file);
 }
 
-/** RomDataFactory **/
-
 /**
  * Create a RomData subclass for the specified ROM file.
  *
@@ -575,7 +620,7 @@ RomData *RomDataFactoryPrivate::checkISO(IRpFile *file)
  * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
  * @return RomData subclass, or nullptr if the ROM isn't supported.
  */
-RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
+RomData *RomDataFactoryPrivate::create(IRpFile *file, unsigned int attrs)
 {
 	RomData::DetectInfo info;
 
@@ -669,7 +714,7 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 	// Check for supported textures.
 	{
 		// TODO: RpTextureWrapper::isRomSupported()?
-		RomData *const romData = new RpTextureWrapper(file);
+		RomData *const romData = RomDataFactoryPrivate::RomData_ctor<RpTextureWrapper>(file);
 		if (romData->isValid()) {
 			// RomData subclass obtained.
 			return romData;
@@ -759,7 +804,7 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 
 		if (fns->isRomSupported(&info) >= 0) {
 			RomData *romData;
-			if (fns->attrs & RDA_CHECK_ISO) {
+			if (fns->attrs & RomDataFactory::RDA_CHECK_ISO) {
 				// Check for a game-specific ISO subclass.
 				romData = RomDataFactoryPrivate::checkISO(file);
 			} else {
@@ -851,6 +896,113 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 	return nullptr;
 }
 
+/**
+ * Initialize the map of RomData subclass attributes.
+ *
+ * Internal function; must be called using pthread_once().
+ */
+void RomDataFactoryPrivate::init_classAttrs(void)
+{
+	for (const RomDataFns *const *tblptr = &romDataFns_tbl[0];
+	     *tblptr != nullptr; tblptr++)
+	{
+		const RomDataFns *fns = *tblptr;
+		for (; fns->romDataInfo != nullptr; fns++) {
+			// NOTE: Some subclasses are listed more than once,
+			// e.g. for multiple magic numbers.
+			map_classAttrs[fns->romDataInfo()->className] |= (fns->attrs & ~ATTR_CHECK_ISO);
+		}
+	}
+
+	// Textures are checked separately from the tables.
+	// (Same attributes as FileFormatFactory in init_supportedFileExtensions().)
+	map_classAttrs[RpTextureWrapper::romDataInfo()->className] = ATTR_HAS_THUMBNAIL | ATTR_HAS_METADATA;
+}
+
+/**
+ * Get the attributes for a RomData subclass.
+ * @param romData RomData object
+ * @param attrs Attributes that were used to create the RomData object
+ * @return RomDataAttr bitfield
+ */
+unsigned int RomDataFactoryPrivate::getClassAttrs(const RomData *romData, unsigned int attrs)
+{
+	pthread_once(&once_classAttrs, init_classAttrs);
+
+	const char *const className = romData->className();
+	if (className) {
+		auto iter = map_classAttrs.find(className);
+		if (iter != map_classAttrs.end()) {
+			return iter->second;
+		}
+	}
+
+	// Not found. This may be a game-specific subclass returned by
+	// checkISO(). Assume it only has the requested attributes.
+	return attrs;
+}
+
+/** RomDataFactory **/
+
+/**
+ * Create a RomData subclass for the specified ROM file.
+ *
+ * NOTE: RomData::isValid() is checked before returning a
+ * created RomData instance, so returned objects can be
+ * assumed to be valid as long as they aren't nullptr.
+ *
+ * If imgbf is non-zero, at least one of the specified image
+ * types must be supported by the RomData subclass in order to
+ * be returned.
+ *
+ * @param file ROM file.
+ * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
+ * @return RomData subclass, or nullptr if the ROM isn't supported.
+ */
+RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
+{
+	if (file->isDevice()) {
+		// Device files aren't traced or cached, since
+		// XboxDisc needs the original RpFile for Kreon
+		// drive commands.
+		return RomDataFactoryPrivate::create(file, attrs);
+	}
+
+	// Trace reads on this file. Reads made while checking RomData
+	// subclasses are attributed to each subclass; reads afterwards
+	// are attributed to the subclass that was returned.
+	// NOTE: The tracing layer is below the caches,
+	// so only reads that reach the actual file are traced.
+	TracingFile *tracingFile = nullptr;
+	if (IoTrace::isEnabled()) {
+		tracingFile = new TracingFile(file, "RomDataFactory");
+		file = tracingFile;
+	}
+
+	// Remote files have a high latency for each read,
+	// so read them in larger blocks.
+	BlockCacheFile *blockCacheFile = nullptr;
+	if (file->isRemote()) {
+		blockCacheFile = new BlockCacheFile(file);
+		file = blockCacheFile;
+	}
+
+	// Cache the header and footer windows read during detection.
+	// Most RomData subclass constructors read the same data again.
+	HeaderCacheFile *const cacheFile = new HeaderCacheFile(file);
+	RomData *const romData = RomDataFactoryPrivate::create(cacheFile, attrs);
+	cacheFile->unref();
+	UNREF(blockCacheFile);
+
+	if (tracingFile) {
+		if (romData) {
+			tracingFile->setTag(romData->className());
+		}
+		tracingFile->unref();
+	}
+	return romData;
+}
+
 /**
  * Create a RomData subclass for the specified ROM file.
  *
@@ -889,6 +1041,53 @@ RomData *RomDataFactory::create(const char *filename, unsigned int attrs)
 	return nullptr;
 }
 
+/**
+ * Create a RomData subclass for the specified ROM file,
+ * reusing a recently-created RomData object if possible.
+ *
+ * This should be used by plugin entry points that may be
+ * called for the same file multiple times in one process,
+ * e.g. overlay icons, property pages, and context menus.
+ * Only local files are cached; other files are opened
+ * using create().
+ *
+ * NOTE: The returned RomData object may have been used
+ * by another caller, e.g. its fields may already be loaded.
+ *
+ * @param file ROM file
+ * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
+ * @return RomData subclass, or nullptr if the ROM isn't supported.
+ */
+RomData *RomDataFactory::createCached(IRpFile *file, unsigned int attrs)
+{
+	// Device files aren't cached, since they might
+	// not have a valid size or mtime.
+	const char *const filename = file->filename();
+	if (file->isDevice() || !filename || filename[0] == '\0') {
+		return create(file, attrs);
+	}
+
+	off64_t size = 0;
+	time_t mtime = 0;
+	if (FileSystem::get_file_size_and_mtime(filename, &size, &mtime) != 0) {
+		// Not a local file.
+		return create(file, attrs);
+	}
+
+	RomData *romData = RomDataCache::lookup(filename, size, mtime, attrs);
+	if (romData) {
+		// Found a cached RomData object.
+		return romData;
+	}
+
+	romData = create(file, attrs);
+	if (romData) {
+		RomDataCache::insert(filename, size, mtime, attrs,
+			RomDataFactoryPrivate::getClassAttrs(romData, attrs), romData);
+	}
+	return romData;
+}
+
 /**
  * Initialize the vector of supported file extensions.
  * Used for Win32 COM registration.
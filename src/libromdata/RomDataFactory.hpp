@@ -98,6 +98,26 @@ class RomDataFactory
 		RP_LIBROMDATA_PUBLIC
 		static LibRpBase::RomData *create(const char *filename, unsigned int attrs = 0);
 
+		/**
+		 * Create a RomData subclass for the specified ROM file,
+		 * reusing a recently-created RomData object if possible.
+		 *
+		 * This should be used by plugin entry points that may be
+		 * called for the same file multiple times in one process,
+		 * e.g. overlay icons, property pages, and context menus.
+		 * Only local files are cached; other files are opened
+		 * using create().
+		 *
+		 * NOTE: The returned RomData object may have been used
+		 * by another caller, e.g. its fields may already be loaded.
+		 *
+		 * @param file ROM file
+		 * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
+		 * @return RomData subclass, or nullptr if the ROM isn't supported.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		static LibRpBase::RomData *createCached(LibRpFile::IRpFile *file, unsigned int attrs = 0);
+
 		struct ExtInfo {
 			const char *ext;
 			unsigned int attrs;
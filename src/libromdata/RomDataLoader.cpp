@@ -0,0 +1,422 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * RomDataLoader.cpp: Asynchronous RomData loader.                         *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "RomDataLoader.hpp"
+#include "RomDataFactory.hpp"
+
+// librpbase, librpfile
+#include "librpfile/CancellableFile.hpp"
+using LibRpBase::RomData;
+using LibRpBase::RomFields;
+using LibRpFile::CancellableFile;
+using LibRpFile::IRpFile;
+
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+#include "librpthreads/Semaphore.hpp"
+#include "librpthreads/Thread.hpp"
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
+using LibRpThreads::Semaphore;
+using LibRpThreads::Thread;
+
+// C++ STL classes
+using std::unordered_map;
+
+namespace LibRomData {
+
+/** RomDataLoaderPrivate **/
+
+class RomDataLoaderPrivate
+{
+	public:
+		RomDataLoaderPrivate(RomDataLoader *q, RomDataLoader::callback_t callback, void *user_data);
+		~RomDataLoaderPrivate();
+
+	private:
+		RP_DISABLE_COPY(RomDataLoaderPrivate)
+		RomDataLoader *const q_ptr;
+
+	public:
+		/**
+		 * Deliver an event to the callback.
+		 * @param event Event
+		 * @return True if delivered; false if loading was cancelled.
+		 */
+		bool emitEvent(RomDataLoader::Event event);
+
+		/**
+		 * Worker thread function.
+		 * @param param RomDataLoaderPrivate
+		 */
+		static void worker(void *param);
+
+		/**
+		 * Load the RomData object.
+		 * Called on the worker thread.
+		 */
+		void load(void);
+
+	public:
+		/**
+		 * Loaders whose worker thread is using an existing RomData object.
+		 * If a new loader is started for the same RomData object, e.g.
+		 * because the UI cancelled the previous loader and dropped it,
+		 * its worker thread waits for the previous one to finish first.
+		 * This is done on the worker thread so the UI never blocks.
+		 */
+		static Mutex activeMutex;
+		static unordered_map<const RomData*, RomDataLoader*> activeLoaders;
+
+		/**
+		 * Register this loader as the active loader for romData.
+		 * Called on the worker thread.
+		 * @return Previous active loader (ref()'d), or nullptr if none.
+		 */
+		RomDataLoader *setActive(void);
+
+		/**
+		 * Unregister this loader as the active loader for romData.
+		 * Called on the worker thread.
+		 */
+		void clearActive(void);
+
+	public:
+		RomDataLoader::callback_t callback;
+		void *user_data;
+
+		IRpFile *file;			// Original file (nullptr if a RomData object was specified)
+		CancellableFile *cfile;		// Cancellable wrapper (nullptr if not used)
+		RomData *romData;
+
+		Thread thread;
+		Mutex mutex;			// Protects cfile and cancelled; held while the callback runs.
+		Semaphore done;			// Released when the worker thread finishes.
+		volatile bool cancelled;
+};
+
+Mutex RomDataLoaderPrivate::activeMutex;
+unordered_map<const RomData*, RomDataLoader*> RomDataLoaderPrivate::activeLoaders;
+
+RomDataLoaderPrivate::RomDataLoaderPrivate(RomDataLoader *q, RomDataLoader::callback_t callback, void *user_data)
+	: q_ptr(q)
+	, callback(callback)
+	, user_data(user_data)
+	, file(nullptr)
+	, cfile(nullptr)
+	, romData(nullptr)
+	, done(0)
+	, cancelled(false)
+{ }
+
+RomDataLoaderPrivate::~RomDataLoaderPrivate()
+{
+	UNREF(romData);
+	UNREF(cfile);
+	UNREF(file);
+}
+
+/**
+ * Deliver an event to the callback.
+ * @param event Event
+ * @return True if delivered; false if loading was cancelled.
+ */
+bool RomDataLoaderPrivate::emitEvent(RomDataLoader::Event event)
+{
+	MutexLocker locker(mutex);
+	if (cancelled)
+		return false;
+	if (callback) {
+		callback(q_ptr, event, user_data);
+	}
+	return true;
+}
+
+/**
+ * Register this loader as the active loader for romData.
+ * Called on the worker thread.
+ * @return Previous active loader (ref()'d), or nullptr if none.
+ */
+RomDataLoader *RomDataLoaderPrivate::setActive(void)
+{
+	MutexLocker locker(activeMutex);
+	RomDataLoader *&active = activeLoaders[romData];
+	RomDataLoader *const prev = (active ? active->ref() : nullptr);
+	active = q_ptr;
+	return prev;
+}
+
+/**
+ * Unregister this loader as the active loader for romData.
+ * Called on the worker thread.
+ */
+void RomDataLoaderPrivate::clearActive(void)
+{
+	MutexLocker locker(activeMutex);
+	auto iter = activeLoaders.find(romData);
+	if (iter != activeLoaders.end() && iter->second == q_ptr) {
+		activeLoaders.erase(iter);
+	}
+}
+
+/**
+ * Worker thread function.
+ * @param param RomDataLoaderPrivate
+ */
+void RomDataLoaderPrivate::worker(void *param)
+{
+	RomDataLoaderPrivate *const d = static_cast<RomDataLoaderPrivate*>(param);
+
+	if (!d->file) {
+		// Using an existing RomData object.
+		// Wait for the previous loader's worker thread, if any,
+		// so two threads never access the RomData object at once.
+		RomDataLoader *const prev = d->setActive();
+		if (prev) {
+			RomDataLoaderPrivate *const dp = prev->d_ptr;
+			while (dp->done.obtain() != 0) {
+				if (errno != EINTR)
+					break;
+			}
+			dp->done.release();
+			prev->unref();
+		}
+	}
+
+	d->load();
+
+	if (!d->file) {
+		d->clearActive();
+	}
+
+	// Wake up any worker thread that's waiting for this one.
+	// NOTE: Waiting threads hold their own reference,
+	// so the loader won't be deleted before they return.
+	d->done.release();
+
+	// Release the worker thread's reference.
+	// NOTE: This may delete the loader, which releases
+	// its reference to the RomData object.
+	d->q_ptr->unref();
+}
+
+/**
+ * Load the RomData object.
+ * Called on the worker thread.
+ */
+void RomDataLoaderPrivate::load(void)
+{
+	typedef RomDataLoader::Event Event;
+
+	// Stage 1: Create the RomData object.
+	if (file) {
+		// Devices are opened directly, since RomData subclasses
+		// may need to access the underlying RpFile.
+		IRpFile *createFile = file;
+		if (!file->isDevice()) {
+			MutexLocker locker(mutex);
+			cfile = new CancellableFile(file);
+			createFile = cfile;
+		}
+
+		RomData *const newRomData = RomDataFactory::create(createFile);
+		if (cancelled) {
+			UNREF(newRomData);
+			return;
+		} else if (!newRomData) {
+			emitEvent(Event::Failed);
+			return;
+		}
+
+		// NOTE: romData is published to other threads by the
+		// mutex in emitEvent(). It isn't changed after this.
+		romData = newRomData;
+		if (!emitEvent(Event::Created))
+			return;
+	}
+
+	// Stage 2: Load the fields.
+	if (cancelled)
+		return;
+	const RomFields *const fields = romData->fields();
+	if (fields) {
+		// Decode list data icons now so the UI thread
+		// doesn't have to decode them when it shows the list.
+		const auto fields_cend = fields->cend();
+		for (auto iter = fields->cbegin(); iter != fields_cend; ++iter) {
+			if (cancelled)
+				return;
+			const RomFields::Field &field = *iter;
+			if (field.type == RomFields::RFT_LISTDATA &&
+			    (field.flags & RomFields::RFT_LISTDATA_ICONS) &&
+			    field.data.list_data.mxd.icons)
+			{
+				field.data.list_data.mxd.icons->loadAll();
+			}
+		}
+	}
+	if (!emitEvent(Event::FieldsLoaded))
+		return;
+
+	// Stage 3: Load the internal images.
+	// RomData caches these, so the UI thread won't
+	// have to do any I/O to retrieve them later.
+	const uint32_t imgbf = romData->supportedImageTypes();
+	for (int i = RomData::IMG_INT_MIN; i <= RomData::IMG_INT_MAX; i++) {
+		if (cancelled)
+			return;
+		if (imgbf & (1U << i)) {
+			romData->image(static_cast<RomData::ImageType>(i));
+		}
+	}
+	if (cancelled)
+		return;
+	romData->iconAnimData();
+	if (!emitEvent(Event::ImagesLoaded))
+		return;
+
+	// Close the file.
+	// Keeping the file open may prevent the user from changing it.
+	// NOTE: This is done here instead of by the UI, since a
+	// cancelled loader may still be using the RomData object.
+	if (cancelled)
+		return;
+	romData->close();
+
+	emitEvent(Event::Finished);
+}
+
+/** RomDataLoader **/
+
+/**
+ * Create and load a RomData object on a worker thread.
+ * The file is opened through a cancellable wrapper, so a
+ * call to cancel() will abort any pending reads.
+ * @param file IRpFile (will be ref()'d)
+ * @param callback Event callback
+ * @param user_data User data for the callback
+ */
+RomDataLoader::RomDataLoader(IRpFile *file, callback_t callback, void *user_data)
+	: d_ptr(new RomDataLoaderPrivate(this, callback, user_data))
+{
+	assert(file != nullptr);
+	if (file) {
+		d_ptr->file = file->ref();
+	}
+}
+
+/**
+ * Load fields and images for an existing RomData object on a worker thread.
+ * The Created event is not delivered.
+ *
+ * If the RomData object was opened using a CancellableFile,
+ * cancel() aborts pending reads on that file. The RomData
+ * object can't read from its file after that.
+ *
+ * @param romData RomData (will be ref()'d)
+ * @param callback Event callback
+ * @param user_data User data for the callback
+ */
+RomDataLoader::RomDataLoader(RomData *romData, callback_t callback, void *user_data)
+	: d_ptr(new RomDataLoaderPrivate(this, callback, user_data))
+{
+	assert(romData != nullptr);
+	if (romData) {
+		d_ptr->romData = romData->ref();
+
+		// If the RomData object was opened using a CancellableFile,
+		// use it to abort pending reads if the loader is cancelled.
+		IRpFile *const file = romData->ref_file();
+		if (file) {
+			CancellableFile *const cfile = CancellableFile::find(file);
+			if (cfile) {
+				d_ptr->cfile = cfile;
+				cfile->ref();
+			}
+			file->unref();
+		}
+	}
+}
+
+RomDataLoader::~RomDataLoader()
+{
+	delete d_ptr;
+}
+
+/**
+ * Start the worker thread.
+ *
+ * The worker thread holds its own reference to the loader,
+ * so the owner should call cancel() before unref()'ing it
+ * if the results are no longer needed. The worker thread
+ * releases the RomData object once it finishes.
+ *
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RomDataLoader::start(void)
+{
+	RP_D(RomDataLoader);
+	if (!d->file && !d->romData) {
+		// Nothing to load.
+		return -EBADF;
+	}
+
+	// The worker thread holds a reference to the loader, and the
+	// thread is detached, so the owner can unref() the loader at
+	// any time without waiting for a pending read to finish.
+	ref();
+	int ret = d->thread.start(RomDataLoaderPrivate::worker, d);
+	if (ret != 0) {
+		unref();
+		return ret;
+	}
+	d->thread.detach();
+	return 0;
+}
+
+/**
+ * Cancel loading.
+ * Pending reads on the file are aborted with ECANCELED.
+ * No callbacks will be invoked after this function returns.
+ */
+void RomDataLoader::cancel(void)
+{
+	RP_D(RomDataLoader);
+
+	// If the worker thread is currently reading from the file,
+	// the read will fail with ECANCELED after this.
+	MutexLocker locker(d->mutex);
+	d->cancelled = true;
+	if (d->cfile) {
+		d->cfile->cancel();
+	}
+}
+
+/**
+ * Has loading been cancelled?
+ * @return True if cancelled; false if not.
+ */
+bool RomDataLoader::isCancelled(void) const
+{
+	RP_D(const RomDataLoader);
+	return d->cancelled;
+}
+
+/**
+ * Get the RomData object.
+ * This is valid after the Created event.
+ * @return RomData object (owned by the loader; ref() it to keep it), or nullptr if not available.
+ */
+RomData *RomDataLoader::romData(void) const
+{
+	RP_D(const RomDataLoader);
+	return d->romData;
+}
+
+}
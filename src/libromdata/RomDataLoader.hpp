@@ -0,0 +1,141 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * RomDataLoader.hpp: Asynchronous RomData loader.                         *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "common.h"
+#include "dll-macros.h"
+#include "RefBase.hpp"
+
+namespace LibRpBase {
+	class RomData;
+}
+namespace LibRpFile {
+	class IRpFile;
+}
+
+namespace LibRomData {
+
+class RomDataLoaderPrivate;
+class RomDataLoader : public RefBase
+{
+	public:
+		/**
+		 * Loader events.
+		 * Events are delivered in this order. Loading stops after
+		 * Finished or Failed, or when cancel() is called.
+		 */
+		enum class Event {
+			Created,	// RomData object was created; romData() is valid.
+			FieldsLoaded,	// RomData::fields() has been loaded.
+			ImagesLoaded,	// Internal images and icon animation data have been loaded.
+			Finished,	// Loading is complete.
+			Failed,		// File is not supported, or an error occurred.
+		};
+
+		/**
+		 * Event callback.
+		 *
+		 * NOTE: The callback is invoked on the worker thread.
+		 * UI frontends must marshal the event to the UI thread.
+		 *
+		 * The RomData object must not be accessed from another thread
+		 * until the corresponding event has been received:
+		 * - After Created: Header information, e.g. systemName().
+		 * - After FieldsLoaded: fields()
+		 * - After Finished: Everything else.
+		 *
+		 * The RomData object's file is closed by the loader before
+		 * Finished is delivered, since it's no longer needed.
+		 *
+		 * @param loader RomDataLoader
+		 * @param event Event
+		 * @param user_data User data
+		 */
+		typedef void (*callback_t)(RomDataLoader *loader, Event event, void *user_data);
+
+		/**
+		 * Create and load a RomData object on a worker thread.
+		 * The file is opened through a cancellable wrapper, so a
+		 * call to cancel() will abort any pending reads.
+		 * @param file IRpFile (will be ref()'d)
+		 * @param callback Event callback
+		 * @param user_data User data for the callback
+		 */
+		RP_LIBROMDATA_PUBLIC
+		RomDataLoader(LibRpFile::IRpFile *file, callback_t callback, void *user_data);
+
+		/**
+		 * Load fields and images for an existing RomData object on a worker thread.
+		 * The Created event is not delivered.
+		 *
+		 * If the RomData object was opened using a CancellableFile,
+		 * cancel() aborts pending reads on that file. The RomData
+		 * object can't read from its file after that.
+		 *
+		 * @param romData RomData (will be ref()'d)
+		 * @param callback Event callback
+		 * @param user_data User data for the callback
+		 */
+		RP_LIBROMDATA_PUBLIC
+		RomDataLoader(LibRpBase::RomData *romData, callback_t callback, void *user_data);
+
+	protected:
+		~RomDataLoader() override;	// call unref() instead
+
+	private:
+		RP_DISABLE_COPY(RomDataLoader)
+	private:
+		friend class RomDataLoaderPrivate;
+		RomDataLoaderPrivate *const d_ptr;
+
+	public:
+		inline RomDataLoader *ref(void)
+		{
+			return RefBase::ref<RomDataLoader>();
+		}
+
+	public:
+		/**
+		 * Start the worker thread.
+		 *
+		 * The worker thread holds its own reference to the loader,
+		 * so the owner should call cancel() before unref()'ing it
+		 * if the results are no longer needed. The worker thread
+		 * releases the RomData object once it finishes.
+		 *
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int start(void);
+
+		/**
+		 * Cancel loading.
+		 * Pending reads on the file are aborted with ECANCELED.
+		 * No callbacks will be invoked after this function returns.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		void cancel(void);
+
+		/**
+		 * Has loading been cancelled?
+		 * @return True if cancelled; false if not.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		bool isCancelled(void) const;
+
+		/**
+		 * Get the RomData object.
+		 * This is valid after the Created event.
+		 * @return RomData object (owned by the loader; ref() it to keep it), or nullptr if not available.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		LibRpBase::RomData *romData(void) const;
+};
+
+}
@@ -2,7 +2,7 @@
  * ROM Properties Page shell extension. (libromdata)                       *
  * Cdrom2352Reader.hpp: CD-ROM reader for 2352-byte sector images.         *
  *                                                                         *
- * Copyright (c) 2016-2022 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -21,6 +21,9 @@
 using namespace LibRpBase;
 using LibRpFile::IRpFile;
 
+// C++ STL classes
+using std::unique_ptr;
+
 namespace LibRomData {
 
 class Cdrom2352ReaderPrivate : public SparseDiscReaderPrivate {
@@ -209,4 +212,85 @@ int Cdrom2352Reader::readBlock(uint32_t blockIdx, int pos, void *ptr, size_t siz
 	return static_cast<int>(size);
 }
 
+/**
+ * Read multiple consecutive full blocks.
+ * @param blockIdx	[in] First block index.
+ * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+ * @param blockCount	[in] Number of blocks to read.
+ * @return Number of bytes read.
+ */
+size_t Cdrom2352Reader::readBlocks(uint32_t blockIdx, void *ptr, uint32_t blockCount)
+{
+	// NOTE: This can only be called by SparseDiscReader,
+	// so the main assertions are already checked there.
+	RP_D(Cdrom2352Reader);
+	const off64_t physBlockAddr = static_cast<off64_t>(blockIdx) * d->physBlockSize;
+	const size_t ret = readSectorUserData(m_file, physBlockAddr, d->physBlockSize, ptr, blockCount);
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/** CD-ROM-specific functions. **/
+
+/**
+ * Read multiple raw sectors and extract the user data.
+ *
+ * Sectors are read into a staging buffer in batches, so a
+ * multi-sector read only needs one I/O per batch.
+ * Mode 1 and Mode 2 XA (Form 1) sectors are supported.
+ *
+ * @param file		[in] File to read from.
+ * @param physAddr	[in] Physical address of the first sector.
+ * @param physBlockSize	[in] Physical sector size. (2352, 2448)
+ * @param ptr		[out] Output data buffer. (Must be at least sectorCount * 2048 bytes!)
+ * @param sectorCount	[in] Number of sectors to read.
+ * @return Number of bytes of user data read.
+ */
+size_t Cdrom2352Reader::readSectorUserData(IRpFile *file, off64_t physAddr,
+	unsigned int physBlockSize, void *ptr, uint32_t sectorCount)
+{
+	assert(file != nullptr);
+	assert(physBlockSize >= sizeof(CDROM_2352_Sector_t));
+	if (!file || physBlockSize < sizeof(CDROM_2352_Sector_t) || sectorCount == 0) {
+		return 0;
+	}
+
+	// Maximum number of sectors to read at once.
+	// 64 sectors is 147 KB (2352) or 153 KB (2448).
+	static const uint32_t STAGING_SECTORS = 64;
+
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+
+	const uint32_t stagingCount = std::min(sectorCount, STAGING_SECTORS);
+	unique_ptr<uint8_t[]> staging(new uint8_t[static_cast<size_t>(stagingCount) * physBlockSize]);
+
+	while (sectorCount > 0) {
+		const uint32_t count = std::min(sectorCount, stagingCount);
+		const size_t sz_req = static_cast<size_t>(count) * physBlockSize;
+		const size_t sz_read = file->seekAndRead(physAddr, staging.get(), sz_req);
+
+		// Extract the user data from each complete sector.
+		// NOTE: Sector user data area position depends on the sector mode.
+		const uint32_t sectorsRead = static_cast<uint32_t>(sz_read / physBlockSize);
+		const uint8_t *pSrc = staging.get();
+		for (uint32_t i = 0; i < sectorsRead; i++, pSrc += physBlockSize, ptr8 += 2048) {
+			const CDROM_2352_Sector_t *const sector =
+				reinterpret_cast<const CDROM_2352_Sector_t*>(pSrc);
+			memcpy(ptr8, cdromSectorDataPtr(sector), 2048);
+		}
+		ret += static_cast<size_t>(sectorsRead) * 2048;
+
+		if (sz_read != sz_req) {
+			// Short read.
+			break;
+		}
+
+		physAddr += sz_req;
+		sectorCount -= count;
+	}
+
+	return ret;
+}
+
 }
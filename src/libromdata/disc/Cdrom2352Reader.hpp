@@ -25,6 +25,7 @@ class Cdrom2352Reader : public LibRpBase::SparseDiscReader
 		 *
 		 * @param file File to read from.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		explicit Cdrom2352Reader(LibRpFile::IRpFile *file);
 
 		/**
@@ -35,6 +36,7 @@ class Cdrom2352Reader : public LibRpBase::SparseDiscReader
 		 * @param file File to read from.
 		 * @param physBlockSize Sector size. (2352, 2446)
 		 */
+		RP_LIBROMDATA_PUBLIC
 		explicit Cdrom2352Reader(LibRpFile::IRpFile *file, unsigned int physBlockSize);
 
 	private:
@@ -68,6 +70,24 @@ class Cdrom2352Reader : public LibRpBase::SparseDiscReader
 		 */
 		int isDiscSupported(const uint8_t *pHeader, size_t szHeader) const final;
 
+	public:
+		/**
+		 * Read multiple raw sectors and extract the user data.
+		 *
+		 * Sectors are read into a staging buffer in batches, so a
+		 * multi-sector read only needs one I/O per batch.
+		 * Mode 1 and Mode 2 XA (Form 1) sectors are supported.
+		 *
+		 * @param file		[in] File to read from.
+		 * @param physAddr	[in] Physical address of the first sector.
+		 * @param physBlockSize	[in] Physical sector size. (2352, 2448)
+		 * @param ptr		[out] Output data buffer. (Must be at least sectorCount * 2048 bytes!)
+		 * @param sectorCount	[in] Number of sectors to read.
+		 * @return Number of bytes of user data read.
+		 */
+		static size_t readSectorUserData(LibRpFile::IRpFile *file, off64_t physAddr,
+			unsigned int physBlockSize, void *ptr, uint32_t sectorCount);
+
 	protected:
 		/** SparseDiscReader functions. **/
 
@@ -93,6 +113,15 @@ class Cdrom2352Reader : public LibRpBase::SparseDiscReader
 		 */
 		ATTR_ACCESS_SIZE(write_only, 4, 5)
 		int readBlock(uint32_t blockIdx, int pos, void *ptr, size_t size) final;
+
+		/**
+		 * Read multiple consecutive full blocks.
+		 * @param blockIdx	[in] First block index.
+		 * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+		 * @param blockCount	[in] Number of blocks to read.
+		 * @return Number of bytes read.
+		 */
+		size_t readBlocks(uint32_t blockIdx, void *ptr, uint32_t blockCount) final;
 };
 
 }
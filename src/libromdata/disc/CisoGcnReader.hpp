@@ -22,6 +22,7 @@ class CisoGcnReader : public LibRpBase::SparseDiscReader
 		 * unref()'d by the caller afterwards.
 		 * @param file File to read from.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		explicit CisoGcnReader(LibRpFile::IRpFile *file);
 
 	private:
@@ -0,0 +1,483 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * FstExtractor.cpp: Extract files from a partition's file system table.   *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "FstExtractor.hpp"
+
+// librpbase
+#include "librpbase/disc/IFst.hpp"
+#include "librpbase/disc/IPartition.hpp"
+using namespace LibRpBase;
+
+// librpfile
+#include "librpfile/FileSystem.hpp"
+#include "librpfile/RpFile.hpp"
+using namespace LibRpFile;
+
+// librpthreads
+#include "librpthreads/ThreadPool.hpp"
+using LibRpThreads::TaskGroup;
+
+// C++ STL classes
+using std::string;
+using std::vector;
+
+namespace LibRomData {
+
+namespace {
+
+// Chunk size for copying through the partition.
+static const size_t CHUNK_SIZE = 1024U * 1024U;
+
+/**
+ * Parameters for the extractFile() write task.
+ */
+struct WriteTaskParam {
+	RpFile *file;
+	const uint8_t *pData;
+	size_t len;
+	size_t written;
+};
+
+void writeTask(void *param)
+{
+	WriteTaskParam *const p = static_cast<WriteTaskParam*>(param);
+	p->written = p->file->write(p->pData, p->len);
+}
+
+}
+
+class FstExtractorPrivate
+{
+	public:
+		explicit FstExtractorPrivate(IPartition *partition);
+		~FstExtractorPrivate();
+
+	private:
+		RP_DISABLE_COPY(FstExtractorPrivate)
+
+	public:
+		IPartition *partition;
+
+		// Buffer for copying through the partition.
+		// Two chunks: one is being written while the other one is being read.
+		uint8_t *buf;
+
+		// Set to false if RpFile::copyRangeFrom() isn't supported,
+		// so it isn't retried for every file.
+		bool tryDirect;
+
+		// Statistics
+		unsigned int fileCount;
+		unsigned int errorCount;
+		off64_t totalSize;
+		off64_t directSize;
+
+	public:
+		/**
+		 * Is a filename from the FST safe to use in the output directory?
+		 * @param name Filename
+		 * @return True if safe; false if not.
+		 */
+		static bool isSafeName(const char *name);
+
+		/**
+		 * Copy a file using RpFile::copyRangeFrom().
+		 * @param dest		[in] Destination file
+		 * @param offset	[in] File offset in the partition
+		 * @param size		[in] File size
+		 * @return 0 on success; -ENOTSUP if the file isn't stored as-is; other negative POSIX error code on error.
+		 */
+		int copyDirect(RpFile *dest, off64_t offset, off64_t size);
+
+		/**
+		 * Copy a file by reading it through the partition.
+		 * @param dest		[in] Destination file
+		 * @param offset	[in] File offset in the partition
+		 * @param size		[in] File size
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int copyBuffered(RpFile *dest, off64_t offset, off64_t size);
+
+		/**
+		 * Extract a file.
+		 * @param outname	[in] Output filename
+		 * @param offset	[in] File offset in the partition
+		 * @param size		[in] File size
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int extractFile(const string &outname, off64_t offset, off64_t size);
+
+		/**
+		 * Extract a directory recursively.
+		 * @param fst		[in] IFst
+		 * @param path		[in] Directory path in the FST
+		 * @param outdir	[in] Output directory, with a trailing separator
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int extractDir(IFst *fst, const string &path, const string &outdir);
+};
+
+/** FstExtractorPrivate **/
+
+FstExtractorPrivate::FstExtractorPrivate(IPartition *partition)
+	: partition(partition ? static_cast<IPartition*>(partition->ref()) : nullptr)
+	, buf(nullptr)
+	, tryDirect(true)
+	, fileCount(0)
+	, errorCount(0)
+	, totalSize(0)
+	, directSize(0)
+{ }
+
+FstExtractorPrivate::~FstExtractorPrivate()
+{
+	aligned_free(buf);
+	UNREF(partition);
+}
+
+/**
+ * Is a filename from the FST safe to use in the output directory?
+ * @param name Filename
+ * @return True if safe; false if not.
+ */
+bool FstExtractorPrivate::isSafeName(const char *name)
+{
+	if (!name || name[0] == '\0') {
+		return false;
+	} else if (!strcmp(name, ".") || !strcmp(name, "..")) {
+		return false;
+	}
+
+	// Don't allow path separators, which could be
+	// used to write outside of the output directory.
+	for (const char *p = name; *p != '\0'; p++) {
+		if (*p == '/' || *p == '\\') {
+			return false;
+		}
+#ifdef _WIN32
+		if (*p == ':') {
+			// Drive letter or alternate data stream.
+			return false;
+		}
+#endif /* _WIN32 */
+	}
+	return true;
+}
+
+/**
+ * Copy a file using RpFile::copyRangeFrom().
+ * @param dest		[in] Destination file
+ * @param offset	[in] File offset in the partition
+ * @param size		[in] File size
+ * @return 0 on success; -ENOTSUP if the file isn't stored as-is; other negative POSIX error code on error.
+ */
+int FstExtractorPrivate::copyDirect(RpFile *dest, off64_t offset, off64_t size)
+{
+	if (!tryDirect) {
+		return -ENOTSUP;
+	}
+
+	off64_t filePos = 0;
+	IRpFile *file = partition->getFileRange(offset, size, &filePos);
+	while (file && file->baseFile()) {
+		// Decorator, e.g. RomDataFactory's header cache.
+		// Positions are passed through as-is, so use the underlying file.
+		file = file->baseFile();
+	}
+	RpFile *const src = dynamic_cast<RpFile*>(file);
+	if (!src) {
+		// File isn't stored as-is, or it's not a regular file.
+		return -ENOTSUP;
+	}
+
+	const off64_t ret = dest->copyRangeFrom(src, filePos, size);
+	if (ret == -ENOTSUP) {
+		// Not supported for these files.
+		tryDirect = false;
+		return -ENOTSUP;
+	} else if (ret < 0) {
+		return static_cast<int>(ret);
+	} else if (ret != size) {
+		// Short copy.
+		return -EIO;
+	}
+
+	directSize += size;
+	return 0;
+}
+
+/**
+ * Copy a file by reading it through the partition.
+ * @param dest		[in] Destination file
+ * @param offset	[in] File offset in the partition
+ * @param size		[in] File size
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int FstExtractorPrivate::copyBuffered(RpFile *dest, off64_t offset, off64_t size)
+{
+	if (size == 0) {
+		return 0;
+	}
+	if (!buf) {
+		buf = static_cast<uint8_t*>(aligned_malloc(16, CHUNK_SIZE * 2));
+		if (!buf) {
+			return -ENOMEM;
+		}
+	}
+
+	if (partition->seek(offset) != 0) {
+		const int err = partition->lastError();
+		return (err != 0 ? -err : -EIO);
+	}
+
+	uint8_t *pCur = buf, *pNext = buf + CHUNK_SIZE;
+	off64_t remain = size;
+	size_t len_cur = static_cast<size_t>(std::min<off64_t>(remain, CHUNK_SIZE));
+	if (partition->read(pCur, len_cur) != len_cur) {
+		return -EIO;
+	}
+	remain -= len_cur;
+
+	int ret = 0;
+	TaskGroup group;
+	while (len_cur > 0) {
+		// Write the current chunk using the thread pool.
+		WriteTaskParam param = {dest, pCur, len_cur, 0};
+		group.run(writeTask, &param);
+
+		// Read the next chunk on this thread.
+		size_t len_next = static_cast<size_t>(std::min<off64_t>(remain, CHUNK_SIZE));
+		if (len_next > 0) {
+			if (partition->read(pNext, len_next) != len_next) {
+				ret = -EIO;
+			}
+			remain -= len_next;
+		}
+		group.wait();
+
+		if (param.written != len_cur) {
+			const int err = dest->lastError();
+			ret = (err != 0 ? -err : -EIO);
+		}
+		if (ret != 0)
+			break;
+
+		std::swap(pCur, pNext);
+		len_cur = len_next;
+	}
+
+	return ret;
+}
+
+/**
+ * Extract a file.
+ * @param outname	[in] Output filename
+ * @param offset	[in] File offset in the partition
+ * @param size		[in] File size
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int FstExtractorPrivate::extractFile(const string &outname, off64_t offset, off64_t size)
+{
+	const off64_t partition_size = partition->size();
+	if (offset < 0 || size < 0 || offset > partition_size || size > partition_size - offset) {
+		// File is out of bounds.
+		return -EIO;
+	}
+
+	RpFile *const dest = new RpFile(outname, RpFile::FM_CREATE_WRITE);
+	if (!dest->isOpen()) {
+		const int err = dest->lastError();
+		dest->unref();
+		return (err != 0 ? -err : -EIO);
+	}
+
+	int ret = copyDirect(dest, offset, size);
+	if (ret == -ENOTSUP) {
+		ret = copyBuffered(dest, offset, size);
+	}
+	dest->unref();
+
+	if (ret != 0) {
+		// Don't leave a partial file behind.
+		FileSystem::delete_file(outname.c_str());
+		return ret;
+	}
+
+	totalSize += size;
+	return 0;
+}
+
+/**
+ * Extract a directory recursively.
+ * @param fst		[in] IFst
+ * @param path		[in] Directory path in the FST
+ * @param outdir	[in] Output directory, with a trailing separator
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int FstExtractorPrivate::extractDir(IFst *fst, const string &path, const string &outdir)
+{
+	int ret = FileSystem::rmkdir(outdir);
+	if (ret != 0) {
+		return (ret < 0 ? ret : -EIO);
+	}
+
+	IFst::Dir *const dirp = fst->opendir(path);
+	if (!dirp) {
+		return -EIO;
+	}
+
+	// Read the entire directory first, since extractDir()
+	// opens subdirectories while this one is being processed.
+	struct Entry {
+		string name;
+		off64_t offset;
+		off64_t size;
+		uint8_t type;
+	};
+	vector<Entry> entries;
+	for (const IFst::DirEnt *dirent = fst->readdir(dirp); dirent != nullptr; dirent = fst->readdir(dirp)) {
+		Entry entry;
+		entry.name = (dirent->name ? dirent->name : "");
+		entry.offset = dirent->offset;
+		entry.size = dirent->size;
+		entry.type = dirent->type;
+		entries.emplace_back(std::move(entry));
+	}
+	fst->closedir(dirp);
+
+	for (const Entry &entry : entries) {
+		int ret_entry;
+		if (!isSafeName(entry.name.c_str())) {
+			ret_entry = -EINVAL;
+			errorCount++;
+		} else if (entry.type == DT_DIR) {
+			string subpath = path;
+			if (subpath.empty() || subpath[subpath.size()-1] != '/') {
+				subpath += '/';
+			}
+			subpath += entry.name;
+			ret_entry = extractDir(fst, subpath, outdir + entry.name + DIR_SEP_CHR);
+		} else if (entry.type == DT_REG) {
+			ret_entry = extractFile(outdir + entry.name, entry.offset, entry.size);
+			if (ret_entry == 0) {
+				fileCount++;
+			} else {
+				errorCount++;
+			}
+		} else {
+			// Not a regular file or a directory.
+			continue;
+		}
+
+		if (ret_entry != 0 && ret == 0) {
+			// Keep the first error.
+			ret = ret_entry;
+		}
+	}
+
+	return ret;
+}
+
+/** FstExtractor **/
+
+/**
+ * Create an FstExtractor for a partition.
+ * @param partition Partition with a file system table. (will be ref()'d)
+ */
+FstExtractor::FstExtractor(IPartition *partition)
+	: d_ptr(new FstExtractorPrivate(partition))
+{ }
+
+FstExtractor::~FstExtractor()
+{
+	delete d_ptr;
+}
+
+/**
+ * Extract all files to a directory.
+ *
+ * Subdirectories are created as needed, and existing files
+ * are overwritten. If a file can't be extracted, the remaining
+ * files are still extracted, and the first error is returned.
+ *
+ * Files that are stored as-is in the underlying disc image file
+ * are copied using RpFile::copyRangeFrom() if possible. Other
+ * files, e.g. compressed or encrypted, are read through the
+ * partition while the previous chunk is being written.
+ *
+ * @param outdir Output directory
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int FstExtractor::extractAll(const char *outdir)
+{
+	RP_D(FstExtractor);
+	assert(outdir != nullptr);
+	if (!outdir || outdir[0] == '\0') {
+		return -EINVAL;
+	} else if (!d->partition || !d->partition->isOpen()) {
+		return -EBADF;
+	}
+
+	IFst *const fst = d->partition->fst();
+	if (!fst) {
+		// No file system table.
+		return -ENOENT;
+	}
+
+	string s_outdir = outdir;
+	if (s_outdir[s_outdir.size()-1] != DIR_SEP_CHR) {
+		s_outdir += DIR_SEP_CHR;
+	}
+	return d->extractDir(fst, "/", s_outdir);
+}
+
+/** Statistics **/
+
+/**
+ * Get the number of files that were extracted.
+ * @return Number of files
+ */
+unsigned int FstExtractor::fileCount(void) const
+{
+	RP_D(const FstExtractor);
+	return d->fileCount;
+}
+
+/**
+ * Get the number of files that couldn't be extracted.
+ * @return Number of files
+ */
+unsigned int FstExtractor::errorCount(void) const
+{
+	RP_D(const FstExtractor);
+	return d->errorCount;
+}
+
+/**
+ * Get the total number of bytes that were extracted.
+ * @return Number of bytes
+ */
+off64_t FstExtractor::totalSize(void) const
+{
+	RP_D(const FstExtractor);
+	return d->totalSize;
+}
+
+/**
+ * Get the number of bytes that were copied directly
+ * from the underlying disc image file.
+ * @return Number of bytes
+ */
+off64_t FstExtractor::directSize(void) const
+{
+	RP_D(const FstExtractor);
+	return d->directSize;
+}
+
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * FstExtractor.hpp: Extract files from a partition's file system table.   *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "common.h"
+#include "dll-macros.h"	// for RP_LIBROMDATA_PUBLIC
+
+// C includes.
+#include <stdint.h>
+#include <sys/types.h>	// for off64_t
+
+// C++ includes.
+#include <string>
+
+namespace LibRpBase {
+	class IPartition;
+}
+
+namespace LibRomData {
+
+class FstExtractorPrivate;
+class FstExtractor
+{
+	public:
+		/**
+		 * Create an FstExtractor for a partition.
+		 * @param partition Partition with a file system table. (will be ref()'d)
+		 */
+		RP_LIBROMDATA_PUBLIC
+		explicit FstExtractor(LibRpBase::IPartition *partition);
+
+		RP_LIBROMDATA_PUBLIC
+		~FstExtractor();
+
+	private:
+		RP_DISABLE_COPY(FstExtractor)
+	private:
+		friend class FstExtractorPrivate;
+		FstExtractorPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Extract all files to a directory.
+		 *
+		 * Subdirectories are created as needed, and existing files
+		 * are overwritten. If a file can't be extracted, the remaining
+		 * files are still extracted, and the first error is returned.
+		 *
+		 * Files that are stored as-is in the underlying disc image file
+		 * are copied using RpFile::copyRangeFrom() if possible. Other
+		 * files, e.g. compressed or encrypted, are read through the
+		 * partition while the previous chunk is being written.
+		 *
+		 * @param outdir Output directory
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int extractAll(const char *outdir);
+
+		/**
+		 * Extract all files to a directory.
+		 * @param outdir Output directory
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int extractAll(const std::string &outdir)
+		{
+			return extractAll(outdir.c_str());
+		}
+
+	public:
+		/** Statistics **/
+
+		/**
+		 * Get the number of files that were extracted.
+		 * @return Number of files
+		 */
+		RP_LIBROMDATA_PUBLIC
+		unsigned int fileCount(void) const;
+
+		/**
+		 * Get the number of files that couldn't be extracted.
+		 * @return Number of files
+		 */
+		RP_LIBROMDATA_PUBLIC
+		unsigned int errorCount(void) const;
+
+		/**
+		 * Get the total number of bytes that were extracted.
+		 * @return Number of bytes
+		 */
+		RP_LIBROMDATA_PUBLIC
+		off64_t totalSize(void) const;
+
+		/**
+		 * Get the number of bytes that were copied directly
+		 * from the underlying disc image file.
+		 * @return Number of bytes
+		 */
+		RP_LIBROMDATA_PUBLIC
+		off64_t directSize(void) const;
+};
+
+}
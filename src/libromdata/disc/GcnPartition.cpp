@@ -187,6 +187,46 @@ off64_t GcnPartition::partition_size_used(void) const
 	return size;
 }
 
+/**
+ * Get the partition's file system table.
+ * @return IFst (owned by this partition), or nullptr on error.
+ */
+IFst *GcnPartition::fst(void)
+{
+	RP_D(GcnPartition);
+	if (!d->fst) {
+		// FST isn't loaded.
+		if (d->loadFst() != 0) {
+			// FST load failed.
+			return nullptr;
+		}
+	}
+	return d->fst;
+}
+
+/** Direct file access **/
+
+/**
+ * Get the underlying file for a range of the partition.
+ * @param pos		[in] Starting position in the partition
+ * @param size		[in] Size of the range, in bytes
+ * @param pFilePos	[out] Starting position in the underlying file
+ * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+ */
+IRpFile *GcnPartition::getFileRange(off64_t pos, off64_t size, off64_t *pFilePos)
+{
+	RP_D(const GcnPartition);
+	if (!m_discReader || pos < 0 || size < 0 ||
+	    pos > d->data_size || size > d->data_size - pos)
+	{
+		return nullptr;
+	}
+
+	// GCN partitions are stored as-is, so the disc reader
+	// determines if the range can be accessed directly.
+	return m_discReader->getFileRange(d->data_offset + pos, size, pFilePos);
+}
+
 /** GcnPartition **/
 
 /** GcnFst wrapper functions. **/
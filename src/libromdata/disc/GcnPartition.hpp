@@ -91,6 +91,24 @@ class GcnPartition : public LibRpBase::IPartition
 		 */
 		off64_t partition_size_used(void) const override;
 
+		/**
+		 * Get the partition's file system table.
+		 * @return IFst (owned by this partition), or nullptr on error.
+		 */
+		LibRpBase::IFst *fst(void) final;
+
+	public:
+		/** Direct file access **/
+
+		/**
+		 * Get the underlying file for a range of the partition.
+		 * @param pos		[in] Starting position in the partition
+		 * @param size		[in] Size of the range, in bytes
+		 * @param pFilePos	[out] Starting position in the underlying file
+		 * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+		 */
+		LibRpFile::IRpFile *getFileRange(off64_t pos, off64_t size, off64_t *pFilePos) override;
+
 	public:
 		/** IFst wrapper functions. **/
 
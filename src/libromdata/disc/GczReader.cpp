@@ -509,4 +509,18 @@ int GczReader::readBlock(uint32_t blockIdx, int pos, void *ptr, size_t size)
 	return static_cast<int>(size);
 }
 
+/**
+ * Read multiple consecutive full blocks.
+ * @param blockIdx	[in] First block index.
+ * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+ * @param blockCount	[in] Number of blocks to read.
+ * @return Number of bytes read.
+ */
+size_t GczReader::readBlocks(uint32_t blockIdx, void *ptr, uint32_t blockCount)
+{
+	// Blocks may be compressed, so each block
+	// has to be read individually.
+	return readBlocksIndividually(blockIdx, ptr, blockCount);
+}
+
 }
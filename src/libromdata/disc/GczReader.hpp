@@ -76,6 +76,15 @@ class GczReader : public LibRpBase::SparseDiscReader
 		 */
 		ATTR_ACCESS_SIZE(write_only, 4, 5)
 		int readBlock(uint32_t blockIdx, int pos, void *ptr, size_t size) final;
+
+		/**
+		 * Read multiple consecutive full blocks.
+		 * @param blockIdx	[in] First block index.
+		 * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+		 * @param blockCount	[in] Number of blocks to read.
+		 * @return Number of bytes read.
+		 */
+		size_t readBlocks(uint32_t blockIdx, void *ptr, uint32_t blockCount) final;
 };
 
 }
@@ -11,6 +11,7 @@
 #include "librpbase/disc/SparseDiscReader_p.hpp"
 
 #include "../cdrom_structs.h"
+#include "Cdrom2352Reader.hpp"
 #include "IsoPartition.hpp"
 
 // Other rom-properties libraries
@@ -84,6 +85,14 @@ class GdiReaderPrivate : public SparseDiscReaderPrivate {
 		 * @return 0 on success; negative POSIX error code on error.
 		 */
 		int openTrack(int trackNumber);
+
+		/**
+		 * Find the block range containing the specified block.
+		 * The track will be opened if it isn't open already.
+		 * @param blockIdx Block index.
+		 * @return Block range, or nullptr if not found.
+		 */
+		const BlockRange *findBlockRange(uint32_t blockIdx);
 };
 
 /** GdiReaderPrivate **/
@@ -299,6 +308,43 @@ int GdiReaderPrivate::openTrack(int trackNumber)
 	return 0;
 }
 
+/**
+ * Find the block range containing the specified block.
+ * The track will be opened if it isn't open already.
+ * @param blockIdx Block index.
+ * @return Block range, or nullptr if not found.
+ */
+const GdiReaderPrivate::BlockRange *GdiReaderPrivate::findBlockRange(uint32_t blockIdx)
+{
+	// TODO: Cache this lookup somewhere or something.
+	for (const BlockRange &vbr : blockRanges) {
+		if (blockIdx < vbr.blockStart) {
+			// Not in this track.
+			continue;
+		}
+
+		// Is the track loaded?
+		if (vbr.blockEnd == 0) {
+			// Track isn't loaded. Load it.
+			int ret = openTrack(vbr.trackNumber);
+			if (ret != 0) {
+				// Unable to load the track.
+				// Skip for now.
+				continue;
+			}
+		}
+
+		// Check the end block.
+		if (vbr.blockEnd != 0 && blockIdx <= vbr.blockEnd) {
+			// Found the track.
+			return &vbr;
+		}
+	}
+
+	// Not found in any block range.
+	return nullptr;
+}
+
 /** GdiReader **/
 
 GdiReader::GdiReader(IRpFile *file)
@@ -507,33 +553,7 @@ int GdiReader::readBlock(uint32_t blockIdx, int pos, void *ptr, size_t size)
 	}
 
 	// Find the block.
-	// TODO: Cache this lookup somewhere or something.
-	const GdiReaderPrivate::BlockRange *blockRange = nullptr;
-	for (const GdiReaderPrivate::BlockRange &vbr : d->blockRanges) {
-		if (blockIdx < vbr.blockStart) {
-			// Not in this track.
-			continue;
-		}
-
-		// Is the track loaded?
-		if (vbr.blockEnd == 0) {
-			// Track isn't loaded. Load it.
-			int ret = d->openTrack(vbr.trackNumber);
-			if (ret != 0) {
-				// Unable to load the track.
-				// Skip for now.
-				continue;
-			}
-		}
-
-		// Check the end block.
-		if (vbr.blockEnd != 0 && blockIdx <= vbr.blockEnd) {
-			// Found the track.
-			blockRange = (const GdiReaderPrivate::BlockRange*)&vbr;
-			break;
-		}
-	}
-
+	const GdiReaderPrivate::BlockRange *const blockRange = d->findBlockRange(blockIdx);
 	if (!blockRange) {
 		// Not found in any block range.
 		return 0;
@@ -569,6 +589,66 @@ int GdiReader::readBlock(uint32_t blockIdx, int pos, void *ptr, size_t size)
 	return (sz_read > 0 ? static_cast<int>(sz_read) : -1);
 }
 
+/**
+ * Read multiple consecutive full blocks.
+ * @param blockIdx	[in] First block index.
+ * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+ * @param blockCount	[in] Number of blocks to read.
+ * @return Number of bytes read.
+ */
+size_t GdiReader::readBlocks(uint32_t blockIdx, void *ptr, uint32_t blockCount)
+{
+	// NOTE: This can only be called by SparseDiscReader,
+	// so the main assertions are already checked there.
+	RP_D(GdiReader);
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+
+	while (blockCount > 0) {
+		const GdiReaderPrivate::BlockRange *const blockRange = d->findBlockRange(blockIdx);
+		if (!blockRange || !blockRange->file) {
+			// Not found in any block range,
+			// or the file isn't open.
+			// Fall back to reading individual blocks.
+			const size_t rd = readBlocksIndividually(blockIdx, ptr8, 1);
+			ret += rd;
+			if (rd != d->block_size) {
+				break;
+			}
+			blockIdx++;
+			blockCount--;
+			ptr8 += d->block_size;
+			continue;
+		}
+
+		// Read as many blocks as possible from this track.
+		const uint32_t count = std::min(blockCount, blockRange->blockEnd - blockIdx + 1);
+		const off64_t phys_pos = static_cast<off64_t>(blockIdx - blockRange->blockStart) * blockRange->sectorSize;
+		const size_t sz_req = static_cast<size_t>(count) * d->block_size;
+		size_t sz_read;
+		if (blockRange->sectorSize == 2352) {
+			// 2352-byte sectors.
+			// TODO: Handle audio tracks properly?
+			sz_read = Cdrom2352Reader::readSectorUserData(blockRange->file, phys_pos, 2352, ptr8, count);
+		} else {
+			// 2048-byte sectors.
+			sz_read = blockRange->file->seekAndRead(phys_pos, ptr8, sz_req);
+		}
+		m_lastError = blockRange->file->lastError();
+		ret += sz_read;
+		if (sz_read != sz_req) {
+			// Short read.
+			break;
+		}
+
+		blockIdx += count;
+		blockCount -= count;
+		ptr8 += sz_req;
+	}
+
+	return ret;
+}
+
 /** GDI-specific functions. **/
 // TODO: "CdromReader" class?
 
@@ -21,12 +21,17 @@ using std::unordered_map;
 
 namespace LibRomData {
 
-class IsoPartitionPrivate
+/**
+ * IsoPartitionPrivate also implements IFst using the
+ * cached directories, so IsoPartition::fst() doesn't
+ * need a separate copy of the directory tables.
+ */
+class IsoPartitionPrivate final : public IFst
 {
 	public:
 		IsoPartitionPrivate(IsoPartition *q,
 			off64_t partition_offset, int iso_start_offset);
-		~IsoPartitionPrivate();
+		~IsoPartitionPrivate() final;
 
 	private:
 		RP_DISABLE_COPY(IsoPartitionPrivate)
@@ -53,6 +58,21 @@ class IsoPartitionPrivate
 		// -1 == unknown
 		int iso_start_offset;
 
+		// Set if an invalid directory entry was found.
+		bool fstHasErrors;
+
+		// Filename buffer for find_file(). [UTF-8]
+		string find_name;
+
+		/**
+		 * IFst::Dir for an ISO-9660 directory.
+		 * dir_idx is the byte offset of the next directory entry.
+		 */
+		struct IsoDir : public IFst::Dir {
+			const DirData_t *pDir;	// Directory
+			string name;		// Current filename [UTF-8]
+		};
+
 		/**
 		 * Find the last slash or backslash in a path.
 		 * @param path Path.
@@ -70,6 +90,31 @@ class IsoPartitionPrivate
 			return (sl ? sl : bs);
 		}
 
+		/**
+		 * Get the next directory entry.
+		 * Padding at the end of each logical block is skipped.
+		 * @param pDir		[in] Directory
+		 * @param pOffset	[in/out] Byte offset of the next directory entry
+		 * @return ISO directory entry, or nullptr if there are no more entries.
+		 */
+		const ISO_DirEntry *nextDirEntry(const DirData_t *pDir, size_t *pOffset);
+
+		/**
+		 * Get the filename from an ISO directory entry.
+		 * The version number (";1") and a trailing '.' are removed.
+		 * @param dirEntry ISO directory entry
+		 * @return Filename [UTF-8]
+		 */
+		static string entryName(const ISO_DirEntry *dirEntry);
+
+		/**
+		 * Fill in an IFst::DirEnt from an ISO directory entry.
+		 * The filename is not set.
+		 * @param dirEntry	[in] ISO directory entry
+		 * @param dirent	[out] IFst::DirEnt
+		 */
+		void toDirEnt(const ISO_DirEntry *dirEntry, IFst::DirEnt *dirent) const;
+
 		/**
 		 * Look up a directory entry from a base filename and directory.
 		 * @param pDir		[in] Directory
@@ -100,6 +145,51 @@ class IsoPartitionPrivate
 		 * @return Unix time.
 		 */
 		time_t parseTimestamp(const ISO_Dir_DateTime_t *isofiletime);
+
+	public:
+		/** IFst **/
+
+		/**
+		 * Is the FST open?
+		 * @return True if open; false if not.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * Have any errors been detected in the FST?
+		 * @return True if yes; false if no.
+		 */
+		bool hasErrors(void) const final;
+
+		/**
+		 * Open a directory.
+		 * @param path	[in] Directory path. [UTF-8]
+		 * @return Dir*, or nullptr on error.
+		 */
+		Dir *opendir(const char *path) final;
+
+		/**
+		 * Read a directory entry.
+		 * "." and ".." are skipped.
+		 * @param dirp Dir pointer.
+		 * @return DirEnt*, or nullptr if end of directory or on error.
+		 */
+		DirEnt *readdir(Dir *dirp) final;
+
+		/**
+		 * Close an opened directory.
+		 * @param dirp Dir pointer.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int closedir(Dir *dirp) final;
+
+		/**
+		 * Get the directory entry for the specified file.
+		 * @param filename	[in] Filename. [UTF-8]
+		 * @param dirent	[out] Pointer to DirEnt buffer.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int find_file(const char *filename, DirEnt *dirent) final;
 };
 
 /** IsoPartitionPrivate **/
@@ -110,6 +200,7 @@ IsoPartitionPrivate::IsoPartitionPrivate(IsoPartition *q,
 	, partition_offset(partition_offset)
 	, partition_size(0)
 	, iso_start_offset(iso_start_offset)
+	, fstHasErrors(false)
 {
 	// Clear the PVD struct.
 	memset(&pvd, 0, sizeof(pvd));
@@ -155,6 +246,97 @@ IsoPartitionPrivate::IsoPartitionPrivate(IsoPartition *q,
 IsoPartitionPrivate::~IsoPartitionPrivate()
 { }
 
+/**
+ * Get the next directory entry.
+ * Padding at the end of each logical block is skipped.
+ * @param pDir		[in] Directory
+ * @param pOffset	[in/out] Byte offset of the next directory entry
+ * @return ISO directory entry, or nullptr if there are no more entries.
+ */
+const ISO_DirEntry *IsoPartitionPrivate::nextDirEntry(const DirData_t *pDir, size_t *pOffset)
+{
+	const unsigned int block_size = pvd.logical_block_size.he;
+	const size_t dir_size = pDir->size();
+	size_t offset = *pOffset;
+	while (offset < dir_size) {
+		const ISO_DirEntry *const dirEntry = reinterpret_cast<const ISO_DirEntry*>(pDir->data() + offset);
+		if (dirEntry->entry_length == 0) {
+			// Directory entries can't cross logical block boundaries,
+			// so the rest of this block is padding.
+			if (block_size == 0)
+				break;
+			offset = ((offset / block_size) + 1) * block_size;
+			continue;
+		}
+
+		if (dirEntry->entry_length < sizeof(*dirEntry) ||
+		    dirEntry->entry_length > dir_size - offset ||
+		    sizeof(*dirEntry) + dirEntry->filename_length > dirEntry->entry_length)
+		{
+			// Directory entry is invalid or out of bounds.
+			fstHasErrors = true;
+			break;
+		}
+
+		*pOffset = offset + dirEntry->entry_length;
+		return dirEntry;
+	}
+
+	// No more entries.
+	*pOffset = dir_size;
+	return nullptr;
+}
+
+/**
+ * Get the filename from an ISO directory entry.
+ * The version number (";1") and a trailing '.' are removed.
+ * @param dirEntry ISO directory entry
+ * @return Filename [UTF-8]
+ */
+string IsoPartitionPrivate::entryName(const ISO_DirEntry *dirEntry)
+{
+	// TODO: Which encoding?
+	// Assuming cp1252...
+	const char *const entry_filename = reinterpret_cast<const char*>(dirEntry) + sizeof(*dirEntry);
+	size_t len = dirEntry->filename_length;
+
+	// Remove the version number.
+	const char *const semi = static_cast<const char*>(memchr(entry_filename, ';', len));
+	if (semi) {
+		len = semi - entry_filename;
+	}
+
+	// Filenames without an extension have a trailing '.', e.g. "README.;1".
+	if (len > 1 && entry_filename[len-1] == '.') {
+		len--;
+	}
+
+	return cp1252_to_utf8(entry_filename, static_cast<int>(len));
+}
+
+/**
+ * Fill in an IFst::DirEnt from an ISO directory entry.
+ * The filename is not set.
+ * @param dirEntry	[in] ISO directory entry
+ * @param dirent	[out] IFst::DirEnt
+ */
+void IsoPartitionPrivate::toDirEnt(const ISO_DirEntry *dirEntry, IFst::DirEnt *dirent) const
+{
+	if (dirEntry->flags & ISO_FLAG_DIRECTORY) {
+		// offset and size are not valid for directories.
+		dirent->type = DT_DIR;
+		dirent->offset = 0;
+		dirent->size = 0;
+		return;
+	}
+
+	// TODO: What is an "associated" file?
+	// open() doesn't allow them, so don't report them as regular files.
+	dirent->type = (dirEntry->flags & ISO_FLAG_ASSOCIATED) ? DT_UNKNOWN : DT_REG;
+	dirent->offset = (static_cast<off64_t>(dirEntry->block.he) - iso_start_offset) * pvd.logical_block_size.he;
+	dirent->size = dirEntry->size.he;
+}
+
 /**
  * Look up a directory entry from a base filename and directory.
  * @param pDir		[in] Directory
@@ -170,20 +352,10 @@ const ISO_DirEntry *IsoPartitionPrivate::lookup_int(const DirData_t *pDir, const
 	int err = ENOENT;
 	const unsigned int filename_len = static_cast<unsigned int>(strlen(filename));
 	const ISO_DirEntry *dirEntry_found = nullptr;
-	const uint8_t *p = pDir->data();
-	const uint8_t *const p_end = p + pDir->size();
-	while (p < p_end) {
-		const ISO_DirEntry *dirEntry = reinterpret_cast<const ISO_DirEntry*>(p);
-		if (dirEntry->entry_length < sizeof(*dirEntry)) {
-			// End of directory.
-			break;
-		}
-
-		const char *const entry_filename = reinterpret_cast<const char*>(p) + sizeof(*dirEntry);
-		if (entry_filename + dirEntry->filename_length > reinterpret_cast<const char*>(p_end)) {
-			// Filename is out of bounds.
-			break;
-		}
+	size_t offset = 0;
+	const ISO_DirEntry *dirEntry;
+	while ((dirEntry = nextDirEntry(pDir, &offset)) != nullptr) {
+		const char *const entry_filename = reinterpret_cast<const char*>(dirEntry) + sizeof(*dirEntry);
 
 		// Check the filename.
 		// 1990s and early 2000s CD-ROM games usually have
@@ -218,9 +390,6 @@ const ISO_DirEntry *IsoPartitionPrivate::lookup_int(const DirData_t *pDir, const
 				break;
 			}
 		}
-
-		// Next entry.
-		p += dirEntry->entry_length;
 	}
 
 	if (!dirEntry_found) {
@@ -243,6 +412,7 @@ const IsoPartitionPrivate::DirData_t *IsoPartitionPrivate::getDirectory(const ch
 		// Root directory. Use "".
 		path = "";
 	}
+	const char *const fullPath = path;
 
 	// Check if this directory was already loaded.
 	auto iter = dir_data.find(path);
@@ -387,7 +557,7 @@ const IsoPartitionPrivate::DirData_t *IsoPartitionPrivate::getDirectory(const ch
 	}
 
 	// Subdirectory loaded.
-	auto ins = dir_data.emplace(path, std::move(dir));
+	auto ins = dir_data.emplace(fullPath, std::move(dir));
 	return &(ins.first->second);
 }
 
@@ -480,6 +650,170 @@ time_t IsoPartitionPrivate::parseTimestamp(const ISO_Dir_DateTime_t *isofiletime
 	return unixtime;
 }
 
+/** IFst **/
+
+/**
+ * Is the FST open?
+ * @return True if open; false if not.
+ */
+bool IsoPartitionPrivate::isOpen(void) const
+{
+	return (q_ptr->m_discReader != nullptr);
+}
+
+/**
+ * Have any errors been detected in the FST?
+ * @return True if yes; false if no.
+ */
+bool IsoPartitionPrivate::hasErrors(void) const
+{
+	return fstHasErrors;
+}
+
+/**
+ * Open a directory.
+ * @param path	[in] Directory path. [UTF-8]
+ * @return Dir*, or nullptr on error.
+ */
+IFst::Dir *IsoPartitionPrivate::opendir(const char *path)
+{
+	assert(path != nullptr);
+	if (!path) {
+		return nullptr;
+	}
+
+	// Remove leading and trailing slashes.
+	while (*path == '/') {
+		path++;
+	}
+	size_t len = strlen(path);
+	while (len > 0 && path[len-1] == '/') {
+		len--;
+	}
+
+	// TODO: Which encoding?
+	// Assuming cp1252...
+	const DirData_t *pDir;
+	if (len == 0) {
+		// Root directory.
+		pDir = getDirectory("");
+	} else {
+		const string s_path = utf8_to_cp1252(path, static_cast<int>(len));
+		pDir = getDirectory(s_path.c_str());
+	}
+	if (!pDir) {
+		// Directory not found.
+		// getDirectory() has already set q->lastError.
+		return nullptr;
+	}
+
+	IsoDir *const dirp = new IsoDir;
+	dirp->parent = this;
+	dirp->dir_idx = 0;
+	dirp->pDir = pDir;
+
+	// Initialize the entry to this directory.
+	// readdir() will automatically seek to the next entry.
+	dirp->entry.idx = 0;
+	dirp->entry.type = DT_DIR;
+	dirp->entry.name = dirp->name.c_str();
+	// offset and size are not valid for directories.
+	dirp->entry.offset = 0;
+	dirp->entry.size = 0;
+	return dirp;
+}
+
+/**
+ * Read a directory entry.
+ * "." and ".." are skipped.
+ * @param dirp Dir pointer.
+ * @return DirEnt*, or nullptr if end of directory or on error.
+ */
+IFst::DirEnt *IsoPartitionPrivate::readdir(IFst::Dir *dirp)
+{
+	assert(dirp != nullptr);
+	assert(dirp->parent == this);
+	if (!dirp || dirp->parent != this) {
+		// No directory pointer, or the dirp
+		// doesn't belong to this IFst.
+		return nullptr;
+	}
+
+	IsoDir *const isoDir = static_cast<IsoDir*>(dirp);
+	size_t offset = static_cast<size_t>(dirp->dir_idx);
+	const ISO_DirEntry *dirEntry;
+	while ((dirEntry = nextDirEntry(isoDir->pDir, &offset)) != nullptr) {
+		const char *const entry_filename = reinterpret_cast<const char*>(dirEntry) + sizeof(*dirEntry);
+		if (dirEntry->filename_length == 1 &&
+		    (entry_filename[0] == '\0' || entry_filename[0] == '\1'))
+		{
+			// "." or ".."
+			continue;
+		}
+		break;
+	}
+	dirp->dir_idx = static_cast<int>(offset);
+	if (!dirEntry) {
+		// No more entries.
+		return nullptr;
+	}
+
+	isoDir->name = entryName(dirEntry);
+	toDirEnt(dirEntry, &dirp->entry);
+	dirp->entry.name = isoDir->name.c_str();
+	// File index is the directory entry's byte offset.
+	dirp->entry.idx = static_cast<int>(reinterpret_cast<const uint8_t*>(dirEntry) - isoDir->pDir->data());
+	return &dirp->entry;
+}
+
+/**
+ * Close an opened directory.
+ * @param dirp Dir pointer.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int IsoPartitionPrivate::closedir(IFst::Dir *dirp)
+{
+	assert(dirp != nullptr);
+	assert(dirp->parent == this);
+	if (!dirp) {
+		// No directory pointer.
+		// In release builds, this is a no-op.
+		return 0;
+	} else if (dirp->parent != this) {
+		// The dirp doesn't belong to this IFst.
+		return -EINVAL;
+	}
+
+	delete static_cast<IsoDir*>(dirp);
+	return 0;
+}
+
+/**
+ * Get the directory entry for the specified file.
+ * @param filename	[in] Filename. [UTF-8]
+ * @param dirent	[out] Pointer to DirEnt buffer.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int IsoPartitionPrivate::find_file(const char *filename, DirEnt *dirent)
+{
+	if (!filename || filename[0] == '\0' || !dirent) {
+		// Invalid parameters.
+		return -EINVAL;
+	}
+
+	const ISO_DirEntry *const dirEntry = lookup(filename);
+	if (!dirEntry) {
+		// Not found.
+		return -ENOENT;
+	}
+
+	find_name = entryName(dirEntry);
+	toDirEnt(dirEntry, dirent);
+	dirent->name = find_name.c_str();
+	dirent->idx = 0;
+	return 0;
+}
+
 /** IsoPartition **/
 
 /**
@@ -613,13 +947,47 @@ off64_t IsoPartition::partition_size_used(void) const
 	return partition_size();
 }
 
-/** IsoPartition **/
+/**
+ * Get the partition's file system table.
+ * @return IFst (owned by this partition), or nullptr on error.
+ */
+IFst *IsoPartition::fst(void)
+{
+	RP_D(IsoPartition);
+	if (!m_discReader) {
+		// ISO-9660 isn't loaded.
+		return nullptr;
+	}
+	return d;
+}
+
+/** Direct file access **/
+
+/**
+ * Get the underlying file for a range of the partition.
+ * @param pos		[in] Starting position in the partition
+ * @param size		[in] Size of the range, in bytes
+ * @param pFilePos	[out] Starting position in the underlying file
+ * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+ */
+IRpFile *IsoPartition::getFileRange(off64_t pos, off64_t size, off64_t *pFilePos)
+{
+	RP_D(const IsoPartition);
+	if (!m_discReader || pos < 0 || size < 0 ||
+	    pos > d->partition_size || size > d->partition_size - pos)
+	{
+		return nullptr;
+	}
+
+	// ISO partitions are stored as-is, so the disc reader
+	// determines if the range can be accessed directly.
+	return m_discReader->getFileRange(d->partition_offset + pos, size, pFilePos);
+}
 
-/** GcnFst wrapper functions. **/
+/** IsoPartition **/
 
-// TODO
+/** IFst wrapper functions. **/
 
-#if 0
 /**
  * Open a directory.
  * @param path	[in] Directory path.
@@ -628,16 +996,7 @@ off64_t IsoPartition::partition_size_used(void) const
 IFst::Dir *IsoPartition::opendir(const char *path)
 {
 	RP_D(IsoPartition);
-	if (!d->fst) {
-		// FST isn't loaded.
-		if (d->loadFst() != 0) {
-			// FST load failed.
-			// TODO: Errors?
-			return nullptr;
-		}
-	}
-
-	return d->fst->opendir(path);
+	return d->opendir(path);
 }
 
 /**
@@ -649,12 +1008,7 @@ IFst::Dir *IsoPartition::opendir(const char *path)
 IFst::DirEnt *IsoPartition::readdir(IFst::Dir *dirp)
 {
 	RP_D(IsoPartition);
-	if (!d->fst) {
-		// TODO: Errors?
-		return nullptr;
-	}
-
-	return d->fst->readdir(dirp);
+	return d->readdir(dirp);
 }
 
 /**
@@ -665,14 +1019,8 @@ IFst::DirEnt *IsoPartition::readdir(IFst::Dir *dirp)
 int IsoPartition::closedir(IFst::Dir *dirp)
 {
 	RP_D(IsoPartition);
-	if (!d->fst) {
-		// TODO: Errors?
-		return -EBADF;
-	}
-
-	return d->fst->closedir(dirp);
+	return d->closedir(dirp);
 }
-#endif
 
 /**
  * Open a file. (read-only)
@@ -9,7 +9,7 @@
 #pragma once
 
 #include "librpbase/disc/IPartition.hpp"
-//#include "librpbase/disc/IFst.hpp"
+#include "librpbase/disc/IFst.hpp"
 
 namespace LibRomData {
 
@@ -90,11 +90,27 @@ class IsoPartition final : public LibRpBase::IPartition
 		 */
 		off64_t partition_size_used(void) const final;
 
+		/**
+		 * Get the partition's file system table.
+		 * @return IFst (owned by this partition), or nullptr on error.
+		 */
+		LibRpBase::IFst *fst(void) final;
+
+	public:
+		/** Direct file access **/
+
+		/**
+		 * Get the underlying file for a range of the partition.
+		 * @param pos		[in] Starting position in the partition
+		 * @param size		[in] Size of the range, in bytes
+		 * @param pFilePos	[out] Starting position in the underlying file
+		 * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+		 */
+		LibRpFile::IRpFile *getFileRange(off64_t pos, off64_t size, off64_t *pFilePos) final;
+
 	public:
 		/** IFst wrapper functions. **/
 
-		// TODO
-#if 0
 		/**
 		 * Open a directory.
 		 * @param path	[in] Directory path.
@@ -126,7 +142,6 @@ class IsoPartition final : public LibRpBase::IPartition
 		 * @return 0 on success; negative POSIX error code on error.
 		 */
 		int closedir(LibRpBase::IFst::Dir *dirp);
-#endif
 
 		/**
 		 * Open a file. (read-only)
@@ -2,7 +2,7 @@
  * ROM Properties Page shell extension. (libromdata)                       *
  * NCCHReader.cpp: Nintendo 3DS NCCH reader.                               *
  *                                                                         *
- * Copyright (c) 2016-2022 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -39,9 +39,10 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q,
 	, headers_loaded(0)
 	, pos(0)
 	, verifyResult(KeyManager::VerifyResult::Unknown)
+	, rangeCache_next(0)
 #ifdef ENABLE_DECRYPTION
 	, tid_be(0)
-	, cipher(nullptr)
+	, ciphers{nullptr, nullptr}
 	, tmd_content_index(0)
 	, isDebug(false)
 #endif /* ENABLE_DECRYPTION */
@@ -158,8 +159,9 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q,
 	{
 		// Initialize the AES cipher.
 		// TODO: Check for errors.
-		cipher = AesCipherFactory::create();
+		IAesCipher *const cipher = AesCipherFactory::create();
 		cipher->setChainingMode(IAesCipher::ChainingMode::CTR);
+		ciphers[0] = cipher;
 		u128_t ctr;
 
 		// FIXME: Verification if ExeFS isn't available.
@@ -195,7 +197,7 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q,
 				// so we'll try it as NoCrypto anyway.
 				memset(ncch_keys, 0, sizeof(ncch_keys));
 				delete cipher;
-				cipher = nullptr;
+				ciphers[0] = nullptr;
 				forceNoCrypto = true;
 				break;
 			}
@@ -212,7 +214,7 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q,
 				// so we'll try it as NoCrypto anyway.
 				memset(ncch_keys, 0, sizeof(ncch_keys));
 				delete cipher;
-				cipher = nullptr;
+				ciphers[0] = nullptr;
 				forceNoCrypto = true;
 				break;
 			}
@@ -238,11 +240,21 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q,
 			// so we'll try it as NoCrypto anyway.
 			memset(ncch_keys, 0, sizeof(ncch_keys));
 			delete cipher;
-			cipher = nullptr;
+			ciphers[0] = nullptr;
 			forceNoCrypto = true;
 		} } while (0);
 
 		if (!forceNoCrypto) {
+			// Set the keys. These won't change after this point.
+			// NOTE: If the ExeFS header was verified, ciphers[0]
+			// already has the correct key.
+			if (!(headers_loaded & HEADER_EXEFS)) {
+				ciphers[0]->setKey(ncch_keys[0].u8, sizeof(ncch_keys[0].u8));
+			}
+			ciphers[1] = AesCipherFactory::create();
+			ciphers[1]->setChainingMode(IAesCipher::ChainingMode::CTR);
+			ciphers[1]->setKey(ncch_keys[1].u8, sizeof(ncch_keys[1].u8));
+
 			// Initialize encrypted section handling.
 			// Reference: https://github.com/profi200/Project_CTR/blob/master/makerom/ncch.c
 			// Encryption details:
@@ -329,7 +341,8 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q,
 NCCHReaderPrivate::~NCCHReaderPrivate()
 {
 #ifdef ENABLE_DECRYPTION
-	delete cipher;
+	delete ciphers[0];
+	delete ciphers[1];
 #endif /* ENABLE_DECRYPTION */
 }
 
@@ -360,7 +373,8 @@ int NCCHReaderPrivate::findEncSection(uint32_t address) const
  * Read data from the underlying ROM image.
  * CIA decryption is automatically handled if set up properly.
  *
- * NOTE: Offset and size must both be multiples of 16.
+ * NOTE: Offset and size must both be multiples of 16
+ * if the data will be decrypted afterwards.
  *
  * @param offset	[in] Starting address, relative to the beginning of the NCCH.
  * @param ptr		[out] Output buffer.
@@ -370,10 +384,8 @@ int NCCHReaderPrivate::findEncSection(uint32_t address) const
 size_t NCCHReaderPrivate::readFromROM(uint32_t offset, void *ptr, size_t size)
 {
 	assert(ptr != nullptr);
-	assert(offset % 16 == 0);
-	assert(size % 16 == 0);
 	RP_Q(NCCHReader);
-	if (!ptr || offset % 16 != 0 || size % 16 != 0) {
+	if (!ptr) {
 		// Invalid parameters.
 		q->m_lastError = EINVAL;
 		return 0;
@@ -402,6 +414,59 @@ size_t NCCHReaderPrivate::readFromROM(uint32_t offset, void *ptr, size_t size)
 	return sz_read;
 }
 
+/**
+ * Read data from the decrypted range cache.
+ * @param offset	[in] Starting address, relative to the beginning of the NCCH.
+ * @param ptr		[out] Output buffer.
+ * @param size		[in] Amount of data to read.
+ * @return True if the entire range was cached; false if not.
+ */
+bool NCCHReaderPrivate::readFromRangeCache(uint32_t offset, void *ptr, size_t size) const
+{
+	for (const CachedRange &range : rangeCache) {
+		if (offset >= range.offset &&
+		    static_cast<uint64_t>(offset) + size <= static_cast<uint64_t>(range.offset) + range.data.size())
+		{
+			// Found a cached range.
+			memcpy(ptr, &range.data[offset - range.offset], size);
+			return true;
+		}
+	}
+
+	// Not cached.
+	return false;
+}
+
+/**
+ * Add data to the decrypted range cache.
+ * Ranges larger than RANGE_CACHE_MAX_SIZE are not cached.
+ * Only the 16-byte aligned blocks within the range are cached,
+ * since AES-CTR decryption works on 16-byte blocks.
+ * @param offset	[in] Starting address, relative to the beginning of the NCCH.
+ * @param ptr		[in] Decrypted data.
+ * @param size		[in] Size of the data.
+ */
+void NCCHReaderPrivate::addToRangeCache(uint32_t offset, const void *ptr, size_t size)
+{
+	if (size == 0 || size > RANGE_CACHE_MAX_SIZE)
+		return;
+
+	// Round the start up and the end down to 16-byte blocks.
+	// (Reads from unencrypted NCCHs don't have to be aligned.)
+	const uint64_t start = (static_cast<uint64_t>(offset) + 15U) & ~15ULL;
+	const uint64_t end = (static_cast<uint64_t>(offset) + size) & ~15ULL;
+	if (end <= start)
+		return;
+
+	// Replace the next entry.
+	CachedRange &range = rangeCache[rangeCache_next];
+	rangeCache_next = (rangeCache_next + 1) % rangeCache.size();
+
+	const uint8_t *const ptr8 = static_cast<const uint8_t*>(ptr) + (start - offset);
+	range.offset = static_cast<uint32_t>(start);
+	range.data.assign(ptr8, ptr8 + (end - start));
+}
+
 /**
  * Load the NCCH Extended Header.
  * @return 0 on success; non-zero on error.
@@ -571,13 +636,26 @@ size_t NCCHReader::read(void *ptr, size_t size)
 		size = static_cast<size_t>(d->ncch_length - d->pos);
 	}
 
+	// Check the decrypted range cache first.
+	if (size <= NCCHReaderPrivate::RANGE_CACHE_MAX_SIZE &&
+	    d->readFromRangeCache(d->pos, ptr, size))
+	{
+		d->pos += static_cast<uint32_t>(size);
+		return size;
+	}
+
 	if ((d->ncch_header.hdr.flags[N3DS_NCCH_FLAG_BIT_MASKS] & N3DS_NCCH_BIT_MASK_NoCrypto) ||
 	     d->forceNoCrypto)
 	{
 		// No NCCH encryption.
 		// NOTE: readFromROM() sets q->m_lastError, so we
 		// don't need to check if a short read occurred.
-		return d->readFromROM(d->pos, ptr, size);
+		const size_t ret_sz = d->readFromROM(d->pos, ptr, size);
+		if (ret_sz == size) {
+			d->addToRangeCache(d->pos, ptr, size);
+		}
+		d->pos += static_cast<uint32_t>(ret_sz);
+		return ret_sz;
 	}
 
 #ifdef ENABLE_DECRYPTION
@@ -589,6 +667,8 @@ size_t NCCHReader::read(void *ptr, size_t size)
 		return 0;
 	}
 
+	const uint32_t start_pos = d->pos;
+	const size_t start_size = size;
 	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
 	size_t sz_total_read = 0;
 	while (size > 0) {
@@ -621,18 +701,16 @@ size_t NCCHReader::read(void *ptr, size_t size)
 		size_t ret_sz = d->readFromROM(d->pos, ptr8, sz_to_read);
 
 		if (section && section->section > N3DS_NCCH_SECTION_PLAIN) {
-			// Set the required key.
-			// TODO: Don't set the key if it hasn't changed.
-			d->cipher->setKey(d->ncch_keys[section->keyIdx].u8, sizeof(d->ncch_keys[section->keyIdx].u8));
-
-			// Initialize the counter based on section and offset.
+			// Each key has its own cipher, so only the counter
+			// needs to be initialized based on section and offset.
+			IAesCipher *const cipher = d->ciphers[section->keyIdx];
 			u128_t ctr;
 			ctr.init_ctr(d->tid_be, section->section, d->pos - section->ctr_base);
-			d->cipher->setIV(ctr.u8, sizeof(ctr.u8));
+			cipher->setIV(ctr.u8, sizeof(ctr.u8));
 
 			// Decrypt the data.
 			// FIXME: Round up to 16 if a short read occurred?
-			ret_sz = d->cipher->decrypt(static_cast<uint8_t*>(ptr), ret_sz);
+			ret_sz = cipher->decrypt(ptr8, ret_sz);
 		}
 
 		d->pos += static_cast<uint32_t>(ret_sz);
@@ -649,6 +727,9 @@ size_t NCCHReader::read(void *ptr, size_t size)
 		}
 	}
 
+	if (sz_total_read == start_size) {
+		d->addToRangeCache(start_pos, ptr, sz_total_read);
+	}
 	return sz_total_read;
 #else /* !ENABLE_DECRYPTION */
 	// Decryption is not enabled.
@@ -33,6 +33,7 @@ class NCCHReader final : public LibRpBase::IPartition
 		 * @param ncch_offset		[in] NCCH start offset, in bytes.
 		 * @param ncch_length		[in] NCCH length, in bytes.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		NCCHReader(LibRpFile::IRpFile *file,
 			uint8_t media_unit_shift,
 			off64_t ncch_offset, uint32_t ncch_length);
@@ -72,6 +73,7 @@ class NCCHReader final : public LibRpBase::IPartition
 		 * @param size Amount of data to read, in bytes.
 		 * @return Number of bytes read.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		ATTR_ACCESS_SIZE(write_only, 2, 3)
 		size_t read(void *ptr, size_t size) final;
 
@@ -80,12 +82,14 @@ class NCCHReader final : public LibRpBase::IPartition
 		 * @param pos Partition position.
 		 * @return 0 on success; -1 on error.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		int seek(off64_t pos) final;
 
 		/**
 		 * Get the partition position.
 		 * @return Partition position on success; -1 on error.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		off64_t tell(void) final;
 
 		/**
@@ -94,6 +98,7 @@ class NCCHReader final : public LibRpBase::IPartition
 		 * and it's adjusted to exclude hashes.
 		 * @return Data size, or -1 on error.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		off64_t size(void) final;
 
 	public:
@@ -24,6 +24,7 @@
 #include <stdint.h>
 
 // C++ includes.
+#include <array>
 #include <vector>
 
 #ifdef ENABLE_DECRYPTION
@@ -98,7 +99,8 @@ class NCCHReaderPrivate
 		 * Read data from the underlying ROM image.
 		 * CIA decryption is automatically handled if set up properly.
 		 *
-		 * NOTE: Offset and size must both be multiples of 16.
+		 * NOTE: Offset and size must both be multiples of 16
+		 * if the data will be decrypted afterwards.
 		 *
 		 * @param offset	[in] Starting address, relative to the beginning of the NCCH.
 		 * @param ptr		[out] Output buffer.
@@ -107,6 +109,43 @@ class NCCHReaderPrivate
 		 */
 		size_t readFromROM(uint32_t offset, void *ptr, size_t size);
 
+		/**
+		 * Decrypted range cache.
+		 * Nintendo3DS and Nintendo3DS_SMDH read the same small ranges
+		 * (ExHeader, SMDH, logo) multiple times, so the data is kept
+		 * here after it's read and decrypted.
+		 */
+		struct CachedRange {
+			uint32_t offset;		// Relative to ncch_offset. (multiple of 16)
+			std::vector<uint8_t> data;	// Decrypted data. (size is a multiple of 16)
+		};
+		std::array<CachedRange, 4> rangeCache;
+		unsigned int rangeCache_next;	// Next entry to replace.
+
+		// Maximum size of a cached range.
+		// This is large enough for the SMDH. (0x36C0 bytes)
+		static constexpr size_t RANGE_CACHE_MAX_SIZE = 16384;
+
+		/**
+		 * Read data from the decrypted range cache.
+		 * @param offset	[in] Starting address, relative to the beginning of the NCCH.
+		 * @param ptr		[out] Output buffer.
+		 * @param size		[in] Amount of data to read.
+		 * @return True if the entire range was cached; false if not.
+		 */
+		bool readFromRangeCache(uint32_t offset, void *ptr, size_t size) const;
+
+		/**
+		 * Add data to the decrypted range cache.
+		 * Ranges larger than RANGE_CACHE_MAX_SIZE are not cached.
+		 * Only the 16-byte aligned blocks within the range are cached,
+		 * since AES-CTR decryption works on 16-byte blocks.
+		 * @param offset	[in] Starting address, relative to the beginning of the NCCH.
+		 * @param ptr		[in] Decrypted data.
+		 * @param size		[in] Size of the data.
+		 */
+		void addToRangeCache(uint32_t offset, const void *ptr, size_t size);
+
 		/**
 		 * Load the NCCH Extended Header.
 		 * @return 0 on success; non-zero on error.
@@ -131,7 +170,12 @@ class NCCHReaderPrivate
 #ifdef ENABLE_DECRYPTION
 		uint64_t tid_be;		// Title ID (for AES-CTR init)
 		u128_t ncch_keys[2];		// Encryption keys
-		LibRpBase::IAesCipher *cipher;	// NCCH cipher
+
+		// NCCH ciphers, one per ncch_keys[] entry.
+		// Each cipher's key is only set once, so read() only
+		// has to set the counter instead of re-expanding the
+		// AES key schedule for every read.
+		LibRpBase::IAesCipher *ciphers[2];
 
 		uint16_t tmd_content_index;
 		bool isDebug;			// Are we using debug keys?
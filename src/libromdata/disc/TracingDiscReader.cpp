@@ -0,0 +1,115 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * TracingDiscReader.cpp: IDiscReader decorator that records I/O           *
+ * statistics.                                                             *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "TracingDiscReader.hpp"
+
+// librpfile
+#include "librpfile/IoTrace.hpp"
+namespace IoTrace = LibRpFile::IoTrace;
+
+namespace LibRomData {
+
+/**
+ * Trace all reads and seeks on an IDiscReader.
+ * Operations are recorded using LibRpFile::IoTrace.
+ * @param discReader IDiscReader (will be ref()'d)
+ * @param tag Tag for the statistics
+ */
+TracingDiscReader::TracingDiscReader(IDiscReader *discReader, const char *tag)
+	: super(discReader)
+	, m_tag(tag ? tag : "")
+{
+	if (!discReader) {
+		m_lastError = EBADF;
+	}
+}
+
+/**
+ * Is a disc image supported by this object?
+ * @param pHeader Disc image header.
+ * @param szHeader Size of header.
+ * @return Class-specific disc format ID (>= 0) if supported; -1 if not.
+ */
+int TracingDiscReader::isDiscSupported(const uint8_t *pHeader, size_t szHeader) const
+{
+	return (m_discReader ? m_discReader->isDiscSupported(pHeader, szHeader) : -1);
+}
+
+/**
+ * Read data from the disc image.
+ * @param ptr Output data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t TracingDiscReader::read(void *ptr, size_t size)
+{
+	if (!m_discReader) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	const off64_t pos = m_discReader->tell();
+	const uint64_t start = IoTrace::now_ns();
+	const size_t ret = m_discReader->read(ptr, size);
+	const uint64_t latency = IoTrace::now_ns() - start;
+	m_lastError = m_discReader->lastError();
+
+	const bool redundant = !m_readRanges.emplace(pos, size).second;
+	IoTrace::record(m_tag.c_str(), IoTrace::Op::Read, pos, size, latency, redundant);
+	return ret;
+}
+
+/**
+ * Set the disc image position.
+ * @param pos Disc image position.
+ * @return 0 on success; -1 on error.
+ */
+int TracingDiscReader::seek(off64_t pos)
+{
+	if (!m_discReader) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	const int ret = m_discReader->seek(pos);
+	m_lastError = m_discReader->lastError();
+	IoTrace::record(m_tag.c_str(), IoTrace::Op::Seek, pos, 0, 0, false);
+	return ret;
+}
+
+/**
+ * Get the disc image position.
+ * @return Disc image position on success; -1 on error.
+ */
+off64_t TracingDiscReader::tell(void)
+{
+	if (!m_discReader) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return m_discReader->tell();
+}
+
+/**
+ * Get the disc image size.
+ * @return Disc image size, or -1 on error.
+ */
+off64_t TracingDiscReader::size(void)
+{
+	if (!m_discReader) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return m_discReader->size();
+}
+
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * TracingDiscReader.hpp: IDiscReader decorator that records I/O           *
+ * statistics.                                                             *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "librpbase/disc/IDiscReader.hpp"
+#include "dll-macros.h"	// for RP_LIBROMDATA_PUBLIC
+
+// C++ includes
+#include <set>
+#include <string>
+#include <utility>
+
+namespace LibRomData {
+
+class TracingDiscReader final : public LibRpBase::IDiscReader
+{
+	public:
+		/**
+		 * Trace all reads and seeks on an IDiscReader.
+		 * Operations are recorded using LibRpFile::IoTrace.
+		 * @param discReader IDiscReader (will be ref()'d)
+		 * @param tag Tag for the statistics
+		 */
+		RP_LIBROMDATA_PUBLIC
+		TracingDiscReader(IDiscReader *discReader, const char *tag);
+	protected:
+		~TracingDiscReader() final = default;	// call unref() instead
+
+	private:
+		typedef IDiscReader super;
+		RP_DISABLE_COPY(TracingDiscReader)
+
+	public:
+		/** Disc image detection functions. **/
+
+		/**
+		 * Is a disc image supported by this object?
+		 * @param pHeader Disc image header.
+		 * @param szHeader Size of header.
+		 * @return Class-specific disc format ID (>= 0) if supported; -1 if not.
+		 */
+		int isDiscSupported(const uint8_t *pHeader, size_t szHeader) const final;
+
+	public:
+		/**
+		 * Read data from the disc image.
+		 * @param ptr Output data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		ATTR_ACCESS_SIZE(write_only, 2, 3)
+		size_t read(void *ptr, size_t size) final;
+
+		/**
+		 * Set the disc image position.
+		 * @param pos Disc image position.
+		 * @return 0 on success; -1 on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int seek(off64_t pos) final;
+
+		/**
+		 * Get the disc image position.
+		 * @return Disc image position on success; -1 on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		off64_t tell(void) final;
+
+		/**
+		 * Get the disc image size.
+		 * @return Disc image size, or -1 on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		off64_t size(void) final;
+
+	protected:
+		std::string m_tag;
+
+		// Ranges that have already been read, for redundant read detection.
+		std::set<std::pair<off64_t, size_t> > m_readRanges;
+};
+
+}
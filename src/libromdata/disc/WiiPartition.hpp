@@ -94,6 +94,25 @@ class WiiPartition : public GcnPartition
 		 */
 		off64_t partition_size_used(void) const final;
 
+	public:
+		/** Direct file access **/
+
+		/**
+		 * Get the underlying file for a range of the partition.
+		 * Wii partitions are encrypted and hashed, so this isn't supported.
+		 * @param pos		[in] Starting position in the partition
+		 * @param size		[in] Size of the range, in bytes
+		 * @param pFilePos	[out] Starting position in the underlying file
+		 * @return nullptr
+		 */
+		LibRpFile::IRpFile *getFileRange(off64_t pos, off64_t size, off64_t *pFilePos) final
+		{
+			RP_UNUSED(pos);
+			RP_UNUSED(size);
+			RP_UNUSED(pFilePos);
+			return nullptr;
+		}
+
 	public:
 		/** WiiPartition **/
 
@@ -18,15 +18,21 @@ using LibRpFile::IRpFile;
 // C++ STL classes
 using std::string;
 using std::unordered_map;
+using std::vector;
 
 namespace LibRomData {
 
-class XDVDFSPartitionPrivate
+/**
+ * XDVDFSPartitionPrivate also implements IFst using the
+ * cached directory tables, so XDVDFSPartition::fst()
+ * doesn't need a separate copy of the directory tables.
+ */
+class XDVDFSPartitionPrivate final : public IFst
 {
 	public:
 		XDVDFSPartitionPrivate(XDVDFSPartition *q,
 			off64_t partition_offset, off64_t partition_size);
-		~XDVDFSPartitionPrivate();
+		~XDVDFSPartitionPrivate() final;
 
 	private:
 		RP_DISABLE_COPY(XDVDFSPartitionPrivate)
@@ -49,6 +55,48 @@ class XDVDFSPartitionPrivate
 		// is a byte array, not an ISO_DirEntry array.
 		unordered_map<std::string, ao::uvector<uint8_t> > dirTables;
 
+		// Set if an invalid directory entry was found.
+		bool fstHasErrors;
+
+		// Filename buffer for find_file(). [UTF-8]
+		string find_name;
+
+		/**
+		 * IFst::Dir for an XDVDFS directory.
+		 * dir_idx is the index of the next entry in offsets.
+		 */
+		struct XDVDFSDir : public IFst::Dir {
+			const ao::uvector<uint8_t> *dirTable;	// Directory table
+			vector<uint32_t> offsets;		// Entry offsets, in sorted order
+			string name;				// Current filename [UTF-8]
+		};
+
+		/**
+		 * Get a directory entry at the specified offset in a directory table.
+		 * The entry, including the filename, must be in bounds.
+		 * @param dirTable Directory table.
+		 * @param offset Byte offset of the directory entry.
+		 * @return Pointer to XDVDFS_DirEntry within dirTable, or nullptr if out of bounds.
+		 */
+		static const XDVDFS_DirEntry *dirEntryAt(const ao::uvector<uint8_t> *dirTable, size_t offset);
+
+		/**
+		 * Get the offsets of all entries in a directory table.
+		 * The directory table is a binary tree, so an in-order
+		 * traversal returns the entries sorted by filename.
+		 * @param dirTable	[in] Directory table.
+		 * @param offsets	[out] Entry offsets.
+		 */
+		void getDirEntryOffsets(const ao::uvector<uint8_t> *dirTable, vector<uint32_t> &offsets);
+
+		/**
+		 * Fill in an IFst::DirEnt from an XDVDFS directory entry.
+		 * The filename is not set.
+		 * @param dirEntry	[in] XDVDFS directory entry
+		 * @param dirent	[out] IFst::DirEnt
+		 */
+		static void toDirEnt(const XDVDFS_DirEntry *dirEntry, IFst::DirEnt *dirent);
+
 		/**
 		 * Get an entry within a specified directory table.
 		 * @param dirTable Directory table.
@@ -65,6 +113,13 @@ class XDVDFSPartitionPrivate
 		 */
 		const ao::uvector<uint8_t> *getDirectory(const char *path);
 
+		/**
+		 * Look up a directory entry from a filename.
+		 * @param filename Filename, with or without a leading slash. [UTF-8]
+		 * @return Pointer to XDVDFS_DirEntry, or nullptr if not found.
+		 */
+		const XDVDFS_DirEntry *lookup(const char *filename);
+
 		/**
 		 * XDVDFS strcasecmp() implementation.
 		 * Uses generic ASCII handling instead of locale-specific case folding.
@@ -73,6 +128,50 @@ class XDVDFSPartitionPrivate
 		 * @return 0 (==), negative (<), or positive (>).
 		 */
 		static int xdvdfs_strcasecmp(const char *s1, const char *s2);
+
+	public:
+		/** IFst **/
+
+		/**
+		 * Is the FST open?
+		 * @return True if open; false if not.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * Have any errors been detected in the FST?
+		 * @return True if yes; false if no.
+		 */
+		bool hasErrors(void) const final;
+
+		/**
+		 * Open a directory.
+		 * @param path	[in] Directory path. [UTF-8]
+		 * @return Dir*, or nullptr on error.
+		 */
+		Dir *opendir(const char *path) final;
+
+		/**
+		 * Read a directory entry.
+		 * @param dirp Dir pointer.
+		 * @return DirEnt*, or nullptr if end of directory or on error.
+		 */
+		DirEnt *readdir(Dir *dirp) final;
+
+		/**
+		 * Close an opened directory.
+		 * @param dirp Dir pointer.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int closedir(Dir *dirp) final;
+
+		/**
+		 * Get the directory entry for the specified file.
+		 * @param filename	[in] Filename. [UTF-8]
+		 * @param dirent	[out] Pointer to DirEnt buffer.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int find_file(const char *filename, DirEnt *dirent) final;
 };
 
 /** XDVDFSPartitionPrivate **/
@@ -82,6 +181,7 @@ XDVDFSPartitionPrivate::XDVDFSPartitionPrivate(XDVDFSPartition *q,
 	: q_ptr(q)
 	, partition_offset(partition_offset)
 	, partition_size(partition_size)
+	, fstHasErrors(false)
 {
 	// Clear the XDVDFS header struct.
 	memset(&xdvdfsHeader, 0, sizeof(xdvdfsHeader));
@@ -133,6 +233,104 @@ XDVDFSPartitionPrivate::XDVDFSPartitionPrivate(XDVDFSPartition *q,
 XDVDFSPartitionPrivate::~XDVDFSPartitionPrivate()
 { }
 
+/**
+ * Get a directory entry at the specified offset in a directory table.
+ * The entry, including the filename, must be in bounds.
+ * @param dirTable Directory table.
+ * @param offset Byte offset of the directory entry.
+ * @return Pointer to XDVDFS_DirEntry within dirTable, or nullptr if out of bounds.
+ */
+const XDVDFS_DirEntry *XDVDFSPartitionPrivate::dirEntryAt(const ao::uvector<uint8_t> *dirTable, size_t offset)
+{
+	const size_t dir_size = dirTable->size();
+	if (offset > dir_size || sizeof(XDVDFS_DirEntry) > dir_size - offset) {
+		return nullptr;
+	}
+
+	const XDVDFS_DirEntry *const dirEntry = reinterpret_cast<const XDVDFS_DirEntry*>(dirTable->data() + offset);
+	if (dirEntry->name_length > dir_size - offset - sizeof(*dirEntry)) {
+		// Filename is out of bounds.
+		return nullptr;
+	}
+	return dirEntry;
+}
+
+/**
+ * Get the offsets of all entries in a directory table.
+ * The directory table is a binary tree, so an in-order
+ * traversal returns the entries sorted by filename.
+ * @param dirTable	[in] Directory table.
+ * @param offsets	[out] Entry offsets.
+ */
+void XDVDFSPartitionPrivate::getDirEntryOffsets(const ao::uvector<uint8_t> *dirTable, vector<uint32_t> &offsets)
+{
+	offsets.clear();
+
+	// The first entry is the root of the tree.
+	// If its left subtree offset is 0xFFFF, the directory is empty.
+	const XDVDFS_DirEntry *dirEntry = dirEntryAt(dirTable, 0);
+	if (!dirEntry || le16_to_cpu(dirEntry->left_offset) == 0xFFFF) {
+		// Empty directory.
+		return;
+	}
+
+	// Subtree offsets are in DWORDs, so each entry has one visited flag.
+	// This prevents infinite loops if the tree is corrupted.
+	vector<bool> visited((dirTable->size() + 3) / 4);
+	vector<uint32_t> stack;
+	uint32_t offset = 0;
+	bool hasNode = true;
+	while (hasNode || !stack.empty()) {
+		if (hasNode) {
+			// Go down the left subtree.
+			dirEntry = dirEntryAt(dirTable, offset);
+			if (!dirEntry || visited[offset / 4]) {
+				// Invalid entry, or a loop in the tree.
+				fstHasErrors = true;
+				hasNode = false;
+				continue;
+			}
+			visited[offset / 4] = true;
+			stack.push_back(offset);
+
+			const uint16_t left_offset = le16_to_cpu(dirEntry->left_offset);
+			hasNode = (left_offset != 0 && left_offset != 0xFFFF);
+			offset = left_offset * sizeof(uint32_t);
+		} else {
+			// Visit this entry, then go down the right subtree.
+			offset = stack.back();
+			stack.pop_back();
+			offsets.push_back(offset);
+
+			dirEntry = reinterpret_cast<const XDVDFS_DirEntry*>(dirTable->data() + offset);
+			const uint16_t right_offset = le16_to_cpu(dirEntry->right_offset);
+			hasNode = (right_offset != 0 && right_offset != 0xFFFF);
+			offset = right_offset * sizeof(uint32_t);
+		}
+	}
+}
+
+/**
+ * Fill in an IFst::DirEnt from an XDVDFS directory entry.
+ * The filename is not set.
+ * @param dirEntry	[in] XDVDFS directory entry
+ * @param dirent	[out] IFst::DirEnt
+ */
+void XDVDFSPartitionPrivate::toDirEnt(const XDVDFS_DirEntry *dirEntry, IFst::DirEnt *dirent)
+{
+	if (dirEntry->attributes & XDVDFS_ATTR_DIRECTORY) {
+		// offset and size are not valid for directories.
+		dirent->type = DT_DIR;
+		dirent->offset = 0;
+		dirent->size = 0;
+		return;
+	}
+
+	dirent->type = DT_REG;
+	dirent->offset = static_cast<off64_t>(le32_to_cpu(dirEntry->start_sector)) * XDVDFS_BLOCK_SIZE;
+	dirent->size = le32_to_cpu(dirEntry->file_size);
+}
+
 /**
  * XDVDFS strcasecmp() implementation.
  * Uses generic ASCII handling instead of locale-specific case folding.
@@ -298,8 +496,45 @@ const ao::uvector<uint8_t> *XDVDFSPartitionPrivate::getDirectory(const char *pat
 		dir_size = xdvdfsHeader.root_dir_size;
 	} else {
 		// Get the parent directory.
-		// TODO
-		return nullptr;
+		// NOTE: path starts with a slash, so strrchr() won't return nullptr.
+		const char *const sl = strrchr(path, '/');
+		const ao::uvector<uint8_t> *pParentDir;
+		if (sl == path) {
+			// Parent is root.
+			pParentDir = getDirectory("/");
+		} else {
+			const string s_parentDir(path, sl - path);
+			pParentDir = getDirectory(s_parentDir.c_str());
+		}
+		if (!pParentDir) {
+			// Can't find the parent directory.
+			// getDirectory() already set q->lastError().
+			return nullptr;
+		}
+
+		// Find this directory.
+		const XDVDFS_DirEntry *const dirEntry = getDirEntry(pParentDir, sl + 1);
+		if (!dirEntry) {
+			// Not found.
+			if (q->m_lastError == 0) {
+				q->m_lastError = ENOENT;
+			}
+			return nullptr;
+		} else if (!(dirEntry->attributes & XDVDFS_ATTR_DIRECTORY)) {
+			// Not a directory.
+			q->m_lastError = ENOTDIR;
+			return nullptr;
+		}
+
+		// Subdirectory size should be less than 16 MB.
+		dir_size = le32_to_cpu(dirEntry->file_size);
+		if (dir_size > 16*1024*1024) {
+			// Subdirectory is too big.
+			q->m_lastError = EIO;
+			return nullptr;
+		}
+		dir_addr = partition_offset + (
+			static_cast<off64_t>(le32_to_cpu(dirEntry->start_sector)) * XDVDFS_BLOCK_SIZE);
 	}
 
 	// Read the directory.
@@ -317,10 +552,212 @@ const ao::uvector<uint8_t> *XDVDFSPartitionPrivate::getDirectory(const char *pat
 	// Save the directory table for later.
 	auto ins_iter = dirTables.emplace(path, std::move(dirTable));
 
-	// Root directory loaded.
+	// Directory loaded.
 	return &(ins_iter.first->second);
 }
 
+/**
+ * Look up a directory entry from a filename.
+ * @param filename Filename, with or without a leading slash. [UTF-8]
+ * @return Pointer to XDVDFS_DirEntry, or nullptr if not found.
+ */
+const XDVDFS_DirEntry *XDVDFSPartitionPrivate::lookup(const char *filename)
+{
+	assert(filename != nullptr);
+	RP_Q(XDVDFSPartition);
+
+	// Remove leading slashes.
+	while (*filename == '/') {
+		filename++;
+	}
+	if (filename[0] == 0) {
+		// Nothing but slashes...
+		q->m_lastError = EINVAL;
+		return nullptr;
+	}
+
+	// Is this file in a subdirectory?
+	const ao::uvector<uint8_t> *dirTable;
+	const char *const sl = strrchr(filename, '/');
+	if (sl) {
+		// This file is in a subdirectory.
+		string s_parentDir(1, '/');
+		s_parentDir.append(filename, sl - filename);
+		filename = sl + 1;
+		dirTable = getDirectory(s_parentDir.c_str());
+	} else {
+		// Not in a subdirectory.
+		// Parent directory is root.
+		dirTable = getDirectory("/");
+	}
+
+	if (!dirTable) {
+		// Directory not found.
+		// getDirectory() has already set q->lastError.
+		return nullptr;
+	}
+
+	// Find the file in the directory.
+	const XDVDFS_DirEntry *const dirEntry = getDirEntry(dirTable, filename);
+	if (!dirEntry && q->m_lastError == 0) {
+		// Not found.
+		q->m_lastError = ENOENT;
+	}
+	return dirEntry;
+}
+
+/** IFst **/
+
+/**
+ * Is the FST open?
+ * @return True if open; false if not.
+ */
+bool XDVDFSPartitionPrivate::isOpen(void) const
+{
+	return (q_ptr->m_discReader != nullptr);
+}
+
+/**
+ * Have any errors been detected in the FST?
+ * @return True if yes; false if no.
+ */
+bool XDVDFSPartitionPrivate::hasErrors(void) const
+{
+	return fstHasErrors;
+}
+
+/**
+ * Open a directory.
+ * @param path	[in] Directory path. [UTF-8]
+ * @return Dir*, or nullptr on error.
+ */
+IFst::Dir *XDVDFSPartitionPrivate::opendir(const char *path)
+{
+	assert(path != nullptr);
+	if (!path) {
+		return nullptr;
+	}
+
+	// Directory tables are cached by absolute path,
+	// so normalize the leading and trailing slashes.
+	while (*path == '/') {
+		path++;
+	}
+	size_t len = strlen(path);
+	while (len > 0 && path[len-1] == '/') {
+		len--;
+	}
+	string s_path(1, '/');
+	s_path.append(path, len);
+
+	const ao::uvector<uint8_t> *const dirTable = getDirectory(s_path.c_str());
+	if (!dirTable) {
+		// Directory not found.
+		// getDirectory() has already set q->lastError.
+		return nullptr;
+	}
+
+	XDVDFSDir *const dirp = new XDVDFSDir;
+	dirp->parent = this;
+	dirp->dir_idx = 0;
+	dirp->dirTable = dirTable;
+	getDirEntryOffsets(dirTable, dirp->offsets);
+
+	// Initialize the entry to this directory.
+	// readdir() will automatically seek to the next entry.
+	dirp->entry.idx = 0;
+	dirp->entry.type = DT_DIR;
+	dirp->entry.name = dirp->name.c_str();
+	// offset and size are not valid for directories.
+	dirp->entry.offset = 0;
+	dirp->entry.size = 0;
+	return dirp;
+}
+
+/**
+ * Read a directory entry.
+ * @param dirp Dir pointer.
+ * @return DirEnt*, or nullptr if end of directory or on error.
+ */
+IFst::DirEnt *XDVDFSPartitionPrivate::readdir(IFst::Dir *dirp)
+{
+	assert(dirp != nullptr);
+	assert(dirp->parent == this);
+	if (!dirp || dirp->parent != this) {
+		// No directory pointer, or the dirp
+		// doesn't belong to this IFst.
+		return nullptr;
+	}
+
+	XDVDFSDir *const xdvdfsDir = static_cast<XDVDFSDir*>(dirp);
+	if (dirp->dir_idx < 0 || static_cast<size_t>(dirp->dir_idx) >= xdvdfsDir->offsets.size()) {
+		// No more entries.
+		return nullptr;
+	}
+
+	// Offsets were validated by getDirEntryOffsets().
+	const uint32_t offset = xdvdfsDir->offsets[dirp->dir_idx];
+	const XDVDFS_DirEntry *const dirEntry =
+		reinterpret_cast<const XDVDFS_DirEntry*>(xdvdfsDir->dirTable->data() + offset);
+	const char *const entry_filename = reinterpret_cast<const char*>(dirEntry) + sizeof(*dirEntry);
+	xdvdfsDir->name = cp1252_to_utf8(entry_filename, dirEntry->name_length);
+
+	toDirEnt(dirEntry, &dirp->entry);
+	dirp->entry.name = xdvdfsDir->name.c_str();
+	dirp->entry.idx = dirp->dir_idx;
+	dirp->dir_idx++;
+	return &dirp->entry;
+}
+
+/**
+ * Close an opened directory.
+ * @param dirp Dir pointer.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int XDVDFSPartitionPrivate::closedir(IFst::Dir *dirp)
+{
+	assert(dirp != nullptr);
+	assert(dirp->parent == this);
+	if (!dirp) {
+		// No directory pointer.
+		// In release builds, this is a no-op.
+		return 0;
+	} else if (dirp->parent != this) {
+		// The dirp doesn't belong to this IFst.
+		return -EINVAL;
+	}
+
+	delete static_cast<XDVDFSDir*>(dirp);
+	return 0;
+}
+
+/**
+ * Get the directory entry for the specified file.
+ * @param filename	[in] Filename. [UTF-8]
+ * @param dirent	[out] Pointer to DirEnt buffer.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int XDVDFSPartitionPrivate::find_file(const char *filename, DirEnt *dirent)
+{
+	if (!filename || !dirent) {
+		// Invalid parameters.
+		return -EINVAL;
+	}
+
+	const XDVDFS_DirEntry *const dirEntry = lookup(filename);
+	if (!dirEntry) {
+		// Not found.
+		return -ENOENT;
+	}
+
+	const char *const entry_filename = reinterpret_cast<const char*>(dirEntry) + sizeof(*dirEntry);
+	find_name = cp1252_to_utf8(entry_filename, dirEntry->name_length);
+	toDirEnt(dirEntry, dirent);
+	dirent->name = find_name.c_str();
+	dirent->idx = 0;
+	return 0;
+}
+
 /** XDVDFSPartition **/
 
 /**
@@ -452,13 +889,47 @@ off64_t XDVDFSPartition::partition_size_used(void) const
 	return partition_size();
 }
 
+/**
+ * Get the partition's file system table.
+ * @return IFst (owned by this partition), or nullptr on error.
+ */
+IFst *XDVDFSPartition::fst(void)
+{
+	RP_D(XDVDFSPartition);
+	if (!m_discReader) {
+		// XDVDFS isn't loaded.
+		return nullptr;
+	}
+	return d;
+}
+
+/** Direct file access **/
+
+/**
+ * Get the underlying file for a range of the partition.
+ * @param pos		[in] Starting position in the partition
+ * @param size		[in] Size of the range, in bytes
+ * @param pFilePos	[out] Starting position in the underlying file
+ * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+ */
+IRpFile *XDVDFSPartition::getFileRange(off64_t pos, off64_t size, off64_t *pFilePos)
+{
+	RP_D(const XDVDFSPartition);
+	if (!m_discReader || pos < 0 || size < 0 ||
+	    pos > d->partition_size || size > d->partition_size - pos)
+	{
+		return nullptr;
+	}
+
+	// XDVDFS partitions are stored as-is, so the disc reader
+	// determines if the range can be accessed directly.
+	return m_discReader->getFileRange(d->partition_offset + pos, size, pFilePos);
+}
+
 /** XDVDFSPartition **/
 
 /** IFst wrapper functions. **/
 
-// TODO
-
-#if 0
 /**
  * Open a directory.
  * @param path	[in] Directory path.
@@ -467,16 +938,7 @@ off64_t XDVDFSPartition::partition_size_used(void) const
 IFst::Dir *XDVDFSPartition::opendir(const char *path)
 {
 	RP_D(XDVDFSPartition);
-	if (!d->fst) {
-		// FST isn't loaded.
-		if (d->loadFst() != 0) {
-			// FST load failed.
-			// TODO: Errors?
-			return nullptr;
-		}
-	}
-
-	return d->fst->opendir(path);
+	return d->opendir(path);
 }
 
 /**
@@ -488,12 +950,7 @@ IFst::Dir *XDVDFSPartition::opendir(const char *path)
 IFst::DirEnt *XDVDFSPartition::readdir(IFst::Dir *dirp)
 {
 	RP_D(XDVDFSPartition);
-	if (!d->fst) {
-		// TODO: Errors?
-		return nullptr;
-	}
-
-	return d->fst->readdir(dirp);
+	return d->readdir(dirp);
 }
 
 /**
@@ -504,14 +961,8 @@ IFst::DirEnt *XDVDFSPartition::readdir(IFst::Dir *dirp)
 int XDVDFSPartition::closedir(IFst::Dir *dirp)
 {
 	RP_D(XDVDFSPartition);
-	if (!d->fst) {
-		// TODO: Errors?
-		return -EBADF;
-	}
-
-	return d->fst->closedir(dirp);
+	return d->closedir(dirp);
 }
-#endif
 
 /**
  * Open a file. (read-only)
@@ -523,8 +974,6 @@ IRpFile *XDVDFSPartition::open(const char *filename)
 	// TODO: File reference counter.
 	// This might be difficult to do because PartitionFile is a separate class.
 
-	// TODO: Support subdirectories.
-
 	// Filename must be valid, and must start with a slash.
 	// Only absolute paths are supported.
 	if (!filename || filename[0] != '/') {
@@ -534,30 +983,12 @@ IRpFile *XDVDFSPartition::open(const char *filename)
 		return nullptr;
 	}
 
-	// Remove leading slashes.
-	while (*filename == '/') {
-		filename++;
-	}
-	if (filename[0] == 0) {
-		// Nothing but slashes...
-		return nullptr;
-	}
-
-	// TODO: Handle subdirectories.
-	// For now, assuming the file is in the root directory.
+	// Find the file.
 	RP_D(XDVDFSPartition);
-	const ao::uvector<uint8_t> *const dirTable = d->getDirectory("/");
-	if (!dirTable) {
-		// Directory not found.
-		// getDirectory() has already set m_lastError.
-		return nullptr;
-	}
-
-	// Find the file in the root directory.
-	const XDVDFS_DirEntry *const dirEntry = d->getDirEntry(dirTable, filename);
+	const XDVDFS_DirEntry *const dirEntry = d->lookup(filename);
 	if (!dirEntry) {
 		// File not found.
-		// getDirEntry() has already set m_lastError.
+		// lookup() has already set m_lastError.
 		return nullptr;
 	}
 
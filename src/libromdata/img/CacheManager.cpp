@@ -11,6 +11,7 @@
 #include "CacheManager.hpp"
 
 // Other rom-properties libraries
+#include "librpbase/config/Config.hpp"
 #include "librpfile/RpFile.hpp"
 #include "librpfile/FileSystem.hpp"
 #include "librpthreads/Semaphore.hpp"
@@ -20,7 +21,9 @@ using LibRpThreads::Semaphore;
 using LibRpThreads::SemaphoreLocker;
 
 // libcachecommon
+#include "libcachecommon/CacheIndex.hpp"
 #include "libcachecommon/CacheKeys.hpp"
+#include "libcachecommon/NegativeCache.hpp"
 
 // OS-specific includes
 #ifdef _WIN32
@@ -82,7 +85,8 @@ void CacheManager::setProxyUrl(const char *proxyUrl)
  *
  * If the file was not found on the server, or it was not found
  * the last time it was requested, an empty string will be
- * returned, and a zero-byte file will be stored in the cache.
+ * returned, and the cache key will be added to the negative
+ * cache index.
  *
  * @return Absolute path to the cached file.
  */
@@ -105,6 +109,21 @@ string CacheManager::download(const char *cache_key)
 	// with e.g. new version information.
 	const bool check_newer = (!strncmp(cache_key, "sys/", 4));
 
+	// Negative cache expiry, in seconds.
+	const Config *const config = Config::instance();
+	const time_t negExpiry = static_cast<time_t>(config->negativeCacheExpiry()) * 86400;
+
+	if (!check_newer && negExpiry > 0) {
+		// Check the negative cache index first.
+		// This doesn't require any filesystem access
+		// unless the index has changed on disk.
+		const time_t negTime = LibCacheCommon::negativeCacheLookup(cache_key);
+		if (negTime >= 0 && (time(nullptr) - negTime) < negExpiry) {
+			// File was not found on the server recently.
+			return string();
+		}
+	}
+
 	// Lock the semaphore to make sure we don't
 	// download too many files at once.
 	SemaphoreLocker locker(m_dlsem);
@@ -119,16 +138,16 @@ string CacheManager::download(const char *cache_key)
 			// TODO: How should we handle errors?
 			if (filesize == 0) {
 				// File is 0 bytes, which indicates it didn't exist
-				// on the server. If the file is older than a week,
-				// try to redownload it.
-				// TODO: Configurable time.
+				// on the server. (Older versions of rp-download created
+				// zero-byte files instead of using the negative cache index.)
+				// If the file hasn't expired yet, don't redownload it.
 				const time_t systime = time(nullptr);
-				if ((systime - filemtime) < (86400*7)) {
-					// Less than a week old.
+				if ((systime - filemtime) < negExpiry) {
+					// Not expired yet.
 					return string();
 				}
 
-				// More than a week old.
+				// Expired.
 				// Delete the cache file and try to download it again.
 				if (FileSystem::delete_file(cache_filename) != 0) {
 					// Unable to delete the cache file.
@@ -137,6 +156,8 @@ string CacheManager::download(const char *cache_key)
 			} else if (filesize > 0) {
 				// File is larger than 0 bytes, which indicates
 				// it was cached successfully.
+				// Record the access so it isn't evicted as an old file.
+				LibCacheCommon::cacheIndexRecordAccess(cache_key);
 				return cache_filename;
 			}
 		} else if (ret != -ENOENT) {
@@ -160,6 +181,8 @@ string CacheManager::download(const char *cache_key)
 	int ret = execRpDownload(cache_key);
 	if (ret != 0) {
 		// rp-download failed for some reason.
+		// It may have updated the negative cache index.
+		LibCacheCommon::negativeCacheInvalidate();
 		return string();
 	}
 
@@ -185,6 +208,9 @@ string CacheManager::findInCache(const char *cache_key)
 	if (FileSystem::access(cache_filename.c_str(), R_OK) != 0) {
 		// Unable to read the cache file.
 		cache_filename.clear();
+	} else {
+		// Record the access so it isn't evicted as an old file.
+		LibCacheCommon::cacheIndexRecordAccess(cache_key);
 	}
 	return cache_filename;
 }
@@ -69,7 +69,8 @@ class CacheManager
 		 *
 		 * If the file was not found on the server, or it was not found
 		 * the last time it was requested, an empty string will be
-		 * returned, and a zero-byte file will be stored in the cache.
+		 * returned, and the cache key will be added to the negative
+		 * cache index.
 		 *
 		 * @return Absolute path to the cached file.
 		 */
@@ -88,7 +89,8 @@ class CacheManager
 		 *
 		 * If the file was not found on the server, or it was not found
 		 * the last time it was requested, an empty string will be
-		 * returned, and a zero-byte file will be stored in the cache.
+		 * returned, and the cache key will be added to the negative
+		 * cache index.
 		 *
 		 * @return Absolute path to the cached file.
 		 */
@@ -2,7 +2,7 @@
  * ROM Properties Page shell extension. (libromdata)                       *
  * ExecRpDownload_posix.cpp: Execute rp-download.exe. (POSIX)              *
  *                                                                         *
- * Copyright (c) 2016-2020 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -10,8 +10,16 @@
 #include "config.libromdata.h"
 #include "CacheManager.hpp"
 
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
+
 // OS-specific includes.
+#include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -21,34 +29,33 @@
 
 // C++ includes.
 #include <string>
+#include <unordered_map>
 using std::string;
+using std::unordered_multimap;
+
+#ifndef MSG_NOSIGNAL
+#  define MSG_NOSIGNAL 0
+#endif
 
 namespace LibRomData {
 
+// rp-download executable.
+// TODO: Mac OS X path. (bundle?)
+static const char rp_download_exe[] = DIR_INSTALL_LIBEXEC "/rp-download";
+
 /**
- * Execute rp-download. (POSIX version)
- * @param filteredCacheKey Filtered cache key.
- * @return 0 on success; negative POSIX error code on error.
+ * Build a minimal environment for rp-download.
+ * This will include http_proxy and https_proxy if the proxy URL is set.
+ * @param s_env		[out] Environment strings (NULL-separated)
+ * @param envp		[out] Environment array (must have 5 elements)
+ * @param proxyUrl	[in] Proxy URL
  */
-int CacheManager::execRpDownload(const string &filteredCacheKey)
+static void buildRpDownloadEnv(string &s_env, const char *envp[5], const string &proxyUrl)
 {
-	// TODO: Mac OS X path. (bundle?)
- 	static const char rp_download_exe[] = DIR_INSTALL_LIBEXEC "/rp-download";
-
-	// Parameters.
-	const char *const argv[3] = {
-		rp_download_exe,
-		filteredCacheKey.c_str(),
-		nullptr
-	};
-
-	// Define a minimal environment for cURL.
-	// This will include http_proxy and https_proxy if the proxy URL is set.
 	// TODO: Separate proxies for http and https?
-	// TODO: Only build this once?
-	int pos[5] = {-1, -1, -1, -1, -1};
+	int pos[4] = {-1, -1, -1, -1};
 	int count = 0;
-	std::string s_env;
+	s_env.clear();
 	s_env.reserve(1024);
 
 	// We want the HOME and USER variables.
@@ -68,7 +75,7 @@ int CacheManager::execRpDownload(const string &filteredCacheKey)
 		s_env += envtmp;
 		s_env += '\0';
 	}
-	if (m_proxyUrl.empty()) {
+	if (proxyUrl.empty()) {
 		// Proxy URL is empty. Get the URLs from the environment.
 		envtmp = getenv("http_proxy");
 		if (envtmp && envtmp[0] != '\0') {
@@ -87,36 +94,61 @@ int CacheManager::execRpDownload(const string &filteredCacheKey)
 	} else {
 		// Proxy URL is set. Use it.
 		pos[count++] = static_cast<int>(s_env.size());
-		s_env += "http_proxy=" + m_proxyUrl;
+		s_env += "http_proxy=" + proxyUrl;
+		s_env += '\0';
 		pos[count++] = static_cast<int>(s_env.size());
-		s_env += "https_proxy=" + m_proxyUrl;
+		s_env += "https_proxy=" + proxyUrl;
+		s_env += '\0';
 	}
 
 	// Build envp.
-	const char *envp[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
+	// NOTE: This must be done after s_env is fully built,
+	// since appending to s_env may reallocate it.
 	unsigned int envp_idx = 0;
-	for (unsigned int i = 0; i < 5; i++) {
+	for (unsigned int i = 0; i < 4; i++) {
 		if (pos[i] >= 0) {
 			envp[envp_idx++] = &s_env[pos[i]];
 		}
 	}
+	for (; envp_idx < 5; envp_idx++) {
+		envp[envp_idx] = nullptr;
+	}
+}
 
+/**
+ * Spawn rp-download.
+ * @param argv		[in] Arguments
+ * @param envp		[in] Environment
+ * @param stdio_fd	[in] If not -1, use this fd for rp-download's stdin and stdout.
+ * @param pPid		[out] Process ID
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int spawnRpDownload(const char *const *argv, const char *const *envp, int stdio_fd, pid_t *pPid)
+{
 	// TODO: Maybe we should close file handles...
 #ifdef HAVE_POSIX_SPAWN
 	// posix_spawn()
+	posix_spawn_file_actions_t file_actions;
+	posix_spawn_file_actions_t *p_file_actions = nullptr;
+	if (stdio_fd >= 0) {
+		posix_spawn_file_actions_init(&file_actions);
+		posix_spawn_file_actions_adddup2(&file_actions, stdio_fd, STDIN_FILENO);
+		posix_spawn_file_actions_adddup2(&file_actions, stdio_fd, STDOUT_FILENO);
+		p_file_actions = &file_actions;
+	}
+
 	errno = 0;
-	pid_t pid;
-	int ret = posix_spawn(&pid, rp_download_exe,
-		nullptr,	// file_actions
+	int ret = posix_spawn(pPid, rp_download_exe,
+		p_file_actions,
 		nullptr,	// attrp
 		(char *const *)argv, (char *const *)envp);
+	if (p_file_actions) {
+		posix_spawn_file_actions_destroy(p_file_actions);
+	}
 	if (ret != 0) {
 		// Error creating the child process.
-		int err = errno;
-		if (err == 0) {
-			err = EIO;
-		}
-		return -err;
+		// NOTE: posix_spawn() returns the error code.
+		return -ret;
 	}
 #else /* !HAVE_POSIX_SPAWN */
 	// fork()/execve().
@@ -124,13 +156,20 @@ int CacheManager::execRpDownload(const string &filteredCacheKey)
 	pid_t pid = fork();
 	if (pid == 0) {
 		// Child process.
+		if (stdio_fd >= 0) {
+			if (dup2(stdio_fd, STDIN_FILENO) < 0 ||
+			    dup2(stdio_fd, STDOUT_FILENO) < 0)
+			{
+				_exit(EXIT_FAILURE);
+			}
+		}
 		int ret = execve(rp_download_exe, (char *const *)argv, (char *const *)envp);
 		if (ret != 0) {
 			// execve() failed.
-			exit(EXIT_FAILURE);
+			_exit(EXIT_FAILURE);
 		}
 		assert(!"Shouldn't get here...");
-		exit(EXIT_FAILURE);
+		_exit(EXIT_FAILURE);
 	} else if (pid == -1) {
 		// fork() failed.
 		int err = errno;
@@ -139,8 +178,398 @@ int CacheManager::execRpDownload(const string &filteredCacheKey)
 		}
 		return -err;
 	}
+	*pPid = pid;
 #endif /* HAVE_POSIX_SPAWN */
 
+	return 0;
+}
+
+/**
+ * Persistent rp-download helper process.
+ *
+ * rp-download is started once in batch mode ("rp-download -b")
+ * and kept running. Cache keys are written to the helper, and the
+ * results are read back. This allows rp-download to reuse its
+ * connections instead of spawning a new process and doing a new
+ * TLS handshake for every cache key, and it allows multiple cache
+ * keys to be downloaded in parallel.
+ *
+ * The helper exits by itself if it's idle, and is restarted on demand.
+ */
+class RpDownloadHelper
+{
+	public:
+		RpDownloadHelper()
+			: m_pid(-1)
+			, m_fd(-1)
+			, m_generation(0)
+			, m_answered(false)
+			, m_disabled(false)
+		{ }
+
+		~RpDownloadHelper()
+		{
+			// Closing the socket will cause rp-download to exit.
+			if (m_fd >= 0) {
+				close(m_fd);
+			}
+		}
+
+	private:
+		RP_DISABLE_COPY(RpDownloadHelper)
+
+	public:
+		/**
+		 * Download a file using the helper.
+		 * @param cache_key Cache key
+		 * @param proxyUrl Proxy URL
+		 * @return 0 on success; -EIO if rp-download failed; -ENOSYS or -EPIPE if the helper isn't available.
+		 */
+		int download(const string &cache_key, const string &proxyUrl);
+
+	private:
+		/**
+		 * Start the helper process.
+		 * m_mutex must be locked by the caller.
+		 * @param proxyUrl Proxy URL
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int start(const string &proxyUrl);
+
+		/**
+		 * Stop the helper process.
+		 * m_readMutex and m_mutex must be locked by the caller.
+		 * @param doKill If true, kill the process. (Otherwise, it must have already exited.)
+		 */
+		void stop(bool doKill);
+
+		/**
+		 * Send a cache key to the helper process.
+		 * m_mutex must be locked by the caller.
+		 * @param cache_key Cache key
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int sendCacheKey(const string &cache_key);
+
+		/**
+		 * Wait for the result for a cache key.
+		 * m_readMutex must be locked by the caller.
+		 * @param cache_key Cache key
+		 * @param generation Helper generation the cache key was sent to
+		 * @return 0 on success; -EIO if rp-download failed; -EPIPE if the helper exited.
+		 */
+		int waitForResult(const string &cache_key, unsigned int generation);
+
+	private:
+		// Maximum time to wait for a response from the helper, in milliseconds.
+		// NOTE: rp-download's per-file timeout is 10 seconds, but
+		// multiple files may be queued.
+		static const int RESPONSE_TIMEOUT_MS = 30*1000;
+
+		// m_mutex protects the process state and writing.
+		// m_readMutex protects reading, m_rdbuf, and m_results.
+		// Lock order: m_readMutex, then m_mutex.
+		Mutex m_mutex;
+		Mutex m_readMutex;
+
+		pid_t m_pid;		// Process ID
+		int m_fd;		// Socket connected to rp-download's stdin/stdout
+		unsigned int m_generation;	// Incremented every time the helper is started
+		string m_proxyUrl;	// Proxy URL used when the helper was started
+
+		bool m_answered;	// Helper has answered at least one request
+		bool m_disabled;	// Helper doesn't work; don't try it again
+
+		string m_rdbuf;		// Partial response line
+		unordered_multimap<string, int> m_results;	// Results received for other threads
+};
+
+/**
+ * Start the helper process.
+ * m_mutex must be locked by the caller.
+ * @param proxyUrl Proxy URL
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RpDownloadHelper::start(const string &proxyUrl)
+{
+	assert(m_fd < 0);
+
+	// NOTE: A socket is used instead of pipes so we can use
+	// send() with MSG_NOSIGNAL if the helper exits.
+	int sv[2];
+#ifdef SOCK_CLOEXEC
+	int ret = socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv);
+#else /* !SOCK_CLOEXEC */
+	int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+	if (ret == 0) {
+		fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+		fcntl(sv[1], F_SETFD, FD_CLOEXEC);
+	}
+#endif /* SOCK_CLOEXEC */
+	if (ret != 0) {
+		int err = errno;
+		if (err == 0) {
+			err = EIO;
+		}
+		return -err;
+	}
+#ifdef SO_NOSIGPIPE
+	// Mac OS X doesn't have MSG_NOSIGNAL.
+	int one = 1;
+	setsockopt(sv[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif /* SO_NOSIGPIPE */
+
+	// Parameters.
+	const char *const argv[3] = {
+		rp_download_exe,
+		"-b",
+		nullptr
+	};
+	string s_env;
+	const char *envp[5];
+	buildRpDownloadEnv(s_env, envp, proxyUrl);
+
+	// NOTE: dup2() clears FD_CLOEXEC on the child's stdin/stdout.
+	pid_t pid = -1;
+	ret = spawnRpDownload(argv, envp, sv[1], &pid);
+	close(sv[1]);
+	if (ret != 0) {
+		close(sv[0]);
+		return ret;
+	}
+
+	m_pid = pid;
+	m_fd = sv[0];
+	m_proxyUrl = proxyUrl;
+	m_answered = false;
+	m_generation++;
+	return 0;
+}
+
+/**
+ * Stop the helper process.
+ * m_readMutex and m_mutex must be locked by the caller.
+ * @param doKill If true, kill the process. (Otherwise, it must have already exited.)
+ */
+void RpDownloadHelper::stop(bool doKill)
+{
+	if (m_fd >= 0) {
+		close(m_fd);
+		m_fd = -1;
+	}
+	if (m_pid > 0) {
+		// NOTE: The process hasn't been reaped yet, so the
+		// PID can't have been reused by another process.
+		if (doKill) {
+			kill(m_pid, SIGTERM);
+		}
+		int wstatus = 0;
+		waitpid(m_pid, &wstatus, 0);
+		m_pid = -1;
+	}
+
+	// Discard any results from this helper.
+	m_rdbuf.clear();
+	m_results.clear();
+}
+
+/**
+ * Wait for the result for a cache key.
+ * m_readMutex must be locked by the caller.
+ * @param cache_key Cache key
+ * @param generation Helper generation the cache key was sent to
+ * @return 0 on success; -EIO if rp-download failed; -EPIPE if the helper exited.
+ */
+int RpDownloadHelper::waitForResult(const string &cache_key, unsigned int generation)
+{
+	while (true) {
+		// Check if another thread already received our result.
+		auto iter = m_results.find(cache_key);
+		if (iter != m_results.end()) {
+			const int status = iter->second;
+			m_results.erase(iter);
+			return (status == 0 ? 0 : -EIO);
+		}
+
+		int fd;
+		{
+			MutexLocker locker(m_mutex);
+			if (m_generation != generation || m_fd < 0) {
+				// The helper that received our cache key has exited.
+				return -EPIPE;
+			}
+			fd = m_fd;
+		}
+
+		// Wait for a response.
+		struct pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		int ret = poll(&pfd, 1, RESPONSE_TIMEOUT_MS);
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		char buf[1024];
+		ssize_t size = -1;
+		if (ret > 0) {
+			size = recv(fd, buf, sizeof(buf), 0);
+			if (size < 0 && errno == EINTR)
+				continue;
+		}
+		if (size <= 0) {
+			// Timeout, error, or the helper exited.
+			MutexLocker locker(m_mutex);
+			if (!m_answered) {
+				// The helper never worked. Don't try it again.
+				// (rp-download might be too old to support batch mode.)
+				m_disabled = true;
+			}
+			// NOTE: If recv() returned 0, the helper has exited.
+			stop(size != 0);
+			return -EPIPE;
+		}
+
+		// Process complete lines.
+		// Format: "[exit code] [cache key]\n"
+		m_rdbuf.append(buf, size);
+		size_t pos;
+		while ((pos = m_rdbuf.find('\n')) != string::npos) {
+			const size_t space = m_rdbuf.find(' ');
+			if (space != string::npos && space < pos) {
+				const int status = atoi(m_rdbuf.c_str());
+				m_results.emplace(m_rdbuf.substr(space + 1, pos - space - 1), status);
+			}
+			m_rdbuf.erase(0, pos + 1);
+		}
+
+		MutexLocker locker(m_mutex);
+		m_answered = true;
+	}
+}
+
+/**
+ * Send a cache key to the helper process.
+ * m_mutex must be locked by the caller.
+ * @param cache_key Cache key
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RpDownloadHelper::sendCacheKey(const string &cache_key)
+{
+	string line = cache_key;
+	line += '\n';
+
+	size_t pos = 0;
+	while (pos < line.size()) {
+		ssize_t size = send(m_fd, line.data() + pos, line.size() - pos, MSG_NOSIGNAL);
+		if (size < 0 && errno == EINTR)
+			continue;
+		if (size <= 0) {
+			// The helper has exited.
+			return -EPIPE;
+		}
+		pos += size;
+	}
+	return 0;
+}
+
+/**
+ * Download a file using the helper.
+ * @param cache_key Cache key
+ * @param proxyUrl Proxy URL
+ * @return 0 on success; -EIO if rp-download failed; -ENOSYS or -EPIPE if the helper isn't available.
+ */
+int RpDownloadHelper::download(const string &cache_key, const string &proxyUrl)
+{
+	if (cache_key.find('\n') != string::npos) {
+		// Newlines aren't allowed in cache keys.
+		return -EINVAL;
+	}
+
+	// NOTE: The helper exits if it's idle, so if it exited
+	// before it received our cache key, restart it and try again.
+	int ret = -EPIPE;
+	for (unsigned int attempt = 0; attempt < 2 && ret == -EPIPE; attempt++) {
+		unsigned int generation;
+		{
+			MutexLocker locker(m_mutex);
+			if (m_disabled) {
+				return -ENOSYS;
+			}
+			if (m_fd >= 0 && proxyUrl != m_proxyUrl) {
+				// The helper is using a different proxy URL.
+				// TODO: Restart the helper once it's idle?
+				return -ENOSYS;
+			}
+
+			if (m_fd < 0) {
+				ret = start(proxyUrl);
+				if (ret != 0) {
+					m_disabled = true;
+					return -ENOSYS;
+				}
+			}
+
+			ret = sendCacheKey(cache_key);
+			generation = m_generation;
+		}
+
+		MutexLocker locker(m_readMutex);
+		if (ret != 0) {
+			// Unable to send the cache key. Clean up the helper.
+			MutexLocker locker(m_mutex);
+			if (m_generation == generation) {
+				stop(true);
+			}
+			ret = -EPIPE;
+			continue;
+		}
+
+		ret = waitForResult(cache_key, generation);
+	}
+
+	return ret;
+}
+
+// Persistent rp-download helper.
+static RpDownloadHelper rpDownloadHelper;
+
+/**
+ * Execute rp-download. (POSIX version)
+ * @param filteredCacheKey Filtered cache key.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int CacheManager::execRpDownload(const string &filteredCacheKey)
+{
+	// Try the persistent helper first.
+	int ret = rpDownloadHelper.download(filteredCacheKey, m_proxyUrl);
+	if (ret != -ENOSYS && ret != -EPIPE) {
+		// The helper handled this cache key.
+		return ret;
+	}
+
+	// Helper isn't available. Run rp-download for this cache key only.
+
+	// Parameters.
+	const char *const argv[3] = {
+		rp_download_exe,
+		filteredCacheKey.c_str(),
+		nullptr
+	};
+
+	// Define a minimal environment for cURL.
+	// TODO: Only build this once?
+	string s_env;
+	const char *envp[5];
+	buildRpDownloadEnv(s_env, envp, m_proxyUrl);
+
+	pid_t pid = -1;
+	ret = spawnRpDownload(argv, envp, -1, &pid);
+	if (ret != 0) {
+		// Error creating the child process.
+		return ret;
+	}
+
 	// Parent process.
 	// Wait up to 10 seconds for the process to exit.
 	// TODO: User-configurable timeout?
@@ -157,6 +586,9 @@ int CacheManager::execRpDownload(const string &filteredCacheKey)
 				// If the return status is non-zero, it failed.
 				if (WEXITSTATUS(wstatus) != 0) {
 					// Failure.
+					// NOTE: The process was reaped, so it
+					// doesn't need to be killed.
+					waited = true;
 					break;
 				}
 				// Success!
@@ -207,6 +207,7 @@ ImgClass TCreateThumbnail<ImgClass>::getExternalImage(
 						}
 					}
 					// TODO: Transparency processing?
+					dl_img->unref();
 					return ret_img;
 				}
 			}
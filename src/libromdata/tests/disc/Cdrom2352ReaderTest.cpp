@@ -0,0 +1,303 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * Cdrom2352ReaderTest.cpp: Cdrom2352Reader test.                          *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpbase, librpfile
+#include "librpbase/disc/IDiscReader.hpp"
+#include "librpfile/IRpFile.hpp"
+using namespace LibRpBase;
+using namespace LibRpFile;
+
+// libromdata
+#include "libromdata/disc/Cdrom2352Reader.hpp"
+#include "libromdata/cdrom_structs.h"
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <algorithm>
+#include <ostream>
+#include <vector>
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+/**
+ * In-memory file that counts the number of reads.
+ */
+class CountingFile final : public IRpFile
+{
+	public:
+		/**
+		 * Create a CountingFile.
+		 * @param data File data
+		 */
+		explicit CountingFile(vector<uint8_t> &&data)
+			: m_data(std::move(data))
+			, m_pos(0)
+			, readCount(0)
+		{ }
+
+	private:
+		RP_DISABLE_COPY(CountingFile)
+
+	public:
+		bool isOpen(void) const final { return true; }
+		void close(void) final { }
+
+		size_t read(void *ptr, size_t size) final
+		{
+			readCount++;
+			if (m_pos >= static_cast<off64_t>(m_data.size()))
+				return 0;
+			size = std::min(size, m_data.size() - static_cast<size_t>(m_pos));
+			memcpy(ptr, &m_data[static_cast<size_t>(m_pos)], size);
+			m_pos += size;
+			return size;
+		}
+
+		size_t write(const void *ptr, size_t size) final
+		{
+			RP_UNUSED(ptr);
+			RP_UNUSED(size);
+			m_lastError = EBADF;
+			return 0;
+		}
+
+		int seek(off64_t pos) final
+		{
+			m_pos = pos;
+			return 0;
+		}
+
+		off64_t tell(void) final { return m_pos; }
+		off64_t size(void) final { return static_cast<off64_t>(m_data.size()); }
+
+	private:
+		vector<uint8_t> m_data;
+		off64_t m_pos;
+
+	public:
+		unsigned int readCount;	// Number of reads
+};
+
+struct Cdrom2352ReaderTest_mode
+{
+	unsigned int physBlockSize;	// Physical sector size
+	off64_t pos;			// Starting position
+	size_t size;			// Amount of data to read
+
+	Cdrom2352ReaderTest_mode(unsigned int physBlockSize, off64_t pos, size_t size)
+		: physBlockSize(physBlockSize)
+		, pos(pos)
+		, size(size)
+	{ }
+};
+
+/**
+ * Formatting function for Cdrom2352ReaderTest_mode.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const Cdrom2352ReaderTest_mode& mode) {
+	return os << mode.physBlockSize << ": pos=" << mode.pos << ", size=" << mode.size;
+}
+
+class Cdrom2352ReaderTest : public ::testing::TestWithParam<Cdrom2352ReaderTest_mode>
+{
+	protected:
+		Cdrom2352ReaderTest()
+			: countingFile(nullptr)
+			, discReader(nullptr)
+		{ }
+
+		void SetUp(void) override;
+		void TearDown(void) override;
+
+	public:
+		// Number of sectors in the disc image.
+		// This is more than two batches of 64 sectors.
+		static const unsigned int SECTOR_COUNT = 150;
+
+		/**
+		 * Get the sector mode for a sector.
+		 * Most sectors are Mode 1, with some Mode 2 XA sectors mixed in.
+		 * @param lba Sector number
+		 * @return Sector mode
+		 */
+		static inline uint8_t sectorMode(unsigned int lba)
+		{
+			return ((lba % 3) == 2 || (lba >= 60 && lba < 70)) ? 2 : 1;
+		}
+
+	protected:
+		CountingFile *countingFile;
+		IDiscReader *discReader;
+
+		// Expected disc contents. (user data only)
+		vector<uint8_t> discData;
+};
+
+void Cdrom2352ReaderTest::SetUp(void)
+{
+	const unsigned int physBlockSize = GetParam().physBlockSize;
+
+	// Build the disc image and the expected disc contents.
+	// Each sector is filled with pseudo-random data, so the
+	// user data is different depending on the sector mode.
+	static const uint8_t sync[12] =
+		{0x00,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x00};
+	vector<uint8_t> img(static_cast<size_t>(SECTOR_COUNT) * physBlockSize);
+	uint32_t seed = 0xCD2352U ^ physBlockSize;
+	for (uint8_t &b : img) {
+		seed = seed * 1103515245U + 12345U;
+		b = static_cast<uint8_t>(seed >> 24);
+	}
+
+	discData.resize(static_cast<size_t>(SECTOR_COUNT) * 2048);
+	for (unsigned int lba = 0; lba < SECTOR_COUNT; lba++) {
+		CDROM_2352_Sector_t *const sector =
+			reinterpret_cast<CDROM_2352_Sector_t*>(&img[static_cast<size_t>(lba) * physBlockSize]);
+		memcpy(sector->sync, sync, sizeof(sync));
+		sector->mode = sectorMode(lba);
+
+		const uint8_t *const pUserData = (sector->mode == 2)
+			? sector->m2xa_f1.data
+			: sector->m1.data;
+		memcpy(&discData[static_cast<size_t>(lba) * 2048], pUserData, 2048);
+	}
+
+	countingFile = new CountingFile(std::move(img));
+	discReader = new Cdrom2352Reader(countingFile, physBlockSize);
+	ASSERT_EQ(static_cast<off64_t>(discData.size()), discReader->size());
+}
+
+void Cdrom2352ReaderTest::TearDown(void)
+{
+	UNREF_AND_NULL(discReader);
+	UNREF_AND_NULL(countingFile);
+}
+
+/**
+ * Read a range of the disc, then verify that the data matches
+ * the expected user data and the data returned by reading
+ * one sector at a time.
+ */
+TEST_P(Cdrom2352ReaderTest, readMatchesSingleSector)
+{
+	const Cdrom2352ReaderTest_mode &mode = GetParam();
+	const off64_t discSize = static_cast<off64_t>(discData.size());
+
+	// Expected size: Short read at the end of the disc.
+	size_t expectedSize = 0;
+	if (mode.pos < discSize) {
+		expectedSize = static_cast<size_t>(std::min(static_cast<off64_t>(mode.size), discSize - mode.pos));
+	}
+
+	// Read the entire range at once.
+	vector<uint8_t> buf(mode.size, 0xCC);
+	countingFile->readCount = 0;
+	ASSERT_EQ(0, discReader->seek(mode.pos));
+	const size_t size = discReader->read(buf.data(), buf.size());
+	const unsigned int readCount = countingFile->readCount;
+	ASSERT_EQ(expectedSize, size);
+	EXPECT_EQ(mode.pos + static_cast<off64_t>(size), discReader->tell());
+	if (size > 0) {
+		EXPECT_EQ(0, memcmp(buf.data(), &discData[static_cast<size_t>(mode.pos)], size));
+	}
+
+	// Read the same range, one sector at a time.
+	// Each sector is read in two parts, so every read is a partial
+	// sector read, which is handled by Cdrom2352Reader::readBlock().
+	vector<uint8_t> buf_sec(mode.size, 0x33);
+	countingFile->readCount = 0;
+	ASSERT_EQ(0, discReader->seek(mode.pos));
+	size_t size_sec = 0;
+	while (size_sec < mode.size) {
+		const off64_t pos = mode.pos + static_cast<off64_t>(size_sec);
+		const size_t sectorRemain = 2048 - static_cast<size_t>(pos % 2048);
+		size_t rd_sz = std::min(sectorRemain, mode.size - size_sec);
+		if (rd_sz == 2048) {
+			rd_sz = 1024;
+		}
+		const size_t rd = discReader->read(&buf_sec[size_sec], rd_sz);
+		if (rd == 0)
+			break;
+		size_sec += rd;
+	}
+	const unsigned int readCount_sec = countingFile->readCount;
+	ASSERT_EQ(size, size_sec);
+	EXPECT_EQ(0, memcmp(buf.data(), buf_sec.data(), size));
+
+	// Check the number of reads.
+	// - Partial sectors at the start and end: One read each.
+	// - Full sectors: One read per batch of 64 sectors.
+	unsigned int expectedReads = 0;
+	if (size > 0) {
+		const off64_t endPos = mode.pos + static_cast<off64_t>(size);
+		const off64_t firstFull = (mode.pos + 2047) / 2048;
+		const off64_t lastFull = endPos / 2048;
+		if (firstFull > lastFull) {
+			// Partial sector only.
+			expectedReads = 1;
+		} else {
+			const unsigned int fullCount = static_cast<unsigned int>(lastFull - firstFull);
+			expectedReads = (fullCount + 63) / 64;
+			if (mode.pos % 2048 != 0)
+				expectedReads++;
+			if (endPos % 2048 != 0)
+				expectedReads++;
+		}
+	}
+	EXPECT_EQ(expectedReads, readCount);
+	EXPECT_LE(readCount, readCount_sec);
+}
+
+INSTANTIATE_TEST_SUITE_P(Cdrom2352ReaderTest, Cdrom2352ReaderTest,
+	::testing::Values(
+		// Entire disc
+		Cdrom2352ReaderTest_mode(2352, 0, 150*2048),
+		Cdrom2352ReaderTest_mode(2448, 0, 150*2048),
+
+		// Unaligned start and end, spanning multiple sectors
+		Cdrom2352ReaderTest_mode(2352, 100, 10*2048),
+		Cdrom2352ReaderTest_mode(2448, 100, 10*2048),
+		Cdrom2352ReaderTest_mode(2352, 2047, 2),
+		Cdrom2352ReaderTest_mode(2352, 2*2048+1, 2048),
+		Cdrom2352ReaderTest_mode(2352, 5*2048+7, 70*2048),
+		Cdrom2352ReaderTest_mode(2448, 5*2048+7, 70*2048),
+
+		// Mode 2 sectors, and crossing the 64-sector batch boundary
+		Cdrom2352ReaderTest_mode(2352, 58*2048+512, 14*2048),
+		Cdrom2352ReaderTest_mode(2352, 63*2048, 2*2048),
+		Cdrom2352ReaderTest_mode(2448, 63*2048, 2*2048),
+
+		// End of the disc
+		Cdrom2352ReaderTest_mode(2352, 140*2048+1000, 20*2048),
+		Cdrom2352ReaderTest_mode(2448, 140*2048+1000, 20*2048),
+		Cdrom2352ReaderTest_mode(2352, 149*2048, 2048),
+		Cdrom2352ReaderTest_mode(2352, 150*2048, 16))
+	);
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRomData test suite: Cdrom2352Reader tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,743 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * FstExtractorTest.cpp: FstExtractor test.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// for HAVE_COPY_FILE_RANGE, HAVE_SENDFILE
+#include "librpfile/config.librpfile.h"
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpbase, librpfile
+#include "librpbase/RomData.hpp"
+#include "librpbase/disc/IFst.hpp"
+#include "librpbase/disc/IPartition.hpp"
+#include "librpfile/BlockCacheFile.hpp"
+#include "librpfile/FileSystem.hpp"
+#include "librpfile/MemFile.hpp"
+#include "librpfile/RpFile.hpp"
+using namespace LibRpBase;
+using namespace LibRpFile;
+
+// libromdata
+#include "libromdata/RomDataFactory.hpp"
+#include "libromdata/disc/FstExtractor.hpp"
+
+// C includes
+#include <unistd.h>
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++ includes
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+// Temporary directory. (set by gtest_main())
+static string tmpdir;
+
+/**
+ * File in the test disc image.
+ */
+struct TestFile {
+	const char *path;	// Path, relative to the FST root
+	size_t size;		// File size
+	uint32_t offset;	// Disc offset (set by assignFileOffsets())
+};
+
+static TestFile testFiles[] = {
+	{"a.bin", 100, 0},
+	{"dir/b.bin", 3U * 1024U * 1024U + 12345U, 0},	// multiple chunks
+	{"dir/empty.bin", 0, 0},
+	{"c.bin", 5000, 0},
+};
+
+/**
+ * Disc image format.
+ */
+enum class DiscFormat {
+	GCN,	// GameCube (GcnPartition)
+	ISO,	// ISO-9660, as a PSP UMD (IsoPartition)
+	XDVDFS,	// Extracted XDVDFS (XDVDFSPartition)
+};
+
+struct FstExtractorTest_mode
+{
+	DiscFormat format;	// Disc image format
+	const char *name;	// Format name
+
+	FstExtractorTest_mode(DiscFormat format, const char *name)
+		: format(format)
+		, name(name)
+	{ }
+};
+
+/**
+ * Formatting function for FstExtractorTest_mode.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const FstExtractorTest_mode& mode) {
+	return os << mode.name;
+}
+
+class FstExtractorTest : public ::testing::TestWithParam<FstExtractorTest_mode>
+{
+	protected:
+		void SetUp(void) override
+		{
+			imageFilename = tmpdir + "/test.iso";
+			outdir = tmpdir + "/out/";
+
+			switch (GetParam().format) {
+				case DiscFormat::GCN:
+					buildGcnImage();
+					break;
+				case DiscFormat::ISO:
+					buildIsoImage();
+					break;
+				case DiscFormat::XDVDFS:
+					buildXdvdfsImage();
+					break;
+			}
+			writeDiscImage();
+		}
+
+		void TearDown(void) override
+		{
+			for (const TestFile &testFile : testFiles) {
+				unlink((outdir + testFile.path).c_str());
+			}
+			rmdir((outdir + "dir").c_str());
+			rmdir(outdir.c_str());
+			unlink(imageFilename.c_str());
+		}
+
+		/**
+		 * Get the expected contents of a test file.
+		 * @param idx Index in testFiles[]
+		 * @return File contents
+		 */
+		static vector<uint8_t> fileData(unsigned int idx)
+		{
+			vector<uint8_t> data(testFiles[idx].size);
+			uint32_t seed = 0x12345678 + idx;
+			for (uint8_t &b : data) {
+				seed = seed * 1103515245U + 12345U;
+				b = static_cast<uint8_t>(seed >> 24);
+			}
+			return data;
+		}
+
+		/**
+		 * Get the total size of all test files.
+		 * @return Total size
+		 */
+		static off64_t totalFileSize(void)
+		{
+			off64_t totalSize = 0;
+			for (const TestFile &testFile : testFiles) {
+				totalSize += testFile.size;
+			}
+			return totalSize;
+		}
+
+		static inline void put_be32(uint8_t *p, uint32_t val)
+		{
+			p[0] = static_cast<uint8_t>(val >> 24);
+			p[1] = static_cast<uint8_t>(val >> 16);
+			p[2] = static_cast<uint8_t>(val >> 8);
+			p[3] = static_cast<uint8_t>(val);
+		}
+
+		static inline void put_le16(uint8_t *p, uint16_t val)
+		{
+			p[0] = static_cast<uint8_t>(val);
+			p[1] = static_cast<uint8_t>(val >> 8);
+		}
+
+		static inline void put_le32(uint8_t *p, uint32_t val)
+		{
+			p[0] = static_cast<uint8_t>(val);
+			p[1] = static_cast<uint8_t>(val >> 8);
+			p[2] = static_cast<uint8_t>(val >> 16);
+			p[3] = static_cast<uint8_t>(val >> 24);
+		}
+
+		/**
+		 * Write an ISO-9660 32-bit value. (LE, then BE)
+		 */
+		static inline void put_iso32(uint8_t *p, uint32_t val)
+		{
+			put_le32(&p[0], val);
+			put_be32(&p[4], val);
+		}
+
+		/**
+		 * Assign file offsets and copy the file data into the disc image.
+		 * @param data_offset	[in] Starting offset for file data
+		 * @param align		[in] File alignment
+		 */
+		void assignFileOffsets(uint32_t data_offset, uint32_t align);
+
+		/**
+		 * Build a GameCube disc image with an FST containing testFiles[].
+		 */
+		void buildGcnImage(void);
+
+		/**
+		 * Add an ISO-9660 directory entry.
+		 * @param p		[in] Directory entry
+		 * @param block		[in] Starting block
+		 * @param size		[in] Size, in bytes
+		 * @param isDir		[in] True for a directory
+		 * @param name		[in] Filename
+		 * @param name_len	[in] Filename length
+		 * @return Directory entry length
+		 */
+		static unsigned int putIsoDirEntry(uint8_t *p, uint32_t block, uint32_t size,
+			bool isDir, const char *name, unsigned int name_len);
+
+		/**
+		 * Build an ISO-9660 disc image (PSP UMD) containing testFiles[].
+		 */
+		void buildIsoImage(void);
+
+		/**
+		 * Add an XDVDFS directory entry.
+		 * @param p		[in] Directory entry
+		 * @param left		[in] Left subtree offset, in bytes (0 for none)
+		 * @param right		[in] Right subtree offset, in bytes (0 for none)
+		 * @param sector	[in] Starting sector
+		 * @param size		[in] Size, in bytes
+		 * @param isDir		[in] True for a directory
+		 * @param name		[in] Filename
+		 */
+		static void putXdvdfsDirEntry(uint8_t *p, unsigned int left, unsigned int right,
+			uint32_t sector, uint32_t size, bool isDir, const char *name);
+
+		/**
+		 * Build an extracted XDVDFS disc image containing testFiles[].
+		 */
+		void buildXdvdfsImage(void);
+
+		/**
+		 * Write the disc image to a temporary file.
+		 */
+		void writeDiscImage(void);
+
+		/**
+		 * Read a directory using the partition's IFst.
+		 * @param fst	[in] IFst
+		 * @param path	[in] Directory path
+		 * @return Directory entries, as "name" or "name/" for directories
+		 */
+		static vector<string> readDir(IFst *fst, const char *path);
+
+		/**
+		 * Check the extracted files.
+		 */
+		void checkExtractedFiles(void);
+
+		/**
+		 * Extract the disc image.
+		 * @param file Disc image file
+		 * @param pDirectSize [out] Number of bytes copied directly
+		 */
+		void extract(IRpFile *file, off64_t *pDirectSize);
+
+	public:
+		vector<uint8_t> image;	// Disc image contents
+		string imageFilename;	// Disc image filename
+		string outdir;		// Output directory, with a trailing separator
+};
+
+/**
+ * Assign file offsets and copy the file data into the disc image.
+ * @param data_offset	[in] Starting offset for file data
+ * @param align		[in] File alignment
+ */
+void FstExtractorTest::assignFileOffsets(uint32_t data_offset, uint32_t align)
+{
+	uint32_t data_end = data_offset;
+	for (TestFile &testFile : testFiles) {
+		testFile.offset = data_end;
+		data_end += static_cast<uint32_t>((testFile.size + (align - 1)) & ~(align - 1));
+	}
+	image.assign(data_end, 0);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(testFiles); i++) {
+		const vector<uint8_t> data = fileData(i);
+		if (!data.empty()) {
+			memcpy(&image[testFiles[i].offset], data.data(), data.size());
+		}
+	}
+}
+
+/**
+ * Build a GameCube disc image with an FST containing testFiles[].
+ */
+void FstExtractorTest::buildGcnImage(void)
+{
+	static const uint32_t FST_OFFSET = 0x2440;
+	static const uint32_t DATA_OFFSET = 0x8000;
+
+	// FST entries:
+	// 0: root, 1: a.bin, 2: dir, 3: dir/b.bin, 4: dir/empty.bin, 5: c.bin
+	static const unsigned int ENTRY_COUNT = 6;
+	static const char strtbl[] = "a.bin\0dir\0b.bin\0empty.bin\0c.bin";
+	static const uint32_t name_offsets[ENTRY_COUNT] = {0, 0, 6, 10, 16, 26};
+	const uint32_t fst_size = ENTRY_COUNT * 12 + sizeof(strtbl);
+
+	assignFileOffsets(DATA_OFFSET, 0x8000);
+	uint8_t *const p = image.data();
+
+	// Disc header
+	memcpy(p, "GTST01", 6);
+	memcpy(&p[0x20], "FstExtractorTest", 16);
+	put_be32(&p[0x1C], 0xC2339F3D);
+
+	// Boot block
+	put_be32(&p[0x420], 0x2000);		// dol_offset
+	put_be32(&p[0x424], FST_OFFSET);	// fst_offset
+	put_be32(&p[0x428], fst_size);		// fst_size
+	put_be32(&p[0x42C], fst_size);		// fst_max_size
+
+	// FST
+	uint8_t *fst = &p[FST_OFFSET];
+	put_be32(&fst[0*12+0], 0x01000000);	// root
+	put_be32(&fst[0*12+8], ENTRY_COUNT);
+	put_be32(&fst[2*12+0], 0x01000000 | name_offsets[2]);	// dir
+	put_be32(&fst[2*12+4], 0);
+	put_be32(&fst[2*12+8], 5);
+	static const uint8_t file_entries[] = {1, 3, 4, 5};
+	for (unsigned int i = 0; i < ARRAY_SIZE(testFiles); i++) {
+		uint8_t *const entry = &fst[file_entries[i] * 12];
+		put_be32(&entry[0], name_offsets[file_entries[i]]);
+		put_be32(&entry[4], testFiles[i].offset);
+		put_be32(&entry[8], static_cast<uint32_t>(testFiles[i].size));
+	}
+	memcpy(&fst[ENTRY_COUNT * 12], strtbl, sizeof(strtbl));
+}
+
+/**
+ * Add an ISO-9660 directory entry.
+ * @param p		[in] Directory entry
+ * @param block		[in] Starting block
+ * @param size		[in] Size, in bytes
+ * @param isDir		[in] True for a directory
+ * @param name		[in] Filename
+ * @param name_len	[in] Filename length
+ * @return Directory entry length
+ */
+unsigned int FstExtractorTest::putIsoDirEntry(uint8_t *p, uint32_t block, uint32_t size,
+	bool isDir, const char *name, unsigned int name_len)
+{
+	// Directory entries have an even length.
+	const unsigned int entry_length = (33 + name_len + 1) & ~1U;
+	p[0] = static_cast<uint8_t>(entry_length);
+	put_iso32(&p[2], block);
+	put_iso32(&p[10], size);
+	p[25] = isDir ? 0x02 : 0x00;	// ISO_FLAG_DIRECTORY
+	p[28] = 1;			// volume_seq_num (LE)
+	p[31] = 1;			// volume_seq_num (BE)
+	p[32] = static_cast<uint8_t>(name_len);
+	memcpy(&p[33], name, name_len);
+	return entry_length;
+}
+
+/**
+ * Build an ISO-9660 disc image (PSP UMD) containing testFiles[].
+ */
+void FstExtractorTest::buildIsoImage(void)
+{
+	// Root directory: 2 blocks, so the second block starts after padding.
+	static const uint32_t ROOT_LBA = 20;
+	static const uint32_t DIR_LBA = 22;
+	static const uint32_t DATA_LBA = 24;
+	assignFileOffsets(DATA_LBA * 2048, 2048);
+	uint8_t *const p = image.data();
+
+	// Primary volume descriptor
+	uint8_t *const pvd = &p[16 * 2048];
+	pvd[0] = 1;	// ISO_VDT_PRIMARY
+	memcpy(&pvd[1], "CD001", 5);
+	pvd[6] = 1;	// ISO_VD_VERSION
+	memset(&pvd[8], ' ', 64);
+	memcpy(&pvd[8], "PSP GAME", 8);
+	put_iso32(&pvd[0x50], static_cast<uint32_t>(image.size() / 2048));
+	pvd[0x80] = 0x00; pvd[0x81] = 0x08;	// logical_block_size (LE)
+	pvd[0x82] = 0x08; pvd[0x83] = 0x00;	// logical_block_size (BE)
+	putIsoDirEntry(&pvd[0x9C], ROOT_LBA, 2 * 2048, true, "", 1);
+
+	// Volume descriptor set terminator
+	uint8_t *const vdst = &p[17 * 2048];
+	vdst[0] = 255;	// ISO_VDT_TERMINATOR
+	memcpy(&vdst[1], "CD001", 5);
+	vdst[6] = 1;	// ISO_VD_VERSION
+
+	// Root directory
+	// NOTE: Filenames have version numbers, which should be removed.
+	uint8_t *d = &p[ROOT_LBA * 2048];
+	d += putIsoDirEntry(d, ROOT_LBA, 2 * 2048, true, "\0", 1);
+	d += putIsoDirEntry(d, ROOT_LBA, 2 * 2048, true, "\1", 1);
+	putIsoDirEntry(d, testFiles[0].offset / 2048, static_cast<uint32_t>(testFiles[0].size), false, "a.bin;1", 7);
+	d = &p[(ROOT_LBA + 1) * 2048];
+	d += putIsoDirEntry(d, testFiles[3].offset / 2048, static_cast<uint32_t>(testFiles[3].size), false, "c.bin;1", 7);
+	putIsoDirEntry(d, DIR_LBA, 2048, true, "dir", 3);
+
+	// Subdirectory
+	d = &p[DIR_LBA * 2048];
+	d += putIsoDirEntry(d, DIR_LBA, 2048, true, "\0", 1);
+	d += putIsoDirEntry(d, ROOT_LBA, 2 * 2048, true, "\1", 1);
+	d += putIsoDirEntry(d, testFiles[1].offset / 2048, static_cast<uint32_t>(testFiles[1].size), false, "b.bin;1", 7);
+	putIsoDirEntry(d, testFiles[2].offset / 2048, static_cast<uint32_t>(testFiles[2].size), false, "empty.bin;1", 11);
+}
+
+/**
+ * Add an XDVDFS directory entry.
+ * @param p		[in] Directory entry
+ * @param left		[in] Left subtree offset, in bytes (0 for none)
+ * @param right		[in] Right subtree offset, in bytes (0 for none)
+ * @param sector	[in] Starting sector
+ * @param size		[in] Size, in bytes
+ * @param isDir		[in] True for a directory
+ * @param name		[in] Filename
+ */
+void FstExtractorTest::putXdvdfsDirEntry(uint8_t *p, unsigned int left, unsigned int right,
+	uint32_t sector, uint32_t size, bool isDir, const char *name)
+{
+	const size_t name_len = strlen(name);
+	put_le16(&p[0], static_cast<uint16_t>(left / 4));
+	put_le16(&p[2], static_cast<uint16_t>(right / 4));
+	put_le32(&p[4], sector);
+	put_le32(&p[8], size);
+	p[12] = isDir ? 0x10 : 0x80;	// XDVDFS_ATTR_DIRECTORY : XDVDFS_ATTR_NORMAL
+	p[13] = static_cast<uint8_t>(name_len);
+	memcpy(&p[14], name, name_len);
+}
+
+/**
+ * Build an extracted XDVDFS disc image containing testFiles[].
+ */
+void FstExtractorTest::buildXdvdfsImage(void)
+{
+	static const uint32_t ROOT_LBA = 33;
+	static const uint32_t DIR_LBA = 34;
+	static const uint32_t DATA_LBA = 35;
+	assignFileOffsets(DATA_LBA * 2048, 2048);
+	uint8_t *const p = image.data();
+
+	// ISO-9660 primary volume descriptor
+	// The creation time doesn't match any Xbox disc,
+	// so this is detected as an extracted XDVDFS.
+	uint8_t *const pvd = &p[16 * 2048];
+	pvd[0] = 1;	// ISO_VDT_PRIMARY
+	memcpy(&pvd[1], "CD001", 5);
+	pvd[6] = 1;	// ISO_VD_VERSION
+
+	// XDVDFS header
+	uint8_t *const hdr = &p[32 * 2048];
+	memcpy(&hdr[0], "MICROSOFT*XBOX*MEDIA", 20);
+	put_le32(&hdr[0x14], ROOT_LBA);
+	put_le32(&hdr[0x18], 2048);
+	memcpy(&hdr[0x7EC], "MICROSOFT*XBOX*MEDIA", 20);
+
+	// Root directory: Binary tree with "c.bin" at the root.
+	// Unused space is filled with 0xFF.
+	// Entries are DWORD-aligned: 14 bytes, plus the filename.
+	uint8_t *d = &p[ROOT_LBA * 2048];
+	memset(d, 0xFF, 2048);
+	putXdvdfsDirEntry(&d[0], 20, 40, testFiles[3].offset / 2048, static_cast<uint32_t>(testFiles[3].size), false, "c.bin");
+	putXdvdfsDirEntry(&d[20], 0, 0, testFiles[0].offset / 2048, static_cast<uint32_t>(testFiles[0].size), false, "a.bin");
+	putXdvdfsDirEntry(&d[40], 0, 0, DIR_LBA, 2048, true, "dir");
+
+	// Subdirectory: "b.bin", with "empty.bin" as the right subtree.
+	d = &p[DIR_LBA * 2048];
+	memset(d, 0xFF, 2048);
+	putXdvdfsDirEntry(&d[0], 0, 20, testFiles[1].offset / 2048, static_cast<uint32_t>(testFiles[1].size), false, "b.bin");
+	putXdvdfsDirEntry(&d[20], 0, 0, testFiles[2].offset / 2048, static_cast<uint32_t>(testFiles[2].size), false, "empty.bin");
+}
+
+/**
+ * Write the disc image to a temporary file.
+ */
+void FstExtractorTest::writeDiscImage(void)
+{
+	FILE *const f = fopen(imageFilename.c_str(), "wb");
+	ASSERT_NE(nullptr, f);
+	EXPECT_EQ(image.size(), fwrite(image.data(), 1, image.size(), f));
+	fclose(f);
+}
+
+/**
+ * Read a directory using the partition's IFst.
+ * @param fst	[in] IFst
+ * @param path	[in] Directory path
+ * @return Directory entries, as "name" or "name/" for directories
+ */
+vector<string> FstExtractorTest::readDir(IFst *fst, const char *path)
+{
+	vector<string> names;
+	IFst::Dir *const dirp = fst->opendir(path);
+	EXPECT_NE(nullptr, dirp) << path;
+	if (!dirp) {
+		return names;
+	}
+
+	for (const IFst::DirEnt *dirent = fst->readdir(dirp); dirent != nullptr; dirent = fst->readdir(dirp)) {
+		string name = dirent->name;
+		if (dirent->type == DT_DIR) {
+			name += '/';
+		}
+		names.emplace_back(std::move(name));
+	}
+	EXPECT_EQ(0, fst->closedir(dirp));
+	return names;
+}
+
+/**
+ * Check the extracted files.
+ */
+void FstExtractorTest::checkExtractedFiles(void)
+{
+	for (unsigned int i = 0; i < ARRAY_SIZE(testFiles); i++) {
+		const string filename = outdir + testFiles[i].path;
+		RpFile *const file = new RpFile(filename, RpFile::FM_OPEN_READ);
+		EXPECT_TRUE(file->isOpen()) << filename;
+		if (!file->isOpen()) {
+			file->unref();
+			continue;
+		}
+
+		const vector<uint8_t> expected = fileData(i);
+		vector<uint8_t> data(expected.size() + 1);
+		EXPECT_EQ(expected.size(), file->read(data.data(), data.size())) << filename;
+		data.resize(expected.size());
+		EXPECT_TRUE(data == expected) << "Data mismatch in " << filename;
+		file->unref();
+	}
+}
+
+/**
+ * Extract the disc image.
+ * @param file Disc image file
+ * @param pDirectSize [out] Number of bytes copied directly
+ */
+void FstExtractorTest::extract(IRpFile *file, off64_t *pDirectSize)
+{
+	RomData *const romData = RomDataFactory::create(file);
+	ASSERT_NE(nullptr, romData);
+	IPartition *const partition = romData->openFstPartition();
+	romData->unref();
+	ASSERT_NE(nullptr, partition);
+
+	FstExtractor extractor(partition);
+	partition->unref();
+	EXPECT_EQ(0, extractor.extractAll(outdir));
+	EXPECT_EQ(ARRAY_SIZE(testFiles), extractor.fileCount());
+	EXPECT_EQ(0U, extractor.errorCount());
+	EXPECT_EQ(totalFileSize(), extractor.totalSize());
+	*pDirectSize = extractor.directSize();
+
+	checkExtractedFiles();
+}
+
+/**
+ * Extract from a regular file. Files are copied directly if supported.
+ */
+TEST_P(FstExtractorTest, directTest)
+{
+	RpFile *const file = new RpFile(imageFilename, RpFile::FM_OPEN_READ);
+	ASSERT_TRUE(file->isOpen());
+
+	off64_t directSize = -1;
+	extract(file, &directSize);
+	file->unref();
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+	EXPECT_EQ(totalFileSize(), directSize);
+#else /* !(HAVE_COPY_FILE_RANGE || HAVE_SENDFILE) */
+	EXPECT_EQ(0, directSize);
+#endif /* HAVE_COPY_FILE_RANGE || HAVE_SENDFILE */
+}
+
+/**
+ * Extract from a regular file wrapped in another IRpFile decorator.
+ * The decorators are unwrapped, so files are still copied directly.
+ */
+TEST_P(FstExtractorTest, decoratedDirectTest)
+{
+	RpFile *const rpFile = new RpFile(imageFilename, RpFile::FM_OPEN_READ);
+	ASSERT_TRUE(rpFile->isOpen());
+	BlockCacheFile *const file = new BlockCacheFile(rpFile);
+	rpFile->unref();
+
+	off64_t directSize = -1;
+	extract(file, &directSize);
+	file->unref();
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+	EXPECT_EQ(totalFileSize(), directSize);
+#else /* !(HAVE_COPY_FILE_RANGE || HAVE_SENDFILE) */
+	EXPECT_EQ(0, directSize);
+#endif /* HAVE_COPY_FILE_RANGE || HAVE_SENDFILE */
+}
+
+/**
+ * Extract from a MemFile. Files are read through the partition.
+ */
+TEST_P(FstExtractorTest, bufferedTest)
+{
+	MemFile *const file = new MemFile(image.data(), image.size());
+	file->setFilename(imageFilename);	// ISO detection checks the file extension.
+
+	off64_t directSize = -1;
+	extract(file, &directSize);
+	file->unref();
+
+	EXPECT_EQ(0, directSize);
+}
+
+/**
+ * IPartition::getFileRange() and RpFile::copyRangeFrom() for a single file.
+ */
+TEST_P(FstExtractorTest, getFileRangeTest)
+{
+	RpFile *const rpFile = new RpFile(imageFilename, RpFile::FM_OPEN_READ);
+	ASSERT_TRUE(rpFile->isOpen());
+	RomData *const romData = RomDataFactory::create(rpFile);
+	ASSERT_NE(nullptr, romData);
+	IPartition *const partition = romData->openFstPartition();
+	romData->unref();
+	ASSERT_NE(nullptr, partition);
+
+	// dir/b.bin
+	const TestFile &testFile = testFiles[1];
+	off64_t filePos = -1;
+	IRpFile *file = partition->getFileRange(testFile.offset, testFile.size, &filePos);
+	ASSERT_NE(nullptr, file);
+	EXPECT_EQ(static_cast<off64_t>(testFile.offset), filePos);
+
+	// RomDataFactory wraps the file in a HeaderCacheFile.
+	EXPECT_NE(nullptr, file->baseFile());
+	while (file->baseFile()) {
+		file = file->baseFile();
+	}
+	ASSERT_EQ(static_cast<IRpFile*>(rpFile), file);
+
+	ASSERT_EQ(0, FileSystem::rmkdir(outdir + "dir/"));
+	const string filename = outdir + testFile.path;
+	RpFile *const dest = new RpFile(filename, RpFile::FM_CREATE_WRITE);
+	ASSERT_TRUE(dest->isOpen());
+	const off64_t ret = dest->copyRangeFrom(rpFile, filePos, testFile.size);
+	dest->unref();
+	partition->unref();
+	rpFile->unref();
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+	EXPECT_EQ(static_cast<off64_t>(testFile.size), ret);
+
+	RpFile *const check = new RpFile(filename, RpFile::FM_OPEN_READ);
+	ASSERT_TRUE(check->isOpen());
+	const vector<uint8_t> expected = fileData(1);
+	vector<uint8_t> data(expected.size());
+	EXPECT_EQ(expected.size(), check->read(data.data(), data.size()));
+	EXPECT_TRUE(data == expected);
+	check->unref();
+#else /* !(HAVE_COPY_FILE_RANGE || HAVE_SENDFILE) */
+	EXPECT_EQ(-ENOTSUP, ret);
+#endif /* HAVE_COPY_FILE_RANGE || HAVE_SENDFILE */
+}
+
+/**
+ * Enumerate directories using IPartition::fst().
+ */
+TEST_P(FstExtractorTest, readdirTest)
+{
+	RpFile *const rpFile = new RpFile(imageFilename, RpFile::FM_OPEN_READ);
+	ASSERT_TRUE(rpFile->isOpen());
+	RomData *const romData = RomDataFactory::create(rpFile);
+	rpFile->unref();
+	ASSERT_NE(nullptr, romData);
+	IPartition *const partition = romData->openFstPartition();
+	romData->unref();
+	ASSERT_NE(nullptr, partition);
+	IFst *const fst = partition->fst();
+	ASSERT_NE(nullptr, fst);
+
+	vector<string> root = readDir(fst, "/");
+	vector<string> dir = readDir(fst, "/dir");
+	EXPECT_FALSE(fst->hasErrors());
+	if (GetParam().format == DiscFormat::XDVDFS) {
+		// XDVDFS directories are binary trees, so they're read in sorted order.
+		EXPECT_TRUE(std::is_sorted(root.begin(), root.end()));
+		EXPECT_TRUE(std::is_sorted(dir.begin(), dir.end()));
+	}
+
+	std::sort(root.begin(), root.end());
+	std::sort(dir.begin(), dir.end());
+	const vector<string> expected_root = {"a.bin", "c.bin", "dir/"};
+	const vector<string> expected_dir = {"b.bin", "empty.bin"};
+	EXPECT_EQ(expected_root, root);
+	EXPECT_EQ(expected_dir, dir);
+
+	// Check a file's offset and size.
+	IFst::DirEnt dirent;
+	ASSERT_EQ(0, fst->find_file("/dir/b.bin", &dirent));
+	EXPECT_EQ(DT_REG, dirent.type);
+	EXPECT_EQ(static_cast<off64_t>(testFiles[1].offset), dirent.offset);
+	EXPECT_EQ(static_cast<off64_t>(testFiles[1].size), dirent.size);
+	EXPECT_STREQ("b.bin", dirent.name);
+
+	// Nonexistent directory
+	EXPECT_EQ(nullptr, fst->opendir("/nonexistent"));
+
+	partition->unref();
+}
+
+INSTANTIATE_TEST_SUITE_P(FstExtractorTest, FstExtractorTest,
+	::testing::Values(
+		FstExtractorTest_mode(DiscFormat::GCN, "GCN"),
+		FstExtractorTest_mode(DiscFormat::ISO, "ISO"),
+		FstExtractorTest_mode(DiscFormat::XDVDFS, "XDVDFS"))
+	);
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRomData test suite: FstExtractor tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// Use a temporary directory for the disc image and extracted files.
+	const char *const env_tmpdir = getenv("TMPDIR");
+	string tmpl = (env_tmpdir && env_tmpdir[0] == '/') ? env_tmpdir : "/tmp";
+	tmpl += "/rp-FstExtractorTest.XXXXXX";
+	if (!mkdtemp(&tmpl[0])) {
+		fprintf(stderr, "*** ERROR: Unable to create a temporary directory: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	LibRomData::Tests::tmpdir = tmpl;
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	const int ret = RUN_ALL_TESTS();
+
+	rmdir(tmpl.c_str());
+	return ret;
+}
@@ -0,0 +1,279 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * NCCHReaderTest.cpp: NCCHReader test.                                    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpbase, librpfile
+#include "librpbase/disc/IDiscReader.hpp"
+#include "librpfile/IRpFile.hpp"
+#include "librpcpu/byteswap_rp.h"
+using namespace LibRpBase;
+using namespace LibRpFile;
+
+// libromdata
+#include "libromdata/disc/NCCHReader.hpp"
+#include "libromdata/Handheld/n3ds_structs.h"
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <algorithm>
+#include <vector>
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+/**
+ * In-memory file that counts the number of reads.
+ */
+class CountingFile final : public IRpFile
+{
+	public:
+		/**
+		 * Create a CountingFile.
+		 * @param data File data
+		 */
+		explicit CountingFile(vector<uint8_t> &&data)
+			: m_data(std::move(data))
+			, m_pos(0)
+			, readCount(0)
+		{ }
+
+	private:
+		RP_DISABLE_COPY(CountingFile)
+
+	public:
+		bool isOpen(void) const final { return true; }
+		void close(void) final { }
+
+		size_t read(void *ptr, size_t size) final
+		{
+			readCount++;
+			if (m_pos >= static_cast<off64_t>(m_data.size()))
+				return 0;
+			size = std::min(size, m_data.size() - static_cast<size_t>(m_pos));
+			memcpy(ptr, &m_data[static_cast<size_t>(m_pos)], size);
+			m_pos += size;
+			return size;
+		}
+
+		size_t write(const void *ptr, size_t size) final
+		{
+			RP_UNUSED(ptr);
+			RP_UNUSED(size);
+			m_lastError = EBADF;
+			return 0;
+		}
+
+		int seek(off64_t pos) final
+		{
+			m_pos = pos;
+			return 0;
+		}
+
+		off64_t tell(void) final { return m_pos; }
+		off64_t size(void) final { return static_cast<off64_t>(m_data.size()); }
+
+	private:
+		vector<uint8_t> m_data;
+		off64_t m_pos;
+
+	public:
+		unsigned int readCount;	// Number of reads
+};
+
+class NCCHReaderTest : public ::testing::Test
+{
+	protected:
+		NCCHReaderTest()
+			: countingFile(nullptr)
+			, ncchReader(nullptr)
+		{ }
+
+		void SetUp(void) override;
+		void TearDown(void) override;
+
+	public:
+		// NCCH length, in bytes.
+		static const uint32_t NCCH_LENGTH = 64*1024;
+
+		// Range cache parameters. (from NCCHReaderPrivate)
+		static const unsigned int RANGE_CACHE_COUNT = 4;
+		static const size_t RANGE_CACHE_MAX_SIZE = 16384;
+
+		/**
+		 * Read from the NCCHReader and verify the data.
+		 * @param pos Starting position
+		 * @param size Amount of data to read
+		 * @return Number of reads from the underlying file.
+		 */
+		unsigned int readAndVerify(uint32_t pos, size_t size);
+
+	protected:
+		CountingFile *countingFile;
+		IDiscReader *ncchReader;
+
+		// Expected NCCH contents.
+		vector<uint8_t> ncchData;
+};
+
+void NCCHReaderTest::SetUp(void)
+{
+	// Build a NoCrypto NCCH filled with pseudo-random data.
+	// The ExeFS offset is 0, so the constructor only reads the header.
+	ncchData.resize(NCCH_LENGTH);
+	uint32_t seed = 0x4E434348U;
+	for (uint8_t &b : ncchData) {
+		seed = seed * 1103515245U + 12345U;
+		b = static_cast<uint8_t>(seed >> 24);
+	}
+
+	N3DS_NCCH_Header_t *const ncch_header =
+		reinterpret_cast<N3DS_NCCH_Header_t*>(ncchData.data());
+	ncch_header->hdr.magic = cpu_to_be32(N3DS_NCCH_HEADER_MAGIC);
+	ncch_header->hdr.content_size = cpu_to_le32(NCCH_LENGTH >> 9);
+	ncch_header->hdr.flags[N3DS_NCCH_FLAG_BIT_MASKS] = N3DS_NCCH_BIT_MASK_NoCrypto;
+	ncch_header->hdr.exheader_size = 0;
+	ncch_header->hdr.exefs_offset = 0;
+	ncch_header->hdr.exefs_size = 0;
+
+	countingFile = new CountingFile(vector<uint8_t>(ncchData));
+	ncchReader = new NCCHReader(countingFile, 9, 0, NCCH_LENGTH);
+	countingFile->readCount = 0;
+}
+
+void NCCHReaderTest::TearDown(void)
+{
+	UNREF_AND_NULL(ncchReader);
+	UNREF_AND_NULL(countingFile);
+}
+
+/**
+ * Read from the NCCHReader and verify the data.
+ * @param pos Starting position
+ * @param size Amount of data to read
+ * @return Number of reads from the underlying file.
+ */
+unsigned int NCCHReaderTest::readAndVerify(uint32_t pos, size_t size)
+{
+	vector<uint8_t> buf(size, 0xCC);
+	countingFile->readCount = 0;
+	EXPECT_EQ(0, ncchReader->seek(pos));
+	EXPECT_EQ(size, ncchReader->read(buf.data(), size));
+	EXPECT_EQ(static_cast<off64_t>(pos + size), ncchReader->tell());
+	EXPECT_EQ(0, memcmp(buf.data(), &ncchData[pos], size));
+	return countingFile->readCount;
+}
+
+/**
+ * Read the entire NCCH sequentially, without seeking.
+ * NoCrypto reads must advance the read position.
+ */
+TEST_F(NCCHReaderTest, sequentialNoCryptoReads)
+{
+	ASSERT_EQ(0, ncchReader->seek(0));
+
+	// Use an odd read size so most reads are unaligned.
+	vector<uint8_t> buf(1000);
+	uint32_t pos = 0;
+	while (pos < NCCH_LENGTH) {
+		const size_t expectedSize = std::min(buf.size(), static_cast<size_t>(NCCH_LENGTH - pos));
+		ASSERT_EQ(expectedSize, ncchReader->read(buf.data(), buf.size())) << "pos == " << pos;
+		ASSERT_EQ(0, memcmp(buf.data(), &ncchData[pos], expectedSize)) << "pos == " << pos;
+		pos += static_cast<uint32_t>(expectedSize);
+		ASSERT_EQ(static_cast<off64_t>(pos), ncchReader->tell());
+	}
+
+	// End of the NCCH.
+	EXPECT_EQ(0U, ncchReader->read(buf.data(), buf.size()));
+	EXPECT_EQ(static_cast<off64_t>(NCCH_LENGTH), ncchReader->tell());
+}
+
+/**
+ * An aligned read is cached, so reading it again
+ * (or reading a subrange) doesn't read from the file.
+ */
+TEST_F(NCCHReaderTest, alignedReadIsCached)
+{
+	EXPECT_EQ(1U, readAndVerify(0x2000, 0x1000));
+	EXPECT_EQ(0U, readAndVerify(0x2000, 0x1000));
+	EXPECT_EQ(0U, readAndVerify(0x2010, 0x100));
+	EXPECT_EQ(0U, readAndVerify(0x2FF0, 0x10));
+
+	// Past the end of the cached range.
+	EXPECT_EQ(1U, readAndVerify(0x2FF0, 0x20));
+}
+
+/**
+ * Only the 16-byte aligned blocks of an unaligned read are cached.
+ */
+TEST_F(NCCHReaderTest, unalignedReadMisses)
+{
+	EXPECT_EQ(1U, readAndVerify(0x3001, 0x100));
+
+	// The unaligned head and tail aren't cached.
+	EXPECT_EQ(1U, readAndVerify(0x3001, 0x100));
+	EXPECT_EQ(1U, readAndVerify(0x3008, 0x8));
+	EXPECT_EQ(1U, readAndVerify(0x3100, 0x1));
+
+	// The aligned blocks in the middle are cached.
+	EXPECT_EQ(0U, readAndVerify(0x3010, 0xF0));
+
+	// A read that doesn't cover a whole aligned block isn't cached at all.
+	EXPECT_EQ(1U, readAndVerify(0x3801, 0xE));
+	EXPECT_EQ(1U, readAndVerify(0x3801, 0xE));
+}
+
+/**
+ * Reads larger than RANGE_CACHE_MAX_SIZE are not cached.
+ */
+TEST_F(NCCHReaderTest, largeReadNotCached)
+{
+	EXPECT_EQ(1U, readAndVerify(0x4000, RANGE_CACHE_MAX_SIZE + 16));
+	EXPECT_EQ(1U, readAndVerify(0x4000, RANGE_CACHE_MAX_SIZE + 16));
+	EXPECT_EQ(1U, readAndVerify(0x4000, 16));
+
+	// RANGE_CACHE_MAX_SIZE itself is cached.
+	EXPECT_EQ(1U, readAndVerify(0x4000, RANGE_CACHE_MAX_SIZE));
+	EXPECT_EQ(0U, readAndVerify(0x4000, RANGE_CACHE_MAX_SIZE));
+}
+
+/**
+ * The range cache has four entries, and the oldest entry is replaced.
+ */
+TEST_F(NCCHReaderTest, cacheReplacesOldestEntry)
+{
+	for (unsigned int i = 0; i <= RANGE_CACHE_COUNT; i++) {
+		EXPECT_EQ(1U, readAndVerify(0x1000 * (i + 1), 0x200));
+	}
+
+	// The first range was replaced.
+	for (unsigned int i = 1; i <= RANGE_CACHE_COUNT; i++) {
+		EXPECT_EQ(0U, readAndVerify(0x1000 * (i + 1), 0x200));
+	}
+	EXPECT_EQ(1U, readAndVerify(0x1000, 0x200));
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRomData test suite: NCCHReader tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,333 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * SparseDiscReaderTest.cpp: SparseDiscReader test.                        *
+ * Uses a synthetic CISO image, since CisoGcnReader uses the default       *
+ * SparseDiscReader::readBlocks() implementation.                          *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpbase, librpcpu, librpfile
+#include "librpbase/disc/IDiscReader.hpp"
+#include "librpcpu/byteswap_rp.h"
+#include "librpfile/IRpFile.hpp"
+using namespace LibRpBase;
+using namespace LibRpFile;
+
+// libromdata
+#include "libromdata/disc/CisoGcnReader.hpp"
+#include "libromdata/disc/ciso_gcn.h"
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <algorithm>
+#include <ostream>
+#include <vector>
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+/**
+ * In-memory file that counts the number of reads.
+ */
+class CountingFile final : public IRpFile
+{
+	public:
+		/**
+		 * Create a CountingFile.
+		 * @param data File data
+		 */
+		explicit CountingFile(vector<uint8_t> &&data)
+			: m_data(std::move(data))
+			, m_pos(0)
+			, readCount(0)
+		{ }
+
+	private:
+		RP_DISABLE_COPY(CountingFile)
+
+	public:
+		bool isOpen(void) const final { return true; }
+		void close(void) final { }
+
+		size_t read(void *ptr, size_t size) final
+		{
+			readCount++;
+			if (m_pos >= static_cast<off64_t>(m_data.size()))
+				return 0;
+			size = std::min(size, m_data.size() - static_cast<size_t>(m_pos));
+			memcpy(ptr, &m_data[static_cast<size_t>(m_pos)], size);
+			m_pos += size;
+			return size;
+		}
+
+		size_t write(const void *ptr, size_t size) final
+		{
+			RP_UNUSED(ptr);
+			RP_UNUSED(size);
+			m_lastError = EBADF;
+			return 0;
+		}
+
+		int seek(off64_t pos) final
+		{
+			m_pos = pos;
+			return 0;
+		}
+
+		off64_t tell(void) final { return m_pos; }
+		off64_t size(void) final { return static_cast<off64_t>(m_data.size()); }
+
+	private:
+		vector<uint8_t> m_data;
+		off64_t m_pos;
+
+	public:
+		unsigned int readCount;	// Number of reads
+};
+
+struct SparseDiscReaderTest_mode
+{
+	off64_t pos;	// Starting position
+	size_t size;	// Amount of data to read
+
+	SparseDiscReaderTest_mode(off64_t pos, size_t size)
+		: pos(pos)
+		, size(size)
+	{ }
+};
+
+/**
+ * Formatting function for SparseDiscReaderTest_mode.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const SparseDiscReaderTest_mode& mode) {
+	return os << "pos=" << mode.pos << ", size=" << mode.size;
+}
+
+class SparseDiscReaderTest : public ::testing::TestWithParam<SparseDiscReaderTest_mode>
+{
+	protected:
+		SparseDiscReaderTest()
+			: countingFile(nullptr)
+			, discReader(nullptr)
+		{ }
+
+		void SetUp(void) override;
+		void TearDown(void) override;
+
+	public:
+		// Block size. (minimum CISO block size)
+		static const unsigned int BLOCK_SIZE = CISO_BLOCK_SIZE_MIN;
+
+		// Block map. (1 == used; 0 == empty)
+		// Used blocks are stored contiguously in the CISO image,
+		// so each run of used blocks is physically contiguous.
+		static const uint8_t blockMap[20];
+
+		/**
+		 * Count the number of reads that are needed to read a range of the disc.
+		 * @param pos Starting position
+		 * @param size Amount of data to read (must be within the disc)
+		 * @param coalesce If true, count a run of used full blocks as one read.
+		 * @return Number of reads
+		 */
+		static unsigned int countReads(off64_t pos, size_t size, bool coalesce);
+
+	protected:
+		CountingFile *countingFile;
+		IDiscReader *discReader;
+
+		// Expected disc contents.
+		vector<uint8_t> discData;
+};
+
+const uint8_t SparseDiscReaderTest::blockMap[20] = {
+	1, 1, 1, 0, 0, 1, 0, 1, 1, 1,
+	1, 0, 0, 0, 1, 1, 0, 1, 1, 1,
+};
+
+void SparseDiscReaderTest::SetUp(void)
+{
+	// Build the CISO image and the expected disc contents.
+	vector<uint8_t> ciso(sizeof(CISOHeader));
+	CISOHeader *const cisoHeader = reinterpret_cast<CISOHeader*>(ciso.data());
+	cisoHeader->magic = cpu_to_be32(CISO_MAGIC);
+	cisoHeader->block_size = cpu_to_le32(BLOCK_SIZE);
+	memcpy(cisoHeader->map, blockMap, sizeof(blockMap));
+
+	discData.resize(sizeof(blockMap) * BLOCK_SIZE);
+	uint32_t seed = 0x5EED1234U;
+	for (size_t i = 0; i < ARRAY_SIZE(blockMap); i++) {
+		if (!blockMap[i])
+			continue;
+
+		uint8_t *const pBlock = &discData[i * BLOCK_SIZE];
+		for (uint8_t *p = pBlock; p < pBlock + BLOCK_SIZE; p++) {
+			seed = seed * 1103515245U + 12345U;
+			*p = static_cast<uint8_t>(seed >> 24);
+		}
+		ciso.insert(ciso.end(), pBlock, pBlock + BLOCK_SIZE);
+	}
+
+	countingFile = new CountingFile(std::move(ciso));
+	discReader = new CisoGcnReader(countingFile);
+	ASSERT_EQ(static_cast<off64_t>(discData.size()), discReader->size());
+}
+
+void SparseDiscReaderTest::TearDown(void)
+{
+	UNREF_AND_NULL(discReader);
+	UNREF_AND_NULL(countingFile);
+}
+
+/**
+ * Count the number of reads that are needed to read a range of the disc.
+ * @param pos Starting position
+ * @param size Amount of data to read (must be within the disc)
+ * @param coalesce If true, count a run of used full blocks as one read.
+ * @return Number of reads
+ */
+unsigned int SparseDiscReaderTest::countReads(off64_t pos, size_t size, bool coalesce)
+{
+	unsigned int reads = 0;
+	bool inRun = false;
+	const off64_t end = pos + static_cast<off64_t>(size);
+	while (pos < end) {
+		const unsigned int blockIdx = static_cast<unsigned int>(pos / BLOCK_SIZE);
+		const off64_t blockStart = static_cast<off64_t>(blockIdx) * BLOCK_SIZE;
+		const off64_t blockEnd = blockStart + BLOCK_SIZE;
+		const bool isFullBlock = (pos == blockStart && end >= blockEnd);
+
+		if (!blockMap[blockIdx]) {
+			// Empty block: No read.
+			inRun = false;
+		} else if (coalesce && isFullBlock) {
+			// Full block: Only the first block of a run is a new read.
+			if (!inRun) {
+				reads++;
+				inRun = true;
+			}
+		} else {
+			// Partial block, or reading block-by-block.
+			reads++;
+			inRun = false;
+		}
+
+		pos = std::min(blockEnd, end);
+	}
+	return reads;
+}
+
+/**
+ * Read a range of the disc, then verify that the data matches
+ * the expected disc contents and the data returned by reading
+ * one block at a time.
+ */
+TEST_P(SparseDiscReaderTest, readMatchesBlockByBlock)
+{
+	const SparseDiscReaderTest_mode &mode = GetParam();
+	const off64_t discSize = static_cast<off64_t>(discData.size());
+
+	// Expected size: Short read at the end of the disc.
+	size_t expectedSize = 0;
+	if (mode.pos < discSize) {
+		expectedSize = static_cast<size_t>(std::min(static_cast<off64_t>(mode.size), discSize - mode.pos));
+	}
+
+	// Read the entire range at once.
+	vector<uint8_t> buf(mode.size, 0xCC);
+	countingFile->readCount = 0;
+	ASSERT_EQ(0, discReader->seek(mode.pos));
+	const size_t size = discReader->read(buf.data(), buf.size());
+	const unsigned int readCount = countingFile->readCount;
+	ASSERT_EQ(expectedSize, size);
+	EXPECT_EQ(mode.pos + static_cast<off64_t>(size), discReader->tell());
+	if (size > 0) {
+		EXPECT_EQ(0, memcmp(buf.data(), &discData[static_cast<size_t>(mode.pos)], size));
+	}
+
+	// Read the same range, one block at a time.
+	// Each of these reads is handled by SparseDiscReader::readBlock().
+	vector<uint8_t> buf_blk(mode.size, 0x33);
+	countingFile->readCount = 0;
+	ASSERT_EQ(0, discReader->seek(mode.pos));
+	size_t size_blk = 0;
+	while (size_blk < mode.size) {
+		const off64_t pos = mode.pos + static_cast<off64_t>(size_blk);
+		const size_t blockRemain = BLOCK_SIZE - static_cast<size_t>(pos % BLOCK_SIZE);
+		const size_t rd = discReader->read(&buf_blk[size_blk], std::min(blockRemain, mode.size - size_blk));
+		if (rd == 0)
+			break;
+		size_blk += rd;
+	}
+	const unsigned int readCount_blk = countingFile->readCount;
+	ASSERT_EQ(size, size_blk);
+	EXPECT_EQ(0, memcmp(buf.data(), buf_blk.data(), size));
+
+	// Check the number of reads.
+	EXPECT_EQ(countReads(mode.pos, size, true), readCount);
+	EXPECT_EQ(countReads(mode.pos, size, false), readCount_blk);
+	EXPECT_LE(readCount, readCount_blk);
+}
+
+/**
+ * Read the entire disc at once. This should use one read
+ * for each run of physically contiguous blocks.
+ */
+TEST_F(SparseDiscReaderTest, readEntireDisc)
+{
+	vector<uint8_t> buf(discData.size());
+	countingFile->readCount = 0;
+	ASSERT_EQ(0, discReader->seek(0));
+	ASSERT_EQ(buf.size(), discReader->read(buf.data(), buf.size()));
+	EXPECT_EQ(discData, buf);
+
+	// Runs of used blocks: [0-2], [5], [7-10], [14-15], [17-19]
+	// Reading one block at a time would need 14 reads.
+	EXPECT_EQ(5U, countingFile->readCount);
+}
+
+INSTANTIATE_TEST_SUITE_P(SparseDiscReaderTest, SparseDiscReaderTest,
+	::testing::Values(
+		// Block-aligned
+		SparseDiscReaderTest_mode(0, 20 * SparseDiscReaderTest::BLOCK_SIZE),
+		SparseDiscReaderTest_mode(1 * SparseDiscReaderTest::BLOCK_SIZE, 9 * SparseDiscReaderTest::BLOCK_SIZE),
+		SparseDiscReaderTest_mode(3 * SparseDiscReaderTest::BLOCK_SIZE, 2 * SparseDiscReaderTest::BLOCK_SIZE),
+		SparseDiscReaderTest_mode(7 * SparseDiscReaderTest::BLOCK_SIZE, 4 * SparseDiscReaderTest::BLOCK_SIZE),
+
+		// Unaligned start and/or end
+		SparseDiscReaderTest_mode(SparseDiscReaderTest::BLOCK_SIZE / 2 + 3, 10 * SparseDiscReaderTest::BLOCK_SIZE + 100),
+		SparseDiscReaderTest_mode(3 * SparseDiscReaderTest::BLOCK_SIZE + 17, 5 * SparseDiscReaderTest::BLOCK_SIZE),
+		SparseDiscReaderTest_mode(6 * SparseDiscReaderTest::BLOCK_SIZE, 5 * SparseDiscReaderTest::BLOCK_SIZE - 1),
+		SparseDiscReaderTest_mode(8 * SparseDiscReaderTest::BLOCK_SIZE - 1, 8 * SparseDiscReaderTest::BLOCK_SIZE + 2),
+		SparseDiscReaderTest_mode(7 * SparseDiscReaderTest::BLOCK_SIZE + 10, 100),
+
+		// End of the disc
+		SparseDiscReaderTest_mode(17 * SparseDiscReaderTest::BLOCK_SIZE + 5, 3 * SparseDiscReaderTest::BLOCK_SIZE),
+		SparseDiscReaderTest_mode(14 * SparseDiscReaderTest::BLOCK_SIZE, 8 * SparseDiscReaderTest::BLOCK_SIZE),
+		SparseDiscReaderTest_mode(20 * SparseDiscReaderTest::BLOCK_SIZE - 1, 10),
+		SparseDiscReaderTest_mode(20 * SparseDiscReaderTest::BLOCK_SIZE, 10))
+	);
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRomData test suite: SparseDiscReader tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
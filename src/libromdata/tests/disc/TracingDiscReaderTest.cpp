@@ -0,0 +1,103 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * TracingDiscReaderTest.cpp: TracingDiscReader test.                      *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpbase, librpfile
+#include "librpbase/disc/DiscReader.hpp"
+#include "librpfile/IoTrace.hpp"
+#include "librpfile/MemFile.hpp"
+using namespace LibRpBase;
+using namespace LibRpFile;
+
+// libromdata
+#include "libromdata/disc/TracingDiscReader.hpp"
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <regex>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+/**
+ * Reads and seeks through a TracingDiscReader are recorded
+ * with its tag, and the data is passed through unchanged.
+ */
+TEST(TracingDiscReaderTest, readsAreRecorded)
+{
+	vector<uint8_t> data(8192);
+	uint32_t seed = 0xD15CU;
+	for (uint8_t &b : data) {
+		seed = seed * 1103515245U + 12345U;
+		b = static_cast<uint8_t>(seed >> 24);
+	}
+
+	IoTrace::setEnabled(true);
+	IoTrace::reset();
+
+	MemFile *const memFile = new MemFile(data.data(), data.size());
+	IDiscReader *const discReader = new DiscReader(memFile);
+	IDiscReader *const tracingReader = new TracingDiscReader(discReader, "TracingDiscReaderTest");
+	EXPECT_EQ(static_cast<off64_t>(data.size()), tracingReader->size());
+
+	vector<uint8_t> buf(2048, 0xCC);
+	EXPECT_EQ(0, tracingReader->seek(2048));
+	EXPECT_EQ(buf.size(), tracingReader->read(buf.data(), buf.size()));
+	EXPECT_EQ(0, memcmp(buf.data(), &data[2048], buf.size()));
+	EXPECT_EQ(4096, tracingReader->tell());
+	EXPECT_EQ(32U, tracingReader->read(buf.data(), 32));
+	EXPECT_EQ(0, memcmp(buf.data(), &data[4096], 32));
+	EXPECT_EQ(0, tracingReader->seek(2048));
+	EXPECT_EQ(buf.size(), tracingReader->read(buf.data(), buf.size()));
+	EXPECT_EQ(0, memcmp(buf.data(), &data[2048], buf.size()));
+
+	UNREF(tracingReader);
+	UNREF(discReader);
+	UNREF(memFile);
+
+	// Latencies are removed, since they aren't deterministic.
+	static const std::regex latency_regex(",\"(us|read_time_us|max_read_us)\":[0-9]+");
+	const string json = std::regex_replace(IoTrace::toJSON(true), latency_regex, "");
+	IoTrace::setEnabled(false);
+	IoTrace::reset();
+
+	EXPECT_EQ("{\"io_trace\":[{\"class\":\"TracingDiscReaderTest\""
+		",\"reads\":3,\"bytes\":4128,\"seeks\":2"
+		",\"tiny_reads\":1,\"redundant_reads\":1"
+		",\"events\":["
+		"{\"op\":\"seek\",\"offset\":2048},"
+		"{\"op\":\"read\",\"offset\":2048,\"size\":2048},"
+		"{\"op\":\"read\",\"offset\":4096,\"size\":32},"
+		"{\"op\":\"seek\",\"offset\":2048},"
+		"{\"op\":\"read\",\"offset\":2048,\"size\":2048,\"redundant\":true}"
+		"],\"events_dropped\":0}]}", json);
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRomData test suite: TracingDiscReader tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
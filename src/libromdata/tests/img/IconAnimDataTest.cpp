@@ -0,0 +1,523 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * IconAnimDataTest.cpp: Animated icon frame decoding tests.               *
+ * Verifies that lazily-decoded frames match eagerly-decoded frames.       *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+#include "common.h"
+#include "librpcpu/byteswap_rp.h"
+
+// librpbase, librpfile, librptexture
+#include "librpbase/RomData.hpp"
+#include "librpbase/img/IconAnimData.hpp"
+#include "librpfile/MemFile.hpp"
+#include "librptexture/img/rp_image.hpp"
+#include "librptexture/decoder/ImageDecoder_GCN.hpp"
+#include "librptexture/decoder/ImageDecoder_NDS.hpp"
+#ifdef _WIN32
+// rp_image backend registration.
+#  include "librptexture/img/RpGdiplusBackend.hpp"
+#endif /* _WIN32 */
+using namespace LibRpBase;
+using namespace LibRpFile;
+using namespace LibRpTexture;
+
+// libromdata
+#include "libromdata/RomDataFactory.hpp"
+#include "libromdata/Console/gcn_card.h"
+#include "libromdata/Handheld/nds_structs.h"
+
+// C includes.
+#include <stdint.h>
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <array>
+#include <thread>
+#include <vector>
+using std::array;
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+class IconAnimDataTest : public ::testing::Test
+{
+	protected:
+		IconAnimDataTest()
+		{
+#ifdef _WIN32
+			// Register RpGdiplusBackend.
+			// TODO: Static initializer somewhere?
+			rp_image::setBackendCreatorFn(RpGdiplusBackend::creator_fn);
+#endif /* _WIN32 */
+		}
+
+	public:
+		/**
+		 * Fill a buffer with pseudo-random data.
+		 * A fixed seed is used so failures are reproducible.
+		 * @param buf Buffer
+		 * @param size Size of buffer
+		 * @param seed Seed
+		 */
+		static void fillRandom(void *buf, size_t size, uint32_t seed)
+		{
+			uint8_t *p = static_cast<uint8_t*>(buf);
+			for (; size > 0; size--, p++) {
+				seed = seed * 1103515245U + 12345U;
+				*p = static_cast<uint8_t>(seed >> 24);
+			}
+		}
+
+		/**
+		 * Compare two images.
+		 * @param expected Expected image
+		 * @param actual Actual image
+		 */
+		static void compareImages(const rp_image *expected, const rp_image *actual);
+
+		/**
+		 * Create a RomData object from a memory buffer.
+		 * @param data Data
+		 * @return RomData object, or nullptr on error.
+		 */
+		static RomData *createRomData(const vector<uint8_t> &data)
+		{
+			MemFile *const memFile = new MemFile(data.data(), data.size());
+			RomData *const romData = RomDataFactory::create(memFile);
+			memFile->unref();
+			return romData;
+		}
+
+		/**
+		 * Decode a DSi icon frame the same way the original eager decoder did.
+		 * @param nds_icon_title Icon/title data
+		 * @param high_token High byte of the sequence token
+		 * @return Decoded frame
+		 */
+		static rp_image *decodeDSiFrame(const NDS_IconTitleData *nds_icon_title, uint8_t high_token);
+
+		/**
+		 * Create a synthetic Nintendo DS ROM image with a DSi animated icon.
+		 * @param nds_icon_title [in/out] Icon/title data (bitmaps and palettes must be set)
+		 * @param seq Sequence tokens (delay must be non-zero)
+		 * @return ROM image
+		 */
+		static vector<uint8_t> createDSiRom(NDS_IconTitleData *nds_icon_title, const vector<uint16_t> &seq);
+};
+
+/**
+ * Compare two images.
+ * @param expected Expected image
+ * @param actual Actual image
+ */
+void IconAnimDataTest::compareImages(const rp_image *expected, const rp_image *actual)
+{
+	ASSERT_NE(nullptr, expected);
+	ASSERT_NE(nullptr, actual);
+	ASSERT_EQ(expected->width(), actual->width());
+	ASSERT_EQ(expected->height(), actual->height());
+	ASSERT_EQ(expected->format(), actual->format());
+
+	if (expected->format() == rp_image::Format::CI8) {
+		ASSERT_EQ(expected->palette_len(), actual->palette_len());
+		EXPECT_EQ(0, memcmp(expected->palette(), actual->palette(),
+			expected->palette_len() * sizeof(uint32_t))) << "Palettes don't match.";
+	}
+
+	const int width = expected->width();
+	const int height = expected->height();
+	const size_t row_bytes = (expected->format() == rp_image::Format::CI8)
+		? static_cast<size_t>(width)
+		: static_cast<size_t>(width) * sizeof(uint32_t);
+	for (int y = 0; y < height; y++) {
+		if (memcmp(expected->scanLine(y), actual->scanLine(y), row_bytes) != 0) {
+			ADD_FAILURE() << "Row " << y << " doesn't match.";
+			break;
+		}
+	}
+}
+
+/**
+ * Decode a DSi icon frame the same way the original eager decoder did.
+ * @param nds_icon_title Icon/title data
+ * @param high_token High byte of the sequence token
+ * @return Decoded frame
+ */
+rp_image *IconAnimDataTest::decodeDSiFrame(const NDS_IconTitleData *nds_icon_title, uint8_t high_token)
+{
+	const uint8_t bmp = (high_token & 7);
+	const uint8_t pal = (high_token >> 3) & 7;
+	rp_image *img = ImageDecoder::fromNDS_CI4(32, 32,
+		nds_icon_title->dsi_icon_data[bmp],
+		sizeof(nds_icon_title->dsi_icon_data[bmp]),
+		nds_icon_title->dsi_icon_pal[pal],
+		sizeof(nds_icon_title->dsi_icon_pal[pal]));
+	if (img && (high_token & (3U << 6))) {
+		// At least one flip bit is set.
+		rp_image::FlipOp flipOp = rp_image::FLIP_NONE;
+		if (high_token & (1U << 6)) {
+			// H-flip
+			flipOp = rp_image::FLIP_H;
+		}
+		if (high_token & (1U << 7)) {
+			// V-flip
+			flipOp = static_cast<rp_image::FlipOp>(flipOp | rp_image::FLIP_V);
+		}
+		rp_image *const flipimg = img->flip(flipOp);
+		img->unref();
+		img = flipimg;
+	}
+	return img;
+}
+
+/**
+ * Create a synthetic Nintendo DS ROM image with a DSi animated icon.
+ * @param nds_icon_title [in/out] Icon/title data (bitmaps and palettes must be set)
+ * @param seq Sequence tokens (delay must be non-zero)
+ * @return ROM image
+ */
+vector<uint8_t> IconAnimDataTest::createDSiRom(NDS_IconTitleData *nds_icon_title, const vector<uint16_t> &seq)
+{
+	// Icon must be located after the secure area.
+	static const uint32_t icon_offset = 0x8200;
+	vector<uint8_t> rom(icon_offset + sizeof(*nds_icon_title));
+
+	// ROM header: Only the Nintendo logo and icon offset are needed.
+	static const uint8_t nintendo_gba_logo[16] = {
+		0x24, 0xFF, 0xAE, 0x51, 0x69, 0x9A, 0xA2, 0x21,
+		0x3D, 0x84, 0x82, 0x0A, 0x84, 0xE4, 0x09, 0xAD
+	};
+	NDS_RomHeader *const romHeader = reinterpret_cast<NDS_RomHeader*>(rom.data());
+	memcpy(romHeader->title, "ICONTEST", 8);
+	memcpy(romHeader->id6, "ITSE01", 6);
+	memcpy(romHeader->nintendo_logo, nintendo_gba_logo, sizeof(nintendo_gba_logo));
+	romHeader->nintendo_logo_checksum = cpu_to_le16(0xCF56);
+	romHeader->unitcode = 0x02;	// DSi-enhanced
+	romHeader->icon_offset = cpu_to_le32(icon_offset);
+
+	// Icon/title data
+	nds_icon_title->version = cpu_to_le16(NDS_ICON_VERSION_DSi);
+	memset(nds_icon_title->dsi_icon_seq, 0, sizeof(nds_icon_title->dsi_icon_seq));
+	for (size_t i = 0; i < seq.size() && i < ARRAY_SIZE(nds_icon_title->dsi_icon_seq); i++) {
+		nds_icon_title->dsi_icon_seq[i] = cpu_to_le16(seq[i]);
+	}
+	memcpy(&rom[icon_offset], nds_icon_title, sizeof(*nds_icon_title));
+	return rom;
+}
+
+/**
+ * DSi animated icon: Lazily-decoded frames must match the original
+ * eager decoder for every sequence index, including frames that share
+ * identical bitmap and/or palette slots and frames with flip bits set.
+ */
+TEST_F(IconAnimDataTest, NintendoDS_DSi)
+{
+	NDS_IconTitleData nds_icon_title;
+	memset(&nds_icon_title, 0, sizeof(nds_icon_title));
+	fillRandom(nds_icon_title.icon_data, sizeof(nds_icon_title.icon_data), 0x12345678U);
+	fillRandom(nds_icon_title.icon_pal, sizeof(nds_icon_title.icon_pal), 0x23456789U);
+	fillRandom(nds_icon_title.dsi_icon_data, sizeof(nds_icon_title.dsi_icon_data), 0x3456789AU);
+	fillRandom(nds_icon_title.dsi_icon_pal, sizeof(nds_icon_title.dsi_icon_pal), 0x456789ABU);
+
+	// Bitmap slot 3 is identical to slot 1.
+	// Palette slot 5 is identical to palette slot 2.
+	memcpy(nds_icon_title.dsi_icon_data[3], nds_icon_title.dsi_icon_data[1], sizeof(nds_icon_title.dsi_icon_data[3]));
+	memcpy(nds_icon_title.dsi_icon_pal[5], nds_icon_title.dsi_icon_pal[2], sizeof(nds_icon_title.dsi_icon_pal[5]));
+
+	// Sequence tokens:
+	// - 15:    V flip
+	// - 14:    H flip
+	// - 13-11: Palette index
+	// - 10-8:  Bitmap index
+	// - 7-0:   Frame duration
+	#define SEQ(vflip, hflip, pal, bmp, delay) \
+		static_cast<uint16_t>(((vflip) << 15) | ((hflip) << 14) | ((pal) << 11) | ((bmp) << 8) | (delay))
+	const vector<uint16_t> seq = {
+		SEQ(0, 0, 0, 0, 10),	// frame 0
+		SEQ(0, 0, 2, 1, 12),	// frame 1
+		SEQ(0, 0, 5, 3, 14),	// same data as frame 1
+		SEQ(0, 0, 2, 3, 16),	// same data as frame 1
+		SEQ(0, 1, 0, 0, 18),	// H flip of frame 0
+		SEQ(1, 0, 0, 0, 20),	// V flip of frame 0
+		SEQ(1, 1, 0, 0, 22),	// H+V flip of frame 0
+		SEQ(0, 1, 5, 3, 24),	// H flip of frame 1's data
+		SEQ(0, 1, 2, 1, 26),	// same data as the previous frame
+		SEQ(0, 0, 4, 6, 28),	// unique frame
+		SEQ(0, 0, 0, 0, 30),	// frame 0 again
+		SEQ(1, 0, 7, 7, 32),	// unique frame, V flip
+	};
+	#undef SEQ
+	// Expected number of unique frames.
+	static const int expected_count = 8;
+
+	const vector<uint8_t> rom = createDSiRom(&nds_icon_title, seq);
+	RomData *const romData = createRomData(rom);
+	ASSERT_NE(nullptr, romData) << "Synthetic DSi ROM image was not detected.";
+
+	const IconAnimData *const iconAnimData = romData->iconAnimData();
+	ASSERT_NE(nullptr, iconAnimData);
+	EXPECT_EQ(static_cast<int>(seq.size()), iconAnimData->seq_count);
+	EXPECT_EQ(expected_count, iconAnimData->count);
+
+	// Access the frames in reverse sequence order, so frames
+	// aren't decoded in the same order as the original decoder.
+	for (int i = static_cast<int>(seq.size()) - 1; i >= 0; i--) {
+		ASSERT_LT(iconAnimData->seq_index[i], iconAnimData->count);
+		const uint8_t high_token = (seq[i] >> 8);
+		rp_image *const expected = decodeDSiFrame(&nds_icon_title, high_token);
+		const rp_image *const actual = iconAnimData->frame(iconAnimData->seq_index[i]);
+
+		SCOPED_TRACE(::testing::Message() << "Sequence index " << i);
+		EXPECT_NO_FATAL_FAILURE(compareImages(expected, actual));
+		UNREF(expected);
+
+		// Check the delay.
+		EXPECT_EQ(seq[i] & 0xFF, iconAnimData->delays[i].numer);
+		EXPECT_EQ(60, iconAnimData->delays[i].denom);
+		EXPECT_EQ((seq[i] & 0xFF) * 1000 / 60, iconAnimData->delays[i].ms);
+	}
+
+	// Tokens with identical bitmap, palette, and flip bits
+	// must map to the same frame.
+	EXPECT_EQ(iconAnimData->seq_index[1], iconAnimData->seq_index[2]);
+	EXPECT_EQ(iconAnimData->seq_index[1], iconAnimData->seq_index[3]);
+	EXPECT_EQ(iconAnimData->seq_index[7], iconAnimData->seq_index[8]);
+	EXPECT_EQ(iconAnimData->seq_index[0], iconAnimData->seq_index[10]);
+	// Flip bits must not be merged.
+	EXPECT_NE(iconAnimData->seq_index[0], iconAnimData->seq_index[4]);
+	EXPECT_NE(iconAnimData->seq_index[0], iconAnimData->seq_index[5]);
+	EXPECT_NE(iconAnimData->seq_index[0], iconAnimData->seq_index[6]);
+	EXPECT_NE(iconAnimData->seq_index[4], iconAnimData->seq_index[5]);
+	EXPECT_NE(iconAnimData->seq_index[1], iconAnimData->seq_index[7]);
+
+	romData->unref();
+}
+
+/**
+ * DSi animated icon: Frames must be decoded correctly
+ * if they're accessed from multiple threads at once.
+ */
+TEST_F(IconAnimDataTest, NintendoDS_DSi_threads)
+{
+	NDS_IconTitleData nds_icon_title;
+	memset(&nds_icon_title, 0, sizeof(nds_icon_title));
+	fillRandom(nds_icon_title.dsi_icon_data, sizeof(nds_icon_title.dsi_icon_data), 0x56789ABCU);
+	fillRandom(nds_icon_title.dsi_icon_pal, sizeof(nds_icon_title.dsi_icon_pal), 0x6789ABCDU);
+
+	// One frame for each bitmap/palette combination, up to 64 frames.
+	vector<uint16_t> seq;
+	for (unsigned int i = 0; i < 64; i++) {
+		seq.push_back(static_cast<uint16_t>((i << 8) | 1));
+	}
+
+	const vector<uint8_t> rom = createDSiRom(&nds_icon_title, seq);
+	RomData *const romData = createRomData(rom);
+	ASSERT_NE(nullptr, romData) << "Synthetic DSi ROM image was not detected.";
+	const IconAnimData *const iconAnimData = romData->iconAnimData();
+	ASSERT_NE(nullptr, iconAnimData);
+	ASSERT_EQ(64, iconAnimData->count);
+
+	// Access all frames from several threads at once.
+	// Each thread must get the same rp_image for each frame.
+	static const int thread_count = 4;
+	array<array<const rp_image*, 64>, thread_count> results;
+	vector<std::thread> threads;
+	for (int t = 0; t < thread_count; t++) {
+		threads.emplace_back([iconAnimData, &results, t]() {
+			for (int i = 0; i < 64; i++) {
+				// Use a different order in each thread.
+				const int idx = (i * (t * 2 + 1)) % 64;
+				results[t][idx] = iconAnimData->frame(idx);
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	for (int i = 0; i < 64; i++) {
+		for (int t = 1; t < thread_count; t++) {
+			EXPECT_EQ(results[0][i], results[t][i]) << "Frame " << i << " was decoded more than once.";
+		}
+		rp_image *const expected = decodeDSiFrame(&nds_icon_title, static_cast<uint8_t>(seq[i] >> 8));
+		SCOPED_TRACE(::testing::Message() << "Frame " << i);
+		EXPECT_NO_FATAL_FAILURE(compareImages(expected, results[0][i]));
+		UNREF(expected);
+	}
+
+	romData->unref();
+}
+
+/**
+ * GameCube save file: Lazily-decoded frames must match the original
+ * eager decoder, including frames that alias earlier frames with
+ * identical icon data and blank frames.
+ */
+TEST_F(IconAnimDataTest, GameCubeSave)
+{
+	static const size_t iconsize_RGB = CARD_ICON_W * CARD_ICON_H * 2;
+	static const size_t iconsize_CI8 = CARD_ICON_W * CARD_ICON_H * 1;
+	static const size_t palsize_CI8 = 256 * 2;
+
+	// Icon formats.
+	// Frames 3, 5, and 6 have the same data as frames 0, 2, and 1.
+	static const uint8_t iconfmt[CARD_MAXICONS] = {
+		CARD_ICON_RGB,		// 0
+		CARD_ICON_CI_UNIQUE,	// 1
+		CARD_ICON_CI_SHARED,	// 2
+		CARD_ICON_RGB,		// 3: same as 0
+		CARD_ICON_NONE,		// 4: blank frame
+		CARD_ICON_CI_SHARED,	// 5: same as 2
+		CARD_ICON_CI_UNIQUE,	// 6: same as 1
+		CARD_ICON_RGB,		// 7
+	};
+	static const int8_t alias_of[CARD_MAXICONS] = {-1, -1, -1, 0, -1, 2, 1, -1};
+
+	// Generate the icon data.
+	vector<uint8_t> icondata;
+	array<size_t, CARD_MAXICONS> offset;
+	for (int i = 0; i < CARD_MAXICONS; i++) {
+		offset[i] = icondata.size();
+		size_t size = 0;
+		switch (iconfmt[i]) {
+			case CARD_ICON_RGB:
+				size = iconsize_RGB;
+				break;
+			case CARD_ICON_CI_UNIQUE:
+				size = iconsize_CI8 + palsize_CI8;
+				break;
+			case CARD_ICON_CI_SHARED:
+				size = iconsize_CI8;
+				break;
+			default:
+				break;
+		}
+		icondata.resize(offset[i] + size);
+		if (size == 0)
+			continue;
+		if (alias_of[i] >= 0) {
+			memcpy(&icondata[offset[i]], &icondata[offset[alias_of[i]]], size);
+		} else {
+			fillRandom(&icondata[offset[i]], size, 0x789ABCDEU + i);
+		}
+	}
+	// Shared CI8 palette is located after all of the icons.
+	const size_t pal_CI8_shared_offset = icondata.size();
+	icondata.resize(icondata.size() + palsize_CI8);
+	fillRandom(&icondata[pal_CI8_shared_offset], palsize_CI8, 0x89ABCDEFU);
+
+	// GCI file: 64-byte directory entry, plus a multiple of 8 KB.
+	const size_t data_size = ((icondata.size() + 8191) / 8192) * 8192;
+	vector<uint8_t> gci(sizeof(card_direntry) + data_size);
+	card_direntry *const direntry = reinterpret_cast<card_direntry*>(gci.data());
+	memset(direntry, 0, sizeof(*direntry));
+	memcpy(direntry->id6, "GTSE01", 6);
+	direntry->pad_00 = 0xFF;
+	direntry->bannerfmt = CARD_BANNER_NONE | CARD_ANIM_BOUNCE;
+	memcpy(direntry->filename, "icontest", 8);
+	direntry->iconaddr = cpu_to_be32(0);
+	uint16_t fmt = 0, speed = 0;
+	for (int i = CARD_MAXICONS - 1; i >= 0; i--) {
+		fmt = (fmt << 2) | iconfmt[i];
+		speed = (speed << 2) | ((i % 3) + 1);
+	}
+	direntry->iconfmt = cpu_to_be16(fmt);
+	direntry->iconspeed = cpu_to_be16(speed);
+	direntry->length = cpu_to_be16(static_cast<uint16_t>(data_size / 8192));
+	direntry->pad_01 = cpu_to_be16(0xFFFF);
+	direntry->commentaddr = cpu_to_be32(static_cast<uint32_t>(data_size - 64));
+	memcpy(&gci[sizeof(card_direntry)], icondata.data(), icondata.size());
+
+	RomData *const romData = createRomData(gci);
+	ASSERT_NE(nullptr, romData) << "Synthetic GCI file was not detected.";
+	const IconAnimData *const iconAnimData = romData->iconAnimData();
+	ASSERT_NE(nullptr, iconAnimData);
+	ASSERT_EQ(CARD_MAXICONS, iconAnimData->count);
+
+	// Bounce animation: 0-7, then 6-1.
+	ASSERT_EQ(CARD_MAXICONS + (CARD_MAXICONS - 2), iconAnimData->seq_count);
+	for (int i = 0; i < iconAnimData->seq_count; i++) {
+		const int expected_idx = (i < CARD_MAXICONS) ? i : (CARD_MAXICONS - 2) - (i - CARD_MAXICONS);
+		EXPECT_EQ(expected_idx, iconAnimData->seq_index[i]) << "Sequence index " << i;
+	}
+
+	// Access the alias frames before the frames they alias.
+	static const int access_order[CARD_MAXICONS] = {6, 3, 5, 4, 7, 2, 1, 0};
+	const uint16_t *const pal_CI8_shared = reinterpret_cast<const uint16_t*>(&icondata[pal_CI8_shared_offset]);
+	for (const int i : access_order) {
+		SCOPED_TRACE(::testing::Message() << "Frame " << i);
+		const rp_image *const actual = iconAnimData->frame(i);
+
+		// Original eager decoder.
+		const uint8_t *const pIcon = &icondata[offset[i]];
+		rp_image *expected = nullptr;
+		switch (iconfmt[i]) {
+			case CARD_ICON_RGB:
+				expected = ImageDecoder::fromGcn16(
+					ImageDecoder::PixelFormat::RGB5A3, CARD_ICON_W, CARD_ICON_H,
+					reinterpret_cast<const uint16_t*>(pIcon), iconsize_RGB);
+				break;
+			case CARD_ICON_CI_UNIQUE:
+				expected = ImageDecoder::fromGcnCI8(CARD_ICON_W, CARD_ICON_H,
+					pIcon, iconsize_CI8,
+					reinterpret_cast<const uint16_t*>(pIcon + iconsize_CI8), palsize_CI8);
+				break;
+			case CARD_ICON_CI_SHARED:
+				expected = ImageDecoder::fromGcnCI8(CARD_ICON_W, CARD_ICON_H,
+					pIcon, iconsize_CI8, pal_CI8_shared, palsize_CI8);
+				break;
+			default:
+				break;
+		}
+
+		if (!expected) {
+			// Blank frame.
+			EXPECT_EQ(nullptr, actual);
+			continue;
+		}
+		EXPECT_NO_FATAL_FAILURE(compareImages(expected, actual));
+		expected->unref();
+	}
+
+	// Alias frames share the same rp_image.
+	for (int i = 0; i < CARD_MAXICONS; i++) {
+		if (alias_of[i] >= 0) {
+			EXPECT_EQ(iconAnimData->frame(alias_of[i]), iconAnimData->frame(i)) << "Frame " << i;
+		}
+	}
+
+	// Delays. (CARD_SPEED_FAST is 125 ms)
+	for (int i = 0; i < CARD_MAXICONS; i++) {
+		const unsigned int delay = (i % 3) + 1;
+		EXPECT_EQ(delay, iconAnimData->delays[i].numer);
+		EXPECT_EQ(8, iconAnimData->delays[i].denom);
+		EXPECT_EQ(static_cast<int>(delay * 125), iconAnimData->delays[i].ms);
+	}
+
+	romData->unref();
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRomData test suite: IconAnimData tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
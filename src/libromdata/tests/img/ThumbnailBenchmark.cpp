@@ -0,0 +1,806 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * ThumbnailBenchmark.cpp: Thumbnail pipeline benchmark.                   *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+/**
+ * This program runs the full TCreateThumbnail::getThumbnail() path
+ * over a set of files at one or more requested thumbnail sizes, and
+ * prints per-stage latency percentiles and the RSS growth per run.
+ *
+ * Stages:
+ * - open: Opening the source file.
+ * - detect: RomDataFactory::create().
+ * - int_image: Loading an internal image. (usually decoding a texture)
+ * - ext_image: Looking up and loading an external image from the cache.
+ * - convert: rp_image to ImgClass conversion.
+ * - rescale: All rescaling operations for a thumbnail.
+ * - png: Encoding the thumbnail as PNG. (in memory)
+ * - total: Everything above.
+ *
+ * int_image and ext_image are measured as the time spent in
+ * getThumbnail() minus convert and rescale. If any external
+ * image was checked, the time is counted as ext_image.
+ *
+ * By default, ImgClass is an ARGB32 rp_image, so convert and rescale
+ * use portable C++ code instead of the frontends' toolkits.
+ *
+ * If THUMBNAILBENCHMARK_CAIRO is defined, ImgClass is cairo_surface_t,
+ * and the conversion and rescaling functions are the same ones used
+ * by the GTK3 frontend.
+ */
+
+#include "common.h"
+#include "dll-macros.h"
+
+// libromdata
+#include "libromdata/img/TCreateThumbnail.cpp"
+
+// librpbase, librpfile
+#include "librpbase/img/RpPngWriter.hpp"
+#include "librpfile/VectorFile.hpp"
+
+#ifdef THUMBNAILBENCHMARK_CAIRO
+// GTK3 frontend: Cairo image conversion and rescaling
+#  include "gtk/gtk3/CairoImageConv.hpp"
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+
+// C includes.
+#include <stdlib.h>
+#ifdef _WIN32
+#  include "libwin32common/RpWin32_sdk.h"
+#  include <psapi.h>
+#else /* !_WIN32 */
+#  include <sys/resource.h>
+#  include <unistd.h>
+#endif /* _WIN32 */
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+#ifdef THUMBNAILBENCHMARK_CAIRO
+#  include <memory>
+using std::unique_ptr;
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+
+namespace LibRomData { namespace Tests {
+
+typedef std::chrono::steady_clock clk;
+
+/**
+ * Get the elapsed time since the specified time point.
+ * @param start Start time
+ * @return Elapsed time, in microseconds
+ */
+static inline double elapsed_us(clk::time_point start)
+{
+	return std::chrono::duration<double, std::micro>(clk::now() - start).count();
+}
+
+#ifdef THUMBNAILBENCHMARK_CAIRO
+typedef cairo_surface_t *ImgClass;
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+typedef rp_image *ImgClass;
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+
+/**
+ * TCreateThumbnail instantiation for benchmarking.
+ * Time spent in conversion and rescaling is recorded.
+ */
+class BenchCreateThumbnail : public TCreateThumbnail<ImgClass>
+{
+	public:
+		BenchCreateThumbnail()
+			: conv_us(0)
+			, rescale_us(0)
+			, checkedExternal(false)
+		{ }
+
+	private:
+		typedef TCreateThumbnail<ImgClass> super;
+		RP_DISABLE_COPY(BenchCreateThumbnail)
+
+	public:
+		/**
+		 * Reset the per-thumbnail timings.
+		 */
+		void resetTimings(void)
+		{
+			conv_us = 0;
+			rescale_us = 0;
+			checkedExternal = false;
+		}
+
+	public:
+		// Per-thumbnail timings (microseconds)
+		mutable double conv_us;
+		mutable double rescale_us;
+		// Was an external image checked?
+		mutable bool checkedExternal;
+
+	protected:
+		/** TCreateThumbnail functions. **/
+
+		/**
+		 * Wrapper function to convert rp_image* to ImgClass.
+		 * @param img rp_image
+		 * @return ImgClass
+		 */
+		ImgClass rpImageToImgClass(const rp_image *img) const final
+		{
+			const clk::time_point start = clk::now();
+#ifdef THUMBNAILBENCHMARK_CAIRO
+			// NOTE: Same as the GTK3 frontend. The image isn't
+			// premultiplied, since it's going directly to PNG.
+			cairo_surface_t *const ret = CairoImageConv::rp_image_to_cairo_surface_t(img, false);
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+			// Frontends convert the image to a toolkit-specific image,
+			// which usually requires a copy.
+			rp_image *const ret = img->dup_ARGB32();
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+			conv_us += elapsed_us(start);
+			return ret;
+		}
+
+		/**
+		 * Wrapper function to check if an ImgClass is valid.
+		 * @param imgClass ImgClass
+		 * @return True if valid; false if not.
+		 */
+		bool isImgClassValid(const ImgClass &imgClass) const final
+		{
+#ifdef THUMBNAILBENCHMARK_CAIRO
+			return (imgClass != nullptr);
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+			return (imgClass != nullptr && imgClass->isValid());
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+		}
+
+		/**
+		 * Wrapper function to get a "null" ImgClass.
+		 * @return "Null" ImgClass.
+		 */
+		ImgClass getNullImgClass(void) const final
+		{
+			return nullptr;
+		}
+
+		/**
+		 * Free an ImgClass object.
+		 * @param imgClass ImgClass object.
+		 */
+		void freeImgClass(ImgClass &imgClass) const final
+		{
+#ifdef THUMBNAILBENCHMARK_CAIRO
+			if (imgClass) {
+				cairo_surface_destroy(imgClass);
+				imgClass = nullptr;
+			}
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+			UNREF_AND_NULL(imgClass);
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+		}
+
+		/**
+		 * Rescale an ImgClass using the specified scaling method.
+		 * @param imgClass ImgClass object.
+		 * @param sz New size.
+		 * @param method Scaling method.
+		 * @return Rescaled ImgClass.
+		 */
+		ImgClass rescaleImgClass(const ImgClass &imgClass, ImgSize sz, ScalingMethod method) const final
+		{
+			const clk::time_point start = clk::now();
+#ifdef THUMBNAILBENCHMARK_CAIRO
+			cairo_surface_t *const ret = CairoImageConv::scale(imgClass,
+				sz.width, sz.height, (method == ScalingMethod::Bilinear));
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+			rp_image *const ret = (method == ScalingMethod::Bilinear)
+				? rescale_bilinear(imgClass, sz)
+				: rescale_nearest(imgClass, sz);
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+			rescale_us += elapsed_us(start);
+			return ret;
+		}
+
+		/**
+		 * Get the size of the specified ImgClass.
+		 * @param imgClass	[in] ImgClass object.
+		 * @param pOutSize	[out] Pointer to ImgSize to store the image size.
+		 * @return 0 on success; non-zero on error.
+		 */
+		int getImgClassSize(const ImgClass &imgClass, ImgSize *pOutSize) const final
+		{
+#ifdef THUMBNAILBENCHMARK_CAIRO
+			pOutSize->width = cairo_image_surface_get_width(imgClass);
+			pOutSize->height = cairo_image_surface_get_height(imgClass);
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+			pOutSize->width = imgClass->width();
+			pOutSize->height = imgClass->height();
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+			return 0;
+		}
+
+		/**
+		 * Get the proxy for the specified URL.
+		 * @param url URL
+		 * @return Proxy, or empty string if no proxy is needed.
+		 */
+		string proxyForUrl(const char *url) const final
+		{
+			// This is called before each external image lookup.
+			RP_UNUSED(url);
+			checkedExternal = true;
+			return string();
+		}
+
+#ifndef THUMBNAILBENCHMARK_CAIRO
+	private:
+		/**
+		 * Rescale an ARGB32 image using nearest-neighbor scaling.
+		 * @param img ARGB32 image
+		 * @param sz New size
+		 * @return Rescaled image
+		 */
+		static rp_image *rescale_nearest(const rp_image *img, ImgSize sz)
+		{
+			rp_image *const ret = new rp_image(sz.width, sz.height, rp_image::Format::ARGB32);
+			const int src_width = img->width();
+			const int src_height = img->height();
+			const int src_stride_px = img->stride() / sizeof(uint32_t);
+			const uint32_t *const src = static_cast<const uint32_t*>(img->bits());
+			uint32_t *dest = static_cast<uint32_t*>(ret->bits());
+			const int dest_stride_px = ret->stride() / sizeof(uint32_t);
+
+			for (int y = 0; y < sz.height; y++, dest += dest_stride_px) {
+				const uint32_t *const src_line = &src[(y * src_height / sz.height) * src_stride_px];
+				for (int x = 0; x < sz.width; x++) {
+					dest[x] = src_line[x * src_width / sz.width];
+				}
+			}
+			return ret;
+		}
+
+		/**
+		 * Rescale an ARGB32 image using bilinear scaling.
+		 * @param img ARGB32 image
+		 * @param sz New size
+		 * @return Rescaled image
+		 */
+		static rp_image *rescale_bilinear(const rp_image *img, ImgSize sz)
+		{
+			rp_image *const ret = new rp_image(sz.width, sz.height, rp_image::Format::ARGB32);
+			const int src_width = img->width();
+			const int src_height = img->height();
+			const int src_stride_px = img->stride() / sizeof(uint32_t);
+			const uint8_t *const src = static_cast<const uint8_t*>(img->bits());
+			uint8_t *dest = static_cast<uint8_t*>(ret->bits());
+
+			// Source coordinates are in 16.16 fixed-point, using pixel centers.
+			auto src_coord = [](int d, int src_sz, int dest_sz) -> int {
+				const int64_t c = ((((int64_t)d * 2) + 1) * src_sz * 65536) / (dest_sz * 2) - 32768;
+				return (c < 0) ? 0 : static_cast<int>(c);
+			};
+
+			for (int y = 0; y < sz.height; y++, dest += ret->stride()) {
+				const int fy = src_coord(y, src_height, sz.height);
+				const int y0 = std::min(fy >> 16, src_height - 1);
+				const int y1 = std::min(y0 + 1, src_height - 1);
+				const unsigned int wy = (fy >> 8) & 0xFF;
+				const uint8_t *const line0 = &src[y0 * src_stride_px * sizeof(uint32_t)];
+				const uint8_t *const line1 = &src[y1 * src_stride_px * sizeof(uint32_t)];
+
+				uint8_t *px_dest = dest;
+				for (int x = 0; x < sz.width; x++, px_dest += 4) {
+					const int fx = src_coord(x, src_width, sz.width);
+					const int x0 = std::min(fx >> 16, src_width - 1);
+					const int x1 = std::min(x0 + 1, src_width - 1);
+					const unsigned int wx = (fx >> 8) & 0xFF;
+
+					for (int c = 0; c < 4; c++) {
+						const unsigned int top = (line0[x0*4+c] * (256 - wx)) + (line0[x1*4+c] * wx);
+						const unsigned int bot = (line1[x0*4+c] * (256 - wx)) + (line1[x1*4+c] * wx);
+						px_dest[c] = static_cast<uint8_t>(((top * (256 - wy)) + (bot * wy)) >> 16);
+					}
+				}
+			}
+			return ret;
+		}
+#endif /* !THUMBNAILBENCHMARK_CAIRO */
+};
+
+/**
+ * Stages
+ */
+enum Stage {
+	STAGE_OPEN,
+	STAGE_DETECT,
+	STAGE_INT_IMAGE,
+	STAGE_EXT_IMAGE,
+	STAGE_CONVERT,
+	STAGE_RESCALE,
+	STAGE_PNG,
+	STAGE_TOTAL,
+
+	STAGE_MAX
+};
+
+static const char *const stage_names[STAGE_MAX] = {
+	"open", "detect", "int_image", "ext_image",
+	"convert", "rescale", "png", "total",
+};
+
+/**
+ * Results for a single requested thumbnail size.
+ */
+struct SizeResults {
+	vector<double> samples[STAGE_MAX];	// microseconds
+	vector<double> rss_growth;		// bytes
+	unsigned int thumbnails;
+	unsigned int cannot_open;
+	unsigned int not_supported;
+	unsigned int no_image;
+	unsigned int png_failed;
+
+	SizeResults()
+		: thumbnails(0)
+		, cannot_open(0)
+		, not_supported(0)
+		, no_image(0)
+		, png_failed(0)
+	{ }
+};
+
+#ifdef THUMBNAILBENCHMARK_CAIRO
+/**
+ * Encode an image as PNG in memory.
+ * NOTE: Same RpPngWriter usage as the GTK3 frontend.
+ * @param surface cairo_surface_t
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int encode_png(cairo_surface_t *surface)
+{
+	const int width = cairo_image_surface_get_width(surface);
+	const int height = cairo_image_surface_get_height(surface);
+	const int stride = cairo_image_surface_get_stride(surface);
+	const uint8_t *pixels = cairo_image_surface_get_data(surface);
+
+	VectorFile *const vf = new VectorFile();
+	int ret;
+	{
+		RpPngWriter pngWriter(vf, width, height, rp_image::Format::ARGB32);
+		if (pngWriter.isOpen()) {
+			ret = pngWriter.write_IHDR();
+			if (ret == 0) {
+				unique_ptr<const uint8_t*[]> row_pointers(new const uint8_t*[height]);
+				for (int y = 0; y < height; y++, pixels += stride) {
+					row_pointers[y] = pixels;
+				}
+				ret = pngWriter.write_IDAT(row_pointers.get(), false);
+			}
+		} else {
+			ret = -pngWriter.lastError();
+		}
+	}
+	vf->unref();
+	return ret;
+}
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+/**
+ * Encode an image as PNG in memory.
+ * @param img rp_image
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int encode_png(const rp_image *img)
+{
+	VectorFile *const vf = new VectorFile();
+	int ret;
+	{
+		RpPngWriter pngWriter(vf, img);
+		if (pngWriter.isOpen()) {
+			ret = pngWriter.write_IHDR();
+			if (ret == 0) {
+				ret = pngWriter.write_IDAT();
+			}
+		} else {
+			ret = -pngWriter.lastError();
+		}
+	}
+	vf->unref();
+	return ret;
+}
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+
+/**
+ * Get the current resident set size of this process.
+ * @return Current RSS, in bytes, or -1 on error.
+ */
+static int64_t get_current_rss(void)
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+		return -1;
+	}
+	return static_cast<int64_t>(pmc.WorkingSetSize);
+#elif defined(__linux__)
+	FILE *const f = fopen("/proc/self/statm", "r");
+	if (!f) {
+		return -1;
+	}
+	long pages_total, pages_resident;
+	const int ret = fscanf(f, "%ld %ld", &pages_total, &pages_resident);
+	fclose(f);
+	if (ret != 2) {
+		return -1;
+	}
+	return static_cast<int64_t>(pages_resident) * sysconf(_SC_PAGESIZE);
+#else
+	// Not supported on this system.
+	return -1;
+#endif
+}
+
+#ifdef __linux__
+/**
+ * Reset the peak resident set size of this process.
+ * Requires Linux 4.0 or later.
+ * @return True on success; false on error.
+ */
+static bool reset_peak_rss(void)
+{
+	FILE *const f = fopen("/proc/self/clear_refs", "w");
+	if (!f) {
+		return false;
+	}
+	const bool ok = (fputs("5", f) >= 0);
+	return (fclose(f) == 0 && ok);
+}
+
+/**
+ * Get the peak resident set size of this process since the last reset_peak_rss().
+ * @return Peak RSS, in bytes, or -1 on error.
+ */
+static int64_t get_reset_peak_rss(void)
+{
+	FILE *const f = fopen("/proc/self/status", "r");
+	if (!f) {
+		return -1;
+	}
+	int64_t ret = -1;
+	char line[128];
+	while (fgets(line, sizeof(line), f)) {
+		long long kb;
+		if (sscanf(line, "VmHWM: %lld kB", &kb) == 1) {
+			ret = static_cast<int64_t>(kb) * 1024;
+			break;
+		}
+	}
+	fclose(f);
+	return ret;
+}
+#endif /* __linux__ */
+
+/**
+ * Run the thumbnail pipeline for a single file.
+ * @param bench		[in] BenchCreateThumbnail
+ * @param filename	[in] Filename
+ * @param reqSize	[in] Requested thumbnail size
+ * @param results	[in/out] Results
+ */
+static void run_one(BenchCreateThumbnail &bench, const char *filename, int reqSize, SizeResults &results)
+{
+	double t[STAGE_MAX] = {0};
+
+	// RSS growth is measured from the start of this run.
+	// On Linux, the peak RSS is reset so the peak during this
+	// run can be measured. Otherwise, the RSS after the run is used.
+	const int64_t rss_start = get_current_rss();
+#ifdef __linux__
+	const bool peak_reset = (rss_start >= 0 && reset_peak_rss());
+#endif /* __linux__ */
+
+	const clk::time_point start = clk::now();
+
+	// Open the file.
+	// NOTE: Same flags as TCreateThumbnail::getThumbnail(const char*).
+	clk::time_point ts = clk::now();
+	RpFile *const file = new RpFile(filename, RpFile::FM_OPEN_READ_GZ);
+	t[STAGE_OPEN] = elapsed_us(ts);
+	if (!file->isOpen()) {
+		file->unref();
+		results.cannot_open++;
+		return;
+	}
+
+	// Detect the file type.
+	// NOTE: Not using createCached() here, since that would
+	// skip detection and image decoding after the first pass.
+	ts = clk::now();
+	RomData *const romData = RomDataFactory::create(file, RomDataFactory::RDA_HAS_THUMBNAIL);
+	t[STAGE_DETECT] = elapsed_us(ts);
+	file->unref();
+	if (!romData) {
+		results.not_supported++;
+		return;
+	}
+
+	// Get the thumbnail.
+	BenchCreateThumbnail::GetThumbnailOutParams_t outParams;
+	bench.resetTimings();
+	ts = clk::now();
+	int ret = bench.getThumbnail(romData, reqSize, &outParams);
+	const double getThumbnail_us = elapsed_us(ts);
+	romData->unref();
+	if (ret != 0 || !outParams.retImg) {
+		results.no_image++;
+		return;
+	}
+	const double img_us = std::max(0.0, getThumbnail_us - bench.conv_us - bench.rescale_us);
+	t[bench.checkedExternal ? STAGE_EXT_IMAGE : STAGE_INT_IMAGE] = img_us;
+	t[STAGE_CONVERT] = bench.conv_us;
+	t[STAGE_RESCALE] = bench.rescale_us;
+
+	// Encode the thumbnail as PNG.
+	ts = clk::now();
+	ret = encode_png(outParams.retImg);
+	t[STAGE_PNG] = elapsed_us(ts);
+#ifdef THUMBNAILBENCHMARK_CAIRO
+	cairo_surface_destroy(outParams.retImg);
+#else /* !THUMBNAILBENCHMARK_CAIRO */
+	outParams.retImg->unref();
+#endif /* THUMBNAILBENCHMARK_CAIRO */
+	if (ret != 0) {
+		results.png_failed++;
+		return;
+	}
+	t[STAGE_TOTAL] = elapsed_us(start);
+
+	// Get the RSS growth.
+	if (rss_start >= 0) {
+#ifdef __linux__
+		const int64_t rss_end = (peak_reset ? get_reset_peak_rss() : get_current_rss());
+#else /* !__linux__ */
+		const int64_t rss_end = get_current_rss();
+#endif /* __linux__ */
+		if (rss_end >= 0) {
+			results.rss_growth.push_back(static_cast<double>(rss_end - rss_start));
+		}
+	}
+
+	// Save the samples.
+	results.thumbnails++;
+	for (int i = 0; i < STAGE_MAX; i++) {
+		if (i == STAGE_INT_IMAGE || i == STAGE_EXT_IMAGE || i == STAGE_RESCALE) {
+			// Only count these stages if they were used.
+			if (t[i] <= 0)
+				continue;
+		}
+		results.samples[i].push_back(t[i]);
+	}
+}
+
+/**
+ * Get a percentile from a sorted vector of samples.
+ * Uses the nearest-rank method.
+ * @param sorted Sorted samples (must not be empty)
+ * @param pct Percentile (0-100)
+ * @return Sample value
+ */
+static double percentile(const vector<double> &sorted, unsigned int pct)
+{
+	size_t rank = (sorted.size() * pct + 99) / 100;
+	if (rank == 0) {
+		rank = 1;
+	}
+	return sorted[rank - 1];
+}
+
+/**
+ * Get the peak resident set size of this process.
+ * NOTE: This covers the entire run, not just a single thumbnail.
+ * @return Peak RSS, in bytes, or -1 on error.
+ */
+static int64_t get_peak_rss(void)
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+		return -1;
+	}
+	return static_cast<int64_t>(pmc.PeakWorkingSetSize);
+#else /* !_WIN32 */
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) != 0) {
+		return -1;
+	}
+#  ifdef __APPLE__
+	// macOS reports ru_maxrss in bytes.
+	return static_cast<int64_t>(ru.ru_maxrss);
+#  else /* !__APPLE__ */
+	// Other systems report ru_maxrss in KiB.
+	return static_cast<int64_t>(ru.ru_maxrss) * 1024;
+#  endif /* __APPLE__ */
+#endif /* _WIN32 */
+}
+
+/**
+ * Print the results for a single requested thumbnail size.
+ * @param reqSize Requested thumbnail size
+ * @param results Results (samples will be sorted)
+ */
+static void print_results(int reqSize, SizeResults &results)
+{
+	printf("reqSize %d: %u thumbnail(s)", reqSize, results.thumbnails);
+	if (results.cannot_open > 0) {
+		printf(", %u could not be opened", results.cannot_open);
+	}
+	if (results.not_supported > 0) {
+		printf(", %u not supported", results.not_supported);
+	}
+	if (results.no_image > 0) {
+		printf(", %u with no image", results.no_image);
+	}
+	if (results.png_failed > 0) {
+		printf(", %u PNG encode failure(s)", results.png_failed);
+	}
+	putchar('\n');
+
+	if (results.thumbnails > 0) {
+		printf("  %-10s %8s %10s %10s %10s %10s  (ms)\n", "stage", "count", "p50", "p90", "p99", "max");
+		for (int i = 0; i < STAGE_MAX; i++) {
+			vector<double> &samples = results.samples[i];
+			if (samples.empty())
+				continue;
+			std::sort(samples.begin(), samples.end());
+			printf("  %-10s %8zu %10.3f %10.3f %10.3f %10.3f\n", stage_names[i], samples.size(),
+				percentile(samples, 50) / 1000.0,
+				percentile(samples, 90) / 1000.0,
+				percentile(samples, 99) / 1000.0,
+				samples.back() / 1000.0);
+		}
+	}
+
+	vector<double> &rss_growth = results.rss_growth;
+	if (!rss_growth.empty()) {
+		std::sort(rss_growth.begin(), rss_growth.end());
+		printf("  %-10s %8zu %10.1f %10.1f %10.1f %10.1f  (KiB)\n", "rss_growth", rss_growth.size(),
+			percentile(rss_growth, 50) / 1024.0,
+			percentile(rss_growth, 90) / 1024.0,
+			percentile(rss_growth, 99) / 1024.0,
+			rss_growth.back() / 1024.0);
+	}
+	putchar('\n');
+	fflush(stdout);
+}
+
+/**
+ * Print the program syntax.
+ * @param argv0 argv[0]
+ */
+static void print_syntax(const char *argv0)
+{
+	fprintf(stderr,
+		"Syntax: %s [-s sizes] [-n iterations] [-l listfile] [files...]\n"
+		"  -s sizes       Comma-separated list of requested thumbnail sizes. (default is 96,128,256,512)\n"
+		"  -n iterations  Number of times to process each file at each size. (default is 1)\n"
+		"  -l listfile    Read filenames from listfile, one per line.\n", argv0);
+}
+
+} }
+
+using namespace LibRomData::Tests;
+
+int RP_C_API main(int argc, char *argv[])
+{
+	vector<int> reqSizes;
+	unsigned int iterations = 1;
+	vector<string> filenames;
+
+	for (int i = 1; i < argc; i++) {
+		const char *const arg = argv[i];
+		if (arg[0] != '-' || arg[1] == '\0') {
+			filenames.emplace_back(arg);
+			continue;
+		}
+		if (arg[2] != '\0' || i + 1 >= argc) {
+			print_syntax(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		const char *const param = argv[++i];
+		switch (arg[1]) {
+			case 's': {
+				const char *p = param;
+				while (*p != '\0') {
+					char *endptr = nullptr;
+					const long sz = strtol(p, &endptr, 10);
+					if (endptr == p || sz <= 0 || sz > 32768 || (*endptr != ',' && *endptr != '\0')) {
+						fprintf(stderr, "*** ERROR: Invalid thumbnail size list '%s'.\n", param);
+						return EXIT_FAILURE;
+					}
+					reqSizes.push_back(static_cast<int>(sz));
+					p = (*endptr == ',') ? endptr + 1 : endptr;
+				}
+				break;
+			}
+
+			case 'n': {
+				char *endptr = nullptr;
+				const long n = strtol(param, &endptr, 10);
+				if (*endptr != '\0' || n <= 0) {
+					fprintf(stderr, "*** ERROR: Invalid iteration count '%s'.\n", param);
+					return EXIT_FAILURE;
+				}
+				iterations = static_cast<unsigned int>(n);
+				break;
+			}
+
+			case 'l': {
+				std::ifstream list(param);
+				if (!list.is_open()) {
+					fprintf(stderr, "*** ERROR: Could not open list file '%s': %s\n", param, strerror(errno));
+					return EXIT_FAILURE;
+				}
+				string line;
+				while (std::getline(list, line)) {
+					// Remove the trailing CR, if present.
+					if (!line.empty() && line.back() == '\r') {
+						line.pop_back();
+					}
+					if (!line.empty()) {
+						filenames.emplace_back(std::move(line));
+					}
+				}
+				break;
+			}
+
+			default:
+				print_syntax(argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (filenames.empty()) {
+		print_syntax(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (reqSizes.empty()) {
+		reqSizes = {96, 128, 256, 512};
+	}
+
+	printf("Thumbnail pipeline benchmark: %zu file(s), %u iteration(s)\n\n",
+		filenames.size(), iterations);
+	fflush(stdout);
+
+	BenchCreateThumbnail bench;
+	for (const int reqSize : reqSizes) {
+		SizeResults results;
+		for (unsigned int n = iterations; n > 0; n--) {
+			for (const string &filename : filenames) {
+				run_one(bench, filename.c_str(), reqSize, results);
+			}
+		}
+		print_results(reqSize, results);
+	}
+
+	const int64_t peak_rss = get_peak_rss();
+	if (peak_rss >= 0) {
+		printf("Process peak RSS: %.1f MiB\n", peak_rss / (1024.0 * 1024.0));
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * DatFileTest.cpp: DatFile test.                                          *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpbase
+#include "librpbase/crypto/MultiHash.hpp"
+using LibRpBase::MultiHash;
+
+// libromdata
+#include "libromdata/utils/DatFile.hpp"
+
+// C includes
+#include <unistd.h>
+
+// C includes (C++ namespace)
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// C++ includes
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+// Temporary directory. (set by gtest_main())
+static string tmpdir;
+
+// ROM data used for the DAT entries.
+static const char rom1_data[] = "The quick brown fox jumps over the lazy dog.";
+static const char rom2_data[] = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.";
+
+class DatFileTest : public ::testing::Test
+{
+	protected:
+		void TearDown(void) override
+		{
+			for (const string &filename : m_files) {
+				unlink(filename.c_str());
+			}
+		}
+
+		/**
+		 * Write a temporary DAT file.
+		 * @param name Filename, relative to the temporary directory
+		 * @param contents File contents
+		 * @return Full filename
+		 */
+		string writeDat(const char *name, const char *contents)
+		{
+			const string filename = tmpdir + '/' + name;
+			FILE *const f = fopen(filename.c_str(), "wb");
+			EXPECT_NE(nullptr, f);
+			if (f) {
+				fwrite(contents, 1, strlen(contents), f);
+				fclose(f);
+			}
+			m_files.push_back(filename);
+			return filename;
+		}
+
+		/**
+		 * Hash a string.
+		 * @param hash MultiHash
+		 * @param str String
+		 */
+		static void hashString(MultiHash &hash, const char *str)
+		{
+			hash.update(str, strlen(str));
+			hash.finalize();
+		}
+
+	private:
+		vector<string> m_files;
+};
+
+/**
+ * Load a DAT file and look up entries.
+ */
+TEST_F(DatFileTest, findTest)
+{
+	const string filename = writeDat("test.dat",
+		"<?xml version=\"1.0\"?>\n"
+		"<datafile>\n"
+		"\t<header><name>Test</name></header>\n"
+		"\t<game name=\"Game 1\">\n"
+		"\t\t<rom name=\"game1.bin\" size=\"44\" crc=\"519025e9\" md5=\"e4d909c290d0fb1ca068ffaddf22cbd0\" sha1=\"408d94384216f890ff7a0c3528e8bed1e0b01621\"/>\n"
+		"\t</game>\n"
+		"\t<machine name=\"Game 2\">\n"
+		"\t\t<rom name=\"game2.bin\" size=\"123\" crc=\"474B756F\"/>\n"
+		"\t\t<rom name=\"nocrc.bin\" size=\"1\"/>\n"
+		"\t</machine>\n"
+		"</datafile>\n");
+
+	DatFile datFile;
+	EXPECT_EQ(2, datFile.load(filename.c_str()));
+	EXPECT_EQ(2U, datFile.count());
+
+	MultiHash hash1;
+	hashString(hash1, rom1_data);
+	const DatFile::RomEntry *entry = datFile.find(hash1);
+	ASSERT_NE(nullptr, entry);
+	EXPECT_EQ(string("Game 1"), entry->game);
+	EXPECT_EQ(string("game1.bin"), entry->name);
+	EXPECT_EQ(44U, entry->size);
+	EXPECT_TRUE(entry->has_md5);
+	EXPECT_TRUE(entry->has_sha1);
+
+	// Uppercase CRC32, no MD5 or SHA-1.
+	MultiHash hash2;
+	hashString(hash2, rom2_data);
+	entry = datFile.find(hash2);
+	ASSERT_NE(nullptr, entry);
+	EXPECT_EQ(string("Game 2"), entry->game);
+	EXPECT_EQ(string("game2.bin"), entry->name);
+	EXPECT_FALSE(entry->has_md5);
+	EXPECT_FALSE(entry->has_sha1);
+
+	// Not in the DAT.
+	MultiHash hash3;
+	hashString(hash3, "Not in the DAT file.");
+	EXPECT_EQ(nullptr, datFile.find(hash3));
+}
+
+/**
+ * Entries with a matching CRC32 are verified using the size, MD5, and SHA-1.
+ */
+TEST_F(DatFileTest, verifyTest)
+{
+	const string filename = writeDat("verify.dat",
+		"<?xml version=\"1.0\"?>\n"
+		"<datafile>\n"
+		"\t<game name=\"Wrong size\">\n"
+		"\t\t<rom name=\"a.bin\" size=\"45\" crc=\"519025e9\"/>\n"
+		"\t</game>\n"
+		"\t<game name=\"Wrong SHA-1\">\n"
+		"\t\t<rom name=\"b.bin\" size=\"44\" crc=\"519025e9\" sha1=\"0000000000000000000000000000000000000000\"/>\n"
+		"\t</game>\n"
+		"</datafile>\n");
+
+	DatFile datFile;
+	EXPECT_EQ(2, datFile.load(filename.c_str()));
+
+	MultiHash hash;
+	hashString(hash, rom1_data);
+	const DatFile::RomEntry *const entry = datFile.find(hash);
+	if (hash.sha1()) {
+		// SHA-1 is available, so neither entry matches.
+		EXPECT_EQ(nullptr, entry);
+	} else {
+		// SHA-1 isn't available, so only the size is checked.
+		ASSERT_NE(nullptr, entry);
+		EXPECT_EQ(string("Wrong SHA-1"), entry->game);
+	}
+}
+
+/**
+ * Multiple DAT files can be loaded into the same object.
+ */
+TEST_F(DatFileTest, multipleDatTest)
+{
+	const string filename1 = writeDat("multi1.dat",
+		"<datafile><game name=\"Game 1\"><rom name=\"game1.bin\" size=\"44\" crc=\"519025e9\"/></game></datafile>");
+	const string filename2 = writeDat("multi2.dat",
+		"<datafile><game name=\"Game 2\"><rom name=\"game2.bin\" size=\"123\" crc=\"474b756f\"/></game></datafile>");
+
+	DatFile datFile;
+	EXPECT_EQ(1, datFile.load(filename1.c_str()));
+	EXPECT_EQ(1, datFile.load(filename2.c_str()));
+	EXPECT_EQ(2U, datFile.count());
+
+	MultiHash hash1, hash2;
+	hashString(hash1, rom1_data);
+	hashString(hash2, rom2_data);
+	EXPECT_NE(nullptr, datFile.find(hash1));
+	EXPECT_NE(nullptr, datFile.find(hash2));
+}
+
+/**
+ * Invalid DAT files.
+ */
+TEST_F(DatFileTest, errorTest)
+{
+	DatFile datFile;
+
+	EXPECT_EQ(-EINVAL, datFile.load(""));
+	EXPECT_EQ(-ENOENT, datFile.load((tmpdir + "/does-not-exist.dat").c_str()));
+
+	// Empty file.
+	EXPECT_EQ(-EIO, datFile.load(writeDat("empty.dat", "").c_str()));
+
+	// Not XML.
+	EXPECT_EQ(-EIO, datFile.load(writeDat("notxml.dat", "clrmamepro (\n\tname \"Test\"\n)\n").c_str()));
+
+	// XML, but not a Logiqx DAT.
+	EXPECT_EQ(-EIO, datFile.load(writeDat("notdat.dat", "<?xml version=\"1.0\"?>\n<root/>\n").c_str()));
+
+	// Valid DAT with no ROM entries.
+	EXPECT_EQ(0, datFile.load(writeDat("nogames.dat", "<datafile><header/></datafile>").c_str()));
+
+	EXPECT_EQ(0U, datFile.count());
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRomData test suite: DatFile tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// Use a temporary directory for the DAT files.
+	const char *const env_tmpdir = getenv("TMPDIR");
+	string tmpl = (env_tmpdir && env_tmpdir[0] == '/') ? env_tmpdir : "/tmp";
+	tmpl += "/rp-DatFileTest.XXXXXX";
+	if (!mkdtemp(&tmpl[0])) {
+		fprintf(stderr, "*** ERROR: Unable to create a temporary directory: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	LibRomData::Tests::tmpdir = tmpl;
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	const int ret = RUN_ALL_TESTS();
+
+	rmdir(tmpl.c_str());
+	return ret;
+}
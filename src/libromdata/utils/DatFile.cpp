@@ -0,0 +1,278 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * DatFile.cpp: Logiqx XML DAT file reader.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "config.librpbase.h"
+#include "DatFile.hpp"
+
+// librpbase, librpfile
+#include "librpbase/crypto/MultiHash.hpp"
+#include "librpfile/RpFile.hpp"
+using LibRpBase::MultiHash;
+using LibRpFile::RpFile;
+
+#ifdef ENABLE_XML
+// TinyXML2
+#  include "tinyxml2.h"
+using namespace tinyxml2;
+#endif /* ENABLE_XML */
+
+// C++ STL classes.
+using std::string;
+using std::unique_ptr;
+using std::unordered_multimap;
+using std::vector;
+
+// References:
+// - https://github.com/SabreTools/SabreTools/wiki/DatFile-Formats#logiqx-xml-format
+
+namespace LibRomData {
+
+#if defined(_MSC_VER) && defined(XML_IS_DLL)
+/**
+ * Check if TinyXML2 can be delay-loaded.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+extern int DelayLoad_test_TinyXML2(void);
+#endif /* defined(_MSC_VER) && defined(XML_IS_DLL) */
+
+class DatFilePrivate
+{
+	public:
+		DatFilePrivate() = default;
+
+	private:
+		RP_DISABLE_COPY(DatFilePrivate)
+
+	public:
+		// Maximum DAT file size. (64 MB)
+		static constexpr off64_t DAT_FILE_SIZE_MAX = 64LL * 1024 * 1024;
+
+		// ROM entries.
+		vector<DatFile::RomEntry> entries;
+
+		// CRC32 index: CRC32 -> index in entries
+		unordered_multimap<uint32_t, size_t> crcIndex;
+
+	public:
+		/**
+		 * Parse a hexadecimal hash string.
+		 * @param pHash		[out] Hash buffer.
+		 * @param hash_len	[in] Hash length, in bytes.
+		 * @param str		[in] Hexadecimal string.
+		 * @return True on success; false on error.
+		 */
+		static bool parseHex(uint8_t *pHash, size_t hash_len, const char *str);
+};
+
+/**
+ * Parse a hexadecimal hash string.
+ * @param pHash		[out] Hash buffer.
+ * @param hash_len	[in] Hash length, in bytes.
+ * @param str		[in] Hexadecimal string.
+ * @return True on success; false on error.
+ */
+bool DatFilePrivate::parseHex(uint8_t *pHash, size_t hash_len, const char *str)
+{
+	if (!str || strlen(str) != hash_len * 2)
+		return false;
+
+	for (size_t i = 0; i < hash_len * 2; i++) {
+		const char chr = str[i];
+		uint8_t nybble;
+		if (chr >= '0' && chr <= '9') {
+			nybble = chr - '0';
+		} else if (chr >= 'a' && chr <= 'f') {
+			nybble = chr - 'a' + 10;
+		} else if (chr >= 'A' && chr <= 'F') {
+			nybble = chr - 'A' + 10;
+		} else {
+			// Invalid character.
+			return false;
+		}
+
+		if (i & 1) {
+			pHash[i / 2] |= nybble;
+		} else {
+			pHash[i / 2] = nybble << 4;
+		}
+	}
+	return true;
+}
+
+/** DatFile **/
+
+DatFile::DatFile()
+	: d_ptr(new DatFilePrivate())
+{ }
+
+DatFile::~DatFile()
+{
+	delete d_ptr;
+}
+
+/**
+ * Load a Logiqx XML DAT file.
+ * Multiple DAT files can be loaded into the same object.
+ * @param filename DAT filename.
+ * @return Number of ROM entries loaded on success; negative POSIX error code on error.
+ */
+int DatFile::load(const char *filename)
+{
+#ifdef ENABLE_XML
+	assert(filename != nullptr);
+	if (!filename || filename[0] == '\0') {
+		return -EINVAL;
+	}
+
+#if defined(_MSC_VER) && defined(XML_IS_DLL)
+	// Delay load verification.
+	// TODO: Only if linked with /DELAYLOAD?
+	int ret_dl = DelayLoad_test_TinyXML2();
+	if (ret_dl != 0) {
+		// Delay load failed.
+		return ret_dl;
+	}
+#endif /* defined(_MSC_VER) && defined(XML_IS_DLL) */
+
+	// Load the DAT file into memory.
+	RpFile *const file = new RpFile(filename, RpFile::FM_OPEN_READ);
+	if (!file->isOpen()) {
+		const int err = file->lastError();
+		file->unref();
+		return (err != 0 ? -err : -EIO);
+	}
+	const off64_t fileSize = file->size();
+	if (fileSize <= 0) {
+		// Empty file. Not a valid DAT file.
+		file->unref();
+		return -EIO;
+	} else if (fileSize > DatFilePrivate::DAT_FILE_SIZE_MAX) {
+		// Too big to load into memory.
+		file->unref();
+		return -EFBIG;
+	}
+	const size_t sz = static_cast<size_t>(fileSize);
+	unique_ptr<char[]> buf(new char[sz]);
+	const size_t size = file->read(buf.get(), sz);
+	file->unref();
+	if (size != sz) {
+		return -EIO;
+	}
+
+	XMLDocument doc;
+	if (doc.Parse(buf.get(), sz) != XML_SUCCESS) {
+		// Not a valid XML document.
+		return -EIO;
+	}
+	buf.reset();
+
+	const XMLElement *const datafile = doc.FirstChildElement("datafile");
+	if (!datafile) {
+		// Not a Logiqx XML DAT file.
+		return -EIO;
+	}
+
+	RP_D(DatFile);
+	int count = 0;
+	for (const XMLElement *game = datafile->FirstChildElement(); game != nullptr;
+	     game = game->NextSiblingElement())
+	{
+		// MAME-style DATs use "machine" instead of "game".
+		if (strcmp(game->Name(), "game") != 0 && strcmp(game->Name(), "machine") != 0)
+			continue;
+
+		const char *const gameName = game->Attribute("name");
+		for (const XMLElement *rom = game->FirstChildElement("rom"); rom != nullptr;
+		     rom = rom->NextSiblingElement("rom"))
+		{
+			// CRC32 is required for lookups.
+			uint8_t crc_be[4];
+			if (!DatFilePrivate::parseHex(crc_be, sizeof(crc_be), rom->Attribute("crc")))
+				continue;
+
+			RomEntry entry;
+			if (gameName) {
+				entry.game = gameName;
+			}
+			const char *const romName = rom->Attribute("name");
+			if (romName) {
+				entry.name = romName;
+			}
+			// NOTE: Unsigned64Attribute() requires TinyXML2 v8.
+			const char *const romSize = rom->Attribute("size");
+			entry.size = (romSize ? strtoull(romSize, nullptr, 10) : 0);
+			entry.crc32 = (crc_be[0] << 24) | (crc_be[1] << 16) | (crc_be[2] << 8) | crc_be[3];
+			entry.has_md5 = DatFilePrivate::parseHex(entry.md5, sizeof(entry.md5), rom->Attribute("md5"));
+			entry.has_sha1 = DatFilePrivate::parseHex(entry.sha1, sizeof(entry.sha1), rom->Attribute("sha1"));
+
+			d->crcIndex.emplace(entry.crc32, d->entries.size());
+			d->entries.emplace_back(std::move(entry));
+			count++;
+		}
+	}
+
+#if TINYXML2_MAJOR_VERSION >= 2
+	doc.Clear();
+#endif /* TINYXML2_MAJOR_VERSION >= 2 */
+	return count;
+#else /* !ENABLE_XML */
+	RP_UNUSED(filename);
+	return -ENOTSUP;
+#endif /* ENABLE_XML */
+}
+
+/**
+ * Get the number of ROM entries.
+ * @return Number of ROM entries.
+ */
+size_t DatFile::count(void) const
+{
+	RP_D(const DatFile);
+	return d->entries.size();
+}
+
+/**
+ * Find a ROM entry matching the specified hashes.
+ *
+ * Entries are looked up by CRC32, then verified using the
+ * size and any MD5 and SHA-1 hashes present in both the
+ * entry and the MultiHash object.
+ *
+ * @param hash Finalized MultiHash. (must include CRC32)
+ * @return ROM entry, or nullptr if not found.
+ */
+const DatFile::RomEntry *DatFile::find(const MultiHash &hash) const
+{
+	RP_D(const DatFile);
+	assert(hash.hashTypes() & MultiHash::HASH_CRC32);
+	if (!(hash.hashTypes() & MultiHash::HASH_CRC32))
+		return nullptr;
+
+	const uint8_t *const md5 = hash.md5();
+	const uint8_t *const sha1 = hash.sha1();
+
+	const auto range = d->crcIndex.equal_range(hash.crc32());
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		const RomEntry &entry = d->entries[iter->second];
+		if (entry.size != hash.size())
+			continue;
+		if (md5 && entry.has_md5 && memcmp(md5, entry.md5, sizeof(entry.md5)) != 0)
+			continue;
+		if (sha1 && entry.has_sha1 && memcmp(sha1, entry.sha1, sizeof(entry.sha1)) != 0)
+			continue;
+
+		// Found a match.
+		return &entry;
+	}
+
+	// No match.
+	return nullptr;
+}
+
+}
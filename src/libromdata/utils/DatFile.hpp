@@ -0,0 +1,87 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * DatFile.hpp: Logiqx XML DAT file reader.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "common.h"
+#include "dll-macros.h"	// for RP_LIBROMDATA_PUBLIC
+
+// C includes.
+#include <stddef.h>	/* size_t */
+#include <stdint.h>
+
+// C++ includes.
+#include <string>
+
+namespace LibRpBase {
+	class MultiHash;
+}
+
+namespace LibRomData {
+
+class DatFilePrivate;
+class DatFile
+{
+	public:
+		RP_LIBROMDATA_PUBLIC
+		DatFile();
+
+		RP_LIBROMDATA_PUBLIC
+		~DatFile();
+
+	private:
+		RP_DISABLE_COPY(DatFile)
+		friend class DatFilePrivate;
+		DatFilePrivate *const d_ptr;
+
+	public:
+		/**
+		 * ROM entry.
+		 */
+		struct RomEntry {
+			std::string game;	// Game name
+			std::string name;	// ROM filename
+			uint64_t size;
+			uint32_t crc32;
+			uint8_t md5[16];
+			uint8_t sha1[20];
+			bool has_md5;
+			bool has_sha1;
+		};
+
+		/**
+		 * Load a Logiqx XML DAT file.
+		 * Multiple DAT files can be loaded into the same object.
+		 * @param filename DAT filename.
+		 * @return Number of ROM entries loaded on success; negative POSIX error code on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int load(const char *filename);
+
+		/**
+		 * Get the number of ROM entries.
+		 * @return Number of ROM entries.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		size_t count(void) const;
+
+		/**
+		 * Find a ROM entry matching the specified hashes.
+		 *
+		 * Entries are looked up by CRC32, then verified using the
+		 * size and any MD5 and SHA-1 hashes present in both the
+		 * entry and the MultiHash object.
+		 *
+		 * @param hash Finalized MultiHash. (must include CRC32)
+		 * @return ROM entry, or nullptr if not found.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		const RomEntry *find(const LibRpBase::MultiHash &hash) const;
+};
+
+}
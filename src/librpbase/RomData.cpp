@@ -10,6 +10,9 @@
 #include "RomData.hpp"
 #include "RomData_p.hpp"
 
+#include "crypto/MultiHash.hpp"
+#include "disc/DiscReader.hpp"
+
 // Other rom-properties libraries
 #include "libi18n/i18n.h"
 #include "libcachecommon/CacheKeys.hpp"
@@ -484,6 +487,9 @@ void RomData::close(void)
 	// Unreference the file.
 	RP_D(RomData);
 	UNREF_AND_NULL(d->file);
+
+	// Release the scratch buffers.
+	d->scratch.reset();
 }
 
 /**
@@ -1078,4 +1084,90 @@ int RomData::checkViewedAchievements(void) const
 	return 0;
 }
 
+/**
+ * Open the logical ROM image for reading.
+ *
+ * This is the image that would be listed in a DAT file,
+ * e.g. the decompressed disc image for compressed formats.
+ * The default implementation reads the file as-is.
+ *
+ * @return IDiscReader for the logical ROM image, or nullptr on error. (Caller must unref() it.)
+ */
+IDiscReader *RomData::openLogicalImage(void)
+{
+	RP_D(RomData);
+	if (!d->file || !d->file->isOpen()) {
+		return nullptr;
+	}
+
+	DiscReader *const discReader = new DiscReader(d->file);
+	if (!discReader->isOpen()) {
+		discReader->unref();
+		return nullptr;
+	}
+	return discReader;
+}
+
+/**
+ * Open the partition that contains the main file system.
+ *
+ * This is used for extracting files from disc images
+ * using FstExtractor. The default implementation
+ * returns nullptr.
+ *
+ * @return IPartition with a file system table, or nullptr if not supported. (Caller must unref() it.)
+ */
+IPartition *RomData::openFstPartition(void)
+{
+	// Not supported by default.
+	return nullptr;
+}
+
+/**
+ * Add a "Hashes" tab to the ROM fields.
+ * This loads the field data if it hasn't been loaded yet.
+ * @param hash		[in] Finalized MultiHash for the logical ROM image.
+ * @param datMatch	[in,opt] DAT match name; "" if no match; nullptr to omit.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RomData::addHashFields(const MultiHash &hash, const char *datMatch)
+{
+	RP_D(RomData);
+	if (!fields()) {
+		// Unable to load the field data.
+		return -EIO;
+	}
+
+	RomFields *const pFields = &d->fields;
+	if (pFields->tabCount() == 1 && !pFields->tabName(0)) {
+		// Single unnamed tab. Give it a name so the
+		// fields don't end up on the "Hashes" tab.
+		pFields->setTabName(0, systemName(SYSNAME_TYPE_LONG | SYSNAME_REGION_GENERIC));
+	}
+	pFields->addTab(C_("RomData", "Hashes"));
+
+	pFields->addField_string(C_("RomData", "Image Size"), formatFileSize(hash.size()));
+
+	static const struct {
+		const char *desc;
+		MultiHash::HashType hashType;
+	} hashFields[] = {
+		{"CRC32",	MultiHash::HASH_CRC32},
+		{"MD5",		MultiHash::HASH_MD5},
+		{"SHA-1",	MultiHash::HASH_SHA1},
+	};
+	for (const auto &p : hashFields) {
+		if (!(hash.hashTypes() & p.hashType))
+			continue;
+		pFields->addField_string(p.desc, hash.hexString(p.hashType),
+			RomFields::STRF_MONOSPACE);
+	}
+
+	if (datMatch) {
+		pFields->addField_string(C_("RomData", "DAT Match"),
+			datMatch[0] != '\0' ? datMatch : C_("RomData", "No match"));
+	}
+	return 0;
+}
+
 }
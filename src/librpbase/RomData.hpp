@@ -33,6 +33,9 @@ namespace LibRpTexture {
 
 namespace LibRpBase {
 
+class IDiscReader;
+class IPartition;
+class MultiHash;
 class RomFields;
 class RomMetaData;
 struct IconAnimData;
@@ -656,6 +659,46 @@ class RomData : public RefBase
 		 * @return Number of achievements unlocked.
 		 */
 		virtual int checkViewedAchievements(void) const;
+
+	public:
+		/** Hashing **/
+
+		/**
+		 * Open the logical ROM image for reading.
+		 *
+		 * This is the image that would be listed in a DAT file,
+		 * e.g. the decompressed disc image for compressed formats.
+		 * The default implementation reads the file as-is.
+		 *
+		 * @return IDiscReader for the logical ROM image, or nullptr on error. (Caller must unref() it.)
+		 */
+		RP_LIBROMDATA_PUBLIC
+		virtual IDiscReader *openLogicalImage(void);
+
+		/**
+		 * Add a "Hashes" tab to the ROM fields.
+		 * This loads the field data if it hasn't been loaded yet.
+		 * @param hash		[in] Finalized MultiHash for the logical ROM image.
+		 * @param datMatch	[in,opt] DAT match name; "" if no match; nullptr to omit.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int addHashFields(const MultiHash &hash, const char *datMatch = nullptr);
+
+	public:
+		/** File system **/
+
+		/**
+		 * Open the partition that contains the main file system.
+		 *
+		 * This is used for extracting files from disc images
+		 * using FstExtractor. The default implementation
+		 * returns nullptr.
+		 *
+		 * @return IPartition with a file system table, or nullptr if not supported. (Caller must unref() it.)
+		 */
+		RP_LIBROMDATA_PUBLIC
+		virtual IPartition *openFstPartition(void);
 };
 
 }
@@ -261,6 +261,30 @@ class klass final : public LibRpBase::RomData { \
 		 */ \
 		void close(void) final;
 
+/**
+ * RomData subclass function declaration for opening the logical image.
+ * Only needed if the ROM image is compressed or wrapped in a container format.
+ */
+#define ROMDATA_DECL_LOGICAL_IMAGE() \
+	public: \
+		/** \
+		 * Open the logical ROM image for reading. \
+		 * @return IDiscReader for the logical ROM image, or nullptr on error. (Caller must unref() it.) \
+		 */ \
+		LibRpBase::IDiscReader *openLogicalImage(void) final;
+
+/**
+ * RomData subclass function declaration for opening the file system partition.
+ * Only needed if the ROM image has a file system that can be extracted.
+ */
+#define ROMDATA_DECL_FST_PARTITION() \
+	public: \
+		/** \
+		 * Open the partition that contains the main file system. \
+		 * @return IPartition with a file system table, or nullptr if not supported. (Caller must unref() it.) \
+		 */ \
+		LibRpBase::IPartition *openFstPartition(void) final;
+
 /**
  * End of RomData subclass declaration.
  */
@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "RomData.hpp"
+#include "ScratchArena.hpp"
 
 // TODO: Remove from here and add to each RomData subclass?
 #include "RomFields.hpp"
@@ -68,6 +69,12 @@ class RomDataPrivate
 		RomFields fields;		// ROM fields (always allocated)
 		RomMetaData *metaData;		// ROM metadata (NOTE: nullptr initially)
 
+		// Scratch arena for temporary buffers used while parsing.
+		// All allocations are released when the file is closed.
+		// NOTE: Use a ScratchArena::Scope for buffers that are only
+		// needed within a single function.
+		ScratchArena scratch;
+
 	public:
 		/** Convenience functions. **/
 
@@ -11,6 +11,12 @@
 
 #include "libi18n/i18n.h"
 
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+#include "librpthreads/ThreadPool.hpp"
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
+
 // C++ STL classes.
 using std::map;
 using std::string;
@@ -305,6 +311,94 @@ RomFields::Field::Field(Field &&other) noexcept
 	other.type = RFT_INVALID;
 }
 
+/** RomFields::ListDataIcons **/
+
+/**
+ * Create a ListDataIcons object for lazy icons.
+ * @param loader	[in] Icon loader function
+ * @param userdata	[in] User data for the loader function
+ */
+RomFields::ListDataIcons::ListDataIcons(IconLoader_t loader, void *userdata)
+	: m_loader(loader)
+	, m_userdata(userdata)
+	, m_mutex(loader ? new Mutex() : nullptr)
+{ }
+
+RomFields::ListDataIcons::ListDataIcons(const ListDataIcons &other)
+	: m_loader(other.m_loader)
+	, m_userdata(other.m_userdata)
+	, m_mutex(other.m_loader ? new Mutex() : nullptr)
+{
+	if (other.m_mutex) {
+		MutexLocker locker(*other.m_mutex);
+		m_entries = other.m_entries;
+	} else {
+		m_entries = other.m_entries;
+	}
+}
+
+RomFields::ListDataIcons::~ListDataIcons()
+{
+	delete m_mutex;
+}
+
+/**
+ * Get an icon.
+ * If the icon hasn't been decoded yet, it will be decoded now.
+ * @param idx Icon index
+ * @return Icon, or nullptr if the row doesn't have an icon.
+ */
+const rp_image *RomFields::ListDataIcons::at(size_t idx) const
+{
+	assert(idx < m_entries.size());
+	if (idx >= m_entries.size())
+		return nullptr;
+
+	if (!m_mutex) {
+		// No loader function, so all icons are already decoded.
+		return m_entries[idx].icon;
+	}
+
+	MutexLocker locker(*m_mutex);
+	Entry &entry = m_entries[idx];
+	if (!entry.loaded) {
+		entry.icon = m_loader(m_userdata, entry.id);
+		entry.loaded = true;
+	}
+	return entry.icon;
+}
+
+/**
+ * Decode all icons that haven't been decoded yet.
+ * @param parallel If true, decode icons using the thread pool.
+ */
+void RomFields::ListDataIcons::loadAll(bool parallel) const
+{
+	if (!m_mutex)
+		return;
+
+	// NOTE: The mutex is held while decoding, so at() will
+	// wait for loadAll() instead of decoding the same icon.
+	// Each thread pool task only writes its own entry.
+	MutexLocker locker(*m_mutex);
+
+	// Only decode icons that haven't been decoded yet.
+	vector<Entry*> pending;
+	for (Entry &entry : m_entries) {
+		if (!entry.loaded) {
+			pending.push_back(&entry);
+		}
+	}
+	if (pending.empty())
+		return;
+
+	LibRpThreads::parallel_for(0, static_cast<int>(pending.size()), [&](int i) {
+		Entry *const entry = pending[i];
+		entry->icon = m_loader(m_userdata, entry->id);
+		entry->loaded = true;
+	}, parallel);
+}
+
 /** RomFields **/
 
 /**
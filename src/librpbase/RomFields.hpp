@@ -16,6 +16,7 @@
 #include <stdint.h>
 
 // C includes. (C++ namespace)
+#include <cassert>
 #include <ctime>
 
 // C++ includes.
@@ -27,6 +28,9 @@
 namespace LibRpTexture {
 	class rp_image;
 }
+namespace LibRpThreads {
+	class Mutex;
+}
 
 namespace LibRpBase {
 
@@ -248,7 +252,138 @@ class RomFields
 		typedef std::map<uint32_t, std::string> StringMultiMap_t;
 		typedef std::vector<std::vector<std::string> > ListData_t;
 		typedef std::map<uint32_t, ListData_t> ListDataMultiMap_t;
-		typedef std::vector<const LibRpTexture::rp_image*> ListDataIcons_t;
+
+		/**
+		 * Icons for RFT_LISTDATA_ICONS.
+		 *
+		 * Icons can be added as decoded images, or as lazy handles
+		 * (resource ID) that are decoded by the loader function on
+		 * first access. loadAll() can be used to decode all pending
+		 * icons at once, optionally using the thread pool.
+		 *
+		 * NOTE: Icons are owned by the RomData object, not by this
+		 * container, so they're only valid while the RomData object
+		 * is alive.
+		 *
+		 * Thread safety: Icons must only be added while the fields are
+		 * being loaded, before the container is visible to other code.
+		 * After that, at() and loadAll() may be called from any thread.
+		 * For lazy icons, they're serialized using an internal mutex,
+		 * so at() blocks while loadAll() is decoding.
+		 */
+		class ListDataIcons {
+			public:
+				/**
+				 * Icon loader function.
+				 * This must be thread-safe if loadAll() is called with parallel == true.
+				 * @param userdata	[in] User data specified in the constructor
+				 * @param id		[in] Resource ID
+				 * @return Icon, or nullptr on error. (Owned by the loader, not by ListDataIcons.)
+				 */
+				typedef const LibRpTexture::rp_image *(*IconLoader_t)(void *userdata, uint64_t id);
+
+				/**
+				 * Create a ListDataIcons object for decoded icons.
+				 */
+				ListDataIcons()
+					: m_loader(nullptr)
+					, m_userdata(nullptr)
+					, m_mutex(nullptr)
+				{ }
+
+				/**
+				 * Create a ListDataIcons object for lazy icons.
+				 * @param loader	[in] Icon loader function
+				 * @param userdata	[in] User data for the loader function
+				 */
+				RP_LIBROMDATA_PUBLIC
+				ListDataIcons(IconLoader_t loader, void *userdata);
+
+				RP_LIBROMDATA_PUBLIC
+				ListDataIcons(const ListDataIcons &other);
+
+				RP_LIBROMDATA_PUBLIC
+				~ListDataIcons();
+
+			private:
+				// Not assignable. (Only copy-constructed by RomFields::Field.)
+				ListDataIcons &operator=(const ListDataIcons &);
+
+			public:
+				inline size_t size(void) const
+				{
+					return m_entries.size();
+				}
+
+				inline bool empty(void) const
+				{
+					return m_entries.empty();
+				}
+
+				inline void reserve(size_t count)
+				{
+					m_entries.reserve(count);
+				}
+
+				/**
+				 * Add a decoded icon.
+				 * @param icon Icon (may be nullptr)
+				 */
+				inline void push_back(const LibRpTexture::rp_image *icon)
+				{
+					Entry entry;
+					entry.id = 0;
+					entry.icon = icon;
+					entry.loaded = true;
+					m_entries.emplace_back(entry);
+				}
+
+				/**
+				 * Add a lazy icon, which will be decoded by the loader function on first access.
+				 * @param id Resource ID
+				 */
+				inline void push_back_lazy(uint64_t id)
+				{
+					assert(m_loader != nullptr);
+					Entry entry;
+					entry.id = id;
+					entry.icon = nullptr;
+					entry.loaded = (m_loader == nullptr);
+					m_entries.emplace_back(entry);
+				}
+
+				/**
+				 * Get an icon.
+				 * If the icon hasn't been decoded yet, it will be decoded now.
+				 * @param idx Icon index
+				 * @return Icon, or nullptr if the row doesn't have an icon.
+				 */
+				RP_LIBROMDATA_PUBLIC
+				const LibRpTexture::rp_image *at(size_t idx) const;
+
+				/**
+				 * Decode all icons that haven't been decoded yet.
+				 * @param parallel If true, decode icons using the thread pool.
+				 */
+				RP_LIBROMDATA_PUBLIC
+				void loadAll(bool parallel = true) const;
+
+			private:
+				struct Entry {
+					uint64_t id;				// Resource ID (lazy icons only)
+					const LibRpTexture::rp_image *icon;	// Decoded icon
+					bool loaded;				// True if icon is valid
+				};
+				mutable std::vector<Entry> m_entries;
+
+				IconLoader_t m_loader;
+				void *m_userdata;
+
+				// Protects m_entries while lazy icons are decoded.
+				// (nullptr if there's no loader function)
+				LibRpThreads::Mutex *m_mutex;
+		};
+		typedef ListDataIcons ListDataIcons_t;
 
 		// ROM field struct.
 		// Dynamically allocated.
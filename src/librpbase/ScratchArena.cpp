@@ -0,0 +1,114 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ScratchArena.cpp: Monotonic allocator for parse-lifetime buffers.       *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "ScratchArena.hpp"
+
+namespace LibRpBase {
+
+/**
+ * Create a scratch arena.
+ * No memory is allocated until the first call to alloc().
+ * @param blockSize Default block size
+ */
+ScratchArena::ScratchArena(size_t blockSize)
+	: m_blockSize(blockSize > 0 ? blockSize : DEFAULT_BLOCK_SIZE)
+	, m_curBlock(0)
+	, m_curPos(0)
+{ }
+
+ScratchArena::~ScratchArena()
+{
+	for (const Block &block : m_blocks) {
+		free(block.data);
+	}
+}
+
+/**
+ * Allocate memory from the arena.
+ * The memory is NOT initialized.
+ * @param size Size, in bytes
+ * @param align Alignment (must be a power of 2)
+ * @return Pointer to the allocated memory, or nullptr on error.
+ */
+void *ScratchArena::alloc(size_t size, size_t align)
+{
+	assert(align != 0 && (align & (align - 1)) == 0);
+	if (align == 0 || (align & (align - 1)) != 0) {
+		// Invalid alignment.
+		return nullptr;
+	}
+	if (size == 0) {
+		// Zero-byte allocations still need a unique pointer.
+		size = 1;
+	}
+
+	// Try the current block, then any blocks that were
+	// kept from before the last Scope or reset().
+	for (; m_curBlock < m_blocks.size(); m_curBlock++, m_curPos = 0) {
+		const Block &block = m_blocks[m_curBlock];
+		const uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+		const uintptr_t p = (base + m_curPos + (align - 1)) & ~static_cast<uintptr_t>(align - 1);
+		const size_t offset = static_cast<size_t>(p - base);
+		if (offset <= block.size && size <= block.size - offset) {
+			m_curPos = offset + size;
+			return reinterpret_cast<void*>(p);
+		}
+	}
+
+	// Allocate a new block.
+	// Large allocations get a block of their own.
+	if (size > (~static_cast<size_t>(0) - align)) {
+		// Overflow.
+		return nullptr;
+	}
+	Block block;
+	block.size = std::max(m_blockSize, size + align);
+	block.data = static_cast<uint8_t*>(malloc(block.size));
+	if (!block.data) {
+		return nullptr;
+	}
+	m_blocks.emplace_back(block);
+	m_curBlock = m_blocks.size() - 1;
+
+	const uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+	const uintptr_t p = (base + (align - 1)) & ~static_cast<uintptr_t>(align - 1);
+	m_curPos = static_cast<size_t>(p - base) + size;
+	return reinterpret_cast<void*>(p);
+}
+
+/**
+ * Release all allocations.
+ * The first block is kept for reuse; other blocks are freed.
+ */
+void ScratchArena::reset(void)
+{
+	if (m_blocks.size() > 1) {
+		for (auto iter = m_blocks.begin() + 1; iter != m_blocks.end(); ++iter) {
+			free(iter->data);
+		}
+		m_blocks.resize(1);
+	}
+	m_curBlock = 0;
+	m_curPos = 0;
+}
+
+/**
+ * Get the total number of bytes reserved by the arena.
+ * @return Total block size, in bytes
+ */
+size_t ScratchArena::capacity(void) const
+{
+	size_t total = 0;
+	for (const Block &block : m_blocks) {
+		total += block.size;
+	}
+	return total;
+}
+
+}
@@ -0,0 +1,136 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ScratchArena.hpp: Monotonic allocator for parse-lifetime buffers.       *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "common.h"
+#include "dll-macros.h"	// for RP_LIBROMDATA_PUBLIC
+
+// C includes (C++ namespace)
+#include <cstddef>
+
+// C++ includes
+#include <vector>
+
+namespace LibRpBase {
+
+/**
+ * Monotonic ("bump pointer") allocator.
+ *
+ * Allocations are carved out of large blocks and are never freed
+ * individually. Everything is released at once by reset() or
+ * when the arena is destroyed. A Scope can be used to release
+ * everything allocated within a block of code.
+ *
+ * Each RomData object owns an arena (RomDataPrivate::scratch) for
+ * temporary buffers used while parsing headers and tables.
+ *
+ * NOTE: This class is NOT thread-safe.
+ */
+class ScratchArena
+{
+	public:
+		/**
+		 * Create a scratch arena.
+		 * No memory is allocated until the first call to alloc().
+		 * @param blockSize Default block size
+		 */
+		RP_LIBROMDATA_PUBLIC
+		explicit ScratchArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+		RP_LIBROMDATA_PUBLIC
+		~ScratchArena();
+
+	private:
+		RP_DISABLE_COPY(ScratchArena)
+
+	public:
+		static const size_t DEFAULT_BLOCK_SIZE = 16384;
+
+		/**
+		 * Allocate memory from the arena.
+		 * The memory is NOT initialized.
+		 * @param size Size, in bytes
+		 * @param align Alignment (must be a power of 2)
+		 * @return Pointer to the allocated memory, or nullptr on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		void *alloc(size_t size, size_t align = 16);
+
+		/**
+		 * Allocate an array of T from the arena.
+		 * The memory is NOT initialized, so T must be a POD type.
+		 * @param count Number of elements
+		 * @return Pointer to the allocated array, or nullptr on error.
+		 */
+		template<typename T>
+		inline T *alloc_array(size_t count)
+		{
+			if (count > (~static_cast<size_t>(0) / sizeof(T))) {
+				// Overflow.
+				return nullptr;
+			}
+			return static_cast<T*>(alloc(count * sizeof(T), alignof(T)));
+		}
+
+		/**
+		 * Release all allocations.
+		 * The first block is kept for reuse; other blocks are freed.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		void reset(void);
+
+		/**
+		 * Get the total number of bytes reserved by the arena.
+		 * @return Total block size, in bytes
+		 */
+		RP_LIBROMDATA_PUBLIC
+		size_t capacity(void) const;
+
+	public:
+		/**
+		 * Release all allocations made during the lifetime
+		 * of this object when it goes out of scope.
+		 * Blocks are kept for reuse.
+		 */
+		class Scope
+		{
+			public:
+				explicit Scope(ScratchArena &arena)
+					: m_arena(arena)
+					, m_block(arena.m_curBlock)
+					, m_pos(arena.m_curPos)
+				{ }
+
+				~Scope()
+				{
+					m_arena.m_curBlock = m_block;
+					m_arena.m_curPos = m_pos;
+				}
+
+			private:
+				RP_DISABLE_COPY(Scope)
+				ScratchArena &m_arena;
+				size_t m_block;
+				size_t m_pos;
+		};
+
+	private:
+		struct Block {
+			uint8_t *data;
+			size_t size;
+		};
+		std::vector<Block> m_blocks;
+		size_t m_blockSize;
+
+		// Current allocation position
+		size_t m_curBlock;	// Index into m_blocks
+		size_t m_curPos;	// Offset into m_blocks[m_curBlock]
+};
+
+}
@@ -82,6 +82,7 @@ class ConfigPrivate : public ConfReaderPrivate
 		bool extImgDownloadEnabled;
 		bool useIntIconForSmallSizes;
 		bool storeFileOriginInfo;
+		unsigned int negativeCacheExpiry;
 
 		// Image bandwidth options
 		Config::ImgBandwidth imgBandwidthUnmetered;
@@ -97,6 +98,9 @@ class ConfigPrivate : public ConfReaderPrivate
 		bool showDangerousPermissionsOverlayIcon;
 		bool enableThumbnailOnNetworkFS;
 		bool showXAttrView;
+
+		// PNG compression profile.
+		Config::PngProfile pngProfile;
 };
 
 /** ConfigPrivate **/
@@ -131,6 +135,7 @@ ConfigPrivate::ConfigPrivate()
 	, extImgDownloadEnabled(true)
 	, useIntIconForSmallSizes(true)
 	, storeFileOriginInfo(true)
+	, negativeCacheExpiry(7)
 	// Image bandwidth options
 	, imgBandwidthUnmetered(Config::ImgBandwidth::HighRes)
 	, imgBandwidthMetered(Config::ImgBandwidth::NormalRes)
@@ -143,6 +148,8 @@ ConfigPrivate::ConfigPrivate()
 	, enableThumbnailOnNetworkFS(false)
 	// Show the Extended Attributes tab
 	, showXAttrView(true)
+	// PNG compression profile
+	, pngProfile(Config::PngProfile::Default)
 {
 	// NOTE: Configuration is also initialized in the reset() function.
 	memset(dmgTSMode, 0, sizeof(dmgTSMode));
@@ -168,6 +175,7 @@ void ConfigPrivate::reset(void)
 	extImgDownloadEnabled = true;
 	useIntIconForSmallSizes = true;
 	storeFileOriginInfo = true;
+	negativeCacheExpiry = 7;
 
 	// Image bandwidth options
 	imgBandwidthUnmetered = Config::ImgBandwidth::HighRes;
@@ -187,6 +195,8 @@ void ConfigPrivate::reset(void)
 	enableThumbnailOnNetworkFS = false;
 	// Show the Extended Attributes tab
 	showXAttrView = true;
+	// PNG compression profile
+	pngProfile = Config::PngProfile::Default;
 }
 
 /**
@@ -233,6 +243,14 @@ int ConfigPrivate::processConfigLine(const char *section, const char *name, cons
 				palLanguageForGameTDB |= TOLOWER(*value);
 			}
 			return 1;
+		} else if (!strcasecmp(name, "NegativeCacheExpiry")) {
+			// Negative cache expiry, in days.
+			char *endptr = nullptr;
+			const unsigned long days = strtoul(value, &endptr, 10);
+			if (endptr && *endptr == '\0' && days <= 3650) {
+				negativeCacheExpiry = static_cast<unsigned int>(days);
+			}
+			return 1;
 		} else if (!strcasecmp(name, "ImgBandwidthUnmetered")) {
 			isNewBandwidthOptionSet = true;
 			ibParam = &imgBandwidthUnmetered;
@@ -311,6 +329,18 @@ int ConfigPrivate::processConfigLine(const char *section, const char *name, cons
 			param = &enableThumbnailOnNetworkFS;
 		} else if (!strcasecmp(name, "ShowXAttrView")) {
 			param = &showXAttrView;
+		} else if (!strcasecmp(name, "PngCompressionProfile")) {
+			// PNG compression profile.
+			if (!strcasecmp(value, "Default")) {
+				pngProfile = Config::PngProfile::Default;
+			} else if (!strcasecmp(value, "Fast")) {
+				pngProfile = Config::PngProfile::Fast;
+			} else if (!strcasecmp(value, "Small")) {
+				pngProfile = Config::PngProfile::Small;
+			} else {
+				// TODO: Show a warning or something?
+			}
+			return 1;
 		} else {
 			// Invalid option.
 			return 1;
@@ -619,6 +649,18 @@ uint32_t Config::palLanguageForGameTDB(void) const
 	return d->palLanguageForGameTDB;
 }
 
+/**
+ * Number of days before a "not found" result for an
+ * external image is retried. (0 to always retry)
+ * NOTE: Call load() before using this function.
+ * @return Negative cache expiry, in days.
+ */
+unsigned int Config::negativeCacheExpiry(void) const
+{
+	RP_D(const Config);
+	return d->negativeCacheExpiry;
+}
+
 /* Image bandwidth settings */
 
 /**
@@ -714,4 +756,15 @@ bool Config::showXAttrView(void) const
 	return d->showXAttrView;
 }
 
+/**
+ * PNG compression profile for thumbnails and extracted images.
+ * NOTE: Call load() before using this function.
+ * @return PNG compression profile.
+ */
+Config::PngProfile Config::pngProfile(void) const
+{
+	RP_D(const Config);
+	return d->pngProfile;
+}
+
 }
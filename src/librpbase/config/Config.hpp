@@ -113,6 +113,14 @@ class RP_LIBROMDATA_PUBLIC Config : public ConfReader
 		 */
 		uint32_t palLanguageForGameTDB(void) const;
 
+		/**
+		 * Number of days before a "not found" result for an
+		 * external image is retried. (0 to always retry)
+		 * NOTE: Call load() before using this function.
+		 * @return Negative cache expiry, in days.
+		 */
+		unsigned int negativeCacheExpiry(void) const;
+
 		/* Image bandwidth options */
 
 		enum class ImgBandwidth : uint8_t {
@@ -174,6 +182,21 @@ class RP_LIBROMDATA_PUBLIC Config : public ConfReader
 		 * @return True if we should enable; false if not.
 		 */
 		bool showXAttrView(void) const;
+
+		/** PNG compression **/
+
+		enum class PngProfile : uint8_t {
+			Default = 0,	// No filtering; default zlib level
+			Fast = 1,	// Fixed "Sub" filter; zlib level 1
+			Small = 2,	// Adaptive filtering; zlib level 9
+		};
+
+		/**
+		 * PNG compression profile for thumbnails and extracted images.
+		 * NOTE: Call load() before using this function.
+		 * @return PNG compression profile.
+		 */
+		PngProfile pngProfile(void) const;
 };
 
 }
@@ -0,0 +1,400 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * MultiHash.cpp: Single-pass CRC32/MD5/SHA-1 hash calculation.            *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "config.librpbase.h"
+#include "MultiHash.hpp"
+#include "MultiHash_p.hpp"
+
+#include "../disc/IDiscReader.hpp"
+
+// librpcpu
+#if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
+#  include "librpcpu/cpuflags_x86.h"
+#endif /* RP_CPU_I386 || RP_CPU_AMD64 */
+
+// zlib for crc32()
+#include <zlib.h>
+
+// librpthreads
+#include "librpthreads/ThreadPool.hpp"
+using LibRpThreads::TaskGroup;
+
+// C++ STL classes
+using std::string;
+
+namespace LibRpBase {
+
+namespace {
+
+/**
+ * Parameters for the hashDiscReader() hash tasks.
+ */
+struct HashTaskParam {
+	MultiHashPrivate *d;
+	const uint8_t *pData;
+	size_t len;
+};
+
+void hashTask_CRC32(void *param)
+{
+	HashTaskParam *const p = static_cast<HashTaskParam*>(param);
+	p->d->crc32 = MultiHash::crc32(p->d->crc32, p->pData, p->len);
+}
+
+void hashTask_MD5(void *param)
+{
+	HashTaskParam *const p = static_cast<HashTaskParam*>(param);
+	p->d->updateMD5(p->pData, p->len);
+}
+
+void hashTask_SHA1(void *param)
+{
+	HashTaskParam *const p = static_cast<HashTaskParam*>(param);
+	p->d->updateSHA1(p->pData, p->len);
+}
+
+}
+
+/** MultiHashPrivate **/
+
+MultiHashPrivate::MultiHashPrivate(unsigned int hashTypes)
+	: hashTypes(hashTypes & MultiHash::supportedHashTypes())
+	, finalized(false)
+	, size(0)
+	, crc32(0)
+{
+	memset(md5, 0, sizeof(md5));
+	memset(sha1, 0, sizeof(sha1));
+	initCrypto();
+}
+
+MultiHashPrivate::~MultiHashPrivate()
+{
+	closeCrypto();
+}
+
+#ifndef ENABLE_DECRYPTION
+/** Cryptographic hash functions. (not available) **/
+
+void MultiHashPrivate::initCrypto(void)
+{
+	// MD5 and SHA-1 aren't available without decryption support.
+	hashTypes &= MultiHash::HASH_CRC32;
+}
+
+void MultiHashPrivate::closeCrypto(void)
+{ }
+
+void MultiHashPrivate::updateMD5(const uint8_t *pData, size_t len)
+{
+	RP_UNUSED(pData);
+	RP_UNUSED(len);
+}
+
+void MultiHashPrivate::updateSHA1(const uint8_t *pData, size_t len)
+{
+	RP_UNUSED(pData);
+	RP_UNUSED(len);
+}
+
+void MultiHashPrivate::finalizeCrypto(void)
+{ }
+#endif /* !ENABLE_DECRYPTION */
+
+/** MultiHash **/
+
+/**
+ * Create a MultiHash object.
+ * Hash types that aren't supported in this build are ignored.
+ * @param hashTypes Hash types to calculate. (See HashType.)
+ */
+MultiHash::MultiHash(unsigned int hashTypes)
+	: d_ptr(new MultiHashPrivate(hashTypes))
+{ }
+
+MultiHash::~MultiHash()
+{
+	delete d_ptr;
+}
+
+/**
+ * Get the hash types supported in this build.
+ * CRC32 is always supported. MD5 and SHA-1 require
+ * decryption support.
+ * @return Supported hash types. (See HashType.)
+ */
+unsigned int MultiHash::supportedHashTypes(void)
+{
+#ifdef ENABLE_DECRYPTION
+	return HASH_ALL;
+#else /* !ENABLE_DECRYPTION */
+	return HASH_CRC32;
+#endif /* ENABLE_DECRYPTION */
+}
+
+/**
+ * Get the hash types being calculated by this object.
+ * @return Hash types. (See HashType.)
+ */
+unsigned int MultiHash::hashTypes(void) const
+{
+	RP_D(const MultiHash);
+	return d->hashTypes;
+}
+
+/**
+ * Reset all hashes.
+ */
+void MultiHash::reset(void)
+{
+	RP_D(MultiHash);
+	d->closeCrypto();
+	d->finalized = false;
+	d->size = 0;
+	d->crc32 = 0;
+	memset(d->md5, 0, sizeof(d->md5));
+	memset(d->sha1, 0, sizeof(d->sha1));
+	d->initCrypto();
+}
+
+/**
+ * Add data to the hashes.
+ * @param pData	[in] Data.
+ * @param len	[in] Length of data.
+ */
+void MultiHash::update(const void *pData, size_t len)
+{
+	RP_D(MultiHash);
+	assert(!d->finalized);
+	if (d->finalized || len == 0)
+		return;
+
+	const uint8_t *const pData8 = static_cast<const uint8_t*>(pData);
+	if (d->hashTypes & HASH_CRC32) {
+		d->crc32 = MultiHash::crc32(d->crc32, pData8, len);
+	}
+	if (d->hashTypes & HASH_MD5) {
+		d->updateMD5(pData8, len);
+	}
+	if (d->hashTypes & HASH_SHA1) {
+		d->updateSHA1(pData8, len);
+	}
+	d->size += len;
+}
+
+/**
+ * Hash the entire contents of an IDiscReader.
+ *
+ * The image is read once, in large chunks. Each hash is
+ * updated on its own thread, and the next chunk is read
+ * while the current chunk is being hashed.
+ *
+ * finalize() is called automatically on success.
+ *
+ * @param discReader	[in] IDiscReader.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int MultiHash::hashDiscReader(IDiscReader *discReader)
+{
+	RP_D(MultiHash);
+	assert(discReader != nullptr);
+	assert(!d->finalized);
+	if (!discReader || !discReader->isOpen()) {
+		return -EBADF;
+	} else if (d->finalized) {
+		return -EINVAL;
+	}
+
+	// Two buffers: one is being hashed while the other one is being read.
+	static constexpr size_t CHUNK_SIZE = 1024U * 1024U;
+	uint8_t *const buf0 = static_cast<uint8_t*>(aligned_malloc(16, CHUNK_SIZE * 2));
+	if (!buf0) {
+		return -ENOMEM;
+	}
+	uint8_t *const buf1 = buf0 + CHUNK_SIZE;
+
+	discReader->rewind();
+	const unsigned int hashTypes = d->hashTypes;
+	uint8_t *pCur = buf0, *pNext = buf1;
+	size_t len_cur = discReader->read(pCur, CHUNK_SIZE);
+	TaskGroup group;
+	while (len_cur > 0) {
+		// Hash the current chunk using the thread pool.
+		HashTaskParam param = {d, pCur, len_cur};
+		if (hashTypes & HASH_CRC32) {
+			group.run(hashTask_CRC32, &param);
+		}
+		if (hashTypes & HASH_MD5) {
+			group.run(hashTask_MD5, &param);
+		}
+		if (hashTypes & HASH_SHA1) {
+			group.run(hashTask_SHA1, &param);
+		}
+
+		// Read the next chunk on this thread.
+		size_t len_next = 0;
+		if (len_cur == CHUNK_SIZE) {
+			len_next = discReader->read(pNext, CHUNK_SIZE);
+		}
+		group.wait();
+
+		d->size += len_cur;
+		std::swap(pCur, pNext);
+		len_cur = len_next;
+	}
+	aligned_free(buf0);
+
+	// Make sure the entire image was read.
+	int ret = discReader->lastError();
+	if (ret != 0) {
+		return -ret;
+	}
+	const off64_t discSize = discReader->size();
+	if (discSize >= 0 && d->size != static_cast<uint64_t>(discSize)) {
+		// Short read.
+		return -EIO;
+	}
+
+	finalize();
+	return 0;
+}
+
+/**
+ * Finalize the hashes.
+ * The hash getters are only valid after calling this function.
+ */
+void MultiHash::finalize(void)
+{
+	RP_D(MultiHash);
+	if (d->finalized)
+		return;
+
+	d->finalizeCrypto();
+	d->finalized = true;
+}
+
+/** Results **/
+
+/**
+ * Get the total number of bytes hashed.
+ * @return Number of bytes hashed.
+ */
+uint64_t MultiHash::size(void) const
+{
+	RP_D(const MultiHash);
+	return d->size;
+}
+
+/**
+ * Get the CRC32.
+ * @return CRC32.
+ */
+uint32_t MultiHash::crc32(void) const
+{
+	RP_D(const MultiHash);
+	return d->crc32;
+}
+
+/**
+ * Get the MD5 hash.
+ * @return MD5 hash (16 bytes), or nullptr if not calculated.
+ */
+const uint8_t *MultiHash::md5(void) const
+{
+	RP_D(const MultiHash);
+	return (d->finalized && (d->hashTypes & HASH_MD5)) ? d->md5 : nullptr;
+}
+
+/**
+ * Get the SHA-1 hash.
+ * @return SHA-1 hash (20 bytes), or nullptr if not calculated.
+ */
+const uint8_t *MultiHash::sha1(void) const
+{
+	RP_D(const MultiHash);
+	return (d->finalized && (d->hashTypes & HASH_SHA1)) ? d->sha1 : nullptr;
+}
+
+/**
+ * Get a hash as a lowercase hexadecimal string.
+ * @param hashType Hash type. (Must be a single HashType.)
+ * @return Hexadecimal string, or empty string if not calculated.
+ */
+string MultiHash::hexString(HashType hashType) const
+{
+	RP_D(const MultiHash);
+	if (!(d->hashTypes & hashType))
+		return {};
+
+	const uint8_t *pHash;
+	size_t hash_len;
+	switch (hashType) {
+		case HASH_CRC32: {
+			char buf[16];
+			snprintf(buf, sizeof(buf), "%08x", d->crc32);
+			return buf;
+		}
+		case HASH_MD5:
+			pHash = md5();
+			hash_len = sizeof(d->md5);
+			break;
+		case HASH_SHA1:
+			pHash = sha1();
+			hash_len = sizeof(d->sha1);
+			break;
+		default:
+			assert(!"Invalid hash type.");
+			return {};
+	}
+	if (!pHash)
+		return {};
+
+	static const char hex_lookup[] = "0123456789abcdef";
+	string s;
+	s.resize(hash_len * 2);
+	for (size_t i = 0; i < hash_len; i++) {
+		s[(i * 2) + 0] = hex_lookup[pHash[i] >> 4];
+		s[(i * 2) + 1] = hex_lookup[pHash[i] & 0x0F];
+	}
+	return s;
+}
+
+/**
+ * Calculate a CRC32 using the standard (zlib) polynomial.
+ * PCLMULQDQ is used if it's supported by the CPU.
+ * @param crc	[in] Previous CRC32. (Use 0 for the first block.)
+ * @param pData	[in] Data.
+ * @param len	[in] Length of data.
+ * @return Updated CRC32.
+ */
+uint32_t MultiHash::crc32(uint32_t crc, const void *pData, size_t len)
+{
+	const uint8_t *pData8 = static_cast<const uint8_t*>(pData);
+
+#if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
+	if (len >= 64 && RP_CPU_HasPCLMULQDQ() && RP_CPU_HasSSE41()) {
+		// PCLMULQDQ handles multiples of 16 bytes.
+		const size_t len_pclmul = len & ~static_cast<size_t>(15);
+		crc = MultiHashPrivate::crc32_pclmul(crc, pData8, len_pclmul);
+		pData8 += len_pclmul;
+		len -= len_pclmul;
+	}
+#endif /* RP_CPU_I386 || RP_CPU_AMD64 */
+
+	// zlib's crc32() takes a 32-bit length.
+	while (len > 0) {
+		const uInt len_z = static_cast<uInt>(std::min(len, static_cast<size_t>(1U << 30)));
+		crc = ::crc32(crc, pData8, len_z);
+		pData8 += len_z;
+		len -= len_z;
+	}
+	return crc;
+}
+
+}
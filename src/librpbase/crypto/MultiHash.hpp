@@ -0,0 +1,164 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * MultiHash.hpp: Single-pass CRC32/MD5/SHA-1 hash calculation.            *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "common.h"
+#include "dll-macros.h"	// for RP_LIBROMDATA_PUBLIC
+
+// C includes.
+#include <stddef.h>	/* size_t */
+#include <stdint.h>
+
+// C++ includes.
+#include <string>
+
+namespace LibRpBase {
+
+class IDiscReader;
+
+class MultiHashPrivate;
+class MultiHash
+{
+	public:
+		/**
+		 * Hash types.
+		 * These can be OR'd together.
+		 */
+		enum HashType : unsigned int {
+			HASH_CRC32	= (1U << 0),
+			HASH_MD5	= (1U << 1),
+			HASH_SHA1	= (1U << 2),
+
+			HASH_ALL	= HASH_CRC32 | HASH_MD5 | HASH_SHA1,
+		};
+
+		/**
+		 * Create a MultiHash object.
+		 * Hash types that aren't supported in this build are ignored.
+		 * @param hashTypes Hash types to calculate. (See HashType.)
+		 */
+		RP_LIBROMDATA_PUBLIC
+		explicit MultiHash(unsigned int hashTypes = HASH_ALL);
+
+		RP_LIBROMDATA_PUBLIC
+		~MultiHash();
+
+	private:
+		RP_DISABLE_COPY(MultiHash)
+		friend class MultiHashPrivate;
+		MultiHashPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Get the hash types supported in this build.
+		 * CRC32 is always supported. MD5 and SHA-1 require
+		 * decryption support.
+		 * @return Supported hash types. (See HashType.)
+		 */
+		RP_LIBROMDATA_PUBLIC
+		static unsigned int supportedHashTypes(void);
+
+		/**
+		 * Get the hash types being calculated by this object.
+		 * @return Hash types. (See HashType.)
+		 */
+		RP_LIBROMDATA_PUBLIC
+		unsigned int hashTypes(void) const;
+
+		/**
+		 * Reset all hashes.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		void reset(void);
+
+		/**
+		 * Add data to the hashes.
+		 * @param pData	[in] Data.
+		 * @param len	[in] Length of data.
+		 */
+		ATTR_ACCESS_SIZE(read_only, 2, 3)
+		RP_LIBROMDATA_PUBLIC
+		void update(const void *pData, size_t len);
+
+		/**
+		 * Hash the entire contents of an IDiscReader.
+		 *
+		 * The image is read once, in large chunks. Each hash is
+		 * updated on its own thread, and the next chunk is read
+		 * while the current chunk is being hashed.
+		 *
+		 * finalize() is called automatically on success.
+		 *
+		 * @param discReader	[in] IDiscReader.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int hashDiscReader(IDiscReader *discReader);
+
+		/**
+		 * Finalize the hashes.
+		 * The hash getters are only valid after calling this function.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		void finalize(void);
+
+	public:
+		/** Results **/
+
+		/**
+		 * Get the total number of bytes hashed.
+		 * @return Number of bytes hashed.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		uint64_t size(void) const;
+
+		/**
+		 * Get the CRC32.
+		 * @return CRC32.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		uint32_t crc32(void) const;
+
+		/**
+		 * Get the MD5 hash.
+		 * @return MD5 hash (16 bytes), or nullptr if not calculated.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		const uint8_t *md5(void) const;
+
+		/**
+		 * Get the SHA-1 hash.
+		 * @return SHA-1 hash (20 bytes), or nullptr if not calculated.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		const uint8_t *sha1(void) const;
+
+		/**
+		 * Get a hash as a lowercase hexadecimal string.
+		 * @param hashType Hash type. (Must be a single HashType.)
+		 * @return Hexadecimal string, or empty string if not calculated.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		std::string hexString(HashType hashType) const;
+
+	public:
+		/**
+		 * Calculate a CRC32 using the standard (zlib) polynomial.
+		 * PCLMULQDQ is used if it's supported by the CPU.
+		 * @param crc	[in] Previous CRC32. (Use 0 for the first block.)
+		 * @param pData	[in] Data.
+		 * @param len	[in] Length of data.
+		 * @return Updated CRC32.
+		 */
+		ATTR_ACCESS_SIZE(read_only, 2, 3)
+		RP_LIBROMDATA_PUBLIC
+		static uint32_t crc32(uint32_t crc, const void *pData, size_t len);
+};
+
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * MultiHashCAPI.cpp: Single-pass CRC32/MD5/SHA-1 hash calculation.        *
+ * (Win32 CryptoAPI implementation.)                                       *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "MultiHash_p.hpp"
+
+// References:
+// - https://docs.microsoft.com/en-us/windows/win32/seccrypto/example-c-program--creating-an-md-5-hash-from-file-content
+
+namespace LibRpBase {
+
+/**
+ * Initialize the MD5 and SHA-1 contexts.
+ * Hash types that can't be initialized are removed from hashTypes.
+ */
+void MultiHashPrivate::initCrypto(void)
+{
+	hProvider = 0;
+	hMD5 = 0;
+	hSHA1 = 0;
+	if (!(hashTypes & (MultiHash::HASH_MD5 | MultiHash::HASH_SHA1)))
+		return;
+
+	// Get handle to the crypto provider
+	if (!CryptAcquireContext(&hProvider, nullptr, nullptr,
+	    PROV_RSA_FULL, CRYPT_VERIFYCONTEXT | CRYPT_SILENT))
+	{
+		// Failed to get a handle to the crypto provider.
+		hProvider = 0;
+		hashTypes &= ~(MultiHash::HASH_MD5 | MultiHash::HASH_SHA1);
+		return;
+	}
+
+	// Create the MD5 and SHA-1 hash objects.
+	if ((hashTypes & MultiHash::HASH_MD5) &&
+	    !CryptCreateHash(hProvider, CALG_MD5, 0, 0, &hMD5))
+	{
+		hMD5 = 0;
+		hashTypes &= ~MultiHash::HASH_MD5;
+	}
+	if ((hashTypes & MultiHash::HASH_SHA1) &&
+	    !CryptCreateHash(hProvider, CALG_SHA1, 0, 0, &hSHA1))
+	{
+		hSHA1 = 0;
+		hashTypes &= ~MultiHash::HASH_SHA1;
+	}
+}
+
+/**
+ * Close the MD5 and SHA-1 contexts.
+ */
+void MultiHashPrivate::closeCrypto(void)
+{
+	if (hSHA1) {
+		CryptDestroyHash(hSHA1);
+		hSHA1 = 0;
+	}
+	if (hMD5) {
+		CryptDestroyHash(hMD5);
+		hMD5 = 0;
+	}
+	if (hProvider) {
+		CryptReleaseContext(hProvider, 0);
+		hProvider = 0;
+	}
+}
+
+/**
+ * Add data to the MD5 hash.
+ * @param pData	[in] Data.
+ * @param len	[in] Length of data.
+ */
+void MultiHashPrivate::updateMD5(const uint8_t *pData, size_t len)
+{
+	// NOTE: CryptHashData() takes a 32-bit length.
+	while (len > 0) {
+		const DWORD len_w = static_cast<DWORD>(std::min(len, static_cast<size_t>(1U << 30)));
+		CryptHashData(hMD5, pData, len_w, 0);
+		pData += len_w;
+		len -= len_w;
+	}
+}
+
+/**
+ * Add data to the SHA-1 hash.
+ * @param pData	[in] Data.
+ * @param len	[in] Length of data.
+ */
+void MultiHashPrivate::updateSHA1(const uint8_t *pData, size_t len)
+{
+	// NOTE: CryptHashData() takes a 32-bit length.
+	while (len > 0) {
+		const DWORD len_w = static_cast<DWORD>(std::min(len, static_cast<size_t>(1U << 30)));
+		CryptHashData(hSHA1, pData, len_w, 0);
+		pData += len_w;
+		len -= len_w;
+	}
+}
+
+/**
+ * Finalize the MD5 and SHA-1 hashes.
+ * Results are stored in md5[] and sha1[].
+ */
+void MultiHashPrivate::finalizeCrypto(void)
+{
+	if (hashTypes & MultiHash::HASH_MD5) {
+		DWORD cbHash = static_cast<DWORD>(sizeof(md5));
+		if (!CryptGetHashParam(hMD5, HP_HASHVAL, md5, &cbHash, 0) || cbHash != sizeof(md5)) {
+			hashTypes &= ~MultiHash::HASH_MD5;
+		}
+	}
+	if (hashTypes & MultiHash::HASH_SHA1) {
+		DWORD cbHash = static_cast<DWORD>(sizeof(sha1));
+		if (!CryptGetHashParam(hSHA1, HP_HASHVAL, sha1, &cbHash, 0) || cbHash != sizeof(sha1)) {
+			hashTypes &= ~MultiHash::HASH_SHA1;
+		}
+	}
+}
+
+}
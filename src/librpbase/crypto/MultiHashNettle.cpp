@@ -0,0 +1,67 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * MultiHashNettle.cpp: Single-pass CRC32/MD5/SHA-1 hash calculation.      *
+ * (Nettle implementation.)                                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "MultiHash_p.hpp"
+
+namespace LibRpBase {
+
+/**
+ * Initialize the MD5 and SHA-1 contexts.
+ * Hash types that can't be initialized are removed from hashTypes.
+ */
+void MultiHashPrivate::initCrypto(void)
+{
+	md5_init(&md5_ctx);
+	sha1_init(&sha1_ctx);
+}
+
+/**
+ * Close the MD5 and SHA-1 contexts.
+ */
+void MultiHashPrivate::closeCrypto(void)
+{
+	// Nothing to do here.
+}
+
+/**
+ * Add data to the MD5 hash.
+ * @param pData	[in] Data.
+ * @param len	[in] Length of data.
+ */
+void MultiHashPrivate::updateMD5(const uint8_t *pData, size_t len)
+{
+	md5_update(&md5_ctx, len, pData);
+}
+
+/**
+ * Add data to the SHA-1 hash.
+ * @param pData	[in] Data.
+ * @param len	[in] Length of data.
+ */
+void MultiHashPrivate::updateSHA1(const uint8_t *pData, size_t len)
+{
+	sha1_update(&sha1_ctx, len, pData);
+}
+
+/**
+ * Finalize the MD5 and SHA-1 hashes.
+ * Results are stored in md5[] and sha1[].
+ */
+void MultiHashPrivate::finalizeCrypto(void)
+{
+	if (hashTypes & MultiHash::HASH_MD5) {
+		md5_digest(&md5_ctx, sizeof(md5), md5);
+	}
+	if (hashTypes & MultiHash::HASH_SHA1) {
+		sha1_digest(&sha1_ctx, sizeof(sha1), sha1);
+	}
+}
+
+}
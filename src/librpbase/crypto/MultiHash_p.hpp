@@ -0,0 +1,108 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * MultiHash_p.hpp: Single-pass CRC32/MD5/SHA-1 hash calculation.          *
+ * (PRIVATE CLASS)                                                         *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "librpbase/config.librpbase.h"
+#include "MultiHash.hpp"
+
+// librpcpu
+#include "librpcpu/cpu_dispatch.h"
+
+#ifdef ENABLE_DECRYPTION
+#  ifdef _WIN32
+#    include "libwin32common/RpWin32_sdk.h"
+#    include <wincrypt.h>
+#  else /* !_WIN32 */
+#    include <nettle/md5.h>
+#    include <nettle/sha1.h>
+#  endif /* _WIN32 */
+#endif /* ENABLE_DECRYPTION */
+
+namespace LibRpBase {
+
+class MultiHashPrivate
+{
+	public:
+		explicit MultiHashPrivate(unsigned int hashTypes);
+		~MultiHashPrivate();
+
+	private:
+		RP_DISABLE_COPY(MultiHashPrivate)
+
+	public:
+		unsigned int hashTypes;	// HashType
+		bool finalized;
+
+		uint64_t size;
+		uint32_t crc32;
+		uint8_t md5[16];
+		uint8_t sha1[20];
+
+#ifdef ENABLE_DECRYPTION
+#  ifdef _WIN32
+		HCRYPTPROV hProvider;
+		HCRYPTHASH hMD5;
+		HCRYPTHASH hSHA1;
+#  else /* !_WIN32 */
+		struct md5_ctx md5_ctx;
+		struct sha1_ctx sha1_ctx;
+#  endif /* _WIN32 */
+#endif /* ENABLE_DECRYPTION */
+
+	public:
+		/** Cryptographic hash functions. (OS-specific) **/
+
+		/**
+		 * Initialize the MD5 and SHA-1 contexts.
+		 * Hash types that can't be initialized are removed from hashTypes.
+		 */
+		void initCrypto(void);
+
+		/**
+		 * Close the MD5 and SHA-1 contexts.
+		 */
+		void closeCrypto(void);
+
+		/**
+		 * Add data to the MD5 hash.
+		 * @param pData	[in] Data.
+		 * @param len	[in] Length of data.
+		 */
+		void updateMD5(const uint8_t *pData, size_t len);
+
+		/**
+		 * Add data to the SHA-1 hash.
+		 * @param pData	[in] Data.
+		 * @param len	[in] Length of data.
+		 */
+		void updateSHA1(const uint8_t *pData, size_t len);
+
+		/**
+		 * Finalize the MD5 and SHA-1 hashes.
+		 * Results are stored in md5[] and sha1[].
+		 */
+		void finalizeCrypto(void);
+
+	public:
+		/** CRC32 **/
+
+#if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
+		/**
+		 * Calculate a CRC32 using PCLMULQDQ.
+		 * @param crc	[in] Previous CRC32.
+		 * @param pData	[in] Data.
+		 * @param len	[in] Length of data.
+		 * @return Updated CRC32.
+		 */
+		static uint32_t crc32_pclmul(uint32_t crc, const uint8_t *pData, size_t len);
+#endif /* RP_CPU_I386 || RP_CPU_AMD64 */
+};
+
+}
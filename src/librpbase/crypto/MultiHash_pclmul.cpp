@@ -0,0 +1,99 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * MultiHash_pclmul.cpp: Single-pass CRC32/MD5/SHA-1 hash calculation.     *
+ * PCLMULQDQ-optimized CRC32.                                              *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "MultiHash_p.hpp"
+
+// SSE4.1 and PCLMULQDQ intrinsics
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+// References:
+// - "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+//   https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/fast-crc-computation-generic-polynomials-pclmulqdq-paper.pdf
+// - Linux kernel: arch/x86/crypto/crc32-pclmul_asm.S
+
+namespace LibRpBase {
+
+/**
+ * Fold a 128-bit value by the specified constants.
+ * @param x	[in] Value to fold.
+ * @param k	[in] Folding constants.
+ * @return Folded value. (XOR with the next 128 bits of data.)
+ */
+static FORCEINLINE __m128i fold_128(__m128i x, __m128i k)
+{
+	const __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+	const __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+	return _mm_xor_si128(lo, hi);
+}
+
+/**
+ * Calculate a CRC32 using PCLMULQDQ.
+ * @param crc	[in] Previous CRC32.
+ * @param pData	[in] Data. (Length must be a multiple of 16, and at least 64.)
+ * @param len	[in] Length of data.
+ * @return Updated CRC32.
+ */
+uint32_t MultiHashPrivate::crc32_pclmul(uint32_t crc, const uint8_t *pData, size_t len)
+{
+	assert(len >= 64);
+	assert(len % 16 == 0);
+
+	// Folding constants for the bit-reflected CRC32 polynomial (0x04C11DB7).
+	const __m128i k1k2 = _mm_set_epi64x(0x1c6e41596LL, 0x154442bd4LL);
+	const __m128i k3k4 = _mm_set_epi64x(0x0ccaa009eLL, 0x1751997d0LL);
+	const __m128i k5 = _mm_set_epi64x(0, 0x163cd6124LL);
+	const __m128i poly = _mm_set_epi64x(0x1f7011641LL, 0x1db710641LL);
+	const __m128i mask32 = _mm_set_epi32(0, 0, 0, -1);
+
+	const __m128i *src = reinterpret_cast<const __m128i*>(pData);
+
+	// zlib's CRC32 is inverted on input and output.
+	__m128i x0 = _mm_xor_si128(_mm_loadu_si128(&src[0]), _mm_cvtsi32_si128(static_cast<int>(~crc)));
+	__m128i x1 = _mm_loadu_si128(&src[1]);
+	__m128i x2 = _mm_loadu_si128(&src[2]);
+	__m128i x3 = _mm_loadu_si128(&src[3]);
+	src += 4;
+	len -= 64;
+
+	// Fold 64 bytes at a time.
+	for (; len >= 64; len -= 64, src += 4) {
+		x0 = _mm_xor_si128(fold_128(x0, k1k2), _mm_loadu_si128(&src[0]));
+		x1 = _mm_xor_si128(fold_128(x1, k1k2), _mm_loadu_si128(&src[1]));
+		x2 = _mm_xor_si128(fold_128(x2, k1k2), _mm_loadu_si128(&src[2]));
+		x3 = _mm_xor_si128(fold_128(x3, k1k2), _mm_loadu_si128(&src[3]));
+	}
+
+	// Fold the four accumulators into one.
+	x0 = _mm_xor_si128(fold_128(x0, k3k4), x1);
+	x0 = _mm_xor_si128(fold_128(x0, k3k4), x2);
+	x0 = _mm_xor_si128(fold_128(x0, k3k4), x3);
+
+	// Fold 16 bytes at a time.
+	for (; len >= 16; len -= 16, src++) {
+		x0 = _mm_xor_si128(fold_128(x0, k3k4), _mm_loadu_si128(src));
+	}
+
+	// Fold 128 bits down to 64 bits.
+	x0 = _mm_xor_si128(_mm_srli_si128(x0, 8), _mm_clmulepi64_si128(k3k4, x0, 0x01));
+
+	// Fold 64 bits down to 32 bits.
+	x0 = _mm_xor_si128(_mm_srli_si128(x0, 4),
+		_mm_clmulepi64_si128(_mm_and_si128(x0, mask32), k5, 0x00));
+
+	// Barrett reduction.
+	__m128i t = _mm_clmulepi64_si128(_mm_and_si128(x0, mask32), poly, 0x10);
+	t = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), poly, 0x00);
+	x0 = _mm_xor_si128(x0, t);
+
+	return ~static_cast<uint32_t>(_mm_extract_epi32(x0, 1));
+}
+
+}
@@ -178,4 +178,27 @@ off64_t DiscReader::size(void)
 	return m_length;
 }
 
+/** Direct file access **/
+
+/**
+ * Get the underlying file for a range of the disc image.
+ * @param pos		[in] Starting position in the disc image
+ * @param size		[in] Size of the range, in bytes
+ * @param pFilePos	[out] Starting position in the underlying file
+ * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+ */
+IRpFile *DiscReader::getFileRange(off64_t pos, off64_t size, off64_t *pFilePos)
+{
+	assert(pFilePos != nullptr);
+	if (!m_file || !pFilePos || pos < 0 || size < 0 ||
+	    pos > m_length || size > m_length - pos)
+	{
+		return nullptr;
+	}
+
+	// DiscReader reads the file as-is.
+	*pFilePos = m_offset + pos;
+	return m_file;
+}
+
 }
@@ -23,6 +23,7 @@ class DiscReader final : public IDiscReader
 		 * unref()'d by the caller afterwards.
 		 * @param file File to read from.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		explicit DiscReader(LibRpFile::IRpFile *file);
 
 		/**
@@ -33,6 +34,7 @@ class DiscReader final : public IDiscReader
 		 * @param offset Starting offset.
 		 * @param length Disc length. (-1 for "until end of file")
 		 */
+		RP_LIBROMDATA_PUBLIC
 		explicit DiscReader(LibRpFile::IRpFile *file, off64_t offset, off64_t length);
 	protected:
 		~DiscReader() final { };	// call unref() instead
@@ -89,6 +91,18 @@ class DiscReader final : public IDiscReader
 		 */
 		off64_t size(void) override;
 
+	public:
+		/** Direct file access **/
+
+		/**
+		 * Get the underlying file for a range of the disc image.
+		 * @param pos		[in] Starting position in the disc image
+		 * @param size		[in] Size of the range, in bytes
+		 * @param pFilePos	[out] Starting position in the underlying file
+		 * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+		 */
+		LibRpFile::IRpFile *getFileRange(off64_t pos, off64_t size, off64_t *pFilePos) final;
+
 	protected:
 		// Offset/length. Useful for e.g. GameCube TGC.
 		off64_t m_offset;
@@ -2,7 +2,7 @@
  * ROM Properties Page shell extension. (librpbase)                        *
  * IDiscReader.cpp: Disc reader interface.                                 *
  *                                                                         *
- * Copyright (c) 2016-2022 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -90,6 +90,27 @@ int IDiscReader::seek_cur(off64_t offset)
 	return this->seek(pos + offset);
 }
 
+/** Direct file access **/
+
+/**
+ * Get the underlying file for a range of the disc image.
+ * This only works if the range is stored as-is in the file,
+ * i.e. it isn't compressed or encrypted, so it can be copied
+ * directly from the file.
+ * @param pos		[in] Starting position in the disc image
+ * @param size		[in] Size of the range, in bytes
+ * @param pFilePos	[out] Starting position in the underlying file
+ * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+ */
+IRpFile *IDiscReader::getFileRange(off64_t pos, off64_t size, off64_t *pFilePos)
+{
+	// Not supported by default.
+	RP_UNUSED(pos);
+	RP_UNUSED(size);
+	RP_UNUSED(pFilePos);
+	return nullptr;
+}
+
 /** Device file functions **/
 
 /**
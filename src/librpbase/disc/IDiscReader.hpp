@@ -134,6 +134,21 @@ class IDiscReader : public RefBase
 		 */
 		int seek_cur(off64_t offset);
 
+	public:
+		/** Direct file access **/
+
+		/**
+		 * Get the underlying file for a range of the disc image.
+		 * This only works if the range is stored as-is in the file,
+		 * i.e. it isn't compressed or encrypted, so it can be copied
+		 * directly from the file.
+		 * @param pos		[in] Starting position in the disc image
+		 * @param size		[in] Size of the range, in bytes
+		 * @param pFilePos	[out] Starting position in the underlying file
+		 * @return Underlying file (not ref()'d), or nullptr if the range isn't stored as-is.
+		 */
+		virtual LibRpFile::IRpFile *getFileRange(off64_t pos, off64_t size, off64_t *pFilePos);
+
 	public:
 		/** Device file functions **/
 
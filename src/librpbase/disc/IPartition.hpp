@@ -12,6 +12,8 @@
 
 namespace LibRpBase {
 
+class IFst;
+
 class IPartition : public IDiscReader
 {
 	protected:
@@ -58,6 +60,18 @@ class IPartition : public IDiscReader
 		 * @return Used partition size, or -1 on error.
 		 */
 		virtual off64_t partition_size_used(void) const = 0;
+
+	public:
+		/** File system **/
+
+		/**
+		 * Get the partition's file system table.
+		 * @return IFst (owned by this partition), or nullptr if this partition doesn't have one.
+		 */
+		virtual IFst *fst(void)
+		{
+			return nullptr;
+		}
 };
 
 /**
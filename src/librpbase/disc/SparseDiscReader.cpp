@@ -3,7 +3,7 @@
  * SparseDiscReader.cpp: Disc reader base class for disc image formats     *
  * that use sparse and/or compressed blocks, e.g. CISO, WBFS, GCZ.         *
  *                                                                         *
- * Copyright (c) 2016-2020 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -104,17 +104,21 @@ size_t SparseDiscReader::read(void *ptr, size_t size)
 	}
 
 	// Read entire blocks.
-	for (; size >= block_size;
-	    size -= block_size, ptr8 += block_size,
-	    ret += block_size, d->pos += block_size)
-	{
+	if (size >= block_size) {
 		assert(d->pos % block_size == 0);
 		const unsigned int blockIdx = static_cast<unsigned int>(d->pos / block_size);
-		int rd = this->readBlock(blockIdx, 0, ptr8, block_size);
-		if (rd < 0 || rd != static_cast<int>(block_size)) {
+		const uint32_t blockCount = static_cast<uint32_t>(size / block_size);
+		const size_t full_sz = static_cast<size_t>(blockCount) * block_size;
+		const size_t rd = this->readBlocks(blockIdx, ptr8, blockCount);
+		ret += rd;
+		d->pos += rd;
+		if (rd != full_sz) {
 			// Error reading the data.
-			return ret + (rd > 0 ? rd : 0);
+			return ret;
 		}
+
+		size -= full_sz;
+		ptr8 += full_sz;
 	}
 
 	// Check if we still have data left. (not a full block)
@@ -263,4 +267,101 @@ int SparseDiscReader::readBlock(uint32_t blockIdx, int pos, void *ptr, size_t si
 	return (sz_read > 0 ? (int)sz_read : -1);
 }
 
+/**
+ * Read multiple consecutive full blocks.
+ *
+ * The default implementation uses getPhysBlockAddr() to find
+ * runs of physically contiguous blocks and runs of empty blocks,
+ * and handles each run with a single read or memset().
+ *
+ * Subclasses that override readBlock() must override this function
+ * too, e.g. by calling readBlocksIndividually().
+ *
+ * @param blockIdx	[in] First block index.
+ * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+ * @param blockCount	[in] Number of blocks to read.
+ * @return Number of bytes read.
+ */
+size_t SparseDiscReader::readBlocks(uint32_t blockIdx, void *ptr, uint32_t blockCount)
+{
+	// NOTE: This can only be called by SparseDiscReader,
+	// so the main assertions are already checked there.
+	RP_D(SparseDiscReader);
+	const size_t block_size = d->block_size;
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+
+	while (blockCount > 0) {
+		const off64_t physBlockAddr = getPhysBlockAddr(blockIdx);
+		assert(physBlockAddr >= 0);
+		if (physBlockAddr < 0) {
+			// Out of range.
+			break;
+		}
+
+		// Find the end of the run.
+		// - Empty blocks: Run of empty blocks.
+		// - Data blocks: Run of physically contiguous blocks.
+		uint32_t runCount = 1;
+		if (physBlockAddr == 0) {
+			while (runCount < blockCount && getPhysBlockAddr(blockIdx + runCount) == 0) {
+				runCount++;
+			}
+		} else {
+			off64_t nextAddr = physBlockAddr + static_cast<off64_t>(block_size);
+			while (runCount < blockCount && getPhysBlockAddr(blockIdx + runCount) == nextAddr) {
+				runCount++;
+				nextAddr += block_size;
+			}
+		}
+
+		const size_t run_sz = static_cast<size_t>(runCount) * block_size;
+		if (physBlockAddr == 0) {
+			// Empty blocks.
+			memset(ptr8, 0, run_sz);
+		} else {
+			// Read the entire run at once.
+			const size_t sz_read = m_file->seekAndRead(physBlockAddr, ptr8, run_sz);
+			if (sz_read != run_sz) {
+				// Short read.
+				m_lastError = m_file->lastError();
+				ret += sz_read;
+				break;
+			}
+		}
+
+		blockIdx += runCount;
+		blockCount -= runCount;
+		ptr8 += run_sz;
+		ret += run_sz;
+	}
+
+	return ret;
+}
+
+/**
+ * Read multiple consecutive full blocks by calling readBlock() for each block.
+ * @param blockIdx	[in] First block index.
+ * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+ * @param blockCount	[in] Number of blocks to read.
+ * @return Number of bytes read.
+ */
+size_t SparseDiscReader::readBlocksIndividually(uint32_t blockIdx, void *ptr, uint32_t blockCount)
+{
+	RP_D(SparseDiscReader);
+	const unsigned int block_size = d->block_size;
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+
+	for (; blockCount > 0; blockCount--, blockIdx++, ptr8 += block_size, ret += block_size) {
+		int rd = this->readBlock(blockIdx, 0, ptr8, block_size);
+		if (rd < 0 || rd != static_cast<int>(block_size)) {
+			// Error reading the data.
+			return ret + (rd > 0 ? rd : 0);
+		}
+	}
+
+	return ret;
+}
+
 }
@@ -37,6 +37,7 @@ class SparseDiscReader : public IDiscReader
 		 * @param size Amount of data to read, in bytes.
 		 * @return Number of bytes read.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		ATTR_ACCESS_SIZE(write_only, 2, 3)
 		size_t read(void *ptr, size_t size) final;
 
@@ -45,18 +46,21 @@ class SparseDiscReader : public IDiscReader
 		 * @param pos disc image position.
 		 * @return 0 on success; -1 on error.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		int seek(off64_t pos) final;
 
 		/**
 		 * Get the disc image position.
 		 * @return Disc image position on success; -1 on error.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		off64_t tell(void) final;
 
 		/**
 		 * Get the disc image size.
 		 * @return Disc image size, or -1 on error.
 		 */
+		RP_LIBROMDATA_PUBLIC
 		off64_t size(void) final;
 
 	protected:
@@ -93,6 +97,32 @@ class SparseDiscReader : public IDiscReader
 		 */
 		ATTR_ACCESS_SIZE(write_only, 4, 5)
 		virtual int readBlock(uint32_t blockIdx, int pos, void *ptr, size_t size);
+
+		/**
+		 * Read multiple consecutive full blocks.
+		 *
+		 * The default implementation uses getPhysBlockAddr() to find
+		 * runs of physically contiguous blocks and runs of empty blocks,
+		 * and handles each run with a single read or memset().
+		 *
+		 * Subclasses that override readBlock() must override this function
+		 * too, e.g. by calling readBlocksIndividually().
+		 *
+		 * @param blockIdx	[in] First block index.
+		 * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+		 * @param blockCount	[in] Number of blocks to read.
+		 * @return Number of bytes read.
+		 */
+		virtual size_t readBlocks(uint32_t blockIdx, void *ptr, uint32_t blockCount);
+
+		/**
+		 * Read multiple consecutive full blocks by calling readBlock() for each block.
+		 * @param blockIdx	[in] First block index.
+		 * @param ptr		[out] Output data buffer. (Must be at least blockCount * block_size bytes!)
+		 * @param blockCount	[in] Number of blocks to read.
+		 * @return Number of bytes read.
+		 */
+		size_t readBlocksIndividually(uint32_t blockIdx, void *ptr, uint32_t blockCount);
 };
 
 }
@@ -15,6 +15,7 @@
 #include <stdint.h>
 
 // C includes. (C++ namespace)
+#include <cassert>
 #include <cstring>
 
 // C++ includes.
@@ -25,6 +26,9 @@
 // librptexture
 #include "librptexture/img/rp_image.hpp"
 
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+
 namespace LibRpBase {
 
 struct IconAnimData : public RefBase
@@ -60,7 +64,15 @@ struct IconAnimData : public RefBase
 	// the previous frame should be used.
 	// NOTE 2: Frames stored here must be ref()'d.
 	// They will be automatically unref()'d in the destructor.
-	std::array<LibRpTexture::rp_image*, MAX_FRAMES> frames;
+	// NOTE 3: Use frame() to access frames. Frames that
+	// haven't been decoded yet are nullptr here.
+	mutable std::array<LibRpTexture::rp_image*, MAX_FRAMES> frames;
+
+	// Frames that haven't been decoded yet.
+	// Subclasses that implement decodeFrame() should set these
+	// instead of decoding all frames in advance. frame() will
+	// decode the frame on first access.
+	mutable std::array<bool, MAX_FRAMES> frame_pending;
 
 	IconAnimData()
 		: count(0)
@@ -68,6 +80,7 @@ struct IconAnimData : public RefBase
 	{
 		seq_index.fill(0);
 		frames.fill(0);
+		frame_pending.fill(false);
 
 		// MSVC 2010 doesn't support initializer lists,
 		// so create a dummy struct.
@@ -83,9 +96,44 @@ protected:
 		}
 	}
 
+	/**
+	 * Decode a frame.
+	 * This is called by frame() on first access if frame_pending[idx] is set.
+	 * frameMutex is locked while this function is running, so use
+	 * frame_locked() instead of frame() to access other frames.
+	 * @param idx Frame index
+	 * @return Decoded frame (ref()'d), or nullptr on error.
+	 */
+	virtual LibRpTexture::rp_image *decodeFrame(int idx) const
+	{
+		RP_UNUSED(idx);
+		return nullptr;
+	}
+
+	/**
+	 * Get a frame, decoding it if it hasn't been decoded yet.
+	 * frameMutex must be locked by the caller.
+	 * @param idx Frame index
+	 * @return Frame, or nullptr if the previous frame should be used.
+	 */
+	const LibRpTexture::rp_image *frame_locked(int idx) const
+	{
+		assert(idx >= 0 && idx < MAX_FRAMES);
+		if (unlikely(frame_pending[idx])) {
+			frame_pending[idx] = false;
+			frames[idx] = decodeFrame(idx);
+		}
+		return frames[idx];
+	}
+
 private:
 	RP_DISABLE_COPY(IconAnimData);
 
+	// Protects frames[] and frame_pending[] while frames are being decoded.
+	// Frames may be accessed from the UI thread's animation timer while
+	// a RomDataLoader or thumbnailer thread is accessing the same object.
+	mutable LibRpThreads::Mutex frameMutex;
+
 public:
 	inline IconAnimData *ref(void)
 	{
@@ -105,6 +153,18 @@ public:
 	{
 		const_cast<IconAnimData*>(this)->RefBase::unref();
 	}
+
+	/**
+	 * Get a frame, decoding it if it hasn't been decoded yet.
+	 * This function is thread-safe.
+	 * @param idx Frame index
+	 * @return Frame, or nullptr if the previous frame should be used.
+	 */
+	const LibRpTexture::rp_image *frame(int idx) const
+	{
+		LibRpThreads::MutexLocker locker(frameMutex);
+		return frame_locked(idx);
+	}
 };
 
 }
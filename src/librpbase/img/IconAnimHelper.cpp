@@ -75,8 +75,8 @@ int IconAnimHelper::nextFrame(int *pDelay)
 	}
 
 	// Check if this frame is valid.
-	if (m_iconAnimData->frames[m_frame] != nullptr &&
-	    m_iconAnimData->frames[m_frame]->isValid())
+	if (m_iconAnimData->frame(m_frame) != nullptr &&
+	    m_iconAnimData->frame(m_frame)->isValid())
 	{
 		// Frame is valid.
 		m_last_valid_frame = m_frame;
@@ -71,6 +71,10 @@ using LibRpTexture::argb32_t;
 # define PNG_Z_DEFAULT_COMPRESSION (-1)
 #endif
 
+// librpthreads
+#include "librpthreads/ThreadPool.hpp"
+using LibRpThreads::ThreadPool;
+
 // C includes. (C++ namespace)
 #include <csetjmp>
 
@@ -116,18 +120,24 @@ class RpPngWriterPrivate
 		RpPngWriterPrivate(IRpFile *file, int width, int height, rp_image::Format format)
 			: lastError(0), file(nullptr), imageTag(ImageTag::Invalid)
 			, png_ptr(nullptr), info_ptr(nullptr), IHDR_written(false)
+			, IEND_written(false), text_after_IHDR(false)
+			, profile(getDefaultProfile())
 		{
 			init(file, width, height, format);
 		}
 		RpPngWriterPrivate(IRpFile *file, const rp_image *img)
 			: lastError(0), file(nullptr), imageTag(ImageTag::Invalid)
 			, png_ptr(nullptr), info_ptr(nullptr), IHDR_written(false)
+			, IEND_written(false), text_after_IHDR(false)
+			, profile(getDefaultProfile())
 		{
 			init(file, img);
 		}
 		RpPngWriterPrivate(IRpFile *file, const IconAnimData *iconAnimData)
 			: lastError(0), file(nullptr), imageTag(ImageTag::Invalid)
 			, png_ptr(nullptr), info_ptr(nullptr), IHDR_written(false)
+			, IEND_written(false), text_after_IHDR(false)
+			, profile(getDefaultProfile())
 		{
 			init(file, iconAnimData);
 		}
@@ -135,6 +145,8 @@ class RpPngWriterPrivate
 		RpPngWriterPrivate(const char *filename, int width, int height, rp_image::Format format)
 			: lastError(0), file(nullptr), imageTag(ImageTag::Invalid)
 			, png_ptr(nullptr), info_ptr(nullptr), IHDR_written(false)
+			, IEND_written(false), text_after_IHDR(false)
+			, profile(getDefaultProfile())
 		{
 			RpFile *const file = (filename ? new RpFile(filename, RpFile::FM_CREATE_WRITE) : nullptr);
 			init(file, width, height, format);
@@ -143,6 +155,8 @@ class RpPngWriterPrivate
 		RpPngWriterPrivate(const char *filename, const rp_image *img)
 			: lastError(0), file(nullptr), imageTag(ImageTag::Invalid)
 			, png_ptr(nullptr), info_ptr(nullptr), IHDR_written(false)
+			, IEND_written(false), text_after_IHDR(false)
+			, profile(getDefaultProfile())
 		{
 			RpFile *const file = (filename ? new RpFile(filename, RpFile::FM_CREATE_WRITE) : nullptr);
 			init(file, img);
@@ -151,6 +165,8 @@ class RpPngWriterPrivate
 		RpPngWriterPrivate(const char *filename, const IconAnimData *iconAnimData)
 			: lastError(0), file(nullptr), imageTag(ImageTag::Invalid)
 			, png_ptr(nullptr), info_ptr(nullptr), IHDR_written(false)
+			, IEND_written(false), text_after_IHDR(false)
+			, profile(getDefaultProfile())
 		{
 			RpFile *const file = (filename ? new RpFile(filename, RpFile::FM_CREATE_WRITE) : nullptr);
 			init(file, iconAnimData);
@@ -273,6 +289,40 @@ class RpPngWriterPrivate
 
 		// Current state.
 		bool IHDR_written;
+		bool IEND_written;	// Set by write_IDAT_parallel()
+		bool text_after_IHDR;	// write_tEXt() was called after write_IHDR()
+
+		// Compression profile.
+		Config::PngProfile profile;
+
+		// Default compression profile. (overrides Config if set)
+		static bool hasDefaultProfile;
+		static Config::PngProfile defaultProfile;
+
+		/**
+		 * Get the default compression profile for new RpPngWriter objects.
+		 * @return Default compression profile
+		 */
+		static Config::PngProfile getDefaultProfile(void)
+		{
+			if (hasDefaultProfile) {
+				return defaultProfile;
+			}
+			return Config::instance()->pngProfile();
+		}
+
+		// Minimum amount of image data for write_IDAT_parallel().
+		// Smaller images, e.g. most thumbnails, aren't worth
+		// the threading overhead.
+		static const size_t PARALLEL_IDAT_MIN_SIZE = 512U * 1024U;
+
+		// Approximate amount of filtered image data per band
+		// in write_IDAT_parallel().
+		static const size_t PARALLEL_IDAT_BAND_SIZE = 256U * 1024U;
+
+		// Number of row groups for filtering in write_IDAT_parallel().
+		// Each group has its own scratch row for adaptive filtering.
+		static const int PARALLEL_FILTER_GROUPS = 64;
 
 	public:
 		/**
@@ -348,10 +398,69 @@ class RpPngWriterPrivate
 		 * @return 0 on success; negative POSIX error code on error.
 		 */
 		int write_IDAT_APNG(void);
+
+		/**
+		 * Filter a row of image data, which was converted using convert_row().
+		 * @param dest		[out] Destination buffer. (rowbytes+1 bytes; first byte is the filter type)
+		 * @param cur		[in] Current row, converted to PNG format.
+		 * @param prev		[in] Previous row, converted to PNG format. (nullptr for the first row)
+		 * @param tmp		[in] Scratch buffer for adaptive filtering. (rowbytes bytes)
+		 * @param rowbytes	[in] Bytes per row.
+		 * @param bpp		[in] Bytes per pixel.
+		 */
+		void filter_row(uint8_t *dest, const uint8_t *cur, const uint8_t *prev, uint8_t *tmp, size_t rowbytes, unsigned int bpp) const;
+
+		/**
+		 * Convert a row of image data to PNG format.
+		 * @param dest		[out] Destination buffer.
+		 * @param src		[in] Source row.
+		 * @param is_abgr	[in] If true, image data is ABGR instead of ARGB.
+		 */
+		void convert_row(uint8_t *dest, const uint8_t *src, bool is_abgr) const;
+
+		/**
+		 * Write a PNG chunk.
+		 * This function uses setjmp(), so it can't have any C++ objects.
+		 * @param chunk_name	[in] Chunk name.
+		 * @param data1		[in] First data segment.
+		 * @param len1		[in] Size of data1.
+		 * @param data2		[in,opt] Second data segment.
+		 * @param len2		[in,opt] Size of data2.
+		 * @param data3		[in,opt] Third data segment.
+		 * @param len3		[in,opt] Size of data3.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int write_chunk(const char *chunk_name,
+			const uint8_t *data1, size_t len1,
+			const uint8_t *data2 = nullptr, size_t len2 = 0,
+			const uint8_t *data3 = nullptr, size_t len3 = 0);
+
+		/**
+		 * Write raw image data to the PNG image using multiple threads.
+		 *
+		 * The image is split into bands of rows, which are filtered and
+		 * deflated independently, similar to pigz. Each band except the
+		 * last one ends with Z_SYNC_FLUSH, so the compressed bands can be
+		 * concatenated into a single zlib stream. The last 32 KB of the
+		 * previous band is used as the dictionary to minimize the size
+		 * penalty.
+		 *
+		 * This writes the IDAT and IEND chunks, so png_write_end()
+		 * must not be called afterwards.
+		 *
+		 * @param row_pointers PNG row pointers. Array must have cache.height elements.
+		 * @param is_abgr If true, image data is ABGR instead of ARGB.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int write_IDAT_parallel(const png_byte *const *row_pointers, bool is_abgr);
 };
 
 /** RpPngWriterPrivate **/
 
+// Default compression profile. (overrides Config if set)
+bool RpPngWriterPrivate::hasDefaultProfile = false;
+Config::PngProfile RpPngWriterPrivate::defaultProfile = Config::PngProfile::Default;
+
 void RpPngWriterPrivate::init(IRpFile *file, int width, int height, rp_image::Format format)
 {
 	this->img = nullptr;
@@ -539,7 +648,7 @@ void RpPngWriterPrivate::init(IRpFile *file, const IconAnimData *iconAnimData)
 	if (imageTag == ImageTag::IconAnimData) {
 		this->iconAnimData = iconAnimData;
 		// Cache the image parameters.
-		const rp_image *const img0 = iconAnimData->frames[iconAnimData->seq_index[0]];
+		const rp_image *const img0 = iconAnimData->frame(iconAnimData->seq_index[0]);
 		assert(img0 != nullptr);
 		if (unlikely(!img0)) {
 			// Invalid animated image.
@@ -548,7 +657,7 @@ void RpPngWriterPrivate::init(IRpFile *file, const IconAnimData *iconAnimData)
 		}
 		cache.setFrom(img0);
 	} else {
-		this->img = iconAnimData->frames[iconAnimData->seq_index[0]];
+		this->img = iconAnimData->frame(iconAnimData->seq_index[0]);
 		cache.setFrom(img);
 	}
 
@@ -614,7 +723,7 @@ void RpPngWriterPrivate::close(void)
 			// TODO: unlink()?
 		} else
 #endif /* PNG_SETJMP_SUPPORTED */
-		{
+		if (!IEND_written) {
 			// Attempt to finish writing the PNG file.
 			png_write_end(png_ptr, info_ptr);
 		}
@@ -741,6 +850,16 @@ int RpPngWriterPrivate::write_IDAT(const png_byte *const *row_pointers, bool is_
 		return -lastError;
 	}
 
+	// Use the multi-threaded encoder for large images if possible.
+	// NOTE: Text chunks added after IHDR are written by png_write_end(),
+	// so the multi-threaded encoder can't be used in that case.
+	if (!text_after_IHDR && ThreadPool::instance()->workerCount() > 0) {
+		const size_t bpp = (cache.format == rp_image::Format::CI8 ? 1 : (cache.skip_alpha ? 3 : 4));
+		if (static_cast<size_t>(cache.width) * static_cast<size_t>(cache.height) * bpp >= PARALLEL_IDAT_MIN_SIZE) {
+			return write_IDAT_parallel(row_pointers, is_abgr);
+		}
+	}
+
 #ifdef PNG_SETJMP_SUPPORTED
 	// WARNING: Do NOT initialize any C++ objects past this point!
 	if (setjmp(png_jmpbuf(png_ptr))) {
@@ -781,6 +900,365 @@ int RpPngWriterPrivate::write_IDAT(const png_byte *const *row_pointers, bool is_
 	return 0;
 }
 
+/**
+ * Convert a row of image data to PNG format.
+ * @param dest		[out] Destination buffer.
+ * @param src		[in] Source row.
+ * @param is_abgr	[in] If true, image data is ABGR instead of ARGB.
+ */
+void RpPngWriterPrivate::convert_row(uint8_t *dest, const uint8_t *src, bool is_abgr) const
+{
+	if (cache.format == rp_image::Format::CI8) {
+		// CI8 is written as-is.
+		memcpy(dest, src, cache.width);
+		return;
+	}
+
+	// ARGB32: Convert to RGBA or RGB.
+	const argb32_t *px = reinterpret_cast<const argb32_t*>(src);
+	const argb32_t *const px_end = px + cache.width;
+	if (cache.skip_alpha) {
+		for (; px != px_end; px++, dest += 3) {
+			dest[0] = (is_abgr ? px->b : px->r);
+			dest[1] = px->g;
+			dest[2] = (is_abgr ? px->r : px->b);
+		}
+	} else {
+		for (; px != px_end; px++, dest += 4) {
+			dest[0] = (is_abgr ? px->b : px->r);
+			dest[1] = px->g;
+			dest[2] = (is_abgr ? px->r : px->b);
+			dest[3] = px->a;
+		}
+	}
+}
+
+/**
+ * Paeth predictor.
+ * @param a Left
+ * @param b Above
+ * @param c Upper left
+ * @return Predicted value
+ */
+static inline uint8_t paeth_predictor(uint8_t a, uint8_t b, uint8_t c)
+{
+	const int p = (int)a + (int)b - (int)c;
+	const int pa = abs(p - (int)a);
+	const int pb = abs(p - (int)b);
+	const int pc = abs(p - (int)c);
+	if (pa <= pb && pa <= pc) {
+		return a;
+	} else if (pb <= pc) {
+		return b;
+	}
+	return c;
+}
+
+/**
+ * Filter a row using the specified PNG filter type.
+ * @param dest		[out] Destination buffer. (rowbytes bytes)
+ * @param cur		[in] Current row.
+ * @param prev		[in] Previous row. (nullptr for the first row)
+ * @param rowbytes	[in] Bytes per row.
+ * @param bpp		[in] Bytes per pixel.
+ * @param filter	[in] PNG filter type. (PNG_FILTER_VALUE_*)
+ * @return Sum of absolute values of the filtered bytes, interpreted as signed.
+ */
+static unsigned int filter_row_type(uint8_t *dest, const uint8_t *cur, const uint8_t *prev,
+	size_t rowbytes, unsigned int bpp, int filter)
+{
+	unsigned int sum = 0;
+	for (size_t i = 0; i < rowbytes; i++) {
+		const uint8_t a = (i >= bpp ? cur[i - bpp] : 0);
+		const uint8_t b = (prev ? prev[i] : 0);
+		const uint8_t c = (prev && i >= bpp ? prev[i - bpp] : 0);
+
+		uint8_t pred;
+		switch (filter) {
+			default:
+			case PNG_FILTER_VALUE_NONE:
+				pred = 0;
+				break;
+			case PNG_FILTER_VALUE_SUB:
+				pred = a;
+				break;
+			case PNG_FILTER_VALUE_UP:
+				pred = b;
+				break;
+			case PNG_FILTER_VALUE_AVG:
+				pred = static_cast<uint8_t>(((unsigned int)a + (unsigned int)b) / 2);
+				break;
+			case PNG_FILTER_VALUE_PAETH:
+				pred = paeth_predictor(a, b, c);
+				break;
+		}
+
+		const uint8_t val = static_cast<uint8_t>(cur[i] - pred);
+		dest[i] = val;
+		sum += abs(static_cast<int8_t>(val));
+	}
+	return sum;
+}
+
+/**
+ * Filter a row of image data, which was converted using convert_row().
+ * @param dest		[out] Destination buffer. (rowbytes+1 bytes; first byte is the filter type)
+ * @param cur		[in] Current row, converted to PNG format.
+ * @param prev		[in] Previous row, converted to PNG format. (nullptr for the first row)
+ * @param tmp		[in] Scratch buffer for adaptive filtering. (rowbytes bytes)
+ * @param rowbytes	[in] Bytes per row.
+ * @param bpp		[in] Bytes per pixel.
+ */
+void RpPngWriterPrivate::filter_row(uint8_t *dest, const uint8_t *cur, const uint8_t *prev, uint8_t *tmp, size_t rowbytes, unsigned int bpp) const
+{
+	// NOTE: Same filter selection as write_IHDR().
+	// CI8 images are never filtered.
+	int filter = PNG_FILTER_VALUE_NONE;
+	if (cache.format != rp_image::Format::CI8) {
+		switch (profile) {
+			default:
+			case Config::PngProfile::Default:
+				filter = PNG_FILTER_VALUE_NONE;
+				break;
+			case Config::PngProfile::Fast:
+				filter = PNG_FILTER_VALUE_SUB;
+				break;
+			case Config::PngProfile::Small: {
+				// Adaptive filtering: Use the filter with the
+				// lowest sum of absolute differences.
+				// NOTE: The current best row is kept in dest.
+				unsigned int best_sum = filter_row_type(&dest[1], cur, prev, rowbytes, bpp, PNG_FILTER_VALUE_NONE);
+				int best_filter = PNG_FILTER_VALUE_NONE;
+				for (int f = PNG_FILTER_VALUE_SUB; f <= PNG_FILTER_VALUE_PAETH; f++) {
+					const unsigned int sum = filter_row_type(tmp, cur, prev, rowbytes, bpp, f);
+					if (sum < best_sum) {
+						best_sum = sum;
+						best_filter = f;
+						memcpy(&dest[1], tmp, rowbytes);
+					}
+				}
+				dest[0] = static_cast<uint8_t>(best_filter);
+				return;
+			}
+		}
+	}
+
+	dest[0] = static_cast<uint8_t>(filter);
+	filter_row_type(&dest[1], cur, prev, rowbytes, bpp, filter);
+}
+
+/**
+ * Write a PNG chunk.
+ * This function uses setjmp(), so it can't have any C++ objects.
+ * @param chunk_name	[in] Chunk name.
+ * @param data1		[in] First data segment.
+ * @param len1		[in] Size of data1.
+ * @param data2		[in,opt] Second data segment.
+ * @param len2		[in,opt] Size of data2.
+ * @param data3		[in,opt] Third data segment.
+ * @param len3		[in,opt] Size of data3.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RpPngWriterPrivate::write_chunk(const char *chunk_name,
+	const uint8_t *data1, size_t len1,
+	const uint8_t *data2, size_t len2,
+	const uint8_t *data3, size_t len3)
+{
+#ifdef PNG_SETJMP_SUPPORTED
+	// WARNING: Do NOT initialize any C++ objects past this point!
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		// PNG write failed.
+		lastError = EIO;
+		return -lastError;
+	}
+#endif /* PNG_SETJMP_SUPPORTED */
+
+	png_write_chunk_start(png_ptr, PNG_CONST_CAST(png_bytep)(reinterpret_cast<const png_byte*>(chunk_name)),
+		static_cast<png_uint_32>(len1 + len2 + len3));
+	if (len1 > 0) {
+		png_write_chunk_data(png_ptr, PNG_CONST_CAST(png_bytep)(data1), len1);
+	}
+	if (len2 > 0) {
+		png_write_chunk_data(png_ptr, PNG_CONST_CAST(png_bytep)(data2), len2);
+	}
+	if (len3 > 0) {
+		png_write_chunk_data(png_ptr, PNG_CONST_CAST(png_bytep)(data3), len3);
+	}
+	png_write_chunk_end(png_ptr);
+	return 0;
+}
+
+/**
+ * Write raw image data to the PNG image using multiple threads.
+ *
+ * The image is split into bands of rows, which are filtered and
+ * deflated independently, similar to pigz. Each band except the
+ * last one ends with Z_SYNC_FLUSH, so the compressed bands can be
+ * concatenated into a single zlib stream. The last 32 KB of the
+ * previous band is used as the dictionary to minimize the size
+ * penalty.
+ *
+ * This writes the IDAT and IEND chunks, so png_write_end()
+ * must not be called afterwards.
+ *
+ * @param row_pointers PNG row pointers. Array must have cache.height elements.
+ * @param is_abgr If true, image data is ABGR instead of ARGB.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RpPngWriterPrivate::write_IDAT_parallel(const png_byte *const *row_pointers, bool is_abgr)
+{
+	const int height = cache.height;
+	const unsigned int bpp = (cache.format == rp_image::Format::CI8 ? 1 : (cache.skip_alpha ? 3 : 4));
+	const size_t rowbytes = static_cast<size_t>(cache.width) * bpp;
+	const size_t filt_stride = rowbytes + 1;
+
+	// Compression level.
+	int level;
+	switch (profile) {
+		default:
+		case Config::PngProfile::Default:
+			level = Z_DEFAULT_COMPRESSION;
+			break;
+		case Config::PngProfile::Fast:
+			level = 1;
+			break;
+		case Config::PngProfile::Small:
+			level = 9;
+			break;
+	}
+
+	// Convert the image data to PNG format.
+	unique_ptr<uint8_t[]> conv(new uint8_t[rowbytes * height]);
+	LibRpThreads::parallel_for(0, height, [&](int y) {
+		convert_row(&conv[rowbytes * y], row_pointers[y], is_abgr);
+	});
+
+	// Filter the image data.
+	// Rows are filtered in groups, and each group reuses a single
+	// scratch row for adaptive filtering, so the scratch rows are
+	// only allocated once per image.
+	unique_ptr<uint8_t[]> filt(new uint8_t[filt_stride * height]);
+	const int filter_groups = std::min(height, PARALLEL_FILTER_GROUPS);
+	unique_ptr<uint8_t[]> filter_tmp(new uint8_t[rowbytes * filter_groups]);
+	LibRpThreads::parallel_for(0, filter_groups, [&](int g) {
+		const int y_start = static_cast<int>((static_cast<int64_t>(height) * g) / filter_groups);
+		const int y_end = static_cast<int>((static_cast<int64_t>(height) * (g + 1)) / filter_groups);
+		uint8_t *const tmp = &filter_tmp[rowbytes * g];
+		for (int y = y_start; y < y_end; y++) {
+			filter_row(&filt[filt_stride * y], &conv[rowbytes * y],
+				(y > 0 ? &conv[rowbytes * (y-1)] : nullptr), tmp, rowbytes, bpp);
+		}
+	});
+	filter_tmp.reset();
+	conv.reset();
+
+	// Split the filtered data into bands.
+	int rows_per_band = static_cast<int>(PARALLEL_IDAT_BAND_SIZE / filt_stride);
+	if (rows_per_band < 1) {
+		rows_per_band = 1;
+	}
+	const int band_count = (height + rows_per_band - 1) / rows_per_band;
+
+	// Compress each band.
+	vector<vector<uint8_t> > bands(band_count);
+	vector<uLong> band_adler(band_count);
+	// NOTE: The task group is cancelled if a zlib error occurs.
+	LibRpThreads::TaskGroup group;
+	LibRpThreads::parallel_for(group, 0, band_count, [&](int i) {
+		const size_t start = filt_stride * rows_per_band * i;
+		const size_t end = std::min(filt_stride * rows_per_band * (i + 1), filt_stride * height);
+		const uInt len = static_cast<uInt>(end - start);
+		uint8_t *const src = &filt[start];
+		band_adler[i] = adler32(adler32(0, nullptr, 0), src, len);
+
+		z_stream strm;
+		memset(&strm, 0, sizeof(strm));
+		int ret = deflateInit2(&strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+		if (ret != Z_OK) {
+			group.cancel();
+			return;
+		}
+		if (i > 0) {
+			// Use the end of the previous band as the dictionary.
+			const size_t dict_len = std::min(start, static_cast<size_t>(32768U));
+			deflateSetDictionary(&strm, &filt[start - dict_len], static_cast<uInt>(dict_len));
+		}
+
+		// NOTE: deflateBound() doesn't include the Z_SYNC_FLUSH marker.
+		vector<uint8_t> &out = bands[i];
+		out.resize(deflateBound(&strm, len) + 16);
+		strm.next_in = src;
+		strm.avail_in = len;
+		strm.next_out = out.data();
+		strm.avail_out = static_cast<uInt>(out.size());
+		const int flush = (i == band_count - 1 ? Z_FINISH : Z_SYNC_FLUSH);
+		do {
+			if (strm.avail_out == 0) {
+				// Out of space. Expand the buffer.
+				const size_t pos = out.size();
+				out.resize(pos * 2);
+				strm.next_out = &out[pos];
+				strm.avail_out = static_cast<uInt>(out.size() - pos);
+			}
+			ret = deflate(&strm, flush);
+		} while (ret == Z_OK && (strm.avail_in > 0 || strm.avail_out == 0));
+		if (ret != Z_OK && ret != Z_STREAM_END) {
+			group.cancel();
+		}
+		out.resize(strm.total_out);
+		deflateEnd(&strm);
+	});
+	filt.reset();
+	if (group.isCancelled()) {
+		lastError = EIO;
+		return -lastError;
+	}
+
+	// zlib header: CMF = 0x78 (deflate, 32 KB window); FLG depends on the level.
+	// NOTE: FLG must make (CMF*256 + FLG) a multiple of 31.
+	uint8_t zlib_header[2] = {0x78, 0x9C};
+	if (level >= 7) {
+		zlib_header[1] = 0xDA;
+	} else if (level >= 2 && level <= 5) {
+		zlib_header[1] = 0x5E;
+	} else if (level >= 0 && level <= 1) {
+		zlib_header[1] = 0x01;
+	}
+
+	// zlib trailer: Adler-32 of the uncompressed data. (big-endian)
+	uLong adler = band_adler[0];
+	for (int i = 1; i < band_count; i++) {
+		const size_t start = filt_stride * rows_per_band * i;
+		const size_t end = std::min(filt_stride * rows_per_band * (i + 1), filt_stride * height);
+		adler = adler32_combine(adler, band_adler[i], static_cast<z_off_t>(end - start));
+	}
+	const uint32_t adler_be = cpu_to_be32(static_cast<uint32_t>(adler));
+
+	// Write one IDAT chunk per band.
+	for (int i = 0; i < band_count; i++) {
+		const vector<uint8_t> &band = bands[i];
+		const bool is_first = (i == 0);
+		const bool is_last = (i == band_count - 1);
+		int ret = write_chunk("IDAT",
+			(is_first ? zlib_header : band.data()),
+			(is_first ? sizeof(zlib_header) : band.size()),
+			(is_first ? band.data() : nullptr),
+			(is_first ? band.size() : 0),
+			(is_last ? reinterpret_cast<const uint8_t*>(&adler_be) : nullptr),
+			(is_last ? sizeof(adler_be) : 0));
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	// Write the IEND chunk.
+	int ret = write_chunk("IEND", nullptr, 0);
+	if (ret == 0) {
+		IEND_written = true;
+	}
+	return ret;
+}
+
 /**
  * Write the rp_image data to the PNG image.
  *
@@ -904,7 +1382,7 @@ int RpPngWriterPrivate::write_IDAT_APNG(void)
 
 	// Write the images.
 	for (int i = 0; i < iconAnimData->seq_count; i++) {
-		const rp_image *const img = iconAnimData->frames[iconAnimData->seq_index[i]];
+		const rp_image *const img = iconAnimData->frame(iconAnimData->seq_index[i]);
 		if (!img)
 			break;
 
@@ -1108,6 +1586,29 @@ void RpPngWriter::close(void)
 	d->close();
 }
 
+/**
+ * Set the default compression profile for new RpPngWriter objects.
+ * This overrides the PngCompressionProfile setting in rom-properties.conf.
+ * @param profile Compression profile
+ */
+void RpPngWriter::setDefaultProfile(Profile profile)
+{
+	RpPngWriterPrivate::defaultProfile = profile;
+	RpPngWriterPrivate::hasDefaultProfile = true;
+}
+
+/**
+ * Set the compression profile.
+ * This must be called before write_IHDR().
+ * @param profile Compression profile
+ */
+void RpPngWriter::setProfile(Profile profile)
+{
+	RP_D(RpPngWriter);
+	assert(!d->IHDR_written);
+	d->profile = profile;
+}
+
 /**
  * Write the PNG IHDR.
  * This must be called before writing any other image data.
@@ -1143,9 +1644,22 @@ int RpPngWriter::write_IHDR(void)
 #endif /* PNG_SETJMP_SUPPORTED */
 
 	// Initialize compression parameters.
-	// TODO: Customizable?
-	png_set_filter(d->png_ptr, 0, PNG_FILTER_NONE);
-	png_set_compression_level(d->png_ptr, PNG_Z_DEFAULT_COMPRESSION);
+	// NOTE: CI8 images are never filtered.
+	switch (d->profile) {
+		default:
+		case Config::PngProfile::Default:
+			png_set_filter(d->png_ptr, 0, PNG_FILTER_NONE);
+			png_set_compression_level(d->png_ptr, PNG_Z_DEFAULT_COMPRESSION);
+			break;
+		case Config::PngProfile::Fast:
+			png_set_filter(d->png_ptr, 0, (d->cache.format != rp_image::Format::CI8) ? PNG_FILTER_SUB : PNG_FILTER_NONE);
+			png_set_compression_level(d->png_ptr, 1);
+			break;
+		case Config::PngProfile::Small:
+			png_set_filter(d->png_ptr, 0, (d->cache.format != rp_image::Format::CI8) ? PNG_ALL_FILTERS : PNG_FILTER_NONE);
+			png_set_compression_level(d->png_ptr, 9);
+			break;
+	}
 
 	// Write the PNG header.
 	switch (d->cache.format) {
@@ -1410,6 +1924,10 @@ int RpPngWriter::write_tEXt(const kv_vector &kv)
 
 	png_set_text(d->png_ptr, d->info_ptr, text.get(), static_cast<int>(kv.size()));
 	std::for_each(vU8toL1.begin(), vU8toL1.end(), ::free);
+	if (d->IHDR_written) {
+		// Text chunks will be written by png_write_end().
+		d->text_after_IHDR = true;
+	}
 	return 0;
 }
 
@@ -11,6 +11,7 @@
 #include "common.h"
 #include "dll-macros.h"	// for RP_LIBROMDATA_PUBLIC
 #include "librptexture/img/rp_image.hpp"
+#include "../config/Config.hpp"
 
 // C++ includes.
 #include <string>
@@ -172,6 +173,24 @@ class RP_LIBROMDATA_PUBLIC RpPngWriter
 		 */
 		void close(void);
 
+		/** Compression profile **/
+
+		typedef Config::PngProfile Profile;
+
+		/**
+		 * Set the default compression profile for new RpPngWriter objects.
+		 * This overrides the PngCompressionProfile setting in rom-properties.conf.
+		 * @param profile Compression profile
+		 */
+		static void setDefaultProfile(Profile profile);
+
+		/**
+		 * Set the compression profile.
+		 * This must be called before write_IHDR().
+		 * @param profile Compression profile
+		 */
+		void setProfile(Profile profile);
+
 		/**
 		 * Write the PNG IHDR.
 		 * This must be called before writing any other image data.
@@ -0,0 +1,156 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase/tests)                  *
+ * MultiHashTest.cpp: MultiHash class test.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// MultiHash
+#include "../crypto/MultiHash.hpp"
+#include "../disc/DiscReader.hpp"
+#include "librpfile/MemFile.hpp"
+using LibRpFile::MemFile;
+
+// C includes. (C++ namespace)
+#include <cstring>
+
+// C++ includes.
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRpBase { namespace Tests {
+
+struct MultiHashTest_mode
+{
+	// String to hash.
+	const char *str;
+
+	// Expected hashes. (lowercase hex)
+	const char *crc32;
+	const char *md5;
+	const char *sha1;
+
+	MultiHashTest_mode(const char *str, const char *crc32, const char *md5, const char *sha1)
+		: str(str), crc32(crc32), md5(md5), sha1(sha1)
+	{ }
+};
+
+class MultiHashTest : public ::testing::TestWithParam<MultiHashTest_mode>
+{ };
+
+/**
+ * Run a MultiHash test.
+ */
+TEST_P(MultiHashTest, multiHashTest)
+{
+	const MultiHashTest_mode &mode = GetParam();
+
+	MultiHash hash;
+	ASSERT_EQ(static_cast<unsigned int>(MultiHash::HASH_ALL), hash.hashTypes());
+
+	// Hash the string in two parts to test incremental updates.
+	const size_t len = strlen(mode.str);
+	hash.update(mode.str, len / 2);
+	hash.update(&mode.str[len / 2], len - (len / 2));
+	hash.finalize();
+
+	EXPECT_EQ(len, hash.size());
+	EXPECT_EQ(string(mode.crc32), hash.hexString(MultiHash::HASH_CRC32));
+	EXPECT_EQ(string(mode.md5), hash.hexString(MultiHash::HASH_MD5));
+	EXPECT_EQ(string(mode.sha1), hash.hexString(MultiHash::HASH_SHA1));
+}
+
+/**
+ * Test CRC32 calculation with larger buffers.
+ * This uses the PCLMULQDQ implementation if it's supported.
+ */
+TEST_F(MultiHashTest, crc32LargeBufferTest)
+{
+	vector<uint8_t> buf(65536 + 13);
+	for (size_t i = 0; i < buf.size(); i++) {
+		buf[i] = static_cast<uint8_t>((i * 7) + (i >> 8));
+	}
+
+	// Entire buffer.
+	EXPECT_EQ(0x04c685a0U, MultiHash::crc32(0, buf.data(), buf.size()));
+
+	// Unaligned split.
+	uint32_t crc = MultiHash::crc32(0, buf.data(), 1001);
+	crc = MultiHash::crc32(crc, &buf[1001], buf.size() - 1001);
+	EXPECT_EQ(0x04c685a0U, crc);
+}
+
+/**
+ * Hash an IDiscReader that's larger than the hashDiscReader() chunk size,
+ * and compare the hashes to update().
+ */
+TEST_F(MultiHashTest, hashDiscReaderTest)
+{
+	// 3 MiB plus a partial chunk.
+	vector<uint8_t> buf(3U * 1024U * 1024U + 12345U);
+	uint32_t seed = 0x12345678;
+	for (uint8_t &b : buf) {
+		seed = seed * 1103515245U + 12345U;
+		b = static_cast<uint8_t>(seed >> 24);
+	}
+
+	MultiHash expected;
+	expected.update(buf.data(), buf.size());
+	expected.finalize();
+
+	MemFile *const memFile = new MemFile(buf.data(), buf.size());
+	DiscReader *const discReader = new DiscReader(memFile);
+	memFile->unref();
+
+	MultiHash hash;
+	EXPECT_EQ(0, hash.hashDiscReader(discReader));
+	discReader->unref();
+
+	EXPECT_EQ(static_cast<uint64_t>(buf.size()), hash.size());
+	EXPECT_EQ(expected.crc32(), hash.crc32());
+	EXPECT_EQ(expected.hexString(MultiHash::HASH_MD5), hash.hexString(MultiHash::HASH_MD5));
+	EXPECT_EQ(expected.hexString(MultiHash::HASH_SHA1), hash.hexString(MultiHash::HASH_SHA1));
+
+	// Image size that's an exact multiple of the chunk size.
+	MemFile *const alignedFile = new MemFile(buf.data(), 2U * 1024U * 1024U);
+	DiscReader *const alignedReader = new DiscReader(alignedFile);
+	alignedFile->unref();
+
+	MultiHash alignedExpected;
+	alignedExpected.update(buf.data(), 2U * 1024U * 1024U);
+	alignedExpected.finalize();
+
+	MultiHash alignedHash;
+	EXPECT_EQ(0, alignedHash.hashDiscReader(alignedReader));
+	EXPECT_EQ(2U * 1024U * 1024U, alignedHash.size());
+	EXPECT_EQ(alignedExpected.crc32(), alignedHash.crc32());
+	alignedReader->unref();
+}
+
+/** MultiHash tests. **/
+
+INSTANTIATE_TEST_SUITE_P(MultiHashStringTest, MultiHashTest,
+	::testing::Values(
+		MultiHashTest_mode("",
+			"00000000",
+			"d41d8cd98f00b204e9800998ecf8427e",
+			"da39a3ee5e6b4b0d3255bfef95601890afd80709"),
+		MultiHashTest_mode("The quick brown fox jumps over the lazy dog.",
+			"519025e9",
+			"e4d909c290d0fb1ca068ffaddf22cbd0",
+			"408d94384216f890ff7a0c3528e8bed1e0b01621"),
+		MultiHashTest_mode("Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.",
+			"474b756f",
+			"818c6e601a24f72750da0f6c9b8ebe28",
+			"cca0871ecbe200379f0a1e4b46de177e2d62e655")
+		)
+	);
+
+} }
@@ -0,0 +1,128 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase/tests)                  *
+ * ScratchArenaTest.cpp: ScratchArena test.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// ScratchArena
+#include "librpbase/ScratchArena.hpp"
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+namespace LibRpBase { namespace Tests {
+
+/**
+ * Allocations must be aligned and must not overlap.
+ */
+TEST(ScratchArenaTest, alignmentTest)
+{
+	ScratchArena arena(256);
+
+	uint8_t *const p1 = static_cast<uint8_t*>(arena.alloc(3, 1));
+	ASSERT_NE(nullptr, p1);
+	uint32_t *const p2 = arena.alloc_array<uint32_t>(5);
+	ASSERT_NE(nullptr, p2);
+	EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(p2) % alignof(uint32_t));
+	uint8_t *const p3 = static_cast<uint8_t*>(arena.alloc(7, 64));
+	ASSERT_NE(nullptr, p3);
+	EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(p3) % 64);
+
+	memset(p1, 0x11, 3);
+	memset(p2, 0x22, 5 * sizeof(uint32_t));
+	memset(p3, 0x33, 7);
+	EXPECT_EQ(0x11, p1[2]);
+	EXPECT_EQ(0x22222222U, p2[4]);
+	EXPECT_EQ(0x33, p3[6]);
+
+	// Invalid alignment.
+	EXPECT_EQ(nullptr, arena.alloc(16, 3));
+}
+
+/**
+ * Allocations larger than the block size get their own block.
+ */
+TEST(ScratchArenaTest, largeAllocTest)
+{
+	ScratchArena arena(256);
+	EXPECT_EQ(0U, arena.capacity());
+
+	uint8_t *const p1 = arena.alloc_array<uint8_t>(16);
+	ASSERT_NE(nullptr, p1);
+	EXPECT_EQ(256U, arena.capacity());
+
+	uint8_t *const p2 = arena.alloc_array<uint8_t>(4096);
+	ASSERT_NE(nullptr, p2);
+	EXPECT_GE(arena.capacity(), 256U + 4096U);
+	memset(p2, 0x55, 4096);
+
+	// Overflow check.
+	EXPECT_EQ(nullptr, arena.alloc_array<uint64_t>(~static_cast<size_t>(0) / 4));
+}
+
+/**
+ * Scope releases allocations and reuses the memory.
+ */
+TEST(ScratchArenaTest, scopeTest)
+{
+	ScratchArena arena(256);
+	uint8_t *const p1 = arena.alloc_array<uint8_t>(16);
+	ASSERT_NE(nullptr, p1);
+
+	uint8_t *p_scoped;
+	{
+		ScratchArena::Scope scope(arena);
+		p_scoped = arena.alloc_array<uint8_t>(32);
+		ASSERT_NE(nullptr, p_scoped);
+
+		// Spill into a second block.
+		ASSERT_NE(nullptr, arena.alloc_array<uint8_t>(1024));
+	}
+	const size_t capacity = arena.capacity();
+
+	// The same memory should be returned after the Scope is released,
+	// and no new blocks should be allocated.
+	uint8_t *const p2 = arena.alloc_array<uint8_t>(32);
+	EXPECT_EQ(p_scoped, p2);
+	ASSERT_NE(nullptr, arena.alloc_array<uint8_t>(1024));
+	EXPECT_EQ(capacity, arena.capacity());
+}
+
+/**
+ * reset() keeps the first block and frees the others.
+ */
+TEST(ScratchArenaTest, resetTest)
+{
+	ScratchArena arena(256);
+	uint8_t *const p1 = arena.alloc_array<uint8_t>(16);
+	ASSERT_NE(nullptr, p1);
+	ASSERT_NE(nullptr, arena.alloc_array<uint8_t>(1024));
+	ASSERT_NE(nullptr, arena.alloc_array<uint8_t>(1024));
+	EXPECT_GT(arena.capacity(), 256U);
+
+	arena.reset();
+	EXPECT_EQ(256U, arena.capacity());
+	EXPECT_EQ(p1, arena.alloc_array<uint8_t>(16));
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRpBase test suite: ScratchArena tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -8,7 +8,11 @@
 
 // C++ includes.
 #include <locale>
+#include <string>
+#include <vector>
 using std::locale;
+using std::string;
+using std::vector;
 
 #include "dll-macros.h"
 #include "tcharx.h"
@@ -32,6 +36,19 @@ namespace Gdiplus {
 
 extern "C" int gtest_main(int argc, TCHAR *argv[]);
 
+/**
+ * Test suites that need more than the common security options
+ * can define these symbols. They're declared as weak symbols,
+ * so they're nullptr if the test suite doesn't define them.
+ */
+#if defined(HAVE_SECCOMP)
+// Additional syscalls to allow. (-1 terminated)
+extern "C" const int gtest_extra_syscall_wl[] __attribute__((weak));
+#elif defined(HAVE_PLEDGE)
+// Additional pledge() promises.
+extern "C" const char gtest_extra_promises[] __attribute__((weak));
+#endif
+
 int RP_C_API _tmain(int argc, TCHAR *argv[])
 {
 	// Set OS-specific security options.
@@ -92,12 +109,29 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 		-1	// End of whitelist
 	};
 	param.syscall_wl = syscall_wl;
-	param.threading = true;		// FIXME: Only if OpenMP is enabled?
+	param.threading = true;		// librpthreads thread pool
+
+	vector<int> syscall_wl_extra;
+	if (gtest_extra_syscall_wl) {
+		// Append the test suite's syscalls to the whitelist.
+		syscall_wl_extra.assign(syscall_wl, syscall_wl + (sizeof(syscall_wl)/sizeof(syscall_wl[0])) - 1);
+		for (const int *p = gtest_extra_syscall_wl; *p != -1; p++) {
+			syscall_wl_extra.push_back(*p);
+		}
+		syscall_wl_extra.push_back(-1);
+		param.syscall_wl = syscall_wl_extra.data();
+	}
 #elif defined(HAVE_PLEDGE)
 	// Promises:
 	// - stdio: General stdio functionality.
 	// - rpath: Read test cases.
-	param.promises = "stdio rpath";
+	string promises("stdio rpath");
+	if (gtest_extra_promises) {
+		// Add the test suite's promises.
+		promises += ' ';
+		promises += gtest_extra_promises;
+	}
+	param.promises = promises.c_str();
 #elif defined(HAVE_TAME)
 	param.tame_flags = TAME_STDIO | TAME_RPATH;
 #else
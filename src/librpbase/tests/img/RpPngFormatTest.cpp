@@ -37,10 +37,12 @@
 #include "librpfile/FileSystem.hpp"
 #include "librpfile/MemFile.hpp"
 #include "librpfile/RpFile.hpp"
+#include "librpfile/VectorFile.hpp"
 using namespace LibRpFile;
 
 // librptexture
 #include "img/RpPng.hpp"
+#include "img/RpPngWriter.hpp"
 #include "librptexture/img/rp_image.hpp"
 using LibRpTexture::rp_image;
 
@@ -53,11 +55,14 @@ using LibRpTexture::rp_image;
 #include <cstring>
 
 // C++ includes.
+#include <algorithm>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 using std::string;
 using std::unique_ptr;
+using std::vector;
 
 namespace LibRpBase { namespace Tests {
 
@@ -1308,6 +1313,443 @@ INSTANTIATE_TEST_SUITE_P(happy_mac_mono_png, RpPngFormatTest,
 		)
 	, RpPngFormatTest::test_case_suffix_generator);
 
+
+/** RpPngWriter: Multi-threaded IDAT encoder **/
+
+// NOTE: These must match RpPngWriterPrivate in RpPngWriter.cpp.
+static const size_t PARALLEL_IDAT_MIN_SIZE = 512U * 1024U;
+static const size_t PARALLEL_IDAT_BAND_SIZE = 256U * 1024U;
+
+struct RpPngWriterParallelTest_mode
+{
+	const char *name;		// Test name
+	rp_image::Format format;	// Image format (ARGB32 or CI8)
+	bool skip_alpha;		// If true, sBIT.alpha == 0, so RGB is written.
+	int width;
+	int height;
+	RpPngWriter::Profile profile;
+
+	RpPngWriterParallelTest_mode(const char *name, rp_image::Format format, bool skip_alpha,
+		int width, int height, RpPngWriter::Profile profile)
+		: name(name)
+		, format(format)
+		, skip_alpha(skip_alpha)
+		, width(width)
+		, height(height)
+		, profile(profile)
+	{ }
+};
+
+/**
+ * Formatting function for RpPngWriterParallelTest.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const RpPngWriterParallelTest_mode& mode)
+{
+	return os << mode.name;
+};
+
+class RpPngWriterParallelTest : public ::testing::TestWithParam<RpPngWriterParallelTest_mode>
+{
+	protected:
+		void SetUp(void) final;
+
+	public:
+		/**
+		 * Write the test image using RpPngWriter.
+		 * @param text_after_IHDR If true, write a tEXt chunk after IHDR.
+		 * @return VectorFile containing the PNG image, or nullptr on error.
+		 */
+		VectorFile *writeImage(bool text_after_IHDR);
+
+		/**
+		 * Verify the PNG image's chunks and zlib stream.
+		 * @param png		[in] PNG image
+		 * @param pIDAT_count	[out] Number of IDAT chunks
+		 * @param pTextAfterIDAT	[out] True if a tEXt or zTXt chunk is after the IDAT chunks.
+		 */
+		void checkChunks(const vector<uint8_t> &png, unsigned int *pIDAT_count, bool *pTextAfterIDAT);
+
+		/**
+		 * Reload the PNG image and compare it to the original image data.
+		 * @param vf VectorFile containing the PNG image
+		 */
+		void checkPixels(VectorFile *vf);
+
+		/**
+		 * Get the number of bands write_IDAT_parallel() should use.
+		 * @return Number of bands
+		 */
+		unsigned int expectedBandCount(void) const;
+
+		/**
+		 * Is the multi-threaded encoder expected to be used?
+		 * @return True if RP_MAX_THREADS is set to more than 1.
+		 */
+		static bool isParallelExpected(void);
+
+		static string test_case_suffix_generator(const ::testing::TestParamInfo<RpPngWriterParallelTest_mode> &info);
+
+	protected:
+		// Image data
+		vector<uint32_t> m_argb32;
+		vector<uint8_t> m_ci8;
+		vector<uint32_t> m_palette;
+
+		// Bytes per pixel in the PNG image
+		unsigned int bytesPerPixel(void) const
+		{
+			const RpPngWriterParallelTest_mode &mode = GetParam();
+			return (mode.format == rp_image::Format::CI8 ? 1 : (mode.skip_alpha ? 3 : 4));
+		}
+};
+
+/**
+ * SetUp() function.
+ * Generate the image data.
+ */
+void RpPngWriterParallelTest::SetUp(void)
+{
+	const RpPngWriterParallelTest_mode &mode = GetParam();
+	const size_t data_size = static_cast<size_t>(mode.width) * mode.height * bytesPerPixel();
+	ASSERT_GE(data_size, PARALLEL_IDAT_MIN_SIZE) << "Test image is too small for the multi-threaded encoder.";
+
+	// Each row is the previous row rotated by a few pixels, plus some noise,
+	// so the compressor finds matches that cross band boundaries.
+	// A fixed seed is used so failures are reproducible.
+	uint32_t seed = 0x5EED1234U;
+	auto next = [&seed]() -> uint32_t {
+		seed = seed * 1103515245U + 12345U;
+		return seed;
+	};
+	vector<uint32_t> pattern(1021);
+	for (uint32_t &px : pattern) {
+		px = next();
+	}
+
+	const size_t count = static_cast<size_t>(mode.width) * mode.height;
+	if (mode.format == rp_image::Format::CI8) {
+		m_ci8.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			const size_t y = i / mode.width;
+			m_ci8[i] = static_cast<uint8_t>(pattern[(i + y * 5) % pattern.size()] >> 24);
+			if ((next() >> 28) == 0) {
+				m_ci8[i] ^= static_cast<uint8_t>(next() >> 16);
+			}
+		}
+		// Palette, with a few transparent entries.
+		m_palette.resize(256);
+		for (uint32_t &color : m_palette) {
+			color = next() | 0xFF000000U;
+			if ((next() >> 29) == 0) {
+				color &= 0x7FFFFFFFU;
+			}
+		}
+	} else {
+		m_argb32.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			const size_t y = i / mode.width;
+			m_argb32[i] = pattern[(i + y * 3) % pattern.size()];
+			if ((next() >> 28) == 0) {
+				m_argb32[i] ^= next() & 0x0F0F0F0FU;
+			}
+		}
+	}
+}
+
+/**
+ * Write the test image using RpPngWriter.
+ * @param text_after_IHDR If true, write a tEXt chunk after IHDR.
+ * @return VectorFile containing the PNG image, or nullptr on error.
+ */
+VectorFile *RpPngWriterParallelTest::writeImage(bool text_after_IHDR)
+{
+	const RpPngWriterParallelTest_mode &mode = GetParam();
+	VectorFile *const vf = new VectorFile();
+
+	// Row pointers
+	unique_ptr<const uint8_t*[]> row_pointers(new const uint8_t*[mode.height]);
+	for (int y = 0; y < mode.height; y++) {
+		row_pointers[y] = (mode.format == rp_image::Format::CI8)
+			? &m_ci8[static_cast<size_t>(y) * mode.width]
+			: reinterpret_cast<const uint8_t*>(&m_argb32[static_cast<size_t>(y) * mode.width]);
+	}
+
+	int ret;
+	{
+		RpPngWriter pngWriter(vf, mode.width, mode.height, mode.format);
+		EXPECT_TRUE(pngWriter.isOpen());
+		if (!pngWriter.isOpen()) {
+			vf->unref();
+			return nullptr;
+		}
+		pngWriter.setProfile(mode.profile);
+
+		const rp_image::sBIT_t sBIT = {8, 8, 8, 0, static_cast<uint8_t>(mode.skip_alpha ? 0 : 8)};
+		if (mode.format == rp_image::Format::CI8) {
+			ret = pngWriter.write_IHDR(&sBIT, m_palette.data(), static_cast<unsigned int>(m_palette.size()));
+		} else {
+			ret = pngWriter.write_IHDR(&sBIT);
+		}
+		EXPECT_EQ(0, ret);
+
+		if (ret == 0 && text_after_IHDR) {
+			// Text chunks after IHDR are written by png_write_end(),
+			// so the single-threaded encoder must be used.
+			RpPngWriter::kv_vector kv;
+			kv.emplace_back("Software", "RpPngWriterParallelTest");
+			ret = pngWriter.write_tEXt(kv);
+			EXPECT_EQ(0, ret);
+		}
+
+		if (ret == 0) {
+			ret = pngWriter.write_IDAT(row_pointers.get());
+			EXPECT_EQ(0, ret);
+		}
+	}
+
+	if (ret != 0) {
+		vf->unref();
+		return nullptr;
+	}
+	return vf;
+}
+
+/**
+ * Verify the PNG image's chunks and zlib stream.
+ * @param png		[in] PNG image
+ * @param pIDAT_count	[out] Number of IDAT chunks
+ * @param pTextAfterIDAT	[out] True if a tEXt or zTXt chunk is after the IDAT chunks.
+ */
+void RpPngWriterParallelTest::checkChunks(const vector<uint8_t> &png, unsigned int *pIDAT_count, bool *pTextAfterIDAT)
+{
+	const RpPngWriterParallelTest_mode &mode = GetParam();
+	*pIDAT_count = 0;
+	*pTextAfterIDAT = false;
+
+	ASSERT_GT(png.size(), sizeof(PNG_magic));
+	ASSERT_EQ(0, memcmp(png.data(), PNG_magic, sizeof(PNG_magic)));
+
+	// Walk the chunks and concatenate the IDAT data.
+	vector<uint8_t> zdata;
+	bool has_IEND = false;
+	size_t pos = sizeof(PNG_magic);
+	while (pos + 12 <= png.size()) {
+		uint32_t chunk_size;
+		memcpy(&chunk_size, &png[pos], sizeof(chunk_size));
+		chunk_size = be32_to_cpu(chunk_size);
+		const char *const chunk_name = reinterpret_cast<const char*>(&png[pos + 4]);
+		ASSERT_LE(pos + 12 + chunk_size, png.size()) << "Chunk extends past the end of the file.";
+		const uint8_t *const chunk_data = &png[pos + 8];
+
+		// Verify the CRC32.
+		uint32_t crc;
+		memcpy(&crc, &chunk_data[chunk_size], sizeof(crc));
+		const uLong expected_crc = crc32(crc32(0, reinterpret_cast<const Bytef*>(chunk_name), 4), chunk_data, chunk_size);
+		EXPECT_EQ(static_cast<uint32_t>(expected_crc), be32_to_cpu(crc)) << "Chunk '" << string(chunk_name, 4) << "' has an incorrect CRC32.";
+
+		if (!memcmp(chunk_name, "IDAT", 4)) {
+			(*pIDAT_count)++;
+			zdata.insert(zdata.end(), chunk_data, chunk_data + chunk_size);
+		} else if (!memcmp(chunk_name, "tEXt", 4) || !memcmp(chunk_name, "zTXt", 4)) {
+			if (*pIDAT_count > 0) {
+				*pTextAfterIDAT = true;
+			}
+		} else if (!memcmp(chunk_name, "IEND", 4)) {
+			EXPECT_EQ(0U, chunk_size);
+			has_IEND = true;
+			pos += 12 + chunk_size;
+			break;
+		}
+		pos += 12 + chunk_size;
+	}
+	EXPECT_TRUE(has_IEND) << "IEND chunk is missing.";
+	EXPECT_EQ(png.size(), pos) << "Extra data after IEND.";
+	ASSERT_GT(*pIDAT_count, 0U);
+
+	// Decompress the zlib stream.
+	// This verifies the zlib header and the Adler-32 checksum.
+	const size_t filt_size = (static_cast<size_t>(mode.width) * bytesPerPixel() + 1) * mode.height;
+	vector<uint8_t> filt(filt_size + 1);
+	z_stream strm;
+	memset(&strm, 0, sizeof(strm));
+	ASSERT_EQ(Z_OK, inflateInit(&strm));
+	strm.next_in = zdata.data();
+	strm.avail_in = static_cast<uInt>(zdata.size());
+	strm.next_out = filt.data();
+	strm.avail_out = static_cast<uInt>(filt.size());
+	const int ret = inflate(&strm, Z_FINISH);
+	EXPECT_EQ(Z_STREAM_END, ret) << "zlib stream is invalid: " << (strm.msg ? strm.msg : "(no message)");
+	EXPECT_EQ(filt_size, strm.total_out);
+	EXPECT_EQ(0U, strm.avail_in) << "Extra data after the end of the zlib stream.";
+	inflateEnd(&strm);
+}
+
+/**
+ * Reload the PNG image and compare it to the original image data.
+ * @param vf VectorFile containing the PNG image
+ */
+void RpPngWriterParallelTest::checkPixels(VectorFile *vf)
+{
+	const RpPngWriterParallelTest_mode &mode = GetParam();
+
+	vf->rewind();
+	const rp_image *const img = RpPng::load(vf);
+	ASSERT_NE(nullptr, img) << "RpPng::load() failed.";
+	EXPECT_EQ(mode.width, img->width());
+	EXPECT_EQ(mode.height, img->height());
+	EXPECT_EQ(mode.format, img->format());
+	if (img->width() != mode.width || img->height() != mode.height || img->format() != mode.format) {
+		const_cast<rp_image*>(img)->unref();
+		return;
+	}
+
+	if (mode.format == rp_image::Format::CI8) {
+		// Compare the palette.
+		EXPECT_EQ(m_palette.size(), img->palette_len());
+		if (img->palette_len() == m_palette.size()) {
+			EXPECT_EQ(0, memcmp(m_palette.data(), img->palette(), m_palette.size() * sizeof(uint32_t)))
+				<< "Palette doesn't match.";
+		}
+	}
+
+	for (int y = 0; y < mode.height; y++) {
+		const uint8_t *const line = static_cast<const uint8_t*>(img->scanLine(y));
+		for (int x = 0; x < mode.width; x++) {
+			const size_t i = static_cast<size_t>(y) * mode.width + x;
+			uint32_t expected, actual;
+			if (mode.format == rp_image::Format::CI8) {
+				expected = m_ci8[i];
+				actual = line[x];
+			} else {
+				// If alpha is skipped, the image is loaded as opaque.
+				expected = m_argb32[i] | (mode.skip_alpha ? 0xFF000000U : 0);
+				memcpy(&actual, &line[x * 4], sizeof(actual));
+			}
+			if (expected != actual) {
+				// Only report the first mismatch.
+				char buf[80];
+				snprintf(buf, sizeof(buf), "Pixel (%d,%d): expected %08X, got %08X",
+					x, y, expected, actual);
+				ADD_FAILURE() << buf;
+				const_cast<rp_image*>(img)->unref();
+				return;
+			}
+		}
+	}
+
+	const_cast<rp_image*>(img)->unref();
+}
+
+/**
+ * Get the number of bands write_IDAT_parallel() should use.
+ * @return Number of bands
+ */
+unsigned int RpPngWriterParallelTest::expectedBandCount(void) const
+{
+	const RpPngWriterParallelTest_mode &mode = GetParam();
+	const size_t filt_stride = static_cast<size_t>(mode.width) * bytesPerPixel() + 1;
+	const unsigned int rows_per_band = std::max(1U, static_cast<unsigned int>(PARALLEL_IDAT_BAND_SIZE / filt_stride));
+	return (mode.height + rows_per_band - 1) / rows_per_band;
+}
+
+/**
+ * Is the multi-threaded encoder expected to be used?
+ * @return True if RP_MAX_THREADS is set to more than 1.
+ */
+bool RpPngWriterParallelTest::isParallelExpected(void)
+{
+	// NOTE: If RP_MAX_THREADS isn't set, the number of worker
+	// threads depends on the number of CPUs.
+	const char *const env = getenv("RP_MAX_THREADS");
+	return (env && strtol(env, nullptr, 10) > 1);
+}
+
+/**
+ * Test case suffix generator.
+ * @param info Test parameter information.
+ * @return Test case suffix.
+ */
+string RpPngWriterParallelTest::test_case_suffix_generator(const ::testing::TestParamInfo<RpPngWriterParallelTest_mode> &info)
+{
+	const RpPngWriterParallelTest_mode &mode = info.param;
+	string suffix = mode.name;
+	switch (mode.profile) {
+		default:
+		case RpPngWriter::Profile::Default:
+			suffix += "_Default";
+			break;
+		case RpPngWriter::Profile::Fast:
+			suffix += "_Fast";
+			break;
+		case RpPngWriter::Profile::Small:
+			suffix += "_Small";
+			break;
+	}
+	return suffix;
+}
+
+/**
+ * Write an image using the multi-threaded encoder and reload it.
+ */
+TEST_P(RpPngWriterParallelTest, parallelIDAT)
+{
+	// Sanity check: More than one band, and the last band is shorter.
+	const RpPngWriterParallelTest_mode &mode = GetParam();
+	const unsigned int band_count = expectedBandCount();
+	ASSERT_GT(band_count, 1U);
+	const size_t filt_stride = static_cast<size_t>(mode.width) * bytesPerPixel() + 1;
+	ASSERT_NE(0U, mode.height % (PARALLEL_IDAT_BAND_SIZE / filt_stride)) << "Last band isn't shorter than the others.";
+
+	VectorFile *const vf = writeImage(false);
+	ASSERT_NE(nullptr, vf);
+
+	unsigned int IDAT_count = 0;
+	bool textAfterIDAT = false;
+	EXPECT_NO_FATAL_FAILURE(checkChunks(vf->vector(), &IDAT_count, &textAfterIDAT));
+	if (isParallelExpected()) {
+		// write_IDAT_parallel() writes one IDAT chunk per band.
+		EXPECT_EQ(band_count, IDAT_count) << "Multi-threaded encoder was not used.";
+	} else if (!GTEST_FLAG_GET(brief)) {
+		fputs("*** RP_MAX_THREADS is not set. Not checking if the multi-threaded encoder was used.\n", stderr);
+	}
+
+	EXPECT_NO_FATAL_FAILURE(checkPixels(vf));
+	vf->unref();
+}
+
+/**
+ * Write an image with a tEXt chunk after IHDR.
+ * The single-threaded encoder must be used, since libpng
+ * writes the text chunk in png_write_end().
+ */
+TEST_P(RpPngWriterParallelTest, textAfterIHDR)
+{
+	VectorFile *const vf = writeImage(true);
+	ASSERT_NE(nullptr, vf);
+
+	unsigned int IDAT_count = 0;
+	bool textAfterIDAT = false;
+	EXPECT_NO_FATAL_FAILURE(checkChunks(vf->vector(), &IDAT_count, &textAfterIDAT));
+	EXPECT_TRUE(textAfterIDAT) << "tEXt chunk was not written after IDAT.";
+
+	EXPECT_NO_FATAL_FAILURE(checkPixels(vf));
+	vf->unref();
+}
+
+// Image sizes are chosen so there are multiple bands,
+// and the last band is shorter than the others.
+#define RPPNGWRITER_PARALLEL_MODES(profile) \
+	RpPngWriterParallelTest_mode("ARGB32", rp_image::Format::ARGB32, false, 600, 300, RpPngWriter::Profile::profile), \
+	RpPngWriterParallelTest_mode("RGB24", rp_image::Format::ARGB32, true, 600, 300, RpPngWriter::Profile::profile), \
+	RpPngWriterParallelTest_mode("CI8", rp_image::Format::CI8, false, 1000, 600, RpPngWriter::Profile::profile)
+
+INSTANTIATE_TEST_SUITE_P(RpPngWriterParallel, RpPngWriterParallelTest,
+	::testing::Values(
+		RPPNGWRITER_PARALLEL_MODES(Default),
+		RPPNGWRITER_PARALLEL_MODES(Fast),
+		RPPNGWRITER_PARALLEL_MODES(Small))
+	, RpPngWriterParallelTest::test_case_suffix_generator);
+
 } }
 
 /**
@@ -22,10 +22,15 @@
  */
 static __typeof__(&rp_byte_swap_16_array_c) rp_byte_swap_16_array_resolve(void)
 {
-#if defined(BYTESWAP_HAS_SSSE3) || defined(BYTESWAP_HAS_SSE2) || defined(BYTESWAP_HAS_MMX)
+#if defined(BYTESWAP_HAS_AVX2) || defined(BYTESWAP_HAS_SSSE3) || defined(BYTESWAP_HAS_SSE2) || defined(BYTESWAP_HAS_MMX)
 	__builtin_cpu_init();
 #endif
 
+#ifdef BYTESWAP_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &rp_byte_swap_16_array_avx2;
+	} else
+#endif /* BYTESWAP_HAS_AVX2 */
 #ifdef BYTESWAP_HAS_SSSE3
 	if (__builtin_cpu_supports("ssse3")) {
 		return &rp_byte_swap_16_array_ssse3;
@@ -63,10 +68,15 @@ __typeof__(&rp_byte_swap_32_array_c) rp_byte_swap_32_array_resolve(void)
 	// We'll use gcc's built-in CPU ID functions instead.
 	// Requires gcc-4.8 or later, or clang-6.0 or later.
 
-#if defined(BYTESWAP_HAS_SSSE3) || defined(BYTESWAP_HAS_SSE2) || defined(BYTESWAP_HAS_MMX)
+#if defined(BYTESWAP_HAS_AVX2) || defined(BYTESWAP_HAS_SSSE3) || defined(BYTESWAP_HAS_SSE2) || defined(BYTESWAP_HAS_MMX)
 	__builtin_cpu_init();
 #endif
 
+#ifdef BYTESWAP_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &rp_byte_swap_32_array_avx2;
+	} else
+#endif /* BYTESWAP_HAS_AVX2 */
 #ifdef BYTESWAP_HAS_SSSE3
 	if (__builtin_cpu_supports("ssse3")) {
 		return &rp_byte_swap_32_array_ssse3;
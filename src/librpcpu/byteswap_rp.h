@@ -31,6 +31,10 @@
 #  endif
 #  define BYTESWAP_HAS_SSE2 1
 #  define BYTESWAP_HAS_SSSE3 1
+/* AVX2 intrinsics require MSVC 2013 or later. */
+#  if !defined(_MSC_VER) || _MSC_VER >= 1800
+#    define BYTESWAP_HAS_AVX2 1
+#  endif
 #endif
 #ifdef RP_CPU_AMD64
 #  define BYTESWAP_ALWAYS_HAS_SSE2 1
@@ -223,6 +227,26 @@ RP_LIBROMDATA_PUBLIC
 void RP_C_API rp_byte_swap_32_array_ssse3(uint32_t *ptr, size_t n);
 #endif /* BYTESWAP_HAS_SSSE3 */
 
+#ifdef BYTESWAP_HAS_AVX2
+/**
+ * 16-bit byteswap function.
+ * AVX2-optimized version.
+ * @param ptr Pointer to array to swap. (MUST be 16-bit aligned!)
+ * @param n Number of bytes to swap. (Must be divisible by 2; an extra odd byte will be ignored.)
+ */
+RP_LIBROMDATA_PUBLIC
+void RP_C_API rp_byte_swap_16_array_avx2(uint16_t *ptr, size_t n);
+
+/**
+ * 32-bit byteswap function.
+ * AVX2-optimized version.
+ * @param ptr Pointer to array to swap. (MUST be 32-bit aligned!)
+ * @param n Number of bytes to swap. (Must be divisible by 4; extra bytes will be ignored.)
+ */
+RP_LIBROMDATA_PUBLIC
+void RP_C_API rp_byte_swap_32_array_avx2(uint32_t *ptr, size_t n);
+#endif /* BYTESWAP_HAS_AVX2 */
+
 #if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
 /* System has IFUNC. Use it for dispatching. */
 
@@ -252,6 +276,11 @@ void RP_C_API rp_byte_swap_32_array(uint32_t *ptr, size_t n);
  */
 static FORCEINLINE void rp_byte_swap_16_array(uint16_t *ptr, size_t n)
 {
+#  ifdef BYTESWAP_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		rp_byte_swap_16_array_avx2(ptr, n);
+	} else
+#  endif /* BYTESWAP_HAS_AVX2 */
 #  ifdef BYTESWAP_HAS_SSSE3
 	if (RP_CPU_HasSSSE3()) {
 		rp_byte_swap_16_array_ssse3(ptr, n);
@@ -286,6 +315,11 @@ static FORCEINLINE void rp_byte_swap_16_array(uint16_t *ptr, size_t n)
  */
 static FORCEINLINE void rp_byte_swap_32_array(uint32_t *ptr, size_t n)
 {
+#  ifdef BYTESWAP_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		rp_byte_swap_32_array_avx2(ptr, n);
+	} else
+#  endif /* BYTESWAP_HAS_AVX2 */
 #  ifdef BYTESWAP_HAS_SSSE3
 	if (RP_CPU_HasSSSE3()) {
 		rp_byte_swap_32_array_ssse3(ptr, n);
@@ -19,6 +19,9 @@
 #if defined(_MSC_VER) && _MSC_VER >= 1400
 #  include <intrin.h>
 #endif
+#if defined(_MSC_VER) && _MSC_VER >= 1600
+#  include <immintrin.h>	/* _xgetbv() */
+#endif
 
 // IA32 CPU flags
 // References:
@@ -41,6 +44,7 @@
 
 // Flags stored in the %ecx register.
 #define CPUFLAG_IA32_ECX_SSE3		((uint32_t)(1U << 0))
+#define CPUFLAG_IA32_ECX_PCLMULQDQ	((uint32_t)(1U << 1))
 #define CPUFLAG_IA32_ECX_SSSE3		((uint32_t)(1U << 9))
 #define CPUFLAG_IA32_ECX_SSE41		((uint32_t)(1U << 19))
 #define CPUFLAG_IA32_ECX_SSE42		((uint32_t)(1U << 20))
@@ -187,6 +191,92 @@ static FORCEINLINE void cpuid(unsigned int level, unsigned int regs[4])
 #endif
 }
 
+/**
+ * Run the `cpuid` instruction with a subleaf.
+ * @param level
+ * @param subleaf
+ * @param regs Registers. (%eax, %ebx, %ecx, %edx)
+ */
+static FORCEINLINE void cpuid_count(unsigned int level, unsigned int subleaf, unsigned int regs[4])
+{
+#ifdef HAVE_CPUID_H
+	// Use the compiler's __cpuid_count() macro.
+	__cpuid_count(level, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#elif defined(__GNUC__)
+	// CPUID macro with PIC support.
+#  ifdef ASM_RESERVE_EBX
+	__asm__ (
+		"xchgl	%%ebx, %1\n"
+		"cpuid\n"
+		"xchgl	%%ebx, %1\n"
+		: "=a" (regs[0]), "=r" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+		: "0" (level), "2" (subleaf)
+		);
+#  else /* !ASM_RESERVE_EBX */
+	__asm__ (
+		"cpuid\n"
+		: "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+		: "0" (level), "2" (subleaf)
+		);
+#  endif
+#elif defined(_MSC_VER)
+#  if _MSC_VER >= 1500
+	// CPUID for MSVC 2008+
+	// Uses the __cpuidex() intrinsic.
+	__cpuidex((int*)regs, level, subleaf);
+#  else /* _MSC_VER < 1500 */
+#    if defined(_M_X64)
+#      error Cannot use inline assembly on 64-bit MSVC.
+#    endif
+	__asm {
+		mov	eax, level
+		mov	ecx, subleaf
+		cpuid
+		mov	regs[0 * TYPE int], eax
+		mov	regs[1 * TYPE int], ebx
+		mov	regs[2 * TYPE int], ecx
+		mov	regs[3 * TYPE int], edx
+	}
+#  endif
+#else
+#  error Missing 'cpuid' asm implementation for this compiler.
+#endif
+}
+
+/**
+ * Run the `xgetbv` instruction.
+ * This reads an extended control register. (XCR0 for index 0)
+ * NOTE: Only call this if CPUID reports OSXSAVE.
+ * @param index XCR index
+ * @return Low 32 bits of the XCR.
+ */
+static FORCEINLINE uint32_t xgetbv_lo(unsigned int index)
+{
+#if defined(__GNUC__)
+	// NOTE: Using the opcode directly in case the assembler
+	// doesn't support the `xgetbv` mnemonic.
+	uint32_t eax, edx;
+	__asm__ (
+		".byte 0x0F, 0x01, 0xD0\n"
+		: "=a" (eax), "=d" (edx)
+		: "c" (index)
+		);
+	return eax;
+#elif defined(_MSC_VER) && (_MSC_VER > 1600 || (_MSC_VER == 1600 && _MSC_FULL_VER >= 160040219))
+	// MSVC 2010 SP1 or later: Use the _xgetbv() intrinsic.
+	return (uint32_t)_xgetbv(index);
+#else
+	// xgetbv isn't supported by this compiler.
+	// Assume the OS doesn't support AVX.
+	((void)index);
+	return 0;
+#endif
+}
+
+// XCR0 bits: OS saves the SSE (XMM) and AVX (YMM) register states.
+#define XCR0_SSE_STATE	((uint32_t)(1U << 1))
+#define XCR0_AVX_STATE	((uint32_t)(1U << 2))
+
 // Register indexes.
 #define REG_EAX 0
 #define REG_EBX 1
@@ -297,6 +387,8 @@ static void RP_CPU_InitCPUFlags_int(void)
 				RP_CPU_Flags |= RP_CPUFLAG_X86_SSE41;
 			if (regs[REG_ECX] & CPUFLAG_IA32_ECX_SSE42)
 				RP_CPU_Flags |= RP_CPUFLAG_X86_SSE42;
+			if (regs[REG_ECX] & CPUFLAG_IA32_ECX_PCLMULQDQ)
+				RP_CPU_Flags |= RP_CPUFLAG_X86_PCLMULQDQ;
 		}
 #else /* !(defined(__i386__) || defined(_M_IX86)) */
 		// AMD64: SSE2 and lower are always supported.
@@ -309,7 +401,31 @@ static void RP_CPU_InitCPUFlags_int(void)
 			RP_CPU_Flags |= RP_CPUFLAG_X86_SSE41;
 		if (regs[REG_ECX] & CPUFLAG_IA32_ECX_SSE42)
 			RP_CPU_Flags |= RP_CPUFLAG_X86_SSE42;
+		if (regs[REG_ECX] & CPUFLAG_IA32_ECX_PCLMULQDQ)
+			RP_CPU_Flags |= RP_CPUFLAG_X86_PCLMULQDQ;
 #endif /* defined(__i386__) || defined(_M_IX86) */
+
+		// Check for AVX.
+		// The OS must support saving the YMM registers, which is
+		// indicated by OSXSAVE and the XCR0 register.
+		if ((RP_CPU_Flags & RP_CPUFLAG_X86_SSE2) &&
+		    (regs[REG_ECX] & (CPUFLAG_IA32_ECX_OSXSAVE | CPUFLAG_IA32_ECX_AVX)) ==
+		                     (CPUFLAG_IA32_ECX_OSXSAVE | CPUFLAG_IA32_ECX_AVX))
+		{
+			const uint32_t xcr0 = xgetbv_lo(0);
+			if ((xcr0 & (XCR0_SSE_STATE | XCR0_AVX_STATE)) ==
+			            (XCR0_SSE_STATE | XCR0_AVX_STATE))
+			{
+				RP_CPU_Flags |= RP_CPUFLAG_X86_AVX;
+			}
+		}
+	}
+
+	if ((RP_CPU_Flags & RP_CPUFLAG_X86_AVX) && maxFunc >= CPUID_EXT_FEATURES) {
+		// Get the extended features.
+		cpuid_count(CPUID_EXT_FEATURES, 0, regs);
+		if (regs[REG_EBX] & CPUFLAG_IA32_FN7_EBX_AVX2)
+			RP_CPU_Flags |= RP_CPUFLAG_X86_AVX2;
 	}
 
 	// CPU flags initialized.
@@ -29,6 +29,9 @@ extern "C" {
 #define RP_CPUFLAG_X86_SSSE3		((uint32_t)(1U << 4))
 #define RP_CPUFLAG_X86_SSE41		((uint32_t)(1U << 5))
 #define RP_CPUFLAG_X86_SSE42		((uint32_t)(1U << 6))
+#define RP_CPUFLAG_X86_AVX		((uint32_t)(1U << 7))
+#define RP_CPUFLAG_X86_AVX2		((uint32_t)(1U << 8))
+#define RP_CPUFLAG_X86_PCLMULQDQ	((uint32_t)(1U << 9))
 
 #endif /* _M_IX86) || __i386__ || _M_X64 || _M_AMD64 || __amd64__ || __x86_64__ */
 
@@ -100,6 +103,31 @@ static FORCEINLINE int RP_CPU_HasSSE41(void)
 	return (RP_CPU_Flags & RP_CPUFLAG_X86_SSE41);
 }
 
+/**
+ * Check if the CPU supports AVX2.
+ * This also checks if the OS supports saving the AVX registers.
+ * @return Non-zero if AVX2 is supported; 0 if not.
+ */
+static FORCEINLINE int RP_CPU_HasAVX2(void)
+{
+	if (unlikely(!RP_CPU_Flags_Init)) {
+		RP_CPU_InitCPUFlags();
+	}
+	return (RP_CPU_Flags & RP_CPUFLAG_X86_AVX2);
+}
+
+/**
+ * Check if the CPU supports PCLMULQDQ.
+ * @return Non-zero if PCLMULQDQ is supported; 0 if not.
+ */
+static FORCEINLINE int RP_CPU_HasPCLMULQDQ(void)
+{
+	if (unlikely(!RP_CPU_Flags_Init)) {
+		RP_CPU_InitCPUFlags();
+	}
+	return (RP_CPU_Flags & RP_CPUFLAG_X86_PCLMULQDQ);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -152,7 +152,7 @@ TEST_F(ByteswapTest, nonHostEndianMacroTest)
 
 /**
  * Macro for testing a 16-bit byteswap function.
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -173,7 +173,7 @@ TEST_F(ByteswapTest, rp_byte_swap_16_array_##opt##_test) \
 
 /**
  * Macro for benchmarking a 16-bit byteswap function.
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -195,7 +195,7 @@ TEST_F(ByteswapTest, rp_byte_swap_16_array_##opt##_benchmark) \
  * This version has data that is 16-bit aligned, but not 32-bit aligned,
  * and the block has an odd number of WORDs at the end.
  *
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -220,7 +220,7 @@ TEST_F(ByteswapTest, rp_byte_swap_16_array_unDWORD_##opt##_test) \
  * This version has data that is 16-bit aligned, but not 32-bit aligned,
  * and the block has an odd number of WORDs at the end.
  *
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -238,7 +238,7 @@ TEST_F(ByteswapTest, rp_byte_swap_16_array_unDWORD_##opt##_benchmark) \
 
 /**
  * Macro for testing a 32-bit byteswap function.
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -259,7 +259,7 @@ TEST_F(ByteswapTest, rp_byte_swap_32_array_##opt##_test) \
 
 /**
  * Macro for benchmarking a 32-bit byteswap function.
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -281,7 +281,7 @@ TEST_F(ByteswapTest, rp_byte_swap_32_array_##opt##_benchmark) \
  * This version has data that is 32-bit aligned, but not 64-bit aligned,
  * and the block has an odd number of DWORDs at the end.
  *
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -306,7 +306,7 @@ TEST_F(ByteswapTest, rp_byte_swap_32_array_unQWORD_##opt##_test) \
  * This version has data that is 32-bit aligned, but not 64-bit aligned,
  * and the block has an odd number of DWORDs at the end.
  *
- * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3; dispatch for the dispatch function)
+ * @param opt		Byteswap function optimization. (c, mmx, sse2, ssse3, avx2; dispatch for the dispatch function)
  * @param expr		Expression to check if this optimization can be used. (Use `true` for c.)
  * @param errmsg	Error message to display if the optimization cannot be used.
  */
@@ -368,8 +368,20 @@ DO_ARRAY_32_unQWORD_TEST	(ssse3, RP_CPU_HasSSSE3(), "*** SSSE3 is not supported
 DO_ARRAY_32_unQWORD_BENCHMARK	(ssse3, RP_CPU_HasSSSE3(), "*** SSSE3 is not supported on this CPU. Skipping test.\n")
 #endif /* BYTESWAP_HAS_SSSE3 */
 
+#ifdef BYTESWAP_HAS_AVX2
+// AVX2-optimized tests.
+DO_ARRAY_16_TEST		(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+DO_ARRAY_16_BENCHMARK		(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+DO_ARRAY_16_unDWORD_TEST	(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+DO_ARRAY_16_unDWORD_BENCHMARK	(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+DO_ARRAY_32_TEST		(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+DO_ARRAY_32_BENCHMARK		(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+DO_ARRAY_32_unQWORD_TEST	(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+DO_ARRAY_32_unQWORD_BENCHMARK	(avx2, RP_CPU_HasAVX2(), "*** AVX2 is not supported on this CPU. Skipping test.\n")
+#endif /* BYTESWAP_HAS_AVX2 */
+
 // NOTE: Add more instruction sets to the #ifdef if other optimizations are added.
-#if defined(BYTESWAP_HAS_MMX) || defined(BYTESWAP_HAS_SSE2) || defined(BYTESWAP_HAS_SSSE3)
+#if defined(BYTESWAP_HAS_MMX) || defined(BYTESWAP_HAS_SSE2) || defined(BYTESWAP_HAS_SSSE3) || defined(BYTESWAP_HAS_AVX2)
 // Dispatch functions.
 DO_ARRAY_16_TEST		(dispatch, true, "")
 DO_ARRAY_16_BENCHMARK		(dispatch, true, "")
@@ -379,7 +391,7 @@ DO_ARRAY_32_TEST		(dispatch, true, "")
 DO_ARRAY_32_BENCHMARK		(dispatch, true, "")
 DO_ARRAY_32_unQWORD_TEST	(dispatch, true, "")
 DO_ARRAY_32_unQWORD_BENCHMARK	(dispatch, true, "")
-#endif /* BYTESWAP_HAS_MMX || BYTESWAP_HAS_SSE2 || BYTESWAP_HAS_SSSE3 */
+#endif /* BYTESWAP_HAS_MMX || BYTESWAP_HAS_SSE2 || BYTESWAP_HAS_SSSE3 || BYTESWAP_HAS_AVX2 */
 
 } }
 
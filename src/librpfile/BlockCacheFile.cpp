@@ -0,0 +1,454 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * BlockCacheFile.cpp: IRpFile decorator that caches aligned blocks.       *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "BlockCacheFile.hpp"
+
+// C++ includes
+#include <iterator>
+
+namespace LibRpFile {
+
+// Maximum read-ahead, in blocks. (512 KiB)
+// Read-ahead starts at one block and doubles for
+// each sequential cache miss.
+static const unsigned int BLOCKCACHE_MAX_READAHEAD = 8;
+
+// Reads this large are passed through to the underlying file.
+static const size_t BLOCKCACHE_DIRECT_READ_SIZE = 1024U * 1024U;
+
+/**
+ * Cache reads from a slow IRpFile in aligned blocks.
+ *
+ * This is intended for non-local files, e.g. GVfs and KIO,
+ * where each read is a round trip to another process.
+ * Blocks are read in BlockCacheFile::BLOCK_SIZE units, and
+ * sequential access increases the read-ahead size.
+ *
+ * @param file IRpFile (will be ref()'d)
+ * @param maxBlocks Maximum number of cached blocks
+ */
+BlockCacheFile::BlockCacheFile(IRpFile *file, unsigned int maxBlocks)
+	: m_file(nullptr)
+	, m_pos(0)
+	, m_size(-1)
+	, m_maxBlocks(maxBlocks > 0 ? maxBlocks : 1)
+	, m_nextSeqBlock(~0ULL)
+	, m_readAhead(0)
+{
+	if (!file) {
+		m_lastError = EBADF;
+		return;
+	}
+
+	m_file = file->ref();
+	m_isWritable = file->isWritable();
+	m_isCompressed = file->isCompressed();
+	m_isRemote = file->isRemote();
+	m_fileType = file->fileType();
+
+	if (!file->isOpen()) {
+		// File isn't open. Don't bother checking the size.
+		return;
+	}
+
+	// NOTE: The file size is cached, since it may
+	// be a round trip for non-local files.
+	// If the size isn't available, reads aren't cached.
+	m_size = file->size();
+	m_pos = file->tell();
+	if (m_pos < 0) {
+		m_pos = 0;
+	}
+}
+
+BlockCacheFile::~BlockCacheFile()
+{
+	UNREF(m_file);
+}
+
+/**
+ * Get a cached block, and mark it as most-recently-used.
+ * @param idx Block index
+ * @return Block, or nullptr if it isn't cached.
+ */
+const BlockCacheFile::Block *BlockCacheFile::findBlock(uint64_t idx)
+{
+	auto iter = m_blockMap.find(idx);
+	if (iter == m_blockMap.end()) {
+		return nullptr;
+	}
+
+	// Move the block to the front of the list.
+	// NOTE: splice() doesn't invalidate iterators.
+	m_blocks.splice(m_blocks.begin(), m_blocks, iter->second);
+	return &m_blocks.front();
+}
+
+/**
+ * Add a block to the cache as the most-recently-used block.
+ * If the cache is full, the least-recently-used block is replaced.
+ * @param idx Block index
+ * @param data Block data
+ * @param size Size of the block data
+ */
+void BlockCacheFile::insertBlock(uint64_t idx, const uint8_t *data, size_t size)
+{
+	auto iter = m_blockMap.find(idx);
+	if (iter != m_blockMap.end()) {
+		// Block is already cached. Replace its data.
+		m_blocks.splice(m_blocks.begin(), m_blocks, iter->second);
+	} else if (m_blocks.size() >= m_maxBlocks) {
+		// Cache is full. Reuse the least-recently-used block.
+		m_blockMap.erase(m_blocks.back().idx);
+		m_blocks.splice(m_blocks.begin(), m_blocks, std::prev(m_blocks.end()));
+		m_blockMap.emplace(idx, m_blocks.begin());
+	} else {
+		m_blocks.emplace_front();
+		m_blockMap.emplace(idx, m_blocks.begin());
+	}
+
+	Block &block = m_blocks.front();
+	block.idx = idx;
+	block.data.assign(data, data + size);
+}
+
+/**
+ * Read blocks from the underlying file.
+ * Read-ahead is added if access is sequential.
+ * @param idx First block index
+ * @param count Number of blocks needed by the caller
+ * @return First block, or nullptr on error.
+ */
+const BlockCacheFile::Block *BlockCacheFile::fetchBlocks(uint64_t idx, unsigned int count)
+{
+	// Increase the read-ahead if this miss continues the last fetch.
+	if (idx == m_nextSeqBlock) {
+		m_readAhead = (m_readAhead > 0)
+			? std::min(m_readAhead * 2, BLOCKCACHE_MAX_READAHEAD)
+			: 1;
+	} else {
+		m_readAhead = 0;
+	}
+
+	// Don't fetch more than half of the cache at once,
+	// and don't fetch past the end of the file.
+	uint64_t total = static_cast<uint64_t>(count) + m_readAhead;
+	total = std::min<uint64_t>(total, std::max(m_maxBlocks / 2, 1U));
+	const uint64_t lastIdx = static_cast<uint64_t>(m_size - 1) / BLOCK_SIZE;
+	if (idx > lastIdx) {
+		return nullptr;
+	}
+	total = std::min(total, lastIdx - idx + 1);
+
+	// Stop at the first block that's already cached.
+	for (uint64_t i = 1; i < total; i++) {
+		if (m_blockMap.find(idx + i) != m_blockMap.end()) {
+			total = i;
+			break;
+		}
+	}
+
+	// Read the blocks using a single read, if possible.
+	const off64_t pos = static_cast<off64_t>(idx * BLOCK_SIZE);
+	const size_t len = static_cast<size_t>(std::min<off64_t>(
+		static_cast<off64_t>(total * BLOCK_SIZE), m_size - pos));
+	if (m_file->seek(pos) != 0) {
+		m_lastError = m_file->lastError();
+		return nullptr;
+	}
+	m_fetchBuf.resize(len);
+	size_t got = 0;
+	while (got < len) {
+		// NOTE: Some backends, e.g. GIO, may return fewer
+		// bytes than requested even if they aren't at EOF.
+		const size_t ret = m_file->read(&m_fetchBuf[got], len - got);
+		if (ret == 0)
+			break;
+		got += ret;
+	}
+	if (got < len) {
+		m_lastError = m_file->lastError();
+		if (m_lastError == 0) {
+			m_lastError = EIO;
+		}
+	}
+
+	// Add the blocks to the cache in reverse order, so the
+	// first block is the most-recently-used block.
+	// Partial blocks are only cached if they're at EOF.
+	for (uint64_t i = total; i > 0; i--) {
+		const size_t b_pos = static_cast<size_t>((i - 1) * BLOCK_SIZE);
+		if (b_pos >= got)
+			continue;
+		const size_t b_len = std::min<size_t>(got - b_pos, BLOCK_SIZE);
+		if (b_len < BLOCK_SIZE && pos + static_cast<off64_t>(b_pos + b_len) != m_size)
+			continue;
+		insertBlock(idx + i - 1, &m_fetchBuf[b_pos], b_len);
+	}
+
+	m_nextSeqBlock = idx + total;
+	return findBlock(idx);
+}
+
+/**
+ * Remove all cached blocks.
+ */
+void BlockCacheFile::clearBlocks(void)
+{
+	m_blocks.clear();
+	m_blockMap.clear();
+	m_nextSeqBlock = ~0ULL;
+	m_readAhead = 0;
+}
+
+/**
+ * Is the file open?
+ * This usually only returns false if an error occurred.
+ * @return True if the file is open; false if it isn't.
+ */
+bool BlockCacheFile::isOpen(void) const
+{
+	return (m_file != nullptr && m_file->isOpen());
+}
+
+/**
+ * Close the file.
+ */
+void BlockCacheFile::close(void)
+{
+	UNREF_AND_NULL(m_file);
+	clearBlocks();
+	m_fetchBuf.clear();
+	m_fetchBuf.shrink_to_fit();
+}
+
+/**
+ * Read data from the file.
+ * @param ptr Output data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t BlockCacheFile::read(void *ptr, size_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	if (m_size < 0) {
+		// File size isn't known. Don't cache anything.
+		if (m_file->seek(m_pos) != 0) {
+			m_lastError = m_file->lastError();
+			return 0;
+		}
+		const size_t ret = m_file->read(ptr, size);
+		m_lastError = m_file->lastError();
+		m_pos += ret;
+		return ret;
+	}
+
+	m_lastError = 0;
+	if (m_pos >= m_size) {
+		// End of file.
+		return 0;
+	}
+	if (static_cast<off64_t>(size) > m_size - m_pos) {
+		size = static_cast<size_t>(m_size - m_pos);
+	}
+	if (size == 0) {
+		return 0;
+	}
+
+	const uint64_t firstIdx = static_cast<uint64_t>(m_pos) / BLOCK_SIZE;
+	const uint64_t lastIdx = static_cast<uint64_t>(m_pos + size - 1) / BLOCK_SIZE;
+	if (size >= BLOCKCACHE_DIRECT_READ_SIZE || (lastIdx - firstIdx + 1) > m_maxBlocks / 2) {
+		// Large read. This is already a single round trip,
+		// and caching it would evict most of the cache.
+		if (m_file->seek(m_pos) != 0) {
+			m_lastError = m_file->lastError();
+			return 0;
+		}
+		const size_t ret = m_file->read(ptr, size);
+		m_lastError = m_file->lastError();
+		m_pos += ret;
+		m_nextSeqBlock = static_cast<uint64_t>(m_pos) / BLOCK_SIZE;
+		return ret;
+	}
+
+	uint8_t *p = static_cast<uint8_t*>(ptr);
+	size_t total = 0;
+	for (uint64_t idx = firstIdx; idx <= lastIdx; idx++) {
+		const Block *block = findBlock(idx);
+		if (!block) {
+			block = fetchBlocks(idx, static_cast<unsigned int>(lastIdx - idx + 1));
+			if (!block) {
+				// Read error.
+				break;
+			}
+		}
+
+		const size_t b_offset = static_cast<size_t>(m_pos - static_cast<off64_t>(idx * BLOCK_SIZE));
+		if (b_offset >= block->data.size()) {
+			// Short block. (file was truncated?)
+			break;
+		}
+		const size_t len = std::min(size, block->data.size() - b_offset);
+		memcpy(p, &block->data[b_offset], len);
+		p += len;
+		m_pos += len;
+		total += len;
+		size -= len;
+	}
+
+	return total;
+}
+
+/**
+ * Write data to the file.
+ * @param ptr Input data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes written.
+ */
+size_t BlockCacheFile::write(const void *ptr, size_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	if (m_file->seek(m_pos) != 0) {
+		m_lastError = m_file->lastError();
+		return 0;
+	}
+
+	// Cached blocks may no longer be valid.
+	clearBlocks();
+
+	const size_t ret = m_file->write(ptr, size);
+	m_lastError = m_file->lastError();
+	m_pos += ret;
+	m_size = m_file->size();
+	return ret;
+}
+
+/**
+ * Set the file position.
+ * NOTE: The underlying file isn't seeked until
+ * data that isn't cached is read or written.
+ * @param pos File position.
+ * @return 0 on success; -1 on error.
+ */
+int BlockCacheFile::seek(off64_t pos)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	} else if (pos < 0) {
+		m_lastError = EINVAL;
+		return -1;
+	}
+
+	m_pos = pos;
+	return 0;
+}
+
+/**
+ * Get the file position.
+ * @return File position, or -1 on error.
+ */
+off64_t BlockCacheFile::tell(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return m_pos;
+}
+
+/**
+ * Truncate the file.
+ * @param size New size. (default is 0)
+ * @return 0 on success; -1 on error.
+ */
+int BlockCacheFile::truncate(off64_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	// Cached blocks may no longer be valid.
+	clearBlocks();
+
+	const int ret = m_file->truncate(size);
+	m_lastError = m_file->lastError();
+	m_size = m_file->size();
+	return ret;
+}
+
+/**
+ * Flush buffers.
+ * This operation only makes sense on writable files.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int BlockCacheFile::flush(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+
+	return m_file->flush();
+}
+
+/** File properties **/
+
+/**
+ * Get the file size.
+ * @return File size, or negative on error.
+ */
+off64_t BlockCacheFile::size(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return (m_size >= 0 ? m_size : m_file->size());
+}
+
+/**
+ * Get the filename.
+ * @return Filename. (May be nullptr if the filename is not available.)
+ */
+const char *BlockCacheFile::filename(void) const
+{
+	return (m_file ? m_file->filename() : nullptr);
+}
+
+/** Extra functions **/
+
+/**
+ * Make the file writable.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int BlockCacheFile::makeWritable(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+
+	const int ret = m_file->makeWritable();
+	m_isWritable = m_file->isWritable();
+	return ret;
+}
+
+}
@@ -0,0 +1,197 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * BlockCacheFile.hpp: IRpFile decorator that caches aligned blocks.       *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "IRpFile.hpp"
+
+// C++ includes
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace LibRpFile {
+
+class RP_LIBROMDATA_PUBLIC BlockCacheFile final : public IRpFile
+{
+	public:
+		// Block size. Reads from the underlying file are aligned to this size.
+		static const unsigned int BLOCK_SIZE = 64U * 1024U;
+		// Default maximum number of cached blocks. (4 MiB)
+		static const unsigned int DEFAULT_MAX_BLOCKS = 64;
+
+	public:
+		/**
+		 * Cache reads from a slow IRpFile in aligned blocks.
+		 *
+		 * This is intended for non-local files, e.g. GVfs and KIO,
+		 * where each read is a round trip to another process.
+		 * Blocks are read in BlockCacheFile::BLOCK_SIZE units, and
+		 * sequential access increases the read-ahead size.
+		 *
+		 * @param file IRpFile (will be ref()'d)
+		 * @param maxBlocks Maximum number of cached blocks
+		 */
+		explicit BlockCacheFile(IRpFile *file, unsigned int maxBlocks = DEFAULT_MAX_BLOCKS);
+	protected:
+		~BlockCacheFile() final;	// call unref() instead
+
+	private:
+		typedef IRpFile super;
+		RP_DISABLE_COPY(BlockCacheFile)
+
+	public:
+		/**
+		 * Is the file open?
+		 * This usually only returns false if an error occurred.
+		 * @return True if the file is open; false if it isn't.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * Close the file.
+		 */
+		void close(void) final;
+
+		/**
+		 * Read data from the file.
+		 * @param ptr Output data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		ATTR_ACCESS_SIZE(write_only, 2, 3)
+		size_t read(void *ptr, size_t size) final;
+
+		/**
+		 * Write data to the file.
+		 * @param ptr Input data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes written.
+		 */
+		ATTR_ACCESS_SIZE(read_only, 2, 3)
+		size_t write(const void *ptr, size_t size) final;
+
+		/**
+		 * Set the file position.
+		 * @param pos File position.
+		 * @return 0 on success; -1 on error.
+		 */
+		int seek(off64_t pos) final;
+
+		/**
+		 * Get the file position.
+		 * @return File position, or -1 on error.
+		 */
+		off64_t tell(void) final;
+
+		/**
+		 * Truncate the file.
+		 * @param size New size. (default is 0)
+		 * @return 0 on success; -1 on error.
+		 */
+		int truncate(off64_t size = 0) final;
+
+		/**
+		 * Flush buffers.
+		 * This operation only makes sense on writable files.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int flush(void) final;
+
+	public:
+		/** File properties **/
+
+		/**
+		 * Get the file size.
+		 * @return File size, or negative on error.
+		 */
+		off64_t size(void) final;
+
+		/**
+		 * Get the filename.
+		 * @return Filename. (May be nullptr if the filename is not available.)
+		 */
+		const char *filename(void) const final;
+
+	public:
+		/** Extra functions **/
+
+		/**
+		 * Make the file writable.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int makeWritable(void) final;
+
+	public:
+		/** Cache functions **/
+
+		/**
+		 * Get the underlying IRpFile.
+		 * NOTE: Reads from the underlying file bypass the cache,
+		 * and its file position is not kept in sync.
+		 * @return Underlying IRpFile (not ref()'d), or nullptr if closed.
+		 */
+		IRpFile *baseFile(void) const final
+		{
+			return m_file;
+		}
+
+	private:
+		struct Block {
+			uint64_t idx;			// Block index
+			std::vector<uint8_t> data;	// Block data (shorter than BLOCK_SIZE at EOF)
+		};
+		typedef std::list<Block> BlockList;
+
+		/**
+		 * Get a cached block, and mark it as most-recently-used.
+		 * @param idx Block index
+		 * @return Block, or nullptr if it isn't cached.
+		 */
+		const Block *findBlock(uint64_t idx);
+
+		/**
+		 * Read blocks from the underlying file.
+		 * Read-ahead is added if access is sequential.
+		 * @param idx First block index
+		 * @param count Number of blocks needed by the caller
+		 * @return First block, or nullptr on error.
+		 */
+		const Block *fetchBlocks(uint64_t idx, unsigned int count);
+
+		/**
+		 * Add a block to the cache as the most-recently-used block.
+		 * If the cache is full, the least-recently-used block is replaced.
+		 * @param idx Block index
+		 * @param data Block data
+		 * @param size Size of the block data
+		 */
+		void insertBlock(uint64_t idx, const uint8_t *data, size_t size);
+
+		/**
+		 * Remove all cached blocks.
+		 */
+		void clearBlocks(void);
+
+	protected:
+		IRpFile *m_file;
+		off64_t m_pos;		// Current position
+		off64_t m_size;		// File size (cached)
+		unsigned int m_maxBlocks;
+
+		// Cached blocks, ordered from most-recently-used to least-recently-used.
+		BlockList m_blocks;
+		std::unordered_map<uint64_t, BlockList::iterator> m_blockMap;
+		std::vector<uint8_t> m_fetchBuf;	// Buffer for reading from the underlying file
+
+		// Sequential access detection.
+		uint64_t m_nextSeqBlock;	// Block after the last fetch
+		unsigned int m_readAhead;	// Current read-ahead, in blocks
+};
+
+}
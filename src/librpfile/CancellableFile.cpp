@@ -0,0 +1,228 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * CancellableFile.cpp: IRpFile decorator that can abort pending reads.    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "CancellableFile.hpp"
+
+namespace LibRpFile {
+
+/**
+ * IRpFile wrapper that fails all reads once it has been cancelled.
+ *
+ * This is used by RomDataLoader and the property page providers,
+ * so a RomData object that's still loading on a worker thread
+ * can be abandoned without waiting for a slow read to finish.
+ *
+ * The cancellation flag is owned by the file, since the RomData
+ * object keeps a reference to the file after the loader is gone.
+ *
+ * @param file IRpFile (will be ref()'d)
+ */
+CancellableFile::CancellableFile(IRpFile *file)
+	: m_file(nullptr)
+	, m_cancelled(false)
+{
+	if (!file) {
+		m_lastError = EBADF;
+		return;
+	}
+
+	m_file = file->ref();
+	m_isWritable = file->isWritable();
+	m_isCompressed = file->isCompressed();
+	m_isRemote = file->isRemote();
+	m_fileType = file->fileType();
+}
+
+CancellableFile::~CancellableFile()
+{
+	UNREF(m_file);
+}
+
+/**
+ * Is the file open?
+ * This usually only returns false if an error occurred.
+ * @return True if the file is open; false if it isn't.
+ */
+bool CancellableFile::isOpen(void) const
+{
+	return (m_file != nullptr && m_file->isOpen());
+}
+
+/**
+ * Close the file.
+ */
+void CancellableFile::close(void)
+{
+	UNREF_AND_NULL(m_file);
+}
+
+/**
+ * Read data from the file.
+ * @param ptr Output data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t CancellableFile::read(void *ptr, size_t size)
+{
+	if (m_cancelled) {
+		m_lastError = ECANCELED;
+		return 0;
+	} else if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	const size_t ret = m_file->read(ptr, size);
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/**
+ * Write data to the file.
+ * @param ptr Input data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes written.
+ */
+size_t CancellableFile::write(const void *ptr, size_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	const size_t ret = m_file->write(ptr, size);
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/**
+ * Set the file position.
+ * @param pos File position.
+ * @return 0 on success; -1 on error.
+ */
+int CancellableFile::seek(off64_t pos)
+{
+	if (m_cancelled) {
+		m_lastError = ECANCELED;
+		return -1;
+	} else if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	const int ret = m_file->seek(pos);
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/**
+ * Get the file position.
+ * @return File position, or -1 on error.
+ */
+off64_t CancellableFile::tell(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+	return m_file->tell();
+}
+
+/**
+ * Truncate the file.
+ * @param size New size. (default is 0)
+ * @return 0 on success; -1 on error.
+ */
+int CancellableFile::truncate(off64_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	const int ret = m_file->truncate(size);
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/**
+ * Flush buffers.
+ * This operation only makes sense on writable files.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int CancellableFile::flush(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+	return m_file->flush();
+}
+
+/** File properties **/
+
+/**
+ * Get the file size.
+ * @return File size, or negative on error.
+ */
+off64_t CancellableFile::size(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+	return m_file->size();
+}
+
+/**
+ * Get the filename.
+ * @return Filename. (May be nullptr if the filename is not available.)
+ */
+const char *CancellableFile::filename(void) const
+{
+	return (m_file ? m_file->filename() : nullptr);
+}
+
+/** Extra functions **/
+
+/**
+ * Make the file writable.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int CancellableFile::makeWritable(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+
+	const int ret = m_file->makeWritable();
+	m_isWritable = m_file->isWritable();
+	return ret;
+}
+
+/** Cancellation **/
+
+/**
+ * Find the CancellableFile in a chain of IRpFile decorators.
+ * @param file IRpFile
+ * @return CancellableFile (not ref()'d), or nullptr if not found.
+ */
+CancellableFile *CancellableFile::find(IRpFile *file)
+{
+	for (; file != nullptr; file = file->baseFile()) {
+		CancellableFile *const cfile = dynamic_cast<CancellableFile*>(file);
+		if (cfile) {
+			return cfile;
+		}
+	}
+	return nullptr;
+}
+
+}
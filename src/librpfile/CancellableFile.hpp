@@ -0,0 +1,164 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * CancellableFile.hpp: IRpFile decorator that can abort pending reads.    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "IRpFile.hpp"
+
+namespace LibRpFile {
+
+class RP_LIBROMDATA_PUBLIC CancellableFile final : public IRpFile
+{
+	public:
+		/**
+		 * IRpFile wrapper that fails all reads once it has been cancelled.
+		 *
+		 * This is used by RomDataLoader and the property page providers,
+		 * so a RomData object that's still loading on a worker thread
+		 * can be abandoned without waiting for a slow read to finish.
+		 *
+		 * The cancellation flag is owned by the file, since the RomData
+		 * object keeps a reference to the file after the loader is gone.
+		 *
+		 * @param file IRpFile (will be ref()'d)
+		 */
+		explicit CancellableFile(IRpFile *file);
+	protected:
+		~CancellableFile() final;	// call unref() instead
+
+	private:
+		typedef IRpFile super;
+		RP_DISABLE_COPY(CancellableFile)
+
+	public:
+		/**
+		 * Is the file open?
+		 * This usually only returns false if an error occurred.
+		 * @return True if the file is open; false if it isn't.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * Close the file.
+		 */
+		void close(void) final;
+
+		/**
+		 * Read data from the file.
+		 * @param ptr Output data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		ATTR_ACCESS_SIZE(write_only, 2, 3)
+		size_t read(void *ptr, size_t size) final;
+
+		/**
+		 * Write data to the file.
+		 * @param ptr Input data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes written.
+		 */
+		ATTR_ACCESS_SIZE(read_only, 2, 3)
+		size_t write(const void *ptr, size_t size) final;
+
+		/**
+		 * Set the file position.
+		 * @param pos File position.
+		 * @return 0 on success; -1 on error.
+		 */
+		int seek(off64_t pos) final;
+
+		/**
+		 * Get the file position.
+		 * @return File position, or -1 on error.
+		 */
+		off64_t tell(void) final;
+
+		/**
+		 * Truncate the file.
+		 * @param size New size. (default is 0)
+		 * @return 0 on success; -1 on error.
+		 */
+		int truncate(off64_t size = 0) final;
+
+		/**
+		 * Flush buffers.
+		 * This operation only makes sense on writable files.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int flush(void) final;
+
+	public:
+		/** File properties **/
+
+		/**
+		 * Get the file size.
+		 * @return File size, or negative on error.
+		 */
+		off64_t size(void) final;
+
+		/**
+		 * Get the filename.
+		 * @return Filename. (May be nullptr if the filename is not available.)
+		 */
+		const char *filename(void) const final;
+
+	public:
+		/** Extra functions **/
+
+		/**
+		 * Make the file writable.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int makeWritable(void) final;
+
+		/**
+		 * Get the underlying IRpFile.
+		 * @return Underlying IRpFile (not ref()'d), or nullptr if closed.
+		 */
+		IRpFile *baseFile(void) const final
+		{
+			return m_file;
+		}
+
+	public:
+		/** Cancellation **/
+
+		/**
+		 * Cancel all further reads and seeks.
+		 * A read that's already in progress on the underlying
+		 * file will finish, but its caller will see an error
+		 * on the next read or seek.
+		 */
+		inline void cancel(void)
+		{
+			m_cancelled = true;
+		}
+
+		/**
+		 * Has the file been cancelled?
+		 * @return True if cancelled; false if not.
+		 */
+		inline bool isCancelled(void) const
+		{
+			return m_cancelled;
+		}
+
+		/**
+		 * Find the CancellableFile in a chain of IRpFile decorators.
+		 * @param file IRpFile
+		 * @return CancellableFile (not ref()'d), or nullptr if not found.
+		 */
+		static CancellableFile *find(IRpFile *file);
+
+	private:
+		IRpFile *m_file;
+		volatile bool m_cancelled;
+};
+
+}
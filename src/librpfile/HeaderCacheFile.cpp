@@ -0,0 +1,407 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * HeaderCacheFile.cpp: IRpFile decorator that caches small reads.         *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "HeaderCacheFile.hpp"
+
+// C++ STL classes
+using std::vector;
+
+namespace LibRpFile {
+
+/**
+ * Cache small reads from an IRpFile.
+ *
+ * This is used by RomDataFactory so the ROM header,
+ * footer, and any other small windows read while
+ * detecting the file type are only read once, even
+ * though the RomData subclass constructor usually
+ * reads the same data again.
+ *
+ * @param file IRpFile (will be ref()'d)
+ */
+HeaderCacheFile::HeaderCacheFile(IRpFile *file)
+	: m_file(nullptr)
+	, m_pos(0)
+	, m_filePos(-1)
+	, m_cacheSize(0)
+{
+	if (!file) {
+		m_lastError = EBADF;
+		return;
+	}
+
+	m_file = file->ref();
+	m_isWritable = file->isWritable();
+	m_isCompressed = file->isCompressed();
+	m_isRemote = file->isRemote();
+	m_fileType = file->fileType();
+
+	m_pos = file->tell();
+	if (m_pos < 0) {
+		m_pos = 0;
+	} else {
+		m_filePos = m_pos;
+	}
+}
+
+HeaderCacheFile::~HeaderCacheFile()
+{
+	UNREF(m_file);
+}
+
+/**
+ * Seek the underlying file to m_pos if necessary.
+ * @return 0 on success; -1 on error.
+ */
+int HeaderCacheFile::syncFilePos(void)
+{
+	if (m_filePos == m_pos) {
+		// Already at the correct position.
+		return 0;
+	}
+
+	const int ret = m_file->seek(m_pos);
+	if (ret != 0) {
+		m_lastError = m_file->lastError();
+		m_filePos = -1;
+		return ret;
+	}
+	m_filePos = m_pos;
+	return 0;
+}
+
+/**
+ * Remove cached windows that overlap the specified range.
+ * @param pos Starting position
+ * @param size Size, in bytes
+ */
+void HeaderCacheFile::invalidate(off64_t pos, size_t size)
+{
+	const off64_t end = pos + static_cast<off64_t>(size);
+
+	// Start with the last window that begins at or before pos,
+	// since it may extend into the range.
+	auto iter = m_windows.upper_bound(pos);
+	if (iter != m_windows.begin()) {
+		--iter;
+	}
+	while (iter != m_windows.end() && iter->first < end) {
+		const off64_t w_end = iter->first + static_cast<off64_t>(iter->second.data.size());
+		if (pos < w_end) {
+			m_cacheSize -= iter->second.data.size();
+			m_lru.erase(iter->second.lru);
+			iter = m_windows.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+/**
+ * Add data to the cache.
+ * Overlapping and adjacent windows are merged, and the
+ * least-recently-used windows are evicted if necessary.
+ * @param pos Starting position
+ * @param data Data
+ * @param size Size, in bytes
+ */
+void HeaderCacheFile::addWindow(off64_t pos, const uint8_t *data, size_t size)
+{
+	// Find windows that overlap or are adjacent to the new data.
+	const off64_t end = pos + static_cast<off64_t>(size);
+	auto first = m_windows.upper_bound(pos);
+	if (first != m_windows.begin()) {
+		auto prev = first;
+		--prev;
+		if (prev->first + static_cast<off64_t>(prev->second.data.size()) >= pos) {
+			first = prev;
+		}
+	}
+	auto last = first;
+	off64_t merge_start = pos;
+	off64_t merge_end = end;
+	for (; last != m_windows.end() && last->first <= end; ++last) {
+		merge_start = std::min(merge_start, last->first);
+		merge_end = std::max(merge_end, last->first + static_cast<off64_t>(last->second.data.size()));
+	}
+
+	const size_t merge_size = static_cast<size_t>(merge_end - merge_start);
+	if (merge_size > MAX_TOTAL_SIZE) {
+		// Merged window would be too big to cache.
+		// The existing windows are still valid, so keep them.
+		return;
+	}
+
+	// Merge the existing windows with the new data.
+	// NOTE: The new data is copied last, though it should
+	// match the existing windows anyway.
+	Window window;
+	window.data.resize(merge_size);
+	for (auto iter = first; iter != last; ) {
+		const vector<uint8_t> &w_data = iter->second.data;
+		memcpy(&window.data[static_cast<size_t>(iter->first - merge_start)], w_data.data(), w_data.size());
+		m_cacheSize -= w_data.size();
+		m_lru.erase(iter->second.lru);
+		iter = m_windows.erase(iter);
+	}
+	memcpy(&window.data[static_cast<size_t>(pos - merge_start)], data, size);
+
+	// Evict the least-recently-used windows until the new window fits.
+	while (m_cacheSize + merge_size > MAX_TOTAL_SIZE && !m_lru.empty()) {
+		auto iter = m_windows.find(m_lru.front());
+		assert(iter != m_windows.end());
+		m_cacheSize -= iter->second.data.size();
+		m_windows.erase(iter);
+		m_lru.pop_front();
+	}
+
+	window.lru = m_lru.insert(m_lru.end(), merge_start);
+	m_windows.emplace(merge_start, std::move(window));
+	m_cacheSize += merge_size;
+}
+
+/**
+ * Clear all cached windows.
+ */
+void HeaderCacheFile::clearWindows(void)
+{
+	m_windows.clear();
+	m_lru.clear();
+	m_cacheSize = 0;
+}
+
+/**
+ * Is the file open?
+ * This usually only returns false if an error occurred.
+ * @return True if the file is open; false if it isn't.
+ */
+bool HeaderCacheFile::isOpen(void) const
+{
+	return (m_file != nullptr && m_file->isOpen());
+}
+
+/**
+ * Close the file.
+ */
+void HeaderCacheFile::close(void)
+{
+	UNREF_AND_NULL(m_file);
+	clearWindows();
+}
+
+/**
+ * Read data from the file.
+ * @param ptr Output data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t HeaderCacheFile::read(void *ptr, size_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	// Copy as much as possible from the cached windows.
+	uint8_t *p = static_cast<uint8_t*>(ptr);
+	size_t total = 0;
+	while (size > 0) {
+		// Find the window that contains m_pos, if any.
+		auto iter = m_windows.upper_bound(m_pos);
+		if (iter == m_windows.begin()) {
+			// Not cached.
+			break;
+		}
+		--iter;
+		Window &window = iter->second;
+		const size_t w_offset = static_cast<size_t>(m_pos - iter->first);
+		if (w_offset >= window.data.size()) {
+			// Not cached.
+			break;
+		}
+
+		// Mark this window as most-recently-used.
+		m_lru.splice(m_lru.end(), m_lru, window.lru);
+
+		const size_t len = std::min(size, window.data.size() - w_offset);
+		memcpy(p, &window.data[w_offset], len);
+		p += len;
+		m_pos += len;
+		total += len;
+		size -= len;
+	}
+
+	if (size == 0) {
+		// Everything was cached.
+		m_lastError = 0;
+		return total;
+	}
+
+	// Read the rest of the data from the file.
+	if (syncFilePos() != 0) {
+		return total;
+	}
+	const size_t ret = m_file->read(p, size);
+	m_lastError = m_file->lastError();
+
+	if (ret > 0 && size <= MAX_READ_SIZE) {
+		// Small read. Cache it.
+		addWindow(m_pos, p, ret);
+	}
+
+	m_pos += ret;
+	m_filePos = m_pos;
+	return total + ret;
+}
+
+/**
+ * Write data to the file.
+ * @param ptr Input data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes written.
+ */
+size_t HeaderCacheFile::write(const void *ptr, size_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	if (syncFilePos() != 0) {
+		return 0;
+	}
+
+	// Cached windows for this range are no longer valid.
+	invalidate(m_pos, size);
+
+	const size_t ret = m_file->write(ptr, size);
+	m_lastError = m_file->lastError();
+	m_pos += ret;
+	m_filePos = m_pos;
+	return ret;
+}
+
+/**
+ * Set the file position.
+ * NOTE: The underlying file isn't seeked until
+ * data that isn't cached is read or written.
+ * @param pos File position.
+ * @return 0 on success; -1 on error.
+ */
+int HeaderCacheFile::seek(off64_t pos)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	} else if (pos < 0) {
+		m_lastError = EINVAL;
+		return -1;
+	}
+
+	m_pos = pos;
+	return 0;
+}
+
+/**
+ * Get the file position.
+ * @return File position, or -1 on error.
+ */
+off64_t HeaderCacheFile::tell(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return m_pos;
+}
+
+/**
+ * Truncate the file.
+ * @param size New size. (default is 0)
+ * @return 0 on success; -1 on error.
+ */
+int HeaderCacheFile::truncate(off64_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	// Cached windows may no longer be valid.
+	clearWindows();
+
+	const int ret = m_file->truncate(size);
+	m_lastError = m_file->lastError();
+	m_filePos = -1;
+	return ret;
+}
+
+/**
+ * Flush buffers.
+ * This operation only makes sense on writable files.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int HeaderCacheFile::flush(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+
+	return m_file->flush();
+}
+
+/** File properties **/
+
+/**
+ * Get the file size.
+ * @return File size, or negative on error.
+ */
+off64_t HeaderCacheFile::size(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return m_file->size();
+}
+
+/**
+ * Get the filename.
+ * @return Filename. (May be nullptr if the filename is not available.)
+ */
+const char *HeaderCacheFile::filename(void) const
+{
+	return (m_file ? m_file->filename() : nullptr);
+}
+
+/** Extra functions **/
+
+/**
+ * Make the file writable.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int HeaderCacheFile::makeWritable(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+
+	// NOTE: The file may be reopened, so the
+	// underlying file position is unknown.
+	const int ret = m_file->makeWritable();
+	m_isWritable = m_file->isWritable();
+	m_filePos = -1;
+	return ret;
+}
+
+}
@@ -0,0 +1,192 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * HeaderCacheFile.hpp: IRpFile decorator that caches small reads.         *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "IRpFile.hpp"
+
+// C++ includes
+#include <list>
+#include <map>
+#include <vector>
+
+namespace LibRpFile {
+
+class RP_LIBROMDATA_PUBLIC HeaderCacheFile final : public IRpFile
+{
+	public:
+		// Reads up to this size are cached.
+		// This covers the RomDataFactory header and footer reads,
+		// plus most header reads done by RomData subclasses.
+		static const size_t MAX_READ_SIZE = 16U * 1024U;
+		// Maximum total size of all cached windows.
+		// If this is exceeded, the least-recently-used windows are evicted.
+		static const size_t MAX_TOTAL_SIZE = 256U * 1024U;
+
+	public:
+		/**
+		 * Cache small reads from an IRpFile.
+		 *
+		 * This is used by RomDataFactory so the ROM header,
+		 * footer, and any other small windows read while
+		 * detecting the file type are only read once, even
+		 * though the RomData subclass constructor usually
+		 * reads the same data again.
+		 *
+		 * @param file IRpFile (will be ref()'d)
+		 */
+		explicit HeaderCacheFile(IRpFile *file);
+	protected:
+		~HeaderCacheFile() final;	// call unref() instead
+
+	private:
+		typedef IRpFile super;
+		RP_DISABLE_COPY(HeaderCacheFile)
+
+	public:
+		/**
+		 * Is the file open?
+		 * This usually only returns false if an error occurred.
+		 * @return True if the file is open; false if it isn't.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * Close the file.
+		 */
+		void close(void) final;
+
+		/**
+		 * Read data from the file.
+		 * @param ptr Output data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		ATTR_ACCESS_SIZE(write_only, 2, 3)
+		size_t read(void *ptr, size_t size) final;
+
+		/**
+		 * Write data to the file.
+		 * @param ptr Input data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes written.
+		 */
+		ATTR_ACCESS_SIZE(read_only, 2, 3)
+		size_t write(const void *ptr, size_t size) final;
+
+		/**
+		 * Set the file position.
+		 * @param pos File position.
+		 * @return 0 on success; -1 on error.
+		 */
+		int seek(off64_t pos) final;
+
+		/**
+		 * Get the file position.
+		 * @return File position, or -1 on error.
+		 */
+		off64_t tell(void) final;
+
+		/**
+		 * Truncate the file.
+		 * @param size New size. (default is 0)
+		 * @return 0 on success; -1 on error.
+		 */
+		int truncate(off64_t size = 0) final;
+
+		/**
+		 * Flush buffers.
+		 * This operation only makes sense on writable files.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int flush(void) final;
+
+	public:
+		/** File properties **/
+
+		/**
+		 * Get the file size.
+		 * @return File size, or negative on error.
+		 */
+		off64_t size(void) final;
+
+		/**
+		 * Get the filename.
+		 * @return Filename. (May be nullptr if the filename is not available.)
+		 */
+		const char *filename(void) const final;
+
+	public:
+		/** Extra functions **/
+
+		/**
+		 * Make the file writable.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int makeWritable(void) final;
+
+	public:
+		/** Cache functions **/
+
+		/**
+		 * Get the underlying IRpFile.
+		 * NOTE: Reads from the underlying file bypass the cache,
+		 * and its file position is not kept in sync.
+		 * @return Underlying IRpFile (not ref()'d), or nullptr if closed.
+		 */
+		IRpFile *baseFile(void) const final
+		{
+			return m_file;
+		}
+
+	private:
+		/**
+		 * Seek the underlying file to m_pos if necessary.
+		 * @return 0 on success; -1 on error.
+		 */
+		int syncFilePos(void);
+
+		/**
+		 * Remove cached windows that overlap the specified range.
+		 * @param pos Starting position
+		 * @param size Size, in bytes
+		 */
+		void invalidate(off64_t pos, size_t size);
+
+		/**
+		 * Add data to the cache.
+		 * Overlapping and adjacent windows are merged, and the
+		 * least-recently-used windows are evicted if necessary.
+		 * @param pos Starting position
+		 * @param data Data
+		 * @param size Size, in bytes
+		 */
+		void addWindow(off64_t pos, const uint8_t *data, size_t size);
+
+		/**
+		 * Clear all cached windows.
+		 */
+		void clearWindows(void);
+
+	protected:
+		IRpFile *m_file;
+		off64_t m_pos;		// Current position
+		off64_t m_filePos;	// Underlying file position (-1 if unknown)
+
+		// Cached windows, keyed by address.
+		// Windows never overlap.
+		struct Window {
+			std::vector<uint8_t> data;
+			std::list<off64_t>::iterator lru;	// Position in m_lru
+		};
+		std::map<off64_t, Window> m_windows;
+		std::list<off64_t> m_lru;	// Window addresses, least-recently-used first
+		size_t m_cacheSize;		// Total size of all windows, in bytes
+};
+
+}
@@ -15,6 +15,7 @@ IRpFile::IRpFile()
 	: m_lastError(0)
 	, m_isWritable(false)
 	, m_isCompressed(false)
+	, m_isRemote(false)
 	, m_fileType(DT_REG)
 {
 	static_assert(sizeof(off64_t) == 8, "off64_t is not 64-bit!");
@@ -88,6 +88,17 @@ class RP_LIBROMDATA_PUBLIC IRpFile : public RefBase
 			return m_isCompressed;
 		}
 
+		/**
+		 * Is the file remote?
+		 * Remote files, e.g. files accessed using GVfs or KIO,
+		 * have a high latency for each read and seek.
+		 * @return True if remote; false if not.
+		 */
+		inline bool isRemote(void) const
+		{
+			return m_isRemote;
+		}
+
 		/**
 		 * Get the file type.
 		 * File types must be set by the IRpFile subclass.
@@ -205,6 +216,18 @@ class RP_LIBROMDATA_PUBLIC IRpFile : public RefBase
 			return -ENOTSUP;
 		}
 
+		/**
+		 * Get the underlying IRpFile, if this is a decorator,
+		 * e.g. a cache or a tracing wrapper.
+		 * NOTE: Reads from the underlying file bypass this file,
+		 * and their file positions are not kept in sync.
+		 * @return Underlying IRpFile (not ref()'d), or nullptr if this isn't a decorator.
+		 */
+		virtual IRpFile *baseFile(void) const
+		{
+			return nullptr;
+		}
+
 	public:
 		/** Convenience functions implemented for all IRpFile classes. **/
 
@@ -278,6 +301,7 @@ class RP_LIBROMDATA_PUBLIC IRpFile : public RefBase
 		int m_lastError;	// Last error number (errno)
 		bool m_isWritable;	// Is this file writable?
 		bool m_isCompressed;	// Is this file compressed?
+	bool m_isRemote;	// Is this file remote? (high latency)
 		uint8_t m_fileType;	// File type (see d_type.h)
 };
 
@@ -0,0 +1,338 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * IoTrace.cpp: I/O tracing statistics.                                    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "IoTrace.hpp"
+
+// librpthreads
+#include "librpthreads/Mutex.hpp"
+#include "librpthreads/pthread_once.h"
+using LibRpThreads::Mutex;
+using LibRpThreads::MutexLocker;
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstdlib>
+
+// C++ includes
+#include <chrono>
+#include <map>
+#include <vector>
+
+// C++ STL classes
+using std::map;
+using std::string;
+using std::vector;
+
+namespace LibRpFile { namespace IoTrace {
+
+namespace {
+
+// Default tag for reads that aren't associated with a RomData subclass.
+const char default_tag[] = "(none)";
+
+struct Event {
+	off64_t offset;
+	uint32_t size;
+	uint32_t latency_us;
+	Op op;
+	bool redundant;
+};
+
+struct TagStats {
+	uint64_t reads;
+	uint64_t bytes;
+	uint64_t seeks;
+	uint64_t tiny_reads;
+	uint64_t redundant_reads;
+	uint64_t read_time_ns;
+	uint64_t max_read_ns;
+	uint64_t events_dropped;
+	vector<Event> events;
+
+	TagStats()
+		: reads(0), bytes(0), seeks(0)
+		, tiny_reads(0), redundant_reads(0)
+		, read_time_ns(0), max_read_ns(0)
+		, events_dropped(0)
+	{ }
+};
+
+// Statistics, sorted by tag.
+// NOTE: Pointers are stored in case the statistics are
+// printed from an atexit() handler.
+Mutex *mutex = nullptr;
+map<string, TagStats> *stats = nullptr;
+
+// Is tracing enabled?
+volatile bool enabled = false;
+
+// Output filename for the atexit() handler. (nullptr for stderr)
+char *out_filename = nullptr;
+
+// Current thread's scoped tag.
+thread_local const char *scoped_tag = nullptr;
+
+// pthread_once() control variable
+pthread_once_t once_control = PTHREAD_ONCE_INIT;
+
+/**
+ * Print the statistics on exit.
+ */
+void print_stats_atexit(void)
+{
+	const string json = toJSON(false);
+	FILE *f = stderr;
+	if (out_filename) {
+		f = fopen(out_filename, "a");
+		if (!f) {
+			f = stderr;
+		}
+	}
+	fputs(json.c_str(), f);
+	fputc('\n', f);
+	if (f != stderr) {
+		fclose(f);
+	}
+}
+
+/**
+ * Initialize I/O tracing.
+ * Called by pthread_once().
+ */
+void initIoTrace(void)
+{
+	mutex = new Mutex();
+	stats = new map<string, TagStats>();
+
+	const char *const env = getenv("RP_IO_TRACE");
+	if (!env || env[0] == '\0' || !strcmp(env, "0")) {
+		// Tracing is not enabled via the environment.
+		return;
+	}
+
+	if (strcmp(env, "1") != 0 && strcmp(env, "stderr") != 0) {
+		out_filename = strdup(env);
+	}
+	enabled = true;
+	atexit(print_stats_atexit);
+}
+
+/**
+ * Escape a string for JSON output.
+ * @param s String
+ * @return Escaped string
+ */
+string json_escape(const string &s)
+{
+	string ret;
+	ret.reserve(s.size());
+	for (const char chr : s) {
+		switch (chr) {
+			case '"':	ret += "\\\""; break;
+			case '\\':	ret += "\\\\"; break;
+			default:
+				if (static_cast<uint8_t>(chr) < 0x20) {
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(chr));
+					ret += buf;
+				} else {
+					ret += chr;
+				}
+				break;
+		}
+	}
+	return ret;
+}
+
+}
+
+/**
+ * Is I/O tracing enabled?
+ * The RP_IO_TRACE environment variable is checked on the first call.
+ * @return True if enabled; false if not.
+ */
+bool isEnabled(void)
+{
+	pthread_once(&once_control, initIoTrace);
+	return enabled;
+}
+
+/**
+ * Enable or disable I/O tracing.
+ * @param enable True to enable; false to disable.
+ */
+void setEnabled(bool enable)
+{
+	pthread_once(&once_control, initIoTrace);
+	enabled = enable;
+}
+
+/**
+ * Record an I/O operation.
+ * @param tag		[in] Tag. (must be a string literal or otherwise remain valid)
+ * @param op		[in] Operation
+ * @param offset	[in] Offset
+ * @param size		[in] Size (reads only)
+ * @param latency_ns	[in] Latency, in nanoseconds
+ * @param redundant	[in] True if this exact range was already read.
+ */
+void record(const char *tag, Op op, off64_t offset, size_t size, uint64_t latency_ns, bool redundant)
+{
+	if (!isEnabled())
+		return;
+	if (!tag) {
+		tag = default_tag;
+	}
+
+	MutexLocker locker(*mutex);
+	TagStats &ts = (*stats)[tag];
+	switch (op) {
+		case Op::Read:
+			ts.reads++;
+			ts.bytes += size;
+			if (size < TINY_READ_SIZE) {
+				ts.tiny_reads++;
+			}
+			if (redundant) {
+				ts.redundant_reads++;
+			}
+			ts.read_time_ns += latency_ns;
+			if (latency_ns > ts.max_read_ns) {
+				ts.max_read_ns = latency_ns;
+			}
+			break;
+		case Op::Seek:
+			ts.seeks++;
+			break;
+		default:
+			assert(!"Invalid I/O trace operation.");
+			return;
+	}
+
+	if (ts.events.size() < MAX_EVENTS_PER_TAG) {
+		Event ev;
+		ev.offset = offset;
+		ev.size = static_cast<uint32_t>(std::min(size, static_cast<size_t>(UINT32_MAX)));
+		ev.latency_us = static_cast<uint32_t>(std::min(latency_ns / 1000, static_cast<uint64_t>(UINT32_MAX)));
+		ev.op = op;
+		ev.redundant = redundant;
+		ts.events.emplace_back(ev);
+	} else {
+		ts.events_dropped++;
+	}
+}
+
+/**
+ * Get the current time for latency measurements.
+ * @return Current time, in nanoseconds.
+ */
+uint64_t now_ns(void)
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * Get the current thread's scoped tag.
+ * @return Scoped tag, or nullptr if none is set.
+ */
+const char *scopedTag(void)
+{
+	return scoped_tag;
+}
+
+ScopedTag::ScopedTag(const char *tag)
+	: m_prevTag(scoped_tag)
+{
+	scoped_tag = tag;
+}
+
+ScopedTag::~ScopedTag()
+{
+	scoped_tag = m_prevTag;
+}
+
+/**
+ * Get the I/O statistics as JSON.
+ * @param includeEvents If true, include the individual events.
+ * @return JSON string.
+ */
+string toJSON(bool includeEvents)
+{
+	pthread_once(&once_control, initIoTrace);
+	MutexLocker locker(*mutex);
+
+	string json;
+	json.reserve(256 + (stats->size() * 256));
+	json += "{\"io_trace\":[";
+
+	char buf[256];
+	bool first = true;
+	for (const auto &p : *stats) {
+		const TagStats &ts = p.second;
+		if (!first) {
+			json += ',';
+		}
+		first = false;
+
+		json += "{\"class\":\"";
+		json += json_escape(p.first);
+		snprintf(buf, sizeof(buf), "\",\"reads\":%llu,\"bytes\":%llu,\"seeks\":%llu"
+			",\"tiny_reads\":%llu,\"redundant_reads\":%llu"
+			",\"read_time_us\":%llu,\"max_read_us\":%llu",
+			static_cast<unsigned long long>(ts.reads),
+			static_cast<unsigned long long>(ts.bytes),
+			static_cast<unsigned long long>(ts.seeks),
+			static_cast<unsigned long long>(ts.tiny_reads),
+			static_cast<unsigned long long>(ts.redundant_reads),
+			static_cast<unsigned long long>(ts.read_time_ns / 1000),
+			static_cast<unsigned long long>(ts.max_read_ns / 1000));
+		json += buf;
+
+		if (includeEvents) {
+			json += ",\"events\":[";
+			bool firstEv = true;
+			for (const Event &ev : ts.events) {
+				if (!firstEv) {
+					json += ',';
+				}
+				firstEv = false;
+
+				if (ev.op == Op::Seek) {
+					snprintf(buf, sizeof(buf), "{\"op\":\"seek\",\"offset\":%lld}",
+						static_cast<long long>(ev.offset));
+				} else {
+					snprintf(buf, sizeof(buf), "{\"op\":\"read\",\"offset\":%lld,\"size\":%u,\"us\":%u%s}",
+						static_cast<long long>(ev.offset), ev.size, ev.latency_us,
+						(ev.redundant ? ",\"redundant\":true" : ""));
+				}
+				json += buf;
+			}
+			snprintf(buf, sizeof(buf), "],\"events_dropped\":%llu",
+				static_cast<unsigned long long>(ts.events_dropped));
+			json += buf;
+		}
+		json += '}';
+	}
+
+	json += "]}";
+	return json;
+}
+
+/**
+ * Reset the I/O statistics.
+ */
+void reset(void)
+{
+	pthread_once(&once_control, initIoTrace);
+	MutexLocker locker(*mutex);
+	stats->clear();
+}
+
+} }
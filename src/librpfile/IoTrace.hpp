@@ -0,0 +1,122 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * IoTrace.hpp: I/O tracing statistics.                                    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "common.h"
+#include "dll-macros.h"	// for RP_LIBROMDATA_PUBLIC
+
+// C includes
+#include <stdint.h>
+#include <sys/types.h>	// for off64_t
+
+// C++ includes
+#include <string>
+
+namespace LibRpFile { namespace IoTrace {
+
+/**
+ * I/O tracing is disabled by default. It can be enabled by calling
+ * setEnabled(), or by setting the RP_IO_TRACE environment variable:
+ * - "1" or "stderr": Print the statistics to stderr on exit.
+ * - Any other value: Append the statistics to the specified file on exit.
+ *
+ * Reads are aggregated by tag. RomDataFactory uses the RomData
+ * class name as the tag, so the statistics show which classes
+ * issue a lot of small or redundant reads.
+ */
+
+// Reads smaller than this are considered "tiny".
+static const size_t TINY_READ_SIZE = 512;
+
+// Maximum number of events to record per tag.
+static const unsigned int MAX_EVENTS_PER_TAG = 8192;
+
+/**
+ * Is I/O tracing enabled?
+ * The RP_IO_TRACE environment variable is checked on the first call.
+ * @return True if enabled; false if not.
+ */
+RP_LIBROMDATA_PUBLIC
+bool isEnabled(void);
+
+/**
+ * Enable or disable I/O tracing.
+ * @param enable True to enable; false to disable.
+ */
+RP_LIBROMDATA_PUBLIC
+void setEnabled(bool enable);
+
+/**
+ * Operation type.
+ */
+enum class Op : uint8_t {
+	Read,
+	Seek,
+};
+
+/**
+ * Record an I/O operation.
+ * @param tag		[in] Tag. (must be a string literal or otherwise remain valid)
+ * @param op		[in] Operation
+ * @param offset	[in] Offset
+ * @param size		[in] Size (reads only)
+ * @param latency_ns	[in] Latency, in nanoseconds
+ * @param redundant	[in] True if this exact range was already read.
+ */
+RP_LIBROMDATA_PUBLIC
+void record(const char *tag, Op op, off64_t offset, size_t size, uint64_t latency_ns, bool redundant);
+
+/**
+ * Get the current time for latency measurements.
+ * @return Current time, in nanoseconds.
+ */
+RP_LIBROMDATA_PUBLIC
+uint64_t now_ns(void);
+
+/**
+ * Get the current thread's scoped tag.
+ * @return Scoped tag, or nullptr if none is set.
+ */
+RP_LIBROMDATA_PUBLIC
+const char *scopedTag(void);
+
+/**
+ * Set a tag for the current thread for the lifetime of this object.
+ * This overrides the tag in TracingFile, e.g. while RomDataFactory
+ * is trying a RomData subclass.
+ */
+class ScopedTag
+{
+	public:
+		RP_LIBROMDATA_PUBLIC
+		explicit ScopedTag(const char *tag);
+
+		RP_LIBROMDATA_PUBLIC
+		~ScopedTag();
+
+	private:
+		RP_DISABLE_COPY(ScopedTag)
+		const char *m_prevTag;
+};
+
+/**
+ * Get the I/O statistics as JSON.
+ * @param includeEvents If true, include the individual events.
+ * @return JSON string.
+ */
+RP_LIBROMDATA_PUBLIC
+std::string toJSON(bool includeEvents);
+
+/**
+ * Reset the I/O statistics.
+ */
+RP_LIBROMDATA_PUBLIC
+void reset(void);
+
+} }
@@ -154,6 +154,21 @@ class RpFile final : public IRpFile
 		 */
 		int makeWritable(void) final;
 
+		/**
+		 * Copy data from another file to the current position in this file.
+		 *
+		 * On Linux, this uses copy_file_range() or sendfile(), so the data
+		 * doesn't have to be copied through a user-space buffer. Both files
+		 * must be regular files, i.e. not gzipped and not device files.
+		 *
+		 * @param src		[in] Source file
+		 * @param srcPos	[in] Starting position in the source file
+		 * @param size		[in] Number of bytes to copy
+		 * @return Number of bytes copied, or negative POSIX error code on error. (-ENOTSUP if not supported for these files)
+		 */
+		RP_LIBROMDATA_PUBLIC
+		off64_t copyRangeFrom(RpFile *src, off64_t srcPos, off64_t size);
+
 	public:
 		/** Device file functions **/
 
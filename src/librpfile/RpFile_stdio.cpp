@@ -19,7 +19,13 @@
 // C includes
 #include <fcntl.h>	// AT_EMPTY_PATH
 #include <sys/stat.h>	// stat(), statx()
-#include <unistd.h>	// ftruncate()
+#include <unistd.h>	// ftruncate(), copy_file_range()
+#ifdef HAVE_SENDFILE
+#  include <sys/sendfile.h>
+#endif /* HAVE_SENDFILE */
+
+// C++ includes
+#include <algorithm>
 
 namespace LibRpFile {
 
@@ -649,4 +655,124 @@ int RpFile::makeWritable(void)
 	return 0;
 }
 
+/**
+ * Copy data from another file to the current position in this file.
+ *
+ * On Linux, this uses copy_file_range() or sendfile(), so the data
+ * doesn't have to be copied through a user-space buffer. Both files
+ * must be regular files, i.e. not gzipped and not device files.
+ *
+ * @param src		[in] Source file
+ * @param srcPos	[in] Starting position in the source file
+ * @param size		[in] Number of bytes to copy
+ * @return Number of bytes copied, or negative POSIX error code on error. (-ENOTSUP if not supported for these files)
+ */
+off64_t RpFile::copyRangeFrom(RpFile *src, off64_t srcPos, off64_t size)
+{
+	RP_D(RpFile);
+	assert(src != nullptr);
+	if (!d->file || !(d->mode & FM_WRITE)) {
+		// Either the file isn't open,
+		// or it's read-only.
+		m_lastError = EBADF;
+		return -EBADF;
+	} else if (!src || !src->d_ptr->file || srcPos < 0 || size < 0) {
+		m_lastError = EINVAL;
+		return -EINVAL;
+	}
+
+	const RpFilePrivate *const sd = src->d_ptr;
+	if (d->gzfd || d->devInfo || sd->gzfd || sd->devInfo) {
+		// Data has to be read or written through RpFile.
+		return -ENOTSUP;
+	}
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+	// The data is written directly to the file descriptor,
+	// so flush the stdio buffers first.
+	if (::fflush(d->file) != 0) {
+		m_lastError = errno;
+		return -m_lastError;
+	}
+	const off64_t destPos = ftello(d->file);
+	if (destPos < 0) {
+		m_lastError = errno;
+		return -m_lastError;
+	}
+
+	const int fd_in = fileno(sd->file);
+	const int fd_out = fileno(d->file);
+#ifdef HAVE_COPY_FILE_RANGE
+	bool useCopyFileRange = true;
+#else /* !HAVE_COPY_FILE_RANGE */
+	static const bool useCopyFileRange = false;
+#endif /* HAVE_COPY_FILE_RANGE */
+
+	off64_t copied = 0;
+	int err = 0;
+	while (copied < size) {
+		// Copy up to 1 GiB per call.
+		const size_t len = static_cast<size_t>(std::min<off64_t>(size - copied, 1024LL*1024*1024));
+		ssize_t ret = -1;
+		if (useCopyFileRange) {
+#ifdef HAVE_COPY_FILE_RANGE
+			loff_t off_in = srcPos + copied;
+			loff_t off_out = destPos + copied;
+			ret = copy_file_range(fd_in, &off_in, fd_out, &off_out, len, 0);
+			if (ret < 0 && copied == 0 &&
+			    (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+			{
+				// copy_file_range() isn't supported for these files,
+				// e.g. Linux 5.2 or earlier across file systems.
+				useCopyFileRange = false;
+				continue;
+			}
+#endif /* HAVE_COPY_FILE_RANGE */
+		} else {
+#ifdef HAVE_SENDFILE
+			// sendfile() writes to the current file offset.
+			if (lseek(fd_out, destPos + copied, SEEK_SET) < 0) {
+				err = errno;
+				break;
+			}
+			off_t off_in = srcPos + copied;
+			ret = sendfile(fd_out, fd_in, &off_in, len);
+			if (ret < 0 && copied == 0 && (errno == EINVAL || errno == ENOSYS)) {
+				// sendfile() isn't supported for these files.
+				err = ENOTSUP;
+				break;
+			}
+#else /* !HAVE_SENDFILE */
+			err = ENOTSUP;
+			break;
+#endif /* HAVE_SENDFILE */
+		}
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			err = errno;
+			break;
+		} else if (ret == 0) {
+			// End of the source file.
+			break;
+		}
+		copied += ret;
+	}
+
+	// Update the stdio file position.
+	fseeko(d->file, destPos + copied, SEEK_SET);
+	if (err != 0) {
+		if (err != ENOTSUP) {
+			m_lastError = err;
+		}
+		return -err;
+	}
+	return copied;
+#else /* !(HAVE_COPY_FILE_RANGE || HAVE_SENDFILE) */
+	// Not supported on this system.
+	return -ENOTSUP;
+#endif /* HAVE_COPY_FILE_RANGE || HAVE_SENDFILE */
+}
+
 }
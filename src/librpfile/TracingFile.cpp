@@ -0,0 +1,212 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * TracingFile.cpp: IRpFile decorator that records I/O statistics.         *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "TracingFile.hpp"
+#include "IoTrace.hpp"
+
+namespace LibRpFile {
+
+/**
+ * Trace all reads and seeks on an IRpFile.
+ * Operations are recorded using IoTrace.
+ * @param file IRpFile (will be ref()'d)
+ * @param tag Initial tag (must remain valid; may be nullptr)
+ */
+TracingFile::TracingFile(IRpFile *file, const char *tag)
+	: m_file(nullptr)
+	, m_tag(tag)
+{
+	if (!file) {
+		m_lastError = EBADF;
+		return;
+	}
+
+	m_file = file->ref();
+	m_isWritable = file->isWritable();
+	m_isCompressed = file->isCompressed();
+	m_isRemote = file->isRemote();
+	m_fileType = file->fileType();
+}
+
+TracingFile::~TracingFile()
+{
+	UNREF(m_file);
+}
+
+/**
+ * Is the file open?
+ * This usually only returns false if an error occurred.
+ * @return True if the file is open; false if it isn't.
+ */
+bool TracingFile::isOpen(void) const
+{
+	return (m_file != nullptr && m_file->isOpen());
+}
+
+/**
+ * Close the file.
+ */
+void TracingFile::close(void)
+{
+	UNREF_AND_NULL(m_file);
+}
+
+/**
+ * Read data from the file.
+ * @param ptr Output data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t TracingFile::read(void *ptr, size_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	const off64_t pos = m_file->tell();
+	const uint64_t start = IoTrace::now_ns();
+	const size_t ret = m_file->read(ptr, size);
+	const uint64_t latency = IoTrace::now_ns() - start;
+	m_lastError = m_file->lastError();
+
+	const bool redundant = !m_readRanges.emplace(pos, size).second;
+	const char *const tag = IoTrace::scopedTag();
+	IoTrace::record(tag ? tag : m_tag, IoTrace::Op::Read, pos, size, latency, redundant);
+	return ret;
+}
+
+/**
+ * Write data to the file.
+ * @param ptr Input data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes written.
+ */
+size_t TracingFile::write(const void *ptr, size_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	const size_t ret = m_file->write(ptr, size);
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/**
+ * Set the file position.
+ * @param pos File position.
+ * @return 0 on success; -1 on error.
+ */
+int TracingFile::seek(off64_t pos)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	const int ret = m_file->seek(pos);
+	m_lastError = m_file->lastError();
+
+	const char *const tag = IoTrace::scopedTag();
+	IoTrace::record(tag ? tag : m_tag, IoTrace::Op::Seek, pos, 0, 0, false);
+	return ret;
+}
+
+/**
+ * Get the file position.
+ * @return File position, or -1 on error.
+ */
+off64_t TracingFile::tell(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return m_file->tell();
+}
+
+/**
+ * Truncate the file.
+ * @param size New size. (default is 0)
+ * @return 0 on success; -1 on error.
+ */
+int TracingFile::truncate(off64_t size)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	const int ret = m_file->truncate(size);
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/**
+ * Flush buffers.
+ * This operation only makes sense on writable files.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int TracingFile::flush(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+
+	return m_file->flush();
+}
+
+/** File properties **/
+
+/**
+ * Get the file size.
+ * @return File size, or negative on error.
+ */
+off64_t TracingFile::size(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return m_file->size();
+}
+
+/**
+ * Get the filename.
+ * @return Filename. (May be nullptr if the filename is not available.)
+ */
+const char *TracingFile::filename(void) const
+{
+	return (m_file ? m_file->filename() : nullptr);
+}
+
+/** Extra functions **/
+
+/**
+ * Make the file writable.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int TracingFile::makeWritable(void)
+{
+	if (!m_file) {
+		m_lastError = EBADF;
+		return -EBADF;
+	}
+
+	const int ret = m_file->makeWritable();
+	m_isWritable = m_file->isWritable();
+	return ret;
+}
+
+}
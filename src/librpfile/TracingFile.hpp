@@ -0,0 +1,148 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile)                        *
+ * TracingFile.hpp: IRpFile decorator that records I/O statistics.         *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "IRpFile.hpp"
+
+// C++ includes
+#include <set>
+#include <utility>
+
+namespace LibRpFile {
+
+class RP_LIBROMDATA_PUBLIC TracingFile final : public IRpFile
+{
+	public:
+		/**
+		 * Trace all reads and seeks on an IRpFile.
+		 * Operations are recorded using IoTrace.
+		 * @param file IRpFile (will be ref()'d)
+		 * @param tag Initial tag (must remain valid; may be nullptr)
+		 */
+		TracingFile(IRpFile *file, const char *tag = nullptr);
+	protected:
+		~TracingFile() final;	// call unref() instead
+
+	private:
+		typedef IRpFile super;
+		RP_DISABLE_COPY(TracingFile)
+
+	public:
+		/**
+		 * Is the file open?
+		 * This usually only returns false if an error occurred.
+		 * @return True if the file is open; false if it isn't.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * Close the file.
+		 */
+		void close(void) final;
+
+		/**
+		 * Read data from the file.
+		 * @param ptr Output data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		ATTR_ACCESS_SIZE(write_only, 2, 3)
+		size_t read(void *ptr, size_t size) final;
+
+		/**
+		 * Write data to the file.
+		 * @param ptr Input data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes written.
+		 */
+		ATTR_ACCESS_SIZE(read_only, 2, 3)
+		size_t write(const void *ptr, size_t size) final;
+
+		/**
+		 * Set the file position.
+		 * @param pos File position.
+		 * @return 0 on success; -1 on error.
+		 */
+		int seek(off64_t pos) final;
+
+		/**
+		 * Get the file position.
+		 * @return File position, or -1 on error.
+		 */
+		off64_t tell(void) final;
+
+		/**
+		 * Truncate the file.
+		 * @param size New size. (default is 0)
+		 * @return 0 on success; -1 on error.
+		 */
+		int truncate(off64_t size = 0) final;
+
+		/**
+		 * Flush buffers.
+		 * This operation only makes sense on writable files.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int flush(void) final;
+
+	public:
+		/** File properties **/
+
+		/**
+		 * Get the file size.
+		 * @return File size, or negative on error.
+		 */
+		off64_t size(void) final;
+
+		/**
+		 * Get the filename.
+		 * @return Filename. (May be nullptr if the filename is not available.)
+		 */
+		const char *filename(void) const final;
+
+	public:
+		/** Extra functions **/
+
+		/**
+		 * Make the file writable.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int makeWritable(void) final;
+
+		/**
+		 * Get the underlying IRpFile.
+		 * NOTE: Reads from the underlying file aren't traced.
+		 * @return Underlying IRpFile (not ref()'d), or nullptr if closed.
+		 */
+		IRpFile *baseFile(void) const final
+		{
+			return m_file;
+		}
+
+	public:
+		/** Tracing functions **/
+
+		/**
+		 * Set the tag for operations that don't have a scoped tag.
+		 * @param tag Tag (must remain valid; may be nullptr)
+		 */
+		inline void setTag(const char *tag)
+		{
+			m_tag = tag;
+		}
+
+	protected:
+		IRpFile *m_file;
+		const char *m_tag;
+
+		// Ranges that have already been read, for redundant read detection.
+		std::set<std::pair<off64_t, size_t> > m_readRanges;
+};
+
+}
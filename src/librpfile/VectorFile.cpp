@@ -2,7 +2,7 @@
  * ROM Properties Page shell extension. (librpfile)                        *
  * VectorFile.cpp: IRpFile implementation using an std::vector.            *
  *                                                                         *
- * Copyright (c) 2016-2022 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -85,17 +85,16 @@ size_t VectorFile::write(const void *ptr, size_t size)
 	}
 
 	// Do we need to expand the std::vector?
-	const size_t vec_size = m_pVector->size();
-	off64_t req_size = static_cast<off64_t>(vec_size) + size;
-	if (req_size < 0) {
+	// NOTE: static_cast<off64_t>(SIZE_MAX) is -1 on 64-bit systems,
+	// so the size check must be done using size_t.
+	if (size > std::numeric_limits<size_t>::max() - m_pos) {
 		// Overflow...
 		return 0;
-	} else if (req_size > static_cast<off64_t>(std::numeric_limits<size_t>::max())) {
-		// Too big for size_t.
-		return 0;
-	} else if (req_size > static_cast<off64_t>(vec_size)) {
+	}
+	const size_t req_size = m_pos + size;
+	if (req_size > m_pVector->size()) {
 		// Need to expand the std::vector.
-		m_pVector->resize(static_cast<size_t>(req_size));
+		m_pVector->resize(req_size);
 	}
 
 	// Copy the data to the buffer.
@@ -125,4 +124,27 @@ int VectorFile::seek(off64_t pos)
 	return 0;
 }
 
+/**
+ * Truncate the file.
+ * @param size New size. (default is 0)
+ * @return 0 on success; -1 on error.
+ */
+int VectorFile::truncate(off64_t size)
+{
+	if (size < 0) {
+		m_lastError = EINVAL;
+		return -1;
+	} else if (static_cast<uint64_t>(size) > static_cast<uint64_t>(std::numeric_limits<size_t>::max())) {
+		// Too big for size_t.
+		m_lastError = ENOMEM;
+		return -1;
+	}
+
+	m_pVector->resize(static_cast<size_t>(size));
+	if (m_pos > m_pVector->size()) {
+		m_pos = m_pVector->size();
+	}
+	return 0;
+}
+
 }
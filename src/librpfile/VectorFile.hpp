@@ -84,6 +84,13 @@ class RP_LIBROMDATA_PUBLIC VectorFile final : public IRpFile
 			return static_cast<off64_t>(m_pos);
 		}
 
+		/**
+		 * Truncate the file.
+		 * @param size New size. (default is 0)
+		 * @return 0 on success; -1 on error.
+		 */
+		int truncate(off64_t size = 0) final;
+
 		/**
 		 * Flush buffers.
 		 * This operation only makes sense on writable files.
@@ -0,0 +1,282 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile/tests)                  *
+ * BlockCacheFileTest.cpp: BlockCacheFile test.                            *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpfile
+#include "librpfile/BlockCacheFile.hpp"
+using namespace LibRpFile;
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <chrono>
+#include <thread>
+#include <vector>
+using std::vector;
+
+namespace LibRpFile { namespace Tests {
+
+/**
+ * Simulated high-latency file, e.g. a file on a network share
+ * accessed through GVfs or KIO. Each read is a round trip.
+ */
+class SlowFile final : public IRpFile
+{
+	public:
+		/**
+		 * Create a SlowFile.
+		 * @param size File size
+		 * @param maxReadSize Maximum number of bytes returned by each read (0 for no limit)
+		 */
+		explicit SlowFile(size_t size, size_t maxReadSize = 0)
+			: m_data(size)
+			, m_pos(0)
+			, m_maxReadSize(maxReadSize)
+			, readCount(0)
+		{
+			// Fill the file with a pattern that doesn't repeat every block.
+			uint32_t seed = 0x12345678;
+			for (uint8_t &b : m_data) {
+				seed = seed * 1103515245U + 12345U;
+				b = static_cast<uint8_t>(seed >> 24);
+			}
+		}
+
+	private:
+		RP_DISABLE_COPY(SlowFile)
+
+	public:
+		bool isOpen(void) const final { return true; }
+		void close(void) final { }
+
+		size_t read(void *ptr, size_t size) final
+		{
+			readCount++;
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+			if (m_pos >= static_cast<off64_t>(m_data.size()))
+				return 0;
+			size = std::min(size, m_data.size() - static_cast<size_t>(m_pos));
+			if (m_maxReadSize > 0 && size > m_maxReadSize)
+				size = m_maxReadSize;
+			memcpy(ptr, &m_data[static_cast<size_t>(m_pos)], size);
+			m_pos += size;
+			return size;
+		}
+
+		size_t write(const void *ptr, size_t size) final
+		{
+			RP_UNUSED(ptr);
+			RP_UNUSED(size);
+			m_lastError = EBADF;
+			return 0;
+		}
+
+		int seek(off64_t pos) final
+		{
+			m_pos = pos;
+			return 0;
+		}
+
+		off64_t tell(void) final { return m_pos; }
+		off64_t size(void) final { return static_cast<off64_t>(m_data.size()); }
+
+	public:
+		const vector<uint8_t> &data(void) const { return m_data; }
+
+	private:
+		vector<uint8_t> m_data;
+		off64_t m_pos;
+		size_t m_maxReadSize;
+
+	public:
+		unsigned int readCount;	// Number of reads (round trips)
+};
+
+class BlockCacheFileTest : public ::testing::Test
+{
+	protected:
+		BlockCacheFileTest()
+			: slowFile(nullptr)
+			, cacheFile(nullptr)
+		{ }
+
+		void TearDown(void) override
+		{
+			UNREF_AND_NULL(cacheFile);
+			UNREF_AND_NULL(slowFile);
+		}
+
+		/**
+		 * Create the SlowFile and BlockCacheFile.
+		 * @param size File size
+		 * @param maxBlocks Maximum number of cached blocks
+		 * @param maxReadSize Maximum number of bytes returned by each underlying read
+		 */
+		void open(size_t size, unsigned int maxBlocks = BlockCacheFile::DEFAULT_MAX_BLOCKS, size_t maxReadSize = 0)
+		{
+			slowFile = new SlowFile(size, maxReadSize);
+			cacheFile = new BlockCacheFile(slowFile, maxBlocks);
+			ASSERT_TRUE(cacheFile->isOpen());
+			ASSERT_EQ(static_cast<off64_t>(size), cacheFile->size());
+		}
+
+		/**
+		 * Read from the BlockCacheFile and compare the data to the SlowFile's data.
+		 * @param pos Position
+		 * @param size Size
+		 * @return Number of bytes read
+		 */
+		size_t checkRead(off64_t pos, size_t size)
+		{
+			vector<uint8_t> buf(size);
+			const size_t ret = cacheFile->seekAndRead(pos, buf.data(), size);
+			const vector<uint8_t> &data = slowFile->data();
+			EXPECT_LE(static_cast<size_t>(pos) + ret, data.size());
+			EXPECT_EQ(0, memcmp(buf.data(), &data[static_cast<size_t>(pos)], ret))
+				<< "Data mismatch at pos " << pos << ", size " << size;
+			EXPECT_EQ(pos + static_cast<off64_t>(ret), cacheFile->tell());
+			return ret;
+		}
+
+	public:
+		SlowFile *slowFile;
+		BlockCacheFile *cacheFile;
+};
+
+/**
+ * Small reads within one block only read the block once.
+ */
+TEST_F(BlockCacheFileTest, smallReadsTest)
+{
+	open(1024U * 1024U);
+
+	for (unsigned int i = 0; i < 256; i++) {
+		const off64_t pos = (i * 4093U) % (BlockCacheFile::BLOCK_SIZE - 16U);
+		EXPECT_EQ(16U, checkRead(pos, 16));
+	}
+	EXPECT_EQ(1U, slowFile->readCount);
+}
+
+/**
+ * Sequential reads use read-ahead.
+ */
+TEST_F(BlockCacheFileTest, sequentialReadTest)
+{
+	static const size_t FILE_SIZE = 4U * 1024U * 1024U;
+	open(FILE_SIZE);
+
+	for (size_t pos = 0; pos < FILE_SIZE; pos += 4096) {
+		ASSERT_EQ(4096U, checkRead(pos, 4096));
+	}
+
+	// Without caching, this would be 1,024 reads.
+	// Without read-ahead, this would be 64 reads.
+	EXPECT_LE(slowFile->readCount, 12U);
+}
+
+/**
+ * Random reads, including reads across block boundaries and EOF.
+ */
+TEST_F(BlockCacheFileTest, randomReadTest)
+{
+	static const size_t FILE_SIZE = 3U * 1024U * 1024U + 123U;
+	open(FILE_SIZE, 16);
+
+	uint32_t seed = 0xCAFEBABE;
+	for (unsigned int i = 0; i < 512; i++) {
+		seed = seed * 1103515245U + 12345U;
+		const off64_t pos = (seed >> 8) % FILE_SIZE;
+		seed = seed * 1103515245U + 12345U;
+		const size_t size = ((seed >> 8) % (256U * 1024U)) + 1;
+
+		const size_t expected = std::min(size, FILE_SIZE - static_cast<size_t>(pos));
+		ASSERT_EQ(expected, checkRead(pos, size));
+	}
+
+	// Large reads are passed through.
+	ASSERT_EQ(2U * 1024U * 1024U, checkRead(12345, 2U * 1024U * 1024U));
+}
+
+/**
+ * Underlying reads that return less data than requested.
+ */
+TEST_F(BlockCacheFileTest, shortReadTest)
+{
+	static const size_t FILE_SIZE = 512U * 1024U + 7U;
+	open(FILE_SIZE, BlockCacheFile::DEFAULT_MAX_BLOCKS, 5000);
+
+	for (size_t pos = 0; pos < FILE_SIZE; pos += 10000) {
+		const size_t expected = std::min<size_t>(10000, FILE_SIZE - pos);
+		ASSERT_EQ(expected, checkRead(pos, 10000));
+	}
+}
+
+/**
+ * Reads at and past EOF.
+ */
+TEST_F(BlockCacheFileTest, eofTest)
+{
+	static const size_t FILE_SIZE = 100000;
+	open(FILE_SIZE);
+
+	EXPECT_EQ(50U, checkRead(FILE_SIZE - 50, 100));
+	EXPECT_EQ(0U, checkRead(FILE_SIZE, 100));
+
+	uint8_t buf[16];
+	EXPECT_EQ(0, cacheFile->seek(FILE_SIZE + 1000));
+	EXPECT_EQ(0U, cacheFile->read(buf, sizeof(buf)));
+}
+
+/**
+ * The least-recently-used block is evicted when the cache is full.
+ */
+TEST_F(BlockCacheFileTest, lruTest)
+{
+	static const off64_t BLOCK_SIZE = BlockCacheFile::BLOCK_SIZE;
+	open(64U * BlockCacheFile::BLOCK_SIZE, 4);
+
+	// Fill the cache with non-sequential blocks.
+	checkRead(0 * BLOCK_SIZE, 16);
+	checkRead(10 * BLOCK_SIZE, 16);
+	checkRead(20 * BLOCK_SIZE, 16);
+	checkRead(30 * BLOCK_SIZE, 16);
+	EXPECT_EQ(4U, slowFile->readCount);
+
+	// Block 0 is still cached.
+	checkRead(0 * BLOCK_SIZE + 100, 16);
+	EXPECT_EQ(4U, slowFile->readCount);
+
+	// Block 40 evicts block 10, since block 0 was used more recently.
+	checkRead(40 * BLOCK_SIZE, 16);
+	EXPECT_EQ(5U, slowFile->readCount);
+	checkRead(0 * BLOCK_SIZE, 16);
+	EXPECT_EQ(5U, slowFile->readCount);
+	checkRead(10 * BLOCK_SIZE, 16);
+	EXPECT_EQ(6U, slowFile->readCount);
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRpFile test suite: BlockCacheFile tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
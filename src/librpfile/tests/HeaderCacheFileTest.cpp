@@ -0,0 +1,301 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile/tests)                  *
+ * HeaderCacheFileTest.cpp: HeaderCacheFile test.                          *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpfile
+#include "librpfile/HeaderCacheFile.hpp"
+using namespace LibRpFile;
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <vector>
+using std::vector;
+
+namespace LibRpFile { namespace Tests {
+
+/**
+ * In-memory file that counts the number of reads.
+ */
+class CountingFile final : public IRpFile
+{
+	public:
+		/**
+		 * Create a CountingFile.
+		 * @param size File size
+		 */
+		explicit CountingFile(size_t size)
+			: m_data(size)
+			, m_pos(0)
+			, readCount(0)
+		{
+			// Fill the file with a pattern that doesn't repeat.
+			uint32_t seed = 0x12345678;
+			for (uint8_t &b : m_data) {
+				seed = seed * 1103515245U + 12345U;
+				b = static_cast<uint8_t>(seed >> 24);
+			}
+			m_isWritable = true;
+		}
+
+	private:
+		RP_DISABLE_COPY(CountingFile)
+
+	public:
+		bool isOpen(void) const final { return true; }
+		void close(void) final { }
+
+		size_t read(void *ptr, size_t size) final
+		{
+			readCount++;
+			if (m_pos >= static_cast<off64_t>(m_data.size()))
+				return 0;
+			size = std::min(size, m_data.size() - static_cast<size_t>(m_pos));
+			memcpy(ptr, &m_data[static_cast<size_t>(m_pos)], size);
+			m_pos += size;
+			return size;
+		}
+
+		size_t write(const void *ptr, size_t size) final
+		{
+			if (m_pos >= static_cast<off64_t>(m_data.size()))
+				return 0;
+			size = std::min(size, m_data.size() - static_cast<size_t>(m_pos));
+			memcpy(&m_data[static_cast<size_t>(m_pos)], ptr, size);
+			m_pos += size;
+			return size;
+		}
+
+		int seek(off64_t pos) final
+		{
+			m_pos = pos;
+			return 0;
+		}
+
+		off64_t tell(void) final { return m_pos; }
+		off64_t size(void) final { return static_cast<off64_t>(m_data.size()); }
+
+	public:
+		const vector<uint8_t> &data(void) const { return m_data; }
+
+	private:
+		vector<uint8_t> m_data;
+		off64_t m_pos;
+
+	public:
+		unsigned int readCount;	// Number of reads
+};
+
+class HeaderCacheFileTest : public ::testing::Test
+{
+	protected:
+		HeaderCacheFileTest()
+			: countingFile(nullptr)
+			, cacheFile(nullptr)
+		{ }
+
+		void TearDown(void) override
+		{
+			UNREF_AND_NULL(cacheFile);
+			UNREF_AND_NULL(countingFile);
+		}
+
+		/**
+		 * Create the CountingFile and HeaderCacheFile.
+		 * @param size File size
+		 */
+		void open(size_t size)
+		{
+			countingFile = new CountingFile(size);
+			cacheFile = new HeaderCacheFile(countingFile);
+			ASSERT_TRUE(cacheFile->isOpen());
+			ASSERT_EQ(static_cast<off64_t>(size), cacheFile->size());
+		}
+
+		/**
+		 * Read from the HeaderCacheFile and compare the data to the CountingFile's data.
+		 * @param pos Position
+		 * @param size Size
+		 * @return Number of bytes read
+		 */
+		size_t checkRead(off64_t pos, size_t size)
+		{
+			vector<uint8_t> buf(size);
+			const size_t ret = cacheFile->seekAndRead(pos, buf.data(), size);
+			const vector<uint8_t> &data = countingFile->data();
+			EXPECT_LE(static_cast<size_t>(pos) + ret, data.size());
+			EXPECT_EQ(0, memcmp(buf.data(), &data[static_cast<size_t>(pos)], ret))
+				<< "Data mismatch at pos " << pos << ", size " << size;
+			EXPECT_EQ(pos + static_cast<off64_t>(ret), cacheFile->tell());
+			return ret;
+		}
+
+	public:
+		CountingFile *countingFile;
+		HeaderCacheFile *cacheFile;
+};
+
+/**
+ * Repeated small reads within a cached window don't read the underlying file.
+ */
+TEST_F(HeaderCacheFileTest, windowHitTest)
+{
+	open(1024U * 1024U);
+
+	EXPECT_EQ(4096U, checkRead(0, 4096));
+	EXPECT_EQ(1U, countingFile->readCount);
+
+	// Reads within the window, including the full window.
+	EXPECT_EQ(4096U, checkRead(0, 4096));
+	EXPECT_EQ(16U, checkRead(100, 16));
+	EXPECT_EQ(1024U, checkRead(3072, 1024));
+	EXPECT_EQ(1U, countingFile->readCount);
+
+	// A second, separate window.
+	EXPECT_EQ(512U, checkRead(512U * 1024U, 512));
+	EXPECT_EQ(512U, checkRead(512U * 1024U, 512));
+	EXPECT_EQ(16U, checkRead(4000, 16));
+	EXPECT_EQ(2U, countingFile->readCount);
+}
+
+/**
+ * Reads that partially overlap a cached window only read the uncached part,
+ * and the windows are merged.
+ */
+TEST_F(HeaderCacheFileTest, partialOverlapTest)
+{
+	open(1024U * 1024U);
+
+	EXPECT_EQ(1024U, checkRead(1024, 1024));
+	EXPECT_EQ(1U, countingFile->readCount);
+
+	// Starts in the window and continues past it.
+	EXPECT_EQ(2048U, checkRead(1536, 2048));
+	EXPECT_EQ(2U, countingFile->readCount);
+
+	// [1024, 3584) is now cached.
+	EXPECT_EQ(2560U, checkRead(1024, 2560));
+	EXPECT_EQ(2U, countingFile->readCount);
+
+	// Starts before the window. Nothing is cached at the start,
+	// so the whole read goes to the file.
+	EXPECT_EQ(2048U, checkRead(0, 2048));
+	EXPECT_EQ(3U, countingFile->readCount);
+
+	// [0, 3584) is now cached as a single window.
+	EXPECT_EQ(3584U, checkRead(0, 3584));
+	EXPECT_EQ(3U, countingFile->readCount);
+
+	// Two windows with a gap, then a read that fills the gap.
+	EXPECT_EQ(1024U, checkRead(8192, 1024));
+	EXPECT_EQ(4U, countingFile->readCount);
+	EXPECT_EQ(8192U - 3584U, checkRead(3584, 8192 - 3584));
+	EXPECT_EQ(5U, countingFile->readCount);
+	EXPECT_EQ(9216U, checkRead(0, 9216));
+	EXPECT_EQ(5U, countingFile->readCount);
+}
+
+/**
+ * Reads at EOF.
+ */
+TEST_F(HeaderCacheFileTest, eofTest)
+{
+	static const size_t FILE_SIZE = 100000;
+	open(FILE_SIZE);
+
+	EXPECT_EQ(50U, checkRead(FILE_SIZE - 50, 100));
+	EXPECT_EQ(1U, countingFile->readCount);
+	EXPECT_EQ(50U, checkRead(FILE_SIZE - 50, 50));
+	EXPECT_EQ(1U, countingFile->readCount);
+
+	EXPECT_EQ(0U, checkRead(FILE_SIZE, 100));
+}
+
+/**
+ * Large reads aren't cached, and the total cache size is limited.
+ * The least-recently-used windows are evicted first.
+ */
+TEST_F(HeaderCacheFileTest, sizeLimitTest)
+{
+	static const size_t MAX_READ_SIZE = HeaderCacheFile::MAX_READ_SIZE;
+	static const size_t MAX_TOTAL_SIZE = HeaderCacheFile::MAX_TOTAL_SIZE;
+	static const unsigned int WINDOW_COUNT = MAX_TOTAL_SIZE / MAX_READ_SIZE;
+	static const off64_t STRIDE = MAX_READ_SIZE * 2;
+	open(static_cast<size_t>(STRIDE) * (WINDOW_COUNT + 4));
+
+	// Reads larger than MAX_READ_SIZE aren't cached.
+	EXPECT_EQ(MAX_READ_SIZE + 1, checkRead(0, MAX_READ_SIZE + 1));
+	EXPECT_EQ(MAX_READ_SIZE + 1, checkRead(0, MAX_READ_SIZE + 1));
+	EXPECT_EQ(2U, countingFile->readCount);
+	countingFile->readCount = 0;
+
+	// Fill the cache with separate windows.
+	for (unsigned int i = 0; i < WINDOW_COUNT; i++) {
+		EXPECT_EQ(MAX_READ_SIZE, checkRead(i * STRIDE, MAX_READ_SIZE));
+	}
+	EXPECT_EQ(WINDOW_COUNT, countingFile->readCount);
+	for (unsigned int i = 0; i < WINDOW_COUNT; i++) {
+		EXPECT_EQ(MAX_READ_SIZE, checkRead(i * STRIDE, MAX_READ_SIZE));
+	}
+	EXPECT_EQ(WINDOW_COUNT, countingFile->readCount);
+
+	// Use window 0 so window 1 is the least-recently-used.
+	checkRead(0, 16);
+	EXPECT_EQ(WINDOW_COUNT, countingFile->readCount);
+
+	// Adding another window evicts window 1.
+	EXPECT_EQ(MAX_READ_SIZE, checkRead(WINDOW_COUNT * STRIDE, MAX_READ_SIZE));
+	EXPECT_EQ(WINDOW_COUNT + 1, countingFile->readCount);
+	checkRead(0, 16);
+	checkRead(2 * STRIDE, 16);
+	EXPECT_EQ(WINDOW_COUNT + 1, countingFile->readCount);
+	checkRead(1 * STRIDE, 16);
+	EXPECT_EQ(WINDOW_COUNT + 2, countingFile->readCount);
+}
+
+/**
+ * Writes invalidate overlapping windows.
+ */
+TEST_F(HeaderCacheFileTest, writeInvalidateTest)
+{
+	open(1024U * 1024U);
+
+	EXPECT_EQ(4096U, checkRead(0, 4096));
+	EXPECT_EQ(4096U, checkRead(65536, 4096));
+	EXPECT_EQ(2U, countingFile->readCount);
+
+	static const uint8_t buf[16] = {0};
+	ASSERT_EQ(0, cacheFile->seek(2000));
+	ASSERT_EQ(sizeof(buf), cacheFile->write(buf, sizeof(buf)));
+
+	// The first window is reread; the second window is still cached.
+	EXPECT_EQ(4096U, checkRead(0, 4096));
+	EXPECT_EQ(3U, countingFile->readCount);
+	EXPECT_EQ(4096U, checkRead(65536, 4096));
+	EXPECT_EQ(3U, countingFile->readCount);
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRpFile test suite: HeaderCacheFile tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
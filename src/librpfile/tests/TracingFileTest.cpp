@@ -0,0 +1,246 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpfile/tests)                  *
+ * TracingFileTest.cpp: TracingFile and IoTrace test.                      *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpfile
+#include "librpfile/IoTrace.hpp"
+#include "librpfile/MemFile.hpp"
+#include "librpfile/TracingFile.hpp"
+using namespace LibRpFile;
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <regex>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRpFile { namespace Tests {
+
+class TracingFileTest : public ::testing::Test
+{
+	protected:
+		TracingFileTest()
+			: memFile(nullptr)
+			, tracingFile(nullptr)
+		{ }
+
+		void SetUp(void) override;
+		void TearDown(void) override;
+
+		/**
+		 * Read from the TracingFile and compare the data to the MemFile's data.
+		 * @param pos Position
+		 * @param size Size
+		 * @return Number of bytes read
+		 */
+		size_t checkRead(off64_t pos, size_t size);
+
+		/**
+		 * Get the I/O statistics as JSON, with the events.
+		 * Latencies are removed, since they aren't deterministic.
+		 * @return JSON string
+		 */
+		static string statsJSON(void);
+
+	public:
+		// File size.
+		static const size_t FILE_SIZE = 4096;
+
+	protected:
+		vector<uint8_t> data;
+		MemFile *memFile;
+		IRpFile *tracingFile;
+};
+
+void TracingFileTest::SetUp(void)
+{
+	data.resize(FILE_SIZE);
+	uint32_t seed = 0x10763ACEU;
+	for (uint8_t &b : data) {
+		seed = seed * 1103515245U + 12345U;
+		b = static_cast<uint8_t>(seed >> 24);
+	}
+
+	IoTrace::setEnabled(true);
+	IoTrace::reset();
+
+	memFile = new MemFile(data.data(), data.size());
+	tracingFile = new TracingFile(memFile, "TracingFileTest");
+	ASSERT_TRUE(tracingFile->isOpen());
+	ASSERT_EQ(static_cast<off64_t>(FILE_SIZE), tracingFile->size());
+}
+
+void TracingFileTest::TearDown(void)
+{
+	UNREF_AND_NULL(tracingFile);
+	UNREF_AND_NULL(memFile);
+
+	IoTrace::setEnabled(false);
+	IoTrace::reset();
+}
+
+/**
+ * Read from the TracingFile and compare the data to the MemFile's data.
+ * @param pos Position
+ * @param size Size
+ * @return Number of bytes read
+ */
+size_t TracingFileTest::checkRead(off64_t pos, size_t size)
+{
+	vector<uint8_t> buf(size, 0xCC);
+	const size_t ret = tracingFile->seekAndRead(pos, buf.data(), size);
+	EXPECT_LE(static_cast<size_t>(pos) + ret, data.size());
+	EXPECT_EQ(0, memcmp(buf.data(), &data[static_cast<size_t>(pos)], ret))
+		<< "Data mismatch at pos " << pos << ", size " << size;
+	EXPECT_EQ(pos + static_cast<off64_t>(ret), tracingFile->tell());
+	return ret;
+}
+
+/**
+ * Get the I/O statistics as JSON, with the events.
+ * Latencies are removed, since they aren't deterministic.
+ * @return JSON string
+ */
+string TracingFileTest::statsJSON(void)
+{
+	static const std::regex latency_regex(",\"(us|read_time_us|max_read_us)\":[0-9]+");
+	return std::regex_replace(IoTrace::toJSON(true), latency_regex, "");
+}
+
+/**
+ * Reads and seeks are recorded with their offsets and sizes,
+ * and the data is passed through unchanged.
+ */
+TEST_F(TracingFileTest, readsAreRecorded)
+{
+	EXPECT_EQ(16U, checkRead(100, 16));
+
+	// Sequential read, without seeking.
+	vector<uint8_t> buf(600);
+	EXPECT_EQ(buf.size(), tracingFile->read(buf.data(), buf.size()));
+	EXPECT_EQ(0, memcmp(buf.data(), &data[116], buf.size()));
+
+	// Same range as the first read.
+	EXPECT_EQ(16U, checkRead(100, 16));
+
+	// Short read at EOF. The requested size is recorded.
+	EXPECT_EQ(96U, checkRead(FILE_SIZE - 96, 1024));
+
+	EXPECT_EQ("{\"io_trace\":[{\"class\":\"TracingFileTest\""
+		",\"reads\":4,\"bytes\":1656,\"seeks\":3"
+		",\"tiny_reads\":2,\"redundant_reads\":1"
+		",\"events\":["
+		"{\"op\":\"seek\",\"offset\":100},"
+		"{\"op\":\"read\",\"offset\":100,\"size\":16},"
+		"{\"op\":\"read\",\"offset\":116,\"size\":600},"
+		"{\"op\":\"seek\",\"offset\":100},"
+		"{\"op\":\"read\",\"offset\":100,\"size\":16,\"redundant\":true},"
+		"{\"op\":\"seek\",\"offset\":4000},"
+		"{\"op\":\"read\",\"offset\":4000,\"size\":1024}"
+		"],\"events_dropped\":0}]}", statsJSON());
+}
+
+/**
+ * A scoped tag overrides the TracingFile's tag,
+ * and the previous tag is restored afterwards.
+ */
+TEST_F(TracingFileTest, scopedTag)
+{
+	static_cast<TracingFile*>(tracingFile)->setTag(nullptr);
+	EXPECT_EQ(16U, checkRead(0, 16));
+	{
+		IoTrace::ScopedTag tag("ScopedTag");
+		EXPECT_STREQ("ScopedTag", IoTrace::scopedTag());
+		EXPECT_EQ(1024U, checkRead(1024, 1024));
+	}
+	EXPECT_EQ(nullptr, IoTrace::scopedTag());
+	EXPECT_EQ(32U, checkRead(2048, 32));
+
+	// Reads without a tag use "(none)".
+	EXPECT_EQ("{\"io_trace\":["
+		"{\"class\":\"(none)\""
+		",\"reads\":2,\"bytes\":48,\"seeks\":2"
+		",\"tiny_reads\":2,\"redundant_reads\":0"
+		",\"events\":["
+		"{\"op\":\"seek\",\"offset\":0},"
+		"{\"op\":\"read\",\"offset\":0,\"size\":16},"
+		"{\"op\":\"seek\",\"offset\":2048},"
+		"{\"op\":\"read\",\"offset\":2048,\"size\":32}"
+		"],\"events_dropped\":0},"
+		"{\"class\":\"ScopedTag\""
+		",\"reads\":1,\"bytes\":1024,\"seeks\":1"
+		",\"tiny_reads\":0,\"redundant_reads\":0"
+		",\"events\":["
+		"{\"op\":\"seek\",\"offset\":1024},"
+		"{\"op\":\"read\",\"offset\":1024,\"size\":1024}"
+		"],\"events_dropped\":0}]}", statsJSON());
+}
+
+/**
+ * Events past MAX_EVENTS_PER_TAG are dropped,
+ * but they're still counted in the statistics.
+ */
+TEST_F(TracingFileTest, eventsDropped)
+{
+	static const unsigned int READ_COUNT = IoTrace::MAX_EVENTS_PER_TAG + 10;
+	uint8_t buf[1];
+	unsigned int seekCount = 0;
+	for (unsigned int i = 0; i < READ_COUNT; i++) {
+		ASSERT_EQ(1U, tracingFile->read(buf, sizeof(buf)));
+		ASSERT_EQ(data[i % FILE_SIZE], buf[0]);
+		if ((i % FILE_SIZE) == FILE_SIZE - 1) {
+			tracingFile->rewind();
+			seekCount++;
+		}
+	}
+
+	// Seeks are events, too.
+	const string json = IoTrace::toJSON(true);
+	char expected[64];
+	snprintf(expected, sizeof(expected), "\"reads\":%u,", READ_COUNT);
+	EXPECT_NE(string::npos, json.find(expected));
+	snprintf(expected, sizeof(expected), "\"seeks\":%u,", seekCount);
+	EXPECT_NE(string::npos, json.find(expected));
+	snprintf(expected, sizeof(expected), "\"events_dropped\":%u}",
+		READ_COUNT + seekCount - IoTrace::MAX_EVENTS_PER_TAG);
+	EXPECT_NE(string::npos, json.find(expected));
+}
+
+/**
+ * Nothing is recorded if tracing is disabled.
+ */
+TEST_F(TracingFileTest, disabled)
+{
+	IoTrace::setEnabled(false);
+	EXPECT_FALSE(IoTrace::isEnabled());
+	EXPECT_EQ(16U, checkRead(100, 16));
+	EXPECT_EQ("{\"io_trace\":[]}", IoTrace::toJSON(true));
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRpFile test suite: TracingFile tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -787,4 +787,25 @@ int RpFile::makeWritable(void)
 	return 0;
 }
 
+/**
+ * Copy data from another file to the current position in this file.
+ *
+ * On Linux, this uses copy_file_range() or sendfile(), so the data
+ * doesn't have to be copied through a user-space buffer. Both files
+ * must be regular files, i.e. not gzipped and not device files.
+ *
+ * @param src		[in] Source file
+ * @param srcPos	[in] Starting position in the source file
+ * @param size		[in] Number of bytes to copy
+ * @return Number of bytes copied, or negative POSIX error code on error. (-ENOTSUP if not supported for these files)
+ */
+off64_t RpFile::copyRangeFrom(RpFile *src, off64_t srcPos, off64_t size)
+{
+	// TODO: Use FSCTL_DUPLICATE_EXTENTS_TO_FILE on ReFS?
+	RP_UNUSED(src);
+	RP_UNUSED(srcPos);
+	RP_UNUSED(size);
+	return -ENOTSUP;
+}
+
 }
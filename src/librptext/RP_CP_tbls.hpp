@@ -1,6 +1,6 @@
 /***************************************************************************
  * ROM Properties Page shell extension. (librptext)                        *
- * RP_CP_tbls.hpp: Code page lookup tables for custom code pages.          *
+ * RP_CP_tbls.hpp: Code page lookup tables.                                 *
  *                                                                         *
  * Copyright (c) 2009-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
@@ -228,6 +228,50 @@ static const char16_t petscii_shifted_lkup[256] = {
 	0xFFFD, 0x258E, 0x2713, 0x2596, 0x259D, 0x2518, 0x2598, 0x259A,
 };
 
+// cp1252 lookup table: 0x80-0x9F only.
+// All other characters are identical to Latin-1.
+// Reference: https://en.wikipedia.org/wiki/Windows-1252
+// NOTE: Undefined characters (0x81, 0x8D, 0x8F, 0x90, 0x9D) are 0.
+// iconv fails on these, so the string is decoded as Latin-1 instead.
+static const char16_t cp1252_lkup_80[32] = {
+	// 0x80
+	0x20AC, 0x0000, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x0000, 0x017D, 0x0000,
+	// 0x90
+	0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x0000, 0x017E, 0x0178,
+};
+
+// cp437 lookup table: 0x80-0xFF only.
+// 0x00-0x7F are identical to ASCII.
+// Reference: https://en.wikipedia.org/wiki/Code_page_437
+static const char16_t cp437_lkup_80[128] = {
+	// 0x80
+	0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7,
+	0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+	// 0x90
+	0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9,
+	0x00FF, 0x00D6, 0x00DC, 0x00A2, 0x00A3, 0x00A5, 0x20A7, 0x0192,
+	// 0xA0
+	0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA,
+	0x00BF, 0x2310, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+	// 0xB0
+	0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556,
+	0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+	// 0xC0
+	0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F,
+	0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+	// 0xD0
+	0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B,
+	0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+	// 0xE0
+	0x03B1, 0x00DF, 0x0393, 0x03C0, 0x03A3, 0x03C3, 0x00B5, 0x03C4,
+	0x03A6, 0x0398, 0x03A9, 0x03B4, 0x221E, 0x03C6, 0x03B5, 0x2229,
+	// 0xF0
+	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248,
+	0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0,
+};
+
 // Lookup tables in RP_CP_* ordering.
 static const char16_t *const lkup_tbls[] = {
 	atariST_lkup,		// CP_RP_ATARIST
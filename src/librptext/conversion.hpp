@@ -222,6 +222,38 @@ std::string cpN_to_utf8(unsigned int cp, const char *str, int len, unsigned int
  */
 std::string cpRP_to_utf8(unsigned int cp, const char *str, int len);
 
+/**
+ * Convert 8-bit text to UTF-8 without using the system's conversion functions.
+ * This handles ASCII-only text in ASCII-compatible code pages, and any text
+ * in cp1252, cp437, and Latin-1.
+ *
+ * Conversion stops at the first NULL byte.
+ * CP_ACP is *not* handled here; the caller must resolve it first.
+ *
+ * @param cp	[in] Code page number.
+ * @param str	[in] 8-bit text.
+ * @param len	[in] Length of str, in bytes. (Must not be negative.)
+ * @param ret	[out] UTF-8 string.
+ * @return True if the string was converted; false if the system's conversion functions must be used.
+ */
+bool cpN_to_utf8_fast(unsigned int cp, const char *str, int len, std::string &ret);
+
+/**
+ * Convert 8-bit text to UTF-16 without using the system's conversion functions.
+ * This handles ASCII-only text in ASCII-compatible code pages, and any text
+ * in cp1252, cp437, and Latin-1.
+ *
+ * Conversion stops at the first NULL byte.
+ * CP_ACP is *not* handled here; the caller must resolve it first.
+ *
+ * @param cp	[in] Code page number.
+ * @param str	[in] 8-bit text.
+ * @param len	[in] Length of str, in bytes. (Must not be negative.)
+ * @param ret	[out] UTF-16 string.
+ * @return True if the string was converted; false if the system's conversion functions must be used.
+ */
+bool cpN_to_utf16_fast(unsigned int cp, const char *str, int len, std::u16string &ret);
+
 /**
  * Convert 8-bit text to UTF-16.
  * Trailing NULL bytes will be removed.
@@ -625,6 +657,7 @@ static inline std::u16string utf16be_to_utf16(const char16_t *wcs, int len)
  * @param fileSize File size.
  * @return Formatted file size.
  */
+RP_LIBROMDATA_PUBLIC
 std::string formatFileSize(off64_t fileSize);
 
 /**
@@ -39,6 +39,7 @@
 
 // C includes (C++ namespace)
 #include <cassert>
+#include <cstring>
 
 // C++ STL classes
 using std::string;
@@ -48,6 +49,132 @@ namespace LibRpText {
 
 /** OS-specific text conversion functions. **/
 
+/**
+ * Per-thread cache of open iconv descriptors.
+ *
+ * iconv_open() has to look up (and possibly load) the conversion
+ * modules every time, which takes much longer than converting a
+ * typical ROM header string. iconv descriptors have conversion
+ * state and can't be shared between threads, so each thread
+ * gets its own cache.
+ */
+class IconvCache
+{
+	public:
+		IconvCache() = default;
+		~IconvCache();
+
+	private:
+		RP_DISABLE_COPY(IconvCache)
+
+	public:
+		/**
+		 * Get an iconv descriptor, opening it if it isn't cached.
+		 * The descriptor is owned by the cache and must not be closed.
+		 * @param src_charset	[in] Source character set.
+		 * @param dest_charset	[in] Destination character set.
+		 * @param ignoreErr	[in] If true, ignore errors. ("//IGNORE" on glibc/libiconv)
+		 * @return iconv descriptor, or (iconv_t)(-1) on error.
+		 */
+		iconv_t get(const char *src_charset, const char *dest_charset, bool ignoreErr);
+
+	private:
+		struct Entry {
+			iconv_t cd;
+			char src_charset[24];
+			char dest_charset[24];
+			bool ignoreErr;
+		};
+
+		// Cache entries. Unused entries have cd == (iconv_t)(-1).
+		// NOTE: Only a few code pages are used at any given time,
+		// so a small array with round-robin replacement is enough.
+		Entry entries[8] = {
+			{(iconv_t)(-1), {0}, {0}, false}, {(iconv_t)(-1), {0}, {0}, false},
+			{(iconv_t)(-1), {0}, {0}, false}, {(iconv_t)(-1), {0}, {0}, false},
+			{(iconv_t)(-1), {0}, {0}, false}, {(iconv_t)(-1), {0}, {0}, false},
+			{(iconv_t)(-1), {0}, {0}, false}, {(iconv_t)(-1), {0}, {0}, false},
+		};
+		unsigned int next_evict = 0;
+};
+
+IconvCache::~IconvCache()
+{
+	for (Entry &entry : entries) {
+		if (entry.cd != (iconv_t)(-1)) {
+			iconv_close(entry.cd);
+		}
+	}
+}
+
+/**
+ * Get an iconv descriptor, opening it if it isn't cached.
+ * The descriptor is owned by the cache and must not be closed.
+ * @param src_charset	[in] Source character set.
+ * @param dest_charset	[in] Destination character set.
+ * @param ignoreErr	[in] If true, ignore errors. ("//IGNORE" on glibc/libiconv)
+ * @return iconv descriptor, or (iconv_t)(-1) on error.
+ */
+iconv_t IconvCache::get(const char *src_charset, const char *dest_charset, bool ignoreErr)
+{
+	for (const Entry &entry : entries) {
+		if (entry.cd != (iconv_t)(-1) && entry.ignoreErr == ignoreErr &&
+		    !strcmp(entry.src_charset, src_charset) &&
+		    !strcmp(entry.dest_charset, dest_charset))
+		{
+			// Found a cached descriptor.
+			return entry.cd;
+		}
+	}
+
+	// Open an iconv descriptor.
+	iconv_t cd;
+#if defined(__linux__) || defined(HAVE_ICONV_LIBICONV)
+	// glibc/libiconv: Append "//IGNORE" to the source character set
+	// if ignoreErr == true.
+	// TODO: Destination, not source?
+	if (ignoreErr) {
+		char tmpsrc[32];
+		snprintf(tmpsrc, sizeof(tmpsrc), "%s//IGNORE", src_charset);
+		cd = iconv_open(dest_charset, tmpsrc);
+	} else {
+		// Not ignoring errors.
+		cd = iconv_open(dest_charset, src_charset);
+	}
+#else
+	cd = iconv_open(dest_charset, src_charset);
+#endif
+
+	if (cd == (iconv_t)(-1)) {
+		// Error opening iconv.
+		return cd;
+	}
+
+	if (strlen(src_charset) >= sizeof(entries[0].src_charset) ||
+	    strlen(dest_charset) >= sizeof(entries[0].dest_charset))
+	{
+		// Character set names are too long to cache.
+		// This shouldn't happen with the names we use...
+		assert(!"Character set name is too long to cache.");
+		iconv_close(cd);
+		return (iconv_t)(-1);
+	}
+
+	// Replace the next entry.
+	Entry &entry = entries[next_evict];
+	next_evict = (next_evict + 1) % ARRAY_SIZE(entries);
+	if (entry.cd != (iconv_t)(-1)) {
+		iconv_close(entry.cd);
+	}
+	entry.cd = cd;
+	strcpy(entry.src_charset, src_charset);
+	strcpy(entry.dest_charset, dest_charset);
+	entry.ignoreErr = ignoreErr;
+	return cd;
+}
+
+static thread_local IconvCache iconv_cache;
+
 /**
  * Convert a string from one character set to another.
  * @param src 		[in] Source string.
@@ -77,24 +204,8 @@ static char *rp_iconv(const char *src, int len,
 	// * http://www.delorie.com/gnu/docs/glibc/libc_101.html
 	// * http://www.codase.com/search/call?name=iconv
 
-	// Open an iconv descriptor.
-	iconv_t cd;
-#if defined(__linux__) || defined(HAVE_ICONV_LIBICONV)
-	// glibc/libiconv: Append "//IGNORE" to the source character set
-	// if ignoreErr == true.
-	// TODO: Destination, not source?
-	if (ignoreErr) {
-		char tmpsrc[32];
-		snprintf(tmpsrc, sizeof(tmpsrc), "%s//IGNORE", src_charset);
-		cd = iconv_open(dest_charset, tmpsrc);
-	} else {
-		// Not ignoring errors.
-		cd = iconv_open(dest_charset, src_charset);
-	}
-#else
-	cd = iconv_open(dest_charset, src_charset);
-#endif
-
+	// Get an iconv descriptor.
+	iconv_t cd = iconv_cache.get(src_charset, dest_charset, ignoreErr);
 	if (cd == (iconv_t)(-1)) {
 		// Error opening iconv.
 		return nullptr;
@@ -139,8 +250,13 @@ static char *rp_iconv(const char *src, int len,
 		}
 	}
 
-	// Close the iconv descriptor.
-	iconv_close(cd);
+	// Reset the iconv descriptor's shift state so it can be reused.
+	// NOTE: The descriptor is owned by the cache; don't close it.
+#ifdef __FreeBSD__
+	__iconv(cd, nullptr, nullptr, nullptr, nullptr, 0, nullptr);
+#else /* !__FreeBSD__ */
+	iconv(cd, nullptr, nullptr, nullptr, nullptr);
+#endif
 
 	if (success) {
 		// The string was converted successfully.
@@ -210,6 +326,13 @@ string cpN_to_utf8(unsigned int cp, const char *str, int len, unsigned int flags
 
 	len = check_NULL_terminator(str, len);
 
+	// ASCII text and table-driven code pages don't need iconv.
+	// NOTE: CP_ACP is assumed to be cp1252. (See codePageToEncName().)
+	string ret;
+	if (cpN_to_utf8_fast((cp == CP_ACP ? 1252 : cp), str, len, ret)) {
+		return ret;
+	}
+
 	// Get the encoding name for the primary code page.
 	char cp_name[20];
 	codePageToEncName(cp_name, sizeof(cp_name), cp);
@@ -221,20 +344,12 @@ string cpN_to_utf8(unsigned int cp, const char *str, int len, unsigned int flags
 	// Attempt to convert the text to UTF-8.
 	// NOTE: "//IGNORE" sometimes doesn't work, so we won't
 	// check for TEXTCONV_FLAG_CP1252_FALLBACK here.
-	string ret;
 	char *mbs = reinterpret_cast<char*>(rp_iconv((char*)str, len*sizeof(*str), cp_name, "UTF-8", ignoreErr));
 	if (!mbs /*&& (flags & TEXTCONV_FLAG_CP1252_FALLBACK)*/) {
-		// Try cp1252 fallback.
-		// NOTE: Sometimes cp1252 fails, even with ignore set.
-		if (cp != 1252) {
-			mbs = reinterpret_cast<char*>(rp_iconv((char*)str, len*sizeof(*str), "CP1252", "UTF-8", true));
-		}
-		if (!mbs) {
-			// Try Latin-1 fallback.
-			if (cp != CP_LATIN1) {
-				mbs = reinterpret_cast<char*>(rp_iconv((char*)str, len*sizeof(*str), "LATIN1", "UTF-8", true));
-			}
-		}
+		// Use the cp1252 fallback.
+		// NOTE: The cp1252 table maps every byte, so this can't fail.
+		cpN_to_utf8_fast(1252, str, len, ret);
+		return ret;
 	}
 
 	if (mbs) {
@@ -277,6 +392,13 @@ u16string cpN_to_utf16(unsigned int cp, const char *str, int len, unsigned int f
 {
 	len = check_NULL_terminator(str, len);
 
+	// ASCII text and table-driven code pages don't need iconv.
+	// NOTE: CP_ACP is assumed to be cp1252. (See codePageToEncName().)
+	u16string ret;
+	if (cpN_to_utf16_fast((cp == CP_ACP ? 1252 : cp), str, len, ret)) {
+		return ret;
+	}
+
 	// Get the encoding name for the primary code page.
 	char cp_name[20];
 	codePageToEncName(cp_name, sizeof(cp_name), cp);
@@ -288,20 +410,12 @@ u16string cpN_to_utf16(unsigned int cp, const char *str, int len, unsigned int f
 	// Attempt to convert the text to UTF-16.
 	// NOTE: "//IGNORE" sometimes doesn't work, so we won't
 	// check for TEXTCONV_FLAG_CP1252_FALLBACK here.
-	u16string ret;
 	char16_t *wcs = reinterpret_cast<char16_t*>(rp_iconv((char*)str, len*sizeof(*str), cp_name, RP_ICONV_UTF16_ENCODING, ignoreErr));
 	if (!wcs /*&& (flags & TEXTCONV_FLAG_CP1252_FALLBACK)*/) {
-		// Try cp1252 fallback.
-		// NOTE: Sometimes cp1252 fails, even with ignore set.
-		if (cp != 1252) {
-			wcs = reinterpret_cast<char16_t*>(rp_iconv((char*)str, len*sizeof(*str), "CP1252", RP_ICONV_UTF16_ENCODING, true));
-		}
-		if (!wcs) {
-			// Try Latin-1 fallback.
-			if (cp != CP_LATIN1) {
-				wcs = reinterpret_cast<char16_t*>(rp_iconv((char*)str, len*sizeof(*str), "LATIN1//IGNORE", RP_ICONV_UTF16_ENCODING, true));
-			}
-		}
+		// Use the cp1252 fallback.
+		// NOTE: The cp1252 table maps every byte, so this can't fail.
+		cpN_to_utf16_fast(1252, str, len, ret);
+		return ret;
 	}
 
 	if (wcs) {
@@ -18,6 +18,7 @@
 
 // C++ STL classes
 using std::string;
+using std::u16string;
 
 namespace LibRpText {
 
@@ -82,6 +83,200 @@ static string str8_to_utf8(const char16_t tbl[256], const char *str, int len)
 	return s_utf8;
 }
 
+/**
+ * Get the high-half lookup table for a table-driven code page.
+ *
+ * If the string has characters that are undefined in cp1252,
+ * iconv fails, and the string is decoded as Latin-1 instead.
+ * The same is done here.
+ *
+ * @param cp		[in] Code page number.
+ * @param str		[in] First non-ASCII character in the string.
+ * @param end		[in] End of the string.
+ * @param pTbl		[out] Lookup table for 0x80 and up. (nullptr if identity)
+ * @param pTblSize	[out] Number of entries in the lookup table.
+ * @return True if the code page is table-driven; false if not.
+ */
+static bool getHighHalfTable(unsigned int cp, const char *str, const char *end,
+	const char16_t **pTbl, unsigned int *pTblSize)
+{
+	switch (cp) {
+		case 1252:
+			for (; str < end; str++) {
+				const uint8_t ch = (uint8_t)*str;
+				if (ch == 0)
+					break;
+				if (ch >= 0x80 && ch < 0xA0 && CodePageTables::cp1252_lkup_80[ch - 0x80] == 0) {
+					// Undefined character. Use Latin-1.
+					*pTbl = nullptr;
+					*pTblSize = 0;
+					return true;
+				}
+			}
+			*pTbl = CodePageTables::cp1252_lkup_80;
+			*pTblSize = ARRAY_SIZE(CodePageTables::cp1252_lkup_80);
+			return true;
+		case 437:
+			*pTbl = CodePageTables::cp437_lkup_80;
+			*pTblSize = ARRAY_SIZE(CodePageTables::cp437_lkup_80);
+			return true;
+		case CP_LATIN1:
+			*pTbl = nullptr;
+			*pTblSize = 0;
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+/**
+ * Is the specified code page a superset of ASCII?
+ * @param cp Code page number.
+ * @return True if 0x00-0x7F are always ASCII; false if not.
+ */
+static inline bool isAsciiCompatible(unsigned int cp)
+{
+	switch (cp) {
+		case 437:
+		case 1250: case 1251: case 1252: case 1253: case 1254:
+		case 1255: case 1256: case 1257: case 1258:
+		case CP_SJIS:
+		case CP_LATIN1:
+		case CP_UTF8:
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+/**
+ * Find the end of the ASCII-only prefix of a string.
+ * @param str	[in] 8-bit text.
+ * @param end	[in] End of the string.
+ * @return Pointer to the first byte that isn't 0x01-0x7F, or end.
+ */
+static inline const char *findAsciiEnd(const char *str, const char *end)
+{
+	for (; str < end; str++) {
+		// NOTE: 0x00 wraps around to 0xFF here.
+		if ((uint8_t)(*str - 1) >= 0x7F)
+			break;
+	}
+	return str;
+}
+
+/**
+ * Convert 8-bit text to UTF-8 without using the system's conversion functions.
+ * This handles ASCII-only text in ASCII-compatible code pages, and any text
+ * in cp1252, cp437, and Latin-1.
+ *
+ * Conversion stops at the first NULL byte.
+ * CP_ACP is *not* handled here; the caller must resolve it first.
+ *
+ * @param cp	[in] Code page number.
+ * @param str	[in] 8-bit text.
+ * @param len	[in] Length of str, in bytes. (Must not be negative.)
+ * @param ret	[out] UTF-8 string.
+ * @return True if the string was converted; false if the system's conversion functions must be used.
+ */
+bool cpN_to_utf8_fast(unsigned int cp, const char *str, int len, std::string &ret)
+{
+	assert(len >= 0);
+	if (!isAsciiCompatible(cp))
+		return false;
+
+	const char *const end = str + len;
+	const char *p = findAsciiEnd(str, end);
+	if (p == end || *p == '\0') {
+		// ASCII only.
+		ret.assign(str, p - str);
+		return true;
+	}
+
+	const char16_t *tbl;
+	unsigned int tblSize;
+	if (!getHighHalfTable(cp, p, end, &tbl, &tblSize)) {
+		// Not a table-driven code page.
+		return false;
+	}
+
+	ret.reserve(len + ((end - p) * 2));
+	ret.assign(str, p - str);
+	for (; p < end; p++) {
+		// NOTE: The (uint8_t) cast is required.
+		// Otherwise, *p is interpreted as a signed char,
+		// which causes all sorts of shenanigans.
+		const uint8_t ch = (uint8_t)*p;
+		if (ch < 0x80) {
+			if (ch == 0)
+				break;
+			ret += (char)ch;
+			continue;
+		}
+
+		const unsigned int idx = ch - 0x80;
+		const char16_t ch16 = (idx < tblSize) ? tbl[idx] : ch;
+		if (ch16 < 0x0800) {
+			ret += (char)(0xC0 | ((ch16 >>  6) & 0x1F));
+			ret += (char)(0x80 | ((ch16 >>  0) & 0x3F));
+		} else /*if (ch16 < 0x10000)*/ {
+			ret += (char)(0xE0 | ((ch16 >> 12) & 0x0F));
+			ret += (char)(0x80 | ((ch16 >>  6) & 0x3F));
+			ret += (char)(0x80 | ((ch16 >>  0) & 0x3F));
+		}
+	}
+	return true;
+}
+
+/**
+ * Convert 8-bit text to UTF-16 without using the system's conversion functions.
+ * This handles ASCII-only text in ASCII-compatible code pages, and any text
+ * in cp1252, cp437, and Latin-1.
+ *
+ * Conversion stops at the first NULL byte.
+ * CP_ACP is *not* handled here; the caller must resolve it first.
+ *
+ * @param cp	[in] Code page number.
+ * @param str	[in] 8-bit text.
+ * @param len	[in] Length of str, in bytes. (Must not be negative.)
+ * @param ret	[out] UTF-16 string.
+ * @return True if the string was converted; false if the system's conversion functions must be used.
+ */
+bool cpN_to_utf16_fast(unsigned int cp, const char *str, int len, std::u16string &ret)
+{
+	assert(len >= 0);
+	if (!isAsciiCompatible(cp))
+		return false;
+
+	const char *const end = str + len;
+	const char *p = findAsciiEnd(str, end);
+	const char16_t *tbl = nullptr;
+	unsigned int tblSize = 0;
+	if (p != end && *p != '\0') {
+		if (!getHighHalfTable(cp, p, end, &tbl, &tblSize)) {
+			// Not a table-driven code page.
+			return false;
+		}
+	}
+
+	ret.clear();
+	ret.reserve(len);
+	for (p = str; p < end; p++) {
+		const uint8_t ch = (uint8_t)*p;
+		if (ch < 0x80) {
+			if (ch == 0)
+				break;
+			ret += (char16_t)ch;
+		} else {
+			const unsigned int idx = ch - 0x80;
+			ret += (idx < tblSize) ? tbl[idx] : (char16_t)ch;
+		}
+	}
+	return true;
+}
+
 /**
  * Convert 8-bit text to UTF-8 using an RP-custom code page.
  * Code page number must be CP_RP_*.
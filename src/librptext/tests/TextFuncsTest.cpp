@@ -21,8 +21,10 @@ using namespace LibRpText;
 
 // C++ includes.
 #include <string>
+#include <vector>
 using std::string;
 using std::u16string;
+using std::vector;
 
 #define C8(x) reinterpret_cast<const char*>(x)
 #define C16(x) reinterpret_cast<const char16_t*>(x)
@@ -65,6 +67,18 @@ class TextFuncsTest : public ::testing::Test
 		 */
 		static const char16_t cp1252_utf16_data[250];
 
+		/**
+		 * cp1252 to UTF-8: All 255 non-NULL bytes, 0x01-0xFF.
+		 * Each byte was converted as a separate string.
+		 */
+		static const uint8_t cp1252_all_utf8[400+1];
+
+		/**
+		 * cp1252 to UTF-16: All 256 bytes, 0x00-0xFF.
+		 * Each byte was converted as a separate string.
+		 */
+		static const char16_t cp1252_all_utf16[256];
+
 		/**
 		 * Shift-JIS test string.
 		 *
@@ -195,11 +209,140 @@ class TextFuncsTest : public ::testing::Test
 		 * - utf8_to_utf16(cpN_to_utf8(CP_RP_ATASCII, atascii_data, ARRAY_SIZE_I(atascii_data)-1))
 		 */
 		static const char16_t atascii_utf16_data[229+1];
+
+		/**
+		 * cp437 to UTF-8: All 255 non-NULL bytes, 0x01-0xFF.
+		 */
+		static const uint8_t cp437_all_utf8[445+1];
+
+		/**
+		 * cp437 to UTF-16: All 256 bytes, 0x00-0xFF.
+		 */
+		static const char16_t cp437_all_utf16[256];
+
+	public:
+		/**
+		 * Split a UTF-8 string into individual characters.
+		 * @param utf8 UTF-8 string, with one character for each byte, 0x01-0xFF.
+		 * @return 256 UTF-8 characters, indexed by byte value. ([0] is empty.)
+		 */
+		static vector<string> splitUtf8(const uint8_t *utf8);
+
+		/**
+		 * Convert strings with a single non-ASCII byte at various offsets,
+		 * and verify that they're converted correctly.
+		 * This checks the boundary between the ASCII fast path
+		 * and the lookup table path.
+		 * @param cp Code page
+		 * @param utf8_chars UTF-8 characters, indexed by byte value (from splitUtf8())
+		 * @param utf16_tbl UTF-16 characters, indexed by byte value
+		 * @param hiBytes Non-ASCII bytes to use
+		 * @param hiBytesCount Number of bytes in hiBytes
+		 */
+		static void checkMixedAscii(unsigned int cp,
+			const vector<string> &utf8_chars, const char16_t *utf16_tbl,
+			const uint8_t *hiBytes, size_t hiBytesCount);
 };
 
 // Test strings are located in TextFuncsTest_data.hpp.
 #include "TextFuncsTest_data.hpp"
 
+/**
+ * Split a UTF-8 string into individual characters.
+ * @param utf8 UTF-8 string, with one character for each byte, 0x01-0xFF.
+ * @return 256 UTF-8 characters, indexed by byte value. ([0] is empty.)
+ */
+vector<string> TextFuncsTest::splitUtf8(const uint8_t *utf8)
+{
+	vector<string> chars;
+	chars.reserve(256);
+	chars.emplace_back();	// 0x00
+
+	const char *p = C8(utf8);
+	while (*p != '\0') {
+		size_t len;
+		const uint8_t lead = static_cast<uint8_t>(*p);
+		if (lead < 0x80) {
+			len = 1;
+		} else if ((lead & 0xE0) == 0xC0) {
+			len = 2;
+		} else {
+			len = 3;
+		}
+		chars.emplace_back(p, len);
+		p += len;
+	}
+	return chars;
+}
+
+/**
+ * Convert strings with a single non-ASCII byte at various offsets,
+ * and verify that they're converted correctly.
+ * This checks the boundary between the ASCII fast path
+ * and the lookup table path.
+ * @param cp Code page
+ * @param utf8_chars UTF-8 characters, indexed by byte value (from splitUtf8())
+ * @param utf16_tbl UTF-16 characters, indexed by byte value
+ * @param hiBytes Non-ASCII bytes to use
+ * @param hiBytesCount Number of bytes in hiBytes
+ */
+void TextFuncsTest::checkMixedAscii(unsigned int cp,
+	const vector<string> &utf8_chars, const char16_t *utf16_tbl,
+	const uint8_t *hiBytes, size_t hiBytesCount)
+{
+	static const char ascii_in[] =
+		"The quick brown fox jumps over the lazy dog. "
+		"0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+	static const int len = ARRAY_SIZE_I(ascii_in) - 1;
+
+	// Offsets around the start, 8-byte and 16-byte boundaries, and the end.
+	static const int offsets[] = {0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, len-1};
+
+	size_t hiIdx = 0;
+	for (const int offset : offsets) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "offset %d", offset);
+		SCOPED_TRACE(buf);
+
+		// Single non-ASCII byte.
+		string in(ascii_in, len);
+		in[offset] = static_cast<char>(hiBytes[hiIdx]);
+		hiIdx = (hiIdx + 1) % hiBytesCount;
+
+		// Non-ASCII byte at the end of the string.
+		string in2(in);
+		in2[len-1] = static_cast<char>(hiBytes[hiIdx]);
+		hiIdx = (hiIdx + 1) % hiBytesCount;
+
+		for (const string *const p_in : {&in, &in2}) {
+			string utf8_expected;
+			u16string utf16_expected;
+			for (const char ch : *p_in) {
+				const uint8_t chr = static_cast<uint8_t>(ch);
+				utf8_expected += utf8_chars[chr];
+				utf16_expected += utf16_tbl[chr];
+			}
+
+			EXPECT_EQ(utf8_expected, cpN_to_utf8(cp, p_in->data(), len));
+			EXPECT_EQ(utf16_expected, cpN_to_utf16(cp, p_in->data(), len));
+			EXPECT_EQ(utf8_expected, cpN_to_utf8(cp, p_in->c_str(), -1));
+			EXPECT_EQ(utf16_expected, cpN_to_utf16(cp, p_in->c_str(), -1));
+		}
+
+		// ASCII text, then a NULL byte at the offset, then non-ASCII text.
+		// Conversion should stop at the NULL byte.
+		string in3(in2);
+		in3[offset] = '\0';
+		if (offset < len-1) {
+			in3[offset+1] = static_cast<char>(hiBytes[hiIdx]);
+		}
+		const string utf8_expected(ascii_in, offset);
+		const u16string utf16_expected(utf8_expected.begin(), utf8_expected.end());
+		EXPECT_EQ(utf8_expected, cpN_to_utf8(cp, in3.data(), len));
+		EXPECT_EQ(utf16_expected, cpN_to_utf16(cp, in3.data(), len));
+	}
+}
+
 /** Code Page 1252 **/
 
 /**
@@ -463,6 +606,102 @@ TEST_F(TextFuncsTest, cp1252_sjis_to_utf16_japanese)
 	EXPECT_EQ(sjis_utf16_data, str);
 }
 
+/** Code Page 1252: Table-driven conversion **/
+
+/**
+ * Convert each cp1252 byte as a separate string.
+ */
+TEST_F(TextFuncsTest, cp1252_all_bytes)
+{
+	const vector<string> utf8_chars = splitUtf8(cp1252_all_utf8);
+	ASSERT_EQ(256U, utf8_chars.size());
+
+	for (unsigned int i = 0; i < 256; i++) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "byte 0x%02X", i);
+		SCOPED_TRACE(buf);
+
+		const char in = static_cast<char>(i);
+		EXPECT_EQ(utf8_chars[i], cp1252_to_utf8(&in, 1));
+
+		const u16string u16str = cp1252_to_utf16(&in, 1);
+		if (i == 0) {
+			// NULL byte: Empty string.
+			EXPECT_TRUE(u16str.empty());
+		} else {
+			ASSERT_EQ(1U, u16str.size());
+			EXPECT_EQ(cp1252_all_utf16[i], u16str[0]);
+		}
+	}
+}
+
+/**
+ * Test strings with bytes that are undefined in cp1252.
+ * (0x81, 0x8D, 0x8F, 0x90, 0x9D)
+ *
+ * The system conversion functions fail on these bytes,
+ * and the entire string is converted as Latin-1 instead.
+ */
+TEST_F(TextFuncsTest, cp1252_undefined_bytes)
+{
+	static const uint8_t undefined_bytes[] = {0x81, 0x8D, 0x8F, 0x90, 0x9D};
+
+	// All bytes, 0x01-0xFF, as a single string.
+	// This includes the undefined bytes, so the whole string is Latin-1.
+	char all_bytes[256];
+	u16string utf16_expected;
+	for (unsigned int i = 1; i < 256; i++) {
+		all_bytes[i-1] = static_cast<char>(i);
+		utf16_expected += static_cast<char16_t>(i);
+	}
+	all_bytes[255] = '\0';
+	EXPECT_EQ(utf16_expected, cp1252_to_utf16(all_bytes, 255));
+	EXPECT_EQ(utf16_expected, cp1252_to_utf16(all_bytes, -1));
+	EXPECT_EQ(latin1_to_utf8(all_bytes, 255), cp1252_to_utf8(all_bytes, 255));
+	EXPECT_EQ(latin1_to_utf8(all_bytes, 255), cp1252_to_utf8(all_bytes, -1));
+
+	// Without the undefined byte, 0x80 and 0x99 are converted as cp1252.
+	static const uint8_t defined_in[] = {'A', 0x80, 'B', 0x99, 0};
+	static const char16_t defined_utf16[] = {'A', 0x20AC, 'B', 0x2122, 0};
+	static const uint8_t defined_utf8[] = {'A', 0xE2,0x82,0xAC, 'B', 0xE2,0x84,0xA2, 0};
+	EXPECT_EQ(defined_utf16, cp1252_to_utf16(C8(defined_in), -1));
+	EXPECT_EQ(C8(defined_utf8), cp1252_to_utf8(C8(defined_in), -1));
+
+	for (const uint8_t undef : undefined_bytes) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "byte 0x%02X", undef);
+		SCOPED_TRACE(buf);
+
+		// With an undefined byte, 0x80 and 0x99 are converted as Latin-1.
+		const uint8_t in[] = {'A', 0x80, 'B', undef, 'C', 0x99, 0};
+		const char16_t in_utf16[] = {'A', 0x0080, 'B', undef, 'C', 0x0099, 0};
+		const uint8_t in_utf8[] = {'A', 0xC2,0x80, 'B', 0xC2,undef, 'C', 0xC2,0x99, 0};
+		EXPECT_EQ(in_utf16, cp1252_to_utf16(C8(in), -1));
+		EXPECT_EQ(C8(in_utf8), cp1252_to_utf8(C8(in), -1));
+
+		// Undefined byte after a NULL byte: It's ignored.
+		const uint8_t in_null[] = {'A', 0x80, 'B', 0x99, 0, undef, 0};
+		EXPECT_EQ(defined_utf16, cp1252_to_utf16(C8(in_null), ARRAY_SIZE_I(in_null)));
+		EXPECT_EQ(C8(defined_utf8), cp1252_to_utf8(C8(in_null), ARRAY_SIZE_I(in_null)));
+	}
+}
+
+/**
+ * Test cp1252 strings with ASCII and non-ASCII text.
+ */
+TEST_F(TextFuncsTest, cp1252_mixed_ascii)
+{
+	const vector<string> utf8_chars = splitUtf8(cp1252_all_utf8);
+	ASSERT_EQ(256U, utf8_chars.size());
+
+	// NOTE: Undefined bytes are tested in cp1252_undefined_bytes.
+	static const uint8_t hiBytes[] = {
+		0x80, 0x8A, 0x99, 0x9F, 0xA0, 0xA9, 0xC0, 0xDF, 0xE9, 0xFF,
+	};
+	ASSERT_NO_FATAL_FAILURE(checkMixedAscii(1252, utf8_chars, cp1252_all_utf16,
+		hiBytes, ARRAY_SIZE(hiBytes)));
+}
+
 /** UTF-8 to UTF-16 and vice-versa **/
 
 /**
@@ -910,6 +1149,67 @@ TEST_F(TextFuncsTest, atascii_to_utf8)
 	EXPECT_EQ(atascii_utf16_data, u16str);
 }
 
+
+/** Code Page 437 **/
+
+/**
+ * Convert each cp437 byte as a separate string,
+ * and all bytes as a single string.
+ */
+TEST_F(TextFuncsTest, cp437_all_bytes)
+{
+	const vector<string> utf8_chars = splitUtf8(cp437_all_utf8);
+	ASSERT_EQ(256U, utf8_chars.size());
+
+	for (unsigned int i = 0; i < 256; i++) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "byte 0x%02X", i);
+		SCOPED_TRACE(buf);
+
+		const char in = static_cast<char>(i);
+		EXPECT_EQ(utf8_chars[i], cpN_to_utf8(437, &in, 1));
+
+		const u16string u16str = cpN_to_utf16(437, &in, 1);
+		if (i == 0) {
+			// NULL byte: Empty string.
+			EXPECT_TRUE(u16str.empty());
+		} else {
+			ASSERT_EQ(1U, u16str.size());
+			EXPECT_EQ(cp437_all_utf16[i], u16str[0]);
+		}
+	}
+
+	// All bytes, 0x01-0xFF, as a single string.
+	char all_bytes[256];
+	for (unsigned int i = 1; i < 256; i++) {
+		all_bytes[i-1] = static_cast<char>(i);
+	}
+	all_bytes[255] = '\0';
+
+	string str = cpN_to_utf8(437, all_bytes, 255);
+	EXPECT_EQ(ARRAY_SIZE(cp437_all_utf8)-1, str.size());
+	EXPECT_EQ(C8(cp437_all_utf8), str);
+
+	u16string u16str = cpN_to_utf16(437, all_bytes, -1);
+	EXPECT_EQ(255U, u16str.size());
+	EXPECT_EQ(u16string(&cp437_all_utf16[1], 255), u16str);
+}
+
+/**
+ * Test cp437 strings with ASCII and non-ASCII text.
+ */
+TEST_F(TextFuncsTest, cp437_mixed_ascii)
+{
+	const vector<string> utf8_chars = splitUtf8(cp437_all_utf8);
+	ASSERT_EQ(256U, utf8_chars.size());
+
+	static const uint8_t hiBytes[] = {
+		0x80, 0x81, 0x9E, 0xA9, 0xB0, 0xC5, 0xDB, 0xE0, 0xEC, 0xFE, 0xFF,
+	};
+	ASSERT_NO_FATAL_FAILURE(checkMixedAscii(437, utf8_chars, cp437_all_utf16,
+		hiBytes, ARRAY_SIZE(hiBytes)));
+}
+
 } }
 
 /**
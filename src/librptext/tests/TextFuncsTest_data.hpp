@@ -162,6 +162,126 @@ const char16_t TextFuncsTest::cp1252_utf16_data[250] =
 	0x00FF,0x0000
 };
 
+/**
+ * cp1252 to UTF-8: All 255 non-NULL bytes, 0x01-0xFF.
+ * Each byte was converted as a separate string.
+ *
+ * The undefined bytes (0x81, 0x8D, 0x8F, 0x90, 0x9D) are converted
+ * as Latin-1, since the system conversion functions fail on them,
+ * so the string falls back to Latin-1.
+ */
+const uint8_t TextFuncsTest::cp1252_all_utf8[400+1] = {
+	// 0x00
+	     0x01,0x02,0x03,0x04,0x05,0x06,0x07,
+	0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+	// 0x10
+	0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,
+	0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,
+	// 0x20
+	0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,
+	0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,
+	// 0x30
+	0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,
+	0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+	// 0x40
+	0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,
+	0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+	// 0x50
+	0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,
+	0x58,0x59,0x5A,0x5B,0x5C,0x5D,0x5E,0x5F,
+	// 0x60
+	0x60,0x61,0x62,0x63,0x64,0x65,0x66,0x67,
+	0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,
+	// 0x70
+	0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,
+	0x78,0x79,0x7A,0x7B,0x7C,0x7D,0x7E,0x7F,
+	// 0x80
+	0xE2,0x82,0xAC, 0xC2,0x81, 0xE2,0x80,0x9A, 0xC6,0x92, 0xE2,0x80,0x9E, 0xE2,0x80,0xA6, 0xE2,0x80,0xA0, 0xE2,0x80,0xA1,
+	0xCB,0x86, 0xE2,0x80,0xB0, 0xC5,0xA0, 0xE2,0x80,0xB9, 0xC5,0x92, 0xC2,0x8D, 0xC5,0xBD, 0xC2,0x8F,
+	// 0x90
+	0xC2,0x90, 0xE2,0x80,0x98, 0xE2,0x80,0x99, 0xE2,0x80,0x9C, 0xE2,0x80,0x9D, 0xE2,0x80,0xA2, 0xE2,0x80,0x93, 0xE2,0x80,0x94,
+	0xCB,0x9C, 0xE2,0x84,0xA2, 0xC5,0xA1, 0xE2,0x80,0xBA, 0xC5,0x93, 0xC2,0x9D, 0xC5,0xBE, 0xC5,0xB8,
+	// 0xA0
+	0xC2,0xA0, 0xC2,0xA1, 0xC2,0xA2, 0xC2,0xA3, 0xC2,0xA4, 0xC2,0xA5, 0xC2,0xA6, 0xC2,0xA7,
+	0xC2,0xA8, 0xC2,0xA9, 0xC2,0xAA, 0xC2,0xAB, 0xC2,0xAC, 0xC2,0xAD, 0xC2,0xAE, 0xC2,0xAF,
+	// 0xB0
+	0xC2,0xB0, 0xC2,0xB1, 0xC2,0xB2, 0xC2,0xB3, 0xC2,0xB4, 0xC2,0xB5, 0xC2,0xB6, 0xC2,0xB7,
+	0xC2,0xB8, 0xC2,0xB9, 0xC2,0xBA, 0xC2,0xBB, 0xC2,0xBC, 0xC2,0xBD, 0xC2,0xBE, 0xC2,0xBF,
+	// 0xC0
+	0xC3,0x80, 0xC3,0x81, 0xC3,0x82, 0xC3,0x83, 0xC3,0x84, 0xC3,0x85, 0xC3,0x86, 0xC3,0x87,
+	0xC3,0x88, 0xC3,0x89, 0xC3,0x8A, 0xC3,0x8B, 0xC3,0x8C, 0xC3,0x8D, 0xC3,0x8E, 0xC3,0x8F,
+	// 0xD0
+	0xC3,0x90, 0xC3,0x91, 0xC3,0x92, 0xC3,0x93, 0xC3,0x94, 0xC3,0x95, 0xC3,0x96, 0xC3,0x97,
+	0xC3,0x98, 0xC3,0x99, 0xC3,0x9A, 0xC3,0x9B, 0xC3,0x9C, 0xC3,0x9D, 0xC3,0x9E, 0xC3,0x9F,
+	// 0xE0
+	0xC3,0xA0, 0xC3,0xA1, 0xC3,0xA2, 0xC3,0xA3, 0xC3,0xA4, 0xC3,0xA5, 0xC3,0xA6, 0xC3,0xA7,
+	0xC3,0xA8, 0xC3,0xA9, 0xC3,0xAA, 0xC3,0xAB, 0xC3,0xAC, 0xC3,0xAD, 0xC3,0xAE, 0xC3,0xAF,
+	// 0xF0
+	0xC3,0xB0, 0xC3,0xB1, 0xC3,0xB2, 0xC3,0xB3, 0xC3,0xB4, 0xC3,0xB5, 0xC3,0xB6, 0xC3,0xB7,
+	0xC3,0xB8, 0xC3,0xB9, 0xC3,0xBA, 0xC3,0xBB, 0xC3,0xBC, 0xC3,0xBD, 0xC3,0xBE, 0xC3,0xBF,
+	0
+};
+
+/**
+ * cp1252 to UTF-16: All 256 bytes, 0x00-0xFF.
+ * Each byte was converted as a separate string.
+ * (0x00 results in an empty string.)
+ *
+ * The undefined bytes (0x81, 0x8D, 0x8F, 0x90, 0x9D) are converted
+ * as Latin-1, since the system conversion functions fail on them,
+ * so the string falls back to Latin-1.
+ */
+const char16_t TextFuncsTest::cp1252_all_utf16[256] = {
+	// 0x00
+	0x0000,0x0001,0x0002,0x0003,0x0004,0x0005,0x0006,0x0007,
+	0x0008,0x0009,0x000A,0x000B,0x000C,0x000D,0x000E,0x000F,
+	// 0x10
+	0x0010,0x0011,0x0012,0x0013,0x0014,0x0015,0x0016,0x0017,
+	0x0018,0x0019,0x001A,0x001B,0x001C,0x001D,0x001E,0x001F,
+	// 0x20
+	0x0020,0x0021,0x0022,0x0023,0x0024,0x0025,0x0026,0x0027,
+	0x0028,0x0029,0x002A,0x002B,0x002C,0x002D,0x002E,0x002F,
+	// 0x30
+	0x0030,0x0031,0x0032,0x0033,0x0034,0x0035,0x0036,0x0037,
+	0x0038,0x0039,0x003A,0x003B,0x003C,0x003D,0x003E,0x003F,
+	// 0x40
+	0x0040,0x0041,0x0042,0x0043,0x0044,0x0045,0x0046,0x0047,
+	0x0048,0x0049,0x004A,0x004B,0x004C,0x004D,0x004E,0x004F,
+	// 0x50
+	0x0050,0x0051,0x0052,0x0053,0x0054,0x0055,0x0056,0x0057,
+	0x0058,0x0059,0x005A,0x005B,0x005C,0x005D,0x005E,0x005F,
+	// 0x60
+	0x0060,0x0061,0x0062,0x0063,0x0064,0x0065,0x0066,0x0067,
+	0x0068,0x0069,0x006A,0x006B,0x006C,0x006D,0x006E,0x006F,
+	// 0x70
+	0x0070,0x0071,0x0072,0x0073,0x0074,0x0075,0x0076,0x0077,
+	0x0078,0x0079,0x007A,0x007B,0x007C,0x007D,0x007E,0x007F,
+	// 0x80
+	0x20AC,0x0081,0x201A,0x0192,0x201E,0x2026,0x2020,0x2021,
+	0x02C6,0x2030,0x0160,0x2039,0x0152,0x008D,0x017D,0x008F,
+	// 0x90
+	0x0090,0x2018,0x2019,0x201C,0x201D,0x2022,0x2013,0x2014,
+	0x02DC,0x2122,0x0161,0x203A,0x0153,0x009D,0x017E,0x0178,
+	// 0xA0
+	0x00A0,0x00A1,0x00A2,0x00A3,0x00A4,0x00A5,0x00A6,0x00A7,
+	0x00A8,0x00A9,0x00AA,0x00AB,0x00AC,0x00AD,0x00AE,0x00AF,
+	// 0xB0
+	0x00B0,0x00B1,0x00B2,0x00B3,0x00B4,0x00B5,0x00B6,0x00B7,
+	0x00B8,0x00B9,0x00BA,0x00BB,0x00BC,0x00BD,0x00BE,0x00BF,
+	// 0xC0
+	0x00C0,0x00C1,0x00C2,0x00C3,0x00C4,0x00C5,0x00C6,0x00C7,
+	0x00C8,0x00C9,0x00CA,0x00CB,0x00CC,0x00CD,0x00CE,0x00CF,
+	// 0xD0
+	0x00D0,0x00D1,0x00D2,0x00D3,0x00D4,0x00D5,0x00D6,0x00D7,
+	0x00D8,0x00D9,0x00DA,0x00DB,0x00DC,0x00DD,0x00DE,0x00DF,
+	// 0xE0
+	0x00E0,0x00E1,0x00E2,0x00E3,0x00E4,0x00E5,0x00E6,0x00E7,
+	0x00E8,0x00E9,0x00EA,0x00EB,0x00EC,0x00ED,0x00EE,0x00EF,
+	// 0xF0
+	0x00F0,0x00F1,0x00F2,0x00F3,0x00F4,0x00F5,0x00F6,0x00F7,
+	0x00F8,0x00F9,0x00FA,0x00FB,0x00FC,0x00FD,0x00FE,0x00FF,
+};
+
 /**
  * Shift-JIS test string.
  *
@@ -707,3 +827,116 @@ const char16_t TextFuncsTest::atascii_utf16_data[229+1] =
 
 	0
 };
+
+/**
+ * cp437 to UTF-8: All 255 non-NULL bytes, 0x01-0xFF.
+ * 0x01-0x1F and 0x7F are control codes, not the
+ * graphics characters used by the IBM PC BIOS font.
+ */
+const uint8_t TextFuncsTest::cp437_all_utf8[445+1] = {
+	// 0x00
+	     0x01,0x02,0x03,0x04,0x05,0x06,0x07,
+	0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+	// 0x10
+	0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,
+	0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,
+	// 0x20
+	0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,
+	0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,
+	// 0x30
+	0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,
+	0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+	// 0x40
+	0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47,
+	0x48,0x49,0x4A,0x4B,0x4C,0x4D,0x4E,0x4F,
+	// 0x50
+	0x50,0x51,0x52,0x53,0x54,0x55,0x56,0x57,
+	0x58,0x59,0x5A,0x5B,0x5C,0x5D,0x5E,0x5F,
+	// 0x60
+	0x60,0x61,0x62,0x63,0x64,0x65,0x66,0x67,
+	0x68,0x69,0x6A,0x6B,0x6C,0x6D,0x6E,0x6F,
+	// 0x70
+	0x70,0x71,0x72,0x73,0x74,0x75,0x76,0x77,
+	0x78,0x79,0x7A,0x7B,0x7C,0x7D,0x7E,0x7F,
+	// 0x80
+	0xC3,0x87, 0xC3,0xBC, 0xC3,0xA9, 0xC3,0xA2, 0xC3,0xA4, 0xC3,0xA0, 0xC3,0xA5, 0xC3,0xA7,
+	0xC3,0xAA, 0xC3,0xAB, 0xC3,0xA8, 0xC3,0xAF, 0xC3,0xAE, 0xC3,0xAC, 0xC3,0x84, 0xC3,0x85,
+	// 0x90
+	0xC3,0x89, 0xC3,0xA6, 0xC3,0x86, 0xC3,0xB4, 0xC3,0xB6, 0xC3,0xB2, 0xC3,0xBB, 0xC3,0xB9,
+	0xC3,0xBF, 0xC3,0x96, 0xC3,0x9C, 0xC2,0xA2, 0xC2,0xA3, 0xC2,0xA5, 0xE2,0x82,0xA7, 0xC6,0x92,
+	// 0xA0
+	0xC3,0xA1, 0xC3,0xAD, 0xC3,0xB3, 0xC3,0xBA, 0xC3,0xB1, 0xC3,0x91, 0xC2,0xAA, 0xC2,0xBA,
+	0xC2,0xBF, 0xE2,0x8C,0x90, 0xC2,0xAC, 0xC2,0xBD, 0xC2,0xBC, 0xC2,0xA1, 0xC2,0xAB, 0xC2,0xBB,
+	// 0xB0
+	0xE2,0x96,0x91, 0xE2,0x96,0x92, 0xE2,0x96,0x93, 0xE2,0x94,0x82, 0xE2,0x94,0xA4, 0xE2,0x95,0xA1, 0xE2,0x95,0xA2, 0xE2,0x95,0x96,
+	0xE2,0x95,0x95, 0xE2,0x95,0xA3, 0xE2,0x95,0x91, 0xE2,0x95,0x97, 0xE2,0x95,0x9D, 0xE2,0x95,0x9C, 0xE2,0x95,0x9B, 0xE2,0x94,0x90,
+	// 0xC0
+	0xE2,0x94,0x94, 0xE2,0x94,0xB4, 0xE2,0x94,0xAC, 0xE2,0x94,0x9C, 0xE2,0x94,0x80, 0xE2,0x94,0xBC, 0xE2,0x95,0x9E, 0xE2,0x95,0x9F,
+	0xE2,0x95,0x9A, 0xE2,0x95,0x94, 0xE2,0x95,0xA9, 0xE2,0x95,0xA6, 0xE2,0x95,0xA0, 0xE2,0x95,0x90, 0xE2,0x95,0xAC, 0xE2,0x95,0xA7,
+	// 0xD0
+	0xE2,0x95,0xA8, 0xE2,0x95,0xA4, 0xE2,0x95,0xA5, 0xE2,0x95,0x99, 0xE2,0x95,0x98, 0xE2,0x95,0x92, 0xE2,0x95,0x93, 0xE2,0x95,0xAB,
+	0xE2,0x95,0xAA, 0xE2,0x94,0x98, 0xE2,0x94,0x8C, 0xE2,0x96,0x88, 0xE2,0x96,0x84, 0xE2,0x96,0x8C, 0xE2,0x96,0x90, 0xE2,0x96,0x80,
+	// 0xE0
+	0xCE,0xB1, 0xC3,0x9F, 0xCE,0x93, 0xCF,0x80, 0xCE,0xA3, 0xCF,0x83, 0xC2,0xB5, 0xCF,0x84,
+	0xCE,0xA6, 0xCE,0x98, 0xCE,0xA9, 0xCE,0xB4, 0xE2,0x88,0x9E, 0xCF,0x86, 0xCE,0xB5, 0xE2,0x88,0xA9,
+	// 0xF0
+	0xE2,0x89,0xA1, 0xC2,0xB1, 0xE2,0x89,0xA5, 0xE2,0x89,0xA4, 0xE2,0x8C,0xA0, 0xE2,0x8C,0xA1, 0xC3,0xB7, 0xE2,0x89,0x88,
+	0xC2,0xB0, 0xE2,0x88,0x99, 0xC2,0xB7, 0xE2,0x88,0x9A, 0xE2,0x81,0xBF, 0xC2,0xB2, 0xE2,0x96,0xA0, 0xC2,0xA0,
+	0
+};
+
+/**
+ * cp437 to UTF-16: All 256 bytes, 0x00-0xFF.
+ * 0x01-0x1F and 0x7F are control codes, not the
+ * graphics characters used by the IBM PC BIOS font.
+ */
+const char16_t TextFuncsTest::cp437_all_utf16[256] = {
+	// 0x00
+	0x0000,0x0001,0x0002,0x0003,0x0004,0x0005,0x0006,0x0007,
+	0x0008,0x0009,0x000A,0x000B,0x000C,0x000D,0x000E,0x000F,
+	// 0x10
+	0x0010,0x0011,0x0012,0x0013,0x0014,0x0015,0x0016,0x0017,
+	0x0018,0x0019,0x001A,0x001B,0x001C,0x001D,0x001E,0x001F,
+	// 0x20
+	0x0020,0x0021,0x0022,0x0023,0x0024,0x0025,0x0026,0x0027,
+	0x0028,0x0029,0x002A,0x002B,0x002C,0x002D,0x002E,0x002F,
+	// 0x30
+	0x0030,0x0031,0x0032,0x0033,0x0034,0x0035,0x0036,0x0037,
+	0x0038,0x0039,0x003A,0x003B,0x003C,0x003D,0x003E,0x003F,
+	// 0x40
+	0x0040,0x0041,0x0042,0x0043,0x0044,0x0045,0x0046,0x0047,
+	0x0048,0x0049,0x004A,0x004B,0x004C,0x004D,0x004E,0x004F,
+	// 0x50
+	0x0050,0x0051,0x0052,0x0053,0x0054,0x0055,0x0056,0x0057,
+	0x0058,0x0059,0x005A,0x005B,0x005C,0x005D,0x005E,0x005F,
+	// 0x60
+	0x0060,0x0061,0x0062,0x0063,0x0064,0x0065,0x0066,0x0067,
+	0x0068,0x0069,0x006A,0x006B,0x006C,0x006D,0x006E,0x006F,
+	// 0x70
+	0x0070,0x0071,0x0072,0x0073,0x0074,0x0075,0x0076,0x0077,
+	0x0078,0x0079,0x007A,0x007B,0x007C,0x007D,0x007E,0x007F,
+	// 0x80
+	0x00C7,0x00FC,0x00E9,0x00E2,0x00E4,0x00E0,0x00E5,0x00E7,
+	0x00EA,0x00EB,0x00E8,0x00EF,0x00EE,0x00EC,0x00C4,0x00C5,
+	// 0x90
+	0x00C9,0x00E6,0x00C6,0x00F4,0x00F6,0x00F2,0x00FB,0x00F9,
+	0x00FF,0x00D6,0x00DC,0x00A2,0x00A3,0x00A5,0x20A7,0x0192,
+	// 0xA0
+	0x00E1,0x00ED,0x00F3,0x00FA,0x00F1,0x00D1,0x00AA,0x00BA,
+	0x00BF,0x2310,0x00AC,0x00BD,0x00BC,0x00A1,0x00AB,0x00BB,
+	// 0xB0
+	0x2591,0x2592,0x2593,0x2502,0x2524,0x2561,0x2562,0x2556,
+	0x2555,0x2563,0x2551,0x2557,0x255D,0x255C,0x255B,0x2510,
+	// 0xC0
+	0x2514,0x2534,0x252C,0x251C,0x2500,0x253C,0x255E,0x255F,
+	0x255A,0x2554,0x2569,0x2566,0x2560,0x2550,0x256C,0x2567,
+	// 0xD0
+	0x2568,0x2564,0x2565,0x2559,0x2558,0x2552,0x2553,0x256B,
+	0x256A,0x2518,0x250C,0x2588,0x2584,0x258C,0x2590,0x2580,
+	// 0xE0
+	0x03B1,0x00DF,0x0393,0x03C0,0x03A3,0x03C3,0x00B5,0x03C4,
+	0x03A6,0x0398,0x03A9,0x03B4,0x221E,0x03C6,0x03B5,0x2229,
+	// 0xF0
+	0x2261,0x00B1,0x2265,0x2264,0x2320,0x2321,0x00F7,0x2248,
+	0x00B0,0x2219,0x00B7,0x221A,0x207F,0x00B2,0x25A0,0x00A0,
+};
@@ -9,6 +9,7 @@
 #include "stdafx.h"
 
 #include "ImageDecoder_ASTC.hpp"
+#include "ImageDecoder_p.hpp"
 #include "basisu_astc_decomp.h"
 
 // librptexture
@@ -87,18 +88,14 @@ rp_image *fromASTC(int width, int height,
 	// Calculate the total number of tiles.
 	const int tilesX = physWidth / block_x;
 	const int tilesY = physHeight / block_y;
-	const unsigned int bytesPerTileRow = tilesX * 16;	// for OpenMP
+	const unsigned int bytesPerTileRow = tilesX * 16;
 
 	// NOTE: Largest ASTC format is 12x12.
 	const int stride_px = img->stride() / sizeof(uint32_t);
 	uint32_t *const pDestBits = static_cast<uint32_t*>(img->bits());
 
-#ifdef _OPENMP
-	bool bErr = false;
-#endif /* _OPENMP */
-
-#pragma omp parallel for
-	for (int y = 0; y < tilesY; y++) {
+	LibRpThreads::TaskGroup group;
+	LibRpThreads::parallel_for(group, 0, tilesY, [&](int y) {
 		const uint8_t *pSrc = &img_buf[y * bytesPerTileRow];
 		for (int x = 0; x < tilesX; x++, pSrc += 16) {
 			// Temporary tile buffer
@@ -111,16 +108,9 @@ rp_image *fromASTC(int width, int height,
 				block_x, block_y);
 			if (!bRet) {
 				// ASTC decompression error.
-#ifdef _OPENMP
-				// Cannot return when using OpenMP,
-				// so set an error value and continue.
-				bErr = true;
-				break;
-#else /* !_OPENMP */
-				// Not using OpenMP, so return immediately.
-				img->unref();
-				return nullptr;
-#endif /* _OPENMP */
+				// Cancel the remaining rows.
+				group.cancel();
+				return;
 			}
 
 			// Blit the tile to the main image buffer.
@@ -138,15 +128,13 @@ rp_image *fromASTC(int width, int height,
 				pTileBuf += block_x;
 			}
 		}
-	}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
-#ifdef _OPENMP
-	if (bErr) {
+	if (group.isCancelled()) {
 		// A decompression error occurred.
 		img->unref();
 		return nullptr;
 	}
-#endif /* _OPENMP */
 
 	if (width < physWidth || height < physHeight) {
 		// Shrink the image.
@@ -673,7 +673,7 @@ rp_image *fromBC7(int width, int height,
 	// Calculate the total number of tiles.
 	const int tilesX = physWidth / 4;
 	const int tilesY = physHeight / 4;
-	const unsigned int bytesPerTileRow = tilesX * sizeof(bc7_block);	// for OpenMP
+	const unsigned int bytesPerTileRow = tilesX * sizeof(bc7_block);
 
 	// Create an rp_image.
 	rp_image *const img = new rp_image(physWidth, physHeight, rp_image::Format::ARGB32);
@@ -688,12 +688,8 @@ rp_image *fromBC7(int width, int height,
 	// Rotation bits makes this difficult...
 	static const rp_image::sBIT_t sBIT = {8,8,8,0,8};
 
-#ifdef _OPENMP
-	bool bErr = false;
-#endif /* _OPENMP */
-
-#pragma omp parallel for
-	for (int y = 0; y < tilesY; y++) {
+	LibRpThreads::TaskGroup group;
+	LibRpThreads::parallel_for(group, 0, tilesY, [&](int y) {
 		// BC7 has eight block modes with varying properties, including
 		// bitfields of different lengths. As such, the only guaranteed
 		// block format we have is 128-bit little-endian, which will be
@@ -710,30 +706,21 @@ rp_image *fromBC7(int width, int height,
 			int ret = decodeBC7Block(tileBuf, bc7_src);
 			if (ret != 0) {
 				// BC7 decoding error.
-#ifdef _OPENMP
-				// Cannot return when using OpenMP,
-				// so set an error value and continue.
-				bErr = true;
-				break;
-#else /* !_OPENMP */
-				// Not using OpenMP, so return immediately.
-				img->unref();
-				return nullptr;
-#endif /* _OPENMP */
+				// Cancel the remaining rows.
+				group.cancel();
+				return;
 			}
 
 			// Blit the tile to the main image buffer.
 			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
 		}
-	}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
-#ifdef _OPENMP
-	if (bErr) {
+	if (group.isCancelled()) {
 		// A decoding error occurred.
 		img->unref();
 		return nullptr;
 	}
-#endif /* _OPENMP */
 
 	if (width < physWidth || height < physHeight) {
 		// Shrink the image.
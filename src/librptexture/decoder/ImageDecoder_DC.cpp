@@ -10,6 +10,7 @@
 
 #include "stdafx.h"
 #include "ImageDecoder_DC.hpp"
+#include "ImageDecoder_p.hpp"
 
 // librptexture
 #include "img/rp_image.hpp"
@@ -104,18 +105,18 @@ rp_image *fromDreamcastSquareTwiddled16(PixelFormat px_format,
 	}
 
 	// Convert one line at a time. (16-bit -> ARGB32)
-	uint32_t *px_dest = static_cast<uint32_t*>(img->bits());
-	const int dest_stride_adj = (img->stride() / sizeof(uint32_t)) - img->width();
+	uint32_t *const bits = static_cast<uint32_t*>(img->bits());
+	const int dest_stride = img->stride() / sizeof(uint32_t);
 	switch (px_format) {
 		case PixelFormat::ARGB1555: {
-			for (unsigned int y = 0; y < static_cast<unsigned int>(height); y++) {
+			LibRpThreads::parallel_for(0, height, [&](int y) {
+				uint32_t *px_dest = &bits[y * dest_stride];
 				for (unsigned int x = 0; x < static_cast<unsigned int>(width); x++) {
 					const unsigned int srcIdx = ((p_tmap[x] << 1) | p_tmap[y]);
 					*px_dest = ARGB1555_to_ARGB32(le16_to_cpu(img_buf[srcIdx]));
 					px_dest++;
 				}
-				px_dest += dest_stride_adj;
-			}
+			}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 			// Set the sBIT metadata.
 			static const rp_image::sBIT_t sBIT = {5,5,5,0,1};
 			img->set_sBIT(&sBIT);
@@ -123,14 +124,14 @@ rp_image *fromDreamcastSquareTwiddled16(PixelFormat px_format,
 		}
 
 		case PixelFormat::RGB565: {
-			for (unsigned int y = 0; y < static_cast<unsigned int>(height); y++) {
+			LibRpThreads::parallel_for(0, height, [&](int y) {
+				uint32_t *px_dest = &bits[y * dest_stride];
 				for (unsigned int x = 0; x < static_cast<unsigned int>(width); x++) {
 					const unsigned int srcIdx = ((p_tmap[x] << 1) | p_tmap[y]);
 					*px_dest = RGB565_to_ARGB32(le16_to_cpu(img_buf[srcIdx]));
 					px_dest++;
 				}
-				px_dest += dest_stride_adj;
-			}
+			}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 			// Set the sBIT metadata.
 			static const rp_image::sBIT_t sBIT = {5,6,5,0,0};
 			img->set_sBIT(&sBIT);
@@ -138,14 +139,14 @@ rp_image *fromDreamcastSquareTwiddled16(PixelFormat px_format,
 		}
 
 		case PixelFormat::ARGB4444: {
-			for (unsigned int y = 0; y < static_cast<unsigned int>(height); y++) {
+			LibRpThreads::parallel_for(0, height, [&](int y) {
+				uint32_t *px_dest = &bits[y * dest_stride];
 				for (unsigned int x = 0; x < static_cast<unsigned int>(width); x++) {
 					const unsigned int srcIdx = ((p_tmap[x] << 1) | p_tmap[y]);
 					*px_dest = ARGB4444_to_ARGB32(le16_to_cpu(img_buf[srcIdx]));
 					px_dest++;
 				}
-				px_dest += dest_stride_adj;
-			}
+			}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 			// Set the sBIT metadata.
 			static const rp_image::sBIT_t sBIT = {4,4,4,0,4};
 			img->set_sBIT(&sBIT);
@@ -273,40 +274,52 @@ rp_image *fromDreamcastVQ16(PixelFormat px_format,
 
 	// Convert one line at a time. (16-bit -> ARGB32)
 	// Reference: https://github.com/nickworonekin/puyotools/blob/548a52684fd48d936526fd91e8ead8e52aa33eb3/Libraries/VrSharp/PvrTexture/PvrDataCodec.cs#L149
-	uint32_t *px_dest = static_cast<uint32_t*>(img->bits());
+	uint32_t *const bits = static_cast<uint32_t*>(img->bits());
 	const int dest_stride = (img->stride() / sizeof(uint32_t));
-	const int dest_stride_adj = dest_stride + dest_stride - img->width();
-	for (unsigned int y = 0; y < static_cast<unsigned int>(height); y += 2, px_dest += dest_stride_adj) {
-	for (unsigned int x = 0; x < static_cast<unsigned int>(width); x += 2, px_dest += 2) {
-		const unsigned int srcIdx = ((p_tmap[x >> 1] << 1) | p_tmap[y >> 1]);
-		assert(srcIdx < (unsigned int)img_siz);
-		if (srcIdx >= static_cast<unsigned int>(img_siz)) {
-			// Out of bounds.
-			img->unref();
-			return nullptr;
-		}
 
-		// Palette index.
-		// Each block of 2x2 pixels uses a 4-element block of
-		// the palette, so the palette index needs to be
-		// multiplied by 4.
-		const unsigned int palIdx = img_buf[srcIdx] * 4;
-		if (smallVQ) {
-			assert(palIdx < static_cast<unsigned int>(pal_entry_count));
-			if (palIdx >= static_cast<unsigned int>(pal_entry_count)) {
-				// Palette index is out of bounds.
-				// NOTE: This can only happen with SmallVQ,
-				// since VQ always has 1024 palette entries.
-				img->unref();
-				return nullptr;
+	// Rows are processed in pairs.
+	LibRpThreads::TaskGroup group;
+	LibRpThreads::parallel_for(group, 0, (height + 1) / 2, [&](int yy) {
+		const int y = yy * 2;
+		uint32_t *px_dest = &bits[y * dest_stride];
+		for (unsigned int x = 0; x < static_cast<unsigned int>(width); x += 2, px_dest += 2) {
+			const unsigned int srcIdx = ((p_tmap[x >> 1] << 1) | p_tmap[y >> 1]);
+			assert(srcIdx < (unsigned int)img_siz);
+			if (srcIdx >= static_cast<unsigned int>(img_siz)) {
+				// Out of bounds.
+				// Cancel the remaining rows.
+				group.cancel();
+				return;
 			}
+
+			// Palette index.
+			// Each block of 2x2 pixels uses a 4-element block of
+			// the palette, so the palette index needs to be
+			// multiplied by 4.
+			const unsigned int palIdx = img_buf[srcIdx] * 4;
+			if (smallVQ) {
+				assert(palIdx < static_cast<unsigned int>(pal_entry_count));
+				if (palIdx >= static_cast<unsigned int>(pal_entry_count)) {
+					// Palette index is out of bounds.
+					// NOTE: This can only happen with SmallVQ,
+					// since VQ always has 1024 palette entries.
+					group.cancel();
+					return;
+				}
+			}
+
+			px_dest[0]		= palette[palIdx];
+			px_dest[1]		= palette[palIdx+2];
+			px_dest[dest_stride]	= palette[palIdx+1];
+			px_dest[dest_stride+1]	= palette[palIdx+3];
 		}
+	}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
-		px_dest[0]		= palette[palIdx];
-		px_dest[1]		= palette[palIdx+2];
-		px_dest[dest_stride]	= palette[palIdx+1];
-		px_dest[dest_stride+1]	= palette[palIdx+3];
-	} }
+	if (group.isCancelled()) {
+		// A decoding error occurred.
+		img->unref();
+		return nullptr;
+	}
 
 	// Image has been converted.
 	return img;
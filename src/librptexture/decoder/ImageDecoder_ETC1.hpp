@@ -14,6 +14,7 @@ namespace LibRpTexture { namespace ImageDecoder {
 
 /**
  * Convert an ETC1 image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf ETC1 image buffer.
@@ -21,9 +22,65 @@ namespace LibRpTexture { namespace ImageDecoder {
  * @return rp_image, or nullptr on error.
  */
 ATTR_ACCESS_SIZE(read_only, 3, 4)
-rp_image *fromETC1(int width, int height,
+RP_LIBROMDATA_PUBLIC
+rp_image *fromETC1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz);
 
+#ifdef IMAGEDECODER_HAS_SSE41
+/**
+ * Convert an ETC1 image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromETC1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
+/**
+ * Convert an ETC1 image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+IFUNC_STATIC_INLINE rp_image *fromETC1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#else /* !(HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64)) */
+// System does not support IFUNC, or we aren't guaranteed to have
+// optimizations for these CPUs. Use standard inline dispatch.
+
+/**
+ * Convert an ETC1 image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+static inline rp_image *fromETC1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+#  ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromETC1_sse41(width, height, img_buf, img_siz);
+	} else
+#  endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromETC1_cpp(width, height, img_buf, img_siz);
+	}
+}
+#endif /* HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64) */
+
 /**
  * Convert an ETC2 RGB image to rp_image.
  * @param width Image width.
@@ -0,0 +1,257 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture)                     *
+ * ImageDecoder_ETC1_sse41.cpp: Image decoding functions: ETC1             *
+ * SSE4.1-optimized version.                                               *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "ImageDecoder_ETC1.hpp"
+#include "ImageDecoder_p.hpp"
+
+// SSE4.1 intrinsics
+#include <smmintrin.h>
+
+// MSVC complains when the high bit is set in hex values
+// when setting SSE2 registers.
+#ifdef _MSC_VER
+#  pragma warning(push)
+#  pragma warning(disable: 4309)
+#endif
+
+// References:
+// - https://www.khronos.org/registry/OpenGL/extensions/OES/OES_compressed_ETC1_RGB8_texture.txt
+// - https://www.khronos.org/registry/DataFormat/specs/1.1/dataformat.1.1.html#ETC1
+
+namespace LibRpTexture { namespace ImageDecoder {
+
+// ETC1 block format. (individual and differential modes only)
+// NOTE: Layout maps to on-disk format, which is big-endian.
+// See ImageDecoder_ETC1.cpp for the full ETC1/ETC2 union.
+struct etc1_block {
+	uint8_t R;		// Base colors
+	uint8_t G;
+	uint8_t B;
+	uint8_t control;	// Table code words, diff bit, flip bit
+	uint16_t msb;		// Pixel index bits. (big-endian)
+	uint16_t lsb;
+};
+ASSERT_STRUCT(etc1_block, sizeof(uint64_t));
+
+/**
+ * Intensity modifier sets.
+ * Index 0 is the table codeword.
+ * Index 1 is the pixel index value.
+ *
+ * NOTE: Same order as in ImageDecoder_ETC1.cpp.
+ */
+static const int16_t etc1_intensity[8][4] = {
+	{ 2,   8,  -2,   -8},
+	{ 5,  17,  -5,  -17},
+	{ 9,  29,  -9,  -29},
+	{13,  42, -13,  -42},
+	{18,  60, -18,  -60},
+	{24,  80, -24,  -80},
+	{33, 106, -33, -106},
+	{47, 183, -47, -183},
+};
+
+// 3-bit 2's complement lookup table.
+static const int8_t etc1_3bit_diff_tbl[8] = {
+	0, 1, 2, 3, -4, -3, -2, -1
+};
+
+/**
+ * Extend a 4-bit color component to 8-bit color.
+ * @param value 4-bit color component.
+ * @return 8-bit color value.
+ */
+static inline uint8_t extend_4to8bits(uint8_t value)
+{
+	return (value << 4) | value;
+}
+
+/**
+ * Extend a 5-bit color component to 8-bit color.
+ * @param value 5-bit color component.
+ * @return 8-bit color value.
+ */
+static inline uint8_t extend_5to8bits(uint8_t value)
+{
+	return (value << 3) | (value >> 2);
+}
+
+/**
+ * Calculate a four-color subblock palette.
+ * Color components are clamped to [0,255].
+ * @param R	[in] Base color: Red
+ * @param G	[in] Base color: Green
+ * @param B	[in] Base color: Blue
+ * @param tbl	[in] Intensity modifier set
+ * @return Four ARGB32 palette entries.
+ */
+static FORCEINLINE __m128i calc_ETC1_subblock_palette_sse41(uint8_t R, uint8_t G, uint8_t B, const int16_t *tbl)
+{
+	const __m128i base = _mm_setr_epi16(B, G, R, 0xFF, B, G, R, 0xFF);
+
+	// Broadcast each intensity modifier to the B, G, and R channels.
+	// NOTE: -128 (0x80) zeroes the byte.
+	const __m128i adj = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(tbl));
+	const __m128i adj01 = _mm_shuffle_epi8(adj, _mm_setr_epi8(0,1, 0,1, 0,1, -128,-128, 2,3, 2,3, 2,3, -128,-128));
+	const __m128i adj23 = _mm_shuffle_epi8(adj, _mm_setr_epi8(4,5, 4,5, 4,5, -128,-128, 6,7, 6,7, 6,7, -128,-128));
+
+	// Unsigned saturation clamps the color components.
+	return _mm_packus_epi16(_mm_add_epi16(base, adj01), _mm_add_epi16(base, adj23));
+}
+
+/**
+ * Decode an ETC1 RGB block directly to the destination image.
+ * @param px_dest	[out] First pixel of the tile in the destination image.
+ * @param stride_px	[in] Destination stride, in pixels.
+ * @param etc1_src	[in] Source RGB block.
+ */
+static FORCEINLINE void decodeBlock_ETC1_RGB_sse41(uint32_t *RESTRICT px_dest, int stride_px,
+	const etc1_block *RESTRICT etc1_src)
+{
+	// Base colors for the two subblocks.
+	uint8_t R0, G0, B0, R1, G1, B1;
+
+	// control, bit 1: diffbit
+	if (!(etc1_src->control & 0x02)) {
+		// Individual mode.
+		R0 = extend_4to8bits(etc1_src->R >> 4);
+		G0 = extend_4to8bits(etc1_src->G >> 4);
+		B0 = extend_4to8bits(etc1_src->B >> 4);
+		R1 = extend_4to8bits(etc1_src->R & 0x0F);
+		G1 = extend_4to8bits(etc1_src->G & 0x0F);
+		B1 = extend_4to8bits(etc1_src->B & 0x0F);
+	} else {
+		// Differential mode.
+		// Differential colors are 3-bit two's complement.
+		R0 = extend_5to8bits(etc1_src->R >> 3);
+		G0 = extend_5to8bits(etc1_src->G >> 3);
+		B0 = extend_5to8bits(etc1_src->B >> 3);
+		R1 = extend_5to8bits((etc1_src->R >> 3) + etc1_3bit_diff_tbl[etc1_src->R & 0x07]);
+		G1 = extend_5to8bits((etc1_src->G >> 3) + etc1_3bit_diff_tbl[etc1_src->G & 0x07]);
+		B1 = extend_5to8bits((etc1_src->B >> 3) + etc1_3bit_diff_tbl[etc1_src->B & 0x07]);
+	}
+
+	// Subblock palettes.
+	const __m128i pal0 = calc_ETC1_subblock_palette_sse41(R0, G0, B0,
+		etc1_intensity[etc1_src->control >> 5]);
+	const __m128i pal1 = calc_ETC1_subblock_palette_sse41(R1, G1, B1,
+		etc1_intensity[(etc1_src->control >> 2) & 0x07]);
+
+	// ETC1 arranges pixels by column, then by row.
+	// Each 16-bit lane tests the index bits for one pixel in linear order.
+	const __m128i mask0 = _mm_setr_epi16(1<<0, 1<<4, 1<<8, 1<<12, 1<<1, 1<<5, 1<<9, 1<<13);
+	const __m128i mask1 = _mm_slli_epi16(mask0, 2);
+	const __m128i four = _mm_set1_epi16(4);
+	const __m128i eight = _mm_set1_epi16(8);
+
+	const __m128i msb = _mm_set1_epi16(static_cast<int16_t>(be16_to_cpu(etc1_src->msb)));
+	const __m128i lsb = _mm_set1_epi16(static_cast<int16_t>(be16_to_cpu(etc1_src->lsb)));
+
+	// Pixel index value: ((msb << 1) | lsb), times 4 for the palette byte offset.
+	const __m128i px0 = _mm_or_si128(
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(msb, mask0), mask0), eight),
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(lsb, mask0), mask0), four));
+	const __m128i px1 = _mm_or_si128(
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(msb, mask1), mask1), eight),
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(lsb, mask1), mask1), four));
+	const __m128i pal_idx = _mm_packus_epi16(px0, px1);
+
+	// Subblock selection:
+	// - flip == 0: 2x4 (left and right halves)
+	// - flip == 1: 4x2 (top and bottom halves)
+	const bool flip = (etc1_src->control & 0x01);
+	const __m128i sub_lr = _mm_setr_epi32(0, 0, -1, -1);
+
+	const __m128i row_inc = _mm_set1_epi8(4);
+	__m128i rowsel = _mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3);
+	const __m128i chan = _mm_setr_epi8(0,1,2,3, 0,1,2,3, 0,1,2,3, 0,1,2,3);
+
+	for (unsigned int row = 0; row < 4; row++, px_dest += stride_px) {
+		const __m128i ctrl = _mm_add_epi8(_mm_shuffle_epi8(pal_idx, rowsel), chan);
+		const __m128i sub = flip
+			? _mm_set1_epi32((row >= 2) ? -1 : 0)
+			: sub_lr;
+		const __m128i px = _mm_blendv_epi8(
+			_mm_shuffle_epi8(pal0, ctrl), _mm_shuffle_epi8(pal1, ctrl), sub);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(px_dest), px);
+		rowsel = _mm_add_epi8(rowsel, row_inc);
+	}
+}
+
+/**
+ * Convert an ETC1 image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromETC1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+	assert(img_siz >= (((size_t)width * (size_t)height) / 2));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < (((size_t)width * (size_t)height) / 2))
+	{
+		return nullptr;
+	}
+
+	// ETC1 uses 4x4 tiles, but some container formats allow
+	// the last tile to be cut off, so round up for the
+	// physical tile size.
+	const int physWidth = ALIGN_BYTES(4, width);
+	const int physHeight = ALIGN_BYTES(4, height);
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(physWidth, physHeight, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+
+	// Calculate the total number of tiles.
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *const bits = static_cast<uint32_t*>(img->bits());
+
+	// Tiles are decoded directly into the destination image.
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const etc1_block *etc1_src = reinterpret_cast<const etc1_block*>(img_buf) + (y * tilesX);
+		uint32_t *px_dest = bits + (y * 4 * stride_px);
+		for (int x = 0; x < tilesX; x++, etc1_src++, px_dest += 4) {
+			decodeBlock_ETC1_RGB_sse41(px_dest, stride_px, etc1_src);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
+
+	if (width < physWidth || height < physHeight) {
+		// Shrink the image.
+		img->shrink(width, height);
+	}
+
+	// Set the sBIT metadata.
+	static const rp_image::sBIT_t sBIT = {8,8,8,0,0};
+	img->set_sBIT(&sBIT);
+
+	// Image has been converted.
+	return img;
+}
+
+} }
+
+#ifdef _MSC_VER
+#  pragma warning(pop)
+#endif
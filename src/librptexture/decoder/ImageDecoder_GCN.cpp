@@ -57,27 +57,28 @@ rp_image *fromGcn16(PixelFormat px_format,
 	}
 
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(width / 4);
-	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
-
-	// Temporary tile buffer.
-	array<uint32_t, 4*4> tileBuf;
+	const int tilesX = width / 4;
+	const int tilesY = height / 4;
 
 	switch (px_format) {
 		case PixelFormat::RGB5A3: {
-			for (unsigned int y = 0; y < tilesY; y++) {
-				for (unsigned int x = 0; x < tilesX; x++) {
+			LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+				const uint16_t *pSrc = &img_buf[y * tilesX * 4*4];
+				for (int x = 0; x < tilesX; x++) {
+					// Temporary tile buffer.
+					array<uint32_t, 4*4> tileBuf;
+
 					// Convert each tile to ARGB32 manually.
 					// TODO: Optimize using pointers instead of indexes?
-					for (unsigned int i = 0; i < 4*4; i += 2, img_buf += 2) {
-						tileBuf[i+0] = RGB5A3_to_ARGB32(be16_to_cpu(img_buf[0]));
-						tileBuf[i+1] = RGB5A3_to_ARGB32(be16_to_cpu(img_buf[1]));
+					for (unsigned int i = 0; i < 4*4; i += 2, pSrc += 2) {
+						tileBuf[i+0] = RGB5A3_to_ARGB32(be16_to_cpu(pSrc[0]));
+						tileBuf[i+1] = RGB5A3_to_ARGB32(be16_to_cpu(pSrc[1]));
 					}
 
 					// Blit the tile to the main image buffer.
 					ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
 				}
-			}
+			}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 			// Set the sBIT metadata.
 			// NOTE: Pixels may be RGB555 or ARGB4444.
 			// We'll use 555 for RGB, and 4 for alpha.
@@ -88,19 +89,23 @@ rp_image *fromGcn16(PixelFormat px_format,
 		}
 
 		case PixelFormat::RGB565: {
-			for (unsigned int y = 0; y < tilesY; y++) {
-				for (unsigned int x = 0; x < tilesX; x++) {
+			LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+				const uint16_t *pSrc = &img_buf[y * tilesX * 4*4];
+				for (int x = 0; x < tilesX; x++) {
+					// Temporary tile buffer.
+					array<uint32_t, 4*4> tileBuf;
+
 					// Convert each tile to ARGB32 manually.
 					// TODO: Optimize using pointers instead of indexes?
-					for (unsigned int i = 0; i < 4*4; i += 2, img_buf += 2) {
-						tileBuf[i+0] = RGB565_to_ARGB32(be16_to_cpu(img_buf[0]));
-						tileBuf[i+1] = RGB565_to_ARGB32(be16_to_cpu(img_buf[1]));
+					for (unsigned int i = 0; i < 4*4; i += 2, pSrc += 2) {
+						tileBuf[i+0] = RGB565_to_ARGB32(be16_to_cpu(pSrc[0]));
+						tileBuf[i+1] = RGB565_to_ARGB32(be16_to_cpu(pSrc[1]));
 					}
 
 					// Blit the tile to the main image buffer.
 					ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
 				}
-			}
+			}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 			// Set the sBIT metadata.
 			static const rp_image::sBIT_t sBIT = {5,6,5,0,0};
 			img->set_sBIT(&sBIT);
@@ -108,19 +113,23 @@ rp_image *fromGcn16(PixelFormat px_format,
 		}
 
 		case PixelFormat::IA8: {
-			for (unsigned int y = 0; y < tilesY; y++) {
-				for (unsigned int x = 0; x < tilesX; x++) {
+			LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+				const uint16_t *pSrc = &img_buf[y * tilesX * 4*4];
+				for (int x = 0; x < tilesX; x++) {
+					// Temporary tile buffer.
+					array<uint32_t, 4*4> tileBuf;
+
 					// Convert each tile to ARGB32 manually.
 					// TODO: Optimize using pointers instead of indexes?
-					for (unsigned int i = 0; i < 4*4; i += 2, img_buf += 2) {
-						tileBuf[i+0] = IA8_to_ARGB32(be16_to_cpu(img_buf[0]));
-						tileBuf[i+1] = IA8_to_ARGB32(be16_to_cpu(img_buf[1]));
+					for (unsigned int i = 0; i < 4*4; i += 2, pSrc += 2) {
+						tileBuf[i+0] = IA8_to_ARGB32(be16_to_cpu(pSrc[0]));
+						tileBuf[i+1] = IA8_to_ARGB32(be16_to_cpu(pSrc[1]));
 					}
 
 					// Blit the tile to the main image buffer.
 					ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
 				}
-			}
+			}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 			// Set the sBIT metadata.
 			// NOTE: Setting the grayscale value, though we're
 			// not saving grayscale PNGs at the moment.
@@ -207,19 +216,18 @@ rp_image *fromGcnCI8(int width, int height,
 	img->set_tr_idx(tr_idx);
 
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(width / 8);
-	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
+	const int tilesX = width / 8;
+	const int tilesY = height / 4;
 
-	// Tile pointer.
-	const array<uint8_t, 8*4> *pTileBuf = reinterpret_cast<const array<uint8_t, 8*4>*>(img_buf);
-
-	for (unsigned int y = 0; y < tilesY; y++) {
-		for (unsigned int x = 0; x < tilesX; x++) {
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		// Tile pointer.
+		const array<uint8_t, 8*4> *pTileBuf = reinterpret_cast<const array<uint8_t, 8*4>*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x++) {
 			// Decode the current tile.
 			ImageDecoderPrivate::BlitTile<uint8_t, 8, 4>(img, *pTileBuf, x, y);
 			pTileBuf++;
 		}
-	}
+	}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	// Set the sBIT metadata.
 	// NOTE: Pixels may be RGB555 or ARGB4444.
@@ -264,8 +272,8 @@ rp_image *fromGcnI8(int width, int height,
 		return nullptr;
 
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = (unsigned int)(width / 8);
-	const unsigned int tilesY = (unsigned int)(height / 4);
+	const int tilesX = width / 8;
+	const int tilesY = height / 4;
 
 	// Create an rp_image.
 	rp_image *const img = new rp_image(width, height, rp_image::Format::CI8);
@@ -287,16 +295,15 @@ rp_image *fromGcnI8(int width, int height,
 	// No transparency here.
 	img->set_tr_idx(-1);
 
-	// Tile pointer.
-	const array<uint8_t, 8*4> *pTileBuf = reinterpret_cast<const array<uint8_t, 8*4>*>(img_buf);
-
-	for (unsigned int y = 0; y < tilesY; y++) {
-		for (unsigned int x = 0; x < tilesX; x++) {
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		// Tile pointer.
+		const array<uint8_t, 8*4> *pTileBuf = reinterpret_cast<const array<uint8_t, 8*4>*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x++) {
 			// Decode the current tile.
 			ImageDecoderPrivate::BlitTile<uint8_t, 8, 4>(img, *pTileBuf, x, y);
 			pTileBuf++;
 		}
-	}
+	}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	// Set the sBIT metadata.
 	// TODO: Use grayscale instead of RGB.
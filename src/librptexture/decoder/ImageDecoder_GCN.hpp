@@ -21,6 +21,7 @@ namespace LibRpTexture { namespace ImageDecoder {
  * @param img_siz Size of image data. [must be >= (w*h)*2]
  * @return rp_image, or nullptr on error.
  */
+RP_LIBROMDATA_PUBLIC
 rp_image *fromGcn16(PixelFormat px_format,
 	int width, int height,
 	const uint16_t *RESTRICT img_buf, size_t img_siz);
@@ -35,6 +36,7 @@ rp_image *fromGcn16(PixelFormat px_format,
  * @param pal_siz Size of palette data. [must be >= 256*2]
  * @return rp_image, or nullptr on error.
  */
+RP_LIBROMDATA_PUBLIC
 rp_image *fromGcnCI8(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz,
 	const uint16_t *RESTRICT pal_buf, size_t pal_siz);
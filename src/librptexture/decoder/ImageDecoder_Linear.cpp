@@ -9,6 +9,7 @@
 
 #include "stdafx.h"
 #include "ImageDecoder_Linear.hpp"
+#include "ImageDecoder_p.hpp"
 
 // librptexture
 #include "ImageSizeCalc.hpp"
@@ -1321,8 +1322,7 @@ rp_image *fromLinear32_cpp(PixelFormat px_format,
 				? (stride / bytespp)
 				: width;
 			const int dest_row_width = img->stride() / bytespp;
-#pragma omp parallel for
-			for (int y = 0; y < height; y++) {
+			LibRpThreads::parallel_for(0, height, [&](int y) {
 				const uint32_t *px_src = &img_buf[y * src_row_width];
 				uint32_t *px_dest = &bits[y * dest_row_width];
 				for (unsigned int x = (unsigned int)width; x > 0; x--) {
@@ -1330,7 +1330,7 @@ rp_image *fromLinear32_cpp(PixelFormat px_format,
 					px_src++;
 					px_dest++;
 				}
-			}
+			}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 			/* Set the sBIT data. */
 			static const rp_image::sBIT_t sBIT = {8,8,8,0,0};
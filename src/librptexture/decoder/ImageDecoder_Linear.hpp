@@ -115,9 +115,28 @@ rp_image *fromLinear16_sse2(PixelFormat px_format,
 	const uint16_t *RESTRICT img_buf, size_t img_siz, int stride = 0);
 #endif /* IMAGEDECODER_HAS_SSE2 */
 
+#ifdef IMAGEDECODER_HAS_AVX2
+/**
+ * Convert a linear 16-bit RGB image to rp_image.
+ * AVX2-optimized version.
+ * @param px_format	[in] 16-bit pixel format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] 16-bit image buffer.
+ * @param img_siz	[in] Size of image data. [must be >= (w*h)*2]
+ * @param stride	[in,opt] Stride, in bytes. If 0, assumes width*bytespp.
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 4, 5)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromLinear16_avx2(PixelFormat px_format,
+	int width, int height,
+	const uint16_t *RESTRICT img_buf, size_t img_siz, int stride = 0);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
 #if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
 
-#  ifdef IMAGEDECODER_ALWAYS_HAS_SSE2
+#  if defined(IMAGEDECODER_ALWAYS_HAS_SSE2) && !defined(IMAGEDECODER_HAS_AVX2)
 // System does support IFUNC, but it's always guaranteed to have SSE2.
 // Eliminate the IFUNC dispatch on this system.
 
@@ -139,8 +158,9 @@ static inline rp_image *fromLinear16(PixelFormat px_format,
 	// amd64 always has SSE2.
 	return fromLinear16_sse2(px_format, width, height, img_buf, img_siz, stride);
 }
-#  else /* !IMAGEDECODER_ALWAYS_HAS_SSE2 */
-// System supports IFUNC and is not guaranteed to always have SSE2.
+#  else /* !IMAGEDECODER_ALWAYS_HAS_SSE2 || IMAGEDECODER_HAS_AVX2 */
+// System supports IFUNC and is not guaranteed to always have
+// the best available optimizations. (SSE2 on i386; AVX2)
 
 /**
  * Convert a linear 16-bit RGB image to rp_image.
@@ -154,10 +174,10 @@ static inline rp_image *fromLinear16(PixelFormat px_format,
  */
 ATTR_ACCESS_SIZE(read_only, 4, 5)
 RP_LIBROMDATA_PUBLIC
-IFUNC_SSE2_STATIC_INLINE rp_image *fromLinear16(PixelFormat px_format,
+IFUNC_STATIC_INLINE rp_image *fromLinear16(PixelFormat px_format,
 	int width, int height,
 	const uint16_t *RESTRICT img_buf, size_t img_siz, int stride = 0);
-#  endif /* IMAGEDECODER_ALWAYS_HAS_SSE2 */
+#  endif /* IMAGEDECODER_ALWAYS_HAS_SSE2 && !IMAGEDECODER_HAS_AVX2 */
 
 #else /* !HAVE_IFUNC or not i386/amd64 */
 // System does not support IFUNC, or we aren't guaranteed to have
@@ -178,6 +198,11 @@ static inline rp_image *fromLinear16(PixelFormat px_format,
 	int width, int height,
 	const uint16_t *RESTRICT img_buf, size_t img_siz, int stride = 0)
 {
+#  ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromLinear16_avx2(px_format, width, height, img_buf, img_siz, stride);
+	}
+#  endif /* IMAGEDECODER_HAS_AVX2 */
 #  ifdef IMAGEDECODER_ALWAYS_HAS_SSE2
 	// amd64 always has SSE2.
 	return fromLinear16_sse2(px_format, width, height, img_buf, img_siz, stride);
@@ -233,6 +258,25 @@ rp_image *fromLinear24_ssse3(PixelFormat px_format,
 	const uint8_t *RESTRICT img_buf, size_t img_siz, int stride = 0);
 #endif /* IMAGEDECODER_HAS_SSSE3 */
 
+#ifdef IMAGEDECODER_HAS_AVX2
+/**
+ * Convert a linear 24-bit RGB image to rp_image.
+ * AVX2-optimized version.
+ * @param px_format	[in] 24-bit pixel format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] Image buffer. (must be byte-addressable)
+ * @param img_siz	[in] Size of image data. [must be >= (w*h)*3]
+ * @param stride	[in,opt] Stride, in bytes. If 0, assumes width*bytespp.
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 4, 5)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromLinear24_avx2(PixelFormat px_format,
+	int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz, int stride = 0);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
 #if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
 /**
  * Convert a linear 24-bit RGB image to rp_image.
@@ -268,6 +312,11 @@ static inline rp_image *fromLinear24(PixelFormat px_format,
 	int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz, int stride = 0)
 {
+#  ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromLinear24_avx2(px_format, width, height, img_buf, img_siz, stride);
+	} else
+#  endif /* IMAGEDECODER_HAS_AVX2 */
 #  ifdef IMAGEDECODER_HAS_SSSE3
 	if (RP_CPU_HasSSSE3()) {
 		return fromLinear24_ssse3(px_format, width, height, img_buf, img_siz, stride);
@@ -317,6 +366,25 @@ rp_image *fromLinear32_ssse3(PixelFormat px_format,
 	const uint32_t *RESTRICT img_buf, size_t img_siz, int stride = 0);
 #endif /* IMAGEDECODER_HAS_SSSE3 */
 
+#ifdef IMAGEDECODER_HAS_AVX2
+/**
+ * Convert a linear 32-bit RGB image to rp_image.
+ * AVX2-optimized version.
+ * @param px_format	[in] 32-bit pixel format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] 32-bit image buffer.
+ * @param img_siz	[in] Size of image data. [must be >= (w*h)*2]
+ * @param stride	[in,opt] Stride, in bytes. If 0, assumes width*bytespp.
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 4, 5)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromLinear32_avx2(PixelFormat px_format,
+	int width, int height,
+	const uint32_t *RESTRICT img_buf, size_t img_siz, int stride = 0);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
 #if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
 /**
  * Convert a linear 32-bit RGB image to rp_image.
@@ -350,6 +418,11 @@ static inline rp_image *fromLinear32(PixelFormat px_format,
 	int width, int height,
 	const uint32_t *RESTRICT img_buf, size_t img_siz, int stride = 0)
 {
+#  ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromLinear32_avx2(px_format, width, height, img_buf, img_siz, stride);
+	} else
+#  endif /* IMAGEDECODER_HAS_AVX2 */
 #  ifdef IMAGEDECODER_HAS_SSSE3
 	if (RP_CPU_HasSSSE3()) {
 		return fromLinear32_ssse3(px_format, width, height, img_buf, img_siz, stride);
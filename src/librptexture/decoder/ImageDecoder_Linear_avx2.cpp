@@ -0,0 +1,1013 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture)                     *
+ * ImageDecoder_Linear.cpp: Image decoding functions: Linear               *
+ * AVX2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "ImageDecoder_Linear.hpp"
+
+// librptexture
+#include "ImageSizeCalc.hpp"
+#include "img/rp_image.hpp"
+#include "PixelConversion.hpp"
+using namespace LibRpTexture::PixelConversion;
+
+// AVX2 intrinsics
+#include <immintrin.h>
+
+// MSVC complains when the high bit is set in hex values
+// when setting SSE2 registers.
+#ifdef _MSC_VER
+#  pragma warning(push)
+#  pragma warning(disable: 4309)
+#endif
+
+// MSVC 2013+: Use __vectorcall for the templated functions.
+// Other i386: Pass __m256i by const ref.
+// Other AMD64: Pass __m256i by value.
+// (See ImageDecoder_Linear_sse2.cpp for more information.)
+#if defined(_MSC_VER) && _MSC_VER >= 1800
+#  define VECTORCALL __vectorcall
+#  define __M256I_ARG 	__m256i
+#else
+#  define VECTORCALL
+#  if defined(_M_X64) || defined(_M_AMD64) || defined(__amd64__) || defined(__x86_64__)
+#    define __M256I_ARG 	__m256i
+#  else
+#    define __M256I_ARG 	const __m256i&
+#  endif
+#endif
+
+// NOTE: rp_image only guarantees 16-byte alignment, so unaligned
+// loads and stores are used for the 256-bit registers.
+// These are just as fast as aligned loads and stores on AVX2 CPUs
+// if the data happens to be aligned.
+
+namespace LibRpTexture { namespace ImageDecoder {
+
+/**
+ * Unpack 16-bit GB and AR words into ARGB32 DWORDs and store them.
+ * AVX2's unpack instructions operate within 128-bit lanes,
+ * so the lanes have to be recombined afterwards.
+ * @param sGB		[in] GB words. (16 pixels)
+ * @param sAR		[in] AR words. (16 pixels)
+ * @param px_dest	[out] Destination image buffer. (16 pixels)
+ */
+static FORCEINLINE void VECTORCALL T_store_unpack16_avx2(__M256I_ARG sGB, __M256I_ARG sAR, uint32_t *RESTRICT px_dest)
+{
+	// lo: pixels 0-3, 8-11
+	// hi: pixels 4-7, 12-15
+	const __m256i lo = _mm256_unpacklo_epi16(sGB, sAR);
+	const __m256i hi = _mm256_unpackhi_epi16(sGB, sAR);
+
+	__m256i *ymm_dest = reinterpret_cast<__m256i*>(px_dest);
+	_mm256_storeu_si256(&ymm_dest[0], _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256(&ymm_dest[1], _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+/**
+ * Templated function for 15/16-bit RGB conversion using AVX2. (no alpha channel)
+ * Processes 16 pixels per iteration.
+ * Use this in the inner loop of the main code.
+ *
+ * @tparam Rshift_W	[in] Red shift amount in the high word.
+ * @tparam Gshift_W	[in] Green shift amount in the low word.
+ * @tparam Bshift_W	[in] Blue shift amount in the low word.
+ * @tparam Rbits	[in] Red bit count.
+ * @tparam Gbits	[in] Green bit count.
+ * @tparam Bbits	[in] Blue bit count.
+ * @tparam isBGR	[in] If true, this is BGR instead of RGB.
+ * @param Rmask		[in] AVX2 mask for the Red channel.
+ * @param Gmask		[in] AVX2 mask for the Green channel.
+ * @param Bmask		[in] AVX2 mask for the Blue channel.
+ * @param img_buf	[in] 16-bit image buffer.
+ * @param px_dest	[out] Destination image buffer.
+ */
+template<uint8_t Rshift_W, uint8_t Gshift_W, uint8_t Bshift_W,
+	uint8_t Rbits, uint8_t Gbits, uint8_t Bbits, bool isBGR>
+static inline void VECTORCALL T_RGB16_avx2(
+	__M256I_ARG Rmask, __M256I_ARG Gmask, __M256I_ARG Bmask,
+	const uint16_t *RESTRICT img_buf, uint32_t *RESTRICT px_dest)
+{
+	// Alpha mask. (high word of each DWORD)
+	const __m256i Mask16_A  = _mm256_set1_epi16(0xFF00);
+	// Mask for the high byte for Green.
+	const __m256i MaskG_Hi8 = _mm256_set1_epi16(0xFF00);
+
+	const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(img_buf));
+
+	// Mask the G and B components and shift them into place.
+	__m256i sG = _mm256_slli_epi16(_mm256_and_si256(Gmask, src), Gshift_W);
+	__m256i sB = (isBGR)
+		? _mm256_srli_epi16(_mm256_and_si256(Bmask, src), Bshift_W)
+		: _mm256_slli_epi16(_mm256_and_si256(Bmask, src), Bshift_W);
+	sG = _mm256_or_si256(sG, _mm256_srli_epi16(sG, Gbits));
+	sB = _mm256_or_si256(sB, _mm256_srli_epi16(sB, Bbits));
+
+	// Combine G and B.
+	if (Gbits > 4) {
+		// NOTE: G low byte has to be masked due to the shift.
+		sB = _mm256_or_si256(sB, _mm256_and_si256(sG, MaskG_Hi8));
+	} else {
+		// Not enough Gbits to need masking.
+		// FIXME: If less than 4, need to shift multiple times.
+		sB = _mm256_or_si256(sB, sG);
+	}
+
+	// Mask the R component and shift it into place.
+	__m256i sR = (isBGR)
+		? _mm256_slli_epi16(_mm256_and_si256(Rmask, src), Rshift_W)
+		: _mm256_srli_epi16(_mm256_and_si256(Rmask, src), Rshift_W);
+	sR = _mm256_or_si256(sR, _mm256_srli_epi16(sR, Rbits));
+
+	// Apply the alpha channel to the R word.
+	sR = _mm256_or_si256(sR, Mask16_A);
+
+	// Unpack R and GB into DWORDs.
+	T_store_unpack16_avx2(sB, sR, px_dest);
+}
+
+/**
+ * Templated function for 15/16-bit RGB conversion using AVX2. (with alpha channel)
+ * Processes 16 pixels per iteration.
+ * Use this in the inner loop of the main code.
+ *
+ * @tparam Ashift_W	[in] Alpha shift amount in the high word. (16 for 1555 alpha handling; 17 for 5551 alpha handling)
+ * @tparam Rshift_W	[in] Red shift amount in the high word.
+ * @tparam Gshift_W	[in] Green shift amount in the low word.
+ * @tparam Bshift_W	[in] Blue shift amount in the low word.
+ * @tparam Abits	[in] Alpha bit count.
+ * @tparam Rbits	[in] Red bit count.
+ * @tparam Gbits	[in] Green bit count.
+ * @tparam Bbits	[in] Blue bit count.
+ * @tparam isBGR	[in] If true, this is BGR instead of RGB.
+ * @param Amask		[in] AVX2 mask for the Alpha channel.
+ * @param Rmask		[in] AVX2 mask for the Red channel.
+ * @param Gmask		[in] AVX2 mask for the Green channel.
+ * @param Bmask		[in] AVX2 mask for the Blue channel.
+ * @param img_buf	[in] 16-bit image buffer.
+ * @param px_dest	[out] Destination image buffer.
+ */
+template<uint8_t Ashift_W, uint8_t Rshift_W, uint8_t Gshift_W, uint8_t Bshift_W,
+	uint8_t Abits, uint8_t Rbits, uint8_t Gbits, uint8_t Bbits, bool isBGR>
+static inline void VECTORCALL T_ARGB16_avx2(
+	__M256I_ARG Amask, __M256I_ARG Rmask, __M256I_ARG Gmask, __M256I_ARG Bmask,
+	const uint16_t *RESTRICT img_buf, uint32_t *RESTRICT px_dest)
+{
+	static_assert(Ashift_W <= 17, "Ashift_W is invalid.");
+	static_assert(Rshift_W < 16, "Rshift_W is invalid.");
+	static_assert(Gshift_W < 16, "Gshift_W is invalid.");
+	static_assert(Bshift_W < 16, "Bshift_W is invalid.");
+	static_assert(Abits < 16, "Abits is invalid.");
+	static_assert(Rbits < 16, "Rbits is invalid.");
+	static_assert(Gbits < 16, "Gbits is invalid.");
+	static_assert(Bbits < 16, "Bbits is invalid.");
+	static_assert(Abits + Rbits + Gbits + Bbits <= 16, "Total number of bits is invalid.");
+
+	// Mask for the high byte for Green and Alpha.
+	const __m256i MaskAG_Hi8 = _mm256_set1_epi16(0xFF00);
+
+	const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(img_buf));
+
+	// Mask the G and B components and shift them into place.
+	__m256i sG = _mm256_slli_epi16(_mm256_and_si256(Gmask, src), Gshift_W);
+	__m256i sB = (isBGR)
+		? _mm256_srli_epi16(_mm256_and_si256(Bmask, src), Bshift_W)
+		: _mm256_slli_epi16(_mm256_and_si256(Bmask, src), Bshift_W);
+	sG = _mm256_or_si256(sG, _mm256_srli_epi16(sG, Gbits));
+	sB = _mm256_or_si256(sB, _mm256_srli_epi16(sB, Bbits));
+
+	// Combine G and B.
+	if (Gbits > 4) {
+		// NOTE: G low byte has to be masked due to the shift.
+		sB = _mm256_or_si256(sB, _mm256_and_si256(sG, MaskAG_Hi8));
+	} else {
+		// Not enough Gbits to need masking.
+		// FIXME: If less than 4, need to shift multiple times.
+		sB = _mm256_or_si256(sB, sG);
+	}
+
+	// Mask the R component and shift it into place.
+	__m256i sR = (isBGR)
+		? _mm256_slli_epi16(_mm256_and_si256(Rmask, src), Rshift_W)
+		: _mm256_srli_epi16(_mm256_and_si256(Rmask, src), Rshift_W);
+	sR = _mm256_or_si256(sR, _mm256_srli_epi16(sR, Rbits));
+
+	// Mask the A components, shift it into place, and combine with R.
+	__m256i sA;
+	if (Ashift_W == 16) {
+		// 1555 alpha handling.
+		// Using a bytewise comparison so we don't have to mask off the low byte.
+		// NOTE: AVX2 doesn't have vpcmpltb, so the operands are swapped.
+		// This comparison is *signed*. Amask must be 0x0080, and we're
+		// checking for Amask > src, which will match:
+		// - < 0x00: 0x80-0xFF
+		// - < 0x80: Nothing
+		sA = _mm256_cmpgt_epi8(Amask, src);
+		// Combine A and R.
+		sR = _mm256_or_si256(sR, sA);
+	} else if (Ashift_W == 17) {
+		// 5551 alpha handling.
+		// Amask has only bit 0 set for each word.
+		// This will mask off bit 0, then compare it to the Amask value.
+		// Any that have bit 0 set will be set to 0x00FF; otherwise, 0x0000.
+		// This can then be shifted into place.
+		sA = _mm256_slli_epi16(_mm256_cmpeq_epi8(_mm256_and_si256(src, Amask), Amask), 8);
+		// Combine A and R.
+		sR = _mm256_or_si256(sR, sA);
+	} else {
+		// Standard alpha handling.
+		sA = _mm256_slli_epi16(_mm256_and_si256(Amask, src), Ashift_W);
+		sA = _mm256_or_si256(sA, _mm256_srli_epi16(sA, Abits));
+		// Combine A and R.
+		if (Abits > 4) {
+			// NOTE: A low byte has to be masked due to the shift.
+			sR = _mm256_or_si256(sR, _mm256_and_si256(sA, MaskAG_Hi8));
+		} else {
+			// Not enough Abits to need masking.
+			// FIXME: If less than 4, need to shift multiple times.
+			sR = _mm256_or_si256(sR, sA);
+		}
+	}
+
+	// Unpack AR and GB into DWORDs.
+	T_store_unpack16_avx2(sB, sR, px_dest);
+}
+
+/**
+ * Convert a linear 16-bit RGB image to rp_image.
+ * AVX2-optimized version.
+ * @param px_format	[in] 16-bit pixel format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] 16-bit image buffer.
+ * @param img_siz	[in] Size of image data. [must be >= (w*h)*3]
+ * @param stride	[in,opt] Stride, in bytes. If 0, assumes width*bytespp.
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromLinear16_avx2(PixelFormat px_format,
+	int width, int height,
+	const uint16_t *RESTRICT img_buf, size_t img_siz, int stride)
+{
+	ASSERT_ALIGNMENT(16, img_buf);
+	static const int bytespp = 2;
+
+	// FIXME: Add support for these formats.
+	// For now, redirect back to the C++ version.
+	switch (px_format) {
+		case PixelFormat::ARGB8332:
+		case PixelFormat::RGB5A3:
+		case PixelFormat::IA8:
+		case PixelFormat::BGR555_PS1:
+		case PixelFormat::BGR5A3:
+		case PixelFormat::L16:
+		case PixelFormat::A8L8:
+		case PixelFormat::L8A8:
+			return fromLinear16_cpp(px_format, width, height, img_buf, img_siz, stride);
+
+		default:
+			break;
+	}
+
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+	assert(img_siz >= (((size_t)width * (size_t)height) * bytespp));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < (((size_t)width * (size_t)height) * bytespp))
+	{
+		return nullptr;
+	}
+
+	// Stride adjustment.
+	int src_stride_adj = 0;
+	assert(stride >= 0);
+	if (stride > 0) {
+		// Set src_stride_adj to the number of pixels we need to
+		// add to the end of each line to get to the next row.
+		assert(stride % bytespp == 0);
+		assert(stride >= (width * bytespp));
+		if (unlikely(stride % bytespp != 0 || stride < (width * bytespp))) {
+			// Invalid stride.
+			return nullptr;
+		}
+		src_stride_adj = (stride / bytespp) - width;
+	}
+
+	// If width + src_stride_adj is not a multiple of 8 pixels,
+	// fall back to the C++ version.
+	if ((width + src_stride_adj) % 8 != 0) {
+		// Fall back to the C++ version.
+		return fromLinear16_cpp(px_format, width, height, img_buf, img_siz, stride);
+	}
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(width, height, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+
+	const int dest_stride_adj = (img->stride() / sizeof(uint32_t)) - img->width();
+	uint32_t *px_dest = static_cast<uint32_t*>(img->bits());
+
+	// TODO: Only initialize what's required for the current pixel format?
+
+	// AND masks for 565 channels.
+	const __m256i Mask565_Hi5  = _mm256_set1_epi16(0xF800);
+	const __m256i Mask565_Mid6 = _mm256_set1_epi16(0x07E0);
+	const __m256i Mask565_Lo5  = _mm256_set1_epi16(0x001F);
+
+	// AND masks for 555 channels.
+	const __m256i Mask555_Hi5  = _mm256_set1_epi16(0x7C00);
+	const __m256i Mask555_Mid5 = _mm256_set1_epi16(0x03E0);
+	const __m256i Mask555_Lo5  = _mm256_set1_epi16(0x001F);
+
+	// AND masks for 4444 channels.
+	const __m256i Mask4444_Nyb3 = _mm256_set1_epi16(0xF000);
+	const __m256i Mask4444_Nyb2 = _mm256_set1_epi16(0x0F00);
+	const __m256i Mask4444_Nyb1 = _mm256_set1_epi16(0x00F0);
+	const __m256i Mask4444_Nyb0 = _mm256_set1_epi16(0x000F);
+
+	// AND masks for 1555 channels.
+	const __m256i Cmp1555_A     = _mm256_set1_epi16(0x0080);
+	const __m256i Mask1555_Hi5  = _mm256_set1_epi16(0x7C00);
+	const __m256i Mask1555_Mid5 = _mm256_set1_epi16(0x03E0);
+	const __m256i Mask1555_Lo5  = _mm256_set1_epi16(0x001F);
+
+	// AND masks for 5551 channels.
+	const __m256i Cmp5551_A     = _mm256_set1_epi16(0x0101);
+	const __m256i Mask5551_Hi5  = _mm256_set1_epi16(0xF800);
+	const __m256i Mask5551_Mid5 = _mm256_set1_epi16(0x07C0);
+	const __m256i Mask5551_Lo5  = _mm256_set1_epi16(0x003E);
+
+	// Alpha mask.
+	const __m256i Mask32_A  = _mm256_set1_epi32(0xFF000000);
+
+	// GR88 mask.
+	const __m256i MaskGR88  = _mm256_set1_epi32(0x00FFFF00);
+
+	// sBIT metadata.
+	static const rp_image::sBIT_t sBIT_RGB565   = {5,6,5,0,0};
+	static const rp_image::sBIT_t sBIT_ARGB1555 = {5,5,5,0,1};
+	static const rp_image::sBIT_t sBIT_xRGB4444 = {4,4,4,0,0};
+	static const rp_image::sBIT_t sBIT_ARGB4444 = {4,4,4,0,4};
+	static const rp_image::sBIT_t sBIT_RGB555   = {5,5,5,0,0};
+
+	// Macro for 16-bit formats with no alpha channel.
+#define fromLinear16_convert(fmt, sBIT, Rshift_W, Gshift_W, Bshift_W, Rbits, Gbits, Bbits, isBGR, Rmask, Gmask, Bmask) \
+		case PixelFormat::fmt: { \
+			for (unsigned int y = (unsigned int)height; y > 0; y--) { \
+				/* Process 16 pixels per iteration using AVX2. */ \
+				unsigned int x = (unsigned int)width; \
+				for (; x > 15; x -= 16, px_dest += 16, img_buf += 16) { \
+					T_RGB16_avx2<Rshift_W, Gshift_W, Bshift_W, Rbits, Gbits, Bbits, isBGR>( \
+						Rmask, Gmask, Bmask, img_buf, px_dest); \
+				} \
+				\
+				/* Remaining pixels. */ \
+				for (; x > 0; x--) { \
+					*px_dest = fmt##_to_ARGB32(*img_buf); \
+					img_buf++; \
+					px_dest++; \
+				} \
+				\
+				/* Next line. */ \
+				img_buf += src_stride_adj; \
+				px_dest += dest_stride_adj; \
+			} \
+			/* Set the sBIT metadata. */ \
+			img->set_sBIT(&sBIT); \
+		} break
+
+	// Macro for 16-bit formats with an alpha channel.
+#define fromLinear16A_convert(fmt, sBIT, Ashift_W, Rshift_W, Gshift_W, Bshift_W, Abits, Rbits, Gbits, Bbits, isBGR, Amask, Rmask, Gmask, Bmask) \
+		case PixelFormat::fmt: { \
+			for (unsigned int y = (unsigned int)height; y > 0; y--) { \
+				/* Process 16 pixels per iteration using AVX2. */ \
+				unsigned int x = (unsigned int)width; \
+				for (; x > 15; x -= 16, px_dest += 16, img_buf += 16) { \
+					T_ARGB16_avx2<Ashift_W, Rshift_W, Gshift_W, Bshift_W, Abits, Rbits, Gbits, Bbits, isBGR>( \
+						Amask, Rmask, Gmask, Bmask, img_buf, px_dest); \
+				} \
+				\
+				/* Remaining pixels. */ \
+				for (; x > 0; x--) { \
+					*px_dest = fmt##_to_ARGB32(*img_buf); \
+					img_buf++; \
+					px_dest++; \
+				} \
+				\
+				/* Next line. */ \
+				img_buf += src_stride_adj; \
+				px_dest += dest_stride_adj; \
+			} \
+			/* Set the sBIT metadata. */ \
+			img->set_sBIT(&sBIT); \
+		} break
+
+	switch (px_format) {
+		/** RGB565 **/
+		fromLinear16_convert(RGB565, sBIT_RGB565, 8, 5, 3, 5, 6, 5, false, Mask565_Hi5, Mask565_Mid6, Mask565_Lo5);
+		fromLinear16_convert(BGR565, sBIT_RGB565, 3, 5, 8, 5, 6, 5, true,  Mask565_Lo5, Mask565_Mid6, Mask565_Hi5);
+
+		/** ARGB1555 **/
+		fromLinear16A_convert(ARGB1555, sBIT_ARGB1555, 16, 7, 6, 3, 1, 5, 5, 5, false, Cmp1555_A, Mask1555_Hi5, Mask1555_Mid5, Mask1555_Lo5);
+		fromLinear16A_convert(ABGR1555, sBIT_ARGB1555, 16, 3, 6, 7, 1, 5, 5, 5, true,  Cmp1555_A, Mask1555_Lo5, Mask1555_Mid5, Mask1555_Hi5);
+		fromLinear16A_convert(RGBA5551, sBIT_ARGB1555, 17, 8, 5, 2, 1, 5, 5, 5, false, Cmp5551_A, Mask5551_Hi5, Mask5551_Mid5, Mask5551_Lo5);
+		fromLinear16A_convert(BGRA5551, sBIT_ARGB1555, 17, 2, 5, 8, 1, 5, 5, 5, true,  Cmp5551_A, Mask5551_Lo5, Mask5551_Mid5, Mask5551_Hi5);
+
+		/** ARGB4444 **/
+		fromLinear16A_convert(ARGB4444, sBIT_ARGB4444,  0, 4, 8, 4, 4, 4, 4, 4, false, Mask4444_Nyb3, Mask4444_Nyb2, Mask4444_Nyb1, Mask4444_Nyb0);
+		fromLinear16A_convert(ABGR4444, sBIT_ARGB4444,  0, 4, 8, 4, 4, 4, 4, 4, true,  Mask4444_Nyb3, Mask4444_Nyb0, Mask4444_Nyb1, Mask4444_Nyb2);
+		fromLinear16A_convert(RGBA4444, sBIT_ARGB4444, 12, 8, 4, 0, 4, 4, 4, 4, false, Mask4444_Nyb0, Mask4444_Nyb3, Mask4444_Nyb2, Mask4444_Nyb1);
+		fromLinear16A_convert(BGRA4444, sBIT_ARGB4444, 12, 0, 4, 8, 4, 4, 4, 4, true,  Mask4444_Nyb0, Mask4444_Nyb1, Mask4444_Nyb2, Mask4444_Nyb3);
+
+		/** xRGB4444 **/
+		fromLinear16_convert(xRGB4444, sBIT_xRGB4444, 4, 8, 4, 4, 4, 4, false, Mask4444_Nyb2, Mask4444_Nyb1, Mask4444_Nyb0);
+		fromLinear16_convert(xBGR4444, sBIT_xRGB4444, 4, 8, 4, 4, 4, 4, true,  Mask4444_Nyb0, Mask4444_Nyb1, Mask4444_Nyb2);
+		fromLinear16_convert(RGBx4444, sBIT_xRGB4444, 8, 4, 0, 4, 4, 4, false, Mask4444_Nyb3, Mask4444_Nyb2, Mask4444_Nyb1);
+		fromLinear16_convert(BGRx4444, sBIT_xRGB4444, 0, 4, 8, 4, 4, 4, true,  Mask4444_Nyb1, Mask4444_Nyb2, Mask4444_Nyb3);
+
+		/** RGB555 **/
+		fromLinear16_convert(RGB555, sBIT_RGB555, 7, 6, 3, 5, 5, 5, false, Mask555_Hi5, Mask555_Mid5, Mask555_Lo5);
+		fromLinear16_convert(BGR555, sBIT_RGB555, 3, 6, 7, 5, 5, 5, true,  Mask555_Lo5, Mask555_Mid5, Mask555_Hi5);
+
+		/** RG88 **/
+		case PixelFormat::RG88: {
+			// Components are already 8-bit, so we need to
+			// expand them to DWORD and add the alpha channel.
+			for (unsigned int y = static_cast<unsigned int>(height); y > 0; y--) {
+				// Process 16 pixels per iteration using AVX2.
+				unsigned int x = static_cast<unsigned int>(width);
+				for (; x > 15; x -= 16, px_dest += 16, img_buf += 16) {
+					const __m128i *xmm_src = reinterpret_cast<const __m128i*>(img_buf);
+					__m256i *ymm_dest = reinterpret_cast<__m256i*>(px_dest);
+
+					// Registers now contain: [00 00 RR GG]
+					__m256i px0 = _mm256_cvtepu16_epi32(_mm_loadu_si128(&xmm_src[0]));
+					__m256i px1 = _mm256_cvtepu16_epi32(_mm_loadu_si128(&xmm_src[1]));
+
+					// Shift to [00 RR GG 00].
+					px0 = _mm256_slli_epi32(px0, 8);
+					px1 = _mm256_slli_epi32(px1, 8);
+
+					// Apply the alpha channel.
+					px0 = _mm256_or_si256(px0, Mask32_A);
+					px1 = _mm256_or_si256(px1, Mask32_A);
+
+					// Write the pixels to the destination image buffer.
+					_mm256_storeu_si256(&ymm_dest[0], px0);
+					_mm256_storeu_si256(&ymm_dest[1], px1);
+				}
+
+				// Remaining pixels.
+				for (; x > 0; x--) {
+					*px_dest = RG88_to_ARGB32(*img_buf);
+					img_buf++;
+					px_dest++;
+				}
+
+				// Next line.
+				img_buf += src_stride_adj;
+				px_dest += dest_stride_adj;
+			}
+
+			// Set the sBIT metadata.
+			static const rp_image::sBIT_t sBIT_RG88 = {8,8,1,0,0};
+			img->set_sBIT(&sBIT_RG88);
+			break;
+		}
+
+		/** GR88 **/
+		case PixelFormat::GR88: {
+			// Components are already 8-bit, so we need to
+			// expand them to DWORD and add the alpha channel.
+			for (unsigned int y = static_cast<unsigned int>(height); y > 0; y--) {
+				// Process 16 pixels per iteration using AVX2.
+				unsigned int x = static_cast<unsigned int>(width);
+				for (; x > 15; x -= 16, px_dest += 16, img_buf += 16) {
+					const __m128i *xmm_src = reinterpret_cast<const __m128i*>(img_buf);
+					__m256i *ymm_dest = reinterpret_cast<__m256i*>(px_dest);
+
+					// Registers now contain: [00 00 GG RR]
+					__m256i px0 = _mm256_cvtepu16_epi32(_mm_loadu_si128(&xmm_src[0]));
+					__m256i px1 = _mm256_cvtepu16_epi32(_mm_loadu_si128(&xmm_src[1]));
+
+					// Duplicate the words: [GG RR GG RR]
+					px0 = _mm256_or_si256(px0, _mm256_slli_epi32(px0, 16));
+					px1 = _mm256_or_si256(px1, _mm256_slli_epi32(px1, 16));
+
+					// Mask off the low and high bytes.
+					// Registers now contain: [00 RR GG 00]
+					px0 = _mm256_and_si256(px0, MaskGR88);
+					px1 = _mm256_and_si256(px1, MaskGR88);
+
+					// Apply the alpha channel.
+					px0 = _mm256_or_si256(px0, Mask32_A);
+					px1 = _mm256_or_si256(px1, Mask32_A);
+
+					// Write the pixels to the destination image buffer.
+					_mm256_storeu_si256(&ymm_dest[0], px0);
+					_mm256_storeu_si256(&ymm_dest[1], px1);
+				}
+
+				// Remaining pixels.
+				for (; x > 0; x--) {
+					*px_dest = GR88_to_ARGB32(*img_buf);
+					img_buf++;
+					px_dest++;
+				}
+
+				// Next line.
+				img_buf += src_stride_adj;
+				px_dest += dest_stride_adj;
+			}
+
+			// Set the sBIT metadata.
+			static const rp_image::sBIT_t sBIT_RG88 = {8,8,1,0,0};
+			img->set_sBIT(&sBIT_RG88);
+			break;
+		}
+
+		default:
+			assert(!"Pixel format not supported.");
+			img->unref();
+			return nullptr;
+	}
+
+	// Image has been converted.
+	return img;
+}
+
+/**
+ * Convert a linear 24-bit RGB image to rp_image.
+ * AVX2-optimized version.
+ * @param px_format	[in] 24-bit pixel format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] Image buffer. (must be byte-addressable)
+ * @param img_siz	[in] Size of image data. [must be >= (w*h)*3]
+ * @param stride	[in,opt] Stride, in bytes. If 0, assumes width*bytespp.
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromLinear24_avx2(PixelFormat px_format,
+	int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz, int stride)
+{
+	ASSERT_ALIGNMENT(16, img_buf);
+	static const int bytespp = 3;
+
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+	assert(img_siz >= (((size_t)width * (size_t)height) * bytespp));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < (((size_t)width * (size_t)height) * bytespp))
+	{
+		return nullptr;
+	}
+
+	// Stride adjustment.
+	int src_stride_adj = 0;
+	assert(stride >= 0);
+	if (stride > 0) {
+		// Set src_stride_adj to the number of bytes we need to
+		// add to the end of each line to get to the next row.
+		if (unlikely(stride < (width * bytespp))) {
+			// Invalid stride.
+			return nullptr;
+		} else if (unlikely(stride % 16 != 0)) {
+			// Unaligned stride.
+			// Use the C++ version.
+			return fromLinear24_cpp(px_format, width, height, img_buf, img_siz, stride);
+		}
+		// NOTE: Byte addressing, so keep it in units of bytespp.
+		src_stride_adj = stride - (width * bytespp);
+	} else {
+		// Calculate stride and make sure it's a multiple of 16.
+		stride = width * bytespp;
+		if (unlikely(stride % 16 != 0)) {
+			// Unaligned stride.
+			// Use the C++ version.
+			return fromLinear24_cpp(px_format, width, height, img_buf, img_siz, stride);
+		}
+	}
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(width, height, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+	const int dest_stride_adj = (img->stride() / sizeof(argb32_t)) - img->width();
+	argb32_t *px_dest = static_cast<argb32_t*>(img->bits());
+
+	// 24-bit RGB images don't have an alpha channel.
+	const __m256i alpha_mask = _mm256_set1_epi32(0xFF000000);
+
+	// Determine the byte shuffle mask.
+	// NOTE: vpshufb shuffles within each 128-bit lane.
+	// Each lane contains 12 bytes of source data (4 pixels),
+	// so the 128-bit shuffle mask is repeated.
+	__m256i shuf_mask;
+	switch (px_format) {
+		case PixelFormat::RGB888:
+			shuf_mask = _mm256_setr_epi8(
+				0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1,
+				0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+			break;
+		case PixelFormat::BGR888:
+			shuf_mask = _mm256_setr_epi8(
+				2,1,0,-1, 5,4,3,-1, 8,7,6,-1, 11,10,9,-1,
+				2,1,0,-1, 5,4,3,-1, 8,7,6,-1, 11,10,9,-1);
+			break;
+		default:
+			assert(!"Unsupported 24-bit pixel format.");
+			img->unref();
+			return nullptr;
+	}
+
+	// DWORD permutation masks to split 24 bytes (8 pixels) into two
+	// lanes of 12 bytes each. The low lane gets bytes [0,12), and the
+	// high lane gets bytes [12,24). The last DWORD in each lane is
+	// not used by the shuffle mask.
+	// - perm_lo: Source data starts at DWORD 0.
+	// - perm_hi: Source data starts at DWORD 2.
+	const __m256i perm_lo = _mm256_setr_epi32(0,1,2,3, 3,4,5,6);
+	const __m256i perm_hi = _mm256_setr_epi32(2,3,4,5, 5,6,7,7);
+
+	for (unsigned int y = static_cast<unsigned int>(height); y > 0; y--) {
+		// Process 32 pixels per iteration using AVX2.
+		unsigned int x = static_cast<unsigned int>(width);
+		for (; x > 31; x -= 32, px_dest += 32, img_buf += 32*3) {
+			const __m256i *ymm_src = reinterpret_cast<const __m256i*>(img_buf);
+			__m256i *ymm_dest = reinterpret_cast<__m256i*>(px_dest);
+
+			// Source bytes: sa = [0,32), sb = [32,64), sc = [64,96)
+			const __m256i sa = _mm256_loadu_si256(&ymm_src[0]);
+			const __m256i sb = _mm256_loadu_si256(&ymm_src[1]);
+			const __m256i sc = _mm256_loadu_si256(&ymm_src[2]);
+
+			// Pixels 0-7: bytes [0,24)
+			__m256i val = _mm256_permutevar8x32_epi32(sa, perm_lo);
+			val = _mm256_or_si256(_mm256_shuffle_epi8(val, shuf_mask), alpha_mask);
+			_mm256_storeu_si256(&ymm_dest[0], val);
+
+			// Pixels 8-15: bytes [24,48)
+			val = _mm256_permute2x128_si256(sa, sb, 0x21);	// bytes [16,48)
+			val = _mm256_permutevar8x32_epi32(val, perm_hi);
+			val = _mm256_or_si256(_mm256_shuffle_epi8(val, shuf_mask), alpha_mask);
+			_mm256_storeu_si256(&ymm_dest[1], val);
+
+			// Pixels 16-23: bytes [48,72)
+			val = _mm256_permute2x128_si256(sb, sc, 0x21);	// bytes [48,80)
+			val = _mm256_permutevar8x32_epi32(val, perm_lo);
+			val = _mm256_or_si256(_mm256_shuffle_epi8(val, shuf_mask), alpha_mask);
+			_mm256_storeu_si256(&ymm_dest[2], val);
+
+			// Pixels 24-31: bytes [72,96)
+			val = _mm256_permutevar8x32_epi32(sc, perm_hi);
+			val = _mm256_or_si256(_mm256_shuffle_epi8(val, shuf_mask), alpha_mask);
+			_mm256_storeu_si256(&ymm_dest[3], val);
+		}
+
+		// Remaining pixels.
+		if (x > 0) {
+		switch (px_format) {
+			case PixelFormat::RGB888:
+				for (; x > 0; x--, px_dest++, img_buf += 3) {
+					px_dest->b = img_buf[0];
+					px_dest->g = img_buf[1];
+					px_dest->r = img_buf[2];
+					px_dest->a = 0xFF;
+				}
+				break;
+
+			case PixelFormat::BGR888:
+				for (; x > 0; x--, px_dest++, img_buf += 3) {
+					px_dest->b = img_buf[2];
+					px_dest->g = img_buf[1];
+					px_dest->r = img_buf[0];
+					px_dest->a = 0xFF;
+				}
+				break;
+
+			default:
+				assert(!"Unsupported 24-bit pixel format.");
+				img->unref();
+				return nullptr;
+		} }
+
+		// Next line.
+		img_buf += src_stride_adj;
+		px_dest += dest_stride_adj;
+	}
+
+	// Set the sBIT metadata.
+	static const rp_image::sBIT_t sBIT = {8,8,8,0,0};
+	img->set_sBIT(&sBIT);
+
+	// Image has been converted.
+	return img;
+}
+
+/**
+ * Convert a linear 32-bit RGB image to rp_image.
+ * AVX2-optimized version.
+ * @param px_format	[in] 32-bit pixel format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] 32-bit image buffer.
+ * @param img_siz	[in] Size of image data. [must be >= (w*h)*3]
+ * @param stride	[in,opt] Stride, in bytes. If 0, assumes width*bytespp.
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromLinear32_avx2(PixelFormat px_format,
+	int width, int height,
+	const uint32_t *RESTRICT img_buf, size_t img_siz, int stride)
+{
+	ASSERT_ALIGNMENT(16, img_buf);
+	static const int bytespp = 4;
+
+	// FIXME: Add support for these formats.
+	// For now, redirect back to the C++ version.
+	switch (px_format) {
+		case PixelFormat::A2R10G10B10:
+		case PixelFormat::A2B10G10R10:
+		case PixelFormat::RGB9_E5:
+		case PixelFormat::BGR888_ABGR7888:
+			return fromLinear32_cpp(px_format, width, height, img_buf, img_siz, stride);
+
+		case PixelFormat::Host_ARGB32:
+			// Host-endian ARGB32 is a straight copy.
+			// The SSSE3 version handles this with memcpy().
+			return fromLinear32_ssse3(px_format, width, height, img_buf, img_siz, stride);
+
+		default:
+			break;
+	}
+
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+	assert(img_siz >= ImageSizeCalc::T_calcImageSize(width, height, bytespp));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < ImageSizeCalc::T_calcImageSize(width, height, bytespp))
+	{
+		return nullptr;
+	}
+
+	// Stride adjustment.
+	int src_stride_adj = 0;
+	assert(stride >= 0);
+	if (stride > 0) {
+		// Set src_stride_adj to the number of pixels we need to
+		// add to the end of each line to get to the next row.
+		assert(stride % bytespp == 0);
+		assert(stride >= (width * bytespp));
+		if (unlikely(stride % bytespp != 0 || stride < (width * bytespp))) {
+			// Invalid stride.
+			return nullptr;
+		}
+		src_stride_adj = (stride / bytespp) - width;
+	} else {
+		// Calculate stride and make sure it's a multiple of 16.
+		stride = width * bytespp;
+		if (unlikely(stride % 16 != 0)) {
+			// Unaligned stride.
+			// Use the C++ version.
+			return fromLinear32_cpp(px_format, width, height, img_buf, img_siz, stride);
+		}
+	}
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(width, height, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+
+	const int dest_stride_adj = (img->stride() / sizeof(uint32_t)) - img->width();
+	uint32_t *px_dest = static_cast<uint32_t*>(img->bits());
+
+	// Determine the byte shuffle mask.
+	// NOTE: vpshufb shuffles within each 128-bit lane,
+	// so the 128-bit shuffle mask is repeated.
+	__m256i shuf_mask;
+	bool has_alpha;
+	switch (px_format) {
+		case PixelFormat::Host_xRGB32:
+			// TODO: Only apply the alpha mask instead of shuffling.
+			shuf_mask = _mm256_setr_epi8(
+				0,1,2,3, 4,5,6,7, 8,9,10,11, 12,13,14,15,
+				0,1,2,3, 4,5,6,7, 8,9,10,11, 12,13,14,15);
+			has_alpha = false;
+			break;
+
+		case PixelFormat::Host_RGBA32:
+		case PixelFormat::Host_RGBx32:
+			shuf_mask = _mm256_setr_epi8(
+				1,2,3,0, 5,6,7,4, 9,10,11,8, 13,14,15,12,
+				1,2,3,0, 5,6,7,4, 9,10,11,8, 13,14,15,12);
+			has_alpha = (px_format == PixelFormat::Host_RGBA32);
+			break;
+
+		case PixelFormat::Swap_ARGB32:
+		case PixelFormat::Swap_xRGB32:
+			shuf_mask = _mm256_setr_epi8(
+				3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+				3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+			has_alpha = (px_format == PixelFormat::Swap_ARGB32);
+			break;
+
+		case PixelFormat::Swap_RGBA32:
+		case PixelFormat::Swap_RGBx32:
+			shuf_mask = _mm256_setr_epi8(
+				2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15,
+				2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15);
+			has_alpha = (px_format == PixelFormat::Swap_RGBA32);
+			break;
+
+		case PixelFormat::G16R16:
+			// NOTE: Truncates to G8R8.
+			shuf_mask = _mm256_setr_epi8(
+				-1,3,1,-1, -1,7,5,-1, -1,11,9,-1, -1,15,13,-1,
+				-1,3,1,-1, -1,7,5,-1, -1,11,9,-1, -1,15,13,-1);
+			has_alpha = false;
+			break;
+
+		case PixelFormat::RABG8888:
+			shuf_mask = _mm256_setr_epi8(
+				1,0,3,2, 5,4,7,6, 9,8,11,10, 13,12,15,14,
+				1,0,3,2, 5,4,7,6, 9,8,11,10, 13,12,15,14);
+			has_alpha = true;
+			break;
+
+		default:
+			assert(!"Unsupported 32-bit pixel format.");
+			img->unref();
+			return nullptr;
+	}
+
+	// If the image doesn't have an alpha channel, it needs to be set to 0xFF.
+	const __m256i alpha_mask = (has_alpha)
+		? _mm256_setzero_si256()
+		: _mm256_set1_epi32(0xFF000000);
+
+	for (unsigned int y = static_cast<unsigned int>(height); y > 0; y--) {
+		// Process 32 pixels per iteration using AVX2.
+		unsigned int x = static_cast<unsigned int>(width);
+		for (; x > 31; x -= 32, px_dest += 32, img_buf += 32) {
+			const __m256i *ymm_src = reinterpret_cast<const __m256i*>(img_buf);
+			__m256i *ymm_dest = reinterpret_cast<__m256i*>(px_dest);
+
+			__m256i sa = _mm256_loadu_si256(&ymm_src[0]);
+			__m256i sb = _mm256_loadu_si256(&ymm_src[1]);
+			__m256i sc = _mm256_loadu_si256(&ymm_src[2]);
+			__m256i sd = _mm256_loadu_si256(&ymm_src[3]);
+
+			_mm256_storeu_si256(&ymm_dest[0], _mm256_or_si256(_mm256_shuffle_epi8(sa, shuf_mask), alpha_mask));
+			_mm256_storeu_si256(&ymm_dest[1], _mm256_or_si256(_mm256_shuffle_epi8(sb, shuf_mask), alpha_mask));
+			_mm256_storeu_si256(&ymm_dest[2], _mm256_or_si256(_mm256_shuffle_epi8(sc, shuf_mask), alpha_mask));
+			_mm256_storeu_si256(&ymm_dest[3], _mm256_or_si256(_mm256_shuffle_epi8(sd, shuf_mask), alpha_mask));
+		}
+
+		// Remaining pixels.
+		if (x > 0) {
+		switch (px_format) {
+			case PixelFormat::Host_xRGB32:
+				// Host-endian XRGB32.
+				// Pixel copy is needed, with alpha channel masking.
+				for (; x > 0; x--) {
+					*px_dest = *img_buf | 0xFF000000;
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::Host_RGBA32:
+				// Host-endian RGBA32.
+				// Pixel copy is needed, with shifting.
+				for (; x > 0; x--) {
+					*px_dest = (*img_buf >> 8) | (*img_buf << 24);
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::Host_RGBx32:
+				// Host-endian RGBx32.
+				// Pixel copy is needed, with a right shift.
+				for (; x > 0; x--) {
+					*px_dest = (*img_buf >> 8) | 0xFF000000;
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::Swap_ARGB32:
+				// Byteswapped ARGB32.
+				// Pixel copy is needed, with byteswapping.
+				for (; x > 0; x--) {
+					*px_dest = __swab32(*img_buf);
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::Swap_xRGB32:
+				// Byteswapped XRGB32.
+				// Pixel copy is needed, with byteswapping and alpha channel masking.
+				for (; x > 0; x--) {
+					*px_dest = __swab32(*img_buf) | 0xFF000000;
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::Swap_RGBA32:
+				// Byteswapped ABGR32.
+				// Pixel copy is needed, with shifting.
+				for (; x > 0; x--) {
+					const uint32_t px = __swab32(*img_buf);
+					*px_dest = (px >> 8) | (px << 24);
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::Swap_RGBx32:
+				// Byteswapped RGBx32.
+				// Pixel copy is needed, with byteswapping and a right shift.
+				for (; x > 0; x--) {
+					*px_dest = (__swab32(*img_buf) >> 8) | 0xFF000000;
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::G16R16:
+				// G16R16.
+				for (; x > 0; x--) {
+					*px_dest = G16R16_to_ARGB32(le32_to_cpu(*img_buf));
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			case PixelFormat::RABG8888:
+				// RABG8888. (VTF "ARGB8888")
+				for (; x > 0; x--) {
+					const uint32_t px = le32_to_cpu(*img_buf);
+					*px_dest  = (px >> 8) & 0xFF;
+					*px_dest |= (px & 0xFF) << 8;
+					*px_dest |= (px << 8) & 0xFF000000;
+					*px_dest |= (px >> 8) & 0x00FF0000;
+					img_buf++;
+					px_dest++;
+				}
+				break;
+
+			default:
+				assert(!"Unsupported 32-bit pixel format.");
+				img->unref();
+				return nullptr;
+		} }
+
+		// Next line.
+		img_buf += src_stride_adj;
+		px_dest += dest_stride_adj;
+	}
+
+	// Set the sBIT metadata.
+	if (has_alpha) {
+		static const rp_image::sBIT_t sBIT_A32 = {8,8,8,0,8};
+		img->set_sBIT(&sBIT_A32);
+	} else if (unlikely(px_format == PixelFormat::G16R16)) {
+		static const rp_image::sBIT_t sBIT_G16R16 = {8,8,1,0,0};
+		img->set_sBIT(&sBIT_G16R16);
+	} else {
+		static const rp_image::sBIT_t sBIT_x32 = {8,8,8,0,0};
+		img->set_sBIT(&sBIT_x32);
+	}
+
+	// Image has been converted.
+	return img;
+}
+
+} }
+
+#ifdef _MSC_VER
+# pragma warning(pop)
+#endif
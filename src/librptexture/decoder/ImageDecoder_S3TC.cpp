@@ -223,47 +223,49 @@ rp_image *fromDXT1_GCN(int width, int height,
 		return nullptr;
 	}
 
-	const dxt1_block *dxt1_src = reinterpret_cast<const dxt1_block*>(img_buf);
-
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(width / 4);
-	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
-
-	// Temporary 4-tile buffer.
-	array<array<uint32_t, 4*4>, 4> tileBuf;
+	const int tilesX = width / 4;
+	const int tilesY = height / 4;
 
 	// Tiles are arranged in 2x2 blocks.
 	// Reference: https://github.com/nickworonekin/puyotools/blob/80f11884f6cae34c4a56c5b1968600fe7c34628b/Libraries/VrSharp/GvrTexture/GvrDataCodec.cs#L712
-	for (unsigned int y = 0; y < tilesY; y += 2) {
-	for (unsigned int x = 0; x < tilesX; x += 2) {
-		// Decode 4 tiles at once.
-		for (unsigned int tile = 0; tile < 4; tile++, dxt1_src++) {
-			// Decode the DXT1 tile palette.
-			// TODO: Color 3 may be either black or transparent.
-			// Figure out if there's a way to specify that in GVR.
-			// Assuming transparent for now, since most GVR DXT1
-			// textures use transparency.
-			argb32_t pal[4];
-			decode_DXTn_tile_color_palette_S3TC<DXTn_PALETTE_BIG_ENDIAN | DXTn_PALETTE_COLOR3_ALPHA>(pal, dxt1_src);
-
-			// Process the 16 color indexes.
-			// NOTE: The tile indexes are stored "backwards" due to
-			// big-endian shenanigans.
-			uint32_t indexes = be32_to_cpu(dxt1_src->indexes);
-			const auto tileBuf_rend = tileBuf[tile].rend();
-			for (auto iter = tileBuf[tile].rbegin();
-			     iter != tileBuf_rend; ++iter, indexes >>= 2)
-			{
-				*iter = pal[indexes & 3].u32;
+	// Rows are processed in pairs.
+	LibRpThreads::parallel_for(0, (tilesY + 1) / 2, [&](int yy) {
+		const int y = yy * 2;
+		const dxt1_block *dxt1_src = reinterpret_cast<const dxt1_block*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x += 2) {
+			// Temporary 4-tile buffer.
+			array<array<uint32_t, 4*4>, 4> tileBuf;
+
+			// Decode 4 tiles at once.
+			for (unsigned int tile = 0; tile < 4; tile++, dxt1_src++) {
+				// Decode the DXT1 tile palette.
+				// TODO: Color 3 may be either black or transparent.
+				// Figure out if there's a way to specify that in GVR.
+				// Assuming transparent for now, since most GVR DXT1
+				// textures use transparency.
+				argb32_t pal[4];
+				decode_DXTn_tile_color_palette_S3TC<DXTn_PALETTE_BIG_ENDIAN | DXTn_PALETTE_COLOR3_ALPHA>(pal, dxt1_src);
+
+				// Process the 16 color indexes.
+				// NOTE: The tile indexes are stored "backwards" due to
+				// big-endian shenanigans.
+				uint32_t indexes = be32_to_cpu(dxt1_src->indexes);
+				const auto tileBuf_rend = tileBuf[tile].rend();
+				for (auto iter = tileBuf[tile].rbegin();
+				     iter != tileBuf_rend; ++iter, indexes >>= 2)
+				{
+					*iter = pal[indexes & 3].u32;
+				}
 			}
-		}
 
-		// Blit the tiles to the main image buffer.
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[0], x+0, y+0);
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[1], x+1, y+0);
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[2], x+0, y+1);
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[3], x+1, y+1);
-	} }
+			// Blit the tiles to the main image buffer.
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[0], x+0, y+0);
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[1], x+1, y+0);
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[2], x+0, y+1);
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf[3], x+1, y+1);
+		}
+	}, width * height >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	// Set the sBIT metadata.
 	static const rp_image::sBIT_t sBIT = {8,8,8,0,1};
@@ -312,31 +314,31 @@ static rp_image *T_fromDXT1(int width, int height,
 		return nullptr;
 	}
 
-	const dxt1_block *dxt1_src = reinterpret_cast<const dxt1_block*>(img_buf);
-
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(physWidth / 4);
-	const unsigned int tilesY = static_cast<unsigned int>(physHeight / 4);
-
-	// Temporary tile buffer.
-	array<uint32_t, 4*4> tileBuf;
-
-	for (unsigned int y = 0; y < tilesY; y++) {
-	for (unsigned int x = 0; x < tilesX; x++, dxt1_src++) {
-		// Decode the DXT1 tile palette.
-		argb32_t pal[4];
-		decode_DXTn_tile_color_palette_S3TC<palflags>(pal, dxt1_src);
-
-		// Process the 16 color indexes.
-		uint32_t indexes = le32_to_cpu(dxt1_src->indexes);
-		for (uint32_t &p : tileBuf) {
-			p = pal[indexes & 3].u32;
-			indexes >>= 2;
-		}
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
 
-		// Blit the tile to the main image buffer.
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
-	} }
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const dxt1_block *dxt1_src = reinterpret_cast<const dxt1_block*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x++, dxt1_src++) {
+			// Temporary tile buffer.
+			array<uint32_t, 4*4> tileBuf;
+
+			// Decode the DXT1 tile palette.
+			argb32_t pal[4];
+			decode_DXTn_tile_color_palette_S3TC<palflags>(pal, dxt1_src);
+
+			// Process the 16 color indexes.
+			uint32_t indexes = le32_to_cpu(dxt1_src->indexes);
+			for (uint32_t &p : tileBuf) {
+				p = pal[indexes & 3].u32;
+				indexes >>= 2;
+			}
+
+			// Blit the tile to the main image buffer.
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	if (width < physWidth || height < physHeight) {
 		// Shrink the image.
@@ -353,6 +355,7 @@ static rp_image *T_fromDXT1(int width, int height,
 
 /**
  * Convert a DXT1 image to rp_image.
+ * Standard version using regular C++ code.
  * S3TC palette index 3 will be interpreted as black.
  *
  * @param width Image width.
@@ -361,7 +364,7 @@ static rp_image *T_fromDXT1(int width, int height,
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *fromDXT1(int width, int height,
+rp_image *fromDXT1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz)
 {
 	return T_fromDXT1<0>(width, height, img_buf, img_siz);
@@ -369,6 +372,7 @@ rp_image *fromDXT1(int width, int height,
 
 /**
  * Convert a DXT1 image to rp_image.
+ * Standard version using regular C++ code.
  * S3TC palette index 3 will be interpreted as fully transparent.
  *
  * @param width Image width.
@@ -377,7 +381,7 @@ rp_image *fromDXT1(int width, int height,
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *fromDXT1_A1(int width, int height,
+rp_image *fromDXT1_A1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz)
 {
 	return T_fromDXT1<DXTn_PALETTE_COLOR3_ALPHA>(width, height, img_buf, img_siz);
@@ -455,38 +459,39 @@ rp_image *fromDXT3(int width, int height,
 		dxt1_block colors;	// DXT1-style color block.
 	};
 	ASSERT_STRUCT(dxt3_block, 16);
-	const dxt3_block *dxt3_src = reinterpret_cast<const dxt3_block*>(img_buf);
 
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(physWidth / 4);
-	const unsigned int tilesY = static_cast<unsigned int>(physHeight / 4);
-
-	// Temporary tile buffer.
-	array<uint32_t, 4*4> tileBuf;
-
-	for (unsigned int y = 0; y < tilesY; y++) {
-	for (unsigned int x = 0; x < tilesX; x++, dxt3_src++) {
-		// Decode the DXT3 tile palette.
-		argb32_t pal[4];
-		decode_DXTn_tile_color_palette_S3TC<DXTn_PALETTE_COLOR0_GT_COLOR1>(pal, &dxt3_src->colors);
-
-		// Process the 16 color indexes and apply alpha.
-		uint32_t indexes = le32_to_cpu(dxt3_src->colors.indexes);
-		uint64_t alpha = le64_to_cpu(dxt3_src->alpha);
-		for (uint32_t &p : tileBuf) {
-			argb32_t color = pal[indexes & 3];
-			// TODO: Verify alpha value handling for DXT3.
-			color.a = (alpha & 0xF) | ((alpha & 0xF) << 4);
-			p = color.u32;
-
-			// Next indexes.
-			indexes >>= 2;
-			alpha >>= 4;
-		}
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
+
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const dxt3_block *dxt3_src = reinterpret_cast<const dxt3_block*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x++, dxt3_src++) {
+			// Temporary tile buffer.
+			array<uint32_t, 4*4> tileBuf;
+
+			// Decode the DXT3 tile palette.
+			argb32_t pal[4];
+			decode_DXTn_tile_color_palette_S3TC<DXTn_PALETTE_COLOR0_GT_COLOR1>(pal, &dxt3_src->colors);
+
+			// Process the 16 color indexes and apply alpha.
+			uint32_t indexes = le32_to_cpu(dxt3_src->colors.indexes);
+			uint64_t alpha = le64_to_cpu(dxt3_src->alpha);
+			for (uint32_t &p : tileBuf) {
+				argb32_t color = pal[indexes & 3];
+				// TODO: Verify alpha value handling for DXT3.
+				color.a = (alpha & 0xF) | ((alpha & 0xF) << 4);
+				p = color.u32;
+
+				// Next indexes.
+				indexes >>= 2;
+				alpha >>= 4;
+			}
 
-		// Blit the tile to the main image buffer.
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
-	} }
+			// Blit the tile to the main image buffer.
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	if (width < physWidth || height < physHeight) {
 		// Shrink the image.
@@ -532,13 +537,14 @@ rp_image *fromDXT4(int width, int height,
 
 /**
  * Convert a DXT5 image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf DXT5 image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)]
  * @return rp_image, or nullptr on error.
  */
-rp_image *fromDXT5(int width, int height,
+rp_image *fromDXT5_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz)
 {
 	// Verify parameters.
@@ -573,40 +579,41 @@ rp_image *fromDXT5(int width, int height,
 		dxt1_block colors;	// DXT1-style color block.
 	};
 	ASSERT_STRUCT(dxt5_block, 16);
-	const dxt5_block *dxt5_src = reinterpret_cast<const dxt5_block*>(img_buf);
 
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(physWidth / 4);
-	const unsigned int tilesY = static_cast<unsigned int>(physHeight / 4);
-
-	// Temporary tile buffer.
-	array<uint32_t, 4*4> tileBuf;
-
-	for (unsigned int y = 0; y < tilesY; y++) {
-	for (unsigned int x = 0; x < tilesX; x++, dxt5_src++) {
-		// Decode the DXT5 tile palette.
-		argb32_t pal[4];
-		decode_DXTn_tile_color_palette_S3TC<0>(pal, &dxt5_src->colors);
-
-		// Get the DXT5 alpha codes.
-		uint64_t alpha48 = extract48(&dxt5_src->alpha);
-
-		// Process the 16 color and alpha indexes.
-		uint32_t indexes = le32_to_cpu(dxt5_src->colors.indexes);
-		for (uint32_t &p : tileBuf) {
-			argb32_t color = pal[indexes & 3];
-			// Decode the alpha channel value.
-			color.a = decode_DXT5_alpha_S3TC(alpha48 & 7, dxt5_src->alpha.values);
-			p = color.u32;
-
-			// Next indexes.
-			indexes >>= 2;
-			alpha48 >>= 3;
-		}
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
+
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const dxt5_block *dxt5_src = reinterpret_cast<const dxt5_block*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x++, dxt5_src++) {
+			// Temporary tile buffer.
+			array<uint32_t, 4*4> tileBuf;
+
+			// Decode the DXT5 tile palette.
+			argb32_t pal[4];
+			decode_DXTn_tile_color_palette_S3TC<0>(pal, &dxt5_src->colors);
+
+			// Get the DXT5 alpha codes.
+			uint64_t alpha48 = extract48(&dxt5_src->alpha);
+
+			// Process the 16 color and alpha indexes.
+			uint32_t indexes = le32_to_cpu(dxt5_src->colors.indexes);
+			for (uint32_t &p : tileBuf) {
+				argb32_t color = pal[indexes & 3];
+				// Decode the alpha channel value.
+				color.a = decode_DXT5_alpha_S3TC(alpha48 & 7, dxt5_src->alpha.values);
+				p = color.u32;
+
+				// Next indexes.
+				indexes >>= 2;
+				alpha48 >>= 3;
+			}
 
-		// Blit the tile to the main image buffer.
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
-	} }
+			// Blit the tile to the main image buffer.
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	if (width < physWidth || height < physHeight) {
 		// Shrink the image.
@@ -663,39 +670,40 @@ rp_image *fromBC4(int width, int height,
 		dxt5_alpha red;
 	};
 	ASSERT_STRUCT(bc4_block, 8);
-	const bc4_block *bc4_src = reinterpret_cast<const bc4_block*>(img_buf);
 
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(physWidth / 4);
-	const unsigned int tilesY = static_cast<unsigned int>(physHeight / 4);
-
-	// Temporary tile buffer.
-	array<uint32_t, 4*4> tileBuf;
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
 
 	// S3TC version.
-	for (unsigned int y = 0; y < tilesY; y++) {
-	for (unsigned int x = 0; x < tilesX; x++, bc4_src++) {
-		// BC4 colors are determined using DXT5-style alpha interpolation.
-
-		// Get the BC4 color codes.
-		uint64_t red48 = extract48(&bc4_src->red);
-
-		// Process the 16 color indexes.
-		// NOTE: Using red instead of grayscale here.
-		argb32_t color;
-		color.u32 = 0xFF000000U;	// opaque black
-		for (uint32_t &p : tileBuf) {
-			// Decode the red channel value.
-			color.r = decode_DXT5_alpha_S3TC(red48 & 7, bc4_src->red.values);
-			p = color.u32;
-
-			// Next index.
-			red48 >>= 3;
-		}
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const bc4_block *bc4_src = reinterpret_cast<const bc4_block*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x++, bc4_src++) {
+			// Temporary tile buffer.
+			array<uint32_t, 4*4> tileBuf;
 
-		// Blit the tile to the main image buffer.
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
-	} }
+			// BC4 colors are determined using DXT5-style alpha interpolation.
+
+			// Get the BC4 color codes.
+			uint64_t red48 = extract48(&bc4_src->red);
+
+			// Process the 16 color indexes.
+			// NOTE: Using red instead of grayscale here.
+			argb32_t color;
+			color.u32 = 0xFF000000U;	// opaque black
+			for (uint32_t &p : tileBuf) {
+				// Decode the red channel value.
+				color.r = decode_DXT5_alpha_S3TC(red48 & 7, bc4_src->red.values);
+				p = color.u32;
+
+				// Next index.
+				red48 >>= 3;
+			}
+
+			// Blit the tile to the main image buffer.
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	if (width < physWidth || height < physHeight) {
 		// Shrink the image.
@@ -755,41 +763,42 @@ rp_image *fromBC5(int width, int height,
 		dxt5_alpha green;
 	};
 	ASSERT_STRUCT(bc5_block, 16);
-	const bc5_block *bc5_src = reinterpret_cast<const bc5_block*>(img_buf);
 
 	// Calculate the total number of tiles.
-	const unsigned int tilesX = static_cast<unsigned int>(width / 4);
-	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
-
-	// Temporary tile buffer.
-	array<uint32_t, 4*4> tileBuf;
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
 
 	// S3TC version.
-	for (unsigned int y = 0; y < tilesY; y++) {
-	for (unsigned int x = 0; x < tilesX; x++, bc5_src++) {
-		// BC5 colors are determined using DXT5-style alpha interpolation.
-
-		// Get the BC5 color codes.
-		uint64_t red48   = extract48(&bc5_src->red);
-		uint64_t green48 = extract48(&bc5_src->green);
-
-		// Process the 16 color indexes.
-		argb32_t color;
-		color.u32 = 0xFF000000U;	// opaque black
-		for (uint32_t &p : tileBuf) {
-			// Decode the red and green channel values.
-			color.r = decode_DXT5_alpha_S3TC(red48   & 7, bc5_src->red.values);
-			color.g = decode_DXT5_alpha_S3TC(green48 & 7, bc5_src->green.values);
-			p = color.u32;
-
-			// Next indexes.
-			red48 >>= 3;
-			green48 >>= 3;
-		}
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const bc5_block *bc5_src = reinterpret_cast<const bc5_block*>(img_buf) + (y * tilesX);
+		for (int x = 0; x < tilesX; x++, bc5_src++) {
+			// Temporary tile buffer.
+			array<uint32_t, 4*4> tileBuf;
+
+			// BC5 colors are determined using DXT5-style alpha interpolation.
 
-		// Blit the tile to the main image buffer.
-		ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
-	} }
+			// Get the BC5 color codes.
+			uint64_t red48   = extract48(&bc5_src->red);
+			uint64_t green48 = extract48(&bc5_src->green);
+
+			// Process the 16 color indexes.
+			argb32_t color;
+			color.u32 = 0xFF000000U;	// opaque black
+			for (uint32_t &p : tileBuf) {
+				// Decode the red and green channel values.
+				color.r = decode_DXT5_alpha_S3TC(red48   & 7, bc5_src->red.values);
+				color.g = decode_DXT5_alpha_S3TC(green48 & 7, bc5_src->green.values);
+				p = color.u32;
+
+				// Next indexes.
+				red48 >>= 3;
+				green48 >>= 3;
+			}
+
+			// Blit the tile to the main image buffer.
+			ImageDecoderPrivate::BlitTile<uint32_t, 4, 4>(img, tileBuf, x, y);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
 
 	if (width < physWidth || height < physHeight) {
 		// Shrink the image.
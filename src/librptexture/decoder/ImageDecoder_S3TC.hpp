@@ -29,6 +29,7 @@ rp_image *fromDXT1_GCN(int width, int height,
 
 /**
  * Convert a DXT1 image to rp_image.
+ * Standard version using regular C++ code.
  * S3TC palette index 3 will be interpreted as black.
  *
  * @param width Image width.
@@ -38,11 +39,114 @@ rp_image *fromDXT1_GCN(int width, int height,
  * @return rp_image, or nullptr on error.
  */
 ATTR_ACCESS_SIZE(read_only, 3, 4)
-rp_image *fromDXT1(int width, int height,
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz);
 
+#ifdef IMAGEDECODER_HAS_SSE41
 /**
  * Convert a DXT1 image to rp_image.
+ * SSE4.1-optimized version.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+/**
+ * Convert a DXT1 image to rp_image.
+ * AVX2-optimized version.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+#if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
+/**
+ * Convert a DXT1 image to rp_image.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+IFUNC_STATIC_INLINE rp_image *fromDXT1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#else /* !(HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64)) */
+// System does not support IFUNC, or we aren't guaranteed to have
+// optimizations for these CPUs. Use standard inline dispatch.
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+static inline rp_image *fromDXT1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+#  ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromDXT1_avx2(width, height, img_buf, img_siz);
+	} else
+#  endif /* IMAGEDECODER_HAS_AVX2 */
+#  ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromDXT1_sse41(width, height, img_buf, img_siz);
+	} else
+#  endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromDXT1_cpp(width, height, img_buf, img_siz);
+	}
+}
+#endif /* HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64) */
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * Standard version using regular C++ code.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT1_A1_cpp(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE41
+/**
+ * Convert a DXT1 image to rp_image.
+ * SSE4.1-optimized version.
  * S3TC palette index 3 will be interpreted as fully transparent.
  *
  * @param width Image width.
@@ -52,8 +156,76 @@ rp_image *fromDXT1(int width, int height,
  * @return rp_image, or nullptr on error.
  */
 ATTR_ACCESS_SIZE(read_only, 3, 4)
-rp_image *fromDXT1_A1(int width, int height,
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT1_A1_sse41(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+/**
+ * Convert a DXT1 image to rp_image.
+ * AVX2-optimized version.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT1_A1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+#if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
+/**
+ * Convert a DXT1 image to rp_image.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+IFUNC_STATIC_INLINE rp_image *fromDXT1_A1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#else /* !(HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64)) */
+// System does not support IFUNC, or we aren't guaranteed to have
+// optimizations for these CPUs. Use standard inline dispatch.
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+static inline rp_image *fromDXT1_A1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+#  ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromDXT1_A1_avx2(width, height, img_buf, img_siz);
+	} else
+#  endif /* IMAGEDECODER_HAS_AVX2 */
+#  ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromDXT1_A1_sse41(width, height, img_buf, img_siz);
+	} else
+#  endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromDXT1_A1_cpp(width, height, img_buf, img_siz);
+	}
+}
+#endif /* HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64) */
 
 /**
  * Convert a DXT2 image to rp_image.
@@ -91,6 +263,53 @@ ATTR_ACCESS_SIZE(read_only, 3, 4)
 rp_image *fromDXT4(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz);
 
+/**
+ * Convert a DXT5 image to rp_image.
+ * Standard version using regular C++ code.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT5_cpp(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE41
+/**
+ * Convert a DXT5 image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT5_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+/**
+ * Convert a DXT5 image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+RP_LIBROMDATA_PUBLIC
+rp_image *fromDXT5_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+#if defined(HAVE_IFUNC) && (defined(RP_CPU_I386) || defined(RP_CPU_AMD64))
 /**
  * Convert a DXT5 image to rp_image.
  * @param width Image width.
@@ -100,8 +319,39 @@ rp_image *fromDXT4(int width, int height,
  * @return rp_image, or nullptr on error.
  */
 ATTR_ACCESS_SIZE(read_only, 3, 4)
-rp_image *fromDXT5(int width, int height,
+IFUNC_STATIC_INLINE rp_image *fromDXT5(int width, int height,
 	const uint8_t *RESTRICT img_buf, size_t img_siz);
+#else /* !(HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64)) */
+// System does not support IFUNC, or we aren't guaranteed to have
+// optimizations for these CPUs. Use standard inline dispatch.
+
+/**
+ * Convert a DXT5 image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+ATTR_ACCESS_SIZE(read_only, 3, 4)
+static inline rp_image *fromDXT5(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+#  ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromDXT5_avx2(width, height, img_buf, img_siz);
+	} else
+#  endif /* IMAGEDECODER_HAS_AVX2 */
+#  ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromDXT5_sse41(width, height, img_buf, img_siz);
+	} else
+#  endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromDXT5_cpp(width, height, img_buf, img_siz);
+	}
+}
+#endif /* HAVE_IFUNC && (RP_CPU_I386 || RP_CPU_AMD64) */
 
 /**
  * Convert a BC4 (ATI1) image to rp_image.
@@ -0,0 +1,475 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture)                     *
+ * ImageDecoder_S3TC_avx2.cpp: Image decoding functions: S3TC              *
+ * AVX2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+
+#include "ImageDecoder_S3TC.hpp"
+#include "ImageDecoder_p.hpp"
+
+#include "PixelConversion.hpp"
+using namespace LibRpTexture::PixelConversion;
+
+// AVX2 intrinsics
+#include <immintrin.h>
+
+// MSVC complains when the high bit is set in hex values
+// when setting SSE2 registers.
+#ifdef _MSC_VER
+#  pragma warning(push)
+#  pragma warning(disable: 4309)
+#endif
+
+// Two horizontally-adjacent tiles are decoded per iteration:
+// the first tile in the low 128-bit lane, and the second tile
+// in the high 128-bit lane. Each row of the two tiles is then
+// contiguous in the destination image, so it can be written
+// using a single 256-bit store.
+
+namespace LibRpTexture { namespace ImageDecoder {
+
+// DXT1 block format.
+// NOTE: Same layout as in ImageDecoder_S3TC.cpp.
+struct dxt1_block {
+	uint16_t color[2];	// Colors 0 and 1, in RGB565 format.
+	uint32_t indexes;	// Two-bit color indexes.
+};
+ASSERT_STRUCT(dxt1_block, 8);
+
+// DXT5 block format.
+struct dxt5_block {
+	uint8_t alpha[8];	// Alpha values (2) and 3-bit alpha codes (48-bit)
+	dxt1_block colors;	// DXT1-style color block.
+};
+ASSERT_STRUCT(dxt5_block, 16);
+
+// decode_DXTn_tile_color_palette flags.
+// NOTE: Same values as in ImageDecoder_S3TC.cpp.
+enum DXTn_Palette_Flags {
+	DXTn_PALETTE_COLOR3_ALPHA	= (1U << 1),	// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+};
+
+/**
+ * Combine two 128-bit values into a 256-bit value.
+ * @param lo Low lane
+ * @param hi High lane
+ * @return 256-bit value
+ */
+static FORCEINLINE __m256i combine_m128i(__m128i lo, __m128i hi)
+{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/**
+ * Decode two DXTn tile color palettes. (AVX2 version)
+ * @tparam flags Flags. (See DXTn_Palette_Flags)
+ * @param srcA	[in] First DXT1 block.
+ * @param srcB	[in] Second DXT1 block.
+ * @return Four ARGB32 palette entries for each block, one block per 128-bit lane.
+ */
+template<unsigned int flags>
+static FORCEINLINE __m256i decode_DXTn_tile_color_palette_x2_avx2(
+	const dxt1_block *RESTRICT srcA, const dxt1_block *RESTRICT srcB)
+{
+	// Convert the first two colors from RGB565,
+	// then expand them to 16-bit channels.
+	const uint16_t a0 = le16_to_cpu(srcA->color[0]);
+	const uint16_t a1 = le16_to_cpu(srcA->color[1]);
+	const uint16_t b0 = le16_to_cpu(srcB->color[0]);
+	const uint16_t b1 = le16_to_cpu(srcB->color[1]);
+	const __m256i p01 = _mm256_cvtepu8_epi16(_mm_setr_epi32(
+		RGB565_to_ARGB32(a0), RGB565_to_ARGB32(a1),
+		RGB565_to_ARGB32(b0), RGB565_to_ARGB32(b1)));
+	const __m256i p10 = _mm256_shuffle_epi32(p01, _MM_SHUFFLE(1,0,3,2));
+
+	// color0 > color1: Colors 2 and 3 are 2/3 and 1/3 interpolations.
+	// NOTE: x / 3 == (x * 0xAAAB) >> 17 for all x < 2^17.
+	__m256i p23_gt = _mm256_add_epi16(_mm256_add_epi16(p01, p01), p10);
+	p23_gt = _mm256_srli_epi16(_mm256_mulhi_epu16(p23_gt, _mm256_set1_epi16(static_cast<short>(0xAAAB))), 1);
+
+	// color0 <= color1: Color 2 is the average; color 3 is black and/or transparent.
+	__m256i p23_le = _mm256_srli_epi16(_mm256_add_epi16(p01, p10), 1);
+	p23_le = _mm256_blend_epi16(p23_le, (flags & DXTn_PALETTE_COLOR3_ALPHA)
+		? _mm256_setzero_si256()
+		: _mm256_set1_epi64x(0x00FF000000000000LL), 0xF0);
+
+	const int gtA = (a0 > a1) ? -1 : 0;
+	const int gtB = (b0 > b1) ? -1 : 0;
+	const __m256i p23 = _mm256_blendv_epi8(p23_le, p23_gt,
+		_mm256_setr_epi32(gtA, gtA, gtA, gtA, gtB, gtB, gtB, gtB));
+	return _mm256_packus_epi16(p01, p23);
+}
+
+/**
+ * Decode two DXT5 alpha palettes. (AVX2 version)
+ * @param alphaA	[in] First DXT5 alpha block.
+ * @param alphaB	[in] Second DXT5 alpha block.
+ * @return Eight alpha values in the low 8 bytes of each 128-bit lane.
+ */
+static FORCEINLINE __m256i decode_DXT5_alpha_palette_x2_avx2(
+	const uint8_t *RESTRICT alphaA, const uint8_t *RESTRICT alphaB)
+{
+	const __m256i a0 = combine_m128i(_mm_set1_epi16(alphaA[0]), _mm_set1_epi16(alphaB[0]));
+	const __m256i a1 = combine_m128i(_mm_set1_epi16(alphaA[1]), _mm_set1_epi16(alphaB[1]));
+
+	// alpha0 > alpha1: Six interpolated values, in 1/7ths.
+	// Colors 0 and 1 are multiplied by 7 so they can use the same division.
+	// NOTE: x / 7 == (x * 9363) >> 16 for all x <= 7*255.
+	__m256i pal_gt = _mm256_add_epi16(
+		_mm256_mullo_epi16(a0, _mm256_setr_epi16(7,0,6,5,4,3,2,1, 7,0,6,5,4,3,2,1)),
+		_mm256_mullo_epi16(a1, _mm256_setr_epi16(0,7,1,2,3,4,5,6, 0,7,1,2,3,4,5,6)));
+	pal_gt = _mm256_mulhi_epu16(pal_gt, _mm256_set1_epi16(9363));
+
+	// alpha0 <= alpha1: Four interpolated values, in 1/5ths, then 0 and 255.
+	// NOTE: x / 5 == (x * 13108) >> 16 for all x <= 5*255.
+	__m256i pal_le = _mm256_add_epi16(
+		_mm256_mullo_epi16(a0, _mm256_setr_epi16(5,0,4,3,2,1,0,0, 5,0,4,3,2,1,0,0)),
+		_mm256_mullo_epi16(a1, _mm256_setr_epi16(0,5,1,2,3,4,0,0, 0,5,1,2,3,4,0,0)));
+	pal_le = _mm256_mulhi_epu16(pal_le, _mm256_set1_epi16(13108));
+	pal_le = _mm256_blend_epi16(pal_le, _mm256_set1_epi64x(0x00FF000000000000LL), 0xC0);
+
+	const int gtA = (alphaA[0] > alphaA[1]) ? -1 : 0;
+	const int gtB = (alphaB[0] > alphaB[1]) ? -1 : 0;
+	const __m256i pal = _mm256_blendv_epi8(pal_le, pal_gt,
+		_mm256_setr_epi32(gtA, gtA, gtA, gtA, gtB, gtB, gtB, gtB));
+	return _mm256_packus_epi16(pal, pal);
+}
+
+/**
+ * Expand the DXT1 color indexes of two blocks to palette byte offsets.
+ * @param idxA First block's two-bit color indexes. (host-endian)
+ * @param idxB Second block's two-bit color indexes. (host-endian)
+ * @return 16 bytes per 128-bit lane, one per pixel, containing (index * 4).
+ */
+static FORCEINLINE __m256i expand_DXT1_indexes_x2_avx2(uint32_t idxA, uint32_t idxB)
+{
+	// Each 16-bit lane tests the two bits for one pixel.
+	const __m256i mask_lo = _mm256_setr_epi16(
+		1<<0, 1<<2, 1<<4, 1<<6, 1<<8, 1<<10, 1<<12, 1<<14,
+		1<<0, 1<<2, 1<<4, 1<<6, 1<<8, 1<<10, 1<<12, 1<<14);
+	const __m256i mask_hi = _mm256_slli_epi16(mask_lo, 1);
+	const __m256i four = _mm256_set1_epi16(4);
+	const __m256i eight = _mm256_set1_epi16(8);
+
+	// Broadcast the low and high 16 bits of each block's indexes.
+	const __m256i idx = _mm256_setr_epi32(idxA, idxA, idxA, idxA, idxB, idxB, idxB, idxB);
+	const __m256i idx0 = _mm256_shuffle_epi8(idx, _mm256_setr_epi8(
+		0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1,
+		0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1));
+	const __m256i idx1 = _mm256_shuffle_epi8(idx, _mm256_setr_epi8(
+		2,3, 2,3, 2,3, 2,3, 2,3, 2,3, 2,3, 2,3,
+		2,3, 2,3, 2,3, 2,3, 2,3, 2,3, 2,3, 2,3));
+
+	const __m256i px0 = _mm256_or_si256(
+		_mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(idx0, mask_lo), mask_lo), four),
+		_mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(idx0, mask_hi), mask_hi), eight));
+	const __m256i px1 = _mm256_or_si256(
+		_mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(idx1, mask_lo), mask_lo), four),
+		_mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(idx1, mask_hi), mask_hi), eight));
+	return _mm256_packus_epi16(px0, px1);
+}
+
+/**
+ * Expand the DXT5 alpha codes of two blocks to palette indexes.
+ * @param alphaA	[in] First DXT5 alpha block.
+ * @param alphaB	[in] Second DXT5 alpha block.
+ * @return 16 bytes per 128-bit lane, one per pixel, containing the 3-bit alpha code.
+ */
+static FORCEINLINE __m256i expand_DXT5_alpha_codes_x2_avx2(
+	const uint8_t *RESTRICT alphaA, const uint8_t *RESTRICT alphaB)
+{
+	// Each 3-bit code is contained within a pair of bytes.
+	// Codes start at byte 2; bytes past the end of the block are zero.
+	const __m256i shuf_lo = _mm256_setr_epi8(
+		2,3, 2,3, 2,3, 3,4, 3,4, 3,4, 4,5, 4,5,
+		2,3, 2,3, 2,3, 3,4, 3,4, 3,4, 4,5, 4,5);
+	const __m256i shuf_hi = _mm256_setr_epi8(
+		5,6, 5,6, 5,6, 6,7, 6,7, 6,7, 7,8, 7,8,
+		5,6, 5,6, 5,6, 6,7, 6,7, 6,7, 7,8, 7,8);
+	// Shift each code into bits 13-15. (Bit offsets: 0,3,6,1,4,7,2,5)
+	const __m256i mul = _mm256_setr_epi16(
+		1<<13, 1<<10, 1<<7, 1<<12, 1<<9, 1<<6, 1<<11, 1<<8,
+		1<<13, 1<<10, 1<<7, 1<<12, 1<<9, 1<<6, 1<<11, 1<<8);
+
+	const __m256i codes = combine_m128i(
+		_mm_loadl_epi64(reinterpret_cast<const __m128i*>(alphaA)),
+		_mm_loadl_epi64(reinterpret_cast<const __m128i*>(alphaB)));
+	const __m256i px0 = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(codes, shuf_lo), mul), 13);
+	const __m256i px1 = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(codes, shuf_hi), mul), 13);
+	return _mm256_packus_epi16(px0, px1);
+}
+
+/**
+ * Write two decoded DXTn tiles directly to the destination image.
+ * @tparam single	[in] If true, only write the first tile.
+ * @param px_dest	[out] First pixel of the first tile in the destination image.
+ * @param stride_px	[in] Destination stride, in pixels.
+ * @param pal		[in] Palettes. (from decode_DXTn_tile_color_palette_x2_avx2())
+ * @param pal_idx	[in] Palette byte offsets. (from expand_DXT1_indexes_x2_avx2())
+ * @param alpha		[in] Alpha values, or zero if the palette already has alpha.
+ */
+template<bool single>
+static FORCEINLINE void write_DXTn_tiles_x2_avx2(uint32_t *RESTRICT px_dest, int stride_px,
+	__m256i pal, __m256i pal_idx, __m256i alpha)
+{
+	const __m256i four = _mm256_set1_epi8(4);
+	// Broadcast each pixel's byte offset to all four channels.
+	__m256i rowsel = _mm256_setr_epi8(
+		0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3,
+		0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3);
+	// NOTE: -128 (0x80) zeroes the byte.
+	__m256i alphasel = _mm256_setr_epi8(
+		-128,-128,-128,0, -128,-128,-128,1, -128,-128,-128,2, -128,-128,-128,3,
+		-128,-128,-128,0, -128,-128,-128,1, -128,-128,-128,2, -128,-128,-128,3);
+	const __m256i chan = _mm256_setr_epi8(
+		0,1,2,3, 0,1,2,3, 0,1,2,3, 0,1,2,3,
+		0,1,2,3, 0,1,2,3, 0,1,2,3, 0,1,2,3);
+
+	for (unsigned int row = 4; row > 0; row--, px_dest += stride_px) {
+		const __m256i ctrl = _mm256_add_epi8(_mm256_shuffle_epi8(pal_idx, rowsel), chan);
+		const __m256i px = _mm256_or_si256(_mm256_shuffle_epi8(pal, ctrl),
+			_mm256_shuffle_epi8(alpha, alphasel));
+		if (single) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(px_dest), _mm256_castsi256_si128(px));
+		} else {
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(px_dest), px);
+		}
+
+		// NOTE: Adding 4 to 0x80 results in 0x84, which is still zeroed by pshufb.
+		rowsel = _mm256_add_epi8(rowsel, four);
+		alphasel = _mm256_add_epi8(alphasel, four);
+	}
+}
+
+/**
+ * Decode two DXT1 tiles directly to the destination image.
+ * @tparam palflags	[in] decode_DXTn_tile_color_palette_x2_avx2<>() flags.
+ * @tparam single	[in] If true, only write the first tile.
+ * @param px_dest	[out] First pixel of the first tile in the destination image.
+ * @param stride_px	[in] Destination stride, in pixels.
+ * @param srcA		[in] First DXT1 block.
+ * @param srcB		[in] Second DXT1 block.
+ */
+template<unsigned int palflags, bool single>
+static FORCEINLINE void decode_DXT1_tiles_x2_avx2(uint32_t *RESTRICT px_dest, int stride_px,
+	const dxt1_block *RESTRICT srcA, const dxt1_block *RESTRICT srcB)
+{
+	const __m256i pal = decode_DXTn_tile_color_palette_x2_avx2<palflags>(srcA, srcB);
+	const __m256i pal_idx = expand_DXT1_indexes_x2_avx2(
+		le32_to_cpu(srcA->indexes), le32_to_cpu(srcB->indexes));
+	write_DXTn_tiles_x2_avx2<single>(px_dest, stride_px, pal, pal_idx, _mm256_setzero_si256());
+}
+
+/**
+ * Decode two DXT5 tiles directly to the destination image.
+ * @tparam single	[in] If true, only write the first tile.
+ * @param px_dest	[out] First pixel of the first tile in the destination image.
+ * @param stride_px	[in] Destination stride, in pixels.
+ * @param srcA		[in] First DXT5 block.
+ * @param srcB		[in] Second DXT5 block.
+ */
+template<bool single>
+static FORCEINLINE void decode_DXT5_tiles_x2_avx2(uint32_t *RESTRICT px_dest, int stride_px,
+	const dxt5_block *RESTRICT srcA, const dxt5_block *RESTRICT srcB)
+{
+	// Decode the DXT5 tile palettes, with the alpha channel cleared.
+	__m256i pal = decode_DXTn_tile_color_palette_x2_avx2<0>(&srcA->colors, &srcB->colors);
+	pal = _mm256_and_si256(pal, _mm256_set1_epi32(0x00FFFFFF));
+	const __m256i pal_idx = expand_DXT1_indexes_x2_avx2(
+		le32_to_cpu(srcA->colors.indexes), le32_to_cpu(srcB->colors.indexes));
+
+	// Decode the 16 alpha values for each tile.
+	const __m256i alpha = _mm256_shuffle_epi8(
+		decode_DXT5_alpha_palette_x2_avx2(srcA->alpha, srcB->alpha),
+		expand_DXT5_alpha_codes_x2_avx2(srcA->alpha, srcB->alpha));
+
+	write_DXTn_tiles_x2_avx2<single>(px_dest, stride_px, pal, pal_idx, alpha);
+}
+
+/**
+ * Convert a DXT1 image to rp_image. (AVX2 version)
+ * @param palflags decode_DXTn_tile_color_palette_x2_avx2<>() flags.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+template<unsigned int palflags>
+static rp_image *T_fromDXT1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+
+	// DXT1 uses 4x4 tiles, but some container formats allow
+	// the last tile to be cut off, so round up for the
+	// physical tile size.
+	const int physWidth = ALIGN_BYTES(4, width);
+	const int physHeight = ALIGN_BYTES(4, height);
+
+	assert(img_siz >= (((size_t)physWidth * (size_t)physHeight) / 2));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < (((size_t)physWidth * (size_t)physHeight) / 2))
+	{
+		return nullptr;
+	}
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(physWidth, physHeight, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+
+	// Calculate the total number of tiles.
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *const bits = static_cast<uint32_t*>(img->bits());
+
+	// Tiles are decoded directly into the destination image.
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const dxt1_block *dxt1_src = reinterpret_cast<const dxt1_block*>(img_buf) + (y * tilesX);
+		uint32_t *px_dest = bits + (y * 4 * stride_px);
+		int x = tilesX;
+		for (; x > 1; x -= 2, dxt1_src += 2, px_dest += 8) {
+			decode_DXT1_tiles_x2_avx2<palflags, false>(px_dest, stride_px, &dxt1_src[0], &dxt1_src[1]);
+		}
+		if (x > 0) {
+			// Remaining tile.
+			decode_DXT1_tiles_x2_avx2<palflags, true>(px_dest, stride_px, dxt1_src, dxt1_src);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
+
+	if (width < physWidth || height < physHeight) {
+		// Shrink the image.
+		img->shrink(width, height);
+	}
+
+	// Set the sBIT metadata.
+	static const rp_image::sBIT_t sBIT = {8,8,8,0,1};
+	img->set_sBIT(&sBIT);
+
+	// Image has been converted.
+	return img;
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * AVX2-optimized version.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromDXT1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	return T_fromDXT1_avx2<0>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * AVX2-optimized version.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromDXT1_A1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	return T_fromDXT1_avx2<DXTn_PALETTE_COLOR3_ALPHA>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT5 image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromDXT5_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+
+	// DXT5 uses 4x4 tiles, but some container formats allow
+	// the last tile to be cut off, so round up for the
+	// physical tile size.
+	const int physWidth = ALIGN_BYTES(4, width);
+	const int physHeight = ALIGN_BYTES(4, height);
+
+	assert(img_siz >= ((size_t)physWidth * (size_t)physHeight));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < ((size_t)physWidth * (size_t)physHeight))
+	{
+		return nullptr;
+	}
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(physWidth, physHeight, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+
+	// Calculate the total number of tiles.
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *const bits = static_cast<uint32_t*>(img->bits());
+
+	// Tiles are decoded directly into the destination image.
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const dxt5_block *dxt5_src = reinterpret_cast<const dxt5_block*>(img_buf) + (y * tilesX);
+		uint32_t *px_dest = bits + (y * 4 * stride_px);
+		int x = tilesX;
+		for (; x > 1; x -= 2, dxt5_src += 2, px_dest += 8) {
+			decode_DXT5_tiles_x2_avx2<false>(px_dest, stride_px, &dxt5_src[0], &dxt5_src[1]);
+		}
+		if (x > 0) {
+			// Remaining tile.
+			decode_DXT5_tiles_x2_avx2<true>(px_dest, stride_px, dxt5_src, dxt5_src);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
+
+	if (width < physWidth || height < physHeight) {
+		// Shrink the image.
+		img->shrink(width, height);
+	}
+
+	// Set the sBIT metadata.
+	static const rp_image::sBIT_t sBIT = {8,8,8,0,8};
+	img->set_sBIT(&sBIT);
+
+	// Image has been converted.
+	return img;
+}
+
+} }
+
+#ifdef _MSC_VER
+#  pragma warning(pop)
+#endif
@@ -0,0 +1,381 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture)                     *
+ * ImageDecoder_S3TC_sse41.cpp: Image decoding functions: S3TC             *
+ * SSE4.1-optimized version.                                               *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+
+#include "ImageDecoder_S3TC.hpp"
+#include "ImageDecoder_p.hpp"
+
+#include "PixelConversion.hpp"
+using namespace LibRpTexture::PixelConversion;
+
+// SSE4.1 intrinsics
+#include <smmintrin.h>
+
+// MSVC complains when the high bit is set in hex values
+// when setting SSE2 registers.
+#ifdef _MSC_VER
+#  pragma warning(push)
+#  pragma warning(disable: 4309)
+#endif
+
+namespace LibRpTexture { namespace ImageDecoder {
+
+// DXT1 block format.
+// NOTE: Same layout as in ImageDecoder_S3TC.cpp.
+struct dxt1_block {
+	uint16_t color[2];	// Colors 0 and 1, in RGB565 format.
+	uint32_t indexes;	// Two-bit color indexes.
+};
+ASSERT_STRUCT(dxt1_block, 8);
+
+// DXT5 block format.
+struct dxt5_block {
+	uint8_t alpha[8];	// Alpha values (2) and 3-bit alpha codes (48-bit)
+	dxt1_block colors;	// DXT1-style color block.
+};
+ASSERT_STRUCT(dxt5_block, 16);
+
+// decode_DXTn_tile_color_palette flags.
+// NOTE: Same values as in ImageDecoder_S3TC.cpp.
+enum DXTn_Palette_Flags {
+	DXTn_PALETTE_COLOR3_ALPHA	= (1U << 1),	// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+};
+
+/**
+ * Decode a DXTn tile color palette. (SSE4.1 version)
+ * @tparam flags Flags. (See DXTn_Palette_Flags)
+ * @param dxt1_src	[in] DXT1 block.
+ * @return Four ARGB32 palette entries.
+ */
+template<unsigned int flags>
+static FORCEINLINE __m128i decode_DXTn_tile_color_palette_sse41(const dxt1_block *RESTRICT dxt1_src)
+{
+	// Convert the first two colors from RGB565,
+	// then expand them to 16-bit channels.
+	const uint16_t c0 = le16_to_cpu(dxt1_src->color[0]);
+	const uint16_t c1 = le16_to_cpu(dxt1_src->color[1]);
+	const __m128i p01 = _mm_cvtepu8_epi16(_mm_set_epi32(0, 0,
+		RGB565_to_ARGB32(c1), RGB565_to_ARGB32(c0)));
+	const __m128i p10 = _mm_shuffle_epi32(p01, _MM_SHUFFLE(1,0,3,2));
+
+	// color0 > color1: Colors 2 and 3 are 2/3 and 1/3 interpolations.
+	// NOTE: x / 3 == (x * 0xAAAB) >> 17 for all x < 2^17.
+	__m128i p23_gt = _mm_add_epi16(_mm_add_epi16(p01, p01), p10);
+	p23_gt = _mm_srli_epi16(_mm_mulhi_epu16(p23_gt, _mm_set1_epi16(static_cast<short>(0xAAAB))), 1);
+
+	// color0 <= color1: Color 2 is the average; color 3 is black and/or transparent.
+	__m128i p23_le = _mm_srli_epi16(_mm_add_epi16(p01, p10), 1);
+	p23_le = _mm_blend_epi16(p23_le, (flags & DXTn_PALETTE_COLOR3_ALPHA)
+		? _mm_setzero_si128()
+		: _mm_setr_epi16(0,0,0,0, 0,0,0,0xFF), 0xF0);
+
+	const __m128i p23 = _mm_blendv_epi8(p23_le, p23_gt, _mm_set1_epi16((c0 > c1) ? -1 : 0));
+	return _mm_packus_epi16(p01, p23);
+}
+
+/**
+ * Decode a DXT5 alpha palette. (SSE4.1 version)
+ * @param alpha	[in] DXT5 alpha block.
+ * @return Eight alpha values in the low 8 bytes.
+ */
+static FORCEINLINE __m128i decode_DXT5_alpha_palette_sse41(const uint8_t *RESTRICT alpha)
+{
+	const __m128i a0 = _mm_set1_epi16(alpha[0]);
+	const __m128i a1 = _mm_set1_epi16(alpha[1]);
+
+	// alpha0 > alpha1: Six interpolated values, in 1/7ths.
+	// Colors 0 and 1 are multiplied by 7 so they can use the same division.
+	// NOTE: x / 7 == (x * 9363) >> 16 for all x <= 7*255.
+	__m128i pal_gt = _mm_add_epi16(
+		_mm_mullo_epi16(a0, _mm_setr_epi16(7,0,6,5,4,3,2,1)),
+		_mm_mullo_epi16(a1, _mm_setr_epi16(0,7,1,2,3,4,5,6)));
+	pal_gt = _mm_mulhi_epu16(pal_gt, _mm_set1_epi16(9363));
+
+	// alpha0 <= alpha1: Four interpolated values, in 1/5ths, then 0 and 255.
+	// NOTE: x / 5 == (x * 13108) >> 16 for all x <= 5*255.
+	__m128i pal_le = _mm_add_epi16(
+		_mm_mullo_epi16(a0, _mm_setr_epi16(5,0,4,3,2,1,0,0)),
+		_mm_mullo_epi16(a1, _mm_setr_epi16(0,5,1,2,3,4,0,0)));
+	pal_le = _mm_mulhi_epu16(pal_le, _mm_set1_epi16(13108));
+	pal_le = _mm_blend_epi16(pal_le, _mm_setr_epi16(0,0,0,0, 0,0,0,0xFF), 0xC0);
+
+	const __m128i pal = _mm_blendv_epi8(pal_le, pal_gt,
+		_mm_set1_epi16((alpha[0] > alpha[1]) ? -1 : 0));
+	return _mm_packus_epi16(pal, pal);
+}
+
+/**
+ * Expand the 16 DXT1 color indexes to palette byte offsets.
+ * @param indexes Two-bit color indexes. (host-endian)
+ * @return 16 bytes, one per pixel, containing (index * 4).
+ */
+static FORCEINLINE __m128i expand_DXT1_indexes_sse41(uint32_t indexes)
+{
+	// Each 16-bit lane tests the two bits for one pixel.
+	const __m128i mask_lo = _mm_setr_epi16(1<<0, 1<<2, 1<<4, 1<<6, 1<<8, 1<<10, 1<<12, 1<<14);
+	const __m128i mask_hi = _mm_slli_epi16(mask_lo, 1);
+	const __m128i four = _mm_set1_epi16(4);
+	const __m128i eight = _mm_set1_epi16(8);
+
+	const __m128i idx0 = _mm_set1_epi16(static_cast<int16_t>(indexes & 0xFFFF));
+	const __m128i idx1 = _mm_set1_epi16(static_cast<int16_t>(indexes >> 16));
+
+	const __m128i px0 = _mm_or_si128(
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(idx0, mask_lo), mask_lo), four),
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(idx0, mask_hi), mask_hi), eight));
+	const __m128i px1 = _mm_or_si128(
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(idx1, mask_lo), mask_lo), four),
+		_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(idx1, mask_hi), mask_hi), eight));
+	return _mm_packus_epi16(px0, px1);
+}
+
+/**
+ * Expand the 16 DXT5 alpha codes to palette indexes.
+ * @param alpha	[in] DXT5 alpha block.
+ * @return 16 bytes, one per pixel, containing the 3-bit alpha code.
+ */
+static FORCEINLINE __m128i expand_DXT5_alpha_codes_sse41(const uint8_t *RESTRICT alpha)
+{
+	// Each 3-bit code is contained within a pair of bytes.
+	// Codes start at byte 2; bytes past the end of the block are zero.
+	const __m128i shuf_lo = _mm_setr_epi8(2,3, 2,3, 2,3, 3,4, 3,4, 3,4, 4,5, 4,5);
+	const __m128i shuf_hi = _mm_setr_epi8(5,6, 5,6, 5,6, 6,7, 6,7, 6,7, 7,8, 7,8);
+	// Shift each code into bits 13-15. (Bit offsets: 0,3,6,1,4,7,2,5)
+	const __m128i mul = _mm_setr_epi16(1<<13, 1<<10, 1<<7, 1<<12, 1<<9, 1<<6, 1<<11, 1<<8);
+
+	const __m128i codes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(alpha));
+	const __m128i px0 = _mm_srli_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(codes, shuf_lo), mul), 13);
+	const __m128i px1 = _mm_srli_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(codes, shuf_hi), mul), 13);
+	return _mm_packus_epi16(px0, px1);
+}
+
+/**
+ * Write a decoded DXTn tile directly to the destination image.
+ * @param px_dest	[out] First pixel of the tile in the destination image.
+ * @param stride_px	[in] Destination stride, in pixels.
+ * @param pal		[in] Four ARGB32 palette entries.
+ * @param pal_idx	[in] Palette byte offsets, one per pixel. (from expand_DXT1_indexes_sse41())
+ */
+static FORCEINLINE void write_DXTn_tile_sse41(uint32_t *RESTRICT px_dest, int stride_px,
+	__m128i pal, __m128i pal_idx)
+{
+	const __m128i four = _mm_set1_epi8(4);
+	// Broadcast each pixel's byte offset to all four channels.
+	__m128i rowsel = _mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3);
+	const __m128i chan = _mm_setr_epi8(0,1,2,3, 0,1,2,3, 0,1,2,3, 0,1,2,3);
+
+	for (unsigned int row = 4; row > 0; row--, px_dest += stride_px) {
+		const __m128i ctrl = _mm_add_epi8(_mm_shuffle_epi8(pal_idx, rowsel), chan);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(px_dest), _mm_shuffle_epi8(pal, ctrl));
+		rowsel = _mm_add_epi8(rowsel, four);
+	}
+}
+
+/**
+ * Convert a DXT1 image to rp_image. (SSE4.1 version)
+ * @param palflags decode_DXTn_tile_color_palette_sse41<>() flags.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+template<unsigned int palflags>
+static rp_image *T_fromDXT1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+
+	// DXT1 uses 4x4 tiles, but some container formats allow
+	// the last tile to be cut off, so round up for the
+	// physical tile size.
+	const int physWidth = ALIGN_BYTES(4, width);
+	const int physHeight = ALIGN_BYTES(4, height);
+
+	assert(img_siz >= (((size_t)physWidth * (size_t)physHeight) / 2));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < (((size_t)physWidth * (size_t)physHeight) / 2))
+	{
+		return nullptr;
+	}
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(physWidth, physHeight, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+
+	// Calculate the total number of tiles.
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *const bits = static_cast<uint32_t*>(img->bits());
+
+	// Tiles are decoded directly into the destination image.
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const dxt1_block *dxt1_src = reinterpret_cast<const dxt1_block*>(img_buf) + (y * tilesX);
+		uint32_t *px_dest = bits + (y * 4 * stride_px);
+		for (int x = 0; x < tilesX; x++, dxt1_src++, px_dest += 4) {
+			const __m128i pal = decode_DXTn_tile_color_palette_sse41<palflags>(dxt1_src);
+			const __m128i pal_idx = expand_DXT1_indexes_sse41(le32_to_cpu(dxt1_src->indexes));
+			write_DXTn_tile_sse41(px_dest, stride_px, pal, pal_idx);
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
+
+	if (width < physWidth || height < physHeight) {
+		// Shrink the image.
+		img->shrink(width, height);
+	}
+
+	// Set the sBIT metadata.
+	static const rp_image::sBIT_t sBIT = {8,8,8,0,1};
+	img->set_sBIT(&sBIT);
+
+	// Image has been converted.
+	return img;
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * SSE4.1-optimized version.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromDXT1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	return T_fromDXT1_sse41<0>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * SSE4.1-optimized version.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromDXT1_A1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	return T_fromDXT1_sse41<DXTn_PALETTE_COLOR3_ALPHA>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT5 image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *fromDXT5_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+{
+	// Verify parameters.
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+
+	// DXT5 uses 4x4 tiles, but some container formats allow
+	// the last tile to be cut off, so round up for the
+	// physical tile size.
+	const int physWidth = ALIGN_BYTES(4, width);
+	const int physHeight = ALIGN_BYTES(4, height);
+
+	assert(img_siz >= ((size_t)physWidth * (size_t)physHeight));
+	if (!img_buf || width <= 0 || height <= 0 ||
+	    img_siz < ((size_t)physWidth * (size_t)physHeight))
+	{
+		return nullptr;
+	}
+
+	// Create an rp_image.
+	rp_image *const img = new rp_image(physWidth, physHeight, rp_image::Format::ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		img->unref();
+		return nullptr;
+	}
+
+	// Calculate the total number of tiles.
+	const int tilesX = physWidth / 4;
+	const int tilesY = physHeight / 4;
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *const bits = static_cast<uint32_t*>(img->bits());
+
+	// Tiles are decoded directly into the destination image.
+	LibRpThreads::parallel_for(0, tilesY, [&](int y) {
+		const dxt5_block *dxt5_src = reinterpret_cast<const dxt5_block*>(img_buf) + (y * tilesX);
+		uint32_t *px_dest = bits + (y * 4 * stride_px);
+		for (int x = 0; x < tilesX; x++, dxt5_src++, px_dest += 4) {
+			// Decode the DXT5 tile palette, with the alpha channel cleared.
+			__m128i pal = decode_DXTn_tile_color_palette_sse41<0>(&dxt5_src->colors);
+			pal = _mm_and_si128(pal, _mm_set1_epi32(0x00FFFFFF));
+			const __m128i pal_idx = expand_DXT1_indexes_sse41(le32_to_cpu(dxt5_src->colors.indexes));
+
+			// Decode the 16 alpha values.
+			const __m128i alpha = _mm_shuffle_epi8(
+				decode_DXT5_alpha_palette_sse41(dxt5_src->alpha),
+				expand_DXT5_alpha_codes_sse41(dxt5_src->alpha));
+
+			// Move each alpha value into the alpha channel of its pixel.
+			const __m128i four = _mm_set1_epi8(4);
+			__m128i rowsel = _mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3);
+			// NOTE: -128 (0x80) zeroes the byte.
+			__m128i alphasel = _mm_setr_epi8(-128,-128,-128,0, -128,-128,-128,1, -128,-128,-128,2, -128,-128,-128,3);
+			const __m128i chan = _mm_setr_epi8(0,1,2,3, 0,1,2,3, 0,1,2,3, 0,1,2,3);
+
+			uint32_t *px_row = px_dest;
+			for (unsigned int row = 4; row > 0; row--, px_row += stride_px) {
+				const __m128i ctrl = _mm_add_epi8(_mm_shuffle_epi8(pal_idx, rowsel), chan);
+				const __m128i px = _mm_or_si128(_mm_shuffle_epi8(pal, ctrl),
+					_mm_shuffle_epi8(alpha, alphasel));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(px_row), px);
+
+				// NOTE: Adding 4 to 0x80 results in 0x84, which is still zeroed by pshufb.
+				rowsel = _mm_add_epi8(rowsel, four);
+				alphasel = _mm_add_epi8(alphasel, four);
+			}
+		}
+	}, physWidth * physHeight >= ImageDecoderPrivate::MT_MIN_PIXELS);
+
+	if (width < physWidth || height < physHeight) {
+		// Shrink the image.
+		img->shrink(width, height);
+	}
+
+	// Set the sBIT metadata.
+	static const rp_image::sBIT_t sBIT = {8,8,8,0,8};
+	img->set_sBIT(&sBIT);
+
+	// Image has been converted.
+	return img;
+}
+
+} }
+
+#ifdef _MSC_VER
+#  pragma warning(pop)
+#endif
@@ -23,6 +23,11 @@
 #  include "librpcpu/cpuflags_x86.h"
 #  define IMAGEDECODER_HAS_SSE2 1
 #  define IMAGEDECODER_HAS_SSSE3 1
+#  define IMAGEDECODER_HAS_SSE41 1
+/* AVX2 intrinsics require MSVC 2013 or later. */
+#  if !defined(_MSC_VER) || _MSC_VER >= 1800
+#    define IMAGEDECODER_HAS_AVX2 1
+#  endif
 #endif
 #ifdef RP_CPU_AMD64
 #  define IMAGEDECODER_ALWAYS_HAS_SSE2 1
@@ -2,7 +2,7 @@
  * ROM Properties Page shell extension. (librptexture)                     *
  * ImageDecoder_ifunc.cpp: ImageDecoder IFUNC resolution functions.        *
  *                                                                         *
- * Copyright (c) 2016-2022 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -11,6 +11,8 @@
 #ifdef HAVE_IFUNC
 
 #include "ImageDecoder_Linear.hpp"
+#include "ImageDecoder_S3TC.hpp"
+#include "ImageDecoder_ETC1.hpp"
 using namespace LibRpTexture;
 
 // NOTE: llvm/clang 14.0.0 fails to detect the resolver functions
@@ -21,7 +23,7 @@ using namespace LibRpTexture;
 // IFUNC attribute doesn't support C++ name mangling.
 extern "C" {
 
-#ifndef IMAGEDECODER_ALWAYS_HAS_SSE2
+#if !defined(IMAGEDECODER_ALWAYS_HAS_SSE2) || defined(IMAGEDECODER_HAS_AVX2)
 /**
  * IFUNC resolver function for fromLinear16().
  * @return Function pointer.
@@ -32,17 +34,30 @@ __typeof__(&ImageDecoder::fromLinear16_cpp) fromLinear16_resolve(void)
 	// cannot call PLT functions. Otherwise, it will crash.
 	// We'll use gcc's built-in CPU ID functions instead.
 	// Requires gcc-4.8 or later, or clang-6.0 or later.
-#ifdef IMAGEDECODER_HAS_SSE2
+#if defined(IMAGEDECODER_HAS_AVX2) || defined(IMAGEDECODER_HAS_SSE2)
 	__builtin_cpu_init();
+#endif
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &ImageDecoder::fromLinear16_avx2;
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_ALWAYS_HAS_SSE2
+	{
+		return &ImageDecoder::fromLinear16_sse2;
+	}
+#else /* !IMAGEDECODER_ALWAYS_HAS_SSE2 */
+#  ifdef IMAGEDECODER_HAS_SSE2
 	if (__builtin_cpu_supports("sse2")) {
 		return &ImageDecoder::fromLinear16_sse2;
 	} else
-#endif /* IMAGEDECODER_HAS_SSE2 */
+#  endif /* IMAGEDECODER_HAS_SSE2 */
 	{
 		return &ImageDecoder::fromLinear16_cpp;
 	}
-}
 #endif /* IMAGEDECODER_ALWAYS_HAS_SSE2 */
+}
+#endif /* !IMAGEDECODER_ALWAYS_HAS_SSE2 || IMAGEDECODER_HAS_AVX2 */
 
 /**
  * IFUNC resolver function for fromLinear24().
@@ -50,8 +65,15 @@ __typeof__(&ImageDecoder::fromLinear16_cpp) fromLinear16_resolve(void)
  */
 __typeof__(&ImageDecoder::fromLinear24_cpp) fromLinear24_resolve(void)
 {
-#ifdef IMAGEDECODER_HAS_SSSE3
+#if defined(IMAGEDECODER_HAS_AVX2) || defined(IMAGEDECODER_HAS_SSSE3)
 	__builtin_cpu_init();
+#endif
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &ImageDecoder::fromLinear24_avx2;
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
 	if (__builtin_cpu_supports("ssse3")) {
 		return &ImageDecoder::fromLinear24_ssse3;
 	} else
@@ -67,8 +89,16 @@ __typeof__(&ImageDecoder::fromLinear24_cpp) fromLinear24_resolve(void)
  */
 __typeof__(&ImageDecoder::fromLinear32_cpp) fromLinear32_resolve(void)
 {
+#if defined(IMAGEDECODER_HAS_AVX2) || defined(IMAGEDECODER_HAS_SSSE3)
+	__builtin_cpu_init();
+#endif
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &ImageDecoder::fromLinear32_avx2;
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
 #ifdef IMAGEDECODER_HAS_SSSE3
-	if (RP_CPU_HasSSSE3()) {
+	if (__builtin_cpu_supports("ssse3")) {
 		return &ImageDecoder::fromLinear32_ssse3;
 	} else
 #endif /* IMAGEDECODER_HAS_SSSE3 */
@@ -77,14 +107,97 @@ __typeof__(&ImageDecoder::fromLinear32_cpp) fromLinear32_resolve(void)
 	}
 }
 
+/**
+ * IFUNC resolver function for fromDXT1().
+ * @return Function pointer.
+ */
+__typeof__(&ImageDecoder::fromDXT1_cpp) fromDXT1_resolve(void)
+{
+	__builtin_cpu_init();
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &ImageDecoder::fromDXT1_avx2;
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (__builtin_cpu_supports("sse4.1")) {
+		return &ImageDecoder::fromDXT1_sse41;
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return &ImageDecoder::fromDXT1_cpp;
+	}
+}
+
+/**
+ * IFUNC resolver function for fromDXT1_A1().
+ * @return Function pointer.
+ */
+__typeof__(&ImageDecoder::fromDXT1_A1_cpp) fromDXT1_A1_resolve(void)
+{
+	__builtin_cpu_init();
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &ImageDecoder::fromDXT1_A1_avx2;
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (__builtin_cpu_supports("sse4.1")) {
+		return &ImageDecoder::fromDXT1_A1_sse41;
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return &ImageDecoder::fromDXT1_A1_cpp;
+	}
+}
+
+/**
+ * IFUNC resolver function for fromDXT5().
+ * @return Function pointer.
+ */
+__typeof__(&ImageDecoder::fromDXT5_cpp) fromDXT5_resolve(void)
+{
+	__builtin_cpu_init();
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (__builtin_cpu_supports("avx2")) {
+		return &ImageDecoder::fromDXT5_avx2;
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (__builtin_cpu_supports("sse4.1")) {
+		return &ImageDecoder::fromDXT5_sse41;
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return &ImageDecoder::fromDXT5_cpp;
+	}
+}
+
+/**
+ * IFUNC resolver function for fromETC1().
+ * @return Function pointer.
+ */
+__typeof__(&ImageDecoder::fromETC1_cpp) fromETC1_resolve(void)
+{
+	__builtin_cpu_init();
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (__builtin_cpu_supports("sse4.1")) {
+		return &ImageDecoder::fromETC1_sse41;
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return &ImageDecoder::fromETC1_cpp;
+	}
 }
 
-#ifndef IMAGEDECODER_ALWAYS_HAS_SSE2
+}
+
+#if !defined(IMAGEDECODER_ALWAYS_HAS_SSE2) || defined(IMAGEDECODER_HAS_AVX2)
 rp_image *ImageDecoder::fromLinear16(PixelFormat px_format,
 	int width, int height,
 	const uint16_t *img_buf, size_t img_siz, int stride)
 	IFUNC_ATTR(fromLinear16_resolve);
-#endif /* IMAGEDECODER_ALWAYS_HAS_SSE2 */
+#endif /* !IMAGEDECODER_ALWAYS_HAS_SSE2 || IMAGEDECODER_HAS_AVX2 */
 
 rp_image *ImageDecoder::fromLinear24(PixelFormat px_format,
 	int width, int height,
@@ -96,4 +209,20 @@ rp_image *ImageDecoder::fromLinear32(PixelFormat px_format,
 	const uint32_t *img_buf, size_t img_siz, int stride)
 	IFUNC_ATTR(fromLinear32_resolve);
 
+rp_image *ImageDecoder::fromDXT1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+	IFUNC_ATTR(fromDXT1_resolve);
+
+rp_image *ImageDecoder::fromDXT1_A1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+	IFUNC_ATTR(fromDXT1_A1_resolve);
+
+rp_image *ImageDecoder::fromDXT5(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+	IFUNC_ATTR(fromDXT5_resolve);
+
+rp_image *ImageDecoder::fromETC1(int width, int height,
+	const uint8_t *RESTRICT img_buf, size_t img_siz)
+	IFUNC_ATTR(fromETC1_resolve);
+
 #endif /* HAVE_IFUNC */
@@ -11,6 +11,9 @@
 #include "common.h"
 #include "../img/rp_image.hpp"
 
+// librpthreads
+#include "librpthreads/ThreadPool.hpp"
+
 // C includes. (C++ namespace)
 #include <cassert>
 #include <cstring>
@@ -20,6 +23,13 @@
 
 namespace LibRpTexture { namespace ImageDecoderPrivate {
 
+/**
+ * Minimum image size, in pixels, for multi-threaded decoding.
+ * Smaller images, e.g. 32x32 icons, are decoded on the calling
+ * thread, since the threading overhead would exceed the decoding time.
+ */
+static const int MT_MIN_PIXELS = 128*128;
+
 /**
  * Blit a tile to an rp_image. (pixel*)
  * NOTE: No bounds checking is done.
@@ -22,6 +22,9 @@
 #  define RP_IMAGE_HAS_SSE2 1
 #  define RP_IMAGE_HAS_SSSE3 1
 #  define RP_IMAGE_HAS_SSE41 1
+#  if !defined(_MSC_VER) || _MSC_VER >= 1800
+#    define RP_IMAGE_HAS_AVX2 1
+#  endif
 #endif
 #ifdef RP_CPU_AMD64
 #  define RP_IMAGE_ALWAYS_HAS_SSE2 1
@@ -413,6 +416,19 @@ class rp_image : public RefBase
 		int un_premultiply_sse41(void);
 #endif /* RP_IMAGE_HAS_SSE41 */
 
+#ifdef RP_IMAGE_HAS_AVX2
+		/**
+		 * Un-premultiply this image.
+		 * AVX2-optimized version.
+		 *
+		 * Image must be ARGB32.
+		 *
+		 * @return 0 on success; non-zero on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int un_premultiply_avx2(void);
+#endif /* RP_IMAGE_HAS_AVX2 */
+
 		/**
 		 * Un-premultiply this image.
 		 *
@@ -440,6 +456,54 @@ class rp_image : public RefBase
 		RP_LIBROMDATA_PUBLIC
 		int premultiply(void);
 
+		/**
+		 * Copy this image to an ARGB32 buffer, premultiplying each pixel.
+		 * Standard version using regular C++ code.
+		 *
+		 * Image must be ARGB32. The destination buffer must have
+		 * the same width and height as this image, and may be
+		 * this image's own buffer.
+		 *
+		 * @param dest		[out] Destination buffer
+		 * @param dest_stride	[in] Destination stride, in bytes
+		 * @return 0 on success; non-zero on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int premultiply_to_cpp(uint32_t *dest, int dest_stride) const;
+
+#ifdef RP_IMAGE_HAS_SSE2
+		/**
+		 * Copy this image to an ARGB32 buffer, premultiplying each pixel.
+		 * SSE2-optimized version.
+		 *
+		 * Image must be ARGB32. The destination buffer must have
+		 * the same width and height as this image, and may be
+		 * this image's own buffer.
+		 *
+		 * @param dest		[out] Destination buffer
+		 * @param dest_stride	[in] Destination stride, in bytes
+		 * @return 0 on success; non-zero on error.
+		 */
+		RP_LIBROMDATA_PUBLIC
+		int premultiply_to_sse2(uint32_t *dest, int dest_stride) const;
+#endif /* RP_IMAGE_HAS_SSE2 */
+
+		/**
+		 * Copy this image to an ARGB32 buffer, premultiplying each pixel.
+		 *
+		 * This is equivalent to dup() followed by premultiply() and
+		 * a copy, but it only reads and writes each pixel once.
+		 *
+		 * Image must be ARGB32. The destination buffer must have
+		 * the same width and height as this image, and may be
+		 * this image's own buffer.
+		 *
+		 * @param dest		[out] Destination buffer
+		 * @param dest_stride	[in] Destination stride, in bytes
+		 * @return 0 on success; non-zero on error.
+		 */
+		inline int premultiply_to(uint32_t *dest, int dest_stride) const;
+
 		/**
 		 * Convert a chroma-keyed image to standard ARGB32.
 		 * Standard version using regular C++ code.
@@ -470,6 +534,22 @@ class rp_image : public RefBase
 		int apply_chroma_key_sse2(uint32_t key);
 #endif /* RP_IMAGE_HAS_SSE2 */
 
+#ifdef RP_IMAGE_HAS_AVX2
+		/**
+		 * Convert a chroma-keyed image to standard ARGB32.
+		 * AVX2-optimized version.
+		 *
+		 * This operates on the image itself, and does not return
+		 * a duplicated image with the adjusted image.
+		 *
+		 * NOTE: The image *must* be ARGB32.
+		 *
+		 * @param key Chroma key color.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int apply_chroma_key_avx2(uint32_t key);
+#endif /* RP_IMAGE_HAS_AVX2 */
+
 		/**
 		 * Convert a chroma-keyed image to standard ARGB32.
 		 *
@@ -530,6 +610,16 @@ class rp_image : public RefBase
 		int swapRB_ssse3(void);
 #endif /* RP_IMAGE_HAS_SSSE3 */
 
+#ifdef RP_IMAGE_HAS_AVX2
+		/**
+		 * Swap Red and Blue channels in an ARGB32 image.
+		 * AVX2-optimized version.
+		 *
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int swapRB_avx2(void);
+#endif /* RP_IMAGE_HAS_AVX2 */
+
 		/**
 		 * Swap Red and Blue channels in an ARGB32 image.
 		 * @return 0 on success; negative POSIX error code on error.
@@ -558,6 +648,17 @@ class rp_image : public RefBase
 		int swizzle_ssse3(const char *swz_spec);
 #endif /* RP_IMAGE_HAS_SSSE3 */
 
+#ifdef RP_IMAGE_HAS_AVX2
+		/**
+		 * Swizzle the image channels.
+		 * AVX2-optimized version.
+		 *
+		 * @param swz_spec Swizzle specification: [rgba01]{4} [matches KTX2]
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int swizzle_avx2(const char *swz_spec);
+#endif /* RP_IMAGE_HAS_AVX2 */
+
 		/**
 		 * Swizzle the image channels.
 		 *
@@ -595,6 +696,11 @@ class rp_image : public RefBase
 inline int rp_image::un_premultiply(void)
 {
 	// FIXME: Figure out how to get IFUNC working with C++ member functions.
+#ifdef RP_IMAGE_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return un_premultiply_avx2();
+	} else
+#endif /* RP_IMAGE_HAS_AVX2 */
 #ifdef RP_IMAGE_HAS_SSE41
 	if (RP_CPU_HasSSE41()) {
 		return un_premultiply_sse41();
@@ -605,6 +711,38 @@ inline int rp_image::un_premultiply(void)
 	}
 }
 
+/**
+ * Copy this image to an ARGB32 buffer, premultiplying each pixel.
+ *
+ * This is equivalent to dup() followed by premultiply() and
+ * a copy, but it only reads and writes each pixel once.
+ *
+ * Image must be ARGB32. The destination buffer must have
+ * the same width and height as this image, and may be
+ * this image's own buffer.
+ *
+ * @param dest		[out] Destination buffer
+ * @param dest_stride	[in] Destination stride, in bytes
+ * @return 0 on success; non-zero on error.
+ */
+inline int rp_image::premultiply_to(uint32_t *dest, int dest_stride) const
+{
+	// FIXME: Figure out how to get IFUNC working with C++ member functions.
+#if defined(RP_IMAGE_ALWAYS_HAS_SSE2)
+	// amd64 always has SSE2.
+	return premultiply_to_sse2(dest, dest_stride);
+#else
+#  if defined(RP_IMAGE_HAS_SSE2)
+	if (RP_CPU_HasSSE2()) {
+		return premultiply_to_sse2(dest, dest_stride);
+	} else
+#  endif /* RP_IMAGE_HAS_SSE2 */
+	{
+		return premultiply_to_cpp(dest, dest_stride);
+	}
+#endif /* RP_IMAGE_ALWAYS_HAS_SSE2 */
+}
+
 /**
  * Convert a chroma-keyed image to standard ARGB32.
  *
@@ -619,6 +757,12 @@ inline int rp_image::un_premultiply(void)
 inline int rp_image::apply_chroma_key(uint32_t key)
 {
 	// FIXME: Figure out how to get IFUNC working with C++ member functions.
+#if defined(RP_IMAGE_HAS_AVX2)
+	if (RP_CPU_HasAVX2()) {
+		return apply_chroma_key_avx2(key);
+	}
+#endif /* RP_IMAGE_HAS_AVX2 */
+
 #if defined(RP_IMAGE_ALWAYS_HAS_SSE2)
 	// amd64 always has SSE2.
 	return apply_chroma_key_sse2(key);
@@ -641,6 +785,11 @@ inline int rp_image::apply_chroma_key(uint32_t key)
 inline int rp_image::swapRB(void)
 {
 	// FIXME: Figure out how to get IFUNC working with C++ member functions.
+#if defined(RP_IMAGE_HAS_AVX2)
+	if (RP_CPU_HasAVX2()) {
+		return swapRB_avx2();
+	} else
+#endif /* RP_IMAGE_HAS_AVX2 */
 #if defined(RP_IMAGE_HAS_SSSE3)
 	if (RP_CPU_HasSSSE3()) {
 		return swapRB_ssse3();
@@ -660,6 +809,11 @@ inline int rp_image::swapRB(void)
 inline int rp_image::swizzle(const char *swz_spec)
 {
 	// FIXME: Figure out how to get IFUNC working with C++ member functions.
+#if defined(RP_IMAGE_HAS_AVX2)
+	if (RP_CPU_HasAVX2()) {
+		return swizzle_avx2(swz_spec);
+	} else
+#endif /* RP_IMAGE_HAS_AVX2 */
 #if defined(RP_IMAGE_HAS_SSSE3)
 	if (RP_CPU_HasSSSE3()) {
 		return swizzle_ssse3(swz_spec);
@@ -0,0 +1,334 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture)                     *
+ * rp_image_ops.cpp: Image class. (operations)                             *
+ * AVX2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "rp_image.hpp"
+#include "rp_image_p.hpp"
+#include "rp_image_backend.hpp"
+
+// AVX2 intrinsics
+#include <immintrin.h>
+
+// Workaround for RP_D() expecting the no-underscore, UpperCamelCase naming convention.
+#define rp_imagePrivate rp_image_private
+
+// NOTE: rp_image only guarantees 16-byte alignment, so unaligned
+// loads and stores are used for the 256-bit registers.
+
+namespace LibRpTexture {
+
+/** Image operations. **/
+
+/**
+ * Convert a chroma-keyed image to standard ARGB32.
+ * AVX2-optimized version.
+ *
+ * This operates on the image itself, and does not return
+ * a duplicated image with the adjusted image.
+ *
+ * NOTE: The image *must* be ARGB32.
+ *
+ * @param key Chroma key color.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int rp_image::apply_chroma_key_avx2(uint32_t key)
+{
+	RP_D(rp_image);
+	rp_image_backend *const backend = d->backend;
+	assert(backend->format == Format::ARGB32);
+	if (backend->format != Format::ARGB32) {
+		// ARGB32 only.
+		return -EINVAL;
+	}
+
+	const unsigned int diff = (backend->stride - this->row_bytes()) / sizeof(uint32_t);
+	uint32_t *img_buf = static_cast<uint32_t*>(backend->data());
+
+	// AVX2 constants.
+	const __m256i ymm_key = _mm256_set1_epi32(key);
+
+	for (unsigned int y = static_cast<unsigned int>(backend->height); y > 0; y--) {
+		// Process 16 pixels per iteration with AVX2.
+		unsigned int x = static_cast<unsigned int>(backend->width);
+		for (; x > 15; x -= 16, img_buf += 16) {
+			__m256i *ymm_data = reinterpret_cast<__m256i*>(img_buf);
+			__m256i sa = _mm256_loadu_si256(&ymm_data[0]);
+			__m256i sb = _mm256_loadu_si256(&ymm_data[1]);
+
+			// Compare the pixels to the chroma key.
+			// Equal values will be 0xFFFFFFFF.
+			// Non-equal values will be 0x00000000.
+			// Then, mask the original data with the inverted results.
+			// Original data will now have 00s for chroma-keyed pixels.
+			sa = _mm256_andnot_si256(_mm256_cmpeq_epi32(sa, ymm_key), sa);
+			sb = _mm256_andnot_si256(_mm256_cmpeq_epi32(sb, ymm_key), sb);
+
+			_mm256_storeu_si256(&ymm_data[0], sa);
+			_mm256_storeu_si256(&ymm_data[1], sb);
+		}
+
+		// Remaining pixels.
+		for (; x > 0; x--, img_buf++) {
+			if (*img_buf == key) {
+				*img_buf = 0;
+			}
+		}
+
+		// Next row.
+		img_buf += diff;
+	}
+
+	// Adjust sBIT.
+	// TODO: Only if transparent pixels were found.
+	if (d->has_sBIT && d->sBIT.alpha == 0) {
+		d->sBIT.alpha = 1;
+	}
+
+	// Chroma key applied.
+	return 0;
+}
+
+/**
+ * Swap Red and Blue channels in an ARGB32 image.
+ * AVX2-optimized version.
+ *
+ * NOTE: The image *must* be ARGB32.
+ *
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int rp_image::swapRB_avx2(void)
+{
+	RP_D(rp_image);
+	rp_image_backend *const backend = d->backend;
+
+	// ABGR shuffle mask
+	// NOTE: vpshufb shuffles within each 128-bit lane,
+	// so the 128-bit shuffle mask is repeated.
+	const __m256i shuf_mask = _mm256_broadcastsi128_si256(
+		_mm_setr_epi8(2,1,0,3, 6,5,4,7, 10,9,8,11, 14,13,12,15));
+
+	switch (backend->format) {
+		default:
+			// Unsupported image format.
+			assert(!"Unsupported rp_image::Format.");
+			return -EINVAL;
+
+		case rp_image::Format::ARGB32: {
+			argb32_t *img_buf = static_cast<argb32_t*>(backend->data());
+			const int row_width = backend->stride / sizeof(uint32_t);
+
+			for (unsigned int y = static_cast<unsigned int>(backend->height); y > 0; y--) {
+				// Process 32 pixels per iteration using AVX2.
+				unsigned int x = static_cast<unsigned int>(backend->width);
+				__m256i *ymm_buf = reinterpret_cast<__m256i*>(img_buf);
+				for (; x > 31; x -= 32, ymm_buf += 4) {
+					__m256i sa = _mm256_loadu_si256(&ymm_buf[0]);
+					__m256i sb = _mm256_loadu_si256(&ymm_buf[1]);
+					__m256i sc = _mm256_loadu_si256(&ymm_buf[2]);
+					__m256i sd = _mm256_loadu_si256(&ymm_buf[3]);
+
+					_mm256_storeu_si256(&ymm_buf[0], _mm256_shuffle_epi8(sa, shuf_mask));
+					_mm256_storeu_si256(&ymm_buf[1], _mm256_shuffle_epi8(sb, shuf_mask));
+					_mm256_storeu_si256(&ymm_buf[2], _mm256_shuffle_epi8(sc, shuf_mask));
+					_mm256_storeu_si256(&ymm_buf[3], _mm256_shuffle_epi8(sd, shuf_mask));
+				}
+
+				// Remaining pixels.
+				argb32_t *px32 = reinterpret_cast<argb32_t*>(ymm_buf);
+				for (; x > 0; x--, px32++) {
+					std::swap(px32->r, px32->b);
+				}
+
+				// Next line.
+				img_buf += row_width;
+			}
+			break;
+		}
+
+		case rp_image::Format::CI8: {
+			argb32_t *pal = reinterpret_cast<argb32_t*>(backend->palette());
+			const unsigned int pal_len = backend->palette_len();
+			assert(pal != nullptr);
+			assert(pal_len > 0);
+			if (!pal || pal_len <= 0) {
+				return -EINVAL;
+			}
+
+			// Process 32 colors per iteration using AVX2.
+			__m256i *ymm_pal = reinterpret_cast<__m256i*>(pal);
+			unsigned int i;
+			for (i = pal_len; i > 31; i -= 32, ymm_pal += 4) {
+				__m256i sa = _mm256_loadu_si256(&ymm_pal[0]);
+				__m256i sb = _mm256_loadu_si256(&ymm_pal[1]);
+				__m256i sc = _mm256_loadu_si256(&ymm_pal[2]);
+				__m256i sd = _mm256_loadu_si256(&ymm_pal[3]);
+
+				_mm256_storeu_si256(&ymm_pal[0], _mm256_shuffle_epi8(sa, shuf_mask));
+				_mm256_storeu_si256(&ymm_pal[1], _mm256_shuffle_epi8(sb, shuf_mask));
+				_mm256_storeu_si256(&ymm_pal[2], _mm256_shuffle_epi8(sc, shuf_mask));
+				_mm256_storeu_si256(&ymm_pal[3], _mm256_shuffle_epi8(sd, shuf_mask));
+			}
+
+			// Remaining colors
+			argb32_t *pal32 = reinterpret_cast<argb32_t*>(ymm_pal);
+			for (; i > 0; i--, pal32++) {
+				std::swap(pal32->r, pal32->b);
+			}
+			break;
+		}
+	}
+
+	// R and B channels swapped.
+	return 0;
+}
+
+/**
+ * Swizzle the image channels.
+ * AVX2-optimized version.
+ *
+ * @param swz_spec Swizzle specification: [rgba01]{4} [matches KTX2]
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int rp_image::swizzle_avx2(const char *swz_spec)
+{
+	RP_D(rp_image);
+	rp_image_backend *const backend = d->backend;
+	assert(backend->format == rp_image::Format::ARGB32);
+	if (backend->format != rp_image::Format::ARGB32) {
+		// ARGB32 is required.
+		// TODO: Automatically convert the image?
+		return -EINVAL;
+	}
+
+	// TODO: Verify swz_spec.
+	typedef union _u8_32 {
+		uint8_t u8[4];
+		uint32_t u32;
+	} u8_32;
+	u8_32 swz_ch;
+	memcpy(&swz_ch, swz_spec, sizeof(swz_ch));
+	if (swz_ch.u32 == 'rgba') {
+		// 'rgba' == NULL swizzle. Don't bother doing anything.
+		return 0;
+	}
+
+	// NOTE: Texture uses ARGB format, but swizzle uses rgba.
+	// Rotate swz_ch to convert it to argb.
+	// The entire thing needs to be byteswapped to match the internal order, too.
+	// NOTE: AVX2 is x86-only, so this is always little-endian.
+	swz_ch.u32 = (swz_ch.u32 >> 24) | (swz_ch.u32 << 8);
+	swz_ch.u32 = be32_to_cpu(swz_ch.u32);
+
+	// Determine the pshufb mask.
+	// This can be used for [rgba0].
+	// For 1, we'll need a separate por mask.
+	// N.B.: For pshufb, only bit 7 needs to be set to indicate "zero the byte".
+	uint8_t pshufb_mask_vals[4];
+	u8_32 por_mask_vals;
+#define SWIZZLE_MASK_VAL(n) do { \
+		switch (swz_ch.u8[n]) { \
+			case 'b':	pshufb_mask_vals[n] = 0;	por_mask_vals.u8[n] = 0;	break; \
+			case 'g':	pshufb_mask_vals[n] = 1;	por_mask_vals.u8[n] = 0;	break; \
+			case 'r':	pshufb_mask_vals[n] = 2;	por_mask_vals.u8[n] = 0;	break; \
+			case 'a':	pshufb_mask_vals[n] = 3;	por_mask_vals.u8[n] = 0;	break; \
+			case '0':	pshufb_mask_vals[n] = 0x80;	por_mask_vals.u8[n] = 0;	break; \
+			case '1':	pshufb_mask_vals[n] = 0x80;	por_mask_vals.u8[n] = 0xFF;	break; \
+			default: \
+				assert(!"Invalid swizzle value."); \
+				pshufb_mask_vals[n] = 0xFF; \
+				por_mask_vals.u8[n] = 0; \
+				break; \
+		} \
+	} while (0)
+
+	SWIZZLE_MASK_VAL(0);
+	SWIZZLE_MASK_VAL(1);
+	SWIZZLE_MASK_VAL(2);
+	SWIZZLE_MASK_VAL(3);
+
+	// NOTE: vpshufb shuffles within each 128-bit lane,
+	// so the 128-bit shuffle mask is repeated.
+	const __m256i pshufb_mask = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+		pshufb_mask_vals[0],	pshufb_mask_vals[1],	pshufb_mask_vals[2],	pshufb_mask_vals[3],
+		pshufb_mask_vals[0]+4,	pshufb_mask_vals[1]+4,	pshufb_mask_vals[2]+4,	pshufb_mask_vals[3]+4,
+		pshufb_mask_vals[0]+8,	pshufb_mask_vals[1]+8,	pshufb_mask_vals[2]+8,	pshufb_mask_vals[3]+8,
+		pshufb_mask_vals[0]+12,	pshufb_mask_vals[1]+12,	pshufb_mask_vals[2]+12,	pshufb_mask_vals[3]+12
+	));
+	const __m256i por_mask = _mm256_set1_epi32(por_mask_vals.u32);
+
+	uint32_t *bits = static_cast<uint32_t*>(backend->data());
+	const unsigned int stride_diff = (backend->stride - this->row_bytes()) / sizeof(uint32_t);
+	const int width = backend->width;
+	for (int y = backend->height; y > 0; y--) {
+		// Process 32 pixels at a time using AVX2.
+		__m256i *ymm_bits = reinterpret_cast<__m256i*>(bits);
+		int x;
+		for (x = width; x > 31; x -= 32, ymm_bits += 4) {
+			__m256i sa = _mm256_loadu_si256(&ymm_bits[0]);
+			__m256i sb = _mm256_loadu_si256(&ymm_bits[1]);
+			__m256i sc = _mm256_loadu_si256(&ymm_bits[2]);
+			__m256i sd = _mm256_loadu_si256(&ymm_bits[3]);
+
+			_mm256_storeu_si256(&ymm_bits[0], _mm256_or_si256(_mm256_shuffle_epi8(sa, pshufb_mask), por_mask));
+			_mm256_storeu_si256(&ymm_bits[1], _mm256_or_si256(_mm256_shuffle_epi8(sb, pshufb_mask), por_mask));
+			_mm256_storeu_si256(&ymm_bits[2], _mm256_or_si256(_mm256_shuffle_epi8(sc, pshufb_mask), por_mask));
+			_mm256_storeu_si256(&ymm_bits[3], _mm256_or_si256(_mm256_shuffle_epi8(sd, pshufb_mask), por_mask));
+		}
+
+		// Process remaining pixels using the pshufb/por values directly.
+		bits = reinterpret_cast<uint32_t*>(ymm_bits);
+		for (; x > 0; x--, bits++) {
+			u8_32 cur, swz;
+			cur.u32 = *bits;
+
+#define SWIZZLE_CHANNEL(n) do { \
+				swz.u8[n] = (pshufb_mask_vals[n] & 0x80) \
+					? por_mask_vals.u8[n] \
+					: cur.u8[pshufb_mask_vals[n]]; \
+			} while (0)
+
+			SWIZZLE_CHANNEL(0);
+			SWIZZLE_CHANNEL(1);
+			SWIZZLE_CHANNEL(2);
+			SWIZZLE_CHANNEL(3);
+
+			*bits = swz.u32;
+		}
+
+		// Next row.
+		bits += stride_diff;
+	}
+
+	// Swizzle the sBIT value, if set.
+	if (d->has_sBIT) {
+		// TODO: If gray is set, move its values to rgb?
+		rp_image::sBIT_t sBIT_old = d->sBIT;
+
+#define SWIZZLE_sBIT(n, ch) do { \
+				switch (swz_ch.u8[n]) { \
+					case 'b':	d->sBIT.ch = sBIT_old.blue;	break; \
+					case 'g':	d->sBIT.ch = sBIT_old.green;	break; \
+					case 'r':	d->sBIT.ch = sBIT_old.red;	break; \
+					case 'a':	d->sBIT.ch = sBIT_old.alpha;	break; \
+					case '0': case '1': \
+							d->sBIT.ch = 1;			break; \
+				} \
+			} while (0)
+
+			// Little-endian channel order: BGRA
+			SWIZZLE_sBIT(0, blue);
+			SWIZZLE_sBIT(1, green);
+			SWIZZLE_sBIT(2, red);
+			SWIZZLE_sBIT(3, alpha);
+	}
+
+	return 0;
+}
+
+}
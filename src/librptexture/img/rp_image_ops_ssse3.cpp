@@ -89,7 +89,7 @@ int rp_image::swapRB_ssse3(void)
 			// Process 16 colors per iteration using SSSE3.
 			__m128i *xmm_pal = reinterpret_cast<__m128i*>(pal);
 			unsigned int i;
-			for (i = pal_len; i > 15; i -= 16, pal += 4) {
+			for (i = pal_len; i > 15; i -= 16, xmm_pal += 4) {
 				__m128i sa = _mm_load_si128(&xmm_pal[0]);
 				__m128i sb = _mm_load_si128(&xmm_pal[1]);
 				__m128i sc = _mm_load_si128(&xmm_pal[2]);
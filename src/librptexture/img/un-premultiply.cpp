@@ -165,30 +165,54 @@ uint32_t rp_image::premultiply_pixel(uint32_t px)
  * @return 0 on success; non-zero on error.
  */
 int rp_image::premultiply(void)
+{
+	RP_D(const rp_image);
+	rp_image_backend *const backend = d->backend;
+	return premultiply_to(static_cast<uint32_t*>(backend->data()), backend->stride);
+}
+
+/**
+ * Copy this image to an ARGB32 buffer, premultiplying each pixel.
+ * Standard version using regular C++ code.
+ *
+ * Image must be ARGB32. The destination buffer must have
+ * the same width and height as this image, and may be
+ * this image's own buffer.
+ *
+ * @param dest		[out] Destination buffer
+ * @param dest_stride	[in] Destination stride, in bytes
+ * @return 0 on success; non-zero on error.
+ */
+int rp_image::premultiply_to_cpp(uint32_t *dest, int dest_stride) const
 {
 	// TODO: Qt doesn't have SSE-optimized builds.
 
 	RP_D(const rp_image);
-	rp_image_backend *const backend = d->backend;
+	const rp_image_backend *const backend = d->backend;
 	assert(backend->format == rp_image::Format::ARGB32);
-	if (backend->format != rp_image::Format::ARGB32) {
+	assert(dest != nullptr);
+	if (backend->format != rp_image::Format::ARGB32 || !dest) {
 		// Incorrect format...
 		return -1;
 	}
 
 	const int width = backend->width;
-	argb32_t *px_dest = static_cast<argb32_t*>(backend->data());
-	int dest_stride_adj = (backend->stride / sizeof(*px_dest)) - width;
-	for (int y = backend->height; y > 0; y--, px_dest += dest_stride_adj) {
+	const uint32_t *px_src = static_cast<const uint32_t*>(backend->data());
+	const int src_stride_adj = (backend->stride / sizeof(*px_src)) - width;
+	const int dest_stride_adj = (dest_stride / sizeof(*dest)) - width;
+	for (int y = backend->height; y > 0; y--) {
 		int x = width;
-		for (; x > 1; x -= 2, px_dest += 2) {
-			px_dest[0].u32 = premultiply_pixel_inl(px_dest[0].u32);
-			px_dest[1].u32 = premultiply_pixel_inl(px_dest[1].u32);
+		for (; x > 1; x -= 2, px_src += 2, dest += 2) {
+			dest[0] = premultiply_pixel_inl(px_src[0]);
+			dest[1] = premultiply_pixel_inl(px_src[1]);
 		}
 		if (x == 1) {
-			px_dest->u32 = premultiply_pixel_inl(px_dest->u32);
-			px_dest++;
+			*dest++ = premultiply_pixel_inl(*px_src++);
 		}
+
+		// Next line.
+		px_src += src_stride_adj;
+		dest += dest_stride_adj;
 	}
 	return 0;
 }
@@ -0,0 +1,138 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture)                     *
+ * un-premultiply_avx2.cpp: Un-premultiply function.                       *
+ * AVX2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2017-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "rp_image.hpp"
+#include "rp_image_p.hpp"
+#include "rp_image_backend.hpp"
+
+// AVX2 intrinsics
+#include <immintrin.h>
+
+// Workaround for RP_D() expecting the no-underscore, UpperCamelCase naming convention.
+#define rp_imagePrivate rp_image_private
+
+namespace LibRpTexture {
+
+/**
+ * Un-premultiply an argb32_t pixel. (AVX2 version)
+ * Used for the remaining pixels in each row.
+ * Identical to the SSE4.1 version.
+ *
+ * @param px	[in/out] argb32_t pixel to un-premultiply, in place.
+ */
+static FORCEINLINE void un_premultiply_pixel_avx2(argb32_t &px)
+{
+	const unsigned int alpha = px.a;
+	if (alpha == 255 || alpha == 0)
+		return;
+
+	const unsigned int invAlpha = rp_image::qt_inv_premul_factor[alpha];
+	const __m128i via = _mm_set1_epi32(invAlpha);
+	const __m128i vr = _mm_set1_epi32(0x8000);
+	__m128i vl = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(px.u32));
+	vl = _mm_mullo_epi32(vl, via);
+	vl = _mm_add_epi32(vl, vr);
+	vl = _mm_srai_epi32(vl, 16);
+	vl = _mm_insert_epi32(vl, alpha, 3);
+	vl = _mm_packus_epi32(vl, vl);
+	vl = _mm_packus_epi16(vl, vl);
+	px.u32 = _mm_cvtsi128_si32(vl);
+}
+
+/**
+ * Un-premultiply two argb32_t pixels, expanded to 32-bit channels.
+ * @param px2	[in] Two pixels, zero-extended to 8 DWORDs
+ * @param via	[in] Inverse alpha factors, one per DWORD
+ * @return Un-premultiplied channels, with the original alpha channel.
+ */
+static FORCEINLINE __m256i un_premultiply_px2_avx2(__m256i px2, __m256i via)
+{
+	const __m256i vr = _mm256_set1_epi32(0x8000);
+	__m256i vl = _mm256_mullo_epi32(px2, via);
+	vl = _mm256_add_epi32(vl, vr);
+	vl = _mm256_srai_epi32(vl, 16);
+	// Restore the original alpha channels. (DWORDs 3 and 7)
+	return _mm256_blend_epi32(vl, px2, 0x88);
+}
+
+/**
+ * Un-premultiply an ARGB32 rp_image.
+ * Image must be ARGB32.
+ * @return 0 on success; non-zero on error.
+ */
+int rp_image::un_premultiply_avx2(void)
+{
+	RP_D(const rp_image);
+	rp_image_backend *const backend = d->backend;
+	assert(backend->format == rp_image::Format::ARGB32);
+	if (backend->format != rp_image::Format::ARGB32) {
+		// Incorrect format...
+		return -1;
+	}
+
+	// Permutation masks to broadcast each pixel's inverse alpha factor
+	// to all four of its channels.
+	const __m256i perm_via01 = _mm256_setr_epi32(0,0,0,0, 1,1,1,1);
+	const __m256i perm_via23 = _mm256_setr_epi32(2,2,2,2, 3,3,3,3);
+	const __m256i perm_via45 = _mm256_setr_epi32(4,4,4,4, 5,5,5,5);
+	const __m256i perm_via67 = _mm256_setr_epi32(6,6,6,6, 7,7,7,7);
+	// Packing interleaves the two 128-bit lanes; this restores the pixel order.
+	const __m256i perm_pack = _mm256_setr_epi32(0,4,1,5,2,6,3,7);
+	const int *const inv_premul_factor = reinterpret_cast<const int*>(qt_inv_premul_factor);
+
+	const int width = backend->width;
+	argb32_t *px_dest = static_cast<argb32_t*>(backend->data());
+	int dest_stride_adj = (backend->stride / sizeof(*px_dest)) - width;
+	for (int y = backend->height; y > 0; y--, px_dest += dest_stride_adj) {
+		// Process 8 pixels per iteration using AVX2.
+		int x = width;
+		for (; x > 7; x -= 8, px_dest += 8) {
+			__m256i *ymm_px = reinterpret_cast<__m256i*>(px_dest);
+			const __m256i px8 = _mm256_loadu_si256(ymm_px);
+
+			// Look up the inverse alpha factors.
+			const __m256i alpha = _mm256_srli_epi32(px8, 24);
+			const __m256i via = _mm256_i32gather_epi32(inv_premul_factor, alpha, 4);
+
+			// Expand each pair of pixels to 32-bit channels.
+			const __m128i px_lo = _mm256_castsi256_si128(px8);
+			const __m128i px_hi = _mm256_extracti128_si256(px8, 1);
+			__m256i px01 = _mm256_cvtepu8_epi32(px_lo);
+			__m256i px23 = _mm256_cvtepu8_epi32(_mm_srli_si128(px_lo, 8));
+			__m256i px45 = _mm256_cvtepu8_epi32(px_hi);
+			__m256i px67 = _mm256_cvtepu8_epi32(_mm_srli_si128(px_hi, 8));
+
+			px01 = un_premultiply_px2_avx2(px01, _mm256_permutevar8x32_epi32(via, perm_via01));
+			px23 = un_premultiply_px2_avx2(px23, _mm256_permutevar8x32_epi32(via, perm_via23));
+			px45 = un_premultiply_px2_avx2(px45, _mm256_permutevar8x32_epi32(via, perm_via45));
+			px67 = un_premultiply_px2_avx2(px67, _mm256_permutevar8x32_epi32(via, perm_via67));
+
+			// Pack the channels back into pixels.
+			__m256i res = _mm256_packus_epi16(
+				_mm256_packus_epi32(px01, px23),
+				_mm256_packus_epi32(px45, px67));
+			res = _mm256_permutevar8x32_epi32(res, perm_pack);
+
+			// Pixels with alpha == 0 are left as-is.
+			const __m256i is_a0 = _mm256_cmpeq_epi32(alpha, _mm256_setzero_si256());
+			res = _mm256_blendv_epi8(res, px8, is_a0);
+
+			_mm256_storeu_si256(ymm_px, res);
+		}
+
+		// Remaining pixels.
+		for (; x > 0; x--, px_dest++) {
+			un_premultiply_pixel_avx2(*px_dest);
+		}
+	}
+	return 0;
+}
+
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture)                     *
+ * un-premultiply_sse2.cpp: Premultiply function.                          *
+ * SSE2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2017-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "rp_image.hpp"
+#include "rp_image_p.hpp"
+#include "rp_image_backend.hpp"
+
+// SSE2 intrinsics
+#include <emmintrin.h>
+
+// Workaround for RP_D() expecting the no-underscore, UpperCamelCase naming convention.
+#define rp_imagePrivate rp_image_private
+
+namespace LibRpTexture {
+
+/**
+ * Premultiply four ARGB32 pixels. (SSE2 version)
+ *
+ * This uses the same formula as the standard version,
+ * qPremultiply() from qt-5.11.0's qrgb.h, so the results
+ * are identical. Pixels with alpha == 0 are not modified.
+ *
+ * @param px	[in] Four ARGB32 pixels to premultiply.
+ * @return Premultiplied pixels.
+ */
+static FORCEINLINE __m128i premultiply_pixels_sse2(__m128i px)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+
+	// Check the alpha channels.
+	const __m128i alpha = _mm_and_si128(px, alpha_mask);
+	if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFF) {
+		// All four pixels are opaque.
+		return px;
+	}
+
+	// Multiplier for the alpha channel itself.
+	// ((a * 255) + ((a * 255) >> 8) + 0x80) >> 8 == a
+	const __m128i alpha_mul_255 = _mm_setr_epi16(0, 0, 0, 0xFF, 0, 0, 0, 0xFF);
+	const __m128i rnd = _mm_set1_epi16(0x80);
+
+	// Expand to 16-bit components. (B, G, R, A)
+	__m128i lo = _mm_unpacklo_epi8(px, zero);
+	__m128i hi = _mm_unpackhi_epi8(px, zero);
+
+	// Broadcast each pixel's alpha value to all of its components.
+	__m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+	__m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+	a_lo = _mm_or_si128(a_lo, alpha_mul_255);
+	a_hi = _mm_or_si128(a_hi, alpha_mul_255);
+
+	// t = c * a; t = (t + (t >> 8) + 0x80) >> 8;
+	// NOTE: Maximum intermediate value is 0xFF7F, so this fits in 16 bits.
+	lo = _mm_mullo_epi16(lo, a_lo);
+	hi = _mm_mullo_epi16(hi, a_hi);
+	lo = _mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), rnd);
+	hi = _mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), rnd);
+	lo = _mm_srli_epi16(lo, 8);
+	hi = _mm_srli_epi16(hi, 8);
+	const __m128i prex = _mm_packus_epi16(lo, hi);
+
+	// Pixels with alpha == 0 are returned as-is.
+	const __m128i is_transparent = _mm_cmpeq_epi32(alpha, zero);
+	return _mm_or_si128(_mm_and_si128(is_transparent, px),
+	                    _mm_andnot_si128(is_transparent, prex));
+}
+
+/**
+ * Copy this image to an ARGB32 buffer, premultiplying each pixel.
+ * SSE2-optimized version.
+ *
+ * Image must be ARGB32. The destination buffer must have
+ * the same width and height as this image, and may be
+ * this image's own buffer.
+ *
+ * @param dest		[out] Destination buffer
+ * @param dest_stride	[in] Destination stride, in bytes
+ * @return 0 on success; non-zero on error.
+ */
+int rp_image::premultiply_to_sse2(uint32_t *dest, int dest_stride) const
+{
+	RP_D(const rp_image);
+	const rp_image_backend *const backend = d->backend;
+	assert(backend->format == rp_image::Format::ARGB32);
+	assert(dest != nullptr);
+	if (backend->format != rp_image::Format::ARGB32 || !dest) {
+		// Incorrect format...
+		return -1;
+	}
+
+	const int width = backend->width;
+	const uint32_t *px_src = static_cast<const uint32_t*>(backend->data());
+	const int src_stride_adj = (backend->stride / sizeof(*px_src)) - width;
+	const int dest_stride_adj = (dest_stride / sizeof(*dest)) - width;
+	for (int y = backend->height; y > 0; y--) {
+		// Process 4 pixels per iteration with SSE2.
+		// NOTE: The destination buffer might not be 16-byte aligned.
+		int x = width;
+		for (; x > 3; x -= 4, px_src += 4, dest += 4) {
+			const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px_src));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), premultiply_pixels_sse2(px));
+		}
+
+		// Remaining pixels.
+		for (; x > 0; x--, px_src++, dest++) {
+			*dest = premultiply_pixel(*px_src);
+		}
+
+		// Next line.
+		px_src += src_stride_adj;
+		dest += dest_stride_adj;
+	}
+	return 0;
+}
+
+}
@@ -0,0 +1,289 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librptexture/tests)               *
+ * ImageDecoderBlockTest.cpp: Block-compressed ImageDecoder tests.         *
+ * Compares the SIMD-optimized S3TC and ETC1 decoders to the standard      *
+ * C++ decoders.                                                           *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+#include "common.h"
+
+// librptexture
+#include "librptexture/img/rp_image.hpp"
+#include "librptexture/decoder/ImageDecoder_S3TC.hpp"
+#include "librptexture/decoder/ImageDecoder_ETC1.hpp"
+#ifdef _WIN32
+// rp_image backend registration.
+#  include "librptexture/img/RpGdiplusBackend.hpp"
+#endif /* _WIN32 */
+using namespace LibRpTexture;
+
+// C includes.
+#include <stdint.h>
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <ostream>
+#include <vector>
+using std::vector;
+
+namespace LibRpTexture { namespace Tests {
+
+struct ImageDecoderBlockTest_mode
+{
+	int width;
+	int height;
+
+	ImageDecoderBlockTest_mode(int width, int height)
+		: width(width)
+		, height(height)
+	{ }
+};
+
+/**
+ * Formatting function for ImageDecoderBlockTest_mode.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const ImageDecoderBlockTest_mode& mode) {
+	return os << mode.width << 'x' << mode.height;
+}
+
+class ImageDecoderBlockTest : public ::testing::TestWithParam<ImageDecoderBlockTest_mode>
+{
+	protected:
+		ImageDecoderBlockTest()
+		{
+#ifdef _WIN32
+			// Register RpGdiplusBackend.
+			// TODO: Static initializer somewhere?
+			rp_image::setBackendCreatorFn(RpGdiplusBackend::creator_fn);
+#endif /* _WIN32 */
+		}
+
+	public:
+		typedef rp_image* (*decoder_fn)(int width, int height,
+			const uint8_t *RESTRICT img_buf, size_t img_siz);
+
+		/**
+		 * Decode pseudo-random block data using the standard and
+		 * optimized decoders, and verify that the images are identical.
+		 * @param fn_cpp Standard decoder
+		 * @param fn_simd Optimized decoder
+		 * @param block_size Bytes per 4x4 block
+		 */
+		static void compareDecoders(decoder_fn fn_cpp, decoder_fn fn_simd, size_t block_size);
+};
+
+/**
+ * Decode pseudo-random block data using the standard and
+ * optimized decoders, and verify that the images are identical.
+ * @param fn_cpp Standard decoder
+ * @param fn_simd Optimized decoder
+ * @param block_size Bytes per 4x4 block
+ */
+void ImageDecoderBlockTest::compareDecoders(decoder_fn fn_cpp, decoder_fn fn_simd, size_t block_size)
+{
+	const ImageDecoderBlockTest_mode &mode = GetParam();
+
+	// Generate the block data.
+	// A fixed seed is used so failures are reproducible.
+	// NOTE: The last row and column of tiles may be cut off.
+	const size_t tilesX = (mode.width + 3) / 4;
+	const size_t tilesY = (mode.height + 3) / 4;
+	vector<uint8_t> img_buf(tilesX * tilesY * block_size);
+	uint32_t seed = 0x4D595DF4U ^ (mode.width << 16) ^ mode.height;
+	for (uint8_t &b : img_buf) {
+		seed = seed * 1103515245U + 12345U;
+		b = static_cast<uint8_t>(seed >> 24);
+	}
+
+	// Make sure both DXT1 color orderings show up in small images.
+	if (block_size == 8 && tilesX * tilesY >= 2) {
+		// Block 0: color0 > color1 (four colors)
+		img_buf[0] = 0xFF; img_buf[1] = 0xFF;
+		img_buf[2] = 0x00; img_buf[3] = 0x00;
+		// Block 1: color0 <= color1 (three colors, plus black or transparent)
+		img_buf[8] = 0x00; img_buf[9] = 0x00;
+		img_buf[10] = 0xFF; img_buf[11] = 0xFF;
+	}
+
+	rp_image *const img_cpp = fn_cpp(mode.width, mode.height, img_buf.data(), img_buf.size());
+	ASSERT_NE(nullptr, img_cpp);
+	rp_image *const img_simd = fn_simd(mode.width, mode.height, img_buf.data(), img_buf.size());
+	if (!img_simd) {
+		img_cpp->unref();
+		ASSERT_NE(nullptr, img_simd);
+		return;
+	}
+
+	EXPECT_EQ(mode.width, img_simd->width());
+	EXPECT_EQ(mode.height, img_simd->height());
+	EXPECT_EQ(img_cpp->width(), img_simd->width());
+	EXPECT_EQ(img_cpp->height(), img_simd->height());
+	EXPECT_EQ(img_cpp->format(), img_simd->format());
+	if (img_cpp->width() == img_simd->width() &&
+	    img_cpp->height() == img_simd->height() &&
+	    img_cpp->format() == img_simd->format())
+	{
+		const rp_image *const c_img_cpp = img_cpp;
+		const rp_image *const c_img_simd = img_simd;
+		const int width = img_cpp->width();
+		const int height = img_cpp->height();
+		for (int y = 0; y < height; y++) {
+			const uint32_t *const px_cpp = static_cast<const uint32_t*>(c_img_cpp->scanLine(y));
+			const uint32_t *const px_simd = static_cast<const uint32_t*>(c_img_simd->scanLine(y));
+			for (int x = 0; x < width; x++) {
+				if (px_cpp[x] != px_simd[x]) {
+					// Only report the first mismatch.
+					char buf[80];
+					snprintf(buf, sizeof(buf), "Pixel (%d,%d): expected %08X, got %08X",
+						x, y, px_cpp[x], px_simd[x]);
+					ADD_FAILURE() << buf;
+					y = height;
+					break;
+				}
+			}
+		}
+	}
+
+	img_cpp->unref();
+	img_simd->unref();
+}
+
+#ifdef IMAGEDECODER_HAS_SSE41
+/**
+ * Test the ImageDecoder::from*_sse41() functions.
+ */
+TEST_P(ImageDecoderBlockTest, fromDXT1_sse41_test)
+{
+	if (!RP_CPU_HasSSE41()) {
+		if (!GTEST_FLAG_GET(brief)) {
+			fputs("*** SSE4.1 is not supported on this CPU. Skipping test.\n", stderr);
+		}
+		return;
+	}
+
+	ASSERT_NO_FATAL_FAILURE(compareDecoders(
+		ImageDecoder::fromDXT1_cpp, ImageDecoder::fromDXT1_sse41, 8));
+}
+
+TEST_P(ImageDecoderBlockTest, fromDXT1_A1_sse41_test)
+{
+	if (!RP_CPU_HasSSE41()) {
+		if (!GTEST_FLAG_GET(brief)) {
+			fputs("*** SSE4.1 is not supported on this CPU. Skipping test.\n", stderr);
+		}
+		return;
+	}
+
+	ASSERT_NO_FATAL_FAILURE(compareDecoders(
+		ImageDecoder::fromDXT1_A1_cpp, ImageDecoder::fromDXT1_A1_sse41, 8));
+}
+
+TEST_P(ImageDecoderBlockTest, fromDXT5_sse41_test)
+{
+	if (!RP_CPU_HasSSE41()) {
+		if (!GTEST_FLAG_GET(brief)) {
+			fputs("*** SSE4.1 is not supported on this CPU. Skipping test.\n", stderr);
+		}
+		return;
+	}
+
+	ASSERT_NO_FATAL_FAILURE(compareDecoders(
+		ImageDecoder::fromDXT5_cpp, ImageDecoder::fromDXT5_sse41, 16));
+}
+
+TEST_P(ImageDecoderBlockTest, fromETC1_sse41_test)
+{
+	if (!RP_CPU_HasSSE41()) {
+		if (!GTEST_FLAG_GET(brief)) {
+			fputs("*** SSE4.1 is not supported on this CPU. Skipping test.\n", stderr);
+		}
+		return;
+	}
+
+	ASSERT_NO_FATAL_FAILURE(compareDecoders(
+		ImageDecoder::fromETC1_cpp, ImageDecoder::fromETC1_sse41, 8));
+}
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+/**
+ * Test the ImageDecoder::from*_avx2() functions.
+ */
+TEST_P(ImageDecoderBlockTest, fromDXT1_avx2_test)
+{
+	if (!RP_CPU_HasAVX2()) {
+		if (!GTEST_FLAG_GET(brief)) {
+			fputs("*** AVX2 is not supported on this CPU. Skipping test.\n", stderr);
+		}
+		return;
+	}
+
+	ASSERT_NO_FATAL_FAILURE(compareDecoders(
+		ImageDecoder::fromDXT1_cpp, ImageDecoder::fromDXT1_avx2, 8));
+}
+
+TEST_P(ImageDecoderBlockTest, fromDXT1_A1_avx2_test)
+{
+	if (!RP_CPU_HasAVX2()) {
+		if (!GTEST_FLAG_GET(brief)) {
+			fputs("*** AVX2 is not supported on this CPU. Skipping test.\n", stderr);
+		}
+		return;
+	}
+
+	ASSERT_NO_FATAL_FAILURE(compareDecoders(
+		ImageDecoder::fromDXT1_A1_cpp, ImageDecoder::fromDXT1_A1_avx2, 8));
+}
+
+TEST_P(ImageDecoderBlockTest, fromDXT5_avx2_test)
+{
+	if (!RP_CPU_HasAVX2()) {
+		if (!GTEST_FLAG_GET(brief)) {
+			fputs("*** AVX2 is not supported on this CPU. Skipping test.\n", stderr);
+		}
+		return;
+	}
+
+	ASSERT_NO_FATAL_FAILURE(compareDecoders(
+		ImageDecoder::fromDXT5_cpp, ImageDecoder::fromDXT5_avx2, 16));
+}
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+// Image sizes.
+// - Odd tile counts exercise the AVX2 two-tile loop's tail.
+// - Sizes that aren't multiples of 4 exercise partial tiles.
+INSTANTIATE_TEST_SUITE_P(ImageSizes, ImageDecoderBlockTest,
+	::testing::Values(
+		ImageDecoderBlockTest_mode(4, 4),
+		ImageDecoderBlockTest_mode(8, 8),
+		ImageDecoderBlockTest_mode(12, 4),
+		ImageDecoderBlockTest_mode(20, 12),
+		ImageDecoderBlockTest_mode(64, 64),
+		ImageDecoderBlockTest_mode(132, 36),
+		ImageDecoderBlockTest_mode(30, 18),
+		ImageDecoderBlockTest_mode(1, 1))
+	);
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRpTexture test suite: ImageDecoder block-compressed format tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -28,6 +28,7 @@ using namespace LibRpTexture;
 #include <cstring>
 
 // C++ includes.
+#include <memory>
 #include <string>
 using std::string;
 
@@ -94,8 +95,25 @@ TEST_F(UnPremultiplyTest, un_premultiply_sse41_benchmark)
 }
 #endif /* RP_IMAGE_HAS_SSE41 */
 
+#ifdef RP_IMAGE_HAS_AVX2
+/**
+ * Benchmark the ImageDecoder::un_premultiply() function. (AVX2-optimized version)
+ */
+TEST_F(UnPremultiplyTest, un_premultiply_avx2_benchmark)
+{
+	if (!RP_CPU_HasAVX2()) {
+		fputs("*** AVX2 is not supported on this CPU. Skipping test.\n", stderr);
+		return;
+	}
+
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		m_img->un_premultiply_avx2();
+	}
+}
+#endif /* RP_IMAGE_HAS_AVX2 */
+
 // NOTE: Add more instruction sets to the #ifdef if other optimizations are added.
-#if defined(RP_IMAGE_HAS_SSE41)
+#if defined(RP_IMAGE_HAS_SSE41) || defined(RP_IMAGE_HAS_AVX2)
 /**
  * Benchmark the ImageDecoder::un_premultiply() dispatch function.
  */
@@ -105,15 +123,86 @@ TEST_F(UnPremultiplyTest, un_premultiply_dispatch_benchmark)
 		m_img->un_premultiply();
 	}
 }
-#endif /* RP_IMAGE_HAS_SSE41 */
+#endif /* RP_IMAGE_HAS_SSE41 || RP_IMAGE_HAS_AVX2 */
 
 /**
  * Benchmark the ImageDecoder::premultiply() function. (Standard version)
  */
 TEST_F(UnPremultiplyTest, premultiply_cpp)
 {
+	// NOTE: premultiply() dispatches to an optimized version if available,
+	// so call the standard version directly, in place.
+	uint32_t *const bits = static_cast<uint32_t*>(m_img->bits());
+	const int stride = m_img->stride();
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		m_img->premultiply_to_cpp(bits, stride);
+	}
+}
+
+#ifdef RP_IMAGE_HAS_SSE2
+/**
+ * Verify that rp_image::premultiply_to_sse2() matches the standard version.
+ */
+TEST_F(UnPremultiplyTest, premultiply_to_sse2_test)
+{
+	if (!RP_CPU_HasSSE2()) {
+		fputs("*** SSE2 is not supported on this CPU. Skipping test.\n", stderr);
+		return;
+	}
+
+	// Every combination of alpha and color component values.
+	// NOTE: Width is not a multiple of 4 in order to test the remaining pixels.
+	rp_image *const img = new rp_image(259, 256, rp_image::Format::ARGB32);
+	uint32_t *px = static_cast<uint32_t*>(img->bits());
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	for (int y = 0; y < img->height(); y++, px += stride_px) {
+		for (int x = 0; x < img->width(); x++) {
+			const uint32_t c = (x & 0xFF);
+			px[x] = (y << 24) | (c << 16) | ((c ^ 0x5A) << 8) | (255 - c);
+		}
+	}
+
+	// Use an odd stride for the destination buffer.
+	const int dest_stride = (img->width() + 1) * sizeof(uint32_t);
+	const size_t dest_len = (size_t)dest_stride * img->height() / sizeof(uint32_t);
+	std::unique_ptr<uint32_t[]> buf_cpp(new uint32_t[dest_len]);
+	std::unique_ptr<uint32_t[]> buf_sse2(new uint32_t[dest_len]);
+	memset(buf_cpp.get(), 0, dest_len * sizeof(uint32_t));
+	memset(buf_sse2.get(), 0, dest_len * sizeof(uint32_t));
+
+	EXPECT_EQ(0, img->premultiply_to_cpp(buf_cpp.get(), dest_stride));
+	EXPECT_EQ(0, img->premultiply_to_sse2(buf_sse2.get(), dest_stride));
+	EXPECT_EQ(0, memcmp(buf_cpp.get(), buf_sse2.get(), dest_len * sizeof(uint32_t)));
+	img->unref();
+}
+
+/**
+ * Benchmark the rp_image::premultiply_to() function. (SSE2-optimized version)
+ */
+TEST_F(UnPremultiplyTest, premultiply_to_sse2_benchmark)
+{
+	if (!RP_CPU_HasSSE2()) {
+		fputs("*** SSE2 is not supported on this CPU. Skipping test.\n", stderr);
+		return;
+	}
+
+	std::unique_ptr<uint32_t[]> buf(new uint32_t[m_img->width() * m_img->height()]);
+	const int dest_stride = m_img->width() * sizeof(uint32_t);
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		m_img->premultiply_to_sse2(buf.get(), dest_stride);
+	}
+}
+#endif /* RP_IMAGE_HAS_SSE2 */
+
+/**
+ * Benchmark the rp_image::premultiply_to() function. (Standard version)
+ */
+TEST_F(UnPremultiplyTest, premultiply_to_cpp_benchmark)
+{
+	std::unique_ptr<uint32_t[]> buf(new uint32_t[m_img->width() * m_img->height()]);
+	const int dest_stride = m_img->width() * sizeof(uint32_t);
 	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
-		m_img->premultiply();
+		m_img->premultiply_to_cpp(buf.get(), dest_stride);
 	}
 }
 
@@ -0,0 +1,20 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpthreads)                     *
+ * Thread.hpp: System-specific thread implementation.                      *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+// NOTE: The .cpp files are #included here in order to inline the functions.
+// Do NOT compile them separately!
+
+// Each .cpp file defines the Thread class itself, with required fields.
+
+#ifdef _WIN32
+#  include "ThreadWin32.cpp"
+#else /* !_WIN32 */
+#  include "ThreadPosix.cpp"
+#endif
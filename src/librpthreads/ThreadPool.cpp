@@ -0,0 +1,481 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpthreads)                     *
+ * ThreadPool.cpp: Process-wide work-stealing thread pool.                 *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "ThreadPool.hpp"
+#include "Thread.hpp"
+#include "pthread_once.h"
+
+// C includes
+#ifdef _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN 1
+#  endif
+#  include <windows.h>
+#else /* !_WIN32 */
+#  include <unistd.h>
+#endif /* _WIN32 */
+
+// C includes (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+
+// C++ includes
+#include <deque>
+
+namespace LibRpThreads {
+
+namespace {
+
+// Maximum number of threads if not specified.
+const unsigned int DEFAULT_MAX_THREADS = 8;
+
+// Maximum number of threads set by ThreadPool::setMaxThreads().
+unsigned int max_threads_override = 0;
+
+// Process-wide thread pool.
+ThreadPool *pool_instance = nullptr;
+
+// pthread_once() control variable
+pthread_once_t once_control = PTHREAD_ONCE_INIT;
+
+// Current thread's queue index.
+// 0 is the shared queue, used by threads that aren't in the pool.
+thread_local unsigned int tls_queue_idx = 0;
+
+struct Task {
+	ThreadPool::TaskFunc func;
+	void *param;
+	TaskGroup *group;
+};
+
+struct TaskQueue {
+	Mutex mutex;
+	std::deque<Task> tasks;
+};
+
+/**
+ * Obtain a semaphore, retrying if interrupted by a signal.
+ * @param sem Semaphore
+ */
+inline void obtain_sem(Semaphore &sem)
+{
+	while (sem.obtain() != 0) {
+		if (errno != EINTR)
+			break;
+	}
+}
+
+/**
+ * Get the number of online CPUs.
+ * @return Number of CPUs
+ */
+unsigned int get_cpu_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return (si.dwNumberOfProcessors > 0 ? si.dwNumberOfProcessors : 1);
+#else /* !_WIN32 */
+	const long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0 ? static_cast<unsigned int>(n) : 1);
+#endif /* _WIN32 */
+}
+
+}
+
+/** ThreadPoolPrivate **/
+
+class ThreadPoolPrivate
+{
+	public:
+		explicit ThreadPoolPrivate(unsigned int workerCount);
+		~ThreadPoolPrivate();
+
+	private:
+#if __cplusplus >= 201103L
+		ThreadPoolPrivate(const ThreadPoolPrivate &) = delete;
+		ThreadPoolPrivate &operator=(const ThreadPoolPrivate &) = delete;
+#else /* __cplusplus < 201103L */
+		ThreadPoolPrivate(const ThreadPoolPrivate &);
+		ThreadPoolPrivate &operator=(const ThreadPoolPrivate &);
+#endif /* __cplusplus */
+
+	public:
+		/**
+		 * Initialize the process-wide thread pool.
+		 * Called by pthread_once().
+		 */
+		static void initInstance(void);
+
+		/**
+		 * Shut down the process-wide thread pool on exit.
+		 */
+		static void destroyInstance(void);
+
+		/**
+		 * Add a task to the current thread's queue.
+		 * @param task Task
+		 */
+		void push(const Task &task);
+
+		/**
+		 * Get a task from the current thread's queue,
+		 * or steal one from another queue.
+		 * @param task [out] Task
+		 * @return True if a task was retrieved; false if all queues are empty.
+		 */
+		bool pop(Task &task);
+
+		/**
+		 * Run a task.
+		 * @param task Task
+		 */
+		static void execute(const Task &task);
+
+		/**
+		 * Worker thread function.
+		 * @param param WorkerParam
+		 */
+		static void worker(void *param);
+
+	public:
+		struct WorkerParam {
+			ThreadPoolPrivate *d;
+			unsigned int idx;
+		};
+
+		unsigned int workerCount;
+		std::vector<TaskQueue*> queues;		// [0] is the shared queue; [1..n] are per-worker.
+		std::vector<Thread*> threads;
+		std::vector<WorkerParam> params;
+		Semaphore workAvail;			// Released once per submitted task.
+		volatile bool quit;
+};
+
+ThreadPoolPrivate::ThreadPoolPrivate(unsigned int workerCount)
+	: workerCount(0)
+	, workAvail(0)
+	, quit(false)
+{
+	queues.reserve(workerCount + 1);
+	for (unsigned int i = 0; i <= workerCount; i++) {
+		queues.push_back(new TaskQueue());
+	}
+
+	// Start the worker threads.
+	// NOTE: params must not be reallocated after the threads start.
+	params.resize(workerCount);
+	threads.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; i++) {
+		params[i].d = this;
+		params[i].idx = i + 1;
+		Thread *const thread = new Thread();
+		if (thread->start(worker, &params[i]) != 0) {
+			// Unable to start the thread.
+			// Use the threads we have so far.
+			delete thread;
+			break;
+		}
+		threads.push_back(thread);
+	}
+	this->workerCount = static_cast<unsigned int>(threads.size());
+}
+
+ThreadPoolPrivate::~ThreadPoolPrivate()
+{
+	// Stop the worker threads.
+	quit = true;
+	for (size_t i = 0; i < threads.size(); i++) {
+		workAvail.release();
+	}
+	for (Thread *thread : threads) {
+#ifdef _WIN32
+		// Waiting for a thread while a DLL is being unloaded
+		// can deadlock on the loader lock.
+		thread->detach();
+#else /* !_WIN32 */
+		thread->join();
+#endif /* _WIN32 */
+		delete thread;
+	}
+
+	for (TaskQueue *queue : queues) {
+		delete queue;
+	}
+}
+
+/**
+ * Initialize the process-wide thread pool.
+ * Called by pthread_once().
+ */
+void ThreadPoolPrivate::initInstance(void)
+{
+	unsigned int maxThreads = max_threads_override;
+	if (maxThreads == 0) {
+		const char *const env = getenv("RP_MAX_THREADS");
+		if (env && env[0] != '\0') {
+			const long n = strtol(env, nullptr, 10);
+			if (n > 0) {
+				maxThreads = static_cast<unsigned int>(n);
+			}
+		}
+	}
+	if (maxThreads == 0) {
+		maxThreads = get_cpu_count();
+		if (maxThreads > DEFAULT_MAX_THREADS) {
+			maxThreads = DEFAULT_MAX_THREADS;
+		}
+	}
+
+	// The calling thread also runs tasks, so one less worker is needed.
+	pool_instance = new ThreadPool(maxThreads - 1);
+	atexit(destroyInstance);
+}
+
+/**
+ * Shut down the process-wide thread pool on exit.
+ */
+void ThreadPoolPrivate::destroyInstance(void)
+{
+	delete pool_instance;
+	pool_instance = nullptr;
+}
+
+/**
+ * Add a task to the current thread's queue.
+ * @param task Task
+ */
+void ThreadPoolPrivate::push(const Task &task)
+{
+	TaskQueue *const queue = queues[tls_queue_idx];
+	{
+		MutexLocker locker(queue->mutex);
+		queue->tasks.push_back(task);
+	}
+	workAvail.release();
+}
+
+/**
+ * Get a task from the current thread's queue,
+ * or steal one from another queue.
+ * @param task [out] Task
+ * @return True if a task was retrieved; false if all queues are empty.
+ */
+bool ThreadPoolPrivate::pop(Task &task)
+{
+	const unsigned int idx = tls_queue_idx;
+
+	// Check our own queue first. (LIFO for cache locality)
+	{
+		TaskQueue *const queue = queues[idx];
+		MutexLocker locker(queue->mutex);
+		if (!queue->tasks.empty()) {
+			task = queue->tasks.back();
+			queue->tasks.pop_back();
+			return true;
+		}
+	}
+
+	// Steal from the other queues. (FIFO, since older tasks
+	// are usually larger chunks of work)
+	const unsigned int count = static_cast<unsigned int>(queues.size());
+	for (unsigned int i = 1; i < count; i++) {
+		TaskQueue *const queue = queues[(idx + i) % count];
+		MutexLocker locker(queue->mutex);
+		if (!queue->tasks.empty()) {
+			task = queue->tasks.front();
+			queue->tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Run a task.
+ * @param task Task
+ */
+void ThreadPoolPrivate::execute(const Task &task)
+{
+	if (!task.group->isCancelled()) {
+		task.func(task.param);
+	}
+	task.group->taskDone();
+}
+
+/**
+ * Worker thread function.
+ * @param param WorkerParam
+ */
+void ThreadPoolPrivate::worker(void *param)
+{
+	const WorkerParam *const wp = static_cast<const WorkerParam*>(param);
+	ThreadPoolPrivate *const d = wp->d;
+	tls_queue_idx = wp->idx;
+
+	for (;;) {
+		obtain_sem(d->workAvail);
+		if (d->quit)
+			break;
+
+		// Run tasks until all queues are empty.
+		// NOTE: A task may have been run by a waiting thread already.
+		Task task;
+		while (d->pop(task)) {
+			execute(task);
+		}
+	}
+}
+
+/** ThreadPool **/
+
+ThreadPool::ThreadPool(unsigned int workerCount)
+	: d_ptr(new ThreadPoolPrivate(workerCount))
+{ }
+
+ThreadPool::~ThreadPool()
+{
+	delete d_ptr;
+}
+
+/**
+ * Get the process-wide thread pool.
+ * The worker threads are started on the first call.
+ * @return Thread pool
+ */
+ThreadPool *ThreadPool::instance(void)
+{
+	pthread_once(&once_control, ThreadPoolPrivate::initInstance);
+	return pool_instance;
+}
+
+/**
+ * Set the maximum number of threads to use for parallel work,
+ * including the calling thread. This must be called before the
+ * thread pool is first used.
+ *
+ * The default is the number of CPUs, up to 8. This can also be
+ * set using the RP_MAX_THREADS environment variable.
+ *
+ * @param maxThreads Maximum number of threads (0 for the default; 1 to disable worker threads)
+ */
+void ThreadPool::setMaxThreads(unsigned int maxThreads)
+{
+	max_threads_override = maxThreads;
+}
+
+/**
+ * Get the number of worker threads.
+ * This does not include the calling thread.
+ * @return Number of worker threads
+ */
+unsigned int ThreadPool::workerCount(void) const
+{
+	return d_ptr->workerCount;
+}
+
+/**
+ * Submit a task.
+ * @param group Task group
+ * @param func Task function
+ * @param param User-specified parameter
+ */
+void ThreadPool::submit(TaskGroup *group, TaskFunc func, void *param)
+{
+	Task task;
+	task.func = func;
+	task.param = param;
+	task.group = group;
+	d_ptr->push(task);
+}
+
+/**
+ * Run one pending task on the current thread, if any are available.
+ * @return True if a task was run; false if no tasks were available.
+ */
+bool ThreadPool::runPendingTask(void)
+{
+	Task task;
+	if (!d_ptr->pop(task))
+		return false;
+	ThreadPoolPrivate::execute(task);
+	return true;
+}
+
+/** TaskGroup **/
+
+/**
+ * Run a task in this group.
+ * @param func Task function
+ * @param param User-specified parameter
+ */
+void TaskGroup::run(ThreadPool::TaskFunc func, void *param)
+{
+	ThreadPool *const pool = this->pool();
+	{
+		MutexLocker locker(m_mutex);
+		m_pending++;
+	}
+	pool->submit(this, func, param);
+}
+
+/**
+ * Wait for all tasks in this group to finish.
+ * Pending tasks are run on the calling thread while waiting.
+ */
+void TaskGroup::wait(void)
+{
+	if (!m_pool) {
+		// No tasks were ever run.
+		return;
+	}
+
+	for (;;) {
+		{
+			MutexLocker locker(m_mutex);
+			if (m_pending == 0)
+				return;
+		}
+
+		// Help out by running a pending task.
+		// NOTE: This might be a task from a different group.
+		if (m_pool->runPendingTask())
+			continue;
+
+		// No tasks are queued, but some of this group's tasks are
+		// still running on other threads. Wait for them to finish.
+		{
+			MutexLocker locker(m_mutex);
+			if (m_pending == 0)
+				return;
+			m_waiting = true;
+		}
+		obtain_sem(m_done);
+	}
+}
+
+/**
+ * A task in this group has finished.
+ * Called by ThreadPoolPrivate.
+ */
+void TaskGroup::taskDone(void)
+{
+	// NOTE: The semaphore is released while holding the mutex,
+	// since wait() may return (and the TaskGroup may be deleted)
+	// as soon as the mutex is unlocked.
+	MutexLocker locker(m_mutex);
+	assert(m_pending > 0);
+	if (--m_pending == 0 && m_waiting) {
+		m_waiting = false;
+		m_done.release();
+	}
+}
+
+}
@@ -0,0 +1,290 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpthreads)                     *
+ * ThreadPool.hpp: Process-wide work-stealing thread pool.                 *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "Mutex.hpp"
+#include "Semaphore.hpp"
+
+// C includes
+#include <stdint.h>
+
+// C++ includes
+#include <vector>
+
+namespace LibRpThreads {
+
+class TaskGroup;
+class ThreadPoolPrivate;
+
+/**
+ * Process-wide work-stealing thread pool.
+ *
+ * Each worker thread has its own task queue. Tasks submitted from a
+ * worker thread are added to that thread's queue; tasks submitted from
+ * any other thread are added to a shared queue. Idle workers steal
+ * tasks from the other queues.
+ *
+ * Threads that wait on a TaskGroup run pending tasks while waiting,
+ * so the calling thread is used as one of the pool's threads.
+ *
+ * Worker threads sleep on a semaphore when there's no work, so idle
+ * workers don't use any CPU time.
+ */
+class ThreadPool
+{
+	private:
+		explicit ThreadPool(unsigned int workerCount);
+		~ThreadPool();
+
+	private:
+#if __cplusplus >= 201103L
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool &operator=(const ThreadPool &) = delete;
+#else /* __cplusplus < 201103L */
+		ThreadPool(const ThreadPool &);
+		ThreadPool &operator=(const ThreadPool &);
+#endif /* __cplusplus */
+	private:
+		friend class TaskGroup;
+		friend class ThreadPoolPrivate;
+		ThreadPoolPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Task function.
+		 * @param param User-specified parameter
+		 */
+		typedef void (*TaskFunc)(void *param);
+
+		/**
+		 * Get the process-wide thread pool.
+		 * The worker threads are started on the first call.
+		 * @return Thread pool
+		 */
+		static ThreadPool *instance(void);
+
+		/**
+		 * Set the maximum number of threads to use for parallel work,
+		 * including the calling thread. This must be called before the
+		 * thread pool is first used.
+		 *
+		 * The default is the number of CPUs, up to 8. This can also be
+		 * set using the RP_MAX_THREADS environment variable.
+		 *
+		 * @param maxThreads Maximum number of threads (0 for the default; 1 to disable worker threads)
+		 */
+		static void setMaxThreads(unsigned int maxThreads);
+
+		/**
+		 * Get the number of worker threads.
+		 * This does not include the calling thread.
+		 * @return Number of worker threads
+		 */
+		unsigned int workerCount(void) const;
+
+	private:
+		/**
+		 * Submit a task.
+		 * @param group Task group
+		 * @param func Task function
+		 * @param param User-specified parameter
+		 */
+		void submit(TaskGroup *group, TaskFunc func, void *param);
+
+		/**
+		 * Run one pending task on the current thread, if any are available.
+		 * @return True if a task was run; false if no tasks were available.
+		 */
+		bool runPendingTask(void);
+};
+
+/**
+ * Group of tasks that can be waited on and cancelled together.
+ */
+class TaskGroup
+{
+	public:
+		/**
+		 * Create a task group.
+		 * @param pool Thread pool (If nullptr, the process-wide pool is used.)
+		 */
+		explicit TaskGroup(ThreadPool *pool = nullptr)
+			: m_pool(pool)
+			, m_pending(0)
+			, m_waiting(false)
+			, m_cancelled(false)
+			, m_done(0)
+		{ }
+
+		/**
+		 * Wait for all tasks to finish, then delete the task group.
+		 */
+		~TaskGroup()
+		{
+			wait();
+		}
+
+	private:
+#if __cplusplus >= 201103L
+		TaskGroup(const TaskGroup &) = delete;
+		TaskGroup &operator=(const TaskGroup &) = delete;
+#else /* __cplusplus < 201103L */
+		TaskGroup(const TaskGroup &);
+		TaskGroup &operator=(const TaskGroup &);
+#endif /* __cplusplus */
+		friend class ThreadPoolPrivate;
+
+	public:
+		/**
+		 * Run a task in this group.
+		 * @param func Task function
+		 * @param param User-specified parameter
+		 */
+		void run(ThreadPool::TaskFunc func, void *param);
+
+		/**
+		 * Wait for all tasks in this group to finish.
+		 * Pending tasks are run on the calling thread while waiting.
+		 */
+		void wait(void);
+
+		/**
+		 * Cancel the task group.
+		 * Tasks that haven't started yet will not be run.
+		 * Running tasks should check isCancelled() periodically.
+		 */
+		inline void cancel(void)
+		{
+			m_cancelled = true;
+		}
+
+		/**
+		 * Has the task group been cancelled?
+		 * @return True if cancelled; false if not.
+		 */
+		inline bool isCancelled(void) const
+		{
+			return m_cancelled;
+		}
+
+		/**
+		 * Get the thread pool used by this task group.
+		 * @return Thread pool
+		 */
+		inline ThreadPool *pool(void)
+		{
+			if (!m_pool) {
+				m_pool = ThreadPool::instance();
+			}
+			return m_pool;
+		}
+
+	private:
+		/**
+		 * A task in this group has finished.
+		 * Called by ThreadPoolPrivate.
+		 */
+		void taskDone(void);
+
+	private:
+		ThreadPool *m_pool;
+		Mutex m_mutex;		// Protects m_pending and m_waiting.
+		int m_pending;		// Number of tasks that haven't finished yet.
+		bool m_waiting;		// True if wait() is blocked on m_done.
+		volatile bool m_cancelled;
+		Semaphore m_done;	// Released when m_pending reaches 0 while waiting.
+};
+
+/**
+ * Range of iterations for parallel_for().
+ * @tparam Body Loop body
+ */
+template<typename Body>
+struct ParallelForRange {
+	const Body *body;
+	TaskGroup *group;
+	int begin;
+	int end;
+
+	static void exec(void *param)
+	{
+		const ParallelForRange *const range = static_cast<const ParallelForRange*>(param);
+		for (int i = range->begin; i < range->end; i++) {
+			if (range->group->isCancelled())
+				break;
+			(*range->body)(i);
+		}
+	}
+};
+
+/**
+ * Run a loop body for each index in [begin, end) using the thread pool.
+ *
+ * The range is split into more chunks than there are threads so
+ * idle threads can steal work from busy ones. The calling thread
+ * runs chunks too, and this function returns when all iterations
+ * have finished.
+ *
+ * If the task group is cancelled, remaining iterations are skipped.
+ *
+ * @param group Task group
+ * @param begin First index
+ * @param end Last index, plus one
+ * @param body Loop body, called as body(int)
+ * @param parallel If false, run the loop on the calling thread only. (e.g. for small images)
+ */
+template<typename Body>
+static inline void parallel_for(TaskGroup &group, int begin, int end, const Body &body, bool parallel = true)
+{
+	if (begin >= end)
+		return;
+
+	const unsigned int workers = (parallel ? group.pool()->workerCount() : 0);
+	const int count = end - begin;
+	if (workers == 0 || count == 1) {
+		// Run the loop on the calling thread.
+		for (int i = begin; i < end; i++) {
+			if (group.isCancelled())
+				break;
+			body(i);
+		}
+		return;
+	}
+
+	// Split the range into chunks.
+	const unsigned int max_chunks = (workers + 1) * 4;
+	const int chunks = (static_cast<unsigned int>(count) < max_chunks)
+		? count : static_cast<int>(max_chunks);
+	std::vector<ParallelForRange<Body> > ranges(chunks);
+	for (int i = 0; i < chunks; i++) {
+		ParallelForRange<Body> &range = ranges[i];
+		range.body = &body;
+		range.group = &group;
+		range.begin = begin + static_cast<int>((static_cast<int64_t>(count) * i) / chunks);
+		range.end = begin + static_cast<int>((static_cast<int64_t>(count) * (i + 1)) / chunks);
+		group.run(ParallelForRange<Body>::exec, &range);
+	}
+	group.wait();
+}
+
+/**
+ * Run a loop body for each index in [begin, end) using the thread pool.
+ * @param begin First index
+ * @param end Last index, plus one
+ * @param body Loop body, called as body(int)
+ * @param parallel If false, run the loop on the calling thread only. (e.g. for small images)
+ */
+template<typename Body>
+static inline void parallel_for(int begin, int end, const Body &body, bool parallel = true)
+{
+	TaskGroup group;
+	parallel_for(group, begin, end, body, parallel);
+}
+
+}
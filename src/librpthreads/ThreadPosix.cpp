@@ -0,0 +1,183 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpthreads)                     *
+ * ThreadPosix.cpp: POSIX thread implementation.                           *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include <pthread.h>
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+
+namespace LibRpThreads {
+
+class Thread
+{
+	public:
+		/**
+		 * Thread function.
+		 * @param param User-specified parameter
+		 */
+		typedef void (*ThreadFunc)(void *param);
+
+		/**
+		 * Create a thread object.
+		 * The thread is not started until start() is called.
+		 */
+		inline explicit Thread();
+
+		/**
+		 * Delete the thread object.
+		 * If the thread is still running, this will block
+		 * until the thread exits.
+		 */
+		inline ~Thread();
+
+	private:
+#if __cplusplus >= 201103L
+		Thread(const Thread &) = delete; \
+		Thread &operator=(const Thread &) = delete;
+#else /* __cplusplus < 201103L */
+		Thread(const Thread &); \
+		Thread &operator=(const Thread &);
+#endif /* __cplusplus */
+
+	public:
+		/**
+		 * Start the thread.
+		 * @param func Thread function
+		 * @param param User-specified parameter
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int start(ThreadFunc func, void *param);
+
+		/**
+		 * Wait for the thread to exit.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int join(void);
+
+		/**
+		 * Detach the thread.
+		 * The thread's resources are released when it exits.
+		 * join() cannot be used afterwards.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int detach(void);
+
+		/**
+		 * Has the thread been started and not yet joined?
+		 * @return True if the thread is joinable; false if not.
+		 */
+		inline bool isJoinable(void) const
+		{
+			return m_isStarted;
+		}
+
+	private:
+		/**
+		 * pthread start routine.
+		 * @param arg Thread object
+		 * @return nullptr
+		 */
+		static void *start_routine(void *arg)
+		{
+			Thread *const thread = static_cast<Thread*>(arg);
+			thread->m_func(thread->m_param);
+			return nullptr;
+		}
+
+	private:
+		pthread_t m_thread;
+		ThreadFunc m_func;
+		void *m_param;
+		bool m_isStarted;
+};
+
+/**
+ * Create a thread object.
+ * The thread is not started until start() is called.
+ */
+inline Thread::Thread()
+	: m_func(nullptr)
+	, m_param(nullptr)
+	, m_isStarted(false)
+{ }
+
+/**
+ * Delete the thread object.
+ * If the thread is still running, this will block
+ * until the thread exits.
+ */
+inline Thread::~Thread()
+{
+	if (m_isStarted) {
+		join();
+	}
+}
+
+/**
+ * Start the thread.
+ * @param func Thread function
+ * @param param User-specified parameter
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::start(ThreadFunc func, void *param)
+{
+	assert(func != nullptr);
+	assert(!m_isStarted);
+	if (!func)
+		return -EINVAL;
+	if (m_isStarted)
+		return -EBUSY;
+
+	m_func = func;
+	m_param = param;
+	int ret = pthread_create(&m_thread, nullptr, start_routine, this);
+	if (ret != 0) {
+		return -ret;
+	}
+	m_isStarted = true;
+	return 0;
+}
+
+/**
+ * Wait for the thread to exit.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::join(void)
+{
+	if (!m_isStarted)
+		return -ESRCH;
+
+	int ret = pthread_join(m_thread, nullptr);
+	if (ret != 0) {
+		return -ret;
+	}
+	m_isStarted = false;
+	return 0;
+}
+
+/**
+ * Detach the thread.
+ * The thread's resources are released when it exits.
+ * join() cannot be used afterwards.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::detach(void)
+{
+	if (!m_isStarted)
+		return -ESRCH;
+
+	int ret = pthread_detach(m_thread);
+	if (ret != 0) {
+		return -ret;
+	}
+	m_isStarted = false;
+	return 0;
+}
+
+}
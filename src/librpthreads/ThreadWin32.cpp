@@ -0,0 +1,184 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpthreads)                     *
+ * ThreadWin32.cpp: Win32 thread implementation.                           *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+
+#ifndef WIN32_LEAN_AND_MEAN
+# define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#include <process.h>
+
+namespace LibRpThreads {
+
+class Thread
+{
+	public:
+		/**
+		 * Thread function.
+		 * @param param User-specified parameter
+		 */
+		typedef void (*ThreadFunc)(void *param);
+
+		/**
+		 * Create a thread object.
+		 * The thread is not started until start() is called.
+		 */
+		inline explicit Thread();
+
+		/**
+		 * Delete the thread object.
+		 * If the thread is still running, this will block
+		 * until the thread exits.
+		 */
+		inline ~Thread();
+
+	private:
+#if __cplusplus >= 201103L
+		Thread(const Thread &) = delete; \
+		Thread &operator=(const Thread &) = delete;
+#else /* __cplusplus < 201103L */
+		Thread(const Thread &); \
+		Thread &operator=(const Thread &);
+#endif /* __cplusplus */
+
+	public:
+		/**
+		 * Start the thread.
+		 * @param func Thread function
+		 * @param param User-specified parameter
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int start(ThreadFunc func, void *param);
+
+		/**
+		 * Wait for the thread to exit.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int join(void);
+
+		/**
+		 * Detach the thread.
+		 * The thread's resources are released when it exits.
+		 * join() cannot be used afterwards.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int detach(void);
+
+		/**
+		 * Has the thread been started and not yet joined?
+		 * @return True if the thread is joinable; false if not.
+		 */
+		inline bool isJoinable(void) const
+		{
+			return (m_hThread != nullptr);
+		}
+
+	private:
+		/**
+		 * _beginthreadex() start address.
+		 * @param arg Thread object
+		 * @return 0
+		 */
+		static unsigned int __stdcall start_address(void *arg)
+		{
+			Thread *const thread = static_cast<Thread*>(arg);
+			thread->m_func(thread->m_param);
+			return 0;
+		}
+
+	private:
+		HANDLE m_hThread;
+		ThreadFunc m_func;
+		void *m_param;
+};
+
+/**
+ * Create a thread object.
+ * The thread is not started until start() is called.
+ */
+inline Thread::Thread()
+	: m_hThread(nullptr)
+	, m_func(nullptr)
+	, m_param(nullptr)
+{ }
+
+/**
+ * Delete the thread object.
+ * If the thread is still running, this will block
+ * until the thread exits.
+ */
+inline Thread::~Thread()
+{
+	if (m_hThread) {
+		join();
+	}
+}
+
+/**
+ * Start the thread.
+ * @param func Thread function
+ * @param param User-specified parameter
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::start(ThreadFunc func, void *param)
+{
+	assert(func != nullptr);
+	assert(m_hThread == nullptr);
+	if (!func)
+		return -EINVAL;
+	if (m_hThread)
+		return -EBUSY;
+
+	m_func = func;
+	m_param = param;
+	m_hThread = reinterpret_cast<HANDLE>(_beginthreadex(nullptr, 0, start_address, this, 0, nullptr));
+	if (!m_hThread) {
+		// _beginthreadex() sets errno on error.
+		int err = errno;
+		return (err != 0 ? -err : -EAGAIN);
+	}
+	return 0;
+}
+
+/**
+ * Wait for the thread to exit.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::join(void)
+{
+	if (!m_hThread)
+		return -ESRCH;
+
+	if (WaitForSingleObject(m_hThread, INFINITE) != WAIT_OBJECT_0) {
+		return -EIO;
+	}
+	CloseHandle(m_hThread);
+	m_hThread = nullptr;
+	return 0;
+}
+
+/**
+ * Detach the thread.
+ * The thread's resources are released when it exits.
+ * join() cannot be used afterwards.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::detach(void)
+{
+	if (!m_hThread)
+		return -ESRCH;
+
+	CloseHandle(m_hThread);
+	m_hThread = nullptr;
+	return 0;
+}
+
+}
@@ -0,0 +1,238 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpthreads/tests)               *
+ * ThreadPoolTest.cpp: ThreadPool, TaskGroup, and parallel_for() tests.    *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// librpthreads
+#include "librpthreads/ThreadPool.hpp"
+using namespace LibRpThreads;
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstdlib>
+
+// C++ includes
+#include <atomic>
+#include <thread>
+#include <vector>
+using std::vector;
+
+namespace LibRpThreads { namespace Tests {
+
+class ThreadPoolTest : public ::testing::Test
+{
+	protected:
+		/**
+		 * Get the thread count from RP_MAX_THREADS.
+		 * @return Thread count, or 0 if not set.
+		 */
+		static unsigned int envMaxThreads(void)
+		{
+			const char *const env = getenv("RP_MAX_THREADS");
+			if (!env || env[0] == '\0')
+				return 0;
+			const long n = strtol(env, nullptr, 10);
+			return (n > 0 ? static_cast<unsigned int>(n) : 0);
+		}
+
+		static void countTask(void *param)
+		{
+			static_cast<std::atomic<int>*>(param)->fetch_add(1);
+		}
+};
+
+/**
+ * parallel_for() runs every iteration exactly once.
+ */
+TEST_F(ThreadPoolTest, parallelForTest)
+{
+	static const int COUNT = 100000;
+	vector<int> hits(COUNT, 0);
+	parallel_for(0, COUNT, [&hits](int i) {
+		hits[i]++;
+	});
+
+	for (int i = 0; i < COUNT; i++) {
+		ASSERT_EQ(1, hits[i]) << "index " << i;
+	}
+
+	// Empty and single-iteration ranges.
+	int calls = 0;
+	parallel_for(5, 5, [&calls](int) { calls++; });
+	EXPECT_EQ(0, calls);
+	parallel_for(5, 6, [&calls](int i) { EXPECT_EQ(5, i); calls++; });
+	EXPECT_EQ(1, calls);
+}
+
+/**
+ * parallel_for() with parallel == false runs on the calling thread.
+ */
+TEST_F(ThreadPoolTest, parallelForSerialTest)
+{
+	const std::thread::id self = std::this_thread::get_id();
+	std::atomic<int> otherThread(0);
+	parallel_for(0, 10000, [&](int) {
+		if (std::this_thread::get_id() != self) {
+			otherThread++;
+		}
+	}, false);
+	EXPECT_EQ(0, otherThread.load());
+}
+
+/**
+ * Tasks added after a task group is cancelled aren't run.
+ */
+TEST_F(ThreadPoolTest, cancelBeforeRunTest)
+{
+	std::atomic<int> count(0);
+	TaskGroup group;
+	group.cancel();
+	EXPECT_TRUE(group.isCancelled());
+	for (int i = 0; i < 100; i++) {
+		group.run(countTask, &count);
+	}
+	group.wait();
+	EXPECT_EQ(0, count.load());
+}
+
+/**
+ * Cancelling a task group from within parallel_for()
+ * skips the remaining iterations.
+ */
+TEST_F(ThreadPoolTest, cancelParallelForTest)
+{
+	static const int COUNT = 1000000;
+	static const int CANCEL_AT = 1000;
+	std::atomic<int> count(0);
+	TaskGroup group;
+	parallel_for(group, 0, COUNT, [&](int) {
+		if (++count == CANCEL_AT) {
+			group.cancel();
+		}
+	});
+
+	EXPECT_TRUE(group.isCancelled());
+	EXPECT_GE(count.load(), CANCEL_AT);
+	EXPECT_LT(count.load(), COUNT);
+
+	// Cancelling one group doesn't affect other groups.
+	std::atomic<int> count2(0);
+	parallel_for(0, 1000, [&](int) { count2++; });
+	EXPECT_EQ(1000, count2.load());
+}
+
+/**
+ * wait() can be called from within a task, e.g. nested parallel_for().
+ * The waiting thread runs pending tasks, so this doesn't deadlock
+ * even if every worker thread is waiting.
+ */
+TEST_F(ThreadPoolTest, nestedWaitTest)
+{
+	static const int OUTER = 64;
+	static const int INNER = 1000;
+	vector<vector<int> > hits(OUTER, vector<int>(INNER, 0));
+	parallel_for(0, OUTER, [&hits](int i) {
+		vector<int> &row = hits[i];
+		parallel_for(0, INNER, [&row](int j) {
+			row[j]++;
+		});
+	});
+
+	for (int i = 0; i < OUTER; i++) {
+		for (int j = 0; j < INNER; j++) {
+			ASSERT_EQ(1, hits[i][j]) << "index " << i << ", " << j;
+		}
+	}
+}
+
+/**
+ * wait() on a task group from within another group's task.
+ */
+TEST_F(ThreadPoolTest, nestedTaskGroupTest)
+{
+	struct Param {
+		std::atomic<int> count;
+	};
+	Param param;
+	param.count = 0;
+
+	TaskGroup outer;
+	for (int i = 0; i < 16; i++) {
+		outer.run([](void *p) {
+			TaskGroup inner;
+			for (int j = 0; j < 16; j++) {
+				inner.run(countTask, &static_cast<Param*>(p)->count);
+			}
+			inner.wait();
+		}, &param);
+	}
+	outer.wait();
+	EXPECT_EQ(16 * 16, param.count.load());
+
+	// wait() on a group that has no tasks returns immediately.
+	TaskGroup empty;
+	empty.wait();
+	outer.wait();
+}
+
+/**
+ * RP_MAX_THREADS sets the number of threads.
+ * With RP_MAX_THREADS=1, there are no worker threads,
+ * so everything runs on the calling thread.
+ */
+TEST_F(ThreadPoolTest, maxThreadsTest)
+{
+	const unsigned int maxThreads = envMaxThreads();
+	ThreadPool *const pool = ThreadPool::instance();
+	ASSERT_NE(nullptr, pool);
+	if (maxThreads == 0) {
+		// Default thread count: number of CPUs, up to 8.
+		EXPECT_LE(pool->workerCount(), 7U);
+		return;
+	}
+	EXPECT_EQ(maxThreads - 1, pool->workerCount());
+	if (maxThreads != 1)
+		return;
+
+	const std::thread::id self = std::this_thread::get_id();
+	std::atomic<int> otherThread(0);
+	std::atomic<int> count(0);
+	parallel_for(0, 10000, [&](int) {
+		if (std::this_thread::get_id() != self) {
+			otherThread++;
+		}
+		count++;
+	});
+	EXPECT_EQ(0, otherThread.load());
+	EXPECT_EQ(10000, count.load());
+
+	// TaskGroup::wait() runs the tasks on the calling thread.
+	TaskGroup group;
+	for (int i = 0; i < 100; i++) {
+		group.run(countTask, &count);
+	}
+	group.wait();
+	EXPECT_EQ(10100, count.load());
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fputs("LibRpThreads test suite: ThreadPool tests.\n\n", stderr);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -12,23 +12,30 @@
 // C++ STL classes.
 using std::string;
 
-// cURL for network access.
-#include <curl/curl.h>
-
 namespace RpDownload {
 
 CurlDownloader::CurlDownloader()
 	: super()
+	, m_curl(nullptr)
 { }
 
 CurlDownloader::CurlDownloader(const TCHAR *url)
 	: super(url)
+	, m_curl(nullptr)
 { }
 
 CurlDownloader::CurlDownloader(const tstring &url)
 	: super(url)
+	, m_curl(nullptr)
 { }
 
+CurlDownloader::~CurlDownloader()
+{
+	if (m_curl) {
+		curl_easy_cleanup(m_curl);
+	}
+}
+
 /**
  * Internal cURL data write function.
  * @param ptr Data to write.
@@ -151,10 +158,13 @@ size_t CurlDownloader::parse_header(char *ptr, size_t size, size_t nitems, void
 }
 
 /**
- * Download the file.
- * @return 0 on success; negative POSIX error code, positive HTTP status code on error.
+ * Prepare the cURL easy handle for a transfer.
+ * The easy handle is kept across transfers so live
+ * connections and the DNS cache can be reused.
+ * @param share cURL share handle, or nullptr for none.
+ * @return cURL easy handle, or nullptr on error.
  */
-int CurlDownloader::download(void)
+CURL *CurlDownloader::prepareTransfer(CURLSH *share)
 {
 	// References:
 	// - http://stackoverflow.com/questions/1636333/download-file-using-libcurl-in-c-c
@@ -165,12 +175,20 @@ int CurlDownloader::download(void)
 	m_data.clear();
 	m_mtime = -1;
 
-	// Initialize cURL.
-	CURL *curl = curl_easy_init();
-	if (!curl) {
-		// Could not initialize cURL.
-		return -ENOMEM;	// TODO: Better error?
+	if (m_curl) {
+		// Reset the options from the previous transfer.
+		// NOTE: curl_easy_reset() keeps live connections,
+		// the DNS cache, and the TLS session cache.
+		curl_easy_reset(m_curl);
+	} else {
+		// Initialize cURL.
+		m_curl = curl_easy_init();
+		if (!m_curl) {
+			// Could not initialize cURL.
+			return nullptr;
+		}
 	}
+	CURL *const curl = m_curl;
 
 	// Proxy settings should be set by the calling application
 	// in the http_proxy and https_proxy variables.
@@ -189,6 +207,18 @@ int CurlDownloader::download(void)
 	// NOTE: Probably not needed for http...
 	curl_easy_setopt(curl, CURLOPT_FILETIME, 1L);
 
+	// Keep connections alive between requests.
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+#if LIBCURL_VERSION_NUM >= 0x072B00
+	// Prefer HTTP/2 over TLS, and wait for an existing connection
+	// to be multiplexed instead of opening a new one.
+	curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+	curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+#endif /* LIBCURL_VERSION_NUM >= 0x072B00 */
+	if (share) {
+		curl_easy_setopt(curl, CURLOPT_SHARE, share);
+	}
+
 	if (m_if_modified_since >= 0) {
 		// Add an "If-Modified-Since" header.
 #if LIBCURL_VERSION_NUM >= 0x073B00
@@ -204,6 +234,8 @@ int CurlDownloader::download(void)
 	curl_easy_setopt(curl, CURLOPT_HEADERDATA, this);
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
 	curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+	// Used by CurlMultiDownloader to find this object.
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, this);
 
 	// Don't use signals. We're running as a plugin, so using
 	// signals might interfere.
@@ -219,15 +251,27 @@ int CurlDownloader::download(void)
 	// Set the User-Agent.
 	curl_easy_setopt(curl, CURLOPT_USERAGENT, m_userAgent.c_str());
 
-	// Download the file.
+	m_inProgress = true;
+	return curl;
+}
+
+/**
+ * Process the result of a completed transfer.
+ * @param res cURL result code.
+ * @return 0 on success; negative POSIX error code, positive HTTP status code on error.
+ */
+int CurlDownloader::finishTransfer(CURLcode res)
+{
+	assert(m_curl != nullptr);
+	m_inProgress = false;
+
 	int ret;
-	CURLcode res = curl_easy_perform(curl);
 	switch (res) {
 		case CURLE_OK:
 			// If the file is empty, check for a 304.
 			if (m_data.empty() && m_if_modified_since >= 0) {
 				long unmet = 0;
-				if (!curl_easy_getinfo(curl, CURLINFO_CONDITION_UNMET, &unmet) && unmet) {
+				if (!curl_easy_getinfo(m_curl, CURLINFO_CONDITION_UNMET, &unmet) && unmet) {
 					// HTTP 304 Not Modified
 					ret = 304;
 					break;
@@ -243,22 +287,23 @@ int CurlDownloader::download(void)
 			ret = -ETIMEDOUT;
 			break;
 
-		default:
+		default: {
 			// Some other error downloading the file.
 			// Check if we have an HTTP response code.
 			// NOTE: GameTDB sometimes returns nothing instead of 404...
 			long response_code = 0;
-			curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+			curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &response_code);
 			if (response_code <= 0) {
 				// No HTTP response code.
 				// TODO: Return a cURL error code and/or message...
-				return -EIO;
+				ret = -EIO;
+			} else {
+				ret = (int)response_code;
 			}
-			ret = (int)response_code;
 			break;
+		}
 	}
 
-	curl_easy_cleanup(curl);
 	if (ret != 0) {
 		return ret;
 	}
@@ -273,4 +318,20 @@ int CurlDownloader::download(void)
 	return 0;
 }
 
+/**
+ * Download the file.
+ * @return 0 on success; negative POSIX error code, positive HTTP status code on error.
+ */
+int CurlDownloader::download(void)
+{
+	CURL *const curl = prepareTransfer();
+	if (!curl) {
+		// Could not initialize cURL.
+		return -ENOMEM;	// TODO: Better error?
+	}
+
+	// Download the file.
+	return finishTransfer(curl_easy_perform(curl));
+}
+
 }
@@ -10,18 +10,25 @@
 
 #include "IDownloader.hpp"
 
+// cURL for network access.
+#include <curl/curl.h>
+
 namespace RpDownload {
 
+class CurlMultiDownloader;
+
 class CurlDownloader final : public IDownloader
 {
 	public:
 		CurlDownloader();
 		explicit CurlDownloader(const TCHAR *url);
 		explicit CurlDownloader(const std::tstring &url);
+		~CurlDownloader() final;
 
 	private:
 		typedef IDownloader super;
 		RP_DISABLE_COPY(CurlDownloader)
+		friend class CurlMultiDownloader;
 
 	protected:
 		/**
@@ -44,12 +51,31 @@ class CurlDownloader final : public IDownloader
 		 */
 		static size_t parse_header(char *ptr, size_t size, size_t nitems, void *userdata);
 
+		/**
+		 * Prepare the cURL easy handle for a transfer.
+		 * The easy handle is kept across transfers so live
+		 * connections and the DNS cache can be reused.
+		 * @param share cURL share handle, or nullptr for none.
+		 * @return cURL easy handle, or nullptr on error.
+		 */
+		CURL *prepareTransfer(CURLSH *share = nullptr);
+
+		/**
+		 * Process the result of a completed transfer.
+		 * @param res cURL result code.
+		 * @return 0 on success; negative POSIX error code, positive HTTP status code on error.
+		 */
+		int finishTransfer(CURLcode res);
+
 	public:
 		/**
 		 * Download the file.
 		 * @return 0 on success; negative POSIX error code, positive HTTP status code on error.
 		 */
 		int download(void) final;
+
+	private:
+		CURL *m_curl;	// cURL easy handle
 };
 
 }
@@ -0,0 +1,190 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rp-download)                      *
+ * CurlMultiDownloader.cpp: libcurl-based parallel file downloader.        *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "CurlMultiDownloader.hpp"
+
+namespace RpDownload {
+
+/**
+ * Create a CurlMultiDownloader.
+ * @param maxHostConnections Maximum number of connections per host.
+ */
+CurlMultiDownloader::CurlMultiDownloader(unsigned int maxHostConnections)
+	: m_multi(nullptr)
+	, m_share(nullptr)
+	, m_active(0)
+{
+	m_multi = curl_multi_init();
+	if (!m_multi) {
+		// Could not initialize cURL.
+		return;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x072B00
+	// Use HTTP/2 multiplexing if available.
+	curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif /* LIBCURL_VERSION_NUM >= 0x072B00 */
+#if LIBCURL_VERSION_NUM >= 0x071E00
+	// Limit the number of connections per host.
+	// Additional transfers will wait for a free connection.
+	curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(maxHostConnections));
+#else /* LIBCURL_VERSION_NUM < 0x071E00 */
+	RP_UNUSED(maxHostConnections);
+#endif /* LIBCURL_VERSION_NUM >= 0x071E00 */
+
+	// Share the DNS cache and TLS sessions between easy handles.
+	// NOTE: Connections are already shared by the multi handle.
+	// NOTE: No locking callbacks are needed, since all transfers
+	// are run on a single thread.
+	m_share = curl_share_init();
+	if (m_share) {
+		curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	}
+}
+
+CurlMultiDownloader::~CurlMultiDownloader()
+{
+	// NOTE: Any remaining easy handles are owned by their
+	// CurlDownloader objects, which must be deleted after
+	// this object is deleted.
+	if (m_multi) {
+		curl_multi_cleanup(m_multi);
+	}
+	if (m_share) {
+		curl_share_cleanup(m_share);
+	}
+}
+
+/**
+ * Add a download to the transfer queue.
+ * The URL and other properties must be set beforehand.
+ *
+ * The CurlDownloader object must remain valid until it's
+ * returned by nextFinished().
+ *
+ * @param dl CurlDownloader
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int CurlMultiDownloader::add(CurlDownloader *dl)
+{
+	assert(dl != nullptr);
+	if (!m_multi) {
+		return -EBADF;
+	} else if (!dl) {
+		return -EINVAL;
+	}
+
+	CURL *const curl = dl->prepareTransfer(m_share);
+	if (!curl) {
+		// Could not initialize cURL.
+		return -ENOMEM;
+	}
+
+	if (curl_multi_add_handle(m_multi, curl) != CURLM_OK) {
+		dl->m_inProgress = false;
+		return -EIO;
+	}
+
+	m_active++;
+	return 0;
+}
+
+/**
+ * Run transfers, and wait for activity on the transfer sockets
+ * or on an additional file descriptor.
+ * @param extra_fd	[in] Additional file descriptor to wait for input on, or -1 for none.
+ * @param timeout_ms	[in] Maximum time to wait, in milliseconds.
+ * @param pExtraFdReady	[out,opt] Set to true if extra_fd has input available.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int CurlMultiDownloader::poll(int extra_fd, int timeout_ms, bool *pExtraFdReady)
+{
+	if (pExtraFdReady) {
+		*pExtraFdReady = false;
+	}
+	if (!m_multi) {
+		return -EBADF;
+	}
+
+	int running = 0;
+	if (curl_multi_perform(m_multi, &running) != CURLM_OK) {
+		return -EIO;
+	}
+
+	struct curl_waitfd waitfd;
+	unsigned int extra_nfds = 0;
+	if (extra_fd >= 0) {
+		waitfd.fd = extra_fd;
+		waitfd.events = CURL_WAIT_POLLIN;
+		waitfd.revents = 0;
+		extra_nfds = 1;
+	}
+
+	// NOTE: If there are no active transfers and extra_fd is -1,
+	// curl_multi_wait() will return immediately.
+	int numfds = 0;
+	if (curl_multi_wait(m_multi, (extra_nfds > 0 ? &waitfd : nullptr),
+	                    extra_nfds, timeout_ms, &numfds) != CURLM_OK)
+	{
+		return -EIO;
+	}
+
+	if (extra_nfds > 0 && (waitfd.revents & CURL_WAIT_POLLIN)) {
+		if (pExtraFdReady) {
+			*pExtraFdReady = true;
+		}
+	}
+
+	// Process any data that arrived while waiting.
+	if (curl_multi_perform(m_multi, &running) != CURLM_OK) {
+		return -EIO;
+	}
+	return 0;
+}
+
+/**
+ * Get the next completed download.
+ * @param pRet [out] Download result: 0 on success; negative POSIX error code, positive HTTP status code on error.
+ * @return CurlDownloader, or nullptr if no downloads have completed.
+ */
+CurlDownloader *CurlMultiDownloader::nextFinished(int *pRet)
+{
+	assert(pRet != nullptr);
+	if (!m_multi) {
+		return nullptr;
+	}
+
+	int msgs_in_queue = 0;
+	CURLMsg *msg;
+	while ((msg = curl_multi_info_read(m_multi, &msgs_in_queue)) != nullptr) {
+		if (msg->msg != CURLMSG_DONE)
+			continue;
+
+		CURL *const curl = msg->easy_handle;
+		const CURLcode res = msg->data.result;
+		CurlDownloader *dl = nullptr;
+		curl_easy_getinfo(curl, CURLINFO_PRIVATE, reinterpret_cast<char**>(&dl));
+		curl_multi_remove_handle(m_multi, curl);
+		assert(m_active > 0);
+		m_active--;
+
+		assert(dl != nullptr);
+		if (!dl)
+			continue;
+
+		*pRet = dl->finishTransfer(res);
+		return dl;
+	}
+
+	// No downloads have completed.
+	return nullptr;
+}
+
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rp-download)                      *
+ * CurlMultiDownloader.hpp: libcurl-based parallel file downloader.        *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+#pragma once
+
+#include "CurlDownloader.hpp"
+
+namespace RpDownload {
+
+/**
+ * Parallel downloader using a cURL multi handle.
+ *
+ * Connections, the DNS cache, and TLS sessions are shared by
+ * all transfers, so downloading many files from the same server
+ * only needs a single TLS handshake. HTTP/2 multiplexing is used
+ * if the server supports it.
+ *
+ * Transfers are handled by CurlDownloader objects, which are
+ * owned by the caller.
+ */
+class CurlMultiDownloader
+{
+	public:
+		/**
+		 * Create a CurlMultiDownloader.
+		 * @param maxHostConnections Maximum number of connections per host.
+		 */
+		explicit CurlMultiDownloader(unsigned int maxHostConnections = 4);
+		~CurlMultiDownloader();
+
+	private:
+		RP_DISABLE_COPY(CurlMultiDownloader)
+
+	public:
+		/**
+		 * Was the cURL multi handle initialized successfully?
+		 * @return True if initialized; false if not.
+		 */
+		inline bool isInit(void) const
+		{
+			return (m_multi != nullptr);
+		}
+
+		/**
+		 * Get the number of active transfers.
+		 * @return Number of active transfers.
+		 */
+		inline unsigned int activeCount(void) const
+		{
+			return m_active;
+		}
+
+		/**
+		 * Add a download to the transfer queue.
+		 * The URL and other properties must be set beforehand.
+		 *
+		 * The CurlDownloader object must remain valid until it's
+		 * returned by nextFinished().
+		 *
+		 * @param dl CurlDownloader
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int add(CurlDownloader *dl);
+
+		/**
+		 * Run transfers, and wait for activity on the transfer sockets
+		 * or on an additional file descriptor.
+		 * @param extra_fd	[in] Additional file descriptor to wait for input on, or -1 for none.
+		 * @param timeout_ms	[in] Maximum time to wait, in milliseconds.
+		 * @param pExtraFdReady	[out,opt] Set to true if extra_fd has input available.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int poll(int extra_fd, int timeout_ms, bool *pExtraFdReady = nullptr);
+
+		/**
+		 * Get the next completed download.
+		 * @param pRet [out] Download result: 0 on success; negative POSIX error code, positive HTTP status code on error.
+		 * @return CurlDownloader, or nullptr if no downloads have completed.
+		 */
+		CurlDownloader *nextFinished(int *pRet);
+
+	private:
+		CURLM *m_multi;		// cURL multi handle
+		CURLSH *m_share;	// cURL share handle (DNS and TLS sessions)
+		unsigned int m_active;	// Number of active transfers
+};
+
+}
@@ -35,10 +35,13 @@
 #include <cstdio>
 
 // C++ includes.
+#include <deque>
 #include <memory>
+#include <vector>
 using std::string;
 using std::tstring;
 using std::unique_ptr;
+using std::vector;
 
 #ifdef _WIN32
 // libwin32common
@@ -50,6 +53,17 @@ using std::unique_ptr;
 // libcachecommon
 #include "libcachecommon/CacheDir.hpp"
 #include "libcachecommon/CacheKeys.hpp"
+#include "libcachecommon/CacheIndex.hpp"
+#include "libcachecommon/NegativeCache.hpp"
+
+// Configuration directory
+#ifdef _WIN32
+#  include "libwin32common/userdirs.hpp"
+#  include "librptext/conversion.hpp"
+#else /* !_WIN32 */
+#  include "libunixcommon/userdirs.hpp"
+#  include "ini.h"
+#endif /* _WIN32 */
 
 #ifdef _WIN32
 #  include <direct.h>
@@ -67,6 +81,7 @@ using std::unique_ptr;
 #  include "WinInetDownloader.hpp"
 #else
 #  include "CurlDownloader.hpp"
+#  include "CurlMultiDownloader.hpp"
 #endif
 #include "SetFileOriginInfo.hpp"
 using namespace RpDownload;
@@ -77,12 +92,18 @@ using namespace RpDownload;
 static const TCHAR *argv0 = nullptr;
 static bool verbose = false;
 
+// Negative cache expiry, in seconds. (0 if disabled)
+static time_t neg_expiry = LibCacheCommon::NEGATIVE_CACHE_EXPIRY_DEFAULT * 86400;
+// Cache quota, in bytes. (0 if unlimited)
+static uint64_t cache_quota = static_cast<uint64_t>(LibCacheCommon::CACHE_QUOTA_DEFAULT) << 20;
+
 /**
  * Show command usage.
  */
 static void show_usage(void)
 {
 	_ftprintf(stderr, _T("Syntax: %s [-v] [-f] cache_key\n"), argv0);
+	_ftprintf(stderr, _T("        %s [-v] [-f] -b < cache_keys\n"), argv0);
 }
 
 /**
@@ -130,6 +151,101 @@ show_info(const TCHAR *format, ...)
 
 #define SHOW_INFO(...) if (verbose) show_info(__VA_ARGS__)
 
+/**
+ * Download cache settings from rom-properties.conf.
+ */
+struct DownloadsConfig {
+	unsigned int negativeCacheExpiry;	// days
+	unsigned int cacheQuota;		// MiB
+};
+
+// Maximum values for the download cache settings.
+static const unsigned int NEGATIVE_CACHE_EXPIRY_MAX = 3650;
+static const unsigned int CACHE_QUOTA_MAX = 1024U*1024U;
+
+#ifndef _WIN32
+/**
+ * Process a configuration line.
+ * @param user Pointer to DownloadsConfig.
+ * @param section Section.
+ * @param name Key.
+ * @param value Value.
+ * @return 1 to continue; 0 to stop processing.
+ */
+static int processConfigLine(void *user, const char *section, const char *name, const char *value)
+{
+	if (strcasecmp(section, "Downloads") != 0) {
+		// Not the Downloads section. Keep going.
+		return 1;
+	}
+
+	DownloadsConfig *const config = static_cast<DownloadsConfig*>(user);
+	unsigned int *param;
+	unsigned int maxValue;
+	if (!strcasecmp(name, "NegativeCacheExpiry")) {
+		param = &config->negativeCacheExpiry;
+		maxValue = NEGATIVE_CACHE_EXPIRY_MAX;
+	} else if (!strcasecmp(name, "CacheQuota")) {
+		param = &config->cacheQuota;
+		maxValue = CACHE_QUOTA_MAX;
+	} else {
+		// Not a setting we're interested in. Keep going.
+		return 1;
+	}
+
+	char *endptr = nullptr;
+	const unsigned long ulValue = strtoul(value, &endptr, 10);
+	if (endptr && *endptr == '\0' && ulValue <= maxValue) {
+		*param = static_cast<unsigned int>(ulValue);
+	}
+	return 1;
+}
+#endif /* !_WIN32 */
+
+/**
+ * Load the download cache settings from rom-properties.conf.
+ * This sets neg_expiry and cache_quota.
+ */
+static void loadDownloadsConfig(void)
+{
+	DownloadsConfig config;
+	config.negativeCacheExpiry = LibCacheCommon::NEGATIVE_CACHE_EXPIRY_DEFAULT;
+	config.cacheQuota = LibCacheCommon::CACHE_QUOTA_DEFAULT;
+
+	// Get the config filename.
+#ifdef _WIN32
+	tstring conf_filename = U82T_s(LibWin32Common::getConfigDirectory());
+#else /* !_WIN32 */
+	string conf_filename = LibUnixCommon::getConfigDirectory();
+#endif /* _WIN32 */
+	if (!conf_filename.empty()) {
+		// Add a trailing slash if necessary.
+		if (conf_filename.at(conf_filename.size()-1) != DIR_SEP_CHR) {
+			conf_filename += DIR_SEP_CHR;
+		}
+
+#ifdef _WIN32
+		conf_filename += _T("rom-properties\\rom-properties.conf");
+		config.negativeCacheExpiry = GetPrivateProfileInt(_T("Downloads"), _T("NegativeCacheExpiry"),
+			config.negativeCacheExpiry, conf_filename.c_str());
+		if (config.negativeCacheExpiry > NEGATIVE_CACHE_EXPIRY_MAX) {
+			config.negativeCacheExpiry = LibCacheCommon::NEGATIVE_CACHE_EXPIRY_DEFAULT;
+		}
+		config.cacheQuota = GetPrivateProfileInt(_T("Downloads"), _T("CacheQuota"),
+			config.cacheQuota, conf_filename.c_str());
+		if (config.cacheQuota > CACHE_QUOTA_MAX) {
+			config.cacheQuota = LibCacheCommon::CACHE_QUOTA_DEFAULT;
+		}
+#else /* !_WIN32 */
+		conf_filename += "rom-properties/rom-properties.conf";
+		ini_parse(conf_filename.c_str(), processConfigLine, &config);
+#endif /* _WIN32 */
+	}
+
+	neg_expiry = static_cast<time_t>(config.negativeCacheExpiry) * 86400;
+	cache_quota = static_cast<uint64_t>(config.cacheQuota) << 20;
+}
+
 /**
  * Get a file's size and time.
  * @param filename	[in] Filename.
@@ -288,179 +404,26 @@ int rmkdir(const tstring &path)
 }
 
 /**
- * rp-download: Download an image from a supported online database.
- * @param cache_key Cache key, e.g. "ds/cover/US/ADAE.png"
- * @return 0 on success; non-zero on error.
- *
- * TODO:
- * - More error codes based on the error.
+ * Download request for a single cache key.
  */
-int RP_C_API _tmain(int argc, TCHAR *argv[])
-{
-	// Create a downloader based on OS:
-	// - Linux: CurlDownloader
-	// - Windows: WinInetDownloader
-
-	// Syntax: rp-download cache_key
-	// Example: rp-download ds/coverM/US/ADAE.png
-
-	// If http_proxy or https_proxy are set, they will be used
-	// by the downloader code if supported.
-
-	// Reduce process integrity, if available.
-	rp_secure_reduce_integrity();
-
-	// Set OS-specific security options.
-	rp_secure_param_t param;
-#if defined(_WIN32)
-	param.bHighSec = FALSE;
-#elif defined(HAVE_SECCOMP)
-	static const int syscall_wl[] = {
-		// Syscalls used by rp-download.
-		// TODO: Add more syscalls.
-		// FIXME: glibc-2.31 uses 64-bit time syscalls that may not be
-		// defined in earlier versions, including Ubuntu 14.04.
-		SCMP_SYS(access),
-		SCMP_SYS(clock_gettime),
-#if defined(__SNR_clock_gettime64) || defined(__NR_clock_gettime64)
-		SCMP_SYS(clock_gettime64),
-#endif /* __SNR_clock_gettime64 || __NR_clock_gettime64 */
-		SCMP_SYS(close),
-		SCMP_SYS(fcntl),     SCMP_SYS(fcntl64),		// gcc profiling
-		SCMP_SYS(fsetxattr),
-		SCMP_SYS(fstat),     SCMP_SYS(fstat64),		// __GI___fxstat() [printf()]
-		SCMP_SYS(fstatat64), SCMP_SYS(newfstatat),	// Ubuntu 19.10 (32-bit)
-		SCMP_SYS(futex),
-		SCMP_SYS(getdents), SCMP_SYS(getdents64),
-		SCMP_SYS(getppid),	// for bubblewrap verification
-		SCMP_SYS(getrusage),
-		SCMP_SYS(gettimeofday),	// 32-bit only?
-		SCMP_SYS(getuid),	// TODO: Only use geteuid()?
-		SCMP_SYS(lseek), SCMP_SYS(_llseek),
-		//SCMP_SYS(lstat), SCMP_SYS(lstat64),	// Not sure if used?
-		SCMP_SYS(mkdir), SCMP_SYS(mmap), SCMP_SYS(mmap2),
-		SCMP_SYS(munmap),
-		SCMP_SYS(open),		// Ubuntu 16.04
-		SCMP_SYS(openat),	// glibc-2.31
-#if defined(__SNR_openat2)
-		SCMP_SYS(openat2),	// Linux 5.6
-#elif defined(__NR_openat2)
-		__NR_openat2,		// Linux 5.6
-#endif /* __SNR_openat2 || __NR_openat2 */
-		SCMP_SYS(poll), SCMP_SYS(select),
-		SCMP_SYS(stat), SCMP_SYS(stat64),
-		SCMP_SYS(unlink),	// to delete expired cache files
-		SCMP_SYS(utimensat),
-
-#if defined(__SNR_statx) || defined(__NR_statx)
-		SCMP_SYS(getcwd),	// called by glibc's statx()
-		SCMP_SYS(statx),
-#endif /* __SNR_statx || __NR_statx */
-
-#ifndef NDEBUG
-		// Needed for assert() on some systems.
-		SCMP_SYS(uname),
-#endif /* NDEBUG */
-
-		// glibc ncsd
-		// TODO: Restrict connect() to AF_UNIX.
-		SCMP_SYS(connect), SCMP_SYS(recvmsg), SCMP_SYS(sendto),
-		SCMP_SYS(sendmmsg),	// getaddrinfo() (32-bit only?)
-		SCMP_SYS(ioctl),	// getaddrinfo() (32-bit only?) [FIXME: Filter for FIONREAD]
-		SCMP_SYS(recvfrom),	// getaddrinfo() (32-bit only?)
-
-		// Needed for network access on Kubuntu 20.04 for some reason.
-		SCMP_SYS(getpid), SCMP_SYS(uname),
-
-		// cURL and OpenSSL
-		SCMP_SYS(bind),		// getaddrinfo() [curl_thread_create_thunk(), curl-7.68.0]
-#ifdef __SNR_getrandom
-		SCMP_SYS(getrandom),
-#endif /* __SNR_getrandom */
-		SCMP_SYS(getpeername), SCMP_SYS(getsockname),
-		SCMP_SYS(getsockopt), SCMP_SYS(madvise), SCMP_SYS(mprotect),
-		SCMP_SYS(setsockopt), SCMP_SYS(socket),
-		SCMP_SYS(socketcall),	// FIXME: Enhanced filtering? [cURL+GnuTLS only?]
-		SCMP_SYS(socketpair), SCMP_SYS(sysinfo),
-		SCMP_SYS(rt_sigprocmask),	// Ubuntu 20.04: __GI_getaddrinfo() ->
-						// gaih_inet() ->
-						// _nss_myhostname_gethostbyname4_r()
-
-		// libnss_resolve.so (systemd-resolved)
-		SCMP_SYS(geteuid),
-		SCMP_SYS(sendmsg),	// libpthread.so [_nss_resolve_gethostbyname4_r() from libnss_resolve.so]
-
-		// FIXME: Manjaro is using these syscalls for some reason...
-		SCMP_SYS(prctl), SCMP_SYS(mremap), SCMP_SYS(ppoll),
-
-		-1	// End of whitelist
-	};
-	param.syscall_wl = syscall_wl;
-	param.threading = true;		// libcurl uses multi-threading.
-#elif defined(HAVE_PLEDGE)
-	// Promises:
-	// - stdio: General stdio functionality.
-	// - rpath: Read from ~/.config/rom-properties/ and ~/.cache/rom-properties/
-	// - wpath: Write to ~/.cache/rom-properties/
-	// - cpath: Create ~/.cache/rom-properties/ if it doesn't exist.
-	// - inet: Internet access.
-	// - fattr: Modify file attributes, e.g. mtime.
-	// - dns: Resolve hostnames.
-	// - getpw: Get user's home directory if HOME is empty.
-	param.promises = "stdio rpath wpath cpath inet fattr dns getpw";
-#elif defined(HAVE_TAME)
-	// NOTE: stdio includes fattr, e.g. utimes().
-	param.tame_flags = TAME_STDIO | TAME_RPATH | TAME_WPATH | TAME_CPATH |
-	                   TAME_INET | TAME_DNS | TAME_GETPW;
-#else
-	param.dummy = 0;
-#endif
-	rp_secure_enable(param);
-
-	// Store argv[0] globally.
-	argv0 = argv[0];
-
-	if (argc < 2) {
-		show_usage();
-		return EXIT_FAILURE;
-	}
-
-	// Check for arguments. (simple non-getopt version)
-	bool force = false;
-	int optind = 1;
-	for (; optind < argc; optind++) {
-		if (!argv[optind] || argv[optind][0] != '-') {
-			// End of options.
-			break;
-		}
-
-		// Allow multiple options in one argument, e.g. '-vf'.
-		for (int i = 1; argv[optind][i] != '\0'; i++) {
-			switch (argv[optind][i]) {
-				case 'v':
-					// Verbose mode is enabled.
-					verbose = true;
-					break;
-				case 'f':
-					// Force download is enabled.
-					force = true;
-					break;
-				default:
-					// Invalid parameter.
-					show_error(_T("Unrecognized option: %c"), argv[optind][i]);
-					show_usage();
-					return EXIT_FAILURE;
-			}
-		}
-	}
-
-	if (optind >= argc) {
-		show_error(_T("No cache key specified."));
-		show_usage();
-		return EXIT_FAILURE;
-	}
-	const TCHAR *const cache_key = argv[optind];
+struct DownloadRequest {
+	tstring cache_key;		// Cache key
+	tstring cache_filename;		// Cache filename
+	TCHAR full_url[256];		// Full URL
+	time_t filemtime;		// Cache file mtime (-1 if not present)
+	bool check_newer;		// Only download if the file on the server is newer
+};
 
+/**
+ * Get the full URL for a cache key.
+ * @param cache_key	[in] Cache key
+ * @param full_url	[out] Full URL
+ * @param full_url_len	[in] Size of full_url, in TCHARs
+ * @param pCheckNewer	[out] Set to true if the file should be downloaded only if it's newer on the server
+ * @return 0 on success; negative POSIX error code on error.
+ */
+static int get_full_url(const TCHAR *cache_key, TCHAR *full_url, size_t full_url_len, bool *pCheckNewer)
+{
 	// Check the cache key prefix. The prefix indicates the system
 	// and identifies the online database used.
 	// [key] indicates the cache key without the prefix.
@@ -491,14 +454,14 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 		// - Does not contain any slashes.
 		// - First slash is either the first or the last character.
 		SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
-		return EXIT_FAILURE;
+		return -EINVAL;
 	}
 
 	const ptrdiff_t prefix_len = (slash_pos - cache_key);
 	if (prefix_len <= 0) {
 		// Empty prefix.
 		SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
-		return EXIT_FAILURE;
+		return -EINVAL;
 	}
 
 	// Cache key must include a lowercase file extension.
@@ -506,7 +469,7 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 	if (!lastdot) {
 		// No dot...
 		SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
-		return EXIT_FAILURE;
+		return -EINVAL;
 	}
 	if ((!_tcscmp(lastdot, _T(".png"))) != 0 ||
 	    (!_tcscmp(lastdot, _T(".jpg"))) != 0)
@@ -518,12 +481,12 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 		// .txt is supported for sys/ only.
 		if (_tcsncmp(cache_key, _T("sys/"), 4) != 0) {
 			SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
-			return EXIT_FAILURE;
+			return -EINVAL;
 		}
 	} else {
 		// Not a supported file extension.
 		SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
-		return EXIT_FAILURE;
+		return -EINVAL;
 	}
 
 	// urlencode the cache key.
@@ -534,20 +497,19 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 	if (!slash_pos) {
 		// Shouldn't happen, since a slash was found earlier...
 		SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
-		return EXIT_FAILURE;
+		return -EINVAL;
 	}
 
 	// Determine the full URL based on the cache key.
 	bool ok = false;
 	bool check_newer = false;	// for [sys]: always check, but only download if newer
-	TCHAR full_url[256];
 	if ((prefix_len == 3 && (!_tcsncmp(cache_key, _T("wii"), 3) || !_tcsncmp(cache_key, _T("3ds"), 3))) ||
 	    (prefix_len == 4 && !_tcsncmp(cache_key, _T("wiiu"), 4)) ||
 	    (prefix_len == 2 && !_tcsncmp(cache_key, _T("ds"), 2)))
 	{
 		// GameTDB: Wii, Wii U, Nintendo 3DS, Nintendo DS
 		ok = true;
-		_sntprintf(full_url, _countof(full_url),
+		_sntprintf(full_url, full_url_len,
 			_T("https://art.gametdb.com/%s"), cache_key_urlencode.c_str());
 	} else if (prefix_len == 6 && !_tcsncmp(cache_key, _T("amiibo"), 6)) {
 		// amiibo.life: amiibo images
@@ -556,12 +518,12 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 		if (filename_len <= 4) {
 			// Can't remove the extension...
 			SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
-			return EXIT_FAILURE;
+			return -EINVAL;
 		}
 		filename_len -= 4;
 
 		ok = true;
-		_sntprintf(full_url, _countof(full_url),
+		_sntprintf(full_url, full_url_len,
 			_T("https://amiibo.life/nfc/%.*s/image"),
 			static_cast<int>(filename_len), slash_pos+1);
 	} else {
@@ -619,7 +581,7 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 		}
 
 		if (ok) {
-			_sntprintf(full_url, _countof(full_url),
+			_sntprintf(full_url, full_url_len,
 				_T("https://rpdb.gerbilsoft.com/%s"), cache_key_urlencode.c_str());
 		}
 	}
@@ -627,11 +589,35 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 	if (!ok) {
 		// Prefix is not supported.
 		SHOW_ERROR(_T("Cache key '%s' has an unsupported prefix."), cache_key);
+		return -ENOTSUP;
+	}
+
+	*pCheckNewer = check_newer;
+	return 0;
+}
+
+/**
+ * Prepare a download request for a cache key.
+ * This validates the cache key and checks the cache file.
+ * @param req		[out] Download request
+ * @param cache_key	[in] Cache key
+ * @param force		[in] If true, redownload the file even if it's cached.
+ * @return -1 if the file needs to be downloaded; otherwise, the exit code for this cache key.
+ */
+static int prepare_request(DownloadRequest &req, const TCHAR *cache_key, bool force)
+{
+	req.cache_key = cache_key;
+	req.filemtime = -1;
+	req.check_newer = false;
+
+	if (get_full_url(cache_key, req.full_url, _countof(req.full_url), &req.check_newer) != 0) {
+		// Invalid cache key.
 		return EXIT_FAILURE;
 	}
+	const bool check_newer = req.check_newer;
 
 	if (verbose) {
-		_ftprintf(stderr, _T("URL: %s\n"), full_url);
+		_ftprintf(stderr, _T("URL: %s\n"), req.full_url);
 	}
 
 	// Make sure we have a valid cache directory.
@@ -644,7 +630,8 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 	}
 
 	// Get the cache filename.
-	tstring cache_filename = LibCacheCommon::getCacheFilename(cache_key);
+	tstring &cache_filename = req.cache_filename;
+	cache_filename = LibCacheCommon::getCacheFilename(cache_key);
 	if (cache_filename.empty()) {
 		// Invalid cache filename.
 		SHOW_ERROR(_T("Cache key '%s' is invalid."), cache_key);
@@ -662,21 +649,36 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 	}
 #endif /* _WIN32 && _UNICODE */
 
+	if (!check_newer) {
+		// Check the negative cache index.
+		// NOTE: Not used for "check_newer" files, e.g. "sys/".
+		const time_t negTime = LibCacheCommon::negativeCacheLookup(cache_key);
+		if (negTime >= 0 && (time(nullptr) - negTime) < neg_expiry) {
+			// Negative cache entry has not expired yet.
+			if (likely(!force)) {
+				SHOW_INFO(_T("Negative cache entry for '%s' has not expired; not redownloading."), cache_key);
+				return EXIT_FAILURE;
+			} else {
+				SHOW_INFO(_T("Negative cache entry for '%s' has not expired, but -f was specified. Redownloading anyway."), cache_key);
+			}
+		}
+	}
+
 	// Get the cache file information.
 	off64_t filesize = 0;
-	time_t filemtime = -1;
-	int ret = get_file_size_and_mtime(cache_filename.c_str(), &filesize, &filemtime);
+	int ret = get_file_size_and_mtime(cache_filename.c_str(), &filesize, &req.filemtime);
 	if (ret == 0) {
 		// Check if the file is 0 bytes.
 		// TODO: How should we handle errors?
 		if (filesize == 0 && !check_newer) {
 			// File is 0 bytes, which indicates it didn't exist on the server.
-			// If the file is older than a week, try to redownload it.
+			// (Older versions created zero-byte files instead of using
+			// the negative cache index.)
+			// If the file has expired, try to redownload it.
 			// NOTE: Not used for "check_newer" files, e.g. "sys/".
-			// TODO: Configurable time.
 			const time_t systime = time(nullptr);
-			if ((systime - filemtime) < (86400*7)) {
-				// Less than a week old.
+			if ((systime - req.filemtime) < neg_expiry) {
+				// Not expired yet.
 				if (likely(!force)) {
 					SHOW_INFO(_T("Negative cache file for '%s' has not expired; not redownloading."), cache_key);
 					return EXIT_FAILURE;
@@ -685,7 +687,7 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 				}
 			}
 
-			// More than a week old.
+			// Expired.
 			// Delete the cache file and try to download it again.
 			if (_tremove(cache_filename.c_str()) != 0) {
 				SHOW_ERROR(_T("Error deleting negative cache file for '%s': %s"), cache_key, _tcserror(errno));
@@ -721,36 +723,68 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 		return EXIT_FAILURE;
 	}
 
-	// Attempt to download the file.
-	// TODO: IDownloaderFactory?
-#ifdef _WIN32
-	unique_ptr<IDownloader> m_downloader(new WinInetDownloader());
-#else /* !_WIN32 */
-	unique_ptr<IDownloader> m_downloader(new CurlDownloader());
-#endif /* _WIN32 */
+	// The file needs to be downloaded.
+	return -1;
+}
 
+/**
+ * Set up a downloader for a download request.
+ * @param downloader	[in] Downloader
+ * @param req		[in] Download request
+ */
+static void setup_downloader(IDownloader *downloader, const DownloadRequest &req)
+{
 	// TODO: Configure this somewhere?
-	m_downloader->setMaxSize(4*1024*1024);
+	downloader->setMaxSize(4*1024*1024);
 
-	if (check_newer && filemtime >= 0) {
+	if (req.check_newer && req.filemtime >= 0) {
 		// Only download if the file on the server is newer than
 		// what's in our cache directory.
-		m_downloader->setIfModifiedSince(filemtime);
+		downloader->setIfModifiedSince(req.filemtime);
+	} else {
+		// The downloader might be reused, so clear this.
+		downloader->setIfModifiedSince(-1);
 	}
 
-	m_downloader->setUrl(full_url);
-	ret = m_downloader->download();
-	if (ret != 0) {
-		// Error downloading the file.
-		if (ret < 0) {
+	downloader->setUrl(req.full_url);
+}
+
+/**
+ * Add a cache key to the negative cache index.
+ * @param req		[in] Download request
+ */
+static void add_negative_cache_entry(const DownloadRequest &req)
+{
+	if (req.check_newer || neg_expiry <= 0) {
+		// Negative caching isn't used for this cache key.
+		return;
+	}
+
+	int ret = LibCacheCommon::negativeCacheUpdate(req.cache_key.c_str(), time(nullptr), neg_expiry);
+	if (ret != 0) {
+		SHOW_ERROR(_T("Error updating the negative cache index: %s"), _tcserror(-ret));
+	}
+}
+
+/**
+ * Save a downloaded file to the cache.
+ * @param req		[in] Download request
+ * @param downloader	[in] Downloader
+ * @param ret		[in] Return value from the download
+ * @return Exit code for this cache key.
+ */
+static int save_cache_file(const DownloadRequest &req, const IDownloader *downloader, int ret)
+{
+	const TCHAR *const cache_key = req.cache_key.c_str();
+	const tstring &cache_filename = req.cache_filename;
+
+	if (ret != 0) {
+		// Error downloading the file.
+		if (ret < 0) {
 			// POSIX error code
 			SHOW_ERROR(_T("Error downloading file: %s"), _tcserror(-ret));
-			// Create a 0-byte file to indicate an error occurred.
-			FILE *f_out = _tfopen(cache_filename.c_str(), _T("wb"));
-			if (f_out) {
-				fclose(f_out);
-			}
-		} else if (ret == 304 && check_newer) {
+			add_negative_cache_entry(req);
+		} else if (ret == 304 && req.check_newer) {
 			// HTTP 304 Not Modified
 			SHOW_ERROR(_T("File has not been modified on the server. Not redownloading."));
 			return EXIT_SUCCESS;
@@ -764,16 +798,12 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 					show_error(_T("Error downloading file: HTTP %d"), ret);
 				}
 			}
-			// Create a 0-byte file to indicate an error occurred.
-			FILE *f_out = _tfopen(cache_filename.c_str(), _T("wb"));
-			if (f_out) {
-				fclose(f_out);
-			}
+			add_negative_cache_entry(req);
 		}
 		return EXIT_FAILURE;
 	}
 
-	if (m_downloader->dataSize() <= 0) {
+	if (downloader->dataSize() <= 0) {
 		// No data downloaded...
 		SHOW_ERROR(_T("Error downloading file: 0 bytes received"));
 		return EXIT_FAILURE;
@@ -788,22 +818,464 @@ int RP_C_API _tmain(int argc, TCHAR *argv[])
 
 	// Write the file to the cache.
 	// TODO: Verify the size.
-	const size_t dataSize = m_downloader->dataSize();
-	size_t size = fwrite(m_downloader->data(), 1, dataSize, f_out);
+	const size_t dataSize = downloader->dataSize();
+	size_t size = fwrite(downloader->data(), 1, dataSize, f_out);
 	fflush(f_out);
 
 	// Save the file origin information.
 #ifdef _WIN32
 	// TODO: Figure out how to setFileOriginInfo() on Windows using an open file handle.
-	setFileOriginInfo(f_out, cache_filename.c_str(), full_url, m_downloader->mtime());
+	setFileOriginInfo(f_out, cache_filename.c_str(), req.full_url, downloader->mtime());
 #else /* !_WIN32 */
-	setFileOriginInfo(f_out, full_url, m_downloader->mtime());
+	setFileOriginInfo(f_out, req.full_url, downloader->mtime());
 #endif /* _WIN32 */
 	fclose(f_out);
 
+	if (!req.check_newer) {
+		// Remove the negative cache entry, if present.
+		LibCacheCommon::negativeCacheUpdate(cache_key, -1, neg_expiry);
+	}
+
+	// Add the file to the cache index, and evict older files
+	// if the cache is over quota.
+	uint64_t freed = 0;
+	ret = LibCacheCommon::cacheIndexUpdate(cache_key, static_cast<int64_t>(dataSize), cache_quota, &freed);
+	if (ret != 0) {
+		SHOW_ERROR(_T("Error updating the cache index: %s"), _tcserror(-ret));
+	} else if (freed > 0) {
+		SHOW_INFO(_T("Evicted %u KiB of older cache files to stay within the cache quota."),
+			static_cast<unsigned int>(freed >> 10));
+	}
+
 	// Success.
 	SHOW_INFO(_T("Downloaded cache file for '%s': %u byte%s."),
 		cache_key, static_cast<unsigned int>(dataSize),
 		unlikely(dataSize == 1) ? "" : "s");
 	return EXIT_SUCCESS;
 }
+
+/**
+ * Batch mode: Write the result for a cache key to stdout.
+ * Format: "[exit code] [cache key]\n"
+ * @param cache_key	[in] Cache key
+ * @param status	[in] Exit code for this cache key
+ */
+static void batch_write_result(const TCHAR *cache_key, int status)
+{
+	_tprintf(_T("%d %s\n"), status, cache_key);
+	fflush(stdout);
+}
+
+#ifndef _WIN32
+// Batch mode settings.
+// TODO: Make these configurable?
+static const unsigned int BATCH_MAX_ACTIVE = 8;			// Maximum number of simultaneous transfers
+static const unsigned int BATCH_MAX_HOST_CONNECTIONS = 4;	// Maximum number of connections per host
+static const time_t BATCH_IDLE_TIMEOUT = 30;			// Exit if idle for this many seconds
+
+/**
+ * Batch mode: Download files for cache keys read from stdin.
+ *
+ * Each line of input is a cache key. Once a cache key has been
+ * processed, its result is written to stdout. (see batch_write_result())
+ * Results may be written in a different order than the requests.
+ *
+ * Downloads are run in parallel, and connections are reused
+ * between downloads.
+ *
+ * The program exits when stdin is closed and all downloads have
+ * finished, or if it's idle for BATCH_IDLE_TIMEOUT seconds.
+ *
+ * @param force If true, redownload files even if they're cached.
+ * @return Exit code.
+ */
+static int batch_mode(bool force)
+{
+	struct BatchItem {
+		DownloadRequest req;
+		unique_ptr<CurlDownloader> dl;
+	};
+	std::deque<unique_ptr<BatchItem> > pending;
+	vector<unique_ptr<BatchItem> > active;
+	// Idle downloaders are kept for reuse.
+	vector<unique_ptr<CurlDownloader> > idle_dl;
+
+	// NOTE: The multi handle must be deleted before the downloaders.
+	CurlMultiDownloader multi(BATCH_MAX_HOST_CONNECTIONS);
+	if (!multi.isInit()) {
+		SHOW_ERROR(_T("Unable to initialize cURL."));
+		return EXIT_FAILURE;
+	}
+
+	// Add a cache key to the queue.
+	auto add_cache_key = [&pending, force](string &cache_key) {
+		// Remove trailing whitespace, e.g. '\r'.
+		while (!cache_key.empty() && ISSPACE(cache_key.back())) {
+			cache_key.resize(cache_key.size()-1);
+		}
+		if (cache_key.empty())
+			return;
+
+		unique_ptr<BatchItem> item(new BatchItem);
+		const int status = prepare_request(item->req, cache_key.c_str(), force);
+		if (status >= 0) {
+			// Nothing to download.
+			batch_write_result(cache_key.c_str(), status);
+			return;
+		}
+		pending.emplace_back(std::move(item));
+	};
+
+	string linebuf;
+	bool eof = false;
+	time_t last_activity = time(nullptr);
+	while (!eof || !pending.empty() || !active.empty()) {
+		// Start pending downloads.
+		while (!pending.empty() && active.size() < BATCH_MAX_ACTIVE) {
+			unique_ptr<BatchItem> item(std::move(pending.front()));
+			pending.pop_front();
+
+			if (!idle_dl.empty()) {
+				item->dl = std::move(idle_dl.back());
+				idle_dl.pop_back();
+			} else {
+				item->dl.reset(new CurlDownloader());
+			}
+
+			setup_downloader(item->dl.get(), item->req);
+			int ret = multi.add(item->dl.get());
+			if (ret != 0) {
+				SHOW_ERROR(_T("Error downloading file: %s"), _tcserror(-ret));
+				batch_write_result(item->req.cache_key.c_str(), EXIT_FAILURE);
+				idle_dl.emplace_back(std::move(item->dl));
+				continue;
+			}
+			active.emplace_back(std::move(item));
+		}
+
+		// Run the transfers and check for more cache keys.
+		bool stdin_ready = false;
+		int ret = multi.poll(eof ? -1 : STDIN_FILENO, 1000, &stdin_ready);
+		if (ret != 0) {
+			SHOW_ERROR(_T("Error downloading files: %s"), _tcserror(-ret));
+			break;
+		}
+
+		if (stdin_ready) {
+			char buf[4096];
+			ssize_t size = read(STDIN_FILENO, buf, sizeof(buf));
+			if (size < 0 && errno == EINTR) {
+				// Interrupted. Try again.
+				continue;
+			} else if (size <= 0) {
+				// End of input.
+				eof = true;
+				if (!linebuf.empty()) {
+					add_cache_key(linebuf);
+					linebuf.clear();
+				}
+			} else {
+				linebuf.append(buf, size);
+				size_t pos;
+				while ((pos = linebuf.find('\n')) != string::npos) {
+					string cache_key = linebuf.substr(0, pos);
+					linebuf.erase(0, pos+1);
+					add_cache_key(cache_key);
+				}
+			}
+			last_activity = time(nullptr);
+		}
+
+		// Check for finished downloads.
+		int dlret = 0;
+		CurlDownloader *dl;
+		while ((dl = multi.nextFinished(&dlret)) != nullptr) {
+			auto iter = std::find_if(active.begin(), active.end(),
+				[dl](const unique_ptr<BatchItem> &item) {
+					return (item->dl.get() == dl);
+				});
+			assert(iter != active.end());
+			if (iter == active.end())
+				continue;
+
+			const DownloadRequest &req = (*iter)->req;
+			batch_write_result(req.cache_key.c_str(), save_cache_file(req, dl, dlret));
+			idle_dl.emplace_back(std::move((*iter)->dl));
+			active.erase(iter);
+			last_activity = time(nullptr);
+		}
+
+		if (!eof && pending.empty() && active.empty() &&
+		    (time(nullptr) - last_activity) >= BATCH_IDLE_TIMEOUT)
+		{
+			// Idle timeout.
+			SHOW_INFO(_T("No cache keys received in %d seconds; exiting."),
+				static_cast<int>(BATCH_IDLE_TIMEOUT));
+			break;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+#else /* _WIN32 */
+/**
+ * Batch mode: Download files for cache keys read from stdin.
+ *
+ * Each line of input is a cache key. Once a cache key has been
+ * processed, its result is written to stdout. (see batch_write_result())
+ *
+ * The program exits when stdin is closed.
+ *
+ * @param force If true, redownload files even if they're cached.
+ * @return Exit code.
+ */
+static int batch_mode(bool force)
+{
+	// TODO: Parallel downloads using WinInet's async mode.
+	unique_ptr<IDownloader> downloader(new WinInetDownloader());
+
+	TCHAR cache_key[1024];
+	while (_fgetts(cache_key, _countof(cache_key), stdin)) {
+		// Remove trailing whitespace, e.g. "\r\n".
+		size_t len = _tcslen(cache_key);
+		while (len > 0 && _istspace(cache_key[len-1])) {
+			cache_key[--len] = _T('\0');
+		}
+		if (len == 0)
+			continue;
+
+		DownloadRequest req;
+		int status = prepare_request(req, cache_key, force);
+		if (status < 0) {
+			setup_downloader(downloader.get(), req);
+			status = save_cache_file(req, downloader.get(), downloader->download());
+		}
+		batch_write_result(cache_key, status);
+	}
+
+	return EXIT_SUCCESS;
+}
+#endif /* !_WIN32 */
+
+/**
+ * rp-download: Download an image from a supported online database.
+ * @param cache_key Cache key, e.g. "ds/cover/US/ADAE.png"
+ * @return 0 on success; non-zero on error.
+ *
+ * TODO:
+ * - More error codes based on the error.
+ */
+int RP_C_API _tmain(int argc, TCHAR *argv[])
+{
+	// Create a downloader based on OS:
+	// - Linux: CurlDownloader
+	// - Windows: WinInetDownloader
+
+	// Syntax: rp-download cache_key
+	// Example: rp-download ds/coverM/US/ADAE.png
+
+	// Batch mode: rp-download -b
+	// Cache keys are read from stdin, one per line, and the
+	// results are written to stdout. (see batch_mode())
+
+	// If http_proxy or https_proxy are set, they will be used
+	// by the downloader code if supported.
+
+	// Reduce process integrity, if available.
+	rp_secure_reduce_integrity();
+
+	// Set OS-specific security options.
+	rp_secure_param_t param;
+#if defined(_WIN32)
+	param.bHighSec = FALSE;
+#elif defined(HAVE_SECCOMP)
+	static const int syscall_wl[] = {
+		// Syscalls used by rp-download.
+		// TODO: Add more syscalls.
+		// FIXME: glibc-2.31 uses 64-bit time syscalls that may not be
+		// defined in earlier versions, including Ubuntu 14.04.
+		SCMP_SYS(access),
+		SCMP_SYS(clock_gettime),
+#if defined(__SNR_clock_gettime64) || defined(__NR_clock_gettime64)
+		SCMP_SYS(clock_gettime64),
+#endif /* __SNR_clock_gettime64 || __NR_clock_gettime64 */
+		SCMP_SYS(close),
+		SCMP_SYS(fcntl),     SCMP_SYS(fcntl64),		// gcc profiling
+		SCMP_SYS(fsetxattr),
+		SCMP_SYS(fstat),     SCMP_SYS(fstat64),		// __GI___fxstat() [printf()]
+		SCMP_SYS(fstatat64), SCMP_SYS(newfstatat),	// Ubuntu 19.10 (32-bit)
+		SCMP_SYS(flock),	// to lock the cache index while updating it
+		SCMP_SYS(futex),
+		SCMP_SYS(getdents), SCMP_SYS(getdents64),
+		SCMP_SYS(getppid),	// for bubblewrap verification
+		SCMP_SYS(getrusage),
+		SCMP_SYS(gettimeofday),	// 32-bit only?
+		SCMP_SYS(getuid),	// TODO: Only use geteuid()?
+		SCMP_SYS(lseek), SCMP_SYS(_llseek),
+		//SCMP_SYS(lstat), SCMP_SYS(lstat64),	// Not sure if used?
+		SCMP_SYS(mkdir), SCMP_SYS(mmap), SCMP_SYS(mmap2),
+		SCMP_SYS(munmap),
+		SCMP_SYS(open),		// Ubuntu 16.04
+		SCMP_SYS(openat),	// glibc-2.31
+#if defined(__SNR_openat2)
+		SCMP_SYS(openat2),	// Linux 5.6
+#elif defined(__NR_openat2)
+		__NR_openat2,		// Linux 5.6
+#endif /* __SNR_openat2 || __NR_openat2 */
+		SCMP_SYS(poll), SCMP_SYS(select),
+		SCMP_SYS(rename), SCMP_SYS(renameat),	// to update the negative cache index
+#if defined(__SNR_renameat2) || defined(__NR_renameat2)
+		SCMP_SYS(renameat2),
+#endif /* __SNR_renameat2 || __NR_renameat2 */
+		SCMP_SYS(stat), SCMP_SYS(stat64),
+		SCMP_SYS(unlink),	// to delete expired and evicted cache files
+		SCMP_SYS(utimensat),
+
+#if defined(__SNR_statx) || defined(__NR_statx)
+		SCMP_SYS(getcwd),	// called by glibc's statx()
+		SCMP_SYS(statx),
+#endif /* __SNR_statx || __NR_statx */
+
+#ifndef NDEBUG
+		// Needed for assert() on some systems.
+		SCMP_SYS(uname),
+#endif /* NDEBUG */
+
+		// glibc ncsd
+		// TODO: Restrict connect() to AF_UNIX.
+		SCMP_SYS(connect), SCMP_SYS(recvmsg), SCMP_SYS(sendto),
+		SCMP_SYS(sendmmsg),	// getaddrinfo() (32-bit only?)
+		SCMP_SYS(ioctl),	// getaddrinfo() (32-bit only?) [FIXME: Filter for FIONREAD]
+		SCMP_SYS(recvfrom),	// getaddrinfo() (32-bit only?)
+
+		// Needed for network access on Kubuntu 20.04 for some reason.
+		SCMP_SYS(getpid), SCMP_SYS(uname),
+
+		// cURL and OpenSSL
+		SCMP_SYS(bind),		// getaddrinfo() [curl_thread_create_thunk(), curl-7.68.0]
+#ifdef __SNR_getrandom
+		SCMP_SYS(getrandom),
+#endif /* __SNR_getrandom */
+		SCMP_SYS(getpeername), SCMP_SYS(getsockname),
+		SCMP_SYS(getsockopt), SCMP_SYS(madvise), SCMP_SYS(mprotect),
+		SCMP_SYS(setsockopt), SCMP_SYS(socket),
+		SCMP_SYS(socketcall),	// FIXME: Enhanced filtering? [cURL+GnuTLS only?]
+		SCMP_SYS(socketpair), SCMP_SYS(sysinfo),
+		SCMP_SYS(rt_sigprocmask),	// Ubuntu 20.04: __GI_getaddrinfo() ->
+						// gaih_inet() ->
+						// _nss_myhostname_gethostbyname4_r()
+
+		// libnss_resolve.so (systemd-resolved)
+		SCMP_SYS(geteuid),
+		SCMP_SYS(sendmsg),	// libpthread.so [_nss_resolve_gethostbyname4_r() from libnss_resolve.so]
+
+		// FIXME: Manjaro is using these syscalls for some reason...
+		SCMP_SYS(prctl), SCMP_SYS(mremap), SCMP_SYS(ppoll),
+
+		// cURL multi interface (batch mode)
+		SCMP_SYS(eventfd2), SCMP_SYS(pipe), SCMP_SYS(pipe2),
+
+		-1	// End of whitelist
+	};
+	param.syscall_wl = syscall_wl;
+	param.threading = true;		// libcurl uses multi-threading.
+#elif defined(HAVE_PLEDGE)
+	// Promises:
+	// - stdio: General stdio functionality.
+	// - rpath: Read from ~/.config/rom-properties/ and ~/.cache/rom-properties/
+	// - wpath: Write to ~/.cache/rom-properties/
+	// - cpath: Create ~/.cache/rom-properties/ if it doesn't exist.
+	// - inet: Internet access.
+	// - fattr: Modify file attributes, e.g. mtime.
+	// - dns: Resolve hostnames.
+	// - getpw: Get user's home directory if HOME is empty.
+	param.promises = "stdio rpath wpath cpath inet fattr dns getpw";
+#elif defined(HAVE_TAME)
+	// NOTE: stdio includes fattr, e.g. utimes().
+	param.tame_flags = TAME_STDIO | TAME_RPATH | TAME_WPATH | TAME_CPATH |
+	                   TAME_INET | TAME_DNS | TAME_GETPW;
+#else
+	param.dummy = 0;
+#endif
+	rp_secure_enable(param);
+
+	// Store argv[0] globally.
+	argv0 = argv[0];
+
+	if (argc < 2) {
+		show_usage();
+		return EXIT_FAILURE;
+	}
+
+	// Get the negative cache expiry and cache quota.
+	loadDownloadsConfig();
+
+	// Check for arguments. (simple non-getopt version)
+	bool force = false;
+	bool batch = false;
+	int optind = 1;
+	for (; optind < argc; optind++) {
+		if (!argv[optind] || argv[optind][0] != '-') {
+			// End of options.
+			break;
+		}
+
+		// Allow multiple options in one argument, e.g. '-vf'.
+		for (int i = 1; argv[optind][i] != '\0'; i++) {
+			switch (argv[optind][i]) {
+				case 'v':
+					// Verbose mode is enabled.
+					verbose = true;
+					break;
+				case 'f':
+					// Force download is enabled.
+					force = true;
+					break;
+				case 'b':
+					// Batch mode is enabled.
+					batch = true;
+					break;
+				default:
+					// Invalid parameter.
+					show_error(_T("Unrecognized option: %c"), argv[optind][i]);
+					show_usage();
+					return EXIT_FAILURE;
+			}
+		}
+	}
+
+	if (batch) {
+		if (optind < argc) {
+			show_error(_T("Cache keys cannot be specified on the command line in batch mode."));
+			show_usage();
+			return EXIT_FAILURE;
+		}
+		return batch_mode(force);
+	}
+
+	if (optind >= argc) {
+		show_error(_T("No cache key specified."));
+		show_usage();
+		return EXIT_FAILURE;
+	}
+	const TCHAR *const cache_key = argv[optind];
+
+	DownloadRequest req;
+	int ret = prepare_request(req, cache_key, force);
+	if (ret >= 0) {
+		// Nothing to download.
+		return ret;
+	}
+
+	// Attempt to download the file.
+	// TODO: IDownloaderFactory?
+#ifdef _WIN32
+	unique_ptr<IDownloader> m_downloader(new WinInetDownloader());
+#else /* !_WIN32 */
+	unique_ptr<IDownloader> m_downloader(new CurlDownloader());
+#endif /* _WIN32 */
+
+	setup_downloader(m_downloader.get(), req);
+	ret = m_downloader->download();
+	return save_cache_file(req, m_downloader.get(), ret);
+}
@@ -0,0 +1,395 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rp-download/tests)                *
+ * CurlMultiDownloaderTest.cpp: CurlMultiDownloader test.                  *
+ *                                                                         *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
+ * SPDX-License-Identifier: GPL-2.0-or-later                               *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+#include "tcharx.h"
+
+// rp-download
+#include "../CurlDownloader.hpp"
+#include "../CurlMultiDownloader.hpp"
+
+// librpsecure
+#include "librpsecure/os-secure.h"
+
+// C includes
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// C includes (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+/**
+ * Additional security options for the local HTTP server.
+ * (See gtest_init.cpp.)
+ */
+#if defined(HAVE_SECCOMP)
+extern "C" const int gtest_extra_syscall_wl[] = {
+	SCMP_SYS(accept), SCMP_SYS(accept4), SCMP_SYS(bind),
+	SCMP_SYS(getpeername), SCMP_SYS(getsockname),
+	SCMP_SYS(getsockopt), SCMP_SYS(setsockopt),
+	SCMP_SYS(listen), SCMP_SYS(recvfrom), SCMP_SYS(socket),
+	SCMP_SYS(socketpair), SCMP_SYS(pipe), SCMP_SYS(pipe2),
+	SCMP_SYS(eventfd2), SCMP_SYS(poll), SCMP_SYS(ppoll),
+	SCMP_SYS(madvise), SCMP_SYS(getrandom),
+	-1	// End of whitelist
+};
+#elif defined(HAVE_PLEDGE)
+extern "C" const char gtest_extra_promises[] = "inet dns";
+#endif
+
+namespace RpDownload { namespace Tests {
+
+/**
+ * Local HTTP/1.1 stand-in server.
+ * Supports keep-alive, and counts the number of accepted connections.
+ *
+ * URLs:
+ * - /file/[n]: Returns "File #[n]"
+ * - anything else: Returns HTTP 404.
+ */
+class LocalHttpServer
+{
+	public:
+		LocalHttpServer()
+			: m_listen_fd(-1)
+			, m_port(0)
+			, m_stop(false)
+			, m_connections(0)
+			, m_requests(0)
+		{ }
+
+		~LocalHttpServer()
+		{
+			stop();
+		}
+
+		/**
+		 * Start the server on an ephemeral port on 127.0.0.1.
+		 * @return True on success; false on error.
+		 */
+		bool start(void)
+		{
+			m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+			if (m_listen_fd < 0)
+				return false;
+
+			int one = 1;
+			setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+			struct sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = 0;
+			if (bind(m_listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+				return false;
+			if (listen(m_listen_fd, 16) != 0)
+				return false;
+
+			socklen_t addrlen = sizeof(addr);
+			if (getsockname(m_listen_fd, reinterpret_cast<struct sockaddr*>(&addr), &addrlen) != 0)
+				return false;
+			m_port = ntohs(addr.sin_port);
+
+			m_acceptThread = std::thread(&LocalHttpServer::acceptLoop, this);
+			return true;
+		}
+
+		/**
+		 * Stop the server.
+		 */
+		void stop(void)
+		{
+			m_stop = true;
+			if (m_acceptThread.joinable()) {
+				m_acceptThread.join();
+			}
+			for (std::thread &thr : m_connThreads) {
+				if (thr.joinable()) {
+					thr.join();
+				}
+			}
+			m_connThreads.clear();
+			if (m_listen_fd >= 0) {
+				close(m_listen_fd);
+				m_listen_fd = -1;
+			}
+		}
+
+		/**
+		 * Get a URL on this server.
+		 * @param path Path, including the leading slash.
+		 * @return URL.
+		 */
+		string url(const char *path) const
+		{
+			char buf[64];
+			snprintf(buf, sizeof(buf), "http://127.0.0.1:%u", m_port);
+			return string(buf) + path;
+		}
+
+		unsigned int connections(void) const { return m_connections; }
+		unsigned int requests(void) const { return m_requests; }
+
+	private:
+		void acceptLoop(void)
+		{
+			while (!m_stop) {
+				struct pollfd pfd = {m_listen_fd, POLLIN, 0};
+				if (::poll(&pfd, 1, 50) <= 0)
+					continue;
+
+				int fd = accept(m_listen_fd, nullptr, nullptr);
+				if (fd < 0)
+					continue;
+				m_connections++;
+				m_connThreads.emplace_back(&LocalHttpServer::connLoop, this, fd);
+			}
+		}
+
+		void connLoop(int fd)
+		{
+			string buf;
+			while (!m_stop) {
+				// Process all complete requests in the buffer.
+				size_t hdr_end;
+				while ((hdr_end = buf.find("\r\n\r\n")) != string::npos) {
+					const string request = buf.substr(0, hdr_end);
+					buf.erase(0, hdr_end + 4);
+					handleRequest(fd, request);
+				}
+
+				struct pollfd pfd = {fd, POLLIN, 0};
+				if (::poll(&pfd, 1, 50) <= 0)
+					continue;
+
+				char rdbuf[1024];
+				ssize_t size = recv(fd, rdbuf, sizeof(rdbuf), 0);
+				if (size <= 0)
+					break;
+				buf.append(rdbuf, size);
+			}
+			close(fd);
+		}
+
+		void handleRequest(int fd, const string &request)
+		{
+			m_requests++;
+
+			// Request line: "GET /path HTTP/1.1"
+			string path;
+			const size_t sp1 = request.find(' ');
+			if (sp1 != string::npos) {
+				const size_t sp2 = request.find(' ', sp1 + 1);
+				if (sp2 != string::npos) {
+					path = request.substr(sp1 + 1, sp2 - sp1 - 1);
+				}
+			}
+
+			string response;
+			if (path.compare(0, 6, "/file/") == 0) {
+				const string body = "File #" + path.substr(6);
+				response = "HTTP/1.1 200 OK\r\n"
+					"Content-Type: application/octet-stream\r\n"
+					"Last-Modified: Wed, 15 Nov 1995 04:58:08 GMT\r\n"
+					"Content-Length: " + std::to_string(body.size()) + "\r\n"
+					"\r\n" + body;
+			} else {
+				static const char body[] = "Not Found";
+				response = "HTTP/1.1 404 Not Found\r\n"
+					"Content-Length: " + std::to_string(sizeof(body)-1) + "\r\n"
+					"\r\n" + body;
+			}
+
+			size_t pos = 0;
+			while (pos < response.size()) {
+				ssize_t size = send(fd, response.data() + pos, response.size() - pos, MSG_NOSIGNAL);
+				if (size <= 0)
+					break;
+				pos += size;
+			}
+		}
+
+	private:
+		int m_listen_fd;
+		uint16_t m_port;
+		std::atomic<bool> m_stop;
+		std::atomic<unsigned int> m_connections;
+		std::atomic<unsigned int> m_requests;
+		std::thread m_acceptThread;
+		vector<std::thread> m_connThreads;
+};
+
+class CurlMultiDownloaderTest : public ::testing::Test
+{
+	protected:
+		void SetUp(void) override
+		{
+			ASSERT_TRUE(m_server.start());
+		}
+
+		void TearDown(void) override
+		{
+			m_server.stop();
+		}
+
+		/**
+		 * Get the downloaded data as a string.
+		 * @param dl Downloader
+		 * @return Downloaded data.
+		 */
+		static string dataString(const IDownloader *dl)
+		{
+			return string(reinterpret_cast<const char*>(dl->data()), dl->dataSize());
+		}
+
+	protected:
+		LocalHttpServer m_server;
+};
+
+/**
+ * Download several files sequentially using a single CurlDownloader.
+ * The connection should be reused.
+ */
+TEST_F(CurlMultiDownloaderTest, sequentialConnectionReuse)
+{
+	CurlDownloader dl;
+	for (unsigned int i = 0; i < 5; i++) {
+		const string num = std::to_string(i);
+		dl.setUrl(m_server.url(("/file/" + num).c_str()));
+		ASSERT_EQ(0, dl.download());
+		EXPECT_EQ("File #" + num, dataString(&dl));
+		EXPECT_EQ(816411488, dl.mtime());
+	}
+
+	EXPECT_EQ(5U, m_server.requests());
+	EXPECT_EQ(1U, m_server.connections());
+}
+
+/**
+ * Download several files in parallel.
+ * The number of connections should be limited.
+ */
+TEST_F(CurlMultiDownloaderTest, parallelDownloads)
+{
+	static const unsigned int maxHostConnections = 2;
+	static const unsigned int fileCount = 16;
+
+	CurlMultiDownloader multi(maxHostConnections);
+	ASSERT_TRUE(multi.isInit());
+
+	vector<unique_ptr<CurlDownloader> > dls;
+	for (unsigned int i = 0; i < fileCount; i++) {
+		CurlDownloader *const dl = new CurlDownloader();
+		dls.emplace_back(dl);
+		dl->setUrl(m_server.url(("/file/" + std::to_string(i)).c_str()));
+		ASSERT_EQ(0, multi.add(dl));
+	}
+	EXPECT_EQ(fileCount, multi.activeCount());
+
+	unsigned int finished = 0;
+	for (unsigned int loops = 0; finished < fileCount && loops < 1000; loops++) {
+		ASSERT_EQ(0, multi.poll(-1, 100));
+
+		int ret = -1;
+		CurlDownloader *dl;
+		while ((dl = multi.nextFinished(&ret)) != nullptr) {
+			EXPECT_EQ(0, ret);
+			finished++;
+		}
+	}
+	ASSERT_EQ(fileCount, finished);
+	EXPECT_EQ(0U, multi.activeCount());
+
+	for (unsigned int i = 0; i < fileCount; i++) {
+		EXPECT_EQ("File #" + std::to_string(i), dataString(dls[i].get()));
+	}
+
+	EXPECT_EQ(fileCount, m_server.requests());
+	EXPECT_LE(m_server.connections(), maxHostConnections);
+}
+
+/**
+ * Download a file that doesn't exist.
+ * The HTTP status code should be returned.
+ */
+TEST_F(CurlMultiDownloaderTest, notFound)
+{
+	CurlMultiDownloader multi;
+	ASSERT_TRUE(multi.isInit());
+
+	CurlDownloader dl;
+	dl.setUrl(m_server.url("/missing.png"));
+	ASSERT_EQ(0, multi.add(&dl));
+
+	int ret = 0;
+	CurlDownloader *finished = nullptr;
+	for (unsigned int loops = 0; !finished && loops < 100; loops++) {
+		ASSERT_EQ(0, multi.poll(-1, 100));
+		finished = multi.nextFinished(&ret);
+	}
+	ASSERT_EQ(&dl, finished);
+	EXPECT_EQ(404, ret);
+}
+
+/**
+ * Wait for input on an extra file descriptor.
+ */
+TEST_F(CurlMultiDownloaderTest, extraFd)
+{
+	CurlMultiDownloader multi;
+	ASSERT_TRUE(multi.isInit());
+
+	int pipefd[2];
+	ASSERT_EQ(0, pipe(pipefd));
+
+	bool ready = true;
+	EXPECT_EQ(0, multi.poll(pipefd[0], 10, &ready));
+	EXPECT_FALSE(ready);
+
+	ASSERT_EQ(1, write(pipefd[1], "\n", 1));
+	EXPECT_EQ(0, multi.poll(pipefd[0], 1000, &ready));
+	EXPECT_TRUE(ready);
+
+	close(pipefd[0]);
+	close(pipefd[1]);
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, TCHAR *argv[])
+{
+	fprintf(stderr, "rp-download test suite: CurlMultiDownloader tests.\n\n");
+	fflush(nullptr);
+
+	// The local HTTP server must not be accessed through a proxy.
+	unsetenv("http_proxy");
+	unsetenv("all_proxy");
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -22,22 +22,31 @@
 #include "librpbase/RomData.hpp"
 #include "librpbase/SystemRegion.hpp"
 #include "librpbase/img/RpPng.hpp"
+#include "librpbase/img/RpPngWriter.hpp"
 #include "librpbase/img/IconAnimData.hpp"
 #include "librpbase/TextOut.hpp"
+#include "librpbase/crypto/MultiHash.hpp"
+#include "librpbase/disc/IDiscReader.hpp"
+#include "librpbase/disc/IPartition.hpp"
 using namespace LibRpBase;
 
 // librptext
+#include "librptext/conversion.hpp"
 #include "librptext/printf.hpp"
 using namespace LibRpText;
 
 // librpfile
 #include "librpfile/config.librpfile.h"
 #include "librpfile/FileSystem.hpp"
+#include "librpfile/IoTrace.hpp"
 #include "librpfile/RpFile.hpp"
 using namespace LibRpFile;
 
 // libromdata
 #include "libromdata/RomDataFactory.hpp"
+#include "libromdata/disc/FstExtractor.hpp"
+#include "libromdata/disc/TracingDiscReader.hpp"
+#include "libromdata/utils/DatFile.hpp"
 using namespace LibRomData;
 
 // librptexture
@@ -164,7 +173,7 @@ static void ExtractImages(const RomData *romData, vector<ExtractParam>& extract)
 				if (errcode == -ENOTSUP) {
 					cerr << "   " << C_("rpcli", "APNG not supported, extracting only the first frame") << endl;
 					// falling back to outputting the first frame
-					errcode = RpPng::save(p.filename, iconAnimData->frames[iconAnimData->seq_index[0]]);
+					errcode = RpPng::save(p.filename, iconAnimData->frame(iconAnimData->seq_index[0]));
 				}
 				if (errcode != 0) {
 					cerr << "   " <<
@@ -190,6 +199,73 @@ static void ExtractImages(const RomData *romData, vector<ExtractParam>& extract)
 	}
 }
 
+/**
+ * Hash the logical ROM image and add the hashes to the ROM fields.
+ * @param romData RomData object
+ * @param datFile DAT file for matching (optional)
+ */
+static void HashRomData(RomData *romData, const DatFile *datFile)
+{
+	IDiscReader *discReader = romData->openLogicalImage();
+	if (!discReader) {
+		cerr << "-- " << C_("rpcli", "Couldn't open the ROM image for hashing") << endl;
+		return;
+	}
+	if (IoTrace::isEnabled()) {
+		// Trace reads from the logical image separately from
+		// reads from the underlying file.
+		const string tag = string(romData->className()) + " (logical image)";
+		IDiscReader *const tracingReader = new TracingDiscReader(discReader, tag.c_str());
+		discReader->unref();
+		discReader = tracingReader;
+	}
+
+	cerr << "-- " << C_("rpcli", "Hashing the ROM image") << endl;
+	MultiHash hash;
+	const int ret = hash.hashDiscReader(discReader);
+	discReader->unref();
+	if (ret != 0) {
+		cerr << "-- " << rp_sprintf(C_("rpcli", "Couldn't hash the ROM image: %s"), strerror(-ret)) << endl;
+		return;
+	}
+
+	const char *datMatch = nullptr;
+	if (datFile) {
+		const DatFile::RomEntry *const entry = datFile->find(hash);
+		datMatch = (entry ? entry->game.c_str() : "");
+	}
+	romData->addHashFields(hash, datMatch);
+}
+
+/**
+ * Extract all files from the ROM image's file system.
+ * @param romData RomData object
+ * @param outdir Output directory
+ */
+static void ExtractFst(RomData *romData, const char *outdir)
+{
+	IPartition *const partition = romData->openFstPartition();
+	if (!partition) {
+		cerr << "-- " << C_("rpcli", "ROM image does not have a file system that can be extracted") << endl;
+		return;
+	}
+
+	cerr << "-- " << rp_sprintf(C_("rpcli", "Extracting files into '%s'"), outdir) << endl;
+	FstExtractor extractor(partition);
+	partition->unref();
+	const int ret = extractor.extractAll(outdir);
+	if (ret != 0) {
+		// tr: %1$u == number of files that couldn't be extracted, %2$s == error message
+		cerr << "   " << rp_sprintf_p(C_("rpcli", "Couldn't extract %1$u file(s): %2$s"),
+			extractor.errorCount(), strerror(-ret)) << endl;
+	}
+	// tr: %1$u == number of files, %2$s == total size, %3$s == size copied directly from the disc image
+	cerr << "   " << rp_sprintf_p(C_("rpcli", "Extracted %1$u file(s), %2$s (%3$s copied directly)"),
+		extractor.fileCount(),
+		formatFileSize(extractor.totalSize()).c_str(),
+		formatFileSize(extractor.directSize()).c_str()) << endl;
+}
+
 /**
  * Shows info about file
  * @param filename ROM filename
@@ -197,15 +273,23 @@ static void ExtractImages(const RomData *romData, vector<ExtractParam>& extract)
  * @param extract Vector of image extraction parameters
  * @param lc Language code (0 for default)
  * @param flags ROMOutput flags (see OutputFlags)
+ * @param hash If true, hash the ROM image.
+ * @param datFile DAT file for hash matching (optional)
+ * @param fstOutDir Output directory for extracting the file system (optional)
  */
 static void DoFile(const char *filename, bool json, vector<ExtractParam>& extract,
-	uint32_t lc = 0, unsigned int flags = 0)
+	uint32_t lc = 0, unsigned int flags = 0, bool hash = false, const DatFile *datFile = nullptr,
+	const char *fstOutDir = nullptr)
 {
 	cerr << "== " << rp_sprintf(C_("rpcli", "Reading file '%s'..."), filename) << endl;
 	RpFile *const file = new RpFile(filename, RpFile::FM_OPEN_READ_GZ);
 	if (file->isOpen()) {
 		RomData *romData = RomDataFactory::create(file);
 		if (romData && romData->isValid()) {
+			if (hash) {
+				HashRomData(romData, datFile);
+			}
+
 			if (json) {
 				cerr << "-- " << C_("rpcli", "Outputting JSON data") << endl;
 				cout << JSONROMOutput(romData, lc, flags) << endl;
@@ -214,6 +298,9 @@ static void DoFile(const char *filename, bool json, vector<ExtractParam>& extrac
 			}
 
 			ExtractImages(romData, extract);
+			if (fstOutDir) {
+				ExtractFst(romData, fstOutDir);
+			}
 		} else {
 			cerr << "-- " << C_("rpcli", "ROM is not supported") << endl;
 			if (json) cout << "{\"error\":\"rom is not supported\"}" << endl;
@@ -406,10 +493,10 @@ int RP_C_API main(int argc, char *argv[])
 
 	if(argc < 2){
 #ifdef ENABLE_DECRYPTION
-		cerr << C_("rpcli", "Usage: rpcli [-k] [-c] [-p] [-j] [-l lang] [[-x[b]N outfile]... [-a apngoutfile] filename]...") << '\n';
+		cerr << C_("rpcli", "Usage: rpcli [-k] [-c] [-p] [-j] [-l lang] [-z profile] [-H] [-D datfile]... [-t] [[-x[b]N outfile]... [-a apngoutfile] [-e outdir] filename]...") << '\n';
 		cerr << "  -k:   " << C_("rpcli", "Verify encryption keys in keys.conf.") << '\n';
 #else /* !ENABLE_DECRYPTION */
-		cerr << C_("rpcli", "Usage: rpcli [-c] [-p] [-j] [-l lang] [[-x[b]N outfile]... [-a apngoutfile] filename]...") << '\n';
+		cerr << C_("rpcli", "Usage: rpcli [-c] [-p] [-j] [-l lang] [-z profile] [-H] [-D datfile]... [-t] [[-x[b]N outfile]... [-a apngoutfile] [-e outdir] filename]...") << '\n';
 #endif /* ENABLE_DECRYPTION */
 		cerr << "  -c:   " << C_("rpcli", "Print system region information.") << '\n';
 		cerr << "  -p:   " << C_("rpcli", "Print system path information.") << '\n';
@@ -418,6 +505,11 @@ int RP_C_API main(int argc, char *argv[])
 		cerr << "  -l:   " << C_("rpcli", "Retrieve the specified language from the ROM image.") << '\n';
 		cerr << "  -xN:  " << C_("rpcli", "Extract image N to outfile in PNG format.") << '\n';
 		cerr << "  -a:   " << C_("rpcli", "Extract the animated icon to outfile in APNG format.") << '\n';
+		cerr << "  -e:   " << C_("rpcli", "Extract all files from the disc image's file system to outdir.") << '\n';
+		cerr << "  -z:   " << C_("rpcli", "PNG compression profile for extracted images: default, fast, small") << '\n';
+		cerr << "  -H:   " << C_("rpcli", "Calculate CRC32, MD5, and SHA-1 hashes of the ROM image.") << '\n';
+		cerr << "  -D:   " << C_("rpcli", "Load a Logiqx XML DAT file for hash matching. (implies -H)") << '\n';
+		cerr << "  -t:   " << C_("rpcli", "Trace file I/O and print per-class read statistics to stderr in JSON format.") << '\n';
 		cerr << '\n';
 #ifdef RP_OS_SCSI_SUPPORTED
 		cerr << C_("rpcli", "Special options for devices:") << '\n';
@@ -471,6 +563,11 @@ int RP_C_API main(int argc, char *argv[])
 	bool inq_ata_packet = false;
 #endif /* RP_OS_SCSI_SUPPORTED */
 	uint32_t lc = 0;
+	bool hash = false;
+	DatFile datFile;
+	bool hasDatFile = false;
+	bool ioTrace = false;
+	const char *fstOutDir = nullptr;
 	bool first = true;
 	int ret = 0;
 	for (int i = 1; i < argc; i++){
@@ -550,6 +647,83 @@ int RP_C_API main(int argc, char *argv[])
 			case 'a':
 				extract.emplace_back(argv[++i], -1);
 				break;
+			case 'e':
+				// Extract the file system.
+				// NOTE: Directory may be immediately after 'e',
+				// or it might be a completely separate argument.
+				if (argv[i][2] == '\0') {
+					// Separate argument.
+					fstOutDir = argv[i+1];
+					i++;
+				} else {
+					// Same argument.
+					fstOutDir = &argv[i][2];
+				}
+				break;
+			case 'z': {
+				// PNG compression profile.
+				// NOTE: Profile may be immediately after 'z',
+				// or it might be a completely separate argument.
+				const char *s_profile;
+				if (argv[i][2] == '\0') {
+					// Separate argument.
+					s_profile = argv[i+1];
+					i++;
+				} else {
+					// Same argument.
+					s_profile = &argv[i][2];
+				}
+				if (!s_profile) {
+					break;
+				}
+
+				if (!strcasecmp(s_profile, "default")) {
+					RpPngWriter::setDefaultProfile(RpPngWriter::Profile::Default);
+				} else if (!strcasecmp(s_profile, "fast")) {
+					RpPngWriter::setDefaultProfile(RpPngWriter::Profile::Fast);
+				} else if (!strcasecmp(s_profile, "small")) {
+					RpPngWriter::setDefaultProfile(RpPngWriter::Profile::Small);
+				} else {
+					cerr << rp_sprintf(C_("rpcli", "Warning: ignoring invalid PNG compression profile '%s'"), s_profile) << endl;
+				}
+				break;
+			}
+			case 'H':
+				// Hash the ROM image.
+				hash = true;
+				break;
+			case 'D': {
+				// Load a DAT file for hash matching.
+				// NOTE: Filename may be immediately after 'D',
+				// or it might be a completely separate argument.
+				const char *s_datfile;
+				if (argv[i][2] == '\0') {
+					// Separate argument.
+					s_datfile = argv[i+1];
+					i++;
+				} else {
+					// Same argument.
+					s_datfile = &argv[i][2];
+				}
+				if (!s_datfile) {
+					break;
+				}
+
+				const int count = datFile.load(s_datfile);
+				if (count < 0) {
+					cerr << rp_sprintf(C_("rpcli", "Warning: couldn't load DAT file '%s': %s"),
+						s_datfile, strerror(-count)) << endl;
+					break;
+				}
+				hash = true;
+				hasDatFile = true;
+				break;
+			}
+			case 't':
+				// Trace file I/O.
+				IoTrace::setEnabled(true);
+				ioTrace = true;
+				break;
 			case 'j': // do nothing
 			case 'J': // still do nothing
 				break;
@@ -602,7 +776,13 @@ int RP_C_API main(int argc, char *argv[])
 #endif /* RP_OS_SCSI_SUPPORTED */
 			{
 				// Regular file.
-				DoFile(argv[i], json, extract, lc, flags);
+				DoFile(argv[i], json, extract, lc, flags, hash, (hasDatFile ? &datFile : nullptr), fstOutDir);
+			}
+
+			if (ioTrace) {
+				// Print the I/O trace for this file.
+				cerr << IoTrace::toJSON(true) << endl;
+				IoTrace::reset();
 			}
 
 #ifdef RP_OS_SCSI_SUPPORTED
@@ -611,6 +791,7 @@ int RP_C_API main(int argc, char *argv[])
 			inq_ata_packet = false;
 #endif /* RP_OS_SCSI_SUPPORTED */
 			extract.clear();
+			fstOutDir = nullptr;
 		}
 	}
 	if (json) cout << ']' << endl;
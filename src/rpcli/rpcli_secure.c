@@ -2,7 +2,7 @@
  * ROM Properties Page shell extension. (rpcli)                            *
  * rpcli_secure.c: Security options for rpcli.                             *
  *                                                                         *
- * Copyright (c) 2016-2020 by David Korth.                                 *
+ * Copyright (c) 2016-2023 by David Korth.                                 *
  * SPDX-License-Identifier: GPL-2.0-or-later                               *
  ***************************************************************************/
 
@@ -72,6 +72,14 @@ int rpcli_do_security_options(void)
 		SCMP_SYS(statx),
 #endif /* __SNR_statx || __NR_statx */
 
+		// FstExtractor (-e)
+		SCMP_SYS(mkdir), SCMP_SYS(mkdirat),	// LibRpFile::FileSystem::rmkdir()
+		SCMP_SYS(unlink), SCMP_SYS(unlinkat),	// LibRpFile::FileSystem::delete_file()
+#if defined(__SNR_copy_file_range) || defined(__NR_copy_file_range)
+		SCMP_SYS(copy_file_range),	// LibRpFile::RpFile::copyRangeFrom()
+#endif /* __SNR_copy_file_range || __NR_copy_file_range */
+		SCMP_SYS(sendfile), SCMP_SYS(sendfile64),	// LibRpFile::RpFile::copyRangeFrom()
+
 		// glibc ncsd
 		// TODO: Restrict connect() to AF_UNIX.
 		SCMP_SYS(connect), SCMP_SYS(recvmsg), SCMP_SYS(sendto),
@@ -85,7 +93,7 @@ int rpcli_do_security_options(void)
 		-1	// End of whitelist
 	};
 	param.syscall_wl = syscall_wl;
-	param.threading = true;		// FIXME: Only if OpenMP is enabled?
+	param.threading = true;		// librpthreads thread pool
 #elif defined(HAVE_PLEDGE)
 	// Promises:
 	// - stdio: General stdio functionality.
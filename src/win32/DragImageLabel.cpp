@@ -230,7 +230,7 @@ bool DragImageLabelPrivate::updateBitmaps(void)
 		// Convert the icons to HBITMAP using the window background color.
 		// TODO: Rescale the icon. (port rescaleImage())
 		for (int i = iconAnimData->count-1; i >= 0; i--) {
-			const rp_image *const frame = iconAnimData->frames[i];
+			const rp_image *const frame = iconAnimData->frame(i);
 			if (frame && frame->isValid()) {
 				if (actualSize.cx == 0) {
 					// Get the icon size and rescale it, if necessary.
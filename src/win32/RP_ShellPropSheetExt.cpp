@@ -1019,13 +1019,11 @@ int RP_ShellPropSheetExt_Private::initListData(HWND hDlg, HWND hWndTab,
 			// Add icons.
 			uint8_t rowColorIdx = 0;
 			const auto &icons = field.data.list_data.mxd.icons;
-			const auto icons_cend = icons->cend();
-			for (auto iter = icons->cbegin(); iter != icons_cend;
-			     ++iter, rowColorIdx = !rowColorIdx)
-			{
+			const size_t icon_count = icons->size();
+			for (size_t i = 0; i < icon_count; i++, rowColorIdx = !rowColorIdx) {
 				bool needsUnref = false;
 				int iImage = -1;
-				const rp_image *icon = *iter;
+				const rp_image *icon = icons->at(i);
 				if (!icon) {
 					// No icon for this row.
 					lvData.vImageList.emplace_back(iImage);